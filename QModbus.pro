@@ -40,11 +40,57 @@ DESTDIR         = ./build/lib                   # Library files output folder.
 HEADERS        +=   include/qabstractmodbus.h \
                     include/qrtumodbus.h \
                     include/qasciimodbus.h \
-                    include/qtcpmodbus.h
+                    include/qtcpmodbus.h \
+                    include/qmodbuslistener.h \
+                    include/qmodbuschangefilter.h \
+                    include/qmodbussubscriptionengine.h \
+                    include/qmodbuspollscheduler.h \
+                    include/qmodbuswritebehind.h \
+                    include/qmodbuscapabilitycache.h \
+                    include/qmodbusverifiedwriter.h \
+                    include/qmodbusframing.h \
+                    include/qmodbusrequestcore.h \
+                    include/qmodbuspdu.h \
+                    include/qmodbusframe.h \
+                    include/qmodbustransactiontable.h \
+                    include/qmodbusrequest.h \
+                    include/qmodbusmpscqueue.h \
+                    include/qmodbussharedconnection.h \
+                    include/qmodbuscoroutine.h \
+                    include/qmodbusredundantclient.h \
+                    include/qmodbusreconnectmanager.h \
+                    include/qmodbusconnectionpool.h \
+                    include/qmodbusstripedreader.h \
+                    include/qmodbusdeadline.h \
+                    include/qmodbusratelimiter.h \
+                    include/qmodbusretryclient.h \
+                    include/qmodbuscapabilityprober.h \
+                    include/qmodbustopologycache.h \
+                    include/qmodbusunitscanner.h \
+                    include/qmodbushostscanner.h
 
 SOURCES        +=   src/qrtumodbus.cpp \
                     src/qasciimodbus.cpp \
-                    src/qtcpmodbus.cpp
+                    src/qtcpmodbus.cpp \
+                    src/qmodbuschangefilter.cpp \
+                    src/qmodbussubscriptionengine.cpp \
+                    src/qmodbuspollscheduler.cpp \
+                    src/qmodbuswritebehind.cpp \
+                    src/qmodbuscapabilitycache.cpp \
+                    src/qmodbusverifiedwriter.cpp \
+                    src/qmodbusframing.cpp \
+                    src/qmodbusrequest.cpp \
+                    src/qmodbussharedconnection.cpp \
+                    src/qmodbusredundantclient.cpp \
+                    src/qmodbusreconnectmanager.cpp \
+                    src/qmodbusconnectionpool.cpp \
+                    src/qmodbusstripedreader.cpp \
+                    src/qmodbusratelimiter.cpp \
+                    src/qmodbusretryclient.cpp \
+                    src/qmodbuscapabilityprober.cpp \
+                    src/qmodbustopologycache.cpp \
+                    src/qmodbusunitscanner.cpp \
+                    src/qmodbushostscanner.cpp
 
 
 # INSTALLATION #########################################################################################################
@@ -0,0 +1,125 @@
+/***********************************************************************************************************************
+* PDU encoding benchmark : Compares the compile-time PDU layouts with the former QDataStream encoding.                 *
+************************************************************************************************************************
+* Author : QModbus contributors                                                                                        *
+* Date   : 2026/10/18                                                                                                  *
+* Changes: -                                                                                                           *
+***********************************************************************************************************************/
+
+
+/*** Qt includes ******************************************************************************************************/
+#include <QModbusPdu>
+#include <QtCore/QByteArray>
+#include <QtCore/QDataStream>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QList>
+
+
+/*** System includes **************************************************************************************************/
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+
+/*** Baseline *********************************************************************************************************/
+// The request PDUs as the transports encoded them before the layouts: a QByteArray grown by a big endian QDataStream,
+// one field at a time.
+static QByteArray streamReadRegisters( const quint16 startingAddress , const quint16 quantity )
+{
+    QByteArray pdu;
+    QDataStream pduStream( &pdu , QIODevice::WriteOnly );
+    pduStream.setByteOrder( QDataStream::BigEndian );
+    pduStream << (quint8)0x03 << startingAddress << quantity;
+    return pdu;
+}
+
+static QByteArray streamWriteRegisters( const quint16 startingAddress , const QList<quint16> &values )
+{
+    QByteArray pdu;
+    QDataStream pduStream( &pdu , QIODevice::WriteOnly );
+    pduStream.setByteOrder( QDataStream::BigEndian );
+    pduStream << (quint8)0x10 << startingAddress << (quint16)values.count() << (quint8)( values.count() * 2 );
+    foreach ( quint16 value , values ) pduStream << value;
+    return pdu;
+}
+
+
+/*** Layouts **********************************************************************************************************/
+// The same PDUs encoded the way the request core does it.
+static int layoutReadRegisters( char *const pdu , const quint16 startingAddress , const quint16 quantity )
+{
+    return QModbusReadRegistersPdu::encode( pdu , 0x03 , startingAddress , quantity );
+}
+
+static int layoutWriteRegisters( char *const pdu , const quint16 startingAddress , const QList<quint16> &values )
+{
+    QModbusWriteMultiplePdu::encode( pdu , 0x10 , startingAddress , values.count() );
+    const int size = QModbusWriteMultiplePdu::setDataSize( pdu , values.count() * 2 );
+    char *data = QModbusWriteMultiplePdu::data( pdu );
+    foreach ( quint16 value , values )
+    {
+        QModbusPdu::put( data , value );
+        data += 2;
+    }
+    return size;
+}
+
+
+/*** Benchmark ********************************************************************************************************/
+// Prints the time per request of both encodings.
+static void report( const char *const name , const qint64 streamNsecs , const qint64 layoutNsecs ,
+                    const int iterations )
+{
+    const double stream = (double)streamNsecs / iterations;
+    const double layout = (double)layoutNsecs / iterations;
+    std::printf( "%-28s QDataStream %8.1f ns   layout %8.1f ns   speedup %6.1fx\n" , name , stream , layout ,
+                 layout > 0 ? stream / layout : 0.0 );
+}
+
+int main( int argc , char *argv[] )
+{
+    const int iterations = argc > 1 ? qMax( 1 , std::atoi( argv[1] ) ) : 1000000;
+    QList<quint16> values;
+    for ( int i = 0 ; i < 16 ; i++ ) values.append( (quint16)( 0x1000 + i ) );
+
+    // Both encodings have to produce the same bytes, otherwise the comparison is meaningless.
+    char pdu[QModbusPdu::MaxSize];
+    int size = layoutReadRegisters( pdu , 100 , 10 );
+    const QByteArray readReference = streamReadRegisters( 100 , 10 );
+    if ( size != readReference.size() || std::memcmp( pdu , readReference.constData() , size ) )
+    {
+        std::printf( "Read holding registers: the encodings differ.\n" );
+        return 1;
+    }
+    size = layoutWriteRegisters( pdu , 100 , values );
+    const QByteArray writeReference = streamWriteRegisters( 100 , values );
+    if ( size != writeReference.size() || std::memcmp( pdu , writeReference.constData() , size ) )
+    {
+        std::printf( "Write multiple registers: the encodings differ.\n" );
+        return 1;
+    }
+
+    // The checksum keeps the compiler from dropping the encodings.
+    unsigned int checksum = 0;
+    QElapsedTimer timer;
+    std::printf( "%d iterations\n" , iterations );
+
+    timer.start();
+    for ( int i = 0 ; i < iterations ; i++ ) checksum += streamReadRegisters( (quint16)i , 10 ).at( 2 );
+    const qint64 streamRead = timer.nsecsElapsed();
+    timer.start();
+    for ( int i = 0 ; i < iterations ; i++ ) checksum += layoutReadRegisters( pdu , (quint16)i , 10 ) + pdu[2];
+    const qint64 layoutRead = timer.nsecsElapsed();
+    report( "Read holding registers" , streamRead , layoutRead , iterations );
+
+    timer.start();
+    for ( int i = 0 ; i < iterations ; i++ ) checksum += streamWriteRegisters( (quint16)i , values ).at( 2 );
+    const qint64 streamWrite = timer.nsecsElapsed();
+    timer.start();
+    for ( int i = 0 ; i < iterations ; i++ ) checksum += layoutWriteRegisters( pdu , (quint16)i , values ) + pdu[2];
+    const qint64 layoutWrite = timer.nsecsElapsed();
+    report( "Write 16 registers" , streamWrite , layoutWrite , iterations );
+
+    std::printf( "(checksum %u)\n" , checksum );
+    return 0;
+}
@@ -0,0 +1,30 @@
+########################################################################################################################
+# pduencoding : Benchmark of the compile-time PDU layouts against the former QDataStream encoding.                     #
+########################################################################################################################
+# Author ........: QModbus contributors                                                                                #
+# Changes .......: -                                                                                                   #
+########################################################################################################################
+
+
+# COMMON SETTINGS FOR ALL PLATFORMS ####################################################################################
+TEMPLATE        = app                           # Console application.
+QT             += core                          # Only Qt's Core module is needed.
+QT             -= gui
+CONFIG         += console \                     # No application bundle, output to the console.
+                  release \                     # Measure optimized code.
+                  warn_on                       # Show all warnings.
+CONFIG         -= app_bundle debug
+
+
+# DEPENDENCIES AND INLCUDES ############################################################################################
+INCLUDEPATH    += ../../include                 # The layouts are header only, the library is not linked.
+
+
+# OUTPUT DESTINATIONS ##################################################################################################
+OBJECTS_DIR     = ./build/.obj
+DESTDIR         = ./build
+TARGET          = pduencoding
+
+
+# FILES ################################################################################################################
+SOURCES        +=   pduencoding.cpp
@@ -9,7 +9,10 @@
 
 
 /*** Qt includes & prototypes *****************************************************************************************/
+#include <QModbusFrame>
 #include <QtCore/QList>
+class QModbusRequest;
+class QModbusResponse;
 
 
 /*** QiAbstractModbus class declaration and help **********************************************************************/
@@ -40,9 +43,22 @@ public:
         CrcError                            = 0x10 ,    //!< The received modbus message is corrupted.
         Timeout                             = 0x11 ,    //!< There was an timeout (slave did not respond in time).
         NoConnection                        = 0x12 ,    //!< No connection to the slave possible.
+        VerificationFailed                  = 0x13 ,    //!< The values read back differ from the values written.
+        Cancelled                           = 0x14 ,    //!< The request was cancelled (QModbusCancellationToken).
         UnknownError                        = 0xFF      //!< An unknown error happened.
     };
 
+    /*!
+    * This enumeration names the four data tables a modbus device exposes.
+    */
+    enum Table
+    {
+        Coils                               = 0x01 ,    //!< Read/write bits, read using function 0x01.
+        DiscreteInputs                      = 0x02 ,    //!< Read only bits, read using function 0x02.
+        HoldingRegisters                    = 0x03 ,    //!< Read/write registers, read using function 0x03.
+        InputRegisters                      = 0x04      //!< Read only registers, read using function 0x04.
+    };
+
     /*!
     * Destructor.
     */
@@ -284,6 +300,35 @@ public:
     virtual QByteArray executeCustomFunction( const quint8 deviceAddress , const quint8 modbusFunction ,
                                               QByteArray &data , quint8 *const status = NULL ) const = 0;
 
+    /*!
+    * This method executes any modbus function given as a complete request PDU (function code and data) and returns
+    * the response PDU (function code and data). Device address, framing and CRC/LRC are handled by the class. Neither
+    * the request nor the response are copied to the heap, so polling using this method does not allocate memory.
+    *
+    * The default implementation executes the request using executeCustomFunction(), so it copies the data. The
+    * transports of the library override it.
+    * \param deviceAddress Address of the slave device [1..247].
+    * \param request The request PDU, 1 to 253 bytes.
+    * \param response Receives the response PDU on success.
+    * \param status Pointer to a variable that will contain the transaction status after method execution. If NULL
+    *               status will not be reported at all.
+    * \return True on success, false if the modbus function failed.
+    */
+    virtual bool executePdu( const quint8 deviceAddress , const QModbusFrameView &request , QModbusPduFrame &response ,
+                             quint8 *const status = NULL ) const;
+
+    /*!
+    * This method executes a batch of requests (see QModbusRequest), for example reads, writes, mask writes and FIFO
+    * reads mixed. The transport is free to optimize the batch: all frames are encoded in one pass into a single buffer
+    * and modbus TCP pipelines the requests instead of waiting for each reply before sending the next request. The
+    * default implementation executes the requests one after the other using executePdu(). A request cancelled or
+    * expired (see QModbusRequest::setDeadline()) fails with Cancelled or Timeout, the transports stop waiting for it.
+    * \param batch The requests.
+    * \return One response per request in the order of the batch, each with its status. Invalid requests fail with
+    *         IllegalDataValue.
+    */
+    virtual QList<QModbusResponse> execute( const QList<QModbusRequest> &batch ) const;
+
     /*!
     * This method speakes raw to the device.
     * \param data Data to send.
@@ -311,6 +311,11 @@ private:
 
     unsigned int _timeout;                  // Timeout to use in serial communication.
 
+    mutable char _rxBuffer[1024];           // Received bytes not consumed yet.
+    mutable int _rxBegin;                   // First unconsumed byte in the receive buffer.
+    mutable int _rxEnd;                     // End of the received bytes in the receive buffer.
+    mutable bool _rxInLine;                 // The start of a line was consumed, but not its end.
+
 public:
     /*!
     * Constructor.
@@ -438,6 +443,13 @@ public:
     QByteArray executeCustomFunction( const quint8 deviceAddress , const quint8 modbusFunction ,
                                       QByteArray &data , quint8 *const status = NULL ) const;
 
+    // Interface implementation (QiAbstractModbus).
+    bool executePdu( const quint8 deviceAddress , const QModbusFrameView &request , QModbusPduFrame &response ,
+                     quint8 *const status = NULL ) const;
+
+    // Interface implementation (QiAbstractModbus).
+    QList<QModbusResponse> execute( const QList<QModbusRequest> &batch ) const;
+
     // Interface implementation (QiAbstractModbus).
     QByteArray executeRaw( QByteArray &data , quint8 *const status = NULL ) const;
 
@@ -445,20 +457,28 @@ public:
     QByteArray calculateCheckSum( QByteArray &data ) const;
 
 private:
+    // The I/O policy of the request core uses the serial port functions below.
+    friend class QAsciiModbusIo;
+
+    // Reads whatever the port delivers within the timeout into data using a single read, returns the number of bytes.
+    int _receive( char *const data , const int maxSize ) const;
+
+    // Reads bytes, buffered bytes first. Returns the number of bytes read.
+    int _receiveBytes( char *const data , const int size ) const;
+
+    // Reads the next line starting with ':' and ending with LF (included) using the receive buffer, everything before
+    // the ':' is dropped. At most maxSize bytes are copied, the next call continues a longer line. Returns the number
+    // of bytes copied, less than a complete line on timeout.
+    int _receiveLine( char *const data , const int maxSize ) const;
+
+    // Drops the received bytes.
+    void _clearReceiveBuffer( void ) const;
 
 # /***/ ifdef Q_OS_WIN /***********************************************************************************************/
 
-    QByteArray _read( const int numberBytes ) const;
-    QByteArray _readAll( void ) const;
-    QByteArray _readLine( int maxBytes ) const;
+    qint64 _read( char *const data , const qint64 maxSize ) const;
     bool _write( QByteArray &data ) const;
+    bool _write( const char *const data , const qint64 size ) const;
 
 # /***/ endif /* Q_OS_WIN *********************************************************************************************/
-
-    // Used to perform LRC on outgoing modbus messages.
-    quint8 _calculateLrc( const QByteArray &pdu ) const;
-
-    // Used to check LRC on incomming modbus messages.
-    bool _checkLrc( const QByteArray &pdu ) const;
 };
-
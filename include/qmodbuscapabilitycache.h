@@ -0,0 +1,174 @@
+/***********************************************************************************************************************
+* QModbusCapabilityCache : Remembers which modbus functions, block sizes and addresses a device supports.             *
+************************************************************************************************************************
+* Author : QModbus contributors                                                                                        *
+* Date   : 2026/10/18                                                                                                  *
+* Changes: -                                                                                                           *
+***********************************************************************************************************************/
+#pragma once
+
+
+/*** Qt includes & prototypes *****************************************************************************************/
+#include <QAbstractModbus>
+#include <QtCore/QHash>
+#include <QtCore/QIODevice>
+#include <QtCore/QList>
+
+
+/*** QModbusCapabilityCache class declaration and help ****************************************************************/
+/*!
+* The capability cache remembers per device address which modbus functions are supported, so that helpers using
+* optional functions (for example writeReadMultipleRegisters()) only pay the cost of an unsupported function once.
+* The support of a function is learned from the status of the transactions made with it: Ok marks it as supported,
+* IllegalFunction as unsupported; any other status leaves the cache unchanged.
+*
+* The cache also holds the largest quantity a device accepts per function and the address window of its tables, both
+* usually learned by QModbusCapabilityProber. The request planners (QModbusPollScheduler, QModbusSubscriptionEngine)
+* size their blocks using maximumQuantity(), which falls back to the modbus limit for functions not learned yet. As
+* probing costs bus time, the cache can be saved to a file and loaded again at the next start.
+*
+* A cache belongs to one connection (device addresses are only unique per bus), but can be shared by several helpers
+* working on the same connection.
+* \headerfile qmodbuscapabilitycache.h QModbusCapabilityCache
+*/
+class QModbusCapabilityCache
+{
+public:
+    /*!
+    * Support of a function by a device.
+    */
+    enum Support
+    {
+        Unknown ,                   //!< Not used yet.
+        Supported ,                 //!< The device executed the function.
+        Unsupported                 //!< The device answered with an illegal function exception.
+    };
+
+    /*!
+    * Constructor, creates an empty cache.
+    */
+    QModbusCapabilityCache();
+
+    /*!
+    * Returns the support of a function by a device.
+    * \param deviceAddress Address of the slave device [1..247].
+    * \param functionCode Modbus function code.
+    * \return Support of the function.
+    */
+    Support support( const quint8 deviceAddress , const quint8 functionCode ) const;
+
+    /*!
+    * Sets the support of a function by a device.
+    * \param deviceAddress Address of the slave device [1..247].
+    * \param functionCode Modbus function code.
+    * \param support Support of the function.
+    */
+    void setSupport( const quint8 deviceAddress , const quint8 functionCode , const Support support );
+
+    /*!
+    * Updates the support of a function from the status of a transaction made with it.
+    * \param deviceAddress Address of the slave device [1..247].
+    * \param functionCode Modbus function code.
+    * \param status Transaction status (see QAbstractModbus::Status).
+    */
+    void record( const quint8 deviceAddress , const quint8 functionCode , const quint8 status );
+
+    /*!
+    * Returns the devices something is known about.
+    * \return Device addresses, sorted.
+    */
+    QList<quint8> devices( void ) const;
+
+    /*!
+    * Returns the largest quantity the modbus specification allows for a function.
+    * \param functionCode Modbus function code.
+    * \return 2000 for 0x01 and 0x02, 125 for 0x03, 0x04 and 0x17 (read quantity), 1968 for 0x0F, 123 for 0x10 and 0
+    *         for functions without a quantity.
+    */
+    static quint16 standardMaximumQuantity( const quint8 functionCode );
+
+    /*!
+    * Returns the largest quantity a device accepts for a function. The read functions use the table values
+    * (QAbstractModbus::Table) as function codes.
+    * \param deviceAddress Address of the slave device [1..247].
+    * \param functionCode Modbus function code.
+    * \return The learned maximum or standardMaximumQuantity() if none was learned.
+    */
+    quint16 maximumQuantity( const quint8 deviceAddress , const quint8 functionCode ) const;
+
+    /*!
+    * Sets the largest quantity a device accepts for a function.
+    * \param deviceAddress Address of the slave device [1..247].
+    * \param functionCode Modbus function code.
+    * \param quantity The maximum, 0 to forget it. Limited to standardMaximumQuantity().
+    */
+    void setMaximumQuantity( const quint8 deviceAddress , const quint8 functionCode , const quint16 quantity );
+
+    /*!
+    * Returns the addresses of a table a device answers to.
+    * \param deviceAddress Address of the slave device [1..247].
+    * \param table The table.
+    * \param firstAddress Receives the first valid address, 0 if unknown. Can be NULL.
+    * \param lastAddress Receives the last valid address, 65535 if unknown. Can be NULL.
+    * \return True if the window is known.
+    */
+    bool addressWindow( const quint8 deviceAddress , const QAbstractModbus::Table table ,
+                        quint16 *const firstAddress , quint16 *const lastAddress ) const;
+
+    /*!
+    * Sets the addresses of a table a device answers to.
+    * \param deviceAddress Address of the slave device [1..247].
+    * \param table The table.
+    * \param firstAddress The first valid address.
+    * \param lastAddress The last valid address, smaller than firstAddress to forget the window.
+    */
+    void setAddressWindow( const quint8 deviceAddress , const QAbstractModbus::Table table ,
+                           const quint16 firstAddress , const quint16 lastAddress );
+
+    /*!
+    * Writes everything known to a device (for example a QSaveFile).
+    * \param device The open device to write to.
+    * \return True on success.
+    */
+    bool save( QIODevice &device ) const;
+
+    /*!
+    * Replaces the content of the cache by the content written using save().
+    * \param device The open device to read from.
+    * \return True on success. On failure the cache is left unchanged.
+    */
+    bool load( QIODevice &device );
+
+    /*!
+    * Forgets everything known about a device, for example after it was replaced.
+    * \param deviceAddress Address of the slave device [1..247].
+    */
+    void clear( const quint8 deviceAddress );
+
+    /*!
+    * Forgets everything.
+    */
+    void clear( void );
+
+private:
+    enum
+    {
+        Magic = 0x514D4343 ,            // "QMCC", start of a saved cache.
+        Version = 1                     // Version of the saved format.
+    };
+
+    struct Window
+    {
+        Window( void ) : first( 0 ) , last( 0xFFFF ) {}
+
+        quint16 first;                  // First valid address.
+        quint16 last;                   // Last valid address.
+    };
+
+    // Key of a function (or table) of a device.
+    static quint16 _key( const quint8 deviceAddress , const quint8 functionCode );
+
+    QHash<quint16,Support> _support; // Known support by device and function.
+    QHash<quint16,quint16> _maximum; // Learned maximal quantities by device and function.
+    QHash<quint16,Window> _windows; // Learned address windows by device and table.
+};
@@ -0,0 +1,173 @@
+/***********************************************************************************************************************
+* QModbusCapabilityProber : Discovers the functions, block sizes and address windows of a device.                      *
+************************************************************************************************************************
+* Author : QModbus contributors                                                                                        *
+* Date   : 2026/10/18                                                                                                  *
+* Changes: -                                                                                                           *
+***********************************************************************************************************************/
+#pragma once
+
+
+/*** Qt includes & prototypes *****************************************************************************************/
+#include <QAbstractModbus>
+#include <QModbusCapabilityCache>
+
+
+/*** QModbusCapabilityProber class declaration and help ***************************************************************/
+/*!
+* The capability prober learns what a device accepts from the exceptions it answers with and stores the results in a
+* QModbusCapabilityCache:
+*
+* - probeFunction() sends a request the device has to reject (a quantity of 0, an invalid coil value or a mask write
+*   outside the address window). A device implementing the function answers with an illegal data value or address
+*   exception, one that does not with an illegal function exception. Nothing is written, except by a probe of 0x16
+*   while the holding register window is not known (see probeFunction()).
+* - probeAddressWindow() starts at an address that can be read and binary searches the first and last readable
+*   address of the table, assuming the window has no holes.
+* - probeReadSize() binary searches the largest quantity a read starting at an address is accepted with. As the
+*   specification checks the quantity before the address, only illegal data value exceptions are taken as a size
+*   limit; a search bounded by the end of the address window returns the size found without recording it.
+* - probeWriteSize() does the same for function 0x0F or 0x10 by writing back the values just read. Use it only on
+*   ranges nothing else writes to while probing.
+*
+* probe() runs the probes that write nothing for a table. Every call sends at most maximumProbes() requests. If the
+* budget runs out, the call stops with Timeout: the size searches record the largest size proved so far, an
+* incomplete address window is not recorded. Transport errors (CRC errors, timeouts...) and busy devices stop a probe
+* the same way without touching the cache, the status tells why.
+*
+* The planners using the cache (QModbusPollScheduler, QModbusSubscriptionEngine) then read the largest blocks the
+* device accepts. Save the cache (QModbusCapabilityCache::save()) to skip the probing at the next start.
+* \headerfile qmodbuscapabilityprober.h QModbusCapabilityProber
+*/
+class QModbusCapabilityProber
+{
+public:
+    /*!
+    * Constructor.
+    * \param modbus The connection to probe. It has to stay valid as long as the prober exists.
+    * \param cache The capability cache to fill. If NULL, the prober uses its own cache. Not owned by the prober.
+    */
+    explicit QModbusCapabilityProber( const QAbstractModbus &modbus , QModbusCapabilityCache *const cache = NULL );
+
+    /*!
+    * Returns the capability cache the prober fills.
+    * \return Capability cache.
+    */
+    QModbusCapabilityCache &capabilities( void ) const;
+
+    //! Returns the most requests a single probe call sends. Default is 64.
+    int maximumProbes( void ) const;
+
+    //! Changes the most requests a single probe call sends [1..1024].
+    void setMaximumProbes( const int probes );
+
+    //! Returns the number of requests the last probe call sent.
+    int probeCount( void ) const;
+
+    /*!
+    * Learns whether a device implements a function. Functions 0x01 to 0x05, 0x0F, 0x10, 0x16 and 0x17 can be probed,
+    * for the others nothing is sent and the status is IllegalDataValue.
+    *
+    * The probe of mask write register (0x16) targets the address before or after the learned holding register window
+    * (see probeAddressWindow()). If the window is not known or spans all addresses, it is a real write to holding
+    * register 0 with AND mask 0xFFFF and OR mask 0: the value stays the same, but the device executes a write (and
+    * may overwrite a value another master wrote in between).
+    * \param deviceAddress Address of the slave device [1..247].
+    * \param functionCode Modbus function code.
+    * \param status Pointer to a variable that will contain Ok if the support was learned or the reason why not. If
+    *               NULL status will not be reported at all.
+    * \return The support of the function, Unknown if it could not be learned.
+    */
+    QModbusCapabilityCache::Support probeFunction( const quint8 deviceAddress , const quint8 functionCode ,
+                                                   quint8 *const status = NULL ) const;
+
+    /*!
+    * Learns the addresses of a table a device answers to.
+    * \param deviceAddress Address of the slave device [1..247].
+    * \param table The table.
+    * \param address An address of the table that can be read.
+    * \param status Pointer to a variable that will contain the transaction status after method execution. If NULL
+    *               status will not be reported at all.
+    * \return True if the window was learned.
+    */
+    bool probeAddressWindow( const quint8 deviceAddress , const QAbstractModbus::Table table , const quint16 address ,
+                             quint8 *const status = NULL ) const;
+
+    /*!
+    * Learns the largest quantity a device reads from a table at once. The search stays within the address window if
+    * it is known.
+    * \param deviceAddress Address of the slave device [1..247].
+    * \param table The table.
+    * \param startingAddress The address the test reads start at.
+    * \param status Pointer to a variable that will contain the transaction status after method execution. If NULL
+    *               status will not be reported at all.
+    * \return The largest quantity read successfully, 0 on failure.
+    */
+    quint16 probeReadSize( const quint8 deviceAddress , const QAbstractModbus::Table table ,
+                           const quint16 startingAddress , quint8 *const status = NULL ) const;
+
+    /*!
+    * Learns the largest quantity a device writes at once using function 0x0F (coils) or 0x10 (holding registers). The
+    * current values are read and written back unchanged, so the test writes are limited to the read size.
+    * \param deviceAddress Address of the slave device [1..247].
+    * \param table QAbstractModbus::Coils or QAbstractModbus::HoldingRegisters.
+    * \param startingAddress The address the test writes start at.
+    * \param status Pointer to a variable that will contain the transaction status after method execution. If NULL
+    *               status will not be reported at all.
+    * \return The largest quantity written successfully, 0 on failure.
+    */
+    quint16 probeWriteSize( const quint8 deviceAddress , const QAbstractModbus::Table table ,
+                            const quint16 startingAddress , quint8 *const status = NULL ) const;
+
+    /*!
+    * Runs the probes of a table that write nothing: the read function, the address window, the read size and the
+    * support of the write functions of the table (0x05 and 0x0F for coils, 0x10, 0x16 and 0x17 for holding
+    * registers). 0x16 is left out if the holding register window spans all addresses.
+    * \param deviceAddress Address of the slave device [1..247].
+    * \param table The table.
+    * \param address An address of the table that can be read.
+    * \param status Pointer to a variable that will contain the transaction status after method execution. If NULL
+    *               status will not be reported at all.
+    * \return True if all probes succeeded.
+    */
+    bool probe( const quint8 deviceAddress , const QAbstractModbus::Table table , const quint16 address ,
+                quint8 *const status = NULL ) const;
+
+private:
+    Q_DISABLE_COPY( QModbusCapabilityProber )
+
+    // Outcome of a test request.
+    enum Outcome
+    {
+        Accepted ,                  // The device executed the request.
+        Rejected ,                  // The device answered with an illegal data value or address exception.
+        Failed                      // Anything else, the probe has to stop.
+    };
+
+    // Reads a range (or reads it and writes it back) as a test, counting the requests.
+    Outcome _test( const quint8 deviceAddress , const QAbstractModbus::Table table , const quint16 startingAddress ,
+                   const quint16 quantity , const bool write , quint8 &status ) const;
+
+    // Classifies the status of a test request.
+    static Outcome _outcome( const quint8 status );
+
+    // Gets an address outside the known holding register window, false if there is none.
+    bool _outsideWindow( const quint8 deviceAddress , quint16 *const address ) const;
+
+    // Starts the probe budget of a public call, unless probe() is running.
+    void _begin( void ) const;
+
+    // Returns true if the budget allows the given number of requests.
+    bool _mayProbe( const int requests ) const;
+
+    // Binary searches the largest quantity accepted, up to limit, and records it for the function.
+    quint16 _search( const quint8 deviceAddress , const QAbstractModbus::Table table , const quint16 startingAddress ,
+                     const quint8 functionCode , const quint16 limit , const bool write , quint8 *const status ) const;
+
+    const QAbstractModbus &_modbus; // Connection to probe.
+    QModbusCapabilityCache _ownCache;   // Cache used if none was given.
+    QModbusCapabilityCache *_cache; // Cache in use.
+    int _maximumProbes;             // Request budget of a probe call.
+    mutable int _probes;            // Requests sent by the current (or last) probe call.
+    mutable bool _nested;           // True while probe() runs the single probes on one budget.
+};
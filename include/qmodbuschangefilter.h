@@ -0,0 +1,121 @@
+/***********************************************************************************************************************
+* QModbusChangeFilter : Compares consecutive samples of a block and reports the changed items only.                   *
+************************************************************************************************************************
+* Author : QModbus contributors                                                                                        *
+* Date   : 2026/10/18                                                                                                  *
+* Changes: -                                                                                                           *
+***********************************************************************************************************************/
+#pragma once
+
+
+/*** Qt includes & prototypes *****************************************************************************************/
+#include <QtCore/QList>
+#include <QtCore/QVector>
+
+
+/*** QModbusChangeFilter class declaration and help *******************************************************************/
+/*!
+* A change filter remembers the last reported sample of a register or bit block and compares each new sample of the
+* same block against it. Only the indices of the items that changed are returned, so that unchanged values need not be
+* converted and dispatched any further.
+*
+* The comparison is done in place on a contiguous copy of the block, 128 bits (SSE2) or 64 bits at a time, so only
+* the words that actually differ are looked at individually. Registers can be interpreted as typed numeric values; in
+* that case an absolute or percent deadband can be applied and a value is only reported if it moved further than the
+* deadband away from the value reported last. 32 bit values use two consecutive registers, high word first.
+*
+* The first sample and every sample with a different size than the previous one report all items as changed.
+* \headerfile qmodbuschangefilter.h QModbusChangeFilter
+*/
+class QModbusChangeFilter
+{
+public:
+    /*!
+    * Interpretation of the registers for the deadband.
+    */
+    enum ValueType
+    {
+        UInt16 ,                    //!< One register, unsigned.
+        Int16 ,                     //!< One register, signed.
+        UInt32 ,                    //!< Two registers, unsigned, high word first.
+        Int32 ,                     //!< Two registers, signed, high word first.
+        Float32                     //!< Two registers, IEEE 754 single precision, high word first.
+    };
+
+    /*!
+    * Deadband applied to typed values.
+    */
+    enum DeadbandMode
+    {
+        NoDeadband ,                //!< Every change is reported.
+        AbsoluteDeadband ,          //!< Report if |new - reported| > deadband.
+        PercentDeadband             //!< Report if |new - reported| > |reported| * deadband / 100.
+    };
+
+    /*!
+    * Constructor.
+    * \param valueType Interpretation of the registers.
+    * \param deadbandMode Deadband mode.
+    * \param deadband Deadband, absolute value or percent depending on the mode.
+    */
+    explicit QModbusChangeFilter( const ValueType valueType = UInt16 , const DeadbandMode deadbandMode = NoDeadband ,
+                                  const double deadband = 0.0 );
+
+    /*!
+    * Returns the interpretation of the registers.
+    * \return Value type.
+    */
+    ValueType valueType( void ) const;
+
+    /*!
+    * Returns the deadband mode.
+    * \return Deadband mode.
+    */
+    DeadbandMode deadbandMode( void ) const;
+
+    /*!
+    * Returns the deadband.
+    * \return Deadband, absolute value or percent depending on the mode.
+    */
+    double deadband( void ) const;
+
+    /*!
+    * Forgets the previous sample, so that the next one reports all items as changed.
+    */
+    void reset( void );
+
+    /*!
+    * Compares a register sample against the previously reported one.
+    * \param values The new sample.
+    * \return Indices of the changed registers. For 32 bit types, the index of the first register of each changed
+    *         value is returned.
+    */
+    QList<int> compare( const QList<quint16> &values );
+
+    /*!
+    * Compares a bit sample against the previously reported one. Deadbands do not apply to bits.
+    * \param values The new sample.
+    * \return Indices of the changed bits.
+    */
+    QList<int> compare( const QList<bool> &values );
+
+private:
+    // Appends the indices of the registers that differ between a and b.
+    static void _diff( const quint16 *a , const quint16 *b , const int count , QList<int> &changed );
+
+    // Appends the indices of the bits that differ between a and b (64 bits per word).
+    static void _diff( const quint64 *a , const quint64 *b , const int words , QList<int> &changed );
+
+    // Returns the typed value starting at the given register.
+    double _value( const quint16 *registers , const int index ) const;
+
+    ValueType _valueType;           // Interpretation of the registers.
+    DeadbandMode _deadbandMode;     // Deadband mode.
+    double _deadband;               // Absolute deadband or percent.
+    bool _valid;                    // True if we have a previous sample.
+    int _count;                     // Number of items of the previous sample.
+    QVector<quint16> _previous;     // Last reported registers.
+    QVector<quint16> _current;      // Contiguous copy of the new registers.
+    QVector<quint64> _previousBits; // Last reported bits, packed.
+    QVector<quint64> _currentBits;  // New bits, packed.
+};
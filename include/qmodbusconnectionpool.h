@@ -0,0 +1,305 @@
+/***********************************************************************************************************************
+* QModbusConnectionPool : Per-unit clients multiplexed over a bounded number of sockets to modbus TCP gateways.        *
+************************************************************************************************************************
+* Author : QModbus contributors                                                                                        *
+* Date   : 2026/10/18                                                                                                  *
+* Changes: -                                                                                                           *
+***********************************************************************************************************************/
+#pragma once
+
+
+/*** Base classes *****************************************************************************************************/
+#include <QAbstractModbus>
+
+
+/*** Qt includes & prototypes *****************************************************************************************/
+#include <QModbusRateLimiter>
+#include <QModbusRequest>
+#include <QModbusSharedConnection>
+#include <QTcpModbus>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QHash>
+#include <QtCore/QList>
+#include <QtCore/QMutex>
+#include <QtCore/QSemaphore>
+#include <QtCore/QString>
+class QModbusPoolClient;
+
+
+/*** QModbusConnectionPool class declaration and help *****************************************************************/
+/*!
+* The connection pool serves many logical devices (unit IDs) behind modbus TCP gateways. For each gateway (host and
+* port) it opens at most maximumConnections() sockets, each executed by its own QModbusSharedConnection, and hands out
+* one client per unit ID.
+*
+* The clients of a gateway share its sockets: a request goes to the open socket with the fewest requests in flight and
+* a new socket is only opened once every socket has requests in flight, so each socket's window stays full before the
+* gateway gets another one. The requests in flight are limited per gateway (maximumInFlight()) and per unit
+* (maximumInFlightPerUnit()); a request beyond a limit waits for a slot. Sockets are connected in the background, a
+* socket that is connecting or lost its connection holds its requests meanwhile (see
+* QModbusSharedConnection::setReconnectTimeout()). After a failed connect no socket of the gateway is connected again
+* for one connect timeout; the requests of that time fail at once with NoConnection instead of each waiting for a
+* connect of its own.
+*
+* The pool and the clients can be used from any thread. The limits apply to gateways contacted afterwards. The pool
+* owns the clients, sockets and I/O threads; it has to be destroyed after all client calls returned.
+* \headerfile qmodbusconnectionpool.h QModbusConnectionPool
+*/
+class QModbusConnectionPool
+{
+public:
+    /*!
+    * Constructor.
+    */
+    QModbusConnectionPool( void );
+
+    /*!
+    * Destructor, closes all connections. Requests still queued fail with NoConnection.
+    */
+    ~QModbusConnectionPool();
+
+    /*!
+    * Returns the client of a unit behind a gateway, created on first use. No connection is opened before the first
+    * request.
+    * \param host IP address or DNS name of the gateway.
+    * \param port Port of the gateway.
+    * \param unitId Unit ID of the device, used as device address of all its requests.
+    * \return The client, owned by the pool.
+    */
+    QModbusPoolClient *client( const QString &host , const quint16 port , const quint8 unitId );
+
+    /*!
+    * Returns the number of sockets currently open to a gateway.
+    * \param host IP address or DNS name of the gateway.
+    * \param port Port of the gateway.
+    * \return Number of open sockets.
+    */
+    int connectionCount( const QString &host , const quint16 port ) const;
+
+    /*!
+    * Returns the rate limiter of a gateway, shared by all its sockets (see QModbusRateLimiter). Set the limits of the
+    * gateway and its units before the first request.
+    * \param host IP address or DNS name of the gateway.
+    * \param port Port of the gateway.
+    * \return The rate limiter, owned by the pool.
+    */
+    QModbusRateLimiter *rateLimiter( const QString &host , const quint16 port );
+
+    /*!
+    * Returns the largest number of sockets per gateway. Default is 4.
+    * \return Maximal number of sockets.
+    */
+    int maximumConnections( void ) const;
+
+    /*!
+    * Changes the largest number of sockets per gateway.
+    * \param count Maximal number of sockets.
+    */
+    void setMaximumConnections( const int count );
+
+    /*!
+    * Returns the largest number of requests in flight per gateway. Default is 32.
+    * \return Maximal number of requests in flight.
+    */
+    int maximumInFlight( void ) const;
+
+    /*!
+    * Changes the largest number of requests in flight per gateway.
+    * \param count Maximal number of requests in flight.
+    */
+    void setMaximumInFlight( const int count );
+
+    /*!
+    * Returns the largest number of requests in flight per unit. Default is 4.
+    * \return Maximal number of requests in flight.
+    */
+    int maximumInFlightPerUnit( void ) const;
+
+    /*!
+    * Changes the largest number of requests in flight per unit.
+    * \param count Maximal number of requests in flight.
+    */
+    void setMaximumInFlightPerUnit( const int count );
+
+private:
+    Q_DISABLE_COPY( QModbusConnectionPool )
+    friend class QModbusPoolClient;
+
+    struct Gateway
+    {
+        Gateway( const int connections , const int inFlight ) :
+            maximumConnections( connections ) , retryAt( 0 ) , freeSlots( inFlight ) , timeout( 500 )
+        {
+            clock.start();
+        }
+
+        QString host;
+        quint16 port;
+        int maximumConnections;                         // Sockets the gateway may get.
+        QMutex mutex;                                   // Protects the sockets.
+        QList<QTcpModbus *> transports;                 // Sockets.
+        QList<QModbusSharedConnection *> connections;   // I/O threads of the sockets.
+        QList<qint64> connectStarted;                   // Start of the last connect of the sockets, -1 if settled.
+        QElapsedTimer clock;                            // Gateway clock.
+        qint64 retryAt;                                 // No connect is started before, set by a failed connect.
+        QSemaphore freeSlots;                           // Free slots for requests in flight.
+        int timeout;                                    // Timeout of the sockets.
+        QHash<quint8,QModbusPoolClient *> clients;      // Clients by unit ID.
+        QModbusRateLimiter limiter;                     // Rate limits of the gateway and its units.
+    };
+
+    // Returns a gateway, created on first use. The caller holds _mutex.
+    Gateway *_gateway( const QString &host , const quint16 port );
+
+    // Returns the connection of a gateway for the next request, starts connecting another socket if all are busy.
+    // NULL if no socket is open or connecting and a connect failed recently.
+    QModbusSharedConnection *_pick( Gateway *const gateway ) const;
+
+    mutable QMutex _mutex;                              // Protects the gateways and clients.
+    QHash<QString,Gateway *> _gateways;                 // Gateways by "host:port".
+    int _maximumConnections;                            // Sockets per gateway.
+    int _maximumInFlight;                               // Requests in flight per gateway.
+    int _maximumInFlightPerUnit;                        // Requests in flight per unit.
+};
+
+
+/*** QModbusPoolClient class declaration and help *********************************************************************/
+/*!
+* Client of a unit behind a gateway, handed out by QModbusConnectionPool. The device address of every request is
+* replaced by the unit ID of the client, so code written for a transport talking to a single device works unchanged.
+* \headerfile qmodbusconnectionpool.h QModbusPoolClient
+*/
+class QModbusPoolClient : public QAbstractModbus
+{
+public:
+    //! Returns the unit ID of the client.
+    quint8 unitId( void ) const;
+
+    /*!
+    * Executes a request, waits for a free slot first if a limit is reached.
+    * \param request The request.
+    * \return The response.
+    */
+    QModbusResponse execute( const QModbusRequest &request ) const;
+
+    // Interface implementation (QAbstractModbus), true if a socket to the gateway is open.
+    bool isOpen( void ) const;
+
+    // Interface implementation (QAbstractModbus).
+    unsigned int timeout( void ) const;
+
+    // Interface implementation (QAbstractModbus), applies to all sockets of the gateway.
+    void setTimeout( const unsigned int timeout );
+
+    // Interface implementation (QAbstractModbus).
+    QList<bool> readCoils( const quint8 deviceAddress ,
+                           const quint16 startingAddress ,
+                           const quint16 quantityOfCoils ,
+                           quint8 *const status = NULL
+                         ) const;
+
+    // Interface implementation (QAbstractModbus).
+    QList<bool> readDiscreteInputs( const quint8 deviceAddress ,
+                                    const quint16 startingAddress ,
+                                    const quint16 quantityOfInputs ,
+                                    quint8 *const status = NULL
+                                  ) const;
+
+    // Interface implementation (QAbstractModbus).
+    QList<quint16> readHoldingRegisters( const quint8 deviceAddress ,
+                                         const quint16 startingAddress ,
+                                         const quint16 quantityOfRegisters ,
+                                         quint8 *const status = NULL
+                                       ) const;
+
+    // Interface implementation (QAbstractModbus).
+    QList<quint16> readInputRegisters( const quint8 deviceAddress ,
+                                       const quint16 startingAddress ,
+                                       const quint16 quantityOfInputRegisters ,
+                                       quint8 *const status = NULL
+                                     ) const;
+
+    // Interface implementation (QAbstractModbus).
+    bool writeSingleCoil( const quint8 deviceAddress ,
+                          const quint16 outputAddress ,
+                          const bool outputValue ,
+                          quint8 *const status = NULL
+                        ) const;
+
+    // Interface implementation (QAbstractModbus).
+    bool writeSingleRegister( const quint8 deviceAddress ,
+                              const quint16 registerAddress ,
+                              const quint16 registerValue ,
+                              quint8 *const status = NULL
+                            ) const;
+
+    // Interface implementation (QAbstractModbus).
+    bool writeMultipleCoils( const quint8 deviceAddress ,
+                             const quint16 startingAddress ,
+                             const QList<bool> & outputValues ,
+                             quint8 *const status = NULL
+                           ) const;
+
+    // Interface implementation (QAbstractModbus).
+    bool writeMultipleRegisters( const quint8 deviceAddress ,
+                                 const quint16 startingAddress ,
+                                 const QList<quint16> & registersValues ,
+                                 quint8 *const status = NULL
+                               ) const;
+
+    // Interface implementation (QAbstractModbus).
+    bool maskWriteRegister( const quint8 deviceAddress ,
+                            const quint16 referenceAddress ,
+                            const quint16 andMask ,
+                            const quint16 orMask ,
+                            quint8 *const status = NULL
+                          ) const;
+
+    // Interface implementation (QAbstractModbus).
+    QList<quint16> writeReadMultipleRegisters( const quint8 deviceAddress ,
+                                               const quint16 writeStartingAddress ,
+                                               const QList<quint16> & writeValues ,
+                                               const quint16 readStartingAddress ,
+                                               const quint16 quantityToRead ,
+                                               quint8 *const status = NULL
+                                             ) const;
+
+    // Interface implementation (QAbstractModbus).
+    QList<quint16> readFifoQueue( const quint8 deviceAddress ,
+                                  const quint16 fifoPointerAddress ,
+                                  quint8 *const status = NULL
+                                ) const;
+
+    // Interface implementation (QAbstractModbus).
+    QByteArray executeCustomFunction( const quint8 deviceAddress , const quint8 modbusFunction ,
+                                      QByteArray &data , quint8 *const status = NULL ) const;
+
+    // Interface implementation (QAbstractModbus).
+    bool executePdu( const quint8 deviceAddress , const QModbusFrameView &request , QModbusPduFrame &response ,
+                     quint8 *const status = NULL ) const;
+
+    // Interface implementation (QAbstractModbus), the requests are spread over the sockets within the limits.
+    QList<QModbusResponse> execute( const QList<QModbusRequest> &batch ) const;
+
+    // Interface implementation (QAbstractModbus), the data is sent unchanged (the unit ID is not replaced).
+    QByteArray executeRaw( QByteArray &data , quint8 *const status = NULL ) const;
+
+    // Interface implementation (QAbstractModbus).
+    QByteArray calculateCheckSum( QByteArray &data ) const;
+
+private:
+    Q_DISABLE_COPY( QModbusPoolClient )
+    friend class QModbusConnectionPool;
+
+    // Constructor, used by the pool.
+    QModbusPoolClient( const QModbusConnectionPool &pool , QModbusConnectionPool::Gateway *const gateway ,
+                       const quint8 unitId , const int inFlight );
+
+    // Completion handler of the requests, frees their slots.
+    static void _release( const QModbusResponse &response , void *context );
+
+    const QModbusConnectionPool &_pool; // The pool.
+    QModbusConnectionPool::Gateway *_gateway;   // The gateway of the unit.
+    quint8 _unitId;                 // Unit ID.
+    mutable QSemaphore _slots;      // Free slots for requests in flight of the unit.
+};
@@ -0,0 +1,236 @@
+/***********************************************************************************************************************
+* QModbusCoroutine : C++20 coroutine interface to a shared modbus connection.                                         *
+************************************************************************************************************************
+* Author : QModbus contributors                                                                                        *
+* Date   : 2026/10/18                                                                                                  *
+* Changes: -                                                                                                           *
+***********************************************************************************************************************/
+#pragma once
+
+
+/*** Qt includes & prototypes *****************************************************************************************/
+#include <QModbusRequest>
+#include <QModbusSharedConnection>
+#include <QtCore/QList>
+
+
+# /***/ if !defined( __cpp_impl_coroutine ) || __cpp_impl_coroutine < 201902L /*************************************/
+#   error "QModbusCoroutine needs C++20 coroutines, compile the code including it with CONFIG += c++2a (-std=c++20)."
+# /***/ endif /* __cpp_impl_coroutine *********************************************************************************/
+
+
+/*** System includes **************************************************************************************************/
+#include <coroutine>
+#include <exception>
+
+
+/*** QModbusAwaitable class declaration and help **********************************************************************/
+/*!
+* The awaitable of a modbus request. co_await submits the request to the shared connection and suspends the coroutine
+* without blocking a thread, the coroutine is resumed by the I/O thread of the connection once the reply is finished.
+* The result of co_await is the QModbusResponse: timeouts, exceptions and all other errors are reported by its status.
+*
+* After the co_await the coroutine runs on the I/O thread until it is suspended again or returns, so it must neither
+* block nor call the blocking methods of the connection, and long computations delay the other requests. A request
+* that can not be submitted (invalid or the connection is stopping) resumes the coroutine immediately.
+* \headerfile qmodbuscoroutine.h QModbusCoroutine
+*/
+class QModbusAwaitable
+{
+public:
+    /*!
+    * Constructor.
+    * \param connection The connection executing the request.
+    * \param request The request.
+    */
+    QModbusAwaitable( const QModbusSharedConnection &connection , const QModbusRequest &request );
+
+    // Awaitable interface.
+    bool await_ready( void ) const;
+    void await_suspend( const std::coroutine_handle<> handle );
+    QModbusResponse await_resume( void ) const;
+
+private:
+    // Completion handler: stores the response and resumes the coroutine.
+    static void _resume( const QModbusResponse &response , void *context );
+
+    const QModbusSharedConnection &_connection;     // Connection executing the request.
+    QModbusRequest _request;        // The request.
+    QModbusResponse _response;      // The response, stored before the coroutine is resumed.
+    std::coroutine_handle<> _handle;    // The suspended coroutine.
+};
+
+
+/*** QModbusTask class declaration and help ***************************************************************************/
+/*!
+* Return type of a coroutine that runs on its own ("device program"): the coroutine starts immediately when called and
+* its frame is released when it returns. Thousands of them can wait for their replies on one shared connection at the
+* cost of their coroutine frames, no thread is needed per program. Exceptions leaving the coroutine terminate the
+* application.
+*
+* Example:
+* \code
+* QModbusTask regulate( QModbusCoroutineClient &client )
+* {
+*     QModbusResponse state = co_await client.readHoldingRegisters( 1 , 100 , 2 );
+*     if ( state.isOk() && state.registers().at( 0 ) == 0 ) co_await client.writeSingleRegister( 1 , 200 , 1 );
+* }
+* \endcode
+* \headerfile qmodbuscoroutine.h QModbusCoroutine
+*/
+class QModbusTask
+{
+public:
+    // Coroutine promise.
+    struct promise_type
+    {
+        QModbusTask get_return_object( void ) { return QModbusTask(); }
+        std::suspend_never initial_suspend( void ) noexcept { return std::suspend_never(); }
+        std::suspend_never final_suspend( void ) noexcept { return std::suspend_never(); }
+        void return_void( void ) {}
+        void unhandled_exception( void ) { std::terminate(); }
+    };
+};
+
+
+/*** QModbusCoroutineClient class declaration and help ****************************************************************/
+/*!
+* The coroutine client creates the awaitables of the standard modbus functions for a shared connection. Any transport
+* (QRtuModbus, QAsciiModbus or QTcpModbus) can be used through a QModbusSharedConnection, its I/O thread is the
+* executor the coroutines are resumed on. Any other function can be awaited using execute().
+* \headerfile qmodbuscoroutine.h QModbusCoroutine
+*/
+class QModbusCoroutineClient
+{
+public:
+    /*!
+    * Constructor.
+    * \param connection The connection to use. It has to stay valid as long as the client or one of its awaitables
+    *                   exists.
+    */
+    explicit QModbusCoroutineClient( const QModbusSharedConnection &connection );
+
+    //! Awaits any request.
+    QModbusAwaitable execute( const QModbusRequest &request ) const;
+
+    //! Awaits read coils (0x01), decode the response with QModbusResponse::bits().
+    QModbusAwaitable readCoils( const quint8 deviceAddress , const quint16 startingAddress ,
+                                const quint16 quantityOfCoils ) const;
+
+    //! Awaits read discrete inputs (0x02), decode the response with QModbusResponse::bits().
+    QModbusAwaitable readDiscreteInputs( const quint8 deviceAddress , const quint16 startingAddress ,
+                                         const quint16 quantityOfInputs ) const;
+
+    //! Awaits read holding registers (0x03), decode the response with QModbusResponse::registers().
+    QModbusAwaitable readHoldingRegisters( const quint8 deviceAddress , const quint16 startingAddress ,
+                                           const quint16 quantityOfRegisters ) const;
+
+    //! Awaits read input registers (0x04), decode the response with QModbusResponse::registers().
+    QModbusAwaitable readInputRegisters( const quint8 deviceAddress , const quint16 startingAddress ,
+                                         const quint16 quantityOfInputRegisters ) const;
+
+    //! Awaits write single coil (0x05).
+    QModbusAwaitable writeSingleCoil( const quint8 deviceAddress , const quint16 outputAddress ,
+                                      const bool outputValue ) const;
+
+    //! Awaits write single register (0x06).
+    QModbusAwaitable writeSingleRegister( const quint8 deviceAddress , const quint16 registerAddress ,
+                                          const quint16 registerValue ) const;
+
+    //! Awaits write multiple registers (0x10).
+    QModbusAwaitable writeMultipleRegisters( const quint8 deviceAddress , const quint16 startingAddress ,
+                                             const QList<quint16> &registersValues ) const;
+
+private:
+    const QModbusSharedConnection &_connection; // Connection to use.
+};
+
+
+/*** QModbusAwaitable implementation **********************************************************************************/
+inline QModbusAwaitable::QModbusAwaitable( const QModbusSharedConnection &connection ,
+                                           const QModbusRequest &request ) :
+    _connection( connection ) , _request( request )
+{}
+
+inline bool QModbusAwaitable::await_ready( void ) const
+{
+    return false;
+}
+
+inline void QModbusAwaitable::await_suspend( const std::coroutine_handle<> handle )
+{
+    // The coroutine may be resumed (and this awaitable destroyed) before submit() returns.
+    _handle = handle;
+    _connection.submit( _request , &QModbusAwaitable::_resume , this );
+}
+
+inline QModbusResponse QModbusAwaitable::await_resume( void ) const
+{
+    return _response;
+}
+
+inline void QModbusAwaitable::_resume( const QModbusResponse &response , void *context )
+{
+    QModbusAwaitable *const awaitable = static_cast<QModbusAwaitable *>( context );
+    awaitable->_response = response;
+    awaitable->_handle.resume();
+}
+
+
+/*** QModbusCoroutineClient implementation ****************************************************************************/
+inline QModbusCoroutineClient::QModbusCoroutineClient( const QModbusSharedConnection &connection ) :
+    _connection( connection )
+{}
+
+inline QModbusAwaitable QModbusCoroutineClient::execute( const QModbusRequest &request ) const
+{
+    return QModbusAwaitable( _connection , request );
+}
+
+inline QModbusAwaitable QModbusCoroutineClient::readCoils( const quint8 deviceAddress , const quint16 startingAddress ,
+                                                           const quint16 quantityOfCoils ) const
+{
+    return execute( QModbusRequest::readCoils( deviceAddress , startingAddress , quantityOfCoils ) );
+}
+
+inline QModbusAwaitable QModbusCoroutineClient::readDiscreteInputs( const quint8 deviceAddress ,
+                                                                    const quint16 startingAddress ,
+                                                                    const quint16 quantityOfInputs ) const
+{
+    return execute( QModbusRequest::readDiscreteInputs( deviceAddress , startingAddress , quantityOfInputs ) );
+}
+
+inline QModbusAwaitable QModbusCoroutineClient::readHoldingRegisters( const quint8 deviceAddress ,
+                                                                      const quint16 startingAddress ,
+                                                                      const quint16 quantityOfRegisters ) const
+{
+    return execute( QModbusRequest::readHoldingRegisters( deviceAddress , startingAddress , quantityOfRegisters ) );
+}
+
+inline QModbusAwaitable QModbusCoroutineClient::readInputRegisters( const quint8 deviceAddress ,
+                                                                    const quint16 startingAddress ,
+                                                                    const quint16 quantityOfInputRegisters ) const
+{
+    return execute( QModbusRequest::readInputRegisters( deviceAddress , startingAddress , quantityOfInputRegisters ) );
+}
+
+inline QModbusAwaitable QModbusCoroutineClient::writeSingleCoil( const quint8 deviceAddress ,
+                                                                 const quint16 outputAddress ,
+                                                                 const bool outputValue ) const
+{
+    return execute( QModbusRequest::writeSingleCoil( deviceAddress , outputAddress , outputValue ) );
+}
+
+inline QModbusAwaitable QModbusCoroutineClient::writeSingleRegister( const quint8 deviceAddress ,
+                                                                     const quint16 registerAddress ,
+                                                                     const quint16 registerValue ) const
+{
+    return execute( QModbusRequest::writeSingleRegister( deviceAddress , registerAddress , registerValue ) );
+}
+
+inline QModbusAwaitable QModbusCoroutineClient::writeMultipleRegisters( const quint8 deviceAddress ,
+                                                                        const quint16 startingAddress ,
+                                                                        const QList<quint16> &registersValues ) const
+{
+    return execute( QModbusRequest::writeMultipleRegisters( deviceAddress , startingAddress , registersValues ) );
+}
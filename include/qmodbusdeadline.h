@@ -0,0 +1,147 @@
+/***********************************************************************************************************************
+* QModbusDeadline : Per-request deadlines and cancellation tokens.                                                     *
+************************************************************************************************************************
+* Author : QModbus contributors                                                                                        *
+* Date   : 2026/10/18                                                                                                  *
+* Changes: -                                                                                                           *
+***********************************************************************************************************************/
+#pragma once
+
+
+/*** Qt includes & prototypes *****************************************************************************************/
+#include <QtCore/QAtomicInt>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QSharedPointer>
+
+
+/*** QModbusDeadline class declaration and help ***********************************************************************/
+/*!
+* A point in time a request has to be finished by. A default constructed deadline never expires. The transports wait
+* for the reply at most until the deadline and then report QAbstractModbus::Timeout, the connection wide timeout still
+* applies to each wait.
+* \headerfile qmodbusdeadline.h QModbusDeadline
+*/
+class QModbusDeadline
+{
+public:
+    //! Constructs a deadline that never expires.
+    QModbusDeadline( void );
+
+    /*!
+    * Constructs a deadline the given time from now.
+    * \param msecs Milliseconds from now, 0 or less for a deadline that has already expired.
+    */
+    explicit QModbusDeadline( const int msecs );
+
+    //! Returns true if the deadline never expires.
+    bool isNever( void ) const;
+
+    //! Returns true if the deadline has passed.
+    bool hasExpired( void ) const;
+
+    /*!
+    * Returns the time left until the deadline.
+    * \param limit Returned if the deadline never expires or is further away.
+    * \return Milliseconds left (0 once expired), at most limit.
+    */
+    int remaining( const int limit ) const;
+
+private:
+    QElapsedTimer _start;           // Time the deadline was set.
+    qint64 _msecs;                  // Milliseconds after the start, -1 for never.
+};
+
+
+/*** QModbusCancellationToken class declaration and help **************************************************************/
+/*!
+* A token to abandon requests. Copies of a token share their state: the caller keeps a copy, attaches another one to
+* one or more requests (see QModbusRequest::setCancellationToken()) and calls cancel() from any thread. A request that
+* was not sent yet is never sent, a request waiting for its reply stops waiting; both finish with
+* QAbstractModbus::Cancelled. Once a reply started to arrive, it is received completely to keep the stream in sync.
+*
+* A default constructed token can be cancelled, none() returns a token that never is (and allocates nothing).
+* \headerfile qmodbusdeadline.h QModbusCancellationToken
+*/
+class QModbusCancellationToken
+{
+public:
+    enum
+    {
+        PollInterval = 10   //!< Milliseconds between two checks of a token while a transport waits.
+    };
+
+    //! Constructs a new token that is not cancelled.
+    QModbusCancellationToken( void );
+
+    //! Returns a token that can not be cancelled.
+    static QModbusCancellationToken none( void );
+
+    //! Returns true if the token can be cancelled (it is not none()).
+    bool isCancellable( void ) const;
+
+    //! Cancels the requests of the token, can be called from any thread.
+    void cancel( void );
+
+    //! Returns true once the token was cancelled.
+    bool isCancelled( void ) const;
+
+private:
+    // Constructs a token with the given state.
+    explicit QModbusCancellationToken( const QSharedPointer<QAtomicInt> &state );
+
+    QSharedPointer<QAtomicInt> _state;  // Shared state, 1 once cancelled. NULL for none().
+};
+
+
+/*** QModbusDeadline implementation ***********************************************************************************/
+inline QModbusDeadline::QModbusDeadline( void ) : _msecs( -1 )
+{}
+
+inline QModbusDeadline::QModbusDeadline( const int msecs ) : _msecs( qMax( 0 , msecs ) )
+{
+    _start.start();
+}
+
+inline bool QModbusDeadline::isNever( void ) const
+{
+    return _msecs < 0;
+}
+
+inline bool QModbusDeadline::hasExpired( void ) const
+{
+    return _msecs >= 0 && _start.hasExpired( _msecs );
+}
+
+inline int QModbusDeadline::remaining( const int limit ) const
+{
+    if ( _msecs < 0 ) return limit;
+    return (int)qBound( (qint64)0 , _msecs - _start.elapsed() , (qint64)limit );
+}
+
+
+/*** QModbusCancellationToken implementation **************************************************************************/
+inline QModbusCancellationToken::QModbusCancellationToken( void ) : _state( new QAtomicInt( 0 ) )
+{}
+
+inline QModbusCancellationToken::QModbusCancellationToken( const QSharedPointer<QAtomicInt> &state ) : _state( state )
+{}
+
+inline QModbusCancellationToken QModbusCancellationToken::none( void )
+{
+    return QModbusCancellationToken( QSharedPointer<QAtomicInt>() );
+}
+
+inline bool QModbusCancellationToken::isCancellable( void ) const
+{
+    return !_state.isNull();
+}
+
+inline void QModbusCancellationToken::cancel( void )
+{
+    if ( _state ) _state->fetchAndStoreRelease( 1 );
+}
+
+inline bool QModbusCancellationToken::isCancelled( void ) const
+{
+    return _state && _state->fetchAndAddAcquire( 0 );
+}
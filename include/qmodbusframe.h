@@ -0,0 +1,292 @@
+/***********************************************************************************************************************
+* QModbusFrame : Fixed capacity frame buffers and views, modbus frames without heap allocations.                      *
+************************************************************************************************************************
+* Author : QModbus contributors                                                                                        *
+* Date   : 2026/10/18                                                                                                  *
+* Changes: -                                                                                                           *
+***********************************************************************************************************************/
+#pragma once
+
+
+/*** Qt includes & prototypes *****************************************************************************************/
+#include <QModbusPdu>
+#include <QtCore/QByteArray>
+#include <QtCore/QtGlobal>
+#include <cstring>
+
+
+/*** QModbusFrameView class declaration and help **********************************************************************/
+/*!
+* A view refers to bytes owned by somebody else (a QModbusFrame, a QByteArray or a plain array), it never copies or
+* allocates. The referred bytes have to stay valid as long as the view is used.
+* \headerfile qmodbusframe.h QModbusFrame
+*/
+class QModbusFrameView
+{
+public:
+    //! Constructs an empty view.
+    QModbusFrameView( void );
+
+    /*!
+    * Constructs a view of size bytes at data.
+    * \param data First byte.
+    * \param size Number of bytes.
+    */
+    QModbusFrameView( const char *const data , const int size );
+
+    /*!
+    * Constructs a view of the content of a byte array.
+    * \param data The byte array, must not be modified or destroyed while the view is in use.
+    */
+    explicit QModbusFrameView( const QByteArray &data );
+
+    //! Returns a pointer to the first byte.
+    const char *data( void ) const;
+
+    //! Returns the number of bytes.
+    int size( void ) const;
+
+    //! Returns true if the view has no bytes.
+    bool isEmpty( void ) const;
+
+    //! Returns the byte at the given index [0..size()-1].
+    quint8 at( const int index ) const;
+
+    //! Returns the 16 bit value (big endian) starting at the given byte index [0..size()-2].
+    quint16 value( const int index ) const;
+
+    /*!
+    * Returns a part of the view.
+    * \param position Index of the first byte.
+    * \param length Number of bytes, -1 for all bytes up to the end.
+    * \return View of the part, empty if position is out of range.
+    */
+    QModbusFrameView mid( const int position , const int length = -1 ) const;
+
+    //! Copies the bytes into a new byte array (allocates).
+    QByteArray toByteArray( void ) const;
+
+    //! Returns true if both views have the same bytes.
+    bool operator ==( const QModbusFrameView &other ) const;
+
+    //! Returns true if the views differ.
+    bool operator !=( const QModbusFrameView &other ) const;
+
+private:
+    const char *_data;  // First byte.
+    int _size;          // Number of bytes.
+};
+
+
+/*** QModbusFrame class declaration and help **************************************************************************/
+/*!
+* A frame stores up to Capacity bytes inline, so a frame declared as a local variable lives completely on the stack.
+* Modbus frames are bounded (see QModbusPdu), so the transports use frames of the maximal size for the PDU and each
+* ADU variant and steady state polling does not allocate for the frames at all. Appending beyond the capacity fails
+* and leaves the frame unchanged.
+* \headerfile qmodbusframe.h QModbusFrame
+*/
+template< int Capacity >
+class QModbusFrame
+{
+public:
+    //! Constructs an empty frame.
+    QModbusFrame( void );
+
+    //! Returns the number of bytes the frame can hold.
+    static int capacity( void ) { return Capacity; }
+
+    //! Returns a pointer to the storage, data can be written directly followed by resize().
+    char *data( void );
+
+    //! Returns a pointer to the first byte.
+    const char *constData( void ) const;
+
+    //! Returns the number of bytes.
+    int size( void ) const;
+
+    //! Returns true if the frame has no bytes.
+    bool isEmpty( void ) const;
+
+    //! Returns the byte at the given index [0..size()-1].
+    quint8 at( const int index ) const;
+
+    //! Removes all bytes.
+    void clear( void );
+
+    /*!
+    * Sets the number of bytes, new bytes are not initialized.
+    * \param size New size [0..Capacity].
+    * \return True on success, false if size is out of range.
+    */
+    bool resize( const int size );
+
+    /*!
+    * Appends a byte.
+    * \param byte The byte.
+    * \return True on success, false if the frame is full.
+    */
+    bool append( const char byte );
+
+    /*!
+    * Appends bytes.
+    * \param data First byte.
+    * \param size Number of bytes.
+    * \return True on success, false if the bytes do not fit.
+    */
+    bool append( const char *const data , const int size );
+
+    //! Returns a view of the frame, valid as long as the frame is neither modified nor destroyed.
+    QModbusFrameView view( void ) const;
+
+    //! Returns a view of a part of the frame, see QModbusFrameView::mid().
+    QModbusFrameView mid( const int position , const int length = -1 ) const;
+
+private:
+    char _data[Capacity];   // Storage.
+    int _size;              // Number of bytes used.
+};
+
+
+/*** Frame types ******************************************************************************************************/
+typedef QModbusFrame<QModbusPdu::MaxSize>           QModbusPduFrame;    //!< Any PDU.
+typedef QModbusFrame<QModbusPdu::MaxRtuAduSize>     QModbusRtuFrame;    //!< Any RTU ADU.
+typedef QModbusFrame<QModbusPdu::MaxAsciiAduSize>   QModbusAsciiFrame;  //!< Any ASCII ADU.
+typedef QModbusFrame<QModbusPdu::MaxTcpAduSize>     QModbusTcpFrame;    //!< Any TCP ADU.
+
+
+/*** QModbusFrameView implementation **********************************************************************************/
+inline QModbusFrameView::QModbusFrameView( void ) : _data( NULL ) , _size( 0 )
+{}
+
+inline QModbusFrameView::QModbusFrameView( const char *const data , const int size ) : _data( data ) , _size( size )
+{}
+
+inline QModbusFrameView::QModbusFrameView( const QByteArray &data ) : _data( data.constData() ) , _size( data.size() )
+{}
+
+inline const char *QModbusFrameView::data( void ) const
+{
+    return _data;
+}
+
+inline int QModbusFrameView::size( void ) const
+{
+    return _size;
+}
+
+inline bool QModbusFrameView::isEmpty( void ) const
+{
+    return _size == 0;
+}
+
+inline quint8 QModbusFrameView::at( const int index ) const
+{
+    return (quint8)_data[index];
+}
+
+inline quint16 QModbusFrameView::value( const int index ) const
+{
+    return QModbusPdu::get( _data + index );
+}
+
+inline QModbusFrameView QModbusFrameView::mid( const int position , const int length ) const
+{
+    if ( position < 0 || position >= _size ) return QModbusFrameView();
+    const int available = _size - position;
+    return QModbusFrameView( _data + position , length < 0 || length > available ? available : length );
+}
+
+inline QByteArray QModbusFrameView::toByteArray( void ) const
+{
+    return QByteArray( _data , _size );
+}
+
+inline bool QModbusFrameView::operator ==( const QModbusFrameView &other ) const
+{
+    return _size == other._size && ( _size == 0 || memcmp( _data , other._data , _size ) == 0 );
+}
+
+inline bool QModbusFrameView::operator !=( const QModbusFrameView &other ) const
+{
+    return !( *this == other );
+}
+
+
+/*** QModbusFrame implementation **************************************************************************************/
+template< int Capacity >
+inline QModbusFrame<Capacity>::QModbusFrame( void ) : _size( 0 )
+{}
+
+template< int Capacity >
+inline char *QModbusFrame<Capacity>::data( void )
+{
+    return _data;
+}
+
+template< int Capacity >
+inline const char *QModbusFrame<Capacity>::constData( void ) const
+{
+    return _data;
+}
+
+template< int Capacity >
+inline int QModbusFrame<Capacity>::size( void ) const
+{
+    return _size;
+}
+
+template< int Capacity >
+inline bool QModbusFrame<Capacity>::isEmpty( void ) const
+{
+    return _size == 0;
+}
+
+template< int Capacity >
+inline quint8 QModbusFrame<Capacity>::at( const int index ) const
+{
+    return (quint8)_data[index];
+}
+
+template< int Capacity >
+inline void QModbusFrame<Capacity>::clear( void )
+{
+    _size = 0;
+}
+
+template< int Capacity >
+inline bool QModbusFrame<Capacity>::resize( const int size )
+{
+    if ( size < 0 || size > Capacity ) return false;
+    _size = size;
+    return true;
+}
+
+template< int Capacity >
+inline bool QModbusFrame<Capacity>::append( const char byte )
+{
+    if ( _size == Capacity ) return false;
+    _data[_size++] = byte;
+    return true;
+}
+
+template< int Capacity >
+inline bool QModbusFrame<Capacity>::append( const char *const data , const int size )
+{
+    if ( size < 0 || size > Capacity - _size ) return false;
+    if ( size ) memcpy( _data + _size , data , size );
+    _size += size;
+    return true;
+}
+
+template< int Capacity >
+inline QModbusFrameView QModbusFrame<Capacity>::view( void ) const
+{
+    return QModbusFrameView( _data , _size );
+}
+
+template< int Capacity >
+inline QModbusFrameView QModbusFrame<Capacity>::mid( const int position , const int length ) const
+{
+    return view().mid( position , length );
+}
@@ -0,0 +1,678 @@
+/***********************************************************************************************************************
+* QModbusFraming : Framing policies (RTU, ASCII and TCP) used by the request core.                                    *
+************************************************************************************************************************
+* Author : QModbus contributors                                                                                        *
+* Date   : 2026/10/18                                                                                                  *
+* Changes: -                                                                                                           *
+***********************************************************************************************************************/
+#pragma once
+
+
+/*** Qt includes & prototypes *****************************************************************************************/
+#include <QAbstractModbus>
+#include <QModbusFrame>
+#include <QModbusPdu>
+#include <QModbusRequest>
+#include <QModbusTransactionTable>
+#include <QtCore/QByteArray>
+#include <QtCore/QList>
+#include <QtCore/QtGlobal>
+
+
+/*** System includes **************************************************************************************************/
+#include <string.h>
+
+
+/*** Framing policies declaration and help ****************************************************************************/
+/*!
+* A framing policy wraps a modbus PDU (function code and data) into the application data unit of a modbus variant,
+* sends it using an I/O policy, receives the response and unwraps it again. The policies are used as template
+* parameters of QModbusRequestCore, so the framing code is inlined into each modbus function.
+*
+* All policies implement the same methods:
+*
+* template< class Io > quint8 transact( const Io &io , const quint8 deviceAddress , const char *const request ,
+*                                       const int size , const int expected , QModbusPduFrame &response ) const;
+*
+* request is the PDU to send (size bytes), expected the length of the response PDU or -1 if the length is not known in
+* advance. On success, response contains the response PDU and Ok is returned. Otherwise the status is Timeout, CrcError,
+* UnknownError (frame does not match the request) or the exception code returned by the device.
+*
+* template< class Io > void transact( const Io &io , const QList<QModbusRequest> &batch ,
+*                                     QList<QModbusResponse> &responses ) const;
+*
+* Executes a batch of requests and appends one response per request to responses, in the order of the batch. The ADUs
+* of the batch are encoded in one pass into a single buffer. Invalid requests fail with IllegalDataValue.
+*
+* The ADUs are built and received in QModbusFrame buffers on the stack, so a transaction does not allocate memory.
+*
+* The requests of a batch are limited by their deadline and cancellation token (see QModbusRequest::setDeadline()): a
+* request that is cancelled or expired before it is sent is not sent, one that is while waiting for its reply stops
+* waiting unless the reply started to arrive. Either way, it fails with Cancelled or Timeout. RTU waits for the late
+* reply and drops it before the next request, TCP frees the transaction slot and sends a limited request in a window of
+* its own. A timeout fails only the requests it concerns (on TCP, those of the window still waiting for their reply);
+* the rest of the batch is only given up if the connection is lost or the stream is out of sync (partial or malformed
+* frame).
+*
+* The I/O policy has to provide these methods (all const):
+*   - bool isOpen( void )                           Returns true while the connection is up.
+*   - void discard( void )                          Drops pending received data.
+*   - void limit( const QModbusDeadline &deadline , const QModbusCancellationToken &token )
+*                                                   Bounds the waits of the following reads by a deadline and a token
+*                                                   as long as they did not receive any byte (none() lifts the limit).
+*   - int read( char *data , int size )             Reads up to size bytes, waiting at most the transport's timeout.
+*   - int readAll( char *data , int maxSize )       Reads what arrives within the timeout, at most maxSize bytes.
+*   - int readLine( char *data , int maxSize )      Reads a line ending with LF of at most maxSize - 1 bytes and
+*                                                   appends a terminating '\0' (as QIODevice::readLine()).
+*   - bool write( const char *data , int size )     Sends data.
+* The read methods return the number of bytes read.
+* \headerfile qmodbusframing.h QModbusFraming
+*/
+
+/*!
+* Framing of modbus RTU: device address, PDU and CRC16 (low byte first).
+*/
+class QModbusRtuFraming
+{
+public:
+    enum
+    {
+        LateReplySilence = 20       //!< Silence in milliseconds after which a late reply is considered passed.
+    };
+
+    /*!
+    * Calculates the modbus CRC16.
+    * \param data The data.
+    * \param size Number of bytes.
+    * \return The CRC.
+    */
+    static quint16 crc( const char *data , const int size );
+
+    /*!
+    * Encodes an ADU.
+    * \param adu Receives size + 3 bytes.
+    * \param deviceAddress Address of the slave device.
+    * \param request The request PDU.
+    * \param size Size of the request PDU.
+    * \return Size of the ADU.
+    */
+    static int encode( char *const adu , const quint8 deviceAddress , const char *const request , const int size );
+
+    //! See above.
+    template< class Io >
+    quint8 transact( const Io &io , const quint8 deviceAddress , const char *const request , const int size ,
+                     const int expected , QModbusPduFrame &response ) const;
+
+    //! See above, the requests are sent one after the other in the order of the batch.
+    template< class Io >
+    void transact( const Io &io , const QList<QModbusRequest> &batch , QList<QModbusResponse> &responses ) const;
+
+private:
+    // Sends an encoded ADU and receives the response.
+    template< class Io >
+    quint8 _exchange( const Io &io , const char *const adu , const int size , const quint8 deviceAddress ,
+                      const int expected , QModbusPduFrame &response ) const;
+};
+
+/*!
+* Framing of modbus ASCII: colon, hex encoded device address, PDU and LRC, CR LF.
+*/
+class QModbusAsciiFraming
+{
+public:
+    /*!
+    * Calculates the modbus LRC.
+    * \param data The data.
+    * \param size Number of bytes.
+    * \return The LRC.
+    */
+    static quint8 lrc( const char *data , const int size );
+
+    /*!
+    * Encodes data to upper case hex followed by the hex encoded LRC of the data, in a single pass. Long data is
+    * encoded 16 bytes at a time using SSE2 if available.
+    * \param data The data (device address and PDU).
+    * \param size Number of bytes.
+    * \param hex Receives 2 * size + 2 characters.
+    * \return Number of characters written.
+    */
+    static int encodeFrame( const char *data , const int size , char *hex );
+
+    /*!
+    * Decodes hex (upper or lower case) to binary data and verifies the LRC in the last byte, in a single pass. Long
+    * frames are decoded 32 characters at a time using SSE2 if available.
+    * \param hex The hex characters (without colon and CR LF).
+    * \param size Number of characters.
+    * \param data Receives size / 2 bytes, the LRC included.
+    * \return Number of bytes decoded or -1 if size is odd, a character is not a hex digit or the LRC is wrong.
+    */
+    static int decodeFrame( const char *hex , const int size , char *data );
+
+    /*!
+    * Encodes an ADU: colon, hex encoded device address, PDU and LRC, CR LF.
+    * \param line Receives 2 * size + 7 characters.
+    * \param deviceAddress Address of the slave device.
+    * \param request The request PDU.
+    * \param size Size of the request PDU.
+    * \return Number of characters written.
+    */
+    static int encode( char *const line , const quint8 deviceAddress , const char *const request , const int size );
+
+    //! See above.
+    template< class Io >
+    quint8 transact( const Io &io , const quint8 deviceAddress , const char *const request , const int size ,
+                     const int expected , QModbusPduFrame &response ) const;
+
+    //! See above, the requests are sent one after the other in the order of the batch.
+    template< class Io >
+    void transact( const Io &io , const QList<QModbusRequest> &batch , QList<QModbusResponse> &responses ) const;
+
+private:
+    // Sends an encoded line and receives the response.
+    template< class Io >
+    quint8 _exchange( const Io &io , const char *const line , const int size , const quint8 deviceAddress ,
+                      const int expected , QModbusPduFrame &response ) const;
+};
+
+/*!
+* Framing of modbus TCP: MBAP header (transaction identifier, protocol identifier, length and unit identifier) and PDU.
+*
+* Transaction identifiers come from the transaction table of the connection. The pending input is not flushed before
+* a request; instead, replies are received frame by frame using the length of their header and replies to
+* transactions that are no longer in flight (late replies to transactions that timed out) are dropped.
+*
+* Batches are pipelined: as many requests as the transaction table has free slots are sent with a single write, and
+* the replies are matched to their requests by transaction identifier in whatever order they arrive.
+*/
+class QModbusTcpFraming
+{
+public:
+    //! Transactions in flight, the expected response length is stored with each.
+    typedef QModbusTransactionTable<int> Transactions;
+
+    /*!
+    * Constructor.
+    * \param transactions Transaction table of the connection.
+    */
+    explicit QModbusTcpFraming( Transactions &transactions );
+
+    /*!
+    * Encodes an ADU.
+    * \param adu Receives size + 7 bytes.
+    * \param transactionId Transaction identifier.
+    * \param deviceAddress Unit identifier.
+    * \param request The request PDU.
+    * \param size Size of the request PDU.
+    * \return Size of the ADU.
+    */
+    static int encode( char *const adu , const quint16 transactionId , const quint8 deviceAddress ,
+                       const char *const request , const int size );
+
+    //! See above.
+    template< class Io >
+    quint8 transact( const Io &io , const quint8 deviceAddress , const char *const request , const int size ,
+                     const int expected , QModbusPduFrame &response ) const;
+
+    //! See above, the requests are pipelined.
+    template< class Io >
+    void transact( const Io &io , const QList<QModbusRequest> &batch , QList<QModbusResponse> &responses ) const;
+
+private:
+    // Receives one frame (header and the rest as announced by the header).
+    template< class Io >
+    static quint8 _receive( const Io &io , QModbusTcpFrame &rx );
+
+    // Checks a received frame and extracts the response PDU.
+    static quint8 _check( const QModbusTcpFrame &rx , const quint8 deviceAddress , const int expected ,
+                          QModbusPduFrame &response );
+
+    Transactions *_transactions;    // Transaction table of the connection.
+};
+
+/*!
+* Framing of clients that execute whole requests themselves (QModbusSharedConnection, QModbusRedundantClient): the I/O
+* policy provides QModbusResponse execute( const QModbusRequest &request ) const instead of the byte stream methods,
+* the framing only checks the size of the response. There is no batch method, such clients implement their own.
+*/
+class QModbusRequestFraming
+{
+public:
+    //! See above.
+    template< class Io >
+    quint8 transact( const Io &io , const quint8 deviceAddress , const char *const request , const int size ,
+                     const int expected , QModbusPduFrame &response ) const;
+};
+
+
+/*** QModbusRtuFraming implementation *********************************************************************************/
+inline int QModbusRtuFraming::encode( char *const adu , const quint8 deviceAddress , const char *const request ,
+                                      const int size )
+{
+    adu[0] = (char)deviceAddress;
+    memcpy( adu + 1 , request , size );
+    const quint16 txCrc = crc( adu , size + 1 );
+    adu[size + 1] = (char)( txCrc & 0xFF );
+    adu[size + 2] = (char)( txCrc >> 8 );
+    return size + 3;
+}
+
+template< class Io >
+quint8 QModbusRtuFraming::transact( const Io &io , const quint8 deviceAddress , const char *const request ,
+                                    const int size , const int expected , QModbusPduFrame &response ) const
+{
+    QModbusRtuFrame adu;
+    adu.resize( encode( adu.data() , deviceAddress , request , size ) );
+    return _exchange( io , adu.constData() , adu.size() , deviceAddress , expected , response );
+}
+
+template< class Io >
+void QModbusRtuFraming::transact( const Io &io , const QList<QModbusRequest> &batch ,
+                                  QList<QModbusResponse> &responses ) const
+{
+    // Encode all ADUs into one buffer, so each request goes out right after the previous response.
+    QByteArray tx;
+    tx.resize( batch.count() * QModbusPdu::MaxRtuAduSize );
+    int txSize = 0;
+    foreach ( const QModbusRequest &request , batch )
+    {
+        if ( !request.isValid() ) continue;
+        txSize += encode( tx.data() + txSize , request.deviceAddress() , request.pdu().data() , request.pdu().size() );
+    }
+
+    // The bus has one transaction at a time, the order of the batch is kept.
+    const char *adu = tx.constData();
+    foreach ( const QModbusRequest &request , batch )
+    {
+        if ( !request.isValid() )
+        {
+            responses.append( QModbusResponse( QAbstractModbus::IllegalDataValue ) );
+            continue;
+        }
+        const QModbusFrameView pdu = request.pdu();
+        const quint8 limit = request.limitStatus();
+        if ( limit != QAbstractModbus::Ok )
+        {
+            // Cancelled or expired while queued: not sent at all.
+            responses.append( QModbusResponse( limit ) );
+            adu += pdu.size() + 3;
+            continue;
+        }
+
+        QModbusPduFrame response;
+        io.limit( request.deadline() , request.cancellationToken() );
+        quint8 result = _exchange( io , adu , pdu.size() + 3 , request.deviceAddress() ,
+                                   QModbusPdu::responseSize( pdu.data() , pdu.size() ) , response );
+        io.limit( QModbusDeadline() , QModbusCancellationToken::none() );
+        if ( result == QAbstractModbus::Timeout && request.limitStatus() != QAbstractModbus::Ok )
+        {
+            // The device may still answer: let a late reply pass before the bus is used again. It is read byte by
+            // byte, so no read waits for more than LateReplySilence, and the drain ends once the bus is silent that
+            // long. A device that does not answer at all (a scan of unused addresses) costs the silence instead of
+            // the timeout of the transport.
+            char sink;
+            do io.limit( QModbusDeadline( LateReplySilence ) , QModbusCancellationToken::none() );
+            while ( io.read( &sink , 1 ) > 0 );
+            io.limit( QModbusDeadline() , QModbusCancellationToken::none() );
+            result = request.limitStatus();
+        }
+        responses.append( QModbusResponse( result , response.view() ) );
+        adu += pdu.size() + 3;
+    }
+}
+
+template< class Io >
+quint8 QModbusRtuFraming::_exchange( const Io &io , const char *const adu , const int size ,
+                                     const quint8 deviceAddress , const int expected , QModbusPduFrame &response ) const
+{
+    // Clear the RX buffer before making the request and send the ADU.
+    io.discard();
+    io.write( adu , size );
+
+    // Even on error we have at least 5 bytes to read.
+    QModbusRtuFrame rx;
+    rx.resize( io.read( rx.data() , 5 ) );
+    if ( rx.size() < 5 ) return QAbstractModbus::Timeout;
+
+    // Once the reply arrives, it is received completely whatever the limits of the request.
+    io.limit( QModbusDeadline() , QModbusCancellationToken::none() );
+
+    // Was it a modbus exception? Otherwise receive the rest.
+    const bool exception = rx.at( 1 ) & 0x80;
+    if ( !exception )
+    {
+        const int free = rx.capacity() - 5;
+        const int rest = expected >= 0 ? qMin( expected + 3 - 5 , free ) : free;
+        rx.resize( 5 + ( expected >= 0 ? io.read( rx.data() + 5 , rest ) : io.readAll( rx.data() + 5 , rest ) ) );
+    }
+
+    // Check CRC.
+    const quint16 rxCrc = crc( rx.constData() , rx.size() - 2 );
+    if ( rx.at( rx.size() - 2 ) != ( rxCrc & 0xFF ) || rx.at( rx.size() - 1 ) != ( rxCrc >> 8 ) )
+    {
+        return QAbstractModbus::CrcError;
+    }
+    if ( exception ) return rx.at( 2 );
+
+    // Check size and device address.
+    if ( ( expected >= 0 && rx.size() != expected + 3 ) || rx.at( 0 ) != deviceAddress )
+    {
+        return QAbstractModbus::UnknownError;
+    }
+
+    response.clear();
+    response.append( rx.constData() + 1 , rx.size() - 3 );
+    return QAbstractModbus::Ok;
+}
+
+
+/*** QModbusAsciiFraming implementation *******************************************************************************/
+inline int QModbusAsciiFraming::encode( char *const line , const quint8 deviceAddress , const char *const request ,
+                                        const int size )
+{
+    // Device address and PDU, encoded to hex together with their LRC.
+    QModbusRtuFrame adu;
+    adu.append( (char)deviceAddress );
+    adu.append( request , size );
+    line[0] = ':';
+    const int count = 1 + encodeFrame( adu.constData() , adu.size() , line + 1 );
+    line[count] = 0x0D;
+    line[count + 1] = 0x0A;
+    return count + 2;
+}
+
+template< class Io >
+quint8 QModbusAsciiFraming::transact( const Io &io , const quint8 deviceAddress , const char *const request ,
+                                      const int size , const int expected , QModbusPduFrame &response ) const
+{
+    QModbusAsciiFrame line;
+    line.resize( encode( line.data() , deviceAddress , request , size ) );
+    return _exchange( io , line.constData() , line.size() , deviceAddress , expected , response );
+}
+
+template< class Io >
+void QModbusAsciiFraming::transact( const Io &io , const QList<QModbusRequest> &batch ,
+                                    QList<QModbusResponse> &responses ) const
+{
+    // Encode all lines into one buffer, so each request goes out right after the previous response.
+    QByteArray tx;
+    tx.resize( batch.count() * QModbusPdu::MaxAsciiAduSize );
+    QList<int> sizes;
+    int txSize = 0;
+    foreach ( const QModbusRequest &request , batch )
+    {
+        const int size = request.isValid() ? encode( tx.data() + txSize , request.deviceAddress() ,
+                                                      request.pdu().data() , request.pdu().size() ) : 0;
+        sizes.append( size );
+        txSize += size;
+    }
+
+    // The bus has one transaction at a time, the order of the batch is kept.
+    const char *line = tx.constData();
+    for ( int i = 0 ; i < batch.count() ; i++ )
+    {
+        const QModbusRequest &request = batch.at( i );
+        if ( !request.isValid() )
+        {
+            responses.append( QModbusResponse( QAbstractModbus::IllegalDataValue ) );
+            continue;
+        }
+        const QModbusFrameView pdu = request.pdu();
+        const quint8 limit = request.limitStatus();
+        if ( limit != QAbstractModbus::Ok )
+        {
+            // Cancelled or expired while queued: not sent at all.
+            responses.append( QModbusResponse( limit ) );
+            line += sizes.at( i );
+            continue;
+        }
+
+        QModbusPduFrame response;
+        io.limit( request.deadline() , request.cancellationToken() );
+        quint8 result = _exchange( io , line , sizes.at( i ) , request.deviceAddress() ,
+                                   QModbusPdu::responseSize( pdu.data() , pdu.size() ) , response );
+        io.limit( QModbusDeadline() , QModbusCancellationToken::none() );
+        if ( result == QAbstractModbus::Timeout && request.limitStatus() != QAbstractModbus::Ok )
+        {
+            result = request.limitStatus();
+        }
+        responses.append( QModbusResponse( result , response.view() ) );
+        line += sizes.at( i );
+    }
+}
+
+template< class Io >
+quint8 QModbusAsciiFraming::_exchange( const Io &io , const char *const line , const int size ,
+                                       const quint8 deviceAddress , const int expected ,
+                                       QModbusPduFrame &response ) const
+{
+    io.write( line , size );
+
+    // Try to read a line (":", at most 256 bytes hex encoded, CR LF), the I/O policy adds a terminating null.
+    QModbusFrame<QModbusPdu::MaxAsciiAduSize + 1> rxLine;
+    rxLine.resize( io.readLine( rxLine.data() , rxLine.capacity() ) );
+    if ( rxLine.size() < 9 ) return QAbstractModbus::Timeout;
+
+    // Decode and check the LRC in one pass.
+    const int hexSize = rxLine.size() - 3;
+    QModbusRtuFrame rx;
+    if ( hexSize > 2 * rx.capacity() || !rx.resize( decodeFrame( rxLine.constData() + 1 , hexSize , rx.data() ) ) ||
+         rx.size() < 3 )
+    {
+        return QAbstractModbus::CrcError;
+    }
+
+    // Was it a modbus exception?
+    if ( rx.at( 1 ) & 0x80 ) return rx.at( 2 );
+
+    // Check size and device address.
+    if ( ( expected >= 0 && rx.size() != expected + 2 ) || rx.at( 0 ) != deviceAddress )
+    {
+        return QAbstractModbus::UnknownError;
+    }
+
+    response.clear();
+    response.append( rx.constData() + 1 , rx.size() - 2 );
+    return QAbstractModbus::Ok;
+}
+
+
+/*** QModbusTcpFraming implementation *********************************************************************************/
+inline QModbusTcpFraming::QModbusTcpFraming( Transactions &transactions ) : _transactions( &transactions )
+{}
+
+inline int QModbusTcpFraming::encode( char *const adu , const quint16 transactionId , const quint8 deviceAddress ,
+                                      const char *const request , const int size )
+{
+    // MBAP header (Modbus uses Big Endian) and PDU.
+    QModbusPdu::put( adu , transactionId );
+    QModbusPdu::put( adu + 2 , 0x0000 );
+    QModbusPdu::put( adu + 4 , size + 1 );
+    adu[6] = (char)deviceAddress;
+    memcpy( adu + 7 , request , size );
+    return size + 7;
+}
+
+template< class Io >
+quint8 QModbusTcpFraming::transact( const Io &io , const quint8 deviceAddress , const char *const request ,
+                                    const int size , const int expected , QModbusPduFrame &response ) const
+{
+    // Allocate a transaction identifier and send the ADU.
+    const int transactionId = _transactions->allocate( expected );
+    if ( transactionId < 0 ) return QAbstractModbus::UnknownError;
+    QModbusTcpFrame adu;
+    adu.resize( encode( adu.data() , transactionId , deviceAddress , request , size ) );
+    io.write( adu.constData() , adu.size() );
+
+    // Receive frames until the reply to this transaction arrives. Any other reply is a late reply to a transaction
+    // that timed out and is no longer in flight: drop it.
+    QModbusTcpFrame rx;
+    quint8 result;
+    do result = _receive( io , rx );
+    while ( result == QAbstractModbus::Ok && QModbusPdu::get( rx.constData() ) != transactionId );
+    _transactions->release( transactionId );
+
+    // Without a complete frame, the stream position is unknown: drop what is pending.
+    if ( result != QAbstractModbus::Ok )
+    {
+        if ( rx.size() ) io.discard();
+        return result;
+    }
+
+    return _check( rx , deviceAddress , expected , response );
+}
+
+template< class Io >
+void QModbusTcpFraming::transact( const Io &io , const QList<QModbusRequest> &batch ,
+                                  QList<QModbusResponse> &responses ) const
+{
+    // Buffer for a full window of ADUs, batch index and identifier of each transaction of the window.
+    QByteArray tx;
+    tx.resize( Transactions::capacity() * QModbusPdu::MaxTcpAduSize );
+    QList<int> indexes;
+    QList<quint16> transactionIds;
+    for ( int i = 0 ; i < Transactions::capacity() ; i++ ) indexes.append( -1 );
+    const QModbusResponse invalid( QAbstractModbus::IllegalDataValue );
+    for ( int i = 0 ; i < batch.count() ; i++ ) responses.append( invalid );
+
+    int next = 0;
+    quint8 result = QAbstractModbus::Ok;
+    while ( next < batch.count() && result == QAbstractModbus::Ok )
+    {
+        // Encode as many requests as there are free transaction slots and send them with a single write. A request with
+        // a deadline or a cancellation token goes out in a window of its own, so giving up on it abandons no other.
+        int txSize = 0;
+        int limited = -1;
+        transactionIds.clear();
+        for ( ; next < batch.count() ; next++ )
+        {
+            const QModbusRequest &request = batch.at( next );
+            if ( !request.isValid() ) continue;
+            const quint8 limit = request.limitStatus();
+            if ( limit != QAbstractModbus::Ok )
+            {
+                responses[next] = QModbusResponse( limit );
+                continue;
+            }
+            if ( request.isLimited() && !transactionIds.isEmpty() ) break;
+
+            const QModbusFrameView pdu = request.pdu();
+            const int transactionId = _transactions->allocate( QModbusPdu::responseSize( pdu.data() , pdu.size() ) );
+            if ( transactionId < 0 ) break;
+            indexes[transactionId & ( Transactions::capacity() - 1 )] = next;
+            transactionIds.append( transactionId );
+            txSize += encode( tx.data() + txSize , transactionId , request.deviceAddress() , pdu.data() , pdu.size() );
+            if ( request.isLimited() )
+            {
+                limited = next++;
+                break;
+            }
+        }
+        if ( transactionIds.isEmpty() )
+        {
+            // No free slot at all.
+            if ( next < batch.count() ) responses[next++] = QModbusResponse( QAbstractModbus::UnknownError );
+            continue;
+        }
+        io.write( tx.constData() , txSize );
+        if ( limited >= 0 ) io.limit( batch.at( limited ).deadline() , batch.at( limited ).cancellationToken() );
+
+        // Receive the replies in any order, drop late replies to transactions no longer in flight.
+        QModbusTcpFrame rx;
+        int pending = transactionIds.count();
+        while ( pending && ( result = _receive( io , rx ) ) == QAbstractModbus::Ok )
+        {
+            const quint16 transactionId = QModbusPdu::get( rx.constData() );
+            const int *const expected = _transactions->find( transactionId );
+            if ( !expected ) continue;
+
+            const int index = indexes.at( transactionId & ( Transactions::capacity() - 1 ) );
+            QModbusPduFrame response;
+            const quint8 status = _check( rx , batch.at( index ).deviceAddress() , *expected , response );
+            responses[index] = QModbusResponse( status , response.view() );
+            _transactions->release( transactionId );
+            pending--;
+        }
+
+        // Give up on a cancelled or expired request between frames: its slot is freed, so its late reply is dropped.
+        if ( limited >= 0 )
+        {
+            io.limit( QModbusDeadline() , QModbusCancellationToken::none() );
+            const quint8 limit = batch.at( limited ).limitStatus();
+            if ( result == QAbstractModbus::Timeout && !rx.size() && limit != QAbstractModbus::Ok )
+            {
+                _transactions->release( transactionIds.first() );
+                responses[limited] = QModbusResponse( limit );
+                result = QAbstractModbus::Ok;
+            }
+        }
+
+        // Fail the transactions of the window still pending. Without a complete frame, the stream position is
+        // unknown: drop what is pending.
+        if ( result != QAbstractModbus::Ok )
+        {
+            if ( rx.size() ) io.discard();
+            foreach ( quint16 transactionId , transactionIds )
+            {
+                if ( !_transactions->release( transactionId ) ) continue;
+                responses[indexes.at( transactionId & ( Transactions::capacity() - 1 ) )] = QModbusResponse( result );
+            }
+        }
+
+        // A timeout between frames leaves the stream aligned: only the window failed, the rest is still sent.
+        if ( result == QAbstractModbus::Timeout && !rx.size() && io.isOpen() ) result = QAbstractModbus::Ok;
+    }
+
+    // The connection failed or the stream is out of sync, do not send the rest.
+    for ( ; next < batch.count() ; next++ )
+    {
+        if ( batch.at( next ).isValid() ) responses[next] = QModbusResponse( result );
+    }
+}
+
+template< class Io >
+quint8 QModbusTcpFraming::_receive( const Io &io , QModbusTcpFrame &rx )
+{
+    rx.resize( io.read( rx.data() , 7 ) );
+    if ( rx.size() < 7 ) return QAbstractModbus::Timeout;
+
+    const int length = QModbusPdu::get( rx.constData() + 4 );
+    if ( QModbusPdu::get( rx.constData() + 2 ) != 0 || length < 3 || length > 254 )
+    {
+        return QAbstractModbus::UnknownError;
+    }
+
+    rx.resize( 7 + io.read( rx.data() + 7 , length - 1 ) );
+    return rx.size() < length + 6 ? QAbstractModbus::Timeout : QAbstractModbus::Ok;
+}
+
+inline quint8 QModbusTcpFraming::_check( const QModbusTcpFrame &rx , const quint8 deviceAddress , const int expected ,
+                                         QModbusPduFrame &response )
+{
+    // Check the header.
+    if ( rx.at( 6 ) != deviceAddress ) return QAbstractModbus::UnknownError;
+
+    // Was it a modbus exception?
+    if ( rx.at( 7 ) & 0x80 ) return rx.at( 8 );
+
+    // Check size.
+    if ( expected >= 0 && rx.size() != expected + 7 ) return QAbstractModbus::UnknownError;
+
+    response.clear();
+    response.append( rx.constData() + 7 , rx.size() - 7 );
+    return QAbstractModbus::Ok;
+}
+
+
+/*** QModbusRequestFraming implementation *****************************************************************************/
+template< class Io >
+quint8 QModbusRequestFraming::transact( const Io &io , const quint8 deviceAddress , const char *const request ,
+                                        const int size , const int expected , QModbusPduFrame &response ) const
+{
+    const QModbusResponse result = io.execute( QModbusRequest( deviceAddress , QModbusFrameView( request , size ) ) );
+    if ( !result.isOk() ) return result.status();
+
+    response.clear();
+    response.append( result.pdu().data() , result.pdu().size() );
+    if ( expected >= 0 && response.size() != expected ) return QAbstractModbus::UnknownError;
+    return QAbstractModbus::Ok;
+}
@@ -0,0 +1,142 @@
+/***********************************************************************************************************************
+* QModbusHostScanner : Finds the hosts accepting modbus TCP connections, connecting to many hosts in parallel.         *
+************************************************************************************************************************
+* Author : QModbus contributors                                                                                        *
+* Date   : 2026/10/18                                                                                                  *
+* Changes: -                                                                                                           *
+***********************************************************************************************************************/
+#pragma once
+
+
+/*** Base classes *****************************************************************************************************/
+#include <QtCore/QObject>
+
+
+/*** Qt includes & prototypes *****************************************************************************************/
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QHash>
+#include <QtCore/QMultiMap>
+#include <QtCore/QStringList>
+#include <QtCore/QTimer>
+#include <QtNetwork/QAbstractSocket>
+class QTcpSocket;
+
+
+/*** QModbusHostScanner class declaration and help ********************************************************************/
+/*!
+* The host scanner looks for modbus TCP servers: it connects to the port of every host of a list or a subnet and
+* reports each host accepting the connection as soon as it does (hostFound()). The connects are non-blocking and up to
+* maximumConnects() of them are in flight at once, so scanning a /24 subnet takes about four connect timeouts instead
+* of 254. A host refusing the connection is done at once, one not answering at all after connectTimeout().
+*
+* The scanner only checks that the port is open, nothing is sent. To find the units behind a host found, connect a
+* QTcpModbus to it and scan it using QModbusUnitScanner.
+*
+* The scanner works asynchronously and needs a running event loop in its thread. The signals are emitted from it.
+* \headerfile qmodbushostscanner.h QModbusHostScanner
+*/
+class QModbusHostScanner : public QObject
+{
+    Q_OBJECT
+
+public:
+    /*!
+    * Constructor.
+    * \param parent The parent object.
+    */
+    explicit QModbusHostScanner( QObject *parent = NULL );
+
+    /*!
+    * Destructor, aborts a running scan.
+    */
+    ~QModbusHostScanner();
+
+    //! Returns the most connects in flight at once. Default is 64.
+    int maximumConnects( void ) const;
+
+    //! Changes the most connects in flight at once [1..1024].
+    void setMaximumConnects( const int connects );
+
+    //! Returns the time in milliseconds a host has to accept the connection. Default is 1000.
+    int connectTimeout( void ) const;
+
+    //! Changes the time a host has to accept the connection, applies to the connects started later.
+    void setConnectTimeout( const int msecs );
+
+    /*!
+    * Starts scanning a list of hosts.
+    * \param hosts Host names or addresses.
+    * \param port The port to connect to.
+    * \return True if the scan was started, false if a scan is running.
+    */
+    bool scan( const QStringList &hosts , const quint16 port = 502 );
+
+    /*!
+    * Starts scanning the hosts of an IPv4 subnet. For prefixes up to 30 bits, the network and broadcast addresses are
+    * left out.
+    * \param address An address of the subnet, for example "192.168.1.0".
+    * \param prefixLength The subnet prefix length [16..32].
+    * \param port The port to connect to.
+    * \return True if the scan was started, false if a scan is running or the subnet is invalid.
+    */
+    bool scanSubnet( const QString &address , const int prefixLength , const quint16 port = 502 );
+
+    /*!
+    * Stops the running scan, the connects in flight are aborted. finished() is emitted.
+    */
+    void cancel( void );
+
+    //! Returns true while a scan is running.
+    bool isScanning( void ) const;
+
+signals:
+    /*!
+    * This signal is emitted for each host that accepted the connection.
+    * \param host The host as given (name or address).
+    * \param port The port.
+    * \param connectTime Milliseconds the connect took.
+    */
+    void hostFound( const QString &host , int port , int connectTime );
+
+    /*!
+    * This signal is emitted once a scan is done or cancelled.
+    * \param found Number of hosts found.
+    */
+    void finished( int found );
+
+private slots:
+    void _socketConnected( void );
+    void _socketError( QAbstractSocket::SocketError error );
+    void _timerExpired( void );
+
+private:
+    Q_DISABLE_COPY( QModbusHostScanner )
+
+    struct Attempt
+    {
+        QString host;               // Host as given.
+        qint64 started;             // Time the connect was started (scanner clock).
+        qint64 due;                 // Time the connect times out.
+    };
+
+    // Starts connects until the limit is reached or no host is left, emits finished() if the scan is done.
+    void _launch( void );
+
+    // Aborts a connect in flight and forgets it.
+    void _finish( QTcpSocket *const socket );
+
+    // Restarts the timer for the earliest connect timeout.
+    void _reschedule( void );
+
+    QStringList _hosts;             // Hosts of the running scan.
+    int _next;                      // Index of the next host to connect to.
+    quint16 _port;                  // Port of the running scan.
+    int _found;                     // Hosts found by the running scan.
+    bool _scanning;                 // True while a scan is running.
+    QHash<QTcpSocket *,Attempt> _attempts;          // Connects in flight.
+    QMultiMap<qint64,QTcpSocket *> _due;            // Connects in flight by timeout.
+    QTimer _timer;                  // Fires at the earliest connect timeout.
+    QElapsedTimer _clock;           // Scanner clock.
+    int _maximumConnects;           // Most connects in flight.
+    int _connectTimeout;            // Connect timeout in milliseconds.
+};
@@ -0,0 +1,88 @@
+/***********************************************************************************************************************
+* QModbusListener : Receives the data polled on behalf of an application module.                                      *
+************************************************************************************************************************
+* Author : QModbus contributors                                                                                        *
+* Date   : 2026/10/18                                                                                                  *
+* Changes: -                                                                                                           *
+***********************************************************************************************************************/
+#pragma once
+
+
+/*** Qt includes & prototypes *****************************************************************************************/
+#include <QAbstractModbus>
+#include <QtCore/QList>
+
+
+/*** QModbusListener class declaration and help ***********************************************************************/
+/*!
+* Callback interface used by the classes that poll modbus devices on behalf of the application (for example the
+* QModbusSubscriptionEngine). Register tables are delivered using registersReceived(), coils and discrete inputs using
+* bitsReceived(). Both methods do nothing by default, so a listener only has to implement the one it needs.
+*
+* If change-only delivery is enabled for a subscription or a poll job, successful polls are delivered using
+* registersChanged() or bitsChanged() instead and only if something changed; by default these forward to the methods
+* above.
+* \headerfile qmodbuslistener.h QModbusListener
+*/
+class QModbusListener
+{
+public:
+    /*!
+    * Destructor.
+    */
+    virtual ~QModbusListener() {}
+
+    /*!
+    * Called each time a register range (holding or input registers) the listener is interested in was polled.
+    * \param id Identifier of the subscription or job the data belongs to.
+    * \param startingAddress Address of the first register in values.
+    * \param values The register values, empty if the poll failed.
+    * \param status Transaction status (see QAbstractModbus::Status).
+    */
+    virtual void registersReceived( const int id , const quint16 startingAddress , const QList<quint16> &values ,
+                                    const quint8 status )
+    {
+        Q_UNUSED( id ); Q_UNUSED( startingAddress ); Q_UNUSED( values ); Q_UNUSED( status );
+    }
+
+    /*!
+    * Called each time a bit range (coils or discrete inputs) the listener is interested in was polled.
+    * \param id Identifier of the subscription or job the data belongs to.
+    * \param startingAddress Address of the first bit in values.
+    * \param values The bit values, empty if the poll failed.
+    * \param status Transaction status (see QAbstractModbus::Status).
+    */
+    virtual void bitsReceived( const int id , const quint16 startingAddress , const QList<bool> &values ,
+                               const quint8 status )
+    {
+        Q_UNUSED( id ); Q_UNUSED( startingAddress ); Q_UNUSED( values ); Q_UNUSED( status );
+    }
+
+    /*!
+    * Called instead of registersReceived() for change-only subscriptions and jobs if at least one value changed.
+    * \param id Identifier of the subscription or job the data belongs to.
+    * \param startingAddress Address of the first register in values.
+    * \param values All register values of the range.
+    * \param changed Indices (relative to startingAddress) of the values that changed (see QModbusChangeFilter).
+    */
+    virtual void registersChanged( const int id , const quint16 startingAddress , const QList<quint16> &values ,
+                                   const QList<int> &changed )
+    {
+        Q_UNUSED( changed );
+        registersReceived( id , startingAddress , values , QAbstractModbus::Ok );
+    }
+
+    /*!
+    * Called instead of bitsReceived() for change-only subscriptions and jobs if at least one bit changed.
+    * \param id Identifier of the subscription or job the data belongs to.
+    * \param startingAddress Address of the first bit in values.
+    * \param values All bit values of the range.
+    * \param changed Indices (relative to startingAddress) of the bits that changed.
+    */
+    virtual void bitsChanged( const int id , const quint16 startingAddress , const QList<bool> &values ,
+                              const QList<int> &changed )
+    {
+        Q_UNUSED( changed );
+        bitsReceived( id , startingAddress , values , QAbstractModbus::Ok );
+    }
+};
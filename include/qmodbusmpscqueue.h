@@ -0,0 +1,145 @@
+/***********************************************************************************************************************
+* QModbusMpscQueue : Lock-free intrusive multi-producer single-consumer queue.                                        *
+************************************************************************************************************************
+* Author : QModbus contributors                                                                                        *
+* Date   : 2026/10/18                                                                                                  *
+* Changes: -                                                                                                           *
+***********************************************************************************************************************/
+#pragma once
+
+
+/*** Qt includes & prototypes *****************************************************************************************/
+#include <QtCore/QAtomicPointer>
+#include <QtCore/QtGlobal>
+
+
+/*** QModbusMpscNode class declaration and help ***********************************************************************/
+/*!
+* Base class of the elements of a QModbusMpscQueue, holds the link to the next element.
+* \headerfile qmodbusmpscqueue.h QModbusMpscQueue
+*/
+class QModbusMpscNode
+{
+protected:
+    QModbusMpscNode( void ) : _next( NULL ) {}
+
+private:
+    template< class Node > friend class QModbusMpscQueue;
+
+    QAtomicPointer<QModbusMpscNode> _next;  // Next element in the queue.
+};
+
+
+/*** QModbusMpscQueue class declaration and help **********************************************************************/
+/*!
+* An unbounded intrusive queue (Vyukov's algorithm): any number of threads can push concurrently, a single thread pops.
+* push() is wait-free (one atomic exchange and one store), pop() is lock-free and never blocks the producers. The queue
+* does not own or allocate its elements, which derive from QModbusMpscNode and can be in at most one queue at a time.
+*
+* pop() can return NULL while a push is in progress, even if the queue is not empty. A consumer that knows an element
+* is there (for example because it counts them with a semaphore) retries.
+* \headerfile qmodbusmpscqueue.h QModbusMpscQueue
+*/
+template< class Node >
+class QModbusMpscQueue
+{
+public:
+    //! Constructs an empty queue.
+    QModbusMpscQueue( void );
+
+    /*!
+    * Appends an element, can be called from any thread.
+    * \param node The element.
+    */
+    void push( Node *const node );
+
+    /*!
+    * Removes the first element, must only be called by the consumer thread.
+    * \return The element or NULL if the queue is empty (or the push of the first element is not complete yet).
+    */
+    Node *pop( void );
+
+private:
+    Q_DISABLE_COPY( QModbusMpscQueue )
+
+    // Appends a link.
+    void _push( QModbusMpscNode *const node );
+
+    // Atomic load with acquire semantics.
+    static QModbusMpscNode *_load( QAtomicPointer<QModbusMpscNode> &pointer );
+
+    QAtomicPointer<QModbusMpscNode> _head;  // Last element, producers append here.
+    QModbusMpscNode *_tail;                 // First element, the consumer removes here.
+    QModbusMpscNode _stub;                  // Placeholder that keeps the queue non empty.
+};
+
+
+/*** QModbusMpscQueue implementation **********************************************************************************/
+template< class Node >
+QModbusMpscQueue<Node>::QModbusMpscQueue( void ) : _head( &_stub ) , _tail( &_stub )
+{}
+
+template< class Node >
+void QModbusMpscQueue<Node>::push( Node *const node )
+{
+    _push( node );
+}
+
+template< class Node >
+Node *QModbusMpscQueue<Node>::pop( void )
+{
+    QModbusMpscNode *tail = _tail;
+    QModbusMpscNode *next = _load( tail->_next );
+
+    // Skip the placeholder.
+    if ( tail == &_stub )
+    {
+        if ( !next ) return NULL;
+        _tail = tail = next;
+        next = _load( next->_next );
+    }
+
+    // More than one element, the first can be removed.
+    if ( next )
+    {
+        _tail = next;
+        return static_cast<Node *>( tail );
+    }
+
+    // A producer is appending right now.
+    if ( tail != _load( _head ) ) return NULL;
+
+    // The last element: put the placeholder behind it so it can be removed.
+    _push( &_stub );
+    next = _load( tail->_next );
+    if ( next )
+    {
+        _tail = next;
+        return static_cast<Node *>( tail );
+    }
+    return NULL;
+}
+
+template< class Node >
+void QModbusMpscQueue<Node>::_push( QModbusMpscNode *const node )
+{
+    node->_next.fetchAndStoreRelaxed( NULL );
+    QModbusMpscNode *const previous = _head.fetchAndStoreOrdered( node );
+    previous->_next.fetchAndStoreRelease( node );
+}
+
+template< class Node >
+QModbusMpscNode *QModbusMpscQueue<Node>::_load( QAtomicPointer<QModbusMpscNode> &pointer )
+{
+
+# /***/ if QT_VERSION >= 0x050000 /***********************************************************************************/
+
+    return pointer.loadAcquire();
+
+# /***/ else /*********************************************************************************************************/
+
+    return pointer.fetchAndAddAcquire( 0 );
+
+# /***/ endif /* QT_VERSION *******************************************************************************************/
+
+}
@@ -0,0 +1,243 @@
+/***********************************************************************************************************************
+* QModbusPdu : Compile-time layouts of the modbus request PDUs, encoded directly into caller provided buffers.         *
+************************************************************************************************************************
+* Author : QModbus contributors                                                                                        *
+* Date   : 2026/10/18                                                                                                  *
+* Changes: -                                                                                                           *
+***********************************************************************************************************************/
+#pragma once
+
+
+/*** Qt includes & prototypes *****************************************************************************************/
+#include <QtCore/QtGlobal>
+
+
+/*** QModbusPdu class declaration and help ****************************************************************************/
+/*!
+* Size limits of modbus frames and big endian field access. All sizes are in bytes.
+* \headerfile qmodbuspdu.h QModbusPdu
+*/
+class QModbusPdu
+{
+public:
+    enum Size
+    {
+        MaxSize         = 253,  //!< Largest PDU (function code and data).
+        MaxRtuAduSize   = 256,  //!< Largest RTU ADU (device address, PDU and CRC).
+        MaxAsciiAduSize = 513,  //!< Largest ASCII ADU (colon, hex encoded address, PDU and LRC, CR LF).
+        MaxTcpAduSize   = 260   //!< Largest TCP ADU (MBAP header and PDU).
+    };
+
+    /*!
+    * Writes a 16 bit value in big endian byte order.
+    * \param buffer Where to write the two bytes.
+    * \param value The value.
+    */
+    static void put( char *const buffer , const quint16 value );
+
+    /*!
+    * Reads a 16 bit value in big endian byte order.
+    * \param buffer Where to read the two bytes from.
+    * \return The value.
+    */
+    static quint16 get( const char *const buffer );
+
+    /*!
+    * Returns the size of the successful response to a request of a standard function.
+    * \param request The request PDU.
+    * \param size Size of the request PDU.
+    * \return Size of the response PDU or -1 if it is not known in advance (FIFO queue and other functions).
+    */
+    static int responseSize( const char *const request , const int size );
+};
+
+
+/*** QModbusPduLayout class declaration and help **********************************************************************/
+/*!
+* Describes a request PDU made of the function code, a fixed number of 16 bit fields and optionally a byte count
+* followed by at most MaxData bytes of data. All offsets and sizes are compile-time constants, so encode() reduces to
+* a handful of byte stores into the buffer, typically an array on the stack of QModbusPdu::MaxSize bytes:
+*
+* char pdu[QModbusPdu::MaxSize];
+* const int size = QModbusReadRegistersPdu::encode( pdu , 0x03 , startingAddress , quantity );
+*
+* For layouts with data, the caller fills the data at data( pdu ) and setDataSize() writes the byte count and returns
+* the size of the complete PDU. The number of fields given to encode() has to match the layout, otherwise compilation
+* fails.
+* \headerfile qmodbuspdu.h QModbusPdu
+*/
+template< int Fields , int MaxData = 0 >
+class QModbusPduLayout
+{
+public:
+    enum
+    {
+        FieldCount      = Fields,                                   //!< Number of 16 bit fields.
+        HasByteCount    = MaxData > 0 ? 1 : 0,                      //!< 1 if a byte count and data follow the fields.
+        ByteCountOffset = 1 + 2 * Fields,                           //!< Offset of the byte count (if any).
+        DataOffset      = 1 + 2 * Fields + HasByteCount,            //!< Offset of the data (if any).
+        FixedSize       = DataOffset,                               //!< Size without data.
+        MaxDataSize     = MaxData,                                  //!< Largest data size allowed.
+        MaxPduSize      = DataOffset + MaxData                      //!< Largest PDU size.
+    };
+
+    /*!
+    * Returns the offset of a field.
+    * \param index Index of the field [0..FieldCount-1].
+    * \return Offset of the field in the PDU.
+    */
+    static int fieldOffset( const int index ) { return 1 + 2 * index; }
+
+    /*!
+    * Returns where the data of the PDU starts.
+    * \param pdu The PDU buffer.
+    * \return Pointer to the data.
+    */
+    static char *data( char *const pdu ) { return pdu + DataOffset; }
+
+    /*!
+    * Encodes the function code and the fields.
+    * \param pdu Buffer of at least MaxPduSize bytes.
+    * \param functionCode The function code.
+    * \param f0 .. f3 The fields in the order they appear in the PDU.
+    * \return Size of the PDU without data.
+    */
+    static int encode( char *const pdu , const quint8 functionCode , const quint16 f0 );
+    //! See above.
+    static int encode( char *const pdu , const quint8 functionCode , const quint16 f0 , const quint16 f1 );
+    //! See above.
+    static int encode( char *const pdu , const quint8 functionCode , const quint16 f0 , const quint16 f1 ,
+                       const quint16 f2 );
+    //! See above.
+    static int encode( char *const pdu , const quint8 functionCode , const quint16 f0 , const quint16 f1 ,
+                       const quint16 f2 , const quint16 f3 );
+
+    /*!
+    * Writes the byte count of a layout with data.
+    * \param pdu The PDU buffer.
+    * \param dataSize Number of data bytes [0..MaxDataSize].
+    * \return Size of the PDU including the data.
+    */
+    static int setDataSize( char *const pdu , const int dataSize );
+
+private:
+    // Checks at compile time that a condition holds (array of negative size otherwise).
+    template< bool Condition >
+    static void _check( void );
+};
+
+
+/*** Request layouts **************************************************************************************************/
+typedef QModbusPduLayout<2>     QModbusReadBitsPdu;         //!< 0x01, 0x02: starting address, quantity.
+typedef QModbusPduLayout<2>     QModbusReadRegistersPdu;    //!< 0x03, 0x04: starting address, quantity.
+typedef QModbusPduLayout<2>     QModbusWriteSinglePdu;      //!< 0x05, 0x06: address, value.
+typedef QModbusPduLayout<2,246> QModbusWriteMultiplePdu;    //!< 0x0F, 0x10: starting address, quantity, data.
+typedef QModbusPduLayout<3>     QModbusMaskWritePdu;        //!< 0x16: address, AND mask, OR mask.
+typedef QModbusPduLayout<4,242> QModbusReadWritePdu;        //!< 0x17: read start, quantity, write start, quantity.
+typedef QModbusPduLayout<1>     QModbusReadFifoPdu;         //!< 0x18: FIFO pointer address.
+
+
+/*** QModbusPdu implementation ****************************************************************************************/
+inline void QModbusPdu::put( char *const buffer , const quint16 value )
+{
+    buffer[0] = (char)( value >> 8 );
+    buffer[1] = (char)( value & 0xFF );
+}
+
+inline quint16 QModbusPdu::get( const char *const buffer )
+{
+    return ( (quint8)buffer[0] << 8 ) | (quint8)buffer[1];
+}
+
+
+inline int QModbusPdu::responseSize( const char *const request , const int size )
+{
+    if ( size < 1 ) return -1;
+    switch( (quint8)request[0] )
+    {
+        case 0x01:
+        case 0x02:
+            return size >= 5 ? 2 + ( get( request + 3 ) + 7 ) / 8 : -1;
+
+        case 0x03:
+        case 0x04:
+            return size >= 5 ? 2 + 2 * get( request + 3 ) : -1;
+
+        case 0x05:
+        case 0x06:
+        case 0x0F:
+        case 0x10:
+            return 5;
+
+        case 0x16:
+            return 7;
+
+        case 0x17:
+            return size >= 5 ? 2 + 2 * get( request + 3 ) : -1;
+
+        default:
+            return -1;
+    }
+}
+
+/*** QModbusPduLayout implementation **********************************************************************************/
+template< int Fields , int MaxData >
+inline int QModbusPduLayout<Fields,MaxData>::encode( char *const pdu , const quint8 functionCode , const quint16 f0 )
+{
+    _check<Fields == 1>();
+    pdu[0] = (char)functionCode;
+    QModbusPdu::put( pdu + 1 , f0 );
+    return FixedSize;
+}
+
+template< int Fields , int MaxData >
+inline int QModbusPduLayout<Fields,MaxData>::encode( char *const pdu , const quint8 functionCode , const quint16 f0 ,
+                                                     const quint16 f1 )
+{
+    _check<Fields == 2>();
+    pdu[0] = (char)functionCode;
+    QModbusPdu::put( pdu + 1 , f0 );
+    QModbusPdu::put( pdu + 3 , f1 );
+    return FixedSize;
+}
+
+template< int Fields , int MaxData >
+inline int QModbusPduLayout<Fields,MaxData>::encode( char *const pdu , const quint8 functionCode , const quint16 f0 ,
+                                                     const quint16 f1 , const quint16 f2 )
+{
+    _check<Fields == 3>();
+    pdu[0] = (char)functionCode;
+    QModbusPdu::put( pdu + 1 , f0 );
+    QModbusPdu::put( pdu + 3 , f1 );
+    QModbusPdu::put( pdu + 5 , f2 );
+    return FixedSize;
+}
+
+template< int Fields , int MaxData >
+inline int QModbusPduLayout<Fields,MaxData>::encode( char *const pdu , const quint8 functionCode , const quint16 f0 ,
+                                                     const quint16 f1 , const quint16 f2 , const quint16 f3 )
+{
+    _check<Fields == 4>();
+    pdu[0] = (char)functionCode;
+    QModbusPdu::put( pdu + 1 , f0 );
+    QModbusPdu::put( pdu + 3 , f1 );
+    QModbusPdu::put( pdu + 5 , f2 );
+    QModbusPdu::put( pdu + 7 , f3 );
+    return FixedSize;
+}
+
+template< int Fields , int MaxData >
+inline int QModbusPduLayout<Fields,MaxData>::setDataSize( char *const pdu , const int dataSize )
+{
+    _check<HasByteCount == 1>();
+    pdu[ByteCountOffset] = (char)dataSize;
+    return FixedSize + dataSize;
+}
+
+template< int Fields , int MaxData >
+template< bool Condition >
+inline void QModbusPduLayout<Fields,MaxData>::_check( void )
+{
+    typedef char ConditionHolds[Condition ? 1 : -1];
+    Q_UNUSED( sizeof( ConditionHolds ) );
+}
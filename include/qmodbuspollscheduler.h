@@ -0,0 +1,243 @@
+/***********************************************************************************************************************
+* QModbusPollScheduler : Earliest deadline first scheduler for periodic read jobs with period and jitter statistics.  *
+************************************************************************************************************************
+* Author : QModbus contributors                                                                                        *
+* Date   : 2026/10/18                                                                                                  *
+* Changes: -                                                                                                           *
+***********************************************************************************************************************/
+#pragma once
+
+
+/*** Base classes *****************************************************************************************************/
+#include <QtCore/QObject>
+
+
+/*** Qt includes & prototypes *****************************************************************************************/
+#include <QAbstractModbus>
+#include <QModbusListener>
+#include <QModbusCapabilityCache>
+#include <QModbusChangeFilter>
+#include <QtCore/QHash>
+#include <QtCore/QVector>
+#include <QtCore/QTimer>
+#include <QtCore/QElapsedTimer>
+
+
+/*** QModbusPollScheduler class declaration and help ******************************************************************/
+/*!
+* The poll scheduler holds periodic read jobs (a scan list) over one or more modbus connections and executes them in
+* earliest deadline first order. The deadlines are kept in a binary heap, so the scheduler scales to thousands of jobs.
+*
+* Each job has exactly one pending deadline at any time, so the scheduler never builds up a backlog: a job that could
+* not be executed in time is executed once, the cycles it missed are counted as overruns and skipped, and the next
+* deadline stays in phase with the original period. With the DropLate policy, a cycle that is later than the
+* tolerance is dropped instead of being executed late. Late jobs of the same connection, device and table with
+* overlapping or adjacent ranges are merged into a single request to help the transport catching up.
+*
+* For every job the scheduler records the actual period (time between two consecutive executions), its standard
+* deviation (jitter), the maximal deviation from the nominal period, the lateness as well as overrun, drop and merge
+* counters.
+*
+* A job can be switched to change-only delivery using setChangeFilter(): each new sample is compared against the last
+* reported one and the listener is only notified if values changed (or moved out of the deadband), together with the
+* indices of the changed values. Failed polls are always reported.
+*
+* Merged requests stay within the modbus limits, or within the largest quantity learned for the device if a capability
+* cache was set for the connection (see setCapabilities() and QModbusCapabilityProber).
+*
+* The scheduler is driven by a single shot timer and so needs a running event loop. The modbus accesses are blocking
+* and are done in the thread the scheduler lives in.
+* \headerfile qmodbuspollscheduler.h QModbusPollScheduler
+*/
+class QModbusPollScheduler : public QObject
+{
+    Q_OBJECT
+
+public:
+    /*!
+    * Defines what happens to a cycle that starts after its deadline.
+    */
+    enum OverloadPolicy
+    {
+        ExecuteLate ,               //!< Execute the cycle late, skip the cycles missed meanwhile.
+        DropLate                    //!< Drop the cycle if it is later than the tolerance, execute it otherwise.
+    };
+
+    /*!
+    * Statistics of a job. Times are in milliseconds.
+    */
+    struct Statistics
+    {
+        int period;                 //!< Nominal period.
+        quint64 samples;            //!< Number of executions.
+        qint64 lastPeriod;          //!< Last actual period, -1 before the second execution.
+        double averagePeriod;       //!< Mean actual period.
+        double jitter;              //!< Standard deviation of the actual period.
+        qint64 maximumJitter;       //!< Largest deviation of an actual period from the nominal period.
+        double averageLateness;     //!< Mean delay between deadline and execution.
+        quint64 overruns;           //!< Number of deadlines that passed without the job being executed.
+        quint64 dropped;            //!< Number of late cycles dropped (DropLate policy).
+        quint64 merged;             //!< Number of executions that shared the request with other jobs.
+    };
+
+    /*!
+    * Constructor.
+    * \param parent The parent object.
+    */
+    explicit QModbusPollScheduler( QObject *parent = NULL );
+
+    /*!
+    * Destructor.
+    */
+    virtual ~QModbusPollScheduler();
+
+    /*!
+    * Adds a periodic read job. The job is due immediately.
+    * \param modbus The connection to use. It has to stay valid as long as the job exists.
+    * \param deviceAddress Address of the slave device [1..247].
+    * \param table The table to read.
+    * \param startingAddress Address of the first coil, input or register [0..65535].
+    * \param quantity Number of coils, inputs or registers [1..2000] for bits, [1..125] for registers, at most the
+    *                 maximum learned for the device (see setCapabilities()).
+    * \param period Period in milliseconds.
+    * \param listener Listener to notify after each execution. Not owned by the scheduler.
+    * \return The job identifier (always positive) or -1 if the parameters are invalid.
+    */
+    int addJob( const QAbstractModbus &modbus , const quint8 deviceAddress , const QAbstractModbus::Table table ,
+                const quint16 startingAddress , const quint16 quantity , const int period ,
+                QModbusListener *const listener );
+
+    /*!
+    * Enables change-only delivery for a job. The next successful execution reports all values as changed.
+    * \param id The identifier returned by addJob().
+    * \param filter The filter defining the value type and deadband to use.
+    * \return True on success, false if there is no such job.
+    */
+    bool setChangeFilter( const int id , const QModbusChangeFilter &filter );
+
+    /*!
+    * Switches a job back to delivering every sample.
+    * \param id The identifier returned by addJob().
+    */
+    void clearChangeFilter( const int id );
+
+    /*!
+    * Sets the capability cache the request sizes of a connection are taken from.
+    * \param modbus The connection.
+    * \param cache The capability cache of the connection, NULL to use the modbus limits. Not owned by the scheduler.
+    */
+    void setCapabilities( const QAbstractModbus &modbus , QModbusCapabilityCache *const cache );
+
+    /*!
+    * Removes a job.
+    * \param id The identifier returned by addJob().
+    */
+    void removeJob( const int id );
+
+    /*!
+    * Returns the number of jobs.
+    * \return Number of jobs.
+    */
+    int jobCount( void ) const;
+
+    /*!
+    * Returns the statistics of a job.
+    * \param id The identifier returned by addJob().
+    * \return The statistics, all zero if there is no such job.
+    */
+    Statistics statistics( const int id ) const;
+
+    /*!
+    * Returns the overload policy. Default is ExecuteLate.
+    * \return Overload policy.
+    */
+    OverloadPolicy overloadPolicy( void ) const;
+
+    /*!
+    * Changes the overload policy.
+    * \param policy The new policy.
+    * \param tolerance Lateness in milliseconds up to which a cycle is still executed with the DropLate policy.
+    */
+    void setOverloadPolicy( const OverloadPolicy policy , const int tolerance = 0 );
+
+    /*!
+    * Starts executing jobs.
+    */
+    void start( void );
+
+    /*!
+    * Stops executing jobs.
+    */
+    void stop( void );
+
+    /*!
+    * Returns true if the scheduler is running.
+    * \return True if started.
+    */
+    bool isActive( void ) const;
+
+    /*!
+    * Executes all jobs whose deadline has passed, earliest deadline first. This is called by the scheduler's timer,
+    * but can be called manually if the scheduler was not started.
+    * \return Number of modbus requests issued.
+    */
+    int processDue( void );
+
+private slots:
+    void _timerExpired( void );
+
+private:
+    struct Job
+    {
+        const QAbstractModbus *modbus;
+        quint8 deviceAddress;
+        QAbstractModbus::Table table;
+        quint16 startingAddress;
+        quint16 quantity;
+        QModbusListener *listener;
+        qint64 deadline;            // Pending deadline (scheduler clock).
+        qint64 lastStart;           // Time of the last execution, -1 if never executed.
+        quint64 periods;            // Number of measured periods.
+        double periodM2;            // Sum of squared period deviations (Welford).
+        Statistics statistics;
+    };
+
+    struct Deadline
+    {
+        qint64 deadline;
+        int id;
+    };
+
+    // Heap order: earliest deadline on top.
+    static bool _later( const Deadline &a , const Deadline &b );
+
+    // Maximal number of items a single read request to the device can fetch.
+    quint32 _maximumBlockSize( const QAbstractModbus *const modbus , const quint8 deviceAddress ,
+                               const QAbstractModbus::Table table ) const;
+
+    // Returns true if the heap entry is the pending deadline of an existing job.
+    bool _isPending( const Deadline &entry ) const;
+
+    // Puts the job's pending deadline onto the heap.
+    void _push( const int id );
+
+    // Executes the jobs with one request and notifies their listeners.
+    void _execute( const QList<int> &ids , const quint32 start , const quint32 end );
+
+    // Updates the statistics and computes the next deadline of a job executed (or dropped) at the given time.
+    void _account( Job &job , const qint64 started , const bool executed );
+
+    // Restarts the timer for the earliest deadline.
+    void _reschedule( void );
+
+    QHash<int,Job> _jobs;           // All jobs by identifier.
+    QHash<int,QModbusChangeFilter> _filters;    // Change filters of the change-only jobs.
+    QVector<Deadline> _heap;        // Pending deadlines, entries of removed jobs are skipped lazily.
+    QHash<const QAbstractModbus *,QModbusCapabilityCache *> _capabilities;  // Learned block sizes by connection.
+    int _nextId;                    // Identifier of the next job.
+    OverloadPolicy _policy;         // Overload policy.
+    int _tolerance;                 // Lateness tolerance of the DropLate policy.
+    bool _active;                   // True if started.
+    QTimer _timer;                  // Single shot timer waking up the scheduler for the earliest deadline.
+    QElapsedTimer _clock;           // Monotonic clock the deadlines are based on.
+};
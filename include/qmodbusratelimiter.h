@@ -0,0 +1,154 @@
+/***********************************************************************************************************************
+* QModbusRateLimiter : Token bucket rate limits per connection and per unit with automatic back-off.                  *
+************************************************************************************************************************
+* Author : QModbus contributors                                                                                        *
+* Date   : 2026/10/18                                                                                                  *
+* Changes: -                                                                                                           *
+***********************************************************************************************************************/
+#pragma once
+
+
+/*** Qt includes & prototypes *****************************************************************************************/
+#include <QModbusRequest>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QHash>
+#include <QtCore/QMutex>
+
+
+/*** QModbusRateLimiter class declaration and help ********************************************************************/
+/*!
+* The rate limiter protects slow devices and gateways from being polled too fast. It is attached to one or more
+* QModbusSharedConnection (see QModbusSharedConnection::setRateLimiter()), whose I/O threads reserve every request
+* before handing it to the transport. Token buckets limit the requests per second and the PDU bytes per second (request
+* and expected response) of all requests together and of each unit ID. A request that exceeds a limit is held, with
+* the later requests to its unit, until the buckets refilled; meanwhile the connection goes on with the requests to
+* the other units.
+*
+* Units replying SlaveDeviceBusy or GatewayTargetDeviceFailedToRespond are backed off: the unit is paused, the pause
+* doubles with every further busy reply up to maximumBackoff(), and its rates are halved (down to 1/64). Each
+* successful reply lifts the pause and gives back a sixteenth of the rates, so healthy devices can be pushed hard while
+* fragile ones settle at the rate they sustain.
+*
+* A limiter shared by all connections to a gateway limits the gateway (see QModbusConnectionPool::rateLimiter()). All
+* methods can be called from any thread.
+* \headerfile qmodbusratelimiter.h QModbusRateLimiter
+*/
+class QModbusRateLimiter
+{
+public:
+    /*!
+    * Constructor, no limits.
+    */
+    QModbusRateLimiter( void );
+
+    /*!
+    * Sets the limits of all requests together.
+    * \param requestsPerSecond Requests per second, 0 for no limit.
+    * \param bytesPerSecond PDU bytes per second, 0 for no limit.
+    */
+    void setConnectionLimit( const double requestsPerSecond , const double bytesPerSecond = 0 );
+
+    /*!
+    * Sets the limits of the requests to a unit.
+    * \param unitId The unit (device address).
+    * \param requestsPerSecond Requests per second, 0 for no limit.
+    * \param bytesPerSecond PDU bytes per second, 0 for no limit.
+    */
+    void setUnitLimit( const quint8 unitId , const double requestsPerSecond , const double bytesPerSecond = 0 );
+
+    /*!
+    * Sets the limits of the units without limits of their own (see setUnitLimit()).
+    * \param requestsPerSecond Requests per second, 0 for no limit.
+    * \param bytesPerSecond PDU bytes per second, 0 for no limit.
+    */
+    void setDefaultUnitLimit( const double requestsPerSecond , const double bytesPerSecond = 0 );
+
+    //! Returns how many milliseconds worth of requests may be sent at once after an idle time. Default is 0.
+    int burst( void ) const;
+
+    /*!
+    * Changes how many milliseconds worth of requests may be sent at once after an idle time. With 0, the requests are
+    * evenly spaced.
+    * \param msecs Burst in milliseconds.
+    */
+    void setBurst( const int msecs );
+
+    //! Returns the longest pause of a backed off unit in milliseconds. Default is 5000.
+    int maximumBackoff( void ) const;
+
+    //! Changes the longest pause of a backed off unit in milliseconds.
+    void setMaximumBackoff( const int msecs );
+
+    /*!
+    * Returns the share of its limits a unit currently gets.
+    * \param unitId The unit.
+    * \return 1.0 unless the unit was backed off.
+    */
+    double unitScale( const quint8 unitId ) const;
+
+    /*!
+    * Reserves a request: takes its tokens from the buckets.
+    * \param request The request.
+    * \return Milliseconds the request has to wait before it is sent, 0 to send it right away.
+    */
+    int reserve( const QModbusRequest &request );
+
+    /*!
+    * Reports the response to a request, backs off or recovers its unit.
+    * \param request The request.
+    * \param response The response.
+    */
+    void report( const QModbusRequest &request , const QModbusResponse &response );
+
+private:
+    Q_DISABLE_COPY( QModbusRateLimiter )
+
+    enum
+    {
+        InitialBackoff = 100 ,      // First pause of a unit that is busy.
+        MinimumScale = 64 ,         // A backed off unit gets at least 1/64 of its limits.
+        RecoverySteps = 16          // Successful replies to recover from a halving.
+    };
+
+    struct Rates
+    {
+        Rates( void ) : requests( 0 ) , bytes( 0 ) {}
+
+        double requests;            // Requests per second, 0 for no limit.
+        double bytes;               // Bytes per second, 0 for no limit.
+    };
+
+    struct Bucket
+    {
+        Bucket( void ) : level( 0 ) , stamp( 0 ) {}
+
+        double level;               // Tokens available, negative while requests wait for tokens.
+        qint64 stamp;               // Time of the last refill.
+    };
+
+    struct Unit
+    {
+        Unit( void ) : ownRates( false ) , scale( 1.0 ) , backoff( 0 ) , pausedUntil( 0 ) {}
+
+        Rates rates;                // Limits of the unit if ownRates.
+        bool ownRates;              // False to use the default limits.
+        Bucket requests;            // Request tokens.
+        Bucket bytes;               // Byte tokens.
+        double scale;               // Share of the limits, below 1 while backed off.
+        int backoff;                // Current pause, 0 if not backed off.
+        qint64 pausedUntil;         // End of the pause.
+    };
+
+    // Takes tokens from a bucket, returns the milliseconds until they are available.
+    double _take( Bucket &bucket , const double rate , const double tokens , const qint64 now ) const;
+
+    mutable QMutex _mutex;          // Protects the members below.
+    QElapsedTimer _clock;           // Time base of the buckets.
+    Rates _connectionRates;         // Limits of all requests.
+    Bucket _connectionRequests;     // Request tokens of all requests.
+    Bucket _connectionBytes;        // Byte tokens of all requests.
+    Rates _defaultRates;            // Limits of the units without their own.
+    QHash<quint8,Unit> _units;      // Units by ID.
+    int _burst;                     // Burst in milliseconds.
+    int _maximumBackoff;            // Longest pause in milliseconds.
+};
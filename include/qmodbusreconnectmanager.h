@@ -0,0 +1,172 @@
+/***********************************************************************************************************************
+* QModbusReconnectManager : Keeps modbus TCP connections up, reconnects in parallel with jittered exponential backoff. *
+************************************************************************************************************************
+* Author : QModbus contributors                                                                                        *
+* Date   : 2026/10/18                                                                                                  *
+* Changes: -                                                                                                           *
+***********************************************************************************************************************/
+#pragma once
+
+
+/*** Base classes *****************************************************************************************************/
+#include <QtCore/QObject>
+
+
+/*** Qt includes & prototypes *****************************************************************************************/
+#include <QTcpModbus>
+#include <QtCore/QHash>
+#include <QtCore/QMultiMap>
+#include <QtCore/QTimer>
+#include <QtCore/QElapsedTimer>
+
+
+/*** QModbusReconnectManager class declaration and help ***************************************************************/
+/*!
+* The reconnect manager watches modbus TCP transports and connects them again whenever a connect fails or an
+* established connection is lost. All connects are non-blocking (see QTcpModbus::connectToHost()), so any number of
+* transports reconnect in parallel and a cold start over many endpoints takes as long as the slowest endpoint, not the
+* sum of all of them:
+*
+* \code
+* foreach ( QTcpModbus *modbus , transports )
+* {
+*     modbus->connectToHost( hostOf( modbus ) );
+*     manager.addConnection( modbus );
+* }
+* \endcode
+*
+* After the n-th consecutive failure of a transport the next attempt is delayed by initialDelay() * 2^n, at most
+* maximumDelay(). Half of the delay is random, so transports that lost their connection together (a site coming back
+* after an outage) do not hit the network in lockstep. A successful connect resets the delay.
+*
+* The manager is driven by a single timer and needs a running event loop. The transports may live in other threads
+* (for example in the I/O thread of a QModbusSharedConnection, which holds its requests while the transport
+* reconnects, see QModbusSharedConnection::setReconnectTimeout()): the manager only talks to them through signals and
+* queued invocations of QTcpModbus::reconnect().
+* \headerfile qmodbusreconnectmanager.h QModbusReconnectManager
+*/
+class QModbusReconnectManager : public QObject
+{
+    Q_OBJECT
+
+public:
+    /*!
+    * Constructor.
+    * \param parent Parent object.
+    */
+    explicit QModbusReconnectManager( QObject *parent = NULL );
+
+    /*!
+    * Destructor.
+    */
+    virtual ~QModbusReconnectManager();
+
+    /*!
+    * Adds a transport. Has to be called from the thread the transport lives in at that moment (before it is handed to
+    * a QModbusSharedConnection). The transport needs a host, either from an earlier connect or a connectToHost() in
+    * progress; a transport that is neither connected nor connecting is connected right away.
+    * \param modbus The transport, has to stay valid until it is removed or the manager is destroyed.
+    */
+    void addConnection( QTcpModbus *const modbus );
+
+    /*!
+    * Removes a transport, the manager stops reconnecting it.
+    * \param modbus The transport.
+    */
+    void removeConnection( QTcpModbus *const modbus );
+
+    /*!
+    * Returns the number of transports.
+    * \return Number of transports.
+    */
+    int connectionCount( void ) const;
+
+    /*!
+    * Returns the number of transports known to be connected.
+    * \return Number of connected transports.
+    */
+    int connectedCount( void ) const;
+
+    /*!
+    * Returns the delay before the first reconnect attempt in milliseconds. Default is 100 ms.
+    * \return Initial delay.
+    */
+    int initialDelay( void ) const;
+
+    /*!
+    * Changes the delay before the first reconnect attempt.
+    * \param msecs Delay in milliseconds.
+    */
+    void setInitialDelay( const int msecs );
+
+    /*!
+    * Returns the largest delay between two reconnect attempts in milliseconds. Default is 30 seconds.
+    * \return Maximal delay.
+    */
+    int maximumDelay( void ) const;
+
+    /*!
+    * Changes the largest delay between two reconnect attempts.
+    * \param msecs Delay in milliseconds.
+    */
+    void setMaximumDelay( const int msecs );
+
+signals:
+    /*!
+    * This signal is emitted once a transport is connected (again).
+    * \param modbus The transport.
+    */
+    void connected( QTcpModbus *modbus );
+
+    /*!
+    * This signal is emitted if a transport lost its connection, the manager reconnects it.
+    * \param modbus The transport.
+    */
+    void disconnected( QTcpModbus *modbus );
+
+    /*!
+    * This signal is emitted each time all transports are connected.
+    */
+    void allConnected();
+
+private slots:
+    void _transportConnected( void );
+    void _transportLost( void );
+    void _transportFailed( void );
+    void _timerExpired( void );
+
+private:
+    Q_DISABLE_COPY( QModbusReconnectManager )
+
+    struct Connection
+    {
+        QTcpModbus *modbus;
+        int failures;               // Consecutive failed attempts.
+        bool connected;             // True if the transport is known to be connected.
+        qint64 due;                 // Time of the next attempt (manager clock), -1 if none is scheduled.
+    };
+
+    // Returns the connection of the transport that sent the current signal, NULL if it was removed meanwhile.
+    Connection *_sender( void ) const;
+
+    // Schedules the next attempt of a connection after a failure.
+    void _schedule( Connection *const connection );
+
+    // Removes the scheduled attempt of a connection.
+    void _unschedule( Connection *const connection );
+
+    // Restarts the timer for the earliest attempt.
+    void _reschedule( void );
+
+    // Returns the backoff delay after the given number of failures, half of it random.
+    int _backoff( const int failures );
+
+    QHash<QObject *,Connection *> _connections;     // Connections by transport.
+    QMultiMap<qint64,Connection *> _due;            // Scheduled attempts by time.
+    QTimer _timer;                  // Fires at the earliest scheduled attempt.
+    QElapsedTimer _clock;           // Manager clock.
+    int _connectedCount;            // Connections known to be connected.
+    int _initialDelay;              // Delay before the first attempt.
+    int _maximumDelay;              // Largest delay between two attempts.
+    quint32 _random;                // State of the jitter generator (xorshift).
+};
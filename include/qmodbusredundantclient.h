@@ -0,0 +1,281 @@
+/***********************************************************************************************************************
+* QModbusRedundantClient : Redundant paths (gateways) to the same devices with failover and hedged reads.             *
+************************************************************************************************************************
+* Author : QModbus contributors                                                                                        *
+* Date   : 2026/10/18                                                                                                  *
+* Changes: -                                                                                                           *
+***********************************************************************************************************************/
+#pragma once
+
+
+/*** Base classes *****************************************************************************************************/
+#include <QAbstractModbus>
+
+
+/*** Qt includes & prototypes *****************************************************************************************/
+#include <QModbusRequest>
+#include <QModbusSharedConnection>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QList>
+#include <QtCore/QMutex>
+#include <QtCore/QVector>
+struct QModbusRedundantAttempt;
+struct QModbusRedundantRace;
+
+
+/*** QModbusRedundantClient class declaration and help ****************************************************************/
+/*!
+* The redundant client reaches the same devices through several paths, typically modbus TCP gateways with redundant
+* links to the field bus. Each path is a transport (usually a connected QTcpModbus) executed by its own
+* QModbusSharedConnection, so the paths work concurrently.
+*
+* Requests go to the first healthy path in the order the paths were given (the primary). A path is marked down after
+* failureThreshold() consecutive path failures (timeout, CRC error, no connection, unexpected frame or a gateway
+* exception). The next path takes over (failover); after recoveryDelay() the preferred path gets the next request
+* again (fail-back) and is marked up by its first answer or down for another recoveryDelay() by a failure. Reads
+* (functions 0x01 to 0x04) that fail on a path are retried on the next path, writes are never repeated: a write whose
+* reply was lost may have been executed.
+*
+* If hedging is enabled, a read that has no reply from the primary within the hedge delay is sent to the next path as
+* well and the first answer is taken. The hedge delay is the hedgePercentile() of the latencies of the last 128
+* answers (at least minimumHedgeDelay()), so only the slowest reads are duplicated. Hedging starts once 16 latencies
+* have been observed. Only reads are hedged, writes are not idempotent. Once a path answered, the attempts still in
+* flight on the other paths are cancelled. An attempt overtaken by a hedge sent after it counts as a failure of its
+* path, so a primary that stalls on every read is marked down even though the hedges rescue the reads. A hedge that is
+* cancelled because the attempt it hedged answered first does not count against its path. Answers that arrive after
+* the race was decided still update the health of their path.
+*
+* The transports are owned by the caller and have to stay valid as long as the client exists. Like the transports, the
+* client is used by one thread at a time.
+* \headerfile qmodbusredundantclient.h QModbusRedundantClient
+*/
+class QModbusRedundantClient : public QAbstractModbus
+{
+public:
+    /*!
+    * Constructor.
+    * \param paths The transports of the paths in order of preference, each has to be open (connected).
+    */
+    explicit QModbusRedundantClient( const QList<QAbstractModbus *> &paths );
+
+    /*!
+    * Destructor, requests still in flight on a path fail.
+    */
+    virtual ~QModbusRedundantClient();
+
+    //! Returns the number of paths.
+    int pathCount( void ) const;
+
+    /*!
+    * Returns true if a path is considered healthy.
+    * \param path Index of the path.
+    * \return False if the path is marked down.
+    */
+    bool isPathHealthy( const int path ) const;
+
+    //! Returns the index of the path requests are sent to first, -1 if there are no paths.
+    int primaryPath( void ) const;
+
+    //! Enables or disables hedged reads (disabled by default).
+    void setHedgingEnabled( const bool enabled );
+
+    //! Returns true if hedged reads are enabled.
+    bool isHedgingEnabled( void ) const;
+
+    //! Sets the latency percentile [50..99] after which a read is hedged, default 95.
+    void setHedgePercentile( const int percentile );
+
+    //! Returns the latency percentile after which a read is hedged.
+    int hedgePercentile( void ) const;
+
+    //! Sets the smallest hedge delay in milliseconds, default 5.
+    void setMinimumHedgeDelay( const int msecs );
+
+    //! Returns the smallest hedge delay in milliseconds.
+    int minimumHedgeDelay( void ) const;
+
+    //! Returns the current hedge delay in milliseconds, -1 as long as too few latencies were observed.
+    int hedgeDelay( void ) const;
+
+    //! Sets the number of consecutive failures after which a path is marked down, default 3.
+    void setFailureThreshold( const int failures );
+
+    //! Returns the number of consecutive failures after which a path is marked down.
+    int failureThreshold( void ) const;
+
+    //! Sets the time in milliseconds after which a path marked down is tried again, default 5000.
+    void setRecoveryDelay( const int msecs );
+
+    //! Returns the time in milliseconds after which a path marked down is tried again.
+    int recoveryDelay( void ) const;
+
+    //! Returns the number of hedged requests sent.
+    quint64 hedgeCount( void ) const;
+
+    //! Returns the number of reads retried on another path after a path failure.
+    quint64 failoverCount( void ) const;
+
+    /*!
+    * Executes a request through the paths as described above.
+    * \param request The request.
+    * \return The first answer or the failure of the last path tried.
+    */
+    QModbusResponse execute( const QModbusRequest &request ) const;
+
+    // Interface implementation (QAbstractModbus), the requests of a batch are executed one after the other.
+    using QAbstractModbus::execute;
+
+    // Interface implementation (QAbstractModbus), true if a path is open.
+    bool isOpen( void ) const;
+
+    // Interface implementation (QAbstractModbus), the timeout of the primary path.
+    unsigned int timeout( void ) const;
+
+    // Interface implementation (QAbstractModbus), applies to all paths.
+    void setTimeout( const unsigned int timeout );
+
+    // Interface implementation (QAbstractModbus).
+    QList<bool> readCoils( const quint8 deviceAddress ,
+                           const quint16 startingAddress ,
+                           const quint16 quantityOfCoils ,
+                           quint8 *const status = NULL
+                         ) const;
+
+    // Interface implementation (QAbstractModbus).
+    QList<bool> readDiscreteInputs( const quint8 deviceAddress ,
+                                    const quint16 startingAddress ,
+                                    const quint16 quantityOfInputs ,
+                                    quint8 *const status = NULL
+                                  ) const;
+
+    // Interface implementation (QAbstractModbus).
+    QList<quint16> readHoldingRegisters( const quint8 deviceAddress ,
+                                         const quint16 startingAddress ,
+                                         const quint16 quantityOfRegisters ,
+                                         quint8 *const status = NULL
+                                       ) const;
+
+    // Interface implementation (QAbstractModbus).
+    QList<quint16> readInputRegisters( const quint8 deviceAddress ,
+                                       const quint16 startingAddress ,
+                                       const quint16 quantityOfInputRegisters ,
+                                       quint8 *const status = NULL
+                                     ) const;
+
+    // Interface implementation (QAbstractModbus).
+    bool writeSingleCoil( const quint8 deviceAddress ,
+                          const quint16 outputAddress ,
+                          const bool outputValue ,
+                          quint8 *const status = NULL
+                        ) const;
+
+    // Interface implementation (QAbstractModbus).
+    bool writeSingleRegister( const quint8 deviceAddress ,
+                              const quint16 registerAddress ,
+                              const quint16 registerValue ,
+                              quint8 *const status = NULL
+                            ) const;
+
+    // Interface implementation (QAbstractModbus).
+    bool writeMultipleCoils( const quint8 deviceAddress ,
+                             const quint16 startingAddress ,
+                             const QList<bool> & outputValues ,
+                             quint8 *const status = NULL
+                           ) const;
+
+    // Interface implementation (QAbstractModbus).
+    bool writeMultipleRegisters( const quint8 deviceAddress ,
+                                 const quint16 startingAddress ,
+                                 const QList<quint16> & registersValues ,
+                                 quint8 *const status = NULL
+                               ) const;
+
+    // Interface implementation (QAbstractModbus).
+    bool maskWriteRegister( const quint8 deviceAddress ,
+                            const quint16 referenceAddress ,
+                            const quint16 andMask ,
+                            const quint16 orMask ,
+                            quint8 *const status = NULL
+                          ) const;
+
+    // Interface implementation (QAbstractModbus).
+    QList<quint16> writeReadMultipleRegisters( const quint8 deviceAddress ,
+                                               const quint16 writeStartingAddress ,
+                                               const QList<quint16> & writeValues ,
+                                               const quint16 readStartingAddress ,
+                                               const quint16 quantityToRead ,
+                                               quint8 *const status = NULL
+                                             ) const;
+
+    // Interface implementation (QAbstractModbus).
+    QList<quint16> readFifoQueue( const quint8 deviceAddress ,
+                                  const quint16 fifoPointerAddress ,
+                                  quint8 *const status = NULL
+                                ) const;
+
+    // Interface implementation (QAbstractModbus).
+    QByteArray executeCustomFunction( const quint8 deviceAddress , const quint8 modbusFunction ,
+                                      QByteArray &data , quint8 *const status = NULL ) const;
+
+    // Interface implementation (QAbstractModbus).
+    bool executePdu( const quint8 deviceAddress , const QModbusFrameView &request , QModbusPduFrame &response ,
+                     quint8 *const status = NULL ) const;
+
+    // Interface implementation (QAbstractModbus), uses the primary path only.
+    QByteArray executeRaw( QByteArray &data , quint8 *const status = NULL ) const;
+
+    // Interface implementation (QAbstractModbus).
+    QByteArray calculateCheckSum( QByteArray &data ) const;
+
+private:
+    Q_DISABLE_COPY( QModbusRedundantClient )
+
+    enum
+    {
+        LatencySamples = 128,       // Number of latencies the hedge delay is based on.
+        MinimumSamples = 16,        // Number of latencies needed before hedging starts.
+        UpdateInterval = 16         // Number of new latencies after which the hedge delay is computed again.
+    };
+
+    struct Path
+    {
+        QAbstractModbus *modbus;            // Transport.
+        QModbusSharedConnection *connection;    // Executes the requests of the path.
+        int failures;                       // Consecutive path failures.
+        bool down;                          // True if the path is marked down.
+        QElapsedTimer downSince;            // Time the path was marked down (or failed again while down).
+    };
+
+    // Returns the paths in the order to try them: up or due for recovery in preference order, then the others.
+    QList<int> _order( void ) const;
+
+    // Updates the health of a path with the result of a request.
+    void _record( const int path , const quint8 status ) const;
+
+    // Sends an attempt of a request on a path.
+    void _submit( QModbusRedundantRace *const race , QList<QModbusRedundantAttempt> &attempts , const int path ,
+                  const QModbusRequest &request , const qint64 sent ) const;
+
+    // Completion handler of an attempt, called by the I/O thread of its path: records the result of the attempt.
+    static void _attemptFinished( const QModbusResponse &response , void *context );
+
+    // Adds a latency sample and updates the hedge delay.
+    void _addLatency( const int msecs ) const;
+
+    // Returns true if the status is a failure of the path rather than an answer of the device.
+    static bool _isPathFailure( const quint8 status );
+
+    mutable QMutex _mutex;          // Protects the health of the paths, recorded by the I/O threads of the paths.
+    mutable QList<Path> _paths;     // The paths in order of preference, never copied (no detach while recording).
+    bool _hedging;                  // Hedged reads enabled.
+    int _hedgePercentile;           // Latency percentile after which reads are hedged.
+    int _minimumHedgeDelay;         // Smallest hedge delay.
+    int _failureThreshold;          // Consecutive failures after which a path is marked down.
+    int _recoveryDelay;             // Time after which a path marked down is tried again.
+    mutable QVector<int> _latencies;    // Latencies of the last answers (ring buffer).
+    mutable int _nextLatency;       // Next position in the ring buffer.
+    mutable int _newLatencies;      // Latencies added since the hedge delay was computed.
+    mutable int _hedgeDelay;        // Current hedge delay, -1 while there are too few latencies.
+    mutable quint64 _hedgeCount;    // Hedged requests sent.
+    mutable quint64 _failoverCount; // Reads retried on another path.
+};
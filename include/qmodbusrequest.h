@@ -0,0 +1,197 @@
+/***********************************************************************************************************************
+* QModbusRequest : Modbus requests and responses as self-contained values.                                            *
+************************************************************************************************************************
+* Author : QModbus contributors                                                                                        *
+* Date   : 2026/10/18                                                                                                  *
+* Changes: -                                                                                                           *
+***********************************************************************************************************************/
+#pragma once
+
+
+/*** Qt includes & prototypes *****************************************************************************************/
+#include <QAbstractModbus>
+#include <QModbusDeadline>
+#include <QModbusFrame>
+#include <QtCore/QList>
+
+
+/*** QModbusRequest class declaration and help ************************************************************************/
+/*!
+* A request is the device address and the request PDU of a modbus transaction. It stores the PDU inline, so it can be
+* copied, queued and handed to another thread without referring to memory of the caller. The static methods create the
+* requests of the standard functions, any other function is created from its PDU.
+*
+* A request may carry a deadline and a cancellation token, both are honoured wherever requests are executed: by the
+* transports (QAbstractModbus::execute()), QModbusSharedConnection and the clients built on it.
+* \headerfile qmodbusrequest.h QModbusRequest
+*/
+class QModbusRequest
+{
+public:
+    /*!
+    * Priority classes, QModbusSharedConnection always executes the queued requests of the highest class first.
+    */
+    enum Priority
+    {
+        Control ,                   //!< Operator commands, sent at the next moment the bus is idle.
+        Interactive ,               //!< Reads a user waits for.
+        Cyclic ,                    //!< Background polling (default).
+        Bulk ,                      //!< Large transfers, sent one frame at a time so the other classes preempt them.
+        PriorityCount               //!< Number of priority classes.
+    };
+
+    //! Constructs an invalid (empty) request.
+    QModbusRequest( void );
+
+    /*!
+    * Constructs a request from its PDU.
+    * \param deviceAddress Address of the slave device [1..247].
+    * \param pdu The request PDU (function code and data), at most 253 bytes. Longer PDUs result in an invalid request.
+    */
+    QModbusRequest( const quint8 deviceAddress , const QModbusFrameView &pdu );
+
+    //! Read coils (0x01).
+    static QModbusRequest readCoils( const quint8 deviceAddress , const quint16 startingAddress ,
+                                     const quint16 quantityOfCoils );
+
+    //! Read discrete inputs (0x02).
+    static QModbusRequest readDiscreteInputs( const quint8 deviceAddress , const quint16 startingAddress ,
+                                              const quint16 quantityOfInputs );
+
+    //! Read holding registers (0x03).
+    static QModbusRequest readHoldingRegisters( const quint8 deviceAddress , const quint16 startingAddress ,
+                                                const quint16 quantityOfRegisters );
+
+    //! Read input registers (0x04).
+    static QModbusRequest readInputRegisters( const quint8 deviceAddress , const quint16 startingAddress ,
+                                              const quint16 quantityOfInputRegisters );
+
+    //! Write single coil (0x05).
+    static QModbusRequest writeSingleCoil( const quint8 deviceAddress , const quint16 outputAddress ,
+                                           const bool outputValue );
+
+    //! Write single register (0x06).
+    static QModbusRequest writeSingleRegister( const quint8 deviceAddress , const quint16 registerAddress ,
+                                               const quint16 registerValue );
+
+    //! Write multiple coils (0x0F), invalid if there are more than 1968 values.
+    static QModbusRequest writeMultipleCoils( const quint8 deviceAddress , const quint16 startingAddress ,
+                                              const QList<bool> &outputValues );
+
+    //! Write multiple registers (0x10), invalid if there are more than 123 values.
+    static QModbusRequest writeMultipleRegisters( const quint8 deviceAddress , const quint16 startingAddress ,
+                                                  const QList<quint16> &registersValues );
+
+    //! Mask write register (0x16).
+    static QModbusRequest maskWriteRegister( const quint8 deviceAddress , const quint16 referenceAddress ,
+                                             const quint16 andMask , const quint16 orMask );
+
+    //! Read/write multiple registers (0x17), invalid if there are more than 121 values to write.
+    static QModbusRequest writeReadMultipleRegisters( const quint8 deviceAddress , const quint16 writeStartingAddress ,
+                                                      const QList<quint16> &writeValues ,
+                                                      const quint16 readStartingAddress ,
+                                                      const quint16 quantityToRead );
+
+    //! Read FIFO queue (0x18).
+    static QModbusRequest readFifoQueue( const quint8 deviceAddress , const quint16 fifoPointerAddress );
+
+    //! Returns true if the request has a PDU.
+    bool isValid( void ) const;
+
+    //! Returns the device address.
+    quint8 deviceAddress( void ) const;
+
+    //! Returns the function code (0 for an invalid request).
+    quint8 functionCode( void ) const;
+
+    //! Returns the request PDU, valid as long as the request is neither modified nor destroyed.
+    QModbusFrameView pdu( void ) const;
+
+    //! Sets the deadline of the request, by default it never expires.
+    void setDeadline( const QModbusDeadline &deadline );
+
+    //! Returns the deadline of the request.
+    const QModbusDeadline &deadline( void ) const;
+
+    //! Sets the cancellation token of the request, by default QModbusCancellationToken::none().
+    void setCancellationToken( const QModbusCancellationToken &token );
+
+    //! Returns the cancellation token of the request.
+    const QModbusCancellationToken &cancellationToken( void ) const;
+
+    //! Returns true if the request has a deadline or a token that can be cancelled.
+    bool isLimited( void ) const;
+
+    /*!
+    * Returns the status of a request that must not be sent (anymore).
+    * \return Cancelled if the token was cancelled, Timeout if the deadline expired, Ok otherwise.
+    */
+    quint8 limitStatus( void ) const;
+
+    //! Sets the priority class of the request, by default Cyclic.
+    void setPriority( const Priority priority );
+
+    //! Returns the priority class of the request.
+    Priority priority( void ) const;
+
+private:
+    quint8 _deviceAddress;          // Address of the slave device.
+    QModbusPduFrame _pdu;           // Request PDU.
+    QModbusDeadline _deadline;      // Deadline.
+    QModbusCancellationToken _token;    // Cancellation token.
+    Priority _priority;             // Priority class.
+};
+
+
+/*** QModbusResponse class declaration and help ***********************************************************************/
+/*!
+* A response is the status of a modbus transaction and, on success, the response PDU. Like the request it stores the
+* PDU inline. The data of the read functions can be decoded using registers(), bits() and fifoQueue().
+* \headerfile qmodbusrequest.h QModbusRequest
+*/
+class QModbusResponse
+{
+public:
+    //! Constructs a response with status QAbstractModbus::UnknownError.
+    QModbusResponse( void );
+
+    /*!
+    * Constructs a response.
+    * \param status The transaction status (see QAbstractModbus::Status).
+    * \param pdu The response PDU (function code and data), ignored unless status is QAbstractModbus::Ok.
+    */
+    explicit QModbusResponse( const quint8 status , const QModbusFrameView &pdu = QModbusFrameView() );
+
+    //! Returns the transaction status (see QAbstractModbus::Status).
+    quint8 status( void ) const;
+
+    //! Returns true if the transaction succeeded.
+    bool isOk( void ) const;
+
+    //! Returns the response PDU, valid as long as the response is neither modified nor destroyed.
+    QModbusFrameView pdu( void ) const;
+
+    /*!
+    * Decodes the registers of a response to read holding registers (0x03), read input registers (0x04) or read/write
+    * multiple registers (0x17).
+    * \return The registers, empty if the transaction failed or the response has no (consistent) register data.
+    */
+    QList<quint16> registers( void ) const;
+
+    /*!
+    * Decodes the bits of a response to read coils (0x01) or read discrete inputs (0x02).
+    * \param quantity Number of bits requested.
+    * \return The bits, empty if the transaction failed or the response does not contain quantity bits.
+    */
+    QList<bool> bits( const quint16 quantity ) const;
+
+    /*!
+    * Decodes the registers of a response to read FIFO queue (0x18).
+    * \return The queued registers, empty if the transaction failed or the response is not consistent.
+    */
+    QList<quint16> fifoQueue( void ) const;
+
+private:
+    quint8 _status;                 // Transaction status.
+    QModbusPduFrame _pdu;           // Response PDU.
+};
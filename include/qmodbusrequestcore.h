@@ -0,0 +1,439 @@
+/***********************************************************************************************************************
+* QModbusRequestCore : Transport independent encoding, validation and decoding of the modbus functions.               *
+************************************************************************************************************************
+* Author : QModbus contributors                                                                                        *
+* Date   : 2026/10/18                                                                                                  *
+* Changes: -                                                                                                           *
+***********************************************************************************************************************/
+#pragma once
+
+
+/*** Qt includes & prototypes *****************************************************************************************/
+#include <QAbstractModbus>
+#include <QModbusFrame>
+#include <QModbusFraming>
+#include <QModbusPdu>
+#include <QModbusRequest>
+#include <QtCore/QByteArray>
+#include <QtCore/QList>
+
+
+/*** QModbusRequestCore class declaration and help ********************************************************************/
+/*!
+* The request core implements the modbus functions once for all transports: it encodes the request PDU, runs the
+* transaction using the framing policy (see QModbusFraming) and the I/O policy, validates the response PDU against the
+* request and decodes it. The transports (QRtuModbus, QAsciiModbus and QTcpModbus) are thin facades that instantiate
+* the core with their framing and I/O policy, so every improvement of the core applies to all of them.
+*
+* Both policies are template parameters, so the calls are resolved at compile time and the framing code is inlined
+* into each function. Requests are encoded with the compile-time layouts of QModbusPdu into a buffer on the stack,
+* responses are received into a QModbusPduFrame on the stack.
+* Besides the methods used by the framing policy, the I/O policy has to provide bool isOpen( void ) const.
+*
+* The methods have the same semantics as the corresponding methods of QAbstractModbus.
+* \headerfile qmodbusrequestcore.h QModbusRequestCore
+*/
+template< class Framing , class Io >
+class QModbusRequestCore
+{
+public:
+    /*!
+    * Constructor.
+    * \param io The I/O policy.
+    * \param framing The framing policy.
+    */
+    explicit QModbusRequestCore( const Io &io , const Framing &framing = Framing() );
+
+    /*!
+    * Executes a transaction.
+    * \param deviceAddress Address of the slave device [1..247].
+    * \param request Request PDU (function code and data).
+    * \param size Size of the request PDU.
+    * \param expected Length of the response PDU or -1 if unknown.
+    * \param response Receives the response PDU on success.
+    * \return Transaction status (see QAbstractModbus::Status).
+    */
+    quint8 transact( const quint8 deviceAddress , const char *const request , const int size , const int expected ,
+                     QModbusPduFrame &response ) const;
+
+    //! Read coils (0x01) or discrete inputs (0x02).
+    QList<bool> readBits( const quint8 deviceAddress , const quint8 functionCode , const quint16 startingAddress ,
+                          const quint16 quantity , quint8 *const status ) const;
+
+    //! Read holding registers (0x03) or input registers (0x04).
+    QList<quint16> readRegisters( const quint8 deviceAddress , const quint8 functionCode ,
+                                  const quint16 startingAddress , const quint16 quantity , quint8 *const status ) const;
+
+    //! Write single coil (0x05).
+    bool writeSingleCoil( const quint8 deviceAddress , const quint16 outputAddress , const bool outputValue ,
+                          quint8 *const status ) const;
+
+    //! Write single register (0x06).
+    bool writeSingleRegister( const quint8 deviceAddress , const quint16 registerAddress ,
+                              const quint16 registerValue , quint8 *const status ) const;
+
+    //! Write multiple coils (0x0F).
+    bool writeMultipleCoils( const quint8 deviceAddress , const quint16 startingAddress ,
+                             const QList<bool> &outputValues , quint8 *const status ) const;
+
+    //! Write multiple registers (0x10).
+    bool writeMultipleRegisters( const quint8 deviceAddress , const quint16 startingAddress ,
+                                 const QList<quint16> &registersValues , quint8 *const status ) const;
+
+    //! Mask write register (0x16).
+    bool maskWriteRegister( const quint8 deviceAddress , const quint16 referenceAddress , const quint16 andMask ,
+                            const quint16 orMask , quint8 *const status ) const;
+
+    //! Read/write multiple registers (0x17).
+    QList<quint16> writeReadMultipleRegisters( const quint8 deviceAddress , const quint16 writeStartingAddress ,
+                                               const QList<quint16> &writeValues ,
+                                               const quint16 readStartingAddress , const quint16 quantityToRead ,
+                                               quint8 *const status ) const;
+
+    //! Read FIFO queue (0x18).
+    QList<quint16> readFifoQueue( const quint8 deviceAddress , const quint16 fifoPointerAddress ,
+                                  quint8 *const status ) const;
+
+    //! Any other function, returns the response data (without function code).
+    QByteArray executeCustomFunction( const quint8 deviceAddress , const quint8 functionCode ,
+                                      const QByteArray &data , quint8 *const status ) const;
+
+    //! Any function given as request PDU, receives the response PDU.
+    bool executePdu( const quint8 deviceAddress , const QModbusFrameView &request , QModbusPduFrame &response ,
+                     quint8 *const status ) const;
+
+    //! A batch of requests, returns one response per request.
+    QList<QModbusResponse> execute( const QList<QModbusRequest> &batch ) const;
+
+private:
+    // Stores the status and returns false.
+    static bool _fail( const quint8 result , quint8 *const status );
+
+    // Runs the transaction and checks the function code, stores the status.
+    bool _execute( const quint8 deviceAddress , const char *const request , const int size , const int expected ,
+                   QModbusPduFrame &response , quint8 *const status ) const;
+
+    // Checks the response against the first echoSize bytes of the request (a write echoes address and value/quantity).
+    bool _echo( const quint8 deviceAddress , const char *const request , const int size , const int echoSize ,
+                quint8 *const status ) const;
+
+    Io _io;                         // I/O policy.
+    Framing _framing;               // Framing policy.
+};
+
+
+/*** QModbusRequestCore implementation ********************************************************************************/
+template< class Framing , class Io >
+QModbusRequestCore<Framing,Io>::QModbusRequestCore( const Io &io , const Framing &framing ) :
+    _io( io ) , _framing( framing )
+{}
+
+template< class Framing , class Io >
+quint8 QModbusRequestCore<Framing,Io>::transact( const quint8 deviceAddress , const char *const request ,
+                                                 const int size , const int expected ,
+                                                 QModbusPduFrame &response ) const
+{
+    // Are we connected ?
+    if ( !_io.isOpen() ) return QAbstractModbus::NoConnection;
+
+    return _framing.transact( _io , deviceAddress , request , size , expected , response );
+}
+
+template< class Framing , class Io >
+QList<bool> QModbusRequestCore<Framing,Io>::readBits( const quint8 deviceAddress , const quint8 functionCode ,
+                                                      const quint16 startingAddress , const quint16 quantity ,
+                                                      quint8 *const status ) const
+{
+    // Create the request PDU.
+    char request[QModbusReadBitsPdu::MaxPduSize];
+    const int size = QModbusReadBitsPdu::encode( request , functionCode , startingAddress , quantity );
+
+    // Execute and check the byte count.
+    const int neededRxBytes = ( quantity + 7 ) / 8;
+    QModbusPduFrame response;
+    if ( !_execute( deviceAddress , request , size , neededRxBytes + 2 , response , status ) ) return QList<bool>();
+    if ( response.at( 1 ) != neededRxBytes )
+    {
+        _fail( QAbstractModbus::UnknownError , status );
+        return QList<bool>();
+    }
+
+    // Convert the data.
+    const uchar *data = (const uchar *)response.constData() + 2;
+    QList<bool> list;
+    for ( int i = 0 ; i < quantity ; i++ )
+    {
+        list.append( data[i >> 3] & ( 0x01 << ( i & 7 ) ) );
+    }
+    return list;
+}
+
+template< class Framing , class Io >
+QList<quint16> QModbusRequestCore<Framing,Io>::readRegisters( const quint8 deviceAddress , const quint8 functionCode ,
+                                                              const quint16 startingAddress , const quint16 quantity ,
+                                                              quint8 *const status ) const
+{
+    // Create the request PDU.
+    char request[QModbusReadRegistersPdu::MaxPduSize];
+    const int size = QModbusReadRegistersPdu::encode( request , functionCode , startingAddress , quantity );
+
+    // Execute and check the byte count.
+    QModbusPduFrame response;
+    if ( !_execute( deviceAddress , request , size , quantity * 2 + 2 , response , status ) ) return QList<quint16>();
+    if ( response.at( 1 ) != ( ( quantity * 2 ) & 0xFF ) )
+    {
+        _fail( QAbstractModbus::UnknownError , status );
+        return QList<quint16>();
+    }
+
+    // Convert the data.
+    QList<quint16> list;
+    for ( int i = 0 ; i < quantity ; i++ ) list.append( response.view().value( 2 + 2 * i ) );
+    return list;
+}
+
+template< class Framing , class Io >
+bool QModbusRequestCore<Framing,Io>::writeSingleCoil( const quint8 deviceAddress , const quint16 outputAddress ,
+                                                      const bool outputValue , quint8 *const status ) const
+{
+    char request[QModbusWriteSinglePdu::MaxPduSize];
+    const int size = QModbusWriteSinglePdu::encode( request , 0x05 , outputAddress , outputValue ? 0xFF00 : 0x0000 );
+    return _echo( deviceAddress , request , size , size , status );
+}
+
+template< class Framing , class Io >
+bool QModbusRequestCore<Framing,Io>::writeSingleRegister( const quint8 deviceAddress , const quint16 registerAddress ,
+                                                          const quint16 registerValue , quint8 *const status ) const
+{
+    char request[QModbusWriteSinglePdu::MaxPduSize];
+    const int size = QModbusWriteSinglePdu::encode( request , 0x06 , registerAddress , registerValue );
+    return _echo( deviceAddress , request , size , size , status );
+}
+
+template< class Framing , class Io >
+bool QModbusRequestCore<Framing,Io>::writeMultipleCoils( const quint8 deviceAddress , const quint16 startingAddress ,
+                                                         const QList<bool> &outputValues ,
+                                                         quint8 *const status ) const
+{
+    // Check that the coils fit into the request.
+    const int txBytes = ( outputValues.count() + 7 ) / 8;
+    if ( txBytes > QModbusWriteMultiplePdu::MaxDataSize ) return _fail( QAbstractModbus::IllegalDataValue , status );
+
+    // Create the request PDU, the bits are packed LSB first.
+    char request[QModbusWriteMultiplePdu::MaxPduSize];
+    QModbusWriteMultiplePdu::encode( request , 0x0F , startingAddress , outputValues.count() );
+    const int size = QModbusWriteMultiplePdu::setDataSize( request , txBytes );
+    char *data = QModbusWriteMultiplePdu::data( request );
+    for ( int i = 0 ; i < txBytes ; i++ ) data[i] = 0;
+    for ( int i = 0 ; i < outputValues.count() ; i++ )
+    {
+        if ( outputValues.at( i ) ) data[i >> 3] |= 0x01 << ( i & 7 );
+    }
+
+    // The response echoes the starting address and the quantity.
+    return _echo( deviceAddress , request , size , 5 , status );
+}
+
+template< class Framing , class Io >
+bool QModbusRequestCore<Framing,Io>::writeMultipleRegisters( const quint8 deviceAddress ,
+                                                             const quint16 startingAddress ,
+                                                             const QList<quint16> &registersValues ,
+                                                             quint8 *const status ) const
+{
+    // Check that the registers fit into the request.
+    const int txBytes = registersValues.count() * 2;
+    if ( txBytes > QModbusWriteMultiplePdu::MaxDataSize ) return _fail( QAbstractModbus::IllegalDataValue , status );
+
+    // Create the request PDU.
+    char request[QModbusWriteMultiplePdu::MaxPduSize];
+    QModbusWriteMultiplePdu::encode( request , 0x10 , startingAddress , registersValues.count() );
+    const int size = QModbusWriteMultiplePdu::setDataSize( request , txBytes );
+    char *data = QModbusWriteMultiplePdu::data( request );
+    foreach ( quint16 reg , registersValues )
+    {
+        QModbusPdu::put( data , reg );
+        data += 2;
+    }
+
+    // The response echoes the starting address and the quantity.
+    return _echo( deviceAddress , request , size , 5 , status );
+}
+
+template< class Framing , class Io >
+bool QModbusRequestCore<Framing,Io>::maskWriteRegister( const quint8 deviceAddress , const quint16 referenceAddress ,
+                                                        const quint16 andMask , const quint16 orMask ,
+                                                        quint8 *const status ) const
+{
+    // The response is an echo of the request.
+    char request[QModbusMaskWritePdu::MaxPduSize];
+    const int size = QModbusMaskWritePdu::encode( request , 0x16 , referenceAddress , andMask , orMask );
+    return _echo( deviceAddress , request , size , size , status );
+}
+
+template< class Framing , class Io >
+QList<quint16> QModbusRequestCore<Framing,Io>::writeReadMultipleRegisters( const quint8 deviceAddress ,
+                                                                           const quint16 writeStartingAddress ,
+                                                                           const QList<quint16> &writeValues ,
+                                                                           const quint16 readStartingAddress ,
+                                                                           const quint16 quantityToRead ,
+                                                                           quint8 *const status ) const
+{
+    // Check that the registers fit into the request.
+    const int txBytes = writeValues.count() * 2;
+    if ( txBytes > QModbusReadWritePdu::MaxDataSize )
+    {
+        _fail( QAbstractModbus::IllegalDataValue , status );
+        return QList<quint16>();
+    }
+
+    // Create the request PDU.
+    char request[QModbusReadWritePdu::MaxPduSize];
+    QModbusReadWritePdu::encode( request , 0x17 , readStartingAddress , quantityToRead , writeStartingAddress ,
+                                 writeValues.count() );
+    const int size = QModbusReadWritePdu::setDataSize( request , txBytes );
+    char *data = QModbusReadWritePdu::data( request );
+    foreach ( quint16 reg , writeValues )
+    {
+        QModbusPdu::put( data , reg );
+        data += 2;
+    }
+
+    // Execute and check the byte count.
+    QModbusPduFrame response;
+    if ( !_execute( deviceAddress , request , size , quantityToRead * 2 + 2 , response , status ) )
+    {
+        return QList<quint16>();
+    }
+    if ( response.at( 1 ) != ( ( quantityToRead * 2 ) & 0xFF ) )
+    {
+        _fail( QAbstractModbus::UnknownError , status );
+        return QList<quint16>();
+    }
+
+    // Convert the data.
+    QList<quint16> list;
+    for ( int i = 0 ; i < quantityToRead ; i++ ) list.append( response.view().value( 2 + 2 * i ) );
+    return list;
+}
+
+template< class Framing , class Io >
+QList<quint16> QModbusRequestCore<Framing,Io>::readFifoQueue( const quint8 deviceAddress ,
+                                                              const quint16 fifoPointerAddress ,
+                                                              quint8 *const status ) const
+{
+    char request[QModbusReadFifoPdu::MaxPduSize];
+    const int size = QModbusReadFifoPdu::encode( request , 0x18 , fifoPointerAddress );
+
+    // The length of the response is only known from its byte count.
+    QModbusPduFrame response;
+    if ( !_execute( deviceAddress , request , size , -1 , response , status ) ) return QList<quint16>();
+    const int byteCount = response.size() >= 5 ? response.view().value( 1 ) : -1;
+    const int fifoCount = response.size() >= 5 ? response.view().value( 3 ) : -1;
+    if ( byteCount != fifoCount * 2 + 2 || response.size() != byteCount + 3 )
+    {
+        _fail( QAbstractModbus::UnknownError , status );
+        return QList<quint16>();
+    }
+
+    // Convert the data.
+    QList<quint16> list;
+    for ( int i = 0 ; i < fifoCount ; i++ ) list.append( response.view().value( 5 + 2 * i ) );
+    return list;
+}
+
+template< class Framing , class Io >
+QByteArray QModbusRequestCore<Framing,Io>::executeCustomFunction( const quint8 deviceAddress ,
+                                                                  const quint8 functionCode , const QByteArray &data ,
+                                                                  quint8 *const status ) const
+{
+    // Create the request PDU.
+    QModbusPduFrame request;
+    if ( !request.append( (char)functionCode ) || !request.append( data.constData() , data.size() ) )
+    {
+        _fail( QAbstractModbus::IllegalDataValue , status );
+        return QByteArray();
+    }
+
+    QModbusPduFrame response;
+    if ( !_execute( deviceAddress , request.constData() , request.size() , -1 , response , status ) )
+    {
+        return QByteArray();
+    }
+    return response.mid( 1 ).toByteArray();
+}
+
+template< class Framing , class Io >
+bool QModbusRequestCore<Framing,Io>::executePdu( const quint8 deviceAddress , const QModbusFrameView &request ,
+                                                 QModbusPduFrame &response , quint8 *const status ) const
+{
+    if ( request.isEmpty() || request.size() > QModbusPdu::MaxSize )
+    {
+        return _fail( QAbstractModbus::IllegalDataValue , status );
+    }
+    const int expected = QModbusPdu::responseSize( request.data() , request.size() );
+    return _execute( deviceAddress , request.data() , request.size() , expected , response , status );
+}
+
+template< class Framing , class Io >
+QList<QModbusResponse> QModbusRequestCore<Framing,Io>::execute( const QList<QModbusRequest> &batch ) const
+{
+    QList<QModbusResponse> responses;
+
+    // Are we connected ?
+    if ( !_io.isOpen() )
+    {
+        const QModbusResponse failed( QAbstractModbus::NoConnection );
+        for ( int i = 0 ; i < batch.count() ; i++ ) responses.append( failed );
+        return responses;
+    }
+
+    // The responses have to be for the functions requested.
+    _framing.transact( _io , batch , responses );
+    for ( int i = 0 ; i < batch.count() ; i++ )
+    {
+        const QModbusFrameView pdu = responses.at( i ).pdu();
+        if ( responses.at( i ).isOk() && ( pdu.size() < 2 || pdu.at( 0 ) != batch.at( i ).functionCode() ) )
+        {
+            responses[i] = QModbusResponse( QAbstractModbus::UnknownError );
+        }
+    }
+    return responses;
+}
+
+template< class Framing , class Io >
+bool QModbusRequestCore<Framing,Io>::_fail( const quint8 result , quint8 *const status )
+{
+    if ( status ) *status = result;
+    return false;
+}
+
+template< class Framing , class Io >
+bool QModbusRequestCore<Framing,Io>::_execute( const quint8 deviceAddress , const char *const request ,
+                                               const int size , const int expected , QModbusPduFrame &response ,
+                                               quint8 *const status ) const
+{
+    quint8 result = transact( deviceAddress , request , size , expected , response );
+
+    // The response has to be for the function requested.
+    if ( result == QAbstractModbus::Ok && ( response.size() < 2 || response.at( 0 ) != (quint8)request[0] ) )
+    {
+        result = QAbstractModbus::UnknownError;
+    }
+
+    if ( status ) *status = result;
+    return result == QAbstractModbus::Ok;
+}
+
+template< class Framing , class Io >
+bool QModbusRequestCore<Framing,Io>::_echo( const quint8 deviceAddress , const char *const request , const int size ,
+                                            const int echoSize , quint8 *const status ) const
+{
+    // The response repeats the function code and the first fields of the request.
+    QModbusPduFrame response;
+    if ( !_execute( deviceAddress , request , size , echoSize , response , status ) ) return false;
+    if ( response.view() != QModbusFrameView( request , echoSize ) )
+    {
+        return _fail( QAbstractModbus::UnknownError , status );
+    }
+    return true;
+}
@@ -0,0 +1,292 @@
+/***********************************************************************************************************************
+* QModbusRetryClient : Retries of failed requests by status, with per-device retry budgets and statistics.            *
+************************************************************************************************************************
+* Author : QModbus contributors                                                                                        *
+* Date   : 2026/10/18                                                                                                  *
+* Changes: -                                                                                                           *
+***********************************************************************************************************************/
+#pragma once
+
+
+/*** Base classes *****************************************************************************************************/
+#include <QtCore/QObject>
+#include <QAbstractModbus>
+
+
+/*** Qt includes & prototypes *****************************************************************************************/
+#include <QModbusRequest>
+#include <QtCore/QHash>
+#include <QtCore/QMutex>
+
+
+/*** QModbusRetryClient class declaration and help ********************************************************************/
+/*!
+* The retry client wraps a transport and retries failed requests depending on their status, so callers no longer need
+* retry loops of their own:
+*   - CrcError is retried right away (a frame corrupted on the serial line).
+*   - Timeout is retried after a delay that starts at timeoutBackoff() and doubles with every retry.
+*   - SlaveDeviceBusy and Acknowledge are retried after a delay that starts at busyDelay() and doubles as well.
+*   - Every other status, IllegalDataAddress and the other exceptions in particular, is final.
+* The delays are at most maximumDelay(). A request is retried at most maximumRetries() times, and never once it is
+* cancelled or its deadline expired (see QModbusRequest). A request that may have been executed (CrcError, Timeout or
+* Acknowledge) is only retried if repeating it is harmless: reads and writes of absolute values, not a FIFO read or a
+* user defined function.
+*
+* Each device has a retry budget so a storm of failures can not eat the bus: every request adds retryBudgetRatio()
+* retries to the budget of its device, up to retryBudgetMaximum(), and every retry takes one. A failure that finds the
+* budget empty is returned as it is. Budgets start full.
+*
+* Every retry is announced by the retrying() signal and counted in the statistics, in total and per device.
+*
+* The transport has to stay valid as long as the client exists. Like the transports, the client is used by one thread
+* at a time; the statistics can be read from any thread.
+* \headerfile qmodbusretryclient.h QModbusRetryClient
+*/
+class QModbusRetryClient : public QObject , public QAbstractModbus
+{
+    Q_OBJECT
+
+public:
+    /*!
+    * Retry statistics.
+    */
+    struct Statistics
+    {
+        Statistics( void ) : requests( 0 ) , retries( 0 ) , crcRetries( 0 ) , timeoutRetries( 0 ) , busyRetries( 0 ) ,
+                             recovered( 0 ) , exhausted( 0 ) , budgetExhausted( 0 ) {}
+
+        quint64 requests;           //!< Requests executed.
+        quint64 retries;            //!< Retries sent.
+        quint64 crcRetries;         //!< Retries after CrcError.
+        quint64 timeoutRetries;     //!< Retries after Timeout.
+        quint64 busyRetries;        //!< Retries after SlaveDeviceBusy or Acknowledge.
+        quint64 recovered;          //!< Requests that succeeded after one or more retries.
+        quint64 exhausted;          //!< Requests that still failed after the last retry.
+        quint64 budgetExhausted;    //!< Retries not sent because the budget of the device was empty.
+    };
+
+    /*!
+    * Constructor.
+    * \param modbus The transport.
+    * \param parent Parent object.
+    */
+    explicit QModbusRetryClient( QAbstractModbus &modbus , QObject *parent = NULL );
+
+    //! Sets the largest number of retries of a request [0..16], default 3.
+    void setMaximumRetries( const int retries );
+
+    //! Returns the largest number of retries of a request.
+    int maximumRetries( void ) const;
+
+    //! Sets the delay before the first retry after a Timeout in milliseconds, default 50.
+    void setTimeoutBackoff( const int msecs );
+
+    //! Returns the delay before the first retry after a Timeout in milliseconds.
+    int timeoutBackoff( void ) const;
+
+    //! Sets the delay before the first retry after SlaveDeviceBusy or Acknowledge in milliseconds, default 200.
+    void setBusyDelay( const int msecs );
+
+    //! Returns the delay before the first retry after SlaveDeviceBusy or Acknowledge in milliseconds.
+    int busyDelay( void ) const;
+
+    //! Sets the longest delay before a retry in milliseconds, default 2000.
+    void setMaximumDelay( const int msecs );
+
+    //! Returns the longest delay before a retry in milliseconds.
+    int maximumDelay( void ) const;
+
+    /*!
+    * Sets the retry budget of the devices.
+    * \param ratio Retries each request adds to the budget of its device, default 0.1.
+    * \param maximum Largest budget of a device in retries, default 10.
+    */
+    void setRetryBudget( const double ratio , const int maximum );
+
+    //! Returns the retries each request adds to the budget of its device.
+    double retryBudgetRatio( void ) const;
+
+    //! Returns the largest budget of a device in retries.
+    int retryBudgetMaximum( void ) const;
+
+    //! Returns the retries left in the budget of a device.
+    double retryBudget( const quint8 deviceAddress ) const;
+
+    //! Returns the statistics of all devices.
+    Statistics statistics( void ) const;
+
+    //! Returns the statistics of a device.
+    Statistics statistics( const quint8 deviceAddress ) const;
+
+    //! Resets the statistics of all devices.
+    void resetStatistics( void );
+
+    /*!
+    * Executes a request and retries it as described above.
+    * \param request The request.
+    * \return The response of the last attempt.
+    */
+    QModbusResponse execute( const QModbusRequest &request ) const;
+
+    // Interface implementation (QAbstractModbus).
+    bool isOpen( void ) const;
+
+    // Interface implementation (QAbstractModbus).
+    unsigned int timeout( void ) const;
+
+    // Interface implementation (QAbstractModbus).
+    void setTimeout( const unsigned int timeout );
+
+    // Interface implementation (QAbstractModbus).
+    QList<bool> readCoils( const quint8 deviceAddress ,
+                           const quint16 startingAddress ,
+                           const quint16 quantityOfCoils ,
+                           quint8 *const status = NULL
+                         ) const;
+
+    // Interface implementation (QAbstractModbus).
+    QList<bool> readDiscreteInputs( const quint8 deviceAddress ,
+                                    const quint16 startingAddress ,
+                                    const quint16 quantityOfInputs ,
+                                    quint8 *const status = NULL
+                                  ) const;
+
+    // Interface implementation (QAbstractModbus).
+    QList<quint16> readHoldingRegisters( const quint8 deviceAddress ,
+                                         const quint16 startingAddress ,
+                                         const quint16 quantityOfRegisters ,
+                                         quint8 *const status = NULL
+                                       ) const;
+
+    // Interface implementation (QAbstractModbus).
+    QList<quint16> readInputRegisters( const quint8 deviceAddress ,
+                                       const quint16 startingAddress ,
+                                       const quint16 quantityOfInputRegisters ,
+                                       quint8 *const status = NULL
+                                     ) const;
+
+    // Interface implementation (QAbstractModbus).
+    bool writeSingleCoil( const quint8 deviceAddress ,
+                          const quint16 outputAddress ,
+                          const bool outputValue ,
+                          quint8 *const status = NULL
+                        ) const;
+
+    // Interface implementation (QAbstractModbus).
+    bool writeSingleRegister( const quint8 deviceAddress ,
+                              const quint16 registerAddress ,
+                              const quint16 registerValue ,
+                              quint8 *const status = NULL
+                            ) const;
+
+    // Interface implementation (QAbstractModbus).
+    bool writeMultipleCoils( const quint8 deviceAddress ,
+                             const quint16 startingAddress ,
+                             const QList<bool> & outputValues ,
+                             quint8 *const status = NULL
+                           ) const;
+
+    // Interface implementation (QAbstractModbus).
+    bool writeMultipleRegisters( const quint8 deviceAddress ,
+                                 const quint16 startingAddress ,
+                                 const QList<quint16> & registersValues ,
+                                 quint8 *const status = NULL
+                               ) const;
+
+    // Interface implementation (QAbstractModbus).
+    bool maskWriteRegister( const quint8 deviceAddress ,
+                            const quint16 referenceAddress ,
+                            const quint16 andMask ,
+                            const quint16 orMask ,
+                            quint8 *const status = NULL
+                          ) const;
+
+    // Interface implementation (QAbstractModbus).
+    QList<quint16> writeReadMultipleRegisters( const quint8 deviceAddress ,
+                                               const quint16 writeStartingAddress ,
+                                               const QList<quint16> & writeValues ,
+                                               const quint16 readStartingAddress ,
+                                               const quint16 quantityToRead ,
+                                               quint8 *const status = NULL
+                                             ) const;
+
+    // Interface implementation (QAbstractModbus).
+    QList<quint16> readFifoQueue( const quint8 deviceAddress ,
+                                  const quint16 fifoPointerAddress ,
+                                  quint8 *const status = NULL
+                                ) const;
+
+    // Interface implementation (QAbstractModbus).
+    QByteArray executeCustomFunction( const quint8 deviceAddress , const quint8 modbusFunction ,
+                                      QByteArray &data , quint8 *const status = NULL ) const;
+
+    // Interface implementation (QAbstractModbus).
+    bool executePdu( const quint8 deviceAddress , const QModbusFrameView &request , QModbusPduFrame &response ,
+                     quint8 *const status = NULL ) const;
+
+    // Interface implementation (QAbstractModbus), the batch goes to the transport as it is, the failed requests are
+    // retried one by one.
+    QList<QModbusResponse> execute( const QList<QModbusRequest> &batch ) const;
+
+    // Interface implementation (QAbstractModbus), raw data is never retried.
+    QByteArray executeRaw( QByteArray &data , quint8 *const status = NULL ) const;
+
+    // Interface implementation (QAbstractModbus).
+    QByteArray calculateCheckSum( QByteArray &data ) const;
+
+signals:
+    /*!
+    * This signal is emitted before each retry.
+    * \param deviceAddress Address of the device.
+    * \param functionCode Function code of the request.
+    * \param status Status of the failed attempt.
+    * \param retry Number of the retry, 1 for the first.
+    * \param delay Milliseconds the retry waits before it is sent.
+    */
+    void retrying( int deviceAddress , int functionCode , int status , int retry , int delay );
+
+    /*!
+    * This signal is emitted if a failed request is not retried because the budget of its device is empty.
+    * \param deviceAddress Address of the device.
+    */
+    void retryBudgetExhausted( int deviceAddress );
+
+private:
+    Q_DISABLE_COPY( QModbusRetryClient )
+
+    enum
+    {
+        MaxRetries = 16 ,           // Upper bound of maximumRetries().
+        PollInterval = 10           // Interval of the checks of the cancellation token while waiting.
+    };
+
+    struct Device
+    {
+        Device( const double maximum = 0 ) : budget( maximum ) {}
+
+        double budget;              // Retries left.
+        Statistics statistics;      // Statistics of the device.
+    };
+
+    // Retries a failed request, returns the final response.
+    QModbusResponse _retry( const QModbusRequest &request , QModbusResponse response ) const;
+
+    // Returns the device entry, created with a full budget. The caller holds _mutex.
+    Device &_device( const quint8 deviceAddress ) const;
+
+    // Waits before a retry, returns false if the request was cancelled or expired meanwhile.
+    static bool _wait( const int msecs , const QModbusRequest &request );
+
+    // Returns true if a request failed with the status can be retried.
+    static bool _isRetryable( const quint8 functionCode , const quint8 status );
+
+    QAbstractModbus &_modbus;       // The transport.
+    int _maximumRetries;            // Retries per request.
+    int _timeoutBackoff;            // First delay after a Timeout.
+    int _busyDelay;                 // First delay after SlaveDeviceBusy or Acknowledge.
+    int _maximumDelay;              // Longest delay.
+    double _budgetRatio;            // Retries added to a budget per request.
+    int _budgetMaximum;             // Largest budget.
+    mutable QMutex _mutex;          // Protects the devices.
+    mutable QHash<quint8,Device> _devices;  // Budgets and statistics by device address.
+};
@@ -0,0 +1,430 @@
+/***********************************************************************************************************************
+* QModbusSharedConnection : One modbus connection shared by any number of threads.                                    *
+************************************************************************************************************************
+* Author : QModbus contributors                                                                                        *
+* Date   : 2026/10/18                                                                                                  *
+* Changes: -                                                                                                           *
+***********************************************************************************************************************/
+#pragma once
+
+
+/*** Base classes *****************************************************************************************************/
+#include <QtCore/QObject>
+#include <QAbstractModbus>
+
+
+/*** Qt includes & prototypes *****************************************************************************************/
+#include <QModbusMpscQueue>
+#include <QModbusRateLimiter>
+#include <QModbusRequest>
+#include <QtCore/QAtomicInt>
+#include <QtCore/QByteArray>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QHash>
+#include <QtCore/QList>
+#include <QtCore/QMutex>
+#include <QtCore/QSemaphore>
+#include <QtCore/QSharedPointer>
+#include <QtCore/QThread>
+class QModbusSharedConnection;
+
+
+/*** QModbusReply class declaration and help **************************************************************************/
+/*!
+* A reply tracks a request submitted to a QModbusSharedConnection. It is created by QModbusSharedConnection::submit()
+* and completed by the I/O thread of the connection. Any thread can check or wait for the completion, the response is
+* valid once the reply is finished. Replies are shared pointers, so a caller can drop a reply it is not interested in.
+* \headerfile qmodbussharedconnection.h QModbusSharedConnection
+*/
+class QModbusReply : public QModbusMpscNode
+{
+public:
+    /*!
+    * Completion handler (see QModbusSharedConnection::submit()).
+    * \param response The response.
+    * \param context The context given when the request was submitted.
+    */
+    typedef void (*Handler)( const QModbusResponse &response , void *context );
+
+    //! Returns the identifier of the reply, passed by QModbusSharedConnection::replyFinished().
+    int id( void ) const;
+
+    //! Returns the request.
+    const QModbusRequest &request( void ) const;
+
+    //! Returns true if the request was executed (or failed).
+    bool isFinished( void ) const;
+
+    /*!
+    * Blocks until the request was executed.
+    * \param msecs Maximal time to wait in milliseconds, -1 to wait forever.
+    * \return True if the reply is finished, false if the time elapsed.
+    */
+    bool waitForFinished( const int msecs = -1 );
+
+    //! Returns the response, status QAbstractModbus::UnknownError as long as the reply is not finished.
+    QModbusResponse response( void ) const;
+
+    //! Returns how long the request was queued before it was handed to the transport, in milliseconds.
+    int queueTime( void ) const;
+
+private:
+    friend class QModbusSharedConnection;
+
+    // Constructs a reply (see QModbusSharedConnection::submit()).
+    QModbusReply( const int id , const QModbusRequest &request );
+
+    // Stores the response, wakes up the waiting threads and calls the completion handler.
+    void _finish( const QModbusResponse &response );
+
+    const int _id;                  // Identifier.
+    const QModbusRequest _request;  // The request.
+    QModbusResponse _response;      // The response, written once by the I/O thread before _finished is set.
+    mutable QAtomicInt _finished;   // 1 once the response is available.
+    QSemaphore _done;               // Released once the response is available.
+    QSharedPointer<QModbusReply> _self; // Keeps the reply alive while the connection holds it.
+    QByteArray _raw;                // Data of a raw request (see QModbusSharedConnection::executeRaw()).
+    bool _isRaw;                    // True if the request is a raw request.
+    Handler _handler;               // Completion handler or NULL.
+    void *_context;                 // Context passed to the completion handler.
+    QElapsedTimer _queued;          // Started when the request is queued.
+    int _queueTime;                 // Time in the queue, set by the I/O thread before the request is executed.
+    qint64 _due;                    // Time the rate limiter releases a held request (I/O thread clock).
+    bool _reserved;                 // True once the request was reserved with the rate limiter.
+};
+
+//! Shared pointer to a reply.
+typedef QSharedPointer<QModbusReply> QModbusReplyPointer;
+
+
+/*** QModbusSharedConnection class declaration and help ***************************************************************/
+/*!
+* The shared connection lets any number of threads use one modbus connection concurrently. The connection owns a
+* dedicated I/O thread which is the only thread that touches the transport. Threads submit requests into a lock-free
+* multi-producer single-consumer queue (see QModbusMpscQueue), which neither blocks nor takes a lock, and the I/O
+* thread executes them in the order they were submitted within their priority class. The queued requests of a class
+* are handed to the transport as one batch (see QAbstractModbus::execute()), so requests of concurrent threads are
+* pipelined on modbus TCP.
+*
+* The I/O thread sorts the queued requests by priority class (see QModbusRequest::Priority) and always executes the
+* oldest requests of the highest class present next. Bulk requests are executed one at a time, so they never hold back
+* another class for more than one frame. On a serial bus, setPreemptive() does the same for all classes below Control:
+* operator commands reach the wire within one frame time while the polling continues in between. The time requests
+* wait in the queue is measured per class (queueStatistics()).
+*
+* Requests the rate limiter holds back (setRateLimiter()) are parked per unit, in order, until the limiter releases
+* them; the I/O thread never sleeps for them but goes on with the requests of the other units and classes.
+*
+* A request can be submitted asynchronously with submit(): the caller gets a QModbusReply it can wait on, and the
+* replyFinished() signal is emitted once the reply is finished. execute() and the QAbstractModbus interface are blocking
+* and can be called from any thread, so a shared connection can replace a transport in any code using QAbstractModbus.
+*
+* If the transport is a QObject (QTcpModbus), it is moved to the I/O thread: it has to be connected before the shared
+* connection is created and must not be used directly while the shared connection exists. The transport has to stay
+* valid as long as the shared connection exists. Requests still queued when the shared connection is destroyed fail
+* with NoConnection, no thread may submit requests while the destructor runs. A transport that lost its connection can
+* be reconnected by a QModbusReconnectManager while the shared connection holds the requests (setReconnectTimeout()).
+* \headerfile qmodbussharedconnection.h QModbusSharedConnection
+*/
+class QModbusSharedConnection : public QObject , public QAbstractModbus
+{
+    Q_OBJECT
+
+public:
+    /*!
+    * Constructor, starts the I/O thread.
+    * \param modbus The transport to share.
+    * \param parent Parent object.
+    */
+    explicit QModbusSharedConnection( QAbstractModbus &modbus , QObject *parent = NULL );
+
+    /*!
+    * Destructor, stops the I/O thread.
+    */
+    virtual ~QModbusSharedConnection();
+
+    /*!
+    * Submits a request, can be called from any thread and never blocks.
+    * \param request The request.
+    * \return The reply, finished with IllegalDataValue if the request is invalid.
+    */
+    QModbusReplyPointer submit( const QModbusRequest &request ) const;
+
+    /*!
+    * Submits a request with a completion handler, can be called from any thread and never blocks.
+    * \param request The request.
+    * \param handler Called once the reply is finished, usually by the I/O thread: the handler must not block and must
+    *                not call the blocking methods of the connection. It is called by the submitting thread before
+    *                submit() returns if the request is invalid or the connection is stopping.
+    * \param context Passed to the handler.
+    * \return The reply.
+    */
+    QModbusReplyPointer submit( const QModbusRequest &request , const QModbusReply::Handler handler ,
+                                void *const context ) const;
+
+    /*!
+    * Submits a request and waits for the response, can be called from any thread.
+    * \param request The request.
+    * \return The response.
+    */
+    QModbusResponse execute( const QModbusRequest &request ) const;
+
+    //! Returns the number of requests submitted but not finished yet.
+    int pendingCount( void ) const;
+
+    /*!
+    * Sets how long queued requests are held while the transport is not open, waiting for it to reconnect (see
+    * QModbusReconnectManager). Meanwhile the I/O thread processes its events, so a reconnect of the transport
+    * progresses. Requests still waiting after the timeout fail with NoConnection. Default is 0: requests fail right
+    * away if the transport is not open.
+    * \param msecs Timeout in milliseconds.
+    */
+    void setReconnectTimeout( const int msecs );
+
+    //! Returns how long queued requests are held while the transport is not open, in milliseconds.
+    int reconnectTimeout( void ) const;
+
+    /*!
+    * Sets whether the requests below Control are executed one at a time. The highest class present is picked again
+    * after each frame, so a control request never waits for more than the frame on the bus. Meant for serial buses,
+    * which execute a batch frame after frame anyway; on modbus TCP it gives up the pipelining. Default is false.
+    * \param preemptive True to execute the requests below Control one at a time.
+    */
+    void setPreemptive( const bool preemptive );
+
+    //! Returns true if the requests below Control are executed one at a time.
+    bool isPreemptive( void ) const;
+
+    /*!
+    * Queue wait times of a priority class.
+    */
+    struct QueueStatistics
+    {
+        QueueStatistics( void ) : count( 0 ) , totalWait( 0 ) , maximumWait( 0 ) {}
+
+        int count;                  //!< Number of requests handed to the transport.
+        qint64 totalWait;           //!< Sum of their times in the queue in milliseconds.
+        int maximumWait;            //!< Longest time in the queue in milliseconds.
+    };
+
+    /*!
+    * Returns the queue wait times of a priority class since the connection was created or the statistics were reset.
+    * \param priority The priority class.
+    * \return The statistics of the class.
+    */
+    QueueStatistics queueStatistics( const QModbusRequest::Priority priority ) const;
+
+    //! Resets the queue wait times of all priority classes.
+    void resetQueueStatistics( void );
+
+    /*!
+    * Sets the rate limiter the I/O thread reserves each request with before handing it to the transport (see
+    * QModbusRateLimiter). Set it before submitting requests; the limiter has to stay valid as long as the shared
+    * connection exists and can be shared by several connections.
+    * \param limiter The rate limiter, NULL for none (default).
+    */
+    void setRateLimiter( QModbusRateLimiter *const limiter );
+
+    //! Returns the rate limiter, NULL if none.
+    QModbusRateLimiter *rateLimiter( void ) const;
+
+    // Interface implementation (QAbstractModbus), the state the I/O thread saw last: it is updated before and after
+    // each batch and while waiting for the transport to reconnect.
+    bool isOpen( void ) const;
+
+    // Interface implementation (QAbstractModbus), the timeout set last.
+    unsigned int timeout( void ) const;
+
+    // Interface implementation (QAbstractModbus), applies to the next request the I/O thread starts.
+    void setTimeout( const unsigned int timeout );
+
+    // Interface implementation (QAbstractModbus).
+    QList<bool> readCoils( const quint8 deviceAddress ,
+                           const quint16 startingAddress ,
+                           const quint16 quantityOfCoils ,
+                           quint8 *const status = NULL
+                         ) const;
+
+    // Interface implementation (QAbstractModbus).
+    QList<bool> readDiscreteInputs( const quint8 deviceAddress ,
+                                    const quint16 startingAddress ,
+                                    const quint16 quantityOfInputs ,
+                                    quint8 *const status = NULL
+                                  ) const;
+
+    // Interface implementation (QAbstractModbus).
+    QList<quint16> readHoldingRegisters( const quint8 deviceAddress ,
+                                         const quint16 startingAddress ,
+                                         const quint16 quantityOfRegisters ,
+                                         quint8 *const status = NULL
+                                       ) const;
+
+    // Interface implementation (QAbstractModbus).
+    QList<quint16> readInputRegisters( const quint8 deviceAddress ,
+                                       const quint16 startingAddress ,
+                                       const quint16 quantityOfInputRegisters ,
+                                       quint8 *const status = NULL
+                                     ) const;
+
+    // Interface implementation (QAbstractModbus).
+    bool writeSingleCoil( const quint8 deviceAddress ,
+                          const quint16 outputAddress ,
+                          const bool outputValue ,
+                          quint8 *const status = NULL
+                        ) const;
+
+    // Interface implementation (QAbstractModbus).
+    bool writeSingleRegister( const quint8 deviceAddress ,
+                              const quint16 registerAddress ,
+                              const quint16 registerValue ,
+                              quint8 *const status = NULL
+                            ) const;
+
+    // Interface implementation (QAbstractModbus).
+    bool writeMultipleCoils( const quint8 deviceAddress ,
+                             const quint16 startingAddress ,
+                             const QList<bool> & outputValues ,
+                             quint8 *const status = NULL
+                           ) const;
+
+    // Interface implementation (QAbstractModbus).
+    bool writeMultipleRegisters( const quint8 deviceAddress ,
+                                 const quint16 startingAddress ,
+                                 const QList<quint16> & registersValues ,
+                                 quint8 *const status = NULL
+                               ) const;
+
+    // Interface implementation (QAbstractModbus).
+    bool maskWriteRegister( const quint8 deviceAddress ,
+                            const quint16 referenceAddress ,
+                            const quint16 andMask ,
+                            const quint16 orMask ,
+                            quint8 *const status = NULL
+                          ) const;
+
+    // Interface implementation (QAbstractModbus).
+    QList<quint16> writeReadMultipleRegisters( const quint8 deviceAddress ,
+                                               const quint16 writeStartingAddress ,
+                                               const QList<quint16> & writeValues ,
+                                               const quint16 readStartingAddress ,
+                                               const quint16 quantityToRead ,
+                                               quint8 *const status = NULL
+                                             ) const;
+
+    // Interface implementation (QAbstractModbus).
+    QList<quint16> readFifoQueue( const quint8 deviceAddress ,
+                                  const quint16 fifoPointerAddress ,
+                                  quint8 *const status = NULL
+                                ) const;
+
+    // Interface implementation (QAbstractModbus).
+    QByteArray executeCustomFunction( const quint8 deviceAddress , const quint8 modbusFunction ,
+                                      QByteArray &data , quint8 *const status = NULL ) const;
+
+    // Interface implementation (QAbstractModbus).
+    bool executePdu( const quint8 deviceAddress , const QModbusFrameView &request , QModbusPduFrame &response ,
+                     quint8 *const status = NULL ) const;
+
+    // Interface implementation (QAbstractModbus), the requests are queued together and pipelined on modbus TCP.
+    QList<QModbusResponse> execute( const QList<QModbusRequest> &batch ) const;
+
+    // Interface implementation (QAbstractModbus), executed by the I/O thread like any other request.
+    QByteArray executeRaw( QByteArray &data , quint8 *const status = NULL ) const;
+
+    // Interface implementation (QAbstractModbus).
+    QByteArray calculateCheckSum( QByteArray &data ) const;
+
+signals:
+    /*!
+    * This signal is emitted by the I/O thread each time a reply is finished.
+    * \param id Identifier of the reply (see QModbusReply::id()).
+    */
+    void replyFinished( int id );
+
+private:
+    Q_DISABLE_COPY( QModbusSharedConnection )
+
+    // The I/O thread, the only thread using the transport.
+    class IoThread : public QThread
+    {
+    public:
+        explicit IoThread( QModbusSharedConnection &connection ) : _connection( connection ) {}
+
+        // QThread::msleep() is protected with Qt 4.
+        static void pause( const unsigned long msecs ) { msleep( msecs ); }
+
+    protected:
+        void run( void ) { _connection._run(); }
+
+    private:
+        QModbusSharedConnection &_connection;
+    };
+
+    enum
+    {
+        MaxBatchSize = 64 ,         // Largest number of requests handed to the transport at once.
+        PollInterval = 20           // Interval of event processing while waiting for the transport to reconnect.
+    };
+
+    // I/O thread: executes the queued requests.
+    void _run( void );
+
+    // Queues a reply for the I/O thread, fails it if the connection is stopping.
+    void _enqueue( const QModbusReplyPointer &reply ) const;
+
+    // Sorts the queued requests into the lanes by priority class.
+    void _sort( void );
+
+    // Removes a request counted by _queued from the queue, waits for its producer to complete the push.
+    QModbusReply *_pop( void );
+
+    // Holds the I/O thread while the transport is not open, up to the reconnect timeout, sorting the requests that
+    // arrive meanwhile into the lanes.
+    void _waitForTransport( void );
+
+    // Takes the next requests to execute from the lanes: the oldest of the highest class present.
+    QList<QModbusReply *> _take( void );
+
+    // Executes the requests taken from the queue, as batches separated by the raw requests. Parks the requests the
+    // rate limiter holds back.
+    void _execute( const QList<QModbusReply *> &replies );
+
+    // Parks a request behind the parked requests of its unit, for at least the given milliseconds.
+    void _park( QModbusReply *const reply , const int wait );
+
+    // Moves the parked requests that are due back to the front of their lanes.
+    void _unpark( void );
+
+    // Returns the milliseconds until the next parked request is due, -1 if none is parked.
+    int _parkedWait( void ) const;
+
+    // Applies a timeout set by setTimeout() to the transport and publishes whether the transport is open. Only the I/O
+    // thread calls the transport, so other threads never see it in the middle of a request.
+    void _refresh( void );
+
+    // Accounts the time a request waited before it is handed to the transport.
+    void _account( QModbusReply *const reply );
+
+    // Finishes a reply and releases the reference the queue held.
+    void _finish( QModbusReply *const reply , const QModbusResponse &response ) const;
+
+    QAbstractModbus &_modbus;       // The transport, only used by the I/O thread.
+    mutable QModbusMpscQueue<QModbusReply> _queue;  // Submitted requests.
+    mutable QSemaphore _queued;     // Number of requests in the queue, wakes up the I/O thread.
+    mutable QAtomicInt _pending;    // Number of requests submitted but not finished.
+    mutable QAtomicInt _nextId;     // Identifier of the next reply.
+    mutable QAtomicInt _stopping;   // 1 once the destructor was called.
+    mutable QAtomicInt _reconnectTimeout;   // How long requests are held while the transport is not open.
+    mutable QAtomicInt _preemptive; // 1 if the requests below Control are executed one at a time.
+    mutable QAtomicInt _open;       // 1 if the transport is open, updated by the I/O thread.
+    mutable QAtomicInt _timeout;    // Timeout of the transport in milliseconds.
+    mutable QAtomicInt _timeoutChanged; // 1 if the I/O thread has to apply _timeout to the transport.
+    QList<QModbusReply *> _lanes[QModbusRequest::PriorityCount];   // Requests taken from the queue, by priority.
+    int _held;                      // Number of requests in the lanes.
+    QHash<quint8,QList<QModbusReply *> > _parked;   // Requests held back by the rate limiter, by unit, oldest first.
+    QElapsedTimer _clock;           // I/O thread clock of the parked requests.
+    mutable QMutex _statisticsMutex;    // Protects the statistics.
+    QueueStatistics _statistics[QModbusRequest::PriorityCount];     // Queue wait times by priority.
+    QModbusRateLimiter *_rateLimiter;   // Rate limiter or NULL.
+    IoThread _thread;               // The I/O thread.
+};
@@ -0,0 +1,106 @@
+/***********************************************************************************************************************
+* QModbusStripedReader : Snapshots of large register ranges, read in blocks spread over several connections.          *
+************************************************************************************************************************
+* Author : QModbus contributors                                                                                        *
+* Date   : 2026/10/18                                                                                                  *
+* Changes: -                                                                                                           *
+***********************************************************************************************************************/
+#pragma once
+
+
+/*** Qt includes & prototypes *****************************************************************************************/
+#include <QAbstractModbus>
+#include <QModbusSharedConnection>
+#include <QtCore/QList>
+#include <QtCore/QVector>
+
+
+/*** QModbusStripedReader class declaration and help ******************************************************************/
+/*!
+* The striped reader takes snapshots of register ranges larger than a single request can read. The range is split into
+* blocks of blockSize() registers (125 by default, the most a read request can fetch) which are spread round robin over
+* several connections to the same device. Each connection is executed by its own QModbusSharedConnection, which
+* pipelines the blocks queued on it (modbus TCP), so the blocks are read in parallel on all connections and the time of
+* a snapshot is bounded by the throughput of the device rather than by the round trip time times the number of blocks.
+*
+* The blocks are decoded into one contiguous buffer. The status of every block can be requested; the registers of a
+* block that failed are zero.
+*
+* Typically the connections are several QTcpModbus connected to the same device. The transports have to be open and
+* stay valid as long as the reader exists. The reader itself can be used from any thread.
+* \headerfile qmodbusstripedreader.h QModbusStripedReader
+*/
+class QModbusStripedReader
+{
+public:
+    /*!
+    * Status of a block of a snapshot.
+    */
+    struct Block
+    {
+        quint16 startingAddress;    //!< Address of the first register of the block.
+        quint16 quantity;           //!< Number of registers of the block.
+        quint8 status;              //!< Status of the read (see QAbstractModbus::Status).
+    };
+
+    /*!
+    * Constructor.
+    * \param connections The transports to read through, all connected to the same device.
+    */
+    explicit QModbusStripedReader( const QList<QAbstractModbus *> &connections );
+
+    /*!
+    * Destructor, stops the I/O threads of the connections.
+    */
+    ~QModbusStripedReader();
+
+    //! Returns the number of connections.
+    int connectionCount( void ) const;
+
+    //! Returns the number of registers per block, default 125.
+    int blockSize( void ) const;
+
+    //! Changes the number of registers per block [1..125].
+    void setBlockSize( const int size );
+
+    /*!
+    * Reads a range of holding registers.
+    * \param deviceAddress Address of the device.
+    * \param startingAddress Address of the first register.
+    * \param quantity Number of registers, the range must not exceed the address space.
+    * \param blocks If not NULL, receives the status of every block.
+    * \param status If not NULL, receives Ok or the status of the first block that failed.
+    * \return The registers, zero where a block failed. Empty if the range is invalid.
+    */
+    QVector<quint16> readHoldingRegisters( const quint8 deviceAddress , const quint16 startingAddress ,
+                                           const int quantity , QList<Block> *const blocks = NULL ,
+                                           quint8 *const status = NULL ) const;
+
+    /*!
+    * Reads a range of input registers.
+    * \param deviceAddress Address of the device.
+    * \param startingAddress Address of the first register.
+    * \param quantity Number of registers, the range must not exceed the address space.
+    * \param blocks If not NULL, receives the status of every block.
+    * \param status If not NULL, receives Ok or the status of the first block that failed.
+    * \return The registers, zero where a block failed. Empty if the range is invalid.
+    */
+    QVector<quint16> readInputRegisters( const quint8 deviceAddress , const quint16 startingAddress ,
+                                         const int quantity , QList<Block> *const blocks = NULL ,
+                                         quint8 *const status = NULL ) const;
+
+private:
+    Q_DISABLE_COPY( QModbusStripedReader )
+
+    enum
+    {
+        MaxBlockSize = 125          // Most registers a read request can fetch.
+    };
+
+    // Reads a range of registers with the given function code.
+    QVector<quint16> _read( const quint8 deviceAddress , const quint8 functionCode , const quint16 startingAddress ,
+                            const int quantity , QList<Block> *const blocks , quint8 *const status ) const;
+
+    QList<QModbusSharedConnection *> _connections;  // The connections, one I/O thread each.
+    int _blockSize;                 // Registers per block.
+};
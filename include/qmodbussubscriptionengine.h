@@ -0,0 +1,202 @@
+/***********************************************************************************************************************
+* QModbusSubscriptionEngine : Merges the periodic polls of many subscribers into as few requests as possible.          *
+************************************************************************************************************************
+* Author : QModbus contributors                                                                                        *
+* Date   : 2026/10/18                                                                                                  *
+* Changes: -                                                                                                           *
+***********************************************************************************************************************/
+#pragma once
+
+
+/*** Base classes *****************************************************************************************************/
+#include <QtCore/QObject>
+
+
+/*** Qt includes & prototypes *****************************************************************************************/
+#include <QAbstractModbus>
+#include <QModbusListener>
+#include <QModbusChangeFilter>
+#include <QModbusCapabilityCache>
+#include <QtCore/QList>
+#include <QtCore/QHash>
+#include <QtCore/QTimer>
+#include <QtCore/QElapsedTimer>
+
+
+/*** QModbusSubscriptionEngine class declaration and help *************************************************************/
+/*!
+* The subscription engine polls address ranges of one modbus connection on behalf of many application modules. Each
+* module subscribes to a range of a table of a device (unit) with its own period and gets the data through a
+* QModbusListener.
+*
+* For every (device, table, period) the engine keeps an interval index of the subscribed ranges: a list of poll blocks
+* sorted by their starting address, where each block covers overlapping or adjacent subscriptions up to the maximal
+* block size modbus allows for the table. Adding or removing a subscription only touches the blocks its range
+* overlaps, the rest of the plan is kept as is. When blocks of different periods are due at the same moment and
+* overlap, they are fetched using a single request as well, and the result is fanned out to all their subscribers.
+*
+* A subscription can be switched to change-only delivery using setChangeFilter(): each new sample is compared against
+* the last reported one and the listener is only notified if values changed (or moved out of the deadband), together
+* with the indices of the changed values. Failed polls are always reported.
+*
+* Devices accepting less than the modbus limits per request are handled using setCapabilities(): the blocks are then
+* limited to the largest quantity learned for the device (see QModbusCapabilityProber).
+*
+* The engine is driven by a single shot timer and so needs a running event loop. The modbus accesses are blocking and
+* are done in the thread the engine lives in.
+* \headerfile qmodbussubscriptionengine.h QModbusSubscriptionEngine
+*/
+class QModbusSubscriptionEngine : public QObject
+{
+    Q_OBJECT
+
+public:
+    /*!
+    * Constructor.
+    * \param modbus The modbus connection to poll. It has to stay valid as long as the engine exists.
+    * \param parent The parent object.
+    */
+    explicit QModbusSubscriptionEngine( const QAbstractModbus &modbus , QObject *parent = NULL );
+
+    /*!
+    * Destructor.
+    */
+    virtual ~QModbusSubscriptionEngine();
+
+    /*!
+    * Adds a subscription. The range is polled for the first time at the next timer tick.
+    * \param deviceAddress Address of the slave device [1..247].
+    * \param table The table to poll.
+    * \param startingAddress Address of the first coil, input or register [0..65535].
+    * \param quantity Number of coils, inputs or registers [1..2000] for bits, [1..125] for registers, at most the
+    *                 maximum learned for the device (see setCapabilities()).
+    * \param period Poll period in milliseconds.
+    * \param listener Listener to notify each time the range was polled. Not owned by the engine.
+    * \return The subscription identifier (always positive) or -1 if the parameters are invalid.
+    */
+    int subscribe( const quint8 deviceAddress , const QAbstractModbus::Table table , const quint16 startingAddress ,
+                   const quint16 quantity , const int period , QModbusListener *const listener );
+
+    /*!
+    * Removes a subscription. The listener will not be called anymore for this subscription.
+    * \param id The identifier returned by subscribe().
+    */
+    void unsubscribe( const int id );
+
+    /*!
+    * Enables change-only delivery for a subscription. The next successful poll reports all values as changed.
+    * \param id The identifier returned by subscribe().
+    * \param filter The filter defining the value type and deadband to use.
+    * \return True on success, false if there is no such subscription.
+    */
+    bool setChangeFilter( const int id , const QModbusChangeFilter &filter );
+
+    /*!
+    * Switches a subscription back to delivering every sample.
+    * \param id The identifier returned by subscribe().
+    */
+    void clearChangeFilter( const int id );
+
+    /*!
+    * Sets the capability cache the block sizes are taken from. Subscriptions added before keep their plan.
+    * \param cache The capability cache of the engine's connection, NULL to use the modbus limits. Not owned by the
+    *              engine.
+    */
+    void setCapabilities( QModbusCapabilityCache *const cache );
+
+    //! Returns the capability cache the block sizes are taken from, NULL if none.
+    QModbusCapabilityCache *capabilities( void ) const;
+
+    /*!
+    * Returns the number of active subscriptions.
+    * \return Number of subscriptions.
+    */
+    int subscriptionCount( void ) const;
+
+    /*!
+    * Returns the number of poll blocks of the current plan, which is the number of requests needed if every
+    * subscription is due at a different moment.
+    * \return Number of planned blocks.
+    */
+    int blockCount( void ) const;
+
+    /*!
+    * Starts polling.
+    */
+    void start( void );
+
+    /*!
+    * Stops polling.
+    */
+    void stop( void );
+
+    /*!
+    * Returns true if the engine is polling.
+    * \return True if started.
+    */
+    bool isActive( void ) const;
+
+    /*!
+    * Polls all blocks that are due now and notifies the listeners. This is called by the engine's timer, but can be
+    * called manually if the engine was not started.
+    * \return Number of modbus requests issued.
+    */
+    int processDue( void );
+
+private slots:
+    void _timerExpired( void );
+
+private:
+    struct Subscription
+    {
+        quint8 deviceAddress;
+        QAbstractModbus::Table table;
+        quint16 startingAddress;
+        quint16 quantity;
+        int period;
+        QModbusListener *listener;
+    };
+
+    struct Block
+    {
+        quint32 start;                      // First address of the block.
+        quint32 end;                        // First address after the block.
+        QList<int> subscriptions;           // Identifiers of the subscriptions covered by the block.
+    };
+
+    struct Group
+    {
+        qint64 nextDue;                     // Time the group's blocks have to be polled next (engine clock).
+        quint32 maximum;                    // Largest block of the group, fixed when the group is created.
+        QList<Block> blocks;                // Interval index, sorted by the starting address of the blocks.
+    };
+
+    // Orders blocks by their starting address.
+    static bool _startsBefore( const Block &block , const quint32 address );
+    static bool _lessThan( const Block &a , const Block &b );
+
+    // Builds the key of a (device, table, period) group.
+    static quint64 _groupKey( const quint8 deviceAddress , const QAbstractModbus::Table table , const int period );
+
+    // Maximal number of items a single read request to the device can fetch.
+    quint32 _maximumBlockSize( const quint8 deviceAddress , const QAbstractModbus::Table table ) const;
+
+    // Adds the subscription to the interval index of the group by merging it with the blocks it overlaps.
+    void _insert( Group &group , const int id );
+
+    // Polls the given block and fans out the result to the covered subscriptions.
+    void _poll( const quint8 deviceAddress , const QAbstractModbus::Table table , const Block &block );
+
+    // Restarts the timer for the next due group.
+    void _reschedule( void );
+
+    const QAbstractModbus &_modbus;         // Connection used for polling.
+    QHash<int,Subscription> _subscriptions; // All subscriptions by identifier.
+    QHash<quint64,Group> _groups;           // Poll plan by (device, table, period).
+    QHash<int,QModbusChangeFilter> _filters;// Change filters of the change-only subscriptions.
+    QModbusCapabilityCache *_capabilities;  // Learned block sizes, NULL for the modbus limits.
+    int _nextId;                            // Identifier of the next subscription.
+    bool _active;                           // True if started.
+    QTimer _timer;                          // Single shot timer waking up the engine for the next due group.
+    QElapsedTimer _clock;                   // Monotonic clock the due times are based on.
+};
@@ -0,0 +1,280 @@
+/***********************************************************************************************************************
+* QModbusTopologyCache : Memory mapped file remembering endpoints, units and their capabilities across restarts.       *
+************************************************************************************************************************
+* Author : QModbus contributors                                                                                        *
+* Date   : 2026/10/18                                                                                                  *
+* Changes: -                                                                                                           *
+***********************************************************************************************************************/
+#pragma once
+
+
+/*** Qt includes & prototypes *****************************************************************************************/
+#include <QAbstractModbus>
+#include <QModbusCapabilityCache>
+#include <QtCore/QFile>
+#include <QtCore/QMap>
+#include <QtCore/QMutex>
+#include <QtCore/QSet>
+#include <QtCore/QString>
+#include <QtCore/QStringList>
+
+
+/*** QModbusTopologyCache class declaration and help ******************************************************************/
+/*!
+* The topology cache keeps what a collector learned about its buses across restarts: per endpoint (a modbus TCP host
+* or a serial port, named by the application, for example "plc1.site:502" or "/dev/ttyUSB0") the resolved address of
+* the host, and per unit whether it answers, its round trip time and the capabilities of a QModbusCapabilityCache
+* (supported functions, maximal quantities, address windows).
+*
+* The file is made of fixed size records in host byte order, sorted by endpoint and unit. load() maps it into memory
+* and only checks its header and endpoint records, so loading costs nothing but the page faults of the records used
+* later; lookups are binary searches in the mapped records. Changes are kept in memory per endpoint (the endpoint's
+* records are copied on the first change) until save() writes a new file and maps it instead. The new file is written
+* next to the old one and renamed, so a crash never leaves a truncated cache. A file written on a machine of another
+* byte order or by another version is ignored, the cache then starts empty.
+*
+* Every unit record carries the time it was last verified. Instead of re-probing the site at startup, a collector uses
+* the cached data right away and calls revalidate() from a timer or an idle I/O thread: each call checks a bounded
+* number of units not verified for a given time, so the cache converges in the background while polling runs.
+*
+* Endpoint names are limited to 63 bytes (UTF-8), longer names are not saved. All methods can be called from any
+* thread.
+* \headerfile qmodbustopologycache.h QModbusTopologyCache
+*/
+class QModbusTopologyCache
+{
+public:
+    /*!
+    * Constructor, creates an empty cache.
+    */
+    QModbusTopologyCache( void );
+
+    /*!
+    * Destructor, unmaps the file. Changes not saved are lost.
+    */
+    ~QModbusTopologyCache();
+
+    /*!
+    * Maps a cache file, changes not saved are dropped.
+    * \param fileName The file written using save().
+    * \return True on success, false if the file does not exist or is not a valid cache (the cache is empty then).
+    */
+    bool load( const QString &fileName );
+
+    /*!
+    * Writes the cache to a file, replacing it, and maps the file written.
+    * \param fileName The file to write.
+    * \return True on success. On failure the cache is left unchanged.
+    */
+    bool save( const QString &fileName );
+
+    /*!
+    * Returns the known endpoints.
+    * \return Endpoint names, sorted.
+    */
+    QStringList endpoints( void ) const;
+
+    /*!
+    * Forgets an endpoint and its units.
+    * \param endpoint The endpoint.
+    */
+    void remove( const QString &endpoint );
+
+    /*!
+    * Returns the address an endpoint's host name was resolved to.
+    * \param endpoint The endpoint.
+    * \param resolved If not NULL, receives the time of the resolution (milliseconds since epoch), 0 if unknown.
+    * \return The address as text, empty if unknown.
+    */
+    QString resolvedAddress( const QString &endpoint , qint64 *const resolved = NULL ) const;
+
+    /*!
+    * Sets the address an endpoint's host name was resolved to, now.
+    * \param endpoint The endpoint.
+    * \param address The address as text (IPv4 or IPv6), empty to forget it.
+    */
+    void setResolvedAddress( const QString &endpoint , const QString &address );
+
+    /*!
+    * Returns the units of an endpoint that answered when they were last verified.
+    * \param endpoint The endpoint.
+    * \return Unit IDs, sorted.
+    */
+    QList<quint8> reachableUnits( const QString &endpoint ) const;
+
+    /*!
+    * Returns whether a unit answered when it was last verified.
+    * \param endpoint The endpoint.
+    * \param unitId The unit.
+    * \return True if the unit is known to answer.
+    */
+    bool isReachable( const QString &endpoint , const quint8 unitId ) const;
+
+    /*!
+    * Records whether a unit answers and marks the unit as verified now.
+    * \param endpoint The endpoint.
+    * \param unitId The unit.
+    * \param reachable True if the unit answered.
+    */
+    void setReachable( const QString &endpoint , const quint8 unitId , const bool reachable );
+
+    /*!
+    * Returns the round trip time observed for a unit.
+    * \param endpoint The endpoint.
+    * \param unitId The unit.
+    * \return Microseconds, -1 if unknown.
+    */
+    int roundTripTime( const QString &endpoint , const quint8 unitId ) const;
+
+    /*!
+    * Records a round trip time observed for a unit. The cache keeps a moving average.
+    * \param endpoint The endpoint.
+    * \param unitId The unit.
+    * \param usecs Round trip time in microseconds.
+    */
+    void addRoundTripTime( const QString &endpoint , const quint8 unitId , const int usecs );
+
+    /*!
+    * Returns the time a unit was last verified.
+    * \param endpoint The endpoint.
+    * \param unitId The unit.
+    * \return Milliseconds since epoch, 0 if never.
+    */
+    qint64 lastVerified( const QString &endpoint , const quint8 unitId ) const;
+
+    /*!
+    * Returns the units of an endpoint not verified for some time.
+    * \param endpoint The endpoint.
+    * \param maximumAge Age in milliseconds from which a unit is stale.
+    * \return Unit IDs, least recently verified first.
+    */
+    QList<quint8> staleUnits( const QString &endpoint , const qint64 maximumAge ) const;
+
+    /*!
+    * Fills a capability cache with what is known about the units of an endpoint.
+    * \param endpoint The endpoint.
+    * \param cache The capability cache of the endpoint's connection.
+    */
+    void restore( const QString &endpoint , QModbusCapabilityCache &cache ) const;
+
+    /*!
+    * Takes over what a capability cache learned about the units of an endpoint. Does not change their reachability.
+    * \param endpoint The endpoint.
+    * \param cache The capability cache of the endpoint's connection.
+    */
+    void store( const QString &endpoint , const QModbusCapabilityCache &cache );
+
+    /*!
+    * Verifies the stale units of an endpoint: each one is sent a read of one holding register. A unit that replies,
+    * even with an exception, is reachable and its round trip time is recorded; a unit that does not, or whose gateway
+    * answers with a gateway exception, is unreachable. If the connection fails, the remaining units are left as they
+    * are.
+    * \param endpoint The endpoint.
+    * \param modbus The connection to the endpoint.
+    * \param maximumAge Age in milliseconds from which a unit is stale.
+    * \param maximumUnits The most units to verify in this call.
+    * \return Number of units verified.
+    */
+    int revalidate( const QString &endpoint , const QAbstractModbus &modbus , const qint64 maximumAge ,
+                    const int maximumUnits );
+
+private:
+    Q_DISABLE_COPY( QModbusTopologyCache )
+
+    enum
+    {
+        Magic = 0x514D5443 ,            // "QMTC", start of a cache file.
+        Version = 1 ,                   // Version of the file format.
+        ByteOrderMark = 0x0102 ,        // Reads differently on a machine of another byte order.
+        NameSize = 64 ,                 // Bytes of an endpoint name, including the terminating '\0'.
+        AddressSize = 48 ,              // Bytes of a resolved address, including the terminating '\0'.
+        FunctionBytes = 16 ,            // Bitmap bytes for the function codes 0..127.
+        QuantityFunctions = 8           // Functions with a maximal quantity (see _quantityFunctions).
+    };
+
+    enum UnitFlag
+    {
+        Reachable = 0x01                // The unit answered when it was last verified.
+    };
+
+    // File header.
+    struct Header
+    {
+        quint32 magic;
+        quint16 version;
+        quint16 byteOrder;
+        quint32 endpointCount;
+        quint32 endpointSize;
+        quint32 unitCount;
+        quint32 unitSize;
+        quint32 reserved[2];
+    };
+
+    // Endpoint record, the endpoints are sorted by name.
+    struct Endpoint
+    {
+        char name[NameSize];            // Endpoint name (UTF-8).
+        char address[AddressSize];      // Resolved address, empty if unknown.
+        qint64 resolved;                // Time of the resolution (milliseconds since epoch).
+        quint32 firstUnit;              // Index of the endpoint's first unit record.
+        quint32 unitCount;              // Number of unit records of the endpoint.
+    };
+
+    // Unit record, the units of an endpoint are stored one after the other, sorted by unit ID.
+    struct Unit
+    {
+        qint64 verified;                // Time of the last verification (milliseconds since epoch), 0 if never.
+        qint32 roundTripTime;           // Moving average in microseconds, -1 if unknown.
+        quint8 unitId;                  // Unit ID.
+        quint8 flags;                   // UnitFlag values.
+        quint8 windows;                 // Bit n set if the address window of table n + 1 is known.
+        quint8 reserved;
+        quint8 supported[FunctionBytes];    // Functions known to be supported.
+        quint8 unsupported[FunctionBytes];  // Functions known to be unsupported.
+        quint16 maximum[QuantityFunctions]; // Learned maximal quantities, 0 if unknown.
+        quint16 window[8];              // First and last address of the four tables.
+    };
+
+    // The units of an endpoint being changed.
+    struct Entry
+    {
+        Entry( void ) : resolved( 0 ) {}
+
+        QString address;                // Resolved address.
+        qint64 resolved;                // Time of the resolution.
+        QMap<quint8,Unit> units;        // Units by ID.
+    };
+
+    // Functions with a maximal quantity, by index in Unit::maximum.
+    static const quint8 _quantityFunctions[QuantityFunctions];
+
+    // Returns a new unit record knowing nothing.
+    static Unit _unit( const quint8 unitId );
+
+    // Returns the mapped record of an endpoint, NULL if none.
+    const Endpoint *_mapped( const QString &endpoint ) const;
+
+    // Returns the units of an endpoint, changed or mapped.
+    QList<Unit> _units( const QString &endpoint ) const;
+
+    // Returns a unit's record, a new one if unknown.
+    Unit _find( const QString &endpoint , const quint8 unitId ) const;
+
+    // Returns the entry of an endpoint to change, copies the mapped records on first use.
+    Entry &_entry( const QString &endpoint );
+
+    // Maps a file and checks its header and endpoint records, returns false if it is not a valid cache.
+    bool _map( const QString &fileName );
+
+    // Unmaps the file.
+    void _unmap( void );
+
+    mutable QMutex _mutex;          // Protects the members below.
+    QFile _file;                    // Mapped file.
+    uchar *_content;                // Mapped file content, NULL if none.
+    const Endpoint *_endpoints;     // Mapped endpoint records.
+    const Unit *_unitRecords;       // Mapped unit records.
+    quint32 _endpointCount;         // Number of mapped endpoint records.
+    QMap<QString,Entry> _changed;   // Endpoints changed since the file was mapped.
+    QSet<QString> _removed;         // Endpoints removed since the file was mapped.
+};
@@ -0,0 +1,134 @@
+/***********************************************************************************************************************
+* QModbusTransactionTable : Monotonic modbus TCP transaction identifiers with constant time lookup.                   *
+************************************************************************************************************************
+* Author : QModbus contributors                                                                                        *
+* Date   : 2026/10/18                                                                                                  *
+* Changes: -                                                                                                           *
+***********************************************************************************************************************/
+#pragma once
+
+
+/*** Qt includes & prototypes *****************************************************************************************/
+#include <QtCore/QtGlobal>
+
+
+/*** QModbusTransactionTable class declaration and help ***************************************************************/
+/*!
+* The transaction table hands out the transaction identifiers of one modbus TCP connection and keeps track of the
+* transactions in flight. Identifiers are allocated in increasing order (wrapping at 65536), so an identifier is only
+* reused after 65536 further transactions and a late reply to a transaction that timed out can not be mistaken for the
+* reply to a newer one.
+*
+* Each transaction in flight occupies the slot given by the low bits of its identifier in a fixed size table, a value
+* of type T (for example the expected response length) can be stored with it. Allocation, lookup and release are
+* constant time and never allocate memory. Slots has to be a power of two, it limits the number of transactions in
+* flight: allocation fails if the slot of the next identifier is still in use.
+*
+* The table is not thread-safe, it belongs to the thread doing the I/O of the connection.
+* \headerfile qmodbustransactiontable.h QModbusTransactionTable
+*/
+template< class T , int Slots = 64 >
+class QModbusTransactionTable
+{
+public:
+    //! Constructs an empty table, the first identifier is 0.
+    QModbusTransactionTable( void );
+
+    //! Returns the maximal number of transactions in flight.
+    static int capacity( void ) { return Slots; }
+
+    /*!
+    * Allocates the next transaction identifier.
+    * \param value Value stored with the transaction.
+    * \return The transaction identifier [0..65535] or -1 if the slot of the next identifier is still in use.
+    */
+    int allocate( const T &value = T() );
+
+    /*!
+    * Looks up a transaction in flight.
+    * \param transactionId The transaction identifier of a reply.
+    * \return Pointer to the value stored with the transaction or NULL if the transaction is not in flight (unknown or
+    *         released, for example because it timed out).
+    */
+    T *find( const quint16 transactionId );
+
+    /*!
+    * Ends a transaction, its slot can be used again.
+    * \param transactionId The transaction identifier.
+    * \return True if the transaction was in flight.
+    */
+    bool release( const quint16 transactionId );
+
+    //! Returns the number of transactions in flight.
+    int pendingCount( void ) const;
+
+    //! Releases all transactions (for example if the connection was lost). Identifiers continue to increase.
+    void clear( void );
+
+private:
+    // Compile-time check that Slots is a power of two dividing 65536 (array of negative size otherwise).
+    typedef char SlotsIsPowerOfTwo[( Slots > 0 && Slots <= 65536 && ( Slots & ( Slots - 1 ) ) == 0 ) ? 1 : -1];
+
+    struct Slot
+    {
+        quint16 transactionId;      // Identifier of the transaction using the slot.
+        bool used;                  // True if a transaction in flight uses the slot.
+        T value;                    // Value stored with the transaction.
+    };
+
+    Slot _slots[Slots];             // Slots, indexed by the low bits of the identifier.
+    quint16 _next;                  // Next identifier to allocate.
+    int _pending;                   // Number of transactions in flight.
+};
+
+
+/*** QModbusTransactionTable implementation ***************************************************************************/
+template< class T , int Slots >
+QModbusTransactionTable<T,Slots>::QModbusTransactionTable( void ) : _next( 0 ) , _pending( 0 )
+{
+    for ( int i = 0 ; i < Slots ; i++ ) _slots[i].used = false;
+}
+
+template< class T , int Slots >
+int QModbusTransactionTable<T,Slots>::allocate( const T &value )
+{
+    Slot &slot = _slots[_next & ( Slots - 1 )];
+    if ( slot.used ) return -1;
+
+    slot.transactionId = _next++;
+    slot.used = true;
+    slot.value = value;
+    _pending++;
+    return slot.transactionId;
+}
+
+template< class T , int Slots >
+T *QModbusTransactionTable<T,Slots>::find( const quint16 transactionId )
+{
+    Slot &slot = _slots[transactionId & ( Slots - 1 )];
+    return slot.used && slot.transactionId == transactionId ? &slot.value : NULL;
+}
+
+template< class T , int Slots >
+bool QModbusTransactionTable<T,Slots>::release( const quint16 transactionId )
+{
+    Slot &slot = _slots[transactionId & ( Slots - 1 )];
+    if ( !slot.used || slot.transactionId != transactionId ) return false;
+
+    slot.used = false;
+    _pending--;
+    return true;
+}
+
+template< class T , int Slots >
+int QModbusTransactionTable<T,Slots>::pendingCount( void ) const
+{
+    return _pending;
+}
+
+template< class T , int Slots >
+void QModbusTransactionTable<T,Slots>::clear( void )
+{
+    for ( int i = 0 ; i < Slots ; i++ ) _slots[i].used = false;
+    _pending = 0;
+}
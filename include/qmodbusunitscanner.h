@@ -0,0 +1,148 @@
+/***********************************************************************************************************************
+* QModbusUnitScanner : Finds the units answering on a bus using short, wire time derived probe timeouts.              *
+************************************************************************************************************************
+* Author : QModbus contributors                                                                                        *
+* Date   : 2026/10/18                                                                                                  *
+* Changes: -                                                                                                           *
+***********************************************************************************************************************/
+#pragma once
+
+
+/*** Base classes *****************************************************************************************************/
+#include <QtCore/QObject>
+
+
+/*** Qt includes & prototypes *****************************************************************************************/
+#include <QAbstractModbus>
+#include <QModbusDeadline>
+#include <QModbusTopologyCache>
+#include <QtCore/QList>
+#include <QtCore/QString>
+
+
+/*** QModbusUnitScanner class declaration and help ********************************************************************/
+/*!
+* The unit scanner probes the unit IDs of a bus one after the other and reports each unit that answers as soon as it
+* is found (unitFound()). Any reply counts, an exception as well: a unit answering IllegalFunction or
+* IllegalDataAddress to the probe is there.
+*
+* Waiting the connection timeout for every silent ID makes a scan of a serial bus take minutes. The scanner instead
+* gives each probe a deadline (see QModbusRequest::setDeadline()) derived from the wire time: the time to send the
+* request at the configured baud rate, the 3.5 character silence and the response allowance, the time a unit may
+* take to start replying. A unit that started to reply is always received completely. The allowance adapts to the
+* units found: it shrinks to four times the slowest turnaround seen so far (at least 10 ms), so a scan of a bus of fast
+* units needs a few milliseconds per silent ID. It never exceeds responseAllowance(); set it higher for slow units or
+* gateways.
+*
+* The probe is a read of one holding register at address 0 (fixed response size, so the reply ends without waiting for
+* an inter character timeout) or Report Server ID (function 0x11, serial line only). The short timeouts need a
+* transport that honours request deadlines (QRtuModbus, QTcpModbus); others wait their full timeout per silent ID.
+*
+* The scan is blocking and runs in the calling thread, unitFound() is emitted from it. If a topology cache is set, the
+* reachability and round trip time of every probed unit are recorded there.
+* \headerfile qmodbusunitscanner.h QModbusUnitScanner
+*/
+class QModbusUnitScanner : public QObject
+{
+    Q_OBJECT
+
+public:
+    /*!
+    * The request used to probe a unit.
+    */
+    enum ProbeFunction
+    {
+        ReadHoldingRegister ,       //!< Read holding register 0 (function 0x03).
+        ReportServerId              //!< Report server ID (function 0x11).
+    };
+
+    /*!
+    * Constructor.
+    * \param modbus The connection to scan. It has to stay valid as long as the scanner exists.
+    * \param parent The parent object.
+    */
+    explicit QModbusUnitScanner( const QAbstractModbus &modbus , QObject *parent = NULL );
+
+    /*!
+    * Sets the serial line parameters the wire time is computed from.
+    * \param baudRate Baud rate, 0 if the connection is not a serial line (no wire time).
+    * \param bitsPerCharacter Bits of a character on the line including start, parity and stop bits. 11 for RTU.
+    */
+    void setSerialLine( const int baudRate , const int bitsPerCharacter = 11 );
+
+    //! Returns the baud rate the wire time is computed from, 0 for none. Default is 0.
+    int baudRate( void ) const;
+
+    //! Returns the request used to probe a unit. Default is ReadHoldingRegister.
+    ProbeFunction probeFunction( void ) const;
+
+    //! Changes the request used to probe a unit.
+    void setProbeFunction( const ProbeFunction function );
+
+    //! Returns the largest time in milliseconds a unit may take to start replying. Default is 50.
+    int responseAllowance( void ) const;
+
+    //! Changes the largest time a unit may take to start replying and resets the adaptation.
+    void setResponseAllowance( const int msecs );
+
+    /*!
+    * Returns the timeout of the next probe: wire time of the request and allowance adapted to the units found.
+    * \return Milliseconds.
+    */
+    int probeTimeout( void ) const;
+
+    /*!
+    * Records the results of the scans in a topology cache.
+    * \param cache The cache, NULL for none. Not owned by the scanner.
+    * \param endpoint The name of the scanned connection in the cache.
+    */
+    void setTopologyCache( QModbusTopologyCache *const cache , const QString &endpoint );
+
+    /*!
+    * Probes a range of unit IDs.
+    * \param firstUnit First unit ID [1..247].
+    * \param lastUnit Last unit ID [1..247].
+    * \param token Stops the scan when cancelled.
+    * \return The IDs of the units that replied.
+    */
+    QList<quint8> scan( const quint8 firstUnit = 1 , const quint8 lastUnit = 247 ,
+                        const QModbusCancellationToken &token = QModbusCancellationToken::none() );
+
+signals:
+    /*!
+    * This signal is emitted for each unit that replied.
+    * \param unitId The unit ID.
+    * \param status Ok, the exception the unit replied with or CrcError for a corrupted reply (maybe two units sharing
+    *               the ID).
+    * \param roundTripTime Microseconds from sending the probe to receiving the reply.
+    */
+    void unitFound( int unitId , int status , int roundTripTime );
+
+    /*!
+    * This signal is emitted at the end of a scan.
+    * \param found Number of units found.
+    */
+    void finished( int found );
+
+private:
+    Q_DISABLE_COPY( QModbusUnitScanner )
+
+    enum
+    {
+        MinimumAllowance = 10 ,     // Smallest allowance in milliseconds.
+        AllowanceFactor = 4         // Allowance in multiples of the slowest turnaround seen.
+    };
+
+    // Returns the wire time of a number of characters in microseconds, 3.5 characters of silence included.
+    qint64 _wireTime( const int characters ) const;
+
+    const QAbstractModbus &_modbus; // Connection to scan.
+    int _baudRate;                  // Baud rate, 0 for none.
+    int _bitsPerCharacter;          // Bits per character on the line.
+    ProbeFunction _probeFunction;   // Request used to probe.
+    int _maximumAllowance;          // Largest allowance in milliseconds.
+    int _allowance;                 // Current (adapted) allowance in milliseconds.
+    qint64 _slowest;                // Slowest turnaround of the current scan in microseconds, -1 if none.
+    QModbusTopologyCache *_cache;   // Cache to record the results in, NULL for none.
+    QString _endpoint;              // Name of the connection in the cache.
+};
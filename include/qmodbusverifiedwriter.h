@@ -0,0 +1,80 @@
+/***********************************************************************************************************************
+* QModbusVerifiedWriter : Writes holding registers and confirms them by reading them back.                            *
+************************************************************************************************************************
+* Author : QModbus contributors                                                                                        *
+* Date   : 2026/10/18                                                                                                  *
+* Changes: -                                                                                                           *
+***********************************************************************************************************************/
+#pragma once
+
+
+/*** Qt includes & prototypes *****************************************************************************************/
+#include <QAbstractModbus>
+#include <QModbusCapabilityCache>
+#include <QtCore/QList>
+
+
+/*** QModbusVerifiedWriter class declaration and help *****************************************************************/
+/*!
+* The verified writer writes a block of holding registers and reads the same block back to confirm that the device
+* accepted the values. If the device supports it, both are done in a single transaction using
+* writeReadMultipleRegisters() (function 0x17), which halves the latency compared to a write followed by a read.
+* Otherwise the writer falls back to writeSingleRegister() or writeMultipleRegisters() followed by
+* readHoldingRegisters().
+*
+* Whether a device supports function 0x17 is learned from the first attempt (an illegal function exception marks it as
+* unsupported) and remembered in a QModbusCapabilityCache. The cache can be shared with other helpers working on the
+* same connection. Blocks larger than the 121 registers function 0x17 can write always use the fallback.
+*
+* If the values read back differ from the values written, the status is QAbstractModbus::VerificationFailed.
+* \headerfile qmodbusverifiedwriter.h QModbusVerifiedWriter
+*/
+class QModbusVerifiedWriter
+{
+public:
+    /*!
+    * Constructor.
+    * \param modbus The connection to write to. It has to stay valid as long as the writer exists.
+    * \param cache The capability cache to use. If NULL, the writer uses its own cache. Not owned by the writer.
+    */
+    explicit QModbusVerifiedWriter( const QAbstractModbus &modbus , QModbusCapabilityCache *const cache = NULL );
+
+    /*!
+    * Returns the capability cache the writer uses.
+    * \return Capability cache.
+    */
+    QModbusCapabilityCache &capabilities( void ) const;
+
+    /*!
+    * Writes a single holding register and confirms its value.
+    * \param deviceAddress Address of the slave device [1..247].
+    * \param registerAddress Register address [0..65535].
+    * \param registerValue Value to write to the register [0..65535].
+    * \param status Pointer to a variable that will contain the transaction status after method execution. If NULL
+    *               status will not be reported at all.
+    * \return True if the value was written and read back unchanged, false otherwise.
+    */
+    bool writeRegister( const quint8 deviceAddress , const quint16 registerAddress , const quint16 registerValue ,
+                        quint8 *const status = NULL ) const;
+
+    /*!
+    * Writes a block of holding registers and confirms their values.
+    * \param deviceAddress Address of the slave device [1..247].
+    * \param startingAddress The address of the first register [0..65535].
+    * \param registersValues The values to write, at most 123 registers.
+    * \param readBack If not NULL, receives the values read back (also if the verification failed).
+    * \param status Pointer to a variable that will contain the transaction status after method execution. If NULL
+    *               status will not be reported at all.
+    * \return True if the values were written and read back unchanged, false otherwise.
+    */
+    bool writeRegisters( const quint8 deviceAddress , const quint16 startingAddress ,
+                         const QList<quint16> &registersValues , QList<quint16> *const readBack = NULL ,
+                         quint8 *const status = NULL ) const;
+
+private:
+    Q_DISABLE_COPY( QModbusVerifiedWriter )
+
+    const QAbstractModbus &_modbus; // Connection to write to.
+    QModbusCapabilityCache _ownCache;   // Cache used if none was given.
+    QModbusCapabilityCache *_cache; // Cache in use.
+};
@@ -0,0 +1,170 @@
+/***********************************************************************************************************************
+* QModbusWriteBehind : Collects single writes for a short time window and sends them coalesced.                       *
+************************************************************************************************************************
+* Author : QModbus contributors                                                                                        *
+* Date   : 2026/10/18                                                                                                  *
+* Changes: -                                                                                                           *
+***********************************************************************************************************************/
+#pragma once
+
+
+/*** Base classes *****************************************************************************************************/
+#include <QtCore/QObject>
+
+
+/*** Qt includes & prototypes *****************************************************************************************/
+#include <QAbstractModbus>
+#include <QtCore/QMap>
+#include <QtCore/QTimer>
+
+
+/*** QModbusWriteBehind class declaration and help ********************************************************************/
+/*!
+* The write behind queue collects coil and register writes for a configurable time window (measured from the first
+* write after the last flush) and then sends them using as few modbus transactions as possible:
+*   - Writes to contiguous registers of the same device are sent using writeMultipleRegisters() (up to 123 registers
+*     per request), contiguous coils using writeMultipleCoils() (up to 1968 coils per request).
+*   - Bit updates (mask writes) to a register are folded together into a single maskWriteRegister(). A bit update to a
+*     register that has a pending value is applied to that value directly.
+*   - An isolated coil or register is sent using writeSingleCoil() or writeSingleRegister().
+*
+* Ordering guarantees:
+*   - For a given coil or register, the last write queued wins. Intermediate values are never sent to the device.
+*   - Within one flush, the coils are sent first and then the registers, each ordered by device address and then by
+*     item address. The order in which writes to different addresses were queued is not kept.
+*     If an application depends on the order of two writes (a setpoint and then the command to apply it, for example),
+*     it has to call flush() between them.
+*   - Reads done directly on the connection do not see queued writes. Call flush() before reading back.
+*
+* Failed transactions are not retried; the writeFailed() signal is emitted and the writes of that transaction are
+* discarded. The flush is done in the thread the queue lives in, using the blocking methods of the connection, so the
+* timer needs a running event loop.
+* \headerfile qmodbuswritebehind.h QModbusWriteBehind
+*/
+class QModbusWriteBehind : public QObject
+{
+    Q_OBJECT
+
+public:
+    /*!
+    * Constructor.
+    * \param modbus The connection to write to. It has to stay valid as long as the queue exists.
+    * \param window Time window in milliseconds the writes are collected for before they are sent.
+    * \param parent The parent object.
+    */
+    explicit QModbusWriteBehind( const QAbstractModbus &modbus , const int window = 10 , QObject *parent = NULL );
+
+    /*!
+    * Destructor. Pending writes are flushed.
+    */
+    virtual ~QModbusWriteBehind();
+
+    /*!
+    * Returns the time window the writes are collected for.
+    * \return Window in milliseconds.
+    */
+    int window( void ) const;
+
+    /*!
+    * Changes the time window the writes are collected for. A window of 0 sends the writes as soon as control returns
+    * to the event loop.
+    * \param window Window in milliseconds.
+    */
+    void setWindow( const int window );
+
+    /*!
+    * Queues a write to a single coil.
+    * \param deviceAddress Address of the slave device [1..247].
+    * \param outputAddress Output (coil) address [0..65535].
+    * \param outputValue true for ON and false for OFF.
+    */
+    void writeCoil( const quint8 deviceAddress , const quint16 outputAddress , const bool outputValue );
+
+    /*!
+    * Queues a write to a sequence of coils.
+    * \param deviceAddress Address of the slave device [1..247].
+    * \param startingAddress The address of the first output (coil) [0..65535].
+    * \param outputValues The output values.
+    */
+    void writeCoils( const quint8 deviceAddress , const quint16 startingAddress , const QList<bool> &outputValues );
+
+    /*!
+    * Queues a write to a single holding register.
+    * \param deviceAddress Address of the slave device [1..247].
+    * \param registerAddress Register address [0..65535].
+    * \param registerValue Value to write to the register [0..65535].
+    */
+    void writeRegister( const quint8 deviceAddress , const quint16 registerAddress , const quint16 registerValue );
+
+    /*!
+    * Queues a write to a block of holding registers.
+    * \param deviceAddress Address of the slave device [1..247].
+    * \param startingAddress The address of the first register [0..65535].
+    * \param registersValues The register values.
+    */
+    void writeRegisters( const quint8 deviceAddress , const quint16 startingAddress ,
+                         const QList<quint16> &registersValues );
+
+    /*!
+    * Queues a modification of some bits of a holding register. The result is the same as for
+    * QAbstractModbus::maskWriteRegister(): Result = ( Current Contents AND And_Mask ) OR ( Or_Mask AND (NOT And_Mask) )
+    * \param deviceAddress Address of the slave device [1..247].
+    * \param referenceAddress Address of the holding register to be modified [0..65535].
+    * \param andMask The mask to use for the AND function.
+    * \param orMask The mask to use for the OR function.
+    */
+    void maskRegister( const quint8 deviceAddress , const quint16 referenceAddress , const quint16 andMask ,
+                       const quint16 orMask );
+
+    /*!
+    * Returns the number of coils and registers with a pending write.
+    * \return Number of pending writes.
+    */
+    int pendingCount( void ) const;
+
+    /*!
+    * Sends all pending writes now.
+    * \param status Pointer to a variable that will contain the status of the first failed transaction or Ok. If NULL
+    *               status will not be reported at all.
+    * \return True if all transactions succeeded, false otherwise.
+    */
+    bool flush( quint8 *const status = NULL );
+
+signals:
+    /*!
+    * Emitted for each failed transaction during a flush. The writes of the transaction are discarded.
+    * \param deviceAddress Address of the slave device.
+    * \param table Coils or HoldingRegisters.
+    * \param startingAddress Address of the first coil or register of the transaction.
+    * \param quantity Number of coils or registers of the transaction.
+    * \param status Transaction status (see QAbstractModbus::Status).
+    */
+    void writeFailed( quint8 deviceAddress , int table , quint16 startingAddress , int quantity , quint8 status );
+
+private slots:
+    void _timerExpired( void );
+
+private:
+    struct Register
+    {
+        bool full;                  // True if the whole value is written, false for a mask write.
+        quint16 value;              // Value to write (full write).
+        quint16 andMask;            // AND mask (mask write).
+        quint16 orMask;             // OR mask (mask write).
+    };
+
+    // Key of a coil or register: device address in the upper, item address in the lower 16 bits.
+    static quint32 _key( const quint8 deviceAddress , const quint16 address );
+
+    // Starts the window timer if not yet running.
+    void _arm( void );
+
+    // Reports a failed transaction.
+    void _fail( const quint32 key , const QAbstractModbus::Table table , const int quantity , const quint8 status ,
+                quint8 &first );
+
+    const QAbstractModbus &_modbus; // Connection to write to.
+    QMap<quint32,bool> _coils;      // Pending coil writes, ordered by device and address.
+    QMap<quint32,Register> _registers;  // Pending register writes, ordered by device and address.
+    QTimer _timer;                  // Single shot window timer.
+};
@@ -13,6 +13,7 @@
 
 
 /*** Qt includes & prototypes *****************************************************************************************/
+#include <QModbusDeadline>
 #include <QtCore/QFile>
 #include <QtCore/QString>
 #include <QtCore/QList>
@@ -465,6 +466,13 @@ public:
     QByteArray executeCustomFunction( const quint8 deviceAddress , const quint8 modbusFunction ,
                                       QByteArray &data , quint8 *const status = NULL ) const;
 
+    // Interface implementation (QiAbstractModbus).
+    bool executePdu( const quint8 deviceAddress , const QModbusFrameView &request , QModbusPduFrame &response ,
+                     quint8 *const status = NULL ) const;
+
+    // Interface implementation (QiAbstractModbus).
+    QList<QModbusResponse> execute( const QList<QModbusRequest> &batch ) const;
+
     // Interface implementation (QiAbstractModbus).
     QByteArray executeRaw( QByteArray &data , quint8 *const status = NULL ) const;
 
@@ -472,19 +480,26 @@ public:
     QByteArray calculateCheckSum( QByteArray &data ) const;
 
 private:
+    // The I/O policy of the request core uses the serial port functions below.
+    friend class QRtuModbusIo;
 
 # /***/ ifdef Q_OS_WIN /***********************************************************************************************/
 
     QByteArray _read( const int numberBytes ) const;
     QByteArray _readAll( void ) const;
     QByteArray _readLine( int maxBytes ) const;
-    bool _write( QByteArray &data ) const;
+    qint64 _read( char *const data , const qint64 maxSize ) const;
+    qint64 _readLine( char *const data , const qint64 maxSize ) const;
 
 # /***/ endif /* Q_OS_WIN *********************************************************************************************/
 
-    // Used to perform CRC on outgoing modbus messages.
-    quint16 _calculateCrc( const QByteArray &pdu ) const;
+    // Drops the data received but not read yet, without waiting for more.
+    void _discard( void ) const;
+
+    // Writes to the serial port, drives RTS if needed.
+    bool _write( const char *const data , const qint64 size ) const;
 
-    // Used to check CRC on incomming modbus messages.
-    bool _checkCrc( const QByteArray &pdu ) const;
+    // Waits until data arrives, at most the timeout and until the deadline or the cancellation of the token. Returns
+    // false if no data arrived. On Windows the limits are only checked, ReadFile() waits for the data.
+    bool _waitForData( const QModbusDeadline &deadline , const QModbusCancellationToken &token ) const;
 };
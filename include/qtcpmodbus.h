@@ -14,8 +14,10 @@
 
 
 /*** Qt includes & prototypes *****************************************************************************************/
+#include <QModbusTransactionTable>
 #include <QtNetwork/QTcpSocket>
 #include <QtCore/QString>
+#include <QtCore/QTimer>
 #include <QtCore/QList>
 
 
@@ -33,9 +35,16 @@ class QTcpModbus : public QObject , public QAbstractModbus
     Q_OBJECT;
 
 private:
+    friend class QTcpModbusIo;      // The I/O policy of the request core uses the socket.
+
     mutable QTcpSocket _socket;     // Socket used for communication.
+    mutable QModbusTransactionTable<int> _transactions; // Transactions in flight (see QModbusTcpFraming).
     int _timeout;                   // Timeout to use in TCP communication.
     int _connectTimeout;            // TCP connect timeout.
+    QTimer _connectTimer;           // Bounds a non-blocking connect to the connect timeout.
+    bool _connecting;               // True while a connect is in progress.
+    QString _host;                  // Host of the last connect.
+    quint16 _port;                  // Port of the last connect.
 
 public:
     /*!
@@ -62,6 +71,34 @@ public:
     */
     bool connect( const QString &host , const quint16 port = 502 );
 
+    /*!
+    * Starts connecting to the given host and returns immediately. Either connected() or connectFailed() is emitted
+    * later, at the latest after the connect timeout. Requests fail with NoConnection until the connection is
+    * established. Needs a running event loop (or blocking calls) in the thread of the transport. Can be invoked
+    * (queued) from other threads.
+    * \param host IP address or DNS name of the host to connect to.
+    * \param port Port to be used for TCP connection. Modbus default is 502.
+    */
+    Q_INVOKABLE void connectToHost( const QString &host , const quint16 port = 502 );
+
+    /*!
+    * Returns true while a connect started by connect() or connectToHost() is in progress.
+    * \return True if connecting.
+    */
+    bool isConnecting( void ) const;
+
+    /*!
+    * Returns the host of the last connect.
+    * \return Host name or address, empty if never connected.
+    */
+    QString host( void ) const;
+
+    /*!
+    * Returns the port of the last connect.
+    * \return Port.
+    */
+    quint16 port( void ) const;
+
     /*!
     * Returns true of the connection to the Modbus device or gateway is alive.
     * \return True if connection is active.
@@ -176,15 +213,48 @@ public:
     QByteArray executeCustomFunction( const quint8 deviceAddress , const quint8 modbusFunction ,
                                       QByteArray &data , quint8 *const status = NULL ) const;
 
+    // Interface implementation (QiAbstractModbus).
+    bool executePdu( const quint8 deviceAddress , const QModbusFrameView &request , QModbusPduFrame &response ,
+                     quint8 *const status = NULL ) const;
+
+    // Interface implementation (QiAbstractModbus).
+    QList<QModbusResponse> execute( const QList<QModbusRequest> &batch ) const;
+
     // Interface implementation (QiAbstractModbus).
     QByteArray executeRaw( QByteArray &data , quint8 *const status = NULL ) const;
 
     // Interface implementation (QiAbstractModbus).
     QByteArray calculateCheckSum( QByteArray &data ) const;
 
+public slots:
+    /*!
+    * Starts connecting again to the host and port of the last connect, unless the transport is connected or a connect
+    * is in progress. Non-blocking like connectToHost(), can be invoked (queued) from other threads.
+    */
+    void reconnect( void );
+
 signals:
     /*!
     * This signal is emitted if the connection to the modbus device was lost.
     */
     void connectionLost();
+
+    /*!
+    * This signal is emitted once a connect succeeded.
+    */
+    void connected();
+
+    /*!
+    * This signal is emitted if a connect failed or timed out.
+    */
+    void connectFailed();
+
+private slots:
+    void _socketConnected( void );
+    void _socketError( QAbstractSocket::SocketError error );
+    void _connectTimedOut( void );
+
+private:
+    // Ends a connect in progress that failed.
+    void _failConnect( void );
 };
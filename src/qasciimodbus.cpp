@@ -5,7 +5,8 @@
 
 
 /*** Qt includes ******************************************************************************************************/
-#include <QtCore/QDataStream>
+#include <QModbusRequestCore>
+#include <cstring>
 
 
 /*** System includes **************************************************************************************************/
@@ -16,16 +17,57 @@
 
 # /***/ ifdef Q_OS_UNIX /**********************************************************************************************/
 
-#   define _read        _commPort.read
-#   define _readAll     _commPort.readAll
-#   define _readLine    _commPort.readLine
 #   define _write       _commPort.write
 
 # /***/ endif /* Q_OS_UNIX ********************************************************************************************/
 
 
+/*** Request core *****************************************************************************************************/
+// I/O policy of the request core, uses the receive buffer of the transport. Pending input is not discarded, as before.
+class QAsciiModbusIo
+{
+public:
+    explicit QAsciiModbusIo( const QAsciiModbus &modbus ) : _modbus( modbus ) {}
+    bool isOpen( void ) const { return _modbus.isOpen(); }
+    void discard( void ) const {}
+
+    // The receive functions wait for the line using the timeout of the port only, the limits of a request are checked
+    // before it is sent.
+    void limit( const QModbusDeadline & , const QModbusCancellationToken & ) const {}
+    int read( char *const data , const int size ) const { return _modbus._receiveBytes( data , size ); }
+    int readAll( char *const data , const int maxSize ) const { return read( data , maxSize ); }
+
+    int readLine( char *const data , const int maxSize ) const
+    {
+        const int size = _modbus._receiveLine( data , maxSize - 1 );
+        data[size] = 0;
+
+        // Drop the rest of a line that is too long for the caller.
+        char rest[64];
+        while ( _modbus._rxInLine && _modbus._receiveLine( rest , sizeof( rest ) ) );
+        return size;
+    }
+
+# /***/ ifdef Q_OS_UNIX /**********************************************************************************************/
+    bool write( const char *const data , const int size ) const { return _modbus._write( data , size ) == size; }
+# /***/ else /*********************************************************************************************************/
+    bool write( const char *const data , const int size ) const { return _modbus._write( data , size ); }
+# /***/ endif /* Q_OS_UNIX ********************************************************************************************/
+
+private:
+    const QAsciiModbus &_modbus;
+};
+
+typedef QModbusRequestCore<QModbusAsciiFraming,QAsciiModbusIo> QAsciiModbusCore;
+
+static inline QAsciiModbusCore core( const QAsciiModbus &modbus )
+{
+    return QAsciiModbusCore( QAsciiModbusIo( modbus ) );
+}
+
+
 /*** Class implememtation *********************************************************************************************/
-QAsciiModbus::QAsciiModbus() : _timeout( 500 )
+QAsciiModbus::QAsciiModbus() : _timeout( 500 ) , _rxBegin( 0 ) , _rxEnd( 0 ) , _rxInLine( false )
 {}
 
 QAsciiModbus::~QAsciiModbus()
@@ -221,6 +263,7 @@ bool QAsciiModbus::isOpen() const
 
 void QAsciiModbus::close()
 {
+    _clearReceiveBuffer();
 
 # /***/ ifdef Q_OS_UNIX /**********************************************************************************************/
 
@@ -279,1186 +322,257 @@ void QAsciiModbus::setTimeout( const unsigned int timeout )
 QList<bool> QAsciiModbus::readCoils( const quint8 deviceAddress , const quint16 startingAddress ,
                                       const quint16 quantityOfCoils , quint8 *const status ) const
 {
-    // Are we connected ?
-    if ( !isOpen() )
-    {
-        if ( status ) *status = NoConnection;
-        return QList<bool>();
-    }
-
-    // Create modbus read coil quint8 pdu (Modbus uses Big Endian).
-    QByteArray pdu;
-    QDataStream pduStream( &pdu , QIODevice::WriteOnly );
-    pduStream.setByteOrder( QDataStream::BigEndian );
-    pduStream << deviceAddress << (quint8)0x01 << startingAddress << quantityOfCoils;
-
-    // Encode to hex.
-    QByteArray hexEncoded( ":" );
-    hexEncoded += pdu.toHex().toUpper();
-
-    // Calculate LRC and add it to the PDU.
-    hexEncoded += QString( "%1" ).arg( _calculateLrc( pdu ) , 2 , 16 , QChar( '0' ) ).toUpper();
-    hexEncoded += 0x0D;
-    hexEncoded += 0x0A;
-
-    // Send the pdu.
-    _write( hexEncoded );
-
-    // Await response.
-    quint16 neededRxBytes = quantityOfCoils / 8;
-    if ( quantityOfCoils % 8 ) neededRxBytes++;
-    pdu.clear();
-    hexEncoded.clear();
-
-    // Try to read line.
-    hexEncoded = _readLine( 200 );
-
-    // Handle timeout.
-    if ( hexEncoded.size() < 9 )
-    {
-        if ( status ) *status = Timeout;
-        return QList<bool>();
-    }
-
-    // Check LRC.
-    if ( !_checkLrc( hexEncoded ) )
-    {
-        if ( status ) *status = CrcError;
-        return QList<bool>();
-    }
-
-    // Get the hex decoded form.
-    pdu = QByteArray::fromHex( hexEncoded.mid( 1 , hexEncoded.size() -5 ) );
-
-    // Was it a Modbus error?
-    if ( pdu[1] & 0x80 )
-    {
-        if ( status ) *status = pdu[2];
-        return QList<bool>();
-    }
-
-    // Check data and return them on success.
-    if ( pdu.size() == neededRxBytes + 3 )
-    {
-        // Read device address and command ID and control them.
-        quint8 rxDeviceAddress , rxFunctionCode , byteCount;
-        QDataStream rxStream( pdu );
-        rxStream.setByteOrder( QDataStream::BigEndian );
-        rxStream >> rxDeviceAddress >> rxFunctionCode >> byteCount;
-
-        if ( rxDeviceAddress == deviceAddress && rxFunctionCode == 0x01 && byteCount == neededRxBytes )
-        {
-            // It is ok, read and convert the data.
-            QList<bool> list;
-            quint8 tmp;
-            for ( int i = 0 ; i < quantityOfCoils ; i++ )
-            {
-                if ( i % 8 == 0 ) rxStream >> tmp;
-                list.append( tmp & ( 0x01 << ( i % 8 ) ) );
-            }
-            if ( status ) *status = Ok;
-            return list;
-        }
-    }
-
-    // If we arrive here, something went wrong.
-    if ( status ) *status = UnknownError;
-    return QList<bool>();
+    return core( *this ).readBits( deviceAddress , 0x01 , startingAddress , quantityOfCoils , status );
 }
 
 QList<bool> QAsciiModbus::readDiscreteInputs( const quint8 deviceAddress , const quint16 startingAddress ,
                                                const quint16 quantityOfInputs , quint8 *const status ) const
 {
-    // Are we connected ?
-    if ( !isOpen() )
-    {
-        if ( status ) *status = NoConnection;
-        return QList<bool>();
-    }
-
-    // Create modbus read coil quint8 pdu (Modbus uses Big Endian).
-    QByteArray pdu;
-    QDataStream pduStream( &pdu , QIODevice::WriteOnly );
-    pduStream.setByteOrder( QDataStream::BigEndian );
-    pduStream << deviceAddress << (quint8)0x02 << startingAddress << quantityOfInputs;
+    return core( *this ).readBits( deviceAddress , 0x02 , startingAddress , quantityOfInputs , status );
+}
 
-    // Encode to hex.
-    QByteArray hexEncoded( ":" );
-    hexEncoded += pdu.toHex().toUpper();
+QList<quint16> QAsciiModbus::readHoldingRegisters( const quint8 deviceAddress , const quint16 startingAddress ,
+                                                    const quint16 quantityOfRegisters , quint8 *const status ) const
+{
+    return core( *this ).readRegisters( deviceAddress , 0x03 , startingAddress , quantityOfRegisters , status );
+}
 
-    // Calculate LRC and add it to the PDU.
-    hexEncoded += QString( "%1" ).arg( _calculateLrc( pdu ) , 2 , 16 , QChar( '0' ) ).toUpper();
-    hexEncoded += 0x0D;
-    hexEncoded += 0x0A;
+QList<quint16> QAsciiModbus::readInputRegisters( const quint8 deviceAddress , const quint16 startingAddress ,
+                                                  const quint16 quantityOfInputRegisters , quint8 *const status ) const
+{
+    return core( *this ).readRegisters( deviceAddress , 0x04 , startingAddress , quantityOfInputRegisters , status );
+}
 
-    // Send the pdu.
-    _write( hexEncoded );
+bool QAsciiModbus::writeSingleCoil( const quint8 deviceAddress , const quint16 outputAddress ,
+                                     const bool outputValue , quint8 *const status ) const
+{
+    return core( *this ).writeSingleCoil( deviceAddress , outputAddress , outputValue , status );
+}
 
-    // Await response.
-    quint16 neededRxBytes = quantityOfInputs / 8;
-    if ( quantityOfInputs % 8 ) neededRxBytes++;
-    pdu.clear();
-    hexEncoded.clear();
+bool QAsciiModbus::writeSingleRegister( const quint8 deviceAddress , const quint16 outputAddress ,
+                                         const quint16 registerValue , quint8 *const status ) const
+{
+    return core( *this ).writeSingleRegister( deviceAddress , outputAddress , registerValue , status );
+}
 
-    // Try to read line.
-    hexEncoded = _readLine( 200 );
+bool QAsciiModbus::writeMultipleCoils( const quint8 deviceAddress , const quint16 startingAddress ,
+                                        const QList<bool> & outputValues , quint8 *const status ) const
+{
+    return core( *this ).writeMultipleCoils( deviceAddress , startingAddress , outputValues , status );
+}
 
-    // Handle timeout.
-    if ( hexEncoded.size() < 9 )
-    {
-        if ( status ) *status = Timeout;
-        return QList<bool>();
-    }
+bool QAsciiModbus::writeMultipleRegisters( const quint8 deviceAddress , const quint16 startingAddress ,
+                                            const QList<quint16> & registersValues , quint8 *const status ) const
+{
+    return core( *this ).writeMultipleRegisters( deviceAddress , startingAddress , registersValues , status );
+}
 
-    // Check LRC.
-    if ( !_checkLrc( hexEncoded ) )
-    {
-        if ( status ) *status = CrcError;
-        return QList<bool>();
-    }
+bool QAsciiModbus::maskWriteRegister( const quint8 deviceAddress , const quint16 referenceAddress ,
+                                       const quint16 andMask , const quint16 orMask , quint8 *const status ) const
+{
+    return core( *this ).maskWriteRegister( deviceAddress , referenceAddress , andMask , orMask , status );
+}
 
-    // Get the hex decoded form.
-    pdu = QByteArray::fromHex( hexEncoded.mid( 1 , hexEncoded.size() -5 ) );
+QList<quint16> QAsciiModbus::writeReadMultipleRegisters( const quint8 deviceAddress ,
+                                                          const quint16 writeStartingAddress ,
+                                                          const QList<quint16> & writeValues ,
+                                                          const quint16 readStartingAddress ,
+                                                          const quint16 quantityToRead , quint8 *const status ) const
+{
+    return core( *this ).writeReadMultipleRegisters( deviceAddress , writeStartingAddress , writeValues ,
+                                                     readStartingAddress , quantityToRead , status );
+}
 
-    // Was it a Modbus error?
-    if ( pdu[1] & 0x80 )
-    {
-        if ( status ) *status = pdu[2];
-        return QList<bool>();
-    }
+QList<quint16> QAsciiModbus::readFifoQueue( const quint8 deviceAddress , const quint16 fifoPointerAddress ,
+                                             quint8 *const status ) const
+{
+    return core( *this ).readFifoQueue( deviceAddress , fifoPointerAddress , status );
+}
 
-    // Check data and return them on success.
-    if ( pdu.size() == neededRxBytes + 3 )
-    {
-        // Read device address and command ID and control them.
-        quint8 rxDeviceAddress , rxFunctionCode , byteCount;
-        QDataStream rxStream( pdu );
-        rxStream.setByteOrder( QDataStream::BigEndian );
-        rxStream >> rxDeviceAddress >> rxFunctionCode >> byteCount;
+QByteArray QAsciiModbus::executeCustomFunction( const quint8 deviceAddress , const quint8 modbusFunction ,
+                                                 QByteArray &data , quint8 *const status ) const
+{
+    return core( *this ).executeCustomFunction( deviceAddress , modbusFunction , data , status );
+}
 
-        if ( rxDeviceAddress == deviceAddress && rxFunctionCode == 0x02 && byteCount == neededRxBytes )
-        {
-            // It is ok, read and convert the data.
-            QList<bool> list;
-            quint8 tmp;
-            for ( int i = 0 ; i < quantityOfInputs ; i++ )
-            {
-                if ( i % 8 == 0 ) rxStream >> tmp;
-                list.append( tmp & ( 0x01 << ( i % 8 ) ) );
-            }
-            if ( status ) *status = Ok;
-            return list;
-        }
-    }
+bool QAsciiModbus::executePdu( const quint8 deviceAddress , const QModbusFrameView &request ,
+                               QModbusPduFrame &response , quint8 *const status ) const
+{
+    return core( *this ).executePdu( deviceAddress , request , response , status );
+}
 
-    // If we arrive here, something went wrong.
-    if ( status ) *status = UnknownError;
-    return QList<bool>();
+QList<QModbusResponse> QAsciiModbus::execute( const QList<QModbusRequest> &batch ) const
+{
+    return core( *this ).execute( batch );
 }
 
-QList<quint16> QAsciiModbus::readHoldingRegisters( const quint8 deviceAddress , const quint16 startingAddress ,
-                                                    const quint16 quantityOfRegisters , quint8 *const status ) const
+QByteArray QAsciiModbus::executeRaw( QByteArray &data , quint8 *const status ) const
 {
     // Are we connected ?
     if ( !isOpen() )
     {
         if ( status ) *status = NoConnection;
-        return QList<quint16>();
+        return QByteArray();
     }
 
-    // Create modbus read holding registers pdu (Modbus uses Big Endian).
-    QByteArray pdu;
-    QDataStream pduStream( &pdu , QIODevice::WriteOnly );
-    pduStream.setByteOrder( QDataStream::BigEndian );
-    pduStream << deviceAddress << (quint8)0x03 << startingAddress << quantityOfRegisters;
-
     // Encode to hex.
     QByteArray hexEncoded( ":" );
-    hexEncoded += pdu.toHex().toUpper();
-
-    // Calculate LRC and add it to the PDU.
-    hexEncoded += QString( "%1" ).arg( _calculateLrc( pdu ) , 2 , 16 , QChar( '0' ) ).toUpper();
-    hexEncoded += 0x0D;
-    hexEncoded += 0x0A;
-
-    // Send the pdu.
+    hexEncoded += data.toHex().toUpper();
+    // Send the data.
     _write( hexEncoded );
 
     // Await response.
-    quint16 neededRxBytes = quantityOfRegisters * 2;
-    pdu.clear();
     hexEncoded.clear();
 
-    // Try to read line.
-    hexEncoded = _readLine( 200 );
+    // Read the line, whatever its length.
+    char chunk[128];
+    int size;
+    do
+    {
+        size = _receiveLine( chunk , sizeof( chunk ) );
+        hexEncoded.append( chunk , size );
+    } while ( size > 0 && _rxInLine );
 
     // Handle timeout.
-    if ( hexEncoded.size() < 9 )
+    if ( hexEncoded.size() == 0 )
     {
         if ( status ) *status = Timeout;
-        return QList<quint16>();
-    }
-
-    // Check LRC.
-    if ( !_checkLrc( hexEncoded ) )
-    {
-        if ( status ) *status = CrcError;
-        return QList<quint16>();
+        return QByteArray();
     }
 
     // Get the hex decoded form.
-    pdu = QByteArray::fromHex( hexEncoded.mid( 1 , hexEncoded.size() -5 ) );
-
-    // Was it a Modbus error?
-    if ( pdu[1] & 0x80 )
-    {
-        if ( status ) *status = pdu[2];
-        return QList<quint16>();
-    }
-
-    // Check data and return them on success.
-    if ( pdu.size() == neededRxBytes + 3 )
-    {
-        // Read device address and command ID and control them.
-        quint8 rxDeviceAddress , rxFunctionCode , byteCount;
-        QDataStream rxStream( pdu );
-        rxStream.setByteOrder( QDataStream::BigEndian );
-        rxStream >> rxDeviceAddress >> rxFunctionCode >> byteCount;
-
-        if ( rxDeviceAddress == deviceAddress && rxFunctionCode == 0x03 && byteCount == neededRxBytes )
-        {
-            // It is ok, read and convert the data.
-            QList<quint16> list;
-            quint16 tmp;
-            for ( int i = 0 ; i < quantityOfRegisters ; i++ )
-            {
-                rxStream >> tmp;
-                list.append( tmp );
-            }
-            if ( status ) *status = Ok;
-            return list;
-        }
-    }
-
-    // If we arrive here, something went wrong.
-    if ( status ) *status = UnknownError;
-    return QList<quint16>();
+    return QByteArray::fromHex( hexEncoded );
 }
 
-QList<quint16> QAsciiModbus::readInputRegisters( const quint8 deviceAddress , const quint16 startingAddress ,
-                                                  const quint16 quantityOfInputRegisters , quint8 *const status ) const
+QByteArray QAsciiModbus::calculateCheckSum( QByteArray &data ) const
 {
-    // Are we connected ?
-    if ( !isOpen() )
-    {
-        if ( status ) *status = NoConnection;
-        return QList<quint16>();
-    }
+    quint8 lrc = QModbusAsciiFraming::lrc( data.constData() , data.size() );
+    return QByteArray( (char *)&lrc , 1 );
+}
 
-    // Create modbus read input quint8 pdu (Modbus uses Big Endian).
-    QByteArray pdu;
-    QDataStream pduStream( &pdu , QIODevice::WriteOnly );
-    pduStream.setByteOrder( QDataStream::BigEndian );
-    pduStream << deviceAddress << (quint8)0x04 << startingAddress << quantityOfInputRegisters;
+int QAsciiModbus::_receive( char *const data , const int maxSize ) const
+{
 
-    // Encode to hex.
-    QByteArray hexEncoded( ":" );
-    hexEncoded += pdu.toHex().toUpper();
+# /***/ ifdef Q_OS_UNIX /**********************************************************************************************/
 
-    // Calculate LRC and add it to the PDU.
-    hexEncoded += QString( "%1" ).arg( _calculateLrc( pdu ) , 2 , 16 , QChar( '0' ) ).toUpper();
-    hexEncoded += 0x0D;
-    hexEncoded += 0x0A;
+    // One system call, returns as soon as some bytes arrived or after the timeout (VMIN = 0, VTIME).
+    const ssize_t size = ::read( _commPort.handle() , data , maxSize );
 
-    // Send the pdu.
-    _write( hexEncoded );
+# /***/ endif /* Q_OS_UNIX ********************************************************************************************/
 
-    // Await response.
-    quint16 neededRxBytes = quantityOfInputRegisters * 2;
-    pdu.clear();
-    hexEncoded.clear();
+# /***/ ifdef Q_OS_WIN /***********************************************************************************************/
 
-    // Try to read line.
-    hexEncoded = _readLine( 200 );
+    // One ReadFile() call, returns after the read interval timeout.
+    const qint64 size = _read( data , maxSize );
 
-    // Handle timeout.
-    if ( hexEncoded.size() < 9 )
-    {
-        if ( status ) *status = Timeout;
-        return QList<quint16>();
-    }
+# /***/ endif /* Q_OS_WIN *********************************************************************************************/
 
-    // Check LRC.
-    if ( !_checkLrc( hexEncoded ) )
-    {
-        if ( status ) *status = CrcError;
-        return QList<quint16>();
-    }
+    return size > 0 ? (int)size : 0;
+}
 
-    // Get the hex decoded form.
-    pdu = QByteArray::fromHex( hexEncoded.mid( 1 , hexEncoded.size() -5 ) );
+int QAsciiModbus::_receiveBytes( char *const data , const int size ) const
+{
+    // Take the buffered bytes first.
+    int count = qMin( size , _rxEnd - _rxBegin );
+    memcpy( data , _rxBuffer + _rxBegin , count );
+    _rxBegin += count;
 
-    // Was it a Modbus error?
-    if ( pdu[1] & 0x80 )
+    // Then read the rest directly.
+    while ( count < size )
     {
-        if ( status ) *status = pdu[2];
-        return QList<quint16>();
+        const int received = _receive( data + count , size - count );
+        if ( received == 0 ) break;
+        count += received;
     }
+    return count;
+}
 
-    // Check data and return them on success.
-    if ( pdu.size() == neededRxBytes + 3 )
+int QAsciiModbus::_receiveLine( char *const data , const int maxSize ) const
+{
+    int count = 0;
+    while ( count < maxSize )
     {
-        // Read TCP fields and, device address and command ID and control them.
-        quint8 rxDeviceAddress , rxFunctionCode , byteCount;
-        QDataStream rxStream( pdu );
-        rxStream.setByteOrder( QDataStream::BigEndian );
-        rxStream >> rxDeviceAddress >> rxFunctionCode >> byteCount;
+        // Refill the buffer if everything was consumed.
+        if ( _rxBegin == _rxEnd )
+        {
+            _rxBegin = 0;
+            _rxEnd = _receive( _rxBuffer , sizeof( _rxBuffer ) );
+            if ( _rxEnd == 0 )
+            {
+                // Timeout, the line is incomplete.
+                _rxInLine = false;
+                break;
+            }
+        }
 
-        if ( rxDeviceAddress == deviceAddress && rxFunctionCode == 0x04 && byteCount == neededRxBytes )
+        // Skip everything up to the start of a line.
+        if ( !_rxInLine )
         {
-            // It is ok, read and convert the data.
-            QList<quint16> list;
-            quint16 tmp;
-            for ( int i = 0 ; i < quantityOfInputRegisters ; i++ )
+            const char *start = (const char *)memchr( _rxBuffer + _rxBegin , ':' , _rxEnd - _rxBegin );
+            if ( !start )
             {
-                rxStream >> tmp;
-                list.append( tmp );
+                _rxBegin = _rxEnd;
+                continue;
             }
-            if ( status ) *status = Ok;
-            return list;
+            _rxBegin = start - _rxBuffer;
+            _rxInLine = true;
+        }
+
+        // Copy up to the end of the line or of the buffered bytes.
+        const char *end = (const char *)memchr( _rxBuffer + _rxBegin , '\n' , _rxEnd - _rxBegin );
+        const int available = ( end ? end - _rxBuffer + 1 : _rxEnd ) - _rxBegin;
+        const int size = qMin( available , maxSize - count );
+        memcpy( data + count , _rxBuffer + _rxBegin , size );
+        _rxBegin += size;
+        count += size;
+        if ( end && size == available )
+        {
+            _rxInLine = false;
+            break;
         }
     }
 
-    // If we arrive here, something went wrong.
-    if ( status ) *status = UnknownError;
-    return QList<quint16>();
+    return count;
 }
 
-bool QAsciiModbus::writeSingleCoil( const quint8 deviceAddress , const quint16 outputAddress ,
-                                     const bool outputValue , quint8 *const status ) const
+void QAsciiModbus::_clearReceiveBuffer( void ) const
 {
-    // Are we connected ?
-    if ( !isOpen() )
-    {
-        if ( status ) *status = NoConnection;
-        return false;
-    }
-
-    // Create modbus write single coil pdu (Modbus uses Big Endian).
-    QByteArray pdu;
-    QDataStream pduStream( &pdu , QIODevice::WriteOnly );
-    pduStream.setByteOrder( QDataStream::BigEndian );
-    pduStream << deviceAddress << (quint8)0x05 << outputAddress << ( outputValue ? (quint16)0xFF00 : (quint16)0x0000 );
-
-    // Encode to hex.
-    QByteArray hexEncoded( ":" );
-    hexEncoded += pdu.toHex().toUpper();
+    _rxBegin = _rxEnd = 0;
+    _rxInLine = false;
+}
 
-    // Calculate LRC and add it to the PDU.
-    hexEncoded += QString( "%1" ).arg( _calculateLrc( pdu ) , 2 , 16 , QChar( '0' ) ).toUpper();
-    hexEncoded += 0x0D;
-    hexEncoded += 0x0A;
 
-    // Send the pdu.
-    _write( hexEncoded );
+# /***/ ifdef Q_OS_WIN /***********************************************************************************************/
 
-    // Await response.
-    pdu.clear();
-    hexEncoded.clear();
+qint64 QAsciiModbus::_read( char *const data , const qint64 maxSize ) const
+{
+    DWORD size = 0;
 
-    // Try to read line.
-    hexEncoded = _readLine( 200 );
+    if ( maxSize == 0 ) return 0;
 
-    // Handle timeout.
-    if ( hexEncoded.size() < 9 )
+    if ( ReadFile( _commPort , data , maxSize , &size , NULL ) )
     {
-        if ( status ) *status = Timeout;
-        return false;
+        return size;
     }
+    return 0;
+}
 
-    // Check LRC.
-    if ( !_checkLrc( hexEncoded ) )
-    {
-        if ( status ) *status = CrcError;
-        return false;
-    }
+bool QAsciiModbus::_write( QByteArray &data ) const
+{
+    return _write( data.constData() , data.size() );
+}
 
-    // Get the hex decoded form.
-    pdu = QByteArray::fromHex( hexEncoded.mid( 1 , hexEncoded.size() -5 ) );
+bool QAsciiModbus::_write( const char *const data , const qint64 size ) const
+{
+    DWORD written = 0;
 
-    // Was it a Modbus error?
-    if ( pdu[1] & 0x80 )
-    {
-        if ( status ) *status = pdu[2];
-        return false;
-    }
+    if ( size == 0 ) return true;
 
-    // Check data and return them on success.
-    if ( pdu.size() == 6 )
+    if ( WriteFile( _commPort , data , size , &written , NULL ) )
     {
-        // Read device address and command ID and control them.
-        quint8 rxDeviceAddress , rxFunctionCode;
-        quint16 rxOutputAddress , rxOutputValue;
-        QDataStream rxStream( pdu );
-        rxStream.setByteOrder( QDataStream::BigEndian );
-        rxStream >> rxDeviceAddress >> rxFunctionCode >> rxOutputAddress >> rxOutputValue;
-        if ( rxDeviceAddress == deviceAddress && rxFunctionCode == 0x05 && rxOutputAddress == outputAddress &&
-             ( ( outputValue && rxOutputValue == 0xFF00 ) || ( !outputValue && rxOutputValue == 0x0000 ) ) )
-        {
-            if ( status ) *status = Ok;
-            return true;
-        }
-    }
-
-    // If we arrive here, something went wrong.
-    if ( status ) *status = UnknownError;
-    return false;
-}
-
-bool QAsciiModbus::writeSingleRegister( const quint8 deviceAddress , const quint16 outputAddress ,
-                                         const quint16 registerValue , quint8 *const status ) const
-{
-    // Are we connected ?
-    if ( !isOpen() )
-    {
-        if ( status ) *status = NoConnection;
-        return false;
-    }
-
-    // Create modbus write single coil pdu (Modbus uses Big Endian).
-    QByteArray pdu;
-    QDataStream pduStream( &pdu , QIODevice::WriteOnly );
-    pduStream.setByteOrder( QDataStream::BigEndian );
-    pduStream << deviceAddress << (quint8)0x06 << outputAddress << registerValue;
-
-    // Encode to hex.
-    QByteArray hexEncoded( ":" );
-    hexEncoded += pdu.toHex().toUpper();
-
-    // Calculate LRC and add it to the PDU.
-    hexEncoded += QString( "%1" ).arg( _calculateLrc( pdu ) , 2 , 16 , QChar( '0' ) ).toUpper();
-    hexEncoded += 0x0D;
-    hexEncoded += 0x0A;
-
-    // Send the pdu.
-    _write( hexEncoded );
-
-    // Await response.
-    pdu.clear();
-    hexEncoded.clear();
-
-    // Try to read line.
-    hexEncoded = _readLine( 200 );
-
-    // Handle timeout.
-    if ( hexEncoded.size() < 9 )
-    {
-        if ( status ) *status = Timeout;
-        return false;
-    }
-
-    // Check LRC.
-    if ( !_checkLrc( hexEncoded ) )
-    {
-        if ( status ) *status = CrcError;
-        return false;
-    }
-
-    // Get the hex decoded form.
-    pdu = QByteArray::fromHex( hexEncoded.mid( 1 , hexEncoded.size() -5 ) );
-
-    // Was it a Modbus error?
-    if ( pdu[1] & 0x80 )
-    {
-        if ( status ) *status = pdu[2];
-        return false;
-    }
-
-    // Check data and return them on success.
-    if ( pdu.size() == 6 )
-    {
-        // Read device address and command ID and control them.
-        quint8 rxDeviceAddress , rxFunctionCode;
-        quint16 rxOutputAddress , rxRegisterValue;
-        QDataStream rxStream( pdu );
-        rxStream.setByteOrder( QDataStream::BigEndian );
-        rxStream >> rxDeviceAddress >> rxFunctionCode >> rxOutputAddress >> rxRegisterValue;
-        if ( rxDeviceAddress == deviceAddress && rxFunctionCode == 0x06 && rxOutputAddress == outputAddress &&
-             rxRegisterValue == registerValue )
-        {
-            if ( status ) *status = Ok;
-            return true;
-        }
-    }
-
-    // If we arrive here, something went wrong.
-    if ( status ) *status = UnknownError;
-    return false;
-}
-
-bool QAsciiModbus::writeMultipleCoils( const quint8 deviceAddress , const quint16 startingAddress ,
-                                        const QList<bool> & outputValues , quint8 *const status ) const
-{
-    // Are we connected ?
-    if ( !isOpen() )
-    {
-        if ( status ) *status = NoConnection;
-        return false;
-    }
-
-    // Create modbus write multiple coil pdu (Modbus uses Big Endian).
-    QByteArray pdu;
-    QDataStream pduStream( &pdu , QIODevice::WriteOnly );
-    pduStream.setByteOrder( QDataStream::BigEndian );
-    quint8 txBytes = outputValues.count() / 8;
-    if ( outputValues.count() % 8 != 0 ) txBytes++;
-    pduStream << deviceAddress << (quint8)0x0F << startingAddress << (quint16)outputValues.count() << txBytes;
-
-    // Encode the binary values.
-    quint8 tmp = 0;
-    for ( int i = 0 ; i < outputValues.count() ; i++ )
-    {
-        if ( i % 8 == 0 )
-        {
-            if ( i != 0 ) pduStream << tmp;
-            tmp = 0;
-        }
-        if ( outputValues[i] ) tmp |= 0x01 << ( i % 8 );
-    }
-    pduStream << tmp;
-
-    // Encode to hex.
-    QByteArray hexEncoded( ":" );
-    hexEncoded += pdu.toHex().toUpper();
-
-    // Calculate LRC and add it to the PDU.
-    hexEncoded += QString( "%1" ).arg( _calculateLrc( pdu ) , 2 , 16 , QChar( '0' ) ).toUpper();
-    hexEncoded += 0x0D;
-    hexEncoded += 0x0A;
-
-    // Send the pdu.
-    _write( hexEncoded );
-
-    // Await response.
-    pdu.clear();
-    hexEncoded.clear();
-
-    // Try to read line.
-    hexEncoded = _readLine( 200 );
-
-    // Handle timeout.
-    if ( hexEncoded.size() < 9 )
-    {
-        if ( status ) *status = Timeout;
-        return false;
-    }
-
-    // Check LRC.
-    if ( !_checkLrc( hexEncoded ) )
-    {
-        if ( status ) *status = CrcError;
-        return false;
-    }
-
-    // Get the hex decoded form.
-    pdu = QByteArray::fromHex( hexEncoded.mid( 1 , hexEncoded.size() -5 ) );
-
-    // Was it a Modbus error?
-    if ( pdu[1] & 0x80 )
-    {
-        if ( status ) *status = pdu[2];
-        return false;
-    }
-
-    // Check data and return them on success.
-    if ( pdu.size() == 6 )
-    {
-        // Read TCP fields and, device address and command ID and control them.
-        quint8 rxDeviceAddress , rxFunctionCode;
-        quint16 rxStartingAddress , rxQuantityOfOutputs;
-        QDataStream rxStream( pdu );
-        rxStream.setByteOrder( QDataStream::BigEndian );
-        rxStream >> rxDeviceAddress >> rxFunctionCode >> rxStartingAddress >> rxQuantityOfOutputs;
-        if ( rxDeviceAddress == deviceAddress && rxFunctionCode == 0x0F && rxStartingAddress == startingAddress &&
-             rxQuantityOfOutputs == outputValues.count() )
-        {
-            if ( status ) *status = Ok;
-            return true;
-        }
-    }
-
-    // If we arrive here, something went wrong.
-    if ( status ) *status = UnknownError;
-    return false;
-}
-
-bool QAsciiModbus::writeMultipleRegisters( const quint8 deviceAddress , const quint16 startingAddress ,
-                                            const QList<quint16> & registersValues , quint8 *const status ) const
-{
-    // Are we connected ?
-    if ( !isOpen() )
-    {
-        if ( status ) *status = NoConnection;
-        return false;
-    }
-
-    // Create modbus write multiple registers pdu (Modbus uses Big Endian).
-    QByteArray pdu;
-    QDataStream pduStream( &pdu , QIODevice::WriteOnly );
-    pduStream.setByteOrder( QDataStream::BigEndian );
-    quint8 txBytes = registersValues.count() * 2;
-    pduStream << deviceAddress << (quint8)0x10 << startingAddress << (quint16)registersValues.count() << txBytes;
-
-    // Encode the register values.
-    foreach ( quint16 reg , registersValues )
-    {
-        pduStream << reg;
-    }
-
-    // Encode to hex.
-    QByteArray hexEncoded( ":" );
-    hexEncoded += pdu.toHex().toUpper();
-
-    // Calculate LRC and add it to the PDU.
-    hexEncoded += QString( "%1" ).arg( _calculateLrc( pdu ) , 2 , 16 , QChar( '0' ) ).toUpper();
-    hexEncoded += 0x0D;
-    hexEncoded += 0x0A;
-
-    // Send the pdu.
-    _write( hexEncoded );
-
-    // Await response.
-    pdu.clear();
-    hexEncoded.clear();
-
-    // Try to read line.
-    hexEncoded = _readLine( 200 );
-
-    // Handle timeout.
-    if ( hexEncoded.size() < 9 )
-    {
-        if ( status ) *status = Timeout;
-        return false;
-    }
-
-    // Check LRC.
-    if ( !_checkLrc( hexEncoded ) )
-    {
-        if ( status ) *status = CrcError;
-        return false;
-    }
-
-    // Get the hex decoded form.
-    pdu = QByteArray::fromHex( hexEncoded.mid( 1 , hexEncoded.size() -5 ) );
-
-    // Was it a Modbus error?
-    if ( pdu[1] & 0x80 )
-    {
-        if ( status ) *status = pdu[2];
-        return false;
-    }
-
-    // Check data and return them on success.
-    if ( pdu.size() == 6 )
-    {
-        // Read device address and command ID and control them.
-        quint8 rxDeviceAddress , rxFunctionCode;
-        quint16 rxStartingAddress , rxQuantityOfRegisters;
-        QDataStream rxStream( pdu );
-        rxStream.setByteOrder( QDataStream::BigEndian );
-        rxStream >> rxDeviceAddress >> rxFunctionCode >> rxStartingAddress >> rxQuantityOfRegisters;
-        if ( rxDeviceAddress == deviceAddress && rxFunctionCode == 0x10 && rxStartingAddress == startingAddress &&
-             rxQuantityOfRegisters == registersValues.count() )
-        {
-            if ( status ) *status = Ok;
-            return true;
-        }
-    }
-
-    // If we arrive here, something went wrong.
-    if ( status ) *status = UnknownError;
-    return false;
-}
-
-bool QAsciiModbus::maskWriteRegister( const quint8 deviceAddress , const quint16 referenceAddress ,
-                                       const quint16 andMask , const quint16 orMask , quint8 *const status ) const
-{
-    // Are we connected ?
-    if ( !isOpen() )
-    {
-        if ( status ) *status = NoConnection;
-        return false;
-    }
-
-    // Create modbus mask write register pdu (Modbus uses Big Endian).
-    QByteArray pdu;
-    QDataStream pduStream( &pdu , QIODevice::WriteOnly );
-    pduStream.setByteOrder( QDataStream::BigEndian );
-    pduStream << deviceAddress << (quint8)0x16 << referenceAddress << andMask << orMask;
-
-    // Encode to hex.
-    QByteArray hexEncoded( ":" );
-    hexEncoded += pdu.toHex().toUpper();
-
-    // Calculate LRC and add it to the PDU.
-    hexEncoded += QString( "%1" ).arg( _calculateLrc( pdu ) , 2 , 16 , QChar( '0' ) ).toUpper();
-    hexEncoded += 0x0D;
-    hexEncoded += 0x0A;
-
-    // Send the pdu.
-    _write( hexEncoded );
-
-    // Await response.
-    pdu.clear();
-    hexEncoded.clear();
-
-    // Try to read line.
-    hexEncoded = _readLine( 200 );
-
-    // Handle timeout.
-    if ( hexEncoded.size() < 9 )
-    {
-        if ( status ) *status = Timeout;
-        return false;
-    }
-
-    // Check LRC.
-    if ( !_checkLrc( hexEncoded ) )
-    {
-        if ( status ) *status = CrcError;
-        return false;
-    }
-
-    // Get the hex decoded form.
-    pdu = QByteArray::fromHex( hexEncoded.mid( 1 , hexEncoded.size() -5 ) );
-
-    // Was it a Modbus error?
-    if ( pdu[1] & 0x80 )
-    {
-        if ( status ) *status = pdu[2];
-        return false;
-    }
-
-    // Check data and return them on success.
-    if ( pdu.size() == 8 )
-    {
-        // Read device address and command ID and control them.
-        quint8 rxDeviceAddress , rxFunctionCode;
-        quint16 rxReferenceAddress , rxAndMask , rxOrMask;
-        QDataStream rxStream( pdu );
-        rxStream.setByteOrder( QDataStream::BigEndian );
-        rxStream >> rxDeviceAddress >> rxFunctionCode >> rxReferenceAddress >> rxAndMask >> rxOrMask;
-        if ( rxDeviceAddress == deviceAddress && rxFunctionCode == 0x16 &&
-             rxReferenceAddress == referenceAddress && rxAndMask == andMask && rxOrMask == orMask )
-        {
-            if ( status ) *status = Ok;
-            return true;
-        }
-    }
-
-    // If we arrive here, something went wrong.
-    if ( status ) *status = UnknownError;
-    return false;
-}
-
-
-QList<quint16> QAsciiModbus::writeReadMultipleRegisters( const quint8 deviceAddress ,
-                                                          const quint16 writeStartingAddress ,
-                                                          const QList<quint16> & writeValues ,
-                                                          const quint16 readStartingAddress ,
-                                                          const quint16 quantityToRead , quint8 *const status ) const
-{
-    // Are we connected ?
-    if ( !isOpen() )
-    {
-        if ( status ) *status = NoConnection;
-        return QList<quint16>();
-    }
-
-    // Create modbus read holding registers pdu (Modbus uses Big Endian).
-    QByteArray pdu;
-    QDataStream pduStream( &pdu , QIODevice::WriteOnly );
-    pduStream.setByteOrder( QDataStream::BigEndian );
-    pduStream << deviceAddress << (quint8)0x17 << readStartingAddress << quantityToRead
-              << writeStartingAddress << (quint16)writeValues.count() << (quint16)( writeValues.count() * 2 );
-
-    // Add data.
-    foreach ( quint16 reg , writeValues )
-    {
-        pduStream << reg;
-    }
-
-    // Encode to hex.
-    QByteArray hexEncoded( ":" );
-    hexEncoded += pdu.toHex().toUpper();
-
-    // Calculate LRC and add it to the PDU.
-    hexEncoded += QString( "%1" ).arg( _calculateLrc( pdu ) , 2 , 16 , QChar( '0' ) ).toUpper();
-    hexEncoded += 0x0D;
-    hexEncoded += 0x0A;
-
-    // Send the pdu.
-    _write( hexEncoded );
-
-    // Await response.
-    quint16 neededRxBytes = quantityToRead * 2;
-    pdu.clear();
-    hexEncoded.clear();
-
-    // Try to read line.
-    hexEncoded = _readLine( 200 );
-
-    // Handle timeout.
-    if ( hexEncoded.size() < 9 )
-    {
-        if ( status ) *status = Timeout;
-        return QList<quint16>();
-    }
-
-    // Check LRC.
-    if ( !_checkLrc( hexEncoded ) )
-    {
-        if ( status ) *status = CrcError;
-        return QList<quint16>();
-    }
-
-    // Get the hex decoded form.
-    pdu = QByteArray::fromHex( hexEncoded.mid( 1 , hexEncoded.size() -5 ) );
-
-    // Was it a Modbus error?
-    if ( pdu[1] & 0x80 )
-    {
-        if ( status ) *status = pdu[2];
-        return QList<quint16>();
-    }
-
-    // Check data and return them on success.
-    if ( pdu.size() == neededRxBytes + 3 )
-    {
-        // Read device address and command ID and control them.
-        quint8 rxDeviceAddress , rxFunctionCode , byteCount;
-        QDataStream rxStream( pdu );
-        rxStream.setByteOrder( QDataStream::BigEndian );
-        rxStream >> rxDeviceAddress >> rxFunctionCode >> byteCount;
-
-        if ( rxDeviceAddress == deviceAddress && rxFunctionCode == 0x17 && byteCount == neededRxBytes )
-        {
-            // Generate response data.
-            QList<quint16> list;
-            quint16 tmp;
-            for ( int i = 0 ; i < quantityToRead ; i++ )
-            {
-                rxStream >> tmp;
-                list.append( tmp );
-            }
-            if ( status ) *status = Ok;
-            return list;
-        }
-    }
-
-    // If we arrive here, something went wrong.
-    if ( status ) *status = UnknownError;
-    return QList<quint16>();
-}
-
-QList<quint16> QAsciiModbus::readFifoQueue( const quint8 deviceAddress , const quint16 fifoPointerAddress ,
-                                             quint8 *const status ) const
-{
-    // Are we connected ?
-    if ( !isOpen() )
-    {
-        if ( status ) *status = NoConnection;
-        return QList<quint16>();
-    }
-
-    // Create modbus read holding registers pdu (Modbus uses Big Endian).
-    QByteArray pdu;
-    QDataStream pduStream( &pdu , QIODevice::WriteOnly );
-    pduStream.setByteOrder( QDataStream::BigEndian );
-    pduStream << deviceAddress << (quint8)0x18 << fifoPointerAddress;
-
-    // Encode to hex.
-    QByteArray hexEncoded( ":" );
-    hexEncoded += pdu.toHex().toUpper();
-
-    // Calculate LRC and add it to the PDU.
-    hexEncoded += QString( "%1" ).arg( _calculateLrc( pdu ) , 2 , 16 , QChar( '0' ) ).toUpper();
-    hexEncoded += 0x0D;
-    hexEncoded += 0x0A;
-
-    // Send the pdu.
-    _write( hexEncoded );
-
-    // Await response.
-    pdu.clear();
-    hexEncoded.clear();
-
-    // Try to read line.
-    hexEncoded = _readLine( 200 );
-
-    // Handle timeout.
-    if ( hexEncoded.size() < 9 )
-    {
-        if ( status ) *status = Timeout;
-        return QList<quint16>();
-    }
-
-    // Check LRC.
-    if ( !_checkLrc( hexEncoded ) )
-    {
-        if ( status ) *status = CrcError;
-        return QList<quint16>();
-    }
-
-    // Get the hex decoded form.
-    pdu = QByteArray::fromHex( hexEncoded.mid( 1 , hexEncoded.size() -5 ) );
-
-    // Was it a Modbus error?
-    if ( pdu[1] & 0x80 )
-    {
-        if ( status ) *status = pdu[2];
-        return QList<quint16>();
-    }
-
-    // Check data and return them on success.
-    if ( pdu.size() >= 8 )
-    {
-        // Read TCP fields and, device address and command ID and control them.
-        quint8 rxDeviceAddress , rxFunctionCode;
-        quint16 byteCount , fifoCount;
-        QDataStream rxStream( pdu );
-        rxStream.setByteOrder( QDataStream::BigEndian );
-        rxStream >> rxDeviceAddress >> rxFunctionCode >> byteCount >> fifoCount;
-
-        if ( rxDeviceAddress == deviceAddress && rxFunctionCode == 0x18 && byteCount == fifoCount * 2 )
-        {
-            QList<quint16> list;
-            quint16 tmp;
-            for ( int i = 0 ; i < fifoCount ; i++ )
-            {
-                rxStream >> tmp;
-                list.append( tmp );
-            }
-            if ( status ) *status = Ok;
-            return list;
-        }
-    }
-
-    // Something went wrong...
-    if ( status ) *status = UnknownError;
-    return QList<quint16>();
-}
-
-QByteArray QAsciiModbus::executeCustomFunction( const quint8 deviceAddress , const quint8 modbusFunction ,
-                                                 QByteArray &data , quint8 *const status ) const
-{
-    // Are we connected ?
-    if ( !isOpen() )
-    {
-        if ( status ) *status = NoConnection;
-        return QByteArray();
-    }
-
-    // Create modbus pdu (Modbus uses Big Endian).
-    QByteArray pdu;
-    QDataStream pduStream( &pdu , QIODevice::WriteOnly );
-    pduStream.setByteOrder( QDataStream::BigEndian );
-    pduStream << deviceAddress << modbusFunction;
-    pduStream.writeRawData( data.data() , data.size() );
-
-    // Encode to hex.
-    QByteArray hexEncoded( ":" );
-    hexEncoded += pdu.toHex().toUpper();
-
-    // Calculate LRC and add it to the PDU.
-    hexEncoded += QString( "%1" ).arg( _calculateLrc( pdu ) , 2 , 16 , QChar( '0' ) ).toUpper();
-    hexEncoded += 0x0D;
-    hexEncoded += 0x0A;
-
-    // Send the pdu.
-    _write( hexEncoded );
-
-    // Await response.
-    pdu.clear();
-    hexEncoded.clear();
-
-    // Try to read line.
-    hexEncoded = _readLine( 2000 );
-
-    // Handle timeout.
-    if ( hexEncoded.size() < 9 )
-    {
-        if ( status ) *status = Timeout;
-        return QByteArray();
-    }
-
-    // Check LRC.
-    if ( !_checkLrc( hexEncoded ) )
-    {
-        if ( status ) *status = CrcError;
-        return QByteArray();
-    }
-
-    // Get the hex decoded form.
-    pdu = QByteArray::fromHex( hexEncoded.mid( 1 , hexEncoded.size() -5 ) );
-
-    // Was it a Modbus error?
-    if ( pdu[1] & 0x80 )
-    {
-        if ( status ) *status = pdu[2];
-        return QByteArray();
-    }
-
-    // Check data and return them on success.
-    if ( pdu.size() >= 4 )
-    {
-        // Read device address and command ID and control them.
-        quint8 rxDeviceAddress , rxFunctionCode;
-        QDataStream rxStream( pdu );
-        rxStream.setByteOrder( QDataStream::BigEndian );
-        rxStream >> rxDeviceAddress >> rxFunctionCode;
-
-        // Control values of the fields.
-        if ( rxDeviceAddress == deviceAddress && rxFunctionCode == modbusFunction )
-        {
-            // Convert data.
-            return pdu.mid( 2 ,  pdu.size() - 4 );
-        }
-    }
-
-    // Something went wrong...
-    if ( status ) *status = UnknownError;
-    return QByteArray();
-}
-
-QByteArray QAsciiModbus::executeRaw( QByteArray &data , quint8 *const status ) const
-{
-    // Are we connected ?
-    if ( !isOpen() )
-    {
-        if ( status ) *status = NoConnection;
-        return QByteArray();
-    }
-
-    // Encode to hex.
-    QByteArray hexEncoded( ":" );
-    hexEncoded += data.toHex().toUpper();
-    // Send the data.
-    _write( hexEncoded );
-
-    // Await response.
-    hexEncoded.clear();
-
-    // Try to read line.
-    hexEncoded = _readLine( 2000 );
-
-    // Handle timeout.
-    if ( hexEncoded.size() == 0 )
-    {
-        if ( status ) *status = Timeout;
-        return QByteArray();
-    }
-
-    // Get the hex decoded form.
-    return QByteArray::fromHex( hexEncoded );
-}
-
-QByteArray QAsciiModbus::calculateCheckSum( QByteArray &data ) const
-{
-    quint8 lrc = _calculateLrc( data );
-    return QByteArray( (char *)&lrc , 1 );
-}
-
-
-# /***/ ifdef Q_OS_WIN /***********************************************************************************************/
-
-QByteArray QAsciiModbus::_read( const int numberBytes ) const
-{
-    QByteArray data( numberBytes , 0 );
-    DWORD size = 0;
-
-    if ( numberBytes == 0 ) return data;
-
-    if ( ReadFile( _commPort , data.data() , numberBytes , &size , NULL ) )
-    {
-        data.resize( size );
-    }
-    else
-    {
-        data.resize( 0 );
-    }
-
-    return data;
-}
-
-QByteArray QAsciiModbus::_readAll( void ) const
-{
-    QByteArray data( 1024 , 0 );
-    DWORD size = 0;
-    if ( ReadFile( _commPort , data.data() , 1024 , &size , NULL ) )
-    {
-        data.resize( size );
-    }
-    else
-    {
-        data.resize( 0 );
-    }
-
-    return data;
-}
-
-QByteArray QAsciiModbus::_readLine( int maxBytes ) const
-{
-    QByteArray data;
-    DWORD size = 0;
-
-    if ( maxBytes == 0 ) return data;
-
-    while( !data.endsWith( '\n' ) && --maxBytes )
-    {
-        unsigned char c;
-        if ( ReadFile( _commPort , &c , 1 , &size , NULL ) )
-        {
-           data.append( c );
-        }
-    }
-
-    return data;
-}
-
-bool QAsciiModbus::_write( QByteArray &data ) const
-{
-    DWORD size = 0;
-
-    if ( data.size() == 0 ) return true;
-
-    if ( WriteFile( _commPort , data.constData() , data.size() , &size , NULL ) )
-    {
-        return ( (int)size == data.size() );
+        return ( (qint64)written == size );
     }
     return false;
 }
 
 # /***/ endif /* Q_OS_WIN *********************************************************************************************/
-
-
-quint8 QAsciiModbus::_calculateLrc( const QByteArray &pdu ) const
-{
-    qint8 nLRC = 0 ;
-
-    for ( int i = 0 ; i < pdu.size() ; i++ )
-        nLRC += pdu[i];
-
-    return -nLRC;
-}
-
-bool QAsciiModbus::_checkLrc( const QByteArray &pdu ) const
-{
-    if ( pdu.size() < 6 ) return false;
-
-    QByteArray msg = QByteArray::fromHex( pdu.mid( 1 , pdu.size() - 5 ) );
-    quint8 oLrc = QByteArray::fromHex( pdu.mid( pdu.size() - 4 , 2 ) )[0];
-    quint8 lrc = _calculateLrc( msg );
-
-    return oLrc == lrc;
-}
@@ -0,0 +1,223 @@
+/***********************************************************************************************************************
+* QModbusCapabilityCache implementation.                                                                              *
+***********************************************************************************************************************/
+#include <QModbusCapabilityCache>
+#include <QAbstractModbus>
+
+
+/*** Qt includes ******************************************************************************************************/
+#include <QtCore/QDataStream>
+
+
+/*** Class implementation *********************************************************************************************/
+QModbusCapabilityCache::QModbusCapabilityCache()
+{}
+
+QModbusCapabilityCache::Support QModbusCapabilityCache::support( const quint8 deviceAddress ,
+                                                                 const quint8 functionCode ) const
+{
+    return _support.value( _key( deviceAddress , functionCode ) , Unknown );
+}
+
+void QModbusCapabilityCache::setSupport( const quint8 deviceAddress , const quint8 functionCode ,
+                                         const Support support )
+{
+    if ( support == Unknown )
+    {
+        _support.remove( _key( deviceAddress , functionCode ) );
+    }
+    else
+    {
+        _support.insert( _key( deviceAddress , functionCode ) , support );
+    }
+}
+
+void QModbusCapabilityCache::record( const quint8 deviceAddress , const quint8 functionCode , const quint8 status )
+{
+    if ( status == QAbstractModbus::Ok )
+    {
+        setSupport( deviceAddress , functionCode , Supported );
+    }
+    else if ( status == QAbstractModbus::IllegalFunction )
+    {
+        setSupport( deviceAddress , functionCode , Unsupported );
+    }
+}
+
+QList<quint8> QModbusCapabilityCache::devices( void ) const
+{
+    // The device address is the high byte of all keys.
+    bool known[0x100] = { false };
+    foreach ( quint16 key , _support.keys() ) known[key >> 8] = true;
+    foreach ( quint16 key , _maximum.keys() ) known[key >> 8] = true;
+    foreach ( quint16 key , _windows.keys() ) known[key >> 8] = true;
+
+    QList<quint8> list;
+    for ( int device = 0 ; device < 0x100 ; device++ )
+    {
+        if ( known[device] ) list.append( device );
+    }
+    return list;
+}
+
+quint16 QModbusCapabilityCache::standardMaximumQuantity( const quint8 functionCode )
+{
+    switch( functionCode )
+    {
+        case 0x01:
+        case 0x02:
+            return 2000;
+
+        case 0x03:
+        case 0x04:
+        case 0x17:
+            return 125;
+
+        case 0x0F:
+            return 1968;
+
+        case 0x10:
+            return 123;
+
+        default:
+            return 0;
+    }
+}
+
+quint16 QModbusCapabilityCache::maximumQuantity( const quint8 deviceAddress , const quint8 functionCode ) const
+{
+    return _maximum.value( _key( deviceAddress , functionCode ) , standardMaximumQuantity( functionCode ) );
+}
+
+void QModbusCapabilityCache::setMaximumQuantity( const quint8 deviceAddress , const quint8 functionCode ,
+                                                 const quint16 quantity )
+{
+    const quint16 maximum = qMin( quantity , standardMaximumQuantity( functionCode ) );
+    if ( maximum == 0 )
+    {
+        _maximum.remove( _key( deviceAddress , functionCode ) );
+    }
+    else
+    {
+        _maximum.insert( _key( deviceAddress , functionCode ) , maximum );
+    }
+}
+
+bool QModbusCapabilityCache::addressWindow( const quint8 deviceAddress , const QAbstractModbus::Table table ,
+                                            quint16 *const firstAddress , quint16 *const lastAddress ) const
+{
+    const quint16 key = _key( deviceAddress , table );
+    const Window window = _windows.value( key );
+    if ( firstAddress ) *firstAddress = window.first;
+    if ( lastAddress ) *lastAddress = window.last;
+    return _windows.contains( key );
+}
+
+void QModbusCapabilityCache::setAddressWindow( const quint8 deviceAddress , const QAbstractModbus::Table table ,
+                                               const quint16 firstAddress , const quint16 lastAddress )
+{
+    if ( lastAddress < firstAddress )
+    {
+        _windows.remove( _key( deviceAddress , table ) );
+    }
+    else
+    {
+        Window window;
+        window.first = firstAddress;
+        window.last = lastAddress;
+        _windows.insert( _key( deviceAddress , table ) , window );
+    }
+}
+
+bool QModbusCapabilityCache::save( QIODevice &device ) const
+{
+    // Header, then each hash as a count followed by (key, value) pairs.
+    QDataStream stream( &device );
+    stream << (quint32)Magic << (quint16)Version;
+
+    stream << (quint32)_support.count();
+    for ( QHash<quint16,Support>::const_iterator i = _support.constBegin() ; i != _support.constEnd() ; ++i )
+    {
+        stream << i.key() << (quint8)i.value();
+    }
+
+    stream << (quint32)_maximum.count();
+    for ( QHash<quint16,quint16>::const_iterator i = _maximum.constBegin() ; i != _maximum.constEnd() ; ++i )
+    {
+        stream << i.key() << i.value();
+    }
+
+    stream << (quint32)_windows.count();
+    for ( QHash<quint16,Window>::const_iterator i = _windows.constBegin() ; i != _windows.constEnd() ; ++i )
+    {
+        stream << i.key() << i.value().first << i.value().last;
+    }
+
+    return stream.status() == QDataStream::Ok;
+}
+
+bool QModbusCapabilityCache::load( QIODevice &device )
+{
+    QDataStream stream( &device );
+    quint32 magic = 0 , count = 0;
+    quint16 version = 0 , key = 0;
+    stream >> magic >> version;
+    if ( stream.status() != QDataStream::Ok || magic != Magic || version != Version ) return false;
+
+    // Read into temporaries, so a truncated file leaves the cache as it was.
+    QHash<quint16,Support> support;
+    stream >> count;
+    for ( quint32 i = 0 ; i < count && stream.status() == QDataStream::Ok ; i++ )
+    {
+        quint8 value = Unknown;
+        stream >> key >> value;
+        if ( value == Supported || value == Unsupported ) support.insert( key , (Support)value );
+    }
+
+    QHash<quint16,quint16> maximum;
+    stream >> count;
+    for ( quint32 i = 0 ; i < count && stream.status() == QDataStream::Ok ; i++ )
+    {
+        quint16 quantity = 0;
+        stream >> key >> quantity;
+        quantity = qMin( quantity , standardMaximumQuantity( key & 0xFF ) );
+        if ( quantity ) maximum.insert( key , quantity );
+    }
+
+    QHash<quint16,Window> windows;
+    stream >> count;
+    for ( quint32 i = 0 ; i < count && stream.status() == QDataStream::Ok ; i++ )
+    {
+        Window window;
+        stream >> key >> window.first >> window.last;
+        if ( window.first <= window.last ) windows.insert( key , window );
+    }
+
+    if ( stream.status() != QDataStream::Ok ) return false;
+    _support = support;
+    _maximum = maximum;
+    _windows = windows;
+    return true;
+}
+
+void QModbusCapabilityCache::clear( const quint8 deviceAddress )
+{
+    for ( int function = 0 ; function < 0x100 ; function++ )
+    {
+        _support.remove( _key( deviceAddress , function ) );
+        _maximum.remove( _key( deviceAddress , function ) );
+        _windows.remove( _key( deviceAddress , function ) );
+    }
+}
+
+void QModbusCapabilityCache::clear( void )
+{
+    _support.clear();
+    _maximum.clear();
+    _windows.clear();
+}
+
+quint16 QModbusCapabilityCache::_key( const quint8 deviceAddress , const quint8 functionCode )
+{
+    return ( (quint16)deviceAddress << 8 ) | functionCode;
+}
@@ -0,0 +1,397 @@
+/***********************************************************************************************************************
+* QModbusCapabilityProber implementation.                                                                             *
+***********************************************************************************************************************/
+#include <QModbusCapabilityProber>
+
+
+/*** Qt includes ******************************************************************************************************/
+#include <QModbusFrame>
+#include <QModbusPdu>
+
+
+/*** Class implementation *********************************************************************************************/
+QModbusCapabilityProber::QModbusCapabilityProber( const QAbstractModbus &modbus ,
+                                                  QModbusCapabilityCache *const cache ) :
+    _modbus( modbus ) , _cache( cache ? cache : &_ownCache ) , _maximumProbes( 64 ) , _probes( 0 ) , _nested( false )
+{}
+
+QModbusCapabilityCache &QModbusCapabilityProber::capabilities( void ) const
+{
+    return *_cache;
+}
+
+int QModbusCapabilityProber::maximumProbes( void ) const
+{
+    return _maximumProbes;
+}
+
+void QModbusCapabilityProber::setMaximumProbes( const int probes )
+{
+    _maximumProbes = qBound( 1 , probes , 1024 );
+}
+
+int QModbusCapabilityProber::probeCount( void ) const
+{
+    return _probes;
+}
+
+QModbusCapabilityCache::Support QModbusCapabilityProber::probeFunction( const quint8 deviceAddress ,
+                                                                        const quint8 functionCode ,
+                                                                        quint8 *const status ) const
+{
+    _begin();
+
+    // Build a request every device implementing the function rejects without side effects.
+    char pdu[QModbusPdu::MaxSize];
+    int size = 0;
+    switch( functionCode )
+    {
+        case 0x01:
+        case 0x02:
+        case 0x03:
+        case 0x04:
+            size = QModbusReadRegistersPdu::encode( pdu , functionCode , 0 , 0 );
+            break;
+
+        case 0x05:
+            size = QModbusWriteSinglePdu::encode( pdu , functionCode , 0 , 0x1234 );
+            break;
+
+        case 0x0F:
+        case 0x10:
+            QModbusWriteMultiplePdu::encode( pdu , functionCode , 0 , 0 );
+            size = QModbusWriteMultiplePdu::setDataSize( pdu , 0 );
+            break;
+
+        case 0x16:
+        {
+            // The mask write leaves the register unchanged, but is a write: target an address outside the known window
+            // of the holding registers, so the device answers with an illegal data address exception instead.
+            quint16 address = 0;
+            _outsideWindow( deviceAddress , &address );
+            size = QModbusMaskWritePdu::encode( pdu , functionCode , address , 0xFFFF , 0x0000 );
+            break;
+        }
+
+        case 0x17:
+            QModbusReadWritePdu::encode( pdu , functionCode , 0 , 0 , 0 , 0 );
+            size = QModbusReadWritePdu::setDataSize( pdu , 0 );
+            break;
+
+        default:
+            if ( status ) *status = QAbstractModbus::IllegalDataValue;
+            return QModbusCapabilityCache::Unknown;
+    }
+
+    if ( !_mayProbe( 1 ) )
+    {
+        if ( status ) *status = QAbstractModbus::Timeout;
+        return QModbusCapabilityCache::Unknown;
+    }
+
+    QModbusPduFrame response;
+    quint8 result = QAbstractModbus::UnknownError;
+    _probes++;
+    _modbus.executePdu( deviceAddress , QModbusFrameView( pdu , size ) , response , &result );
+
+    // Any answer but an illegal function exception shows that the device decoded the function.
+    QModbusCapabilityCache::Support support = QModbusCapabilityCache::Unknown;
+    switch( result )
+    {
+        case QAbstractModbus::Ok:
+        case QAbstractModbus::IllegalDataAddress:
+        case QAbstractModbus::IllegalDataValue:
+        case QAbstractModbus::SlaveDeviceFailure:
+            support = QModbusCapabilityCache::Supported;
+            break;
+
+        case QAbstractModbus::IllegalFunction:
+            support = QModbusCapabilityCache::Unsupported;
+            break;
+
+        default:
+            if ( status ) *status = result;
+            return QModbusCapabilityCache::Unknown;
+    }
+
+    _cache->setSupport( deviceAddress , functionCode , support );
+    if ( status ) *status = QAbstractModbus::Ok;
+    return support;
+}
+
+bool QModbusCapabilityProber::probeAddressWindow( const quint8 deviceAddress , const QAbstractModbus::Table table ,
+                                                  const quint16 address , quint8 *const status ) const
+{
+    _begin();
+    quint8 result = QAbstractModbus::Timeout;
+
+    // The search starts from an address known to be readable.
+    if ( !_mayProbe( 1 ) || _test( deviceAddress , table , address , 1 , false , result ) != Accepted )
+    {
+        if ( status ) *status = result;
+        return false;
+    }
+
+    // Binary search the last readable address in [address, 65535], then the first one in [0, address].
+    qint32 good = address , bad = 0x10000;
+    while ( bad - good > 1 )
+    {
+        const qint32 middle = ( good + bad ) / 2;
+        result = QAbstractModbus::Timeout;
+        const Outcome outcome = _mayProbe( 1 ) ? _test( deviceAddress , table , middle , 1 , false , result ) : Failed;
+        if ( outcome == Failed )
+        {
+            if ( status ) *status = result;
+            return false;
+        }
+        if ( outcome == Accepted )
+        {
+            good = middle;
+        }
+        else
+        {
+            bad = middle;
+        }
+    }
+    const quint16 lastAddress = good;
+
+    good = address;
+    bad = -1;
+    while ( good - bad > 1 )
+    {
+        const qint32 middle = ( good + bad ) / 2;
+        result = QAbstractModbus::Timeout;
+        const Outcome outcome = _mayProbe( 1 ) ? _test( deviceAddress , table , middle , 1 , false , result ) : Failed;
+        if ( outcome == Failed )
+        {
+            if ( status ) *status = result;
+            return false;
+        }
+        if ( outcome == Accepted )
+        {
+            good = middle;
+        }
+        else
+        {
+            bad = middle;
+        }
+    }
+
+    _cache->setAddressWindow( deviceAddress , table , good , lastAddress );
+    if ( status ) *status = QAbstractModbus::Ok;
+    return true;
+}
+
+quint16 QModbusCapabilityProber::probeReadSize( const quint8 deviceAddress , const QAbstractModbus::Table table ,
+                                                const quint16 startingAddress , quint8 *const status ) const
+{
+    _begin();
+
+    // Stay within the address window if known.
+    quint16 lastAddress = 0xFFFF;
+    _cache->addressWindow( deviceAddress , table , NULL , &lastAddress );
+    const quint32 limit = qMin( (quint32)QModbusCapabilityCache::standardMaximumQuantity( table ) ,
+                                lastAddress >= startingAddress ? (quint32)lastAddress - startingAddress + 1 : 0 );
+    if ( limit == 0 )
+    {
+        if ( status ) *status = QAbstractModbus::IllegalDataAddress;
+        return 0;
+    }
+
+    return _search( deviceAddress , table , startingAddress , table , limit , false , status );
+}
+
+quint16 QModbusCapabilityProber::probeWriteSize( const quint8 deviceAddress , const QAbstractModbus::Table table ,
+                                                 const quint16 startingAddress , quint8 *const status ) const
+{
+    _begin();
+    if ( table != QAbstractModbus::Coils && table != QAbstractModbus::HoldingRegisters )
+    {
+        if ( status ) *status = QAbstractModbus::IllegalDataValue;
+        return 0;
+    }
+
+    // The values written back are read first, so the writes can not be larger than the reads.
+    const quint8 functionCode = table == QAbstractModbus::Coils ? 0x0F : 0x10;
+    quint16 lastAddress = 0xFFFF;
+    _cache->addressWindow( deviceAddress , table , NULL , &lastAddress );
+    quint32 limit = qMin( QModbusCapabilityCache::standardMaximumQuantity( functionCode ) ,
+                          _cache->maximumQuantity( deviceAddress , table ) );
+    limit = qMin( limit , lastAddress >= startingAddress ? (quint32)lastAddress - startingAddress + 1 : 0 );
+    if ( limit == 0 )
+    {
+        if ( status ) *status = QAbstractModbus::IllegalDataAddress;
+        return 0;
+    }
+
+    return _search( deviceAddress , table , startingAddress , functionCode , limit , true , status );
+}
+
+bool QModbusCapabilityProber::probe( const quint8 deviceAddress , const QAbstractModbus::Table table ,
+                                     const quint16 address , quint8 *const status ) const
+{
+    // All probes share one budget.
+    _begin();
+    _nested = true;
+
+    quint8 result = QAbstractModbus::Ok;
+    bool ok = probeFunction( deviceAddress , table , &result ) == QModbusCapabilityCache::Supported;
+    if ( result == QAbstractModbus::Ok && !ok ) result = QAbstractModbus::IllegalFunction;
+
+    // Search the read size from the start of the window, so the window does not hide the device's limit.
+    quint16 firstAddress = 0;
+    ok = ok && probeAddressWindow( deviceAddress , table , address , &result );
+    _cache->addressWindow( deviceAddress , table , &firstAddress , NULL );
+    ok = ok && probeReadSize( deviceAddress , table , firstAddress , &result ) > 0 && result == QAbstractModbus::Ok;
+
+    // Learn the write functions of the table, a failure stops, an unsupported function does not.
+    QList<quint8> functions;
+    if ( table == QAbstractModbus::Coils ) functions << 0x05 << 0x0F;
+    if ( table == QAbstractModbus::HoldingRegisters ) functions << 0x10 << 0x17;
+    if ( table == QAbstractModbus::HoldingRegisters && _outsideWindow( deviceAddress , NULL ) ) functions << 0x16;
+    foreach ( quint8 function , functions )
+    {
+        if ( !ok ) break;
+        probeFunction( deviceAddress , function , &result );
+        ok = result == QAbstractModbus::Ok;
+    }
+
+    _nested = false;
+    if ( status ) *status = result;
+    return ok;
+}
+
+QModbusCapabilityProber::Outcome QModbusCapabilityProber::_test( const quint8 deviceAddress ,
+                                                                 const QAbstractModbus::Table table ,
+                                                                 const quint16 startingAddress ,
+                                                                 const quint16 quantity , const bool write ,
+                                                                 quint8 &status ) const
+{
+    const bool bits = table == QAbstractModbus::Coils || table == QAbstractModbus::DiscreteInputs;
+    QList<bool> coils;
+    QList<quint16> registers;
+    int count = 0;
+
+    // Read the range.
+    _probes++;
+    switch( table )
+    {
+        case QAbstractModbus::Coils:
+            coils = _modbus.readCoils( deviceAddress , startingAddress , quantity , &status );
+            break;
+
+        case QAbstractModbus::DiscreteInputs:
+            coils = _modbus.readDiscreteInputs( deviceAddress , startingAddress , quantity , &status );
+            break;
+
+        case QAbstractModbus::HoldingRegisters:
+            registers = _modbus.readHoldingRegisters( deviceAddress , startingAddress , quantity , &status );
+            break;
+
+        case QAbstractModbus::InputRegisters:
+            registers = _modbus.readInputRegisters( deviceAddress , startingAddress , quantity , &status );
+            break;
+    }
+    count = bits ? coils.count() : registers.count();
+    if ( status == QAbstractModbus::Ok && count != quantity ) status = QAbstractModbus::UnknownError;
+    _cache->record( deviceAddress , table , status );
+    if ( !write ) return _outcome( status );
+
+    // Write the values back unchanged. A failed read stops the probe, its limits are not the write's.
+    if ( status != QAbstractModbus::Ok ) return Failed;
+    _probes++;
+    if ( bits )
+    {
+        _modbus.writeMultipleCoils( deviceAddress , startingAddress , coils , &status );
+        _cache->record( deviceAddress , 0x0F , status );
+    }
+    else
+    {
+        _modbus.writeMultipleRegisters( deviceAddress , startingAddress , registers , &status );
+        _cache->record( deviceAddress , 0x10 , status );
+    }
+    return _outcome( status );
+}
+
+QModbusCapabilityProber::Outcome QModbusCapabilityProber::_outcome( const quint8 status )
+{
+    switch( status )
+    {
+        case QAbstractModbus::Ok:
+            return Accepted;
+
+        case QAbstractModbus::IllegalDataAddress:
+        case QAbstractModbus::IllegalDataValue:
+            return Rejected;
+
+        default:
+            return Failed;
+    }
+}
+
+bool QModbusCapabilityProber::_outsideWindow( const quint8 deviceAddress , quint16 *const address ) const
+{
+    quint16 firstAddress = 0 , lastAddress = 0xFFFF;
+    if ( !_cache->addressWindow( deviceAddress , QAbstractModbus::HoldingRegisters , &firstAddress , &lastAddress ) ||
+         ( firstAddress == 0 && lastAddress == 0xFFFF ) ) return false;
+
+    if ( address ) *address = firstAddress > 0 ? firstAddress - 1 : lastAddress + 1;
+    return true;
+}
+
+void QModbusCapabilityProber::_begin( void ) const
+{
+    if ( !_nested ) _probes = 0;
+}
+
+bool QModbusCapabilityProber::_mayProbe( const int requests ) const
+{
+    return _probes + requests <= _maximumProbes;
+}
+
+quint16 QModbusCapabilityProber::_search( const quint8 deviceAddress , const QAbstractModbus::Table table ,
+                                          const quint16 startingAddress , const quint8 functionCode ,
+                                          const quint16 limit , const bool write , quint8 *const status ) const
+{
+    // Try the limit first, most devices accept it. Then binary search between the largest quantity accepted and the
+    // smallest one rejected.
+    const int requests = write ? 2 : 1;
+    quint32 good = 0 , bad = (quint32)limit + 1;
+    quint8 result = QAbstractModbus::Ok;
+    bool sized = false;
+    while ( bad - good > 1 )
+    {
+        if ( !_mayProbe( requests ) )
+        {
+            result = QAbstractModbus::Timeout;
+            break;
+        }
+
+        const quint32 quantity = good == 0 && bad == (quint32)limit + 1 ? limit : ( good + bad ) / 2;
+        switch( _test( deviceAddress , table , startingAddress , quantity , write , result ) )
+        {
+            case Accepted:
+                good = quantity;
+                break;
+
+            case Rejected:
+                // Only an illegal data value tells about the size, an illegal data address about the window.
+                sized = sized || result == QAbstractModbus::IllegalDataValue;
+                bad = quantity;
+                break;
+
+            case Failed:
+                if ( status ) *status = result;
+                return 0;
+        }
+    }
+
+    // The size is a property of the device if a quantity was refused or the standard maximum accepted.
+    if ( good > 0 && ( sized || good == QModbusCapabilityCache::standardMaximumQuantity( functionCode ) ) )
+    {
+        _cache->setMaximumQuantity( deviceAddress , functionCode , good );
+    }
+
+    if ( status ) *status = good > 0 && result != QAbstractModbus::Timeout ? (quint8)QAbstractModbus::Ok : result;
+    return good;
+}
@@ -0,0 +1,216 @@
+/***********************************************************************************************************************
+* QModbusChangeFilter implementation.                                                                                 *
+***********************************************************************************************************************/
+#include <QModbusChangeFilter>
+
+
+/*** System includes **************************************************************************************************/
+#include <string.h>
+#ifdef __SSE2__
+#   include <emmintrin.h>
+#endif
+
+
+/*** Helper functions *************************************************************************************************/
+static inline int lowestSetBit( const quint64 word )
+{
+#if defined( __GNUC__ )
+    return __builtin_ctzll( word );
+#else
+    int bit = 0;
+    while ( !( word & ( (quint64)1 << bit ) ) ) bit++;
+    return bit;
+#endif
+}
+
+
+/*** Class implementation *********************************************************************************************/
+QModbusChangeFilter::QModbusChangeFilter( const ValueType valueType , const DeadbandMode deadbandMode ,
+                                          const double deadband ) :
+    _valueType( valueType ) , _deadbandMode( deadbandMode ) , _deadband( deadband ) , _valid( false ) , _count( 0 )
+{}
+
+QModbusChangeFilter::ValueType QModbusChangeFilter::valueType( void ) const
+{
+    return _valueType;
+}
+
+QModbusChangeFilter::DeadbandMode QModbusChangeFilter::deadbandMode( void ) const
+{
+    return _deadbandMode;
+}
+
+double QModbusChangeFilter::deadband( void ) const
+{
+    return _deadband;
+}
+
+void QModbusChangeFilter::reset( void )
+{
+    _valid = false;
+}
+
+QList<int> QModbusChangeFilter::compare( const QList<quint16> &values )
+{
+    const int count = values.count();
+    const int width = ( _valueType == UInt16 || _valueType == Int16 ) ? 1 : 2;
+    QList<int> changed;
+
+    // Contiguous copy of the new sample, the buffer is reused from sample to sample.
+    _current.resize( count );
+    quint16 *current = _current.data();
+    for ( int i = 0 ; i < count ; i++ ) current[i] = values.at( i );
+
+    // Without a comparable previous sample, everything changed.
+    if ( !_valid || _count != count )
+    {
+        for ( int i = 0 ; i + width <= count ; i += width ) changed.append( i );
+        qSwap( _previous , _current );
+        _valid = true;
+        _count = count;
+        return changed;
+    }
+
+    // Find the differing registers, the common case of no deadband on plain registers is done here.
+    QList<int> differing;
+    _diff( _previous.constData() , current , count , differing );
+    if ( width == 1 && _deadbandMode == NoDeadband )
+    {
+        qSwap( _previous , _current );
+        return differing;
+    }
+
+    // Apply the deadband per value. The previous sample only takes over reported values, so that slow drifts are
+    // reported as soon as they exceed the deadband.
+    quint16 *previous = _previous.data();
+    int last = -1;
+    foreach ( int i , differing )
+    {
+        const int index = i - i % width;
+        if ( index == last || index + width > count ) continue;
+        last = index;
+
+        if ( _deadbandMode != NoDeadband )
+        {
+            const double reported = _value( previous , index );
+            const double limit = _deadbandMode == AbsoluteDeadband ? _deadband : qAbs( reported ) * _deadband / 100.0;
+            if ( qAbs( _value( current , index ) - reported ) <= limit ) continue;
+        }
+
+        for ( int j = 0 ; j < width ; j++ ) previous[index + j] = current[index + j];
+        changed.append( index );
+    }
+
+    return changed;
+}
+
+QList<int> QModbusChangeFilter::compare( const QList<bool> &values )
+{
+    const int count = values.count();
+    const int words = ( count + 63 ) / 64;
+    QList<int> changed;
+
+    // Pack the new sample, unused bits of the last word stay cleared.
+    _currentBits.fill( 0 , words );
+    quint64 *current = _currentBits.data();
+    for ( int i = 0 ; i < count ; i++ )
+    {
+        if ( values.at( i ) ) current[i >> 6] |= (quint64)1 << ( i & 63 );
+    }
+
+    // Without a comparable previous sample, everything changed.
+    if ( !_valid || _count != count )
+    {
+        for ( int i = 0 ; i < count ; i++ ) changed.append( i );
+        _valid = true;
+        _count = count;
+    }
+    else
+    {
+        _diff( _previousBits.constData() , current , words , changed );
+    }
+
+    qSwap( _previousBits , _currentBits );
+    return changed;
+}
+
+void QModbusChangeFilter::_diff( const quint16 *a , const quint16 *b , const int count , QList<int> &changed )
+{
+    int i = 0;
+
+#ifdef __SSE2__
+    // 8 registers at a time. The byte mask has two bits set for each equal register.
+    for ( ; i + 8 <= count ; i += 8 )
+    {
+        const int equal = _mm_movemask_epi8( _mm_cmpeq_epi16( _mm_loadu_si128( (const __m128i *)( a + i ) ) ,
+                                                              _mm_loadu_si128( (const __m128i *)( b + i ) ) ) );
+        if ( equal == 0xFFFF ) continue;
+        for ( int j = 0 ; j < 8 ; j++ )
+        {
+            if ( ( ( equal >> ( 2 * j ) ) & 0x03 ) != 0x03 ) changed.append( i + j );
+        }
+    }
+#endif
+
+    // 4 registers at a time.
+    for ( ; i + 4 <= count ; i += 4 )
+    {
+        quint64 x , y;
+        memcpy( &x , a + i , sizeof( x ) );
+        memcpy( &y , b + i , sizeof( y ) );
+        if ( x == y ) continue;
+        for ( int j = 0 ; j < 4 ; j++ )
+        {
+            if ( a[i + j] != b[i + j] ) changed.append( i + j );
+        }
+    }
+
+    // The rest.
+    for ( ; i < count ; i++ )
+    {
+        if ( a[i] != b[i] ) changed.append( i );
+    }
+}
+
+void QModbusChangeFilter::_diff( const quint64 *a , const quint64 *b , const int words , QList<int> &changed )
+{
+    for ( int w = 0 ; w < words ; w++ )
+    {
+        // Visit the set bits of the difference only.
+        quint64 difference = a[w] ^ b[w];
+        while ( difference )
+        {
+            changed.append( w * 64 + lowestSetBit( difference ) );
+            difference &= difference - 1;
+        }
+    }
+}
+
+double QModbusChangeFilter::_value( const quint16 *registers , const int index ) const
+{
+    const quint32 word = ( (quint32)registers[index] << 16 ) | ( _valueType >= UInt32 ? registers[index + 1] : 0 );
+
+    switch ( _valueType )
+    {
+        case UInt16:
+            return registers[index];
+
+        case Int16:
+            return (qint16)registers[index];
+
+        case UInt32:
+            return word;
+
+        case Int32:
+            return (qint32)word;
+
+        case Float32:
+        {
+            float value;
+            memcpy( &value , &word , sizeof( value ) );
+            return value;
+        }
+    }
+
+    return 0.0;
+}
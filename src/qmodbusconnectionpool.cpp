@@ -0,0 +1,404 @@
+/***********************************************************************************************************************
+* QModbusConnectionPool implementation.                                                                               *
+***********************************************************************************************************************/
+#include <QModbusConnectionPool>
+
+
+/*** Qt includes ******************************************************************************************************/
+#include <QModbusRequestCore>
+#include <QtCore/QMetaObject>
+#include <QtCore/QMutexLocker>
+
+
+/*** Request core *****************************************************************************************************/
+// I/O policy of the request core, hands the requests to the pool.
+class QModbusPoolClientIo
+{
+public:
+    explicit QModbusPoolClientIo( const QModbusPoolClient &client ) : _client( client ) {}
+
+    bool isOpen( void ) const
+    {
+        // Sockets are opened on demand, a request without any reports NoConnection itself.
+        return true;
+    }
+
+    QModbusResponse execute( const QModbusRequest &request ) const
+    {
+        return _client.execute( request );
+    }
+
+private:
+    const QModbusPoolClient &_client;
+};
+
+typedef QModbusRequestCore<QModbusRequestFraming,QModbusPoolClientIo> QModbusPoolClientCore;
+
+static inline QModbusPoolClientCore core( const QModbusPoolClient &client )
+{
+    return QModbusPoolClientCore( QModbusPoolClientIo( client ) );
+}
+
+
+/*** QModbusConnectionPool implementation *****************************************************************************/
+// Key of a gateway in the pool.
+static inline QString gatewayKey( const QString &host , const quint16 port )
+{
+    return QString( "%1:%2" ).arg( host ).arg( port );
+}
+
+QModbusConnectionPool::QModbusConnectionPool( void ) :
+    _maximumConnections( 4 ) , _maximumInFlight( 32 ) , _maximumInFlightPerUnit( 4 )
+{}
+
+QModbusConnectionPool::~QModbusConnectionPool()
+{
+    foreach ( Gateway *gateway , _gateways )
+    {
+        // Stop the I/O threads before the sockets go away.
+        qDeleteAll( gateway->clients );
+        qDeleteAll( gateway->connections );
+        qDeleteAll( gateway->transports );
+        delete gateway;
+    }
+}
+
+QModbusPoolClient *QModbusConnectionPool::client( const QString &host , const quint16 port , const quint8 unitId )
+{
+    QMutexLocker locker( &_mutex );
+
+    Gateway *const gateway = _gateway( host , port );
+    QModbusPoolClient *client = gateway->clients.value( unitId , NULL );
+    if ( !client )
+    {
+        client = new QModbusPoolClient( *this , gateway , unitId , _maximumInFlightPerUnit );
+        gateway->clients.insert( unitId , client );
+    }
+    return client;
+}
+
+int QModbusConnectionPool::connectionCount( const QString &host , const quint16 port ) const
+{
+    QMutexLocker locker( &_mutex );
+
+    Gateway *const gateway = _gateways.value( gatewayKey( host , port ) , NULL );
+    if ( !gateway ) return 0;
+
+    QMutexLocker gatewayLocker( &gateway->mutex );
+    int count = 0;
+    foreach ( const QModbusSharedConnection *connection , gateway->connections )
+    {
+        if ( connection->isOpen() ) count++;
+    }
+    return count;
+}
+
+QModbusRateLimiter *QModbusConnectionPool::rateLimiter( const QString &host , const quint16 port )
+{
+    QMutexLocker locker( &_mutex );
+    return &_gateway( host , port )->limiter;
+}
+
+int QModbusConnectionPool::maximumConnections( void ) const
+{
+    return _maximumConnections;
+}
+
+void QModbusConnectionPool::setMaximumConnections( const int count )
+{
+    QMutexLocker locker( &_mutex );
+    _maximumConnections = qMax( 1 , count );
+}
+
+int QModbusConnectionPool::maximumInFlight( void ) const
+{
+    return _maximumInFlight;
+}
+
+void QModbusConnectionPool::setMaximumInFlight( const int count )
+{
+    QMutexLocker locker( &_mutex );
+    _maximumInFlight = qMax( 1 , count );
+}
+
+int QModbusConnectionPool::maximumInFlightPerUnit( void ) const
+{
+    return _maximumInFlightPerUnit;
+}
+
+void QModbusConnectionPool::setMaximumInFlightPerUnit( const int count )
+{
+    QMutexLocker locker( &_mutex );
+    _maximumInFlightPerUnit = qMax( 1 , count );
+}
+
+QModbusConnectionPool::Gateway *QModbusConnectionPool::_gateway( const QString &host , const quint16 port )
+{
+    const QString key = gatewayKey( host , port );
+    Gateway *gateway = _gateways.value( key , NULL );
+    if ( !gateway )
+    {
+        gateway = new Gateway( _maximumConnections , _maximumInFlight );
+        gateway->host = host;
+        gateway->port = port;
+        _gateways.insert( key , gateway );
+    }
+    return gateway;
+}
+
+QModbusSharedConnection *QModbusConnectionPool::_pick( Gateway *const gateway ) const
+{
+    QMutexLocker locker( &gateway->mutex );
+    const qint64 now = gateway->clock.elapsed();
+
+    // The socket with the fewest requests in flight among those open or still connecting. A connect that did not
+    // succeed within its timeout failed: no socket is connected again for one connect timeout.
+    QModbusSharedConnection *best = NULL;
+    int load = 0;
+    for ( int i = 0 ; i < gateway->connections.count() ; i++ )
+    {
+        QModbusSharedConnection *const connection = gateway->connections.at( i );
+        const qint64 started = gateway->connectStarted.at( i );
+        const int connectTimeout = gateway->transports.at( i )->connectTimeout();
+        if ( connection->isOpen() ) gateway->connectStarted[i] = -1;
+        else if ( started >= 0 && now - started >= connectTimeout )
+        {
+            gateway->connectStarted[i] = -1;
+            gateway->retryAt = qMax( gateway->retryAt , now + connectTimeout );
+            continue;
+        }
+        else if ( started < 0 ) continue;
+
+        const int pending = connection->pendingCount();
+        if ( !best || pending < load )
+        {
+            best = connection;
+            load = pending;
+        }
+    }
+    if ( best && !load ) return best;
+    const bool retry = now >= gateway->retryAt;
+
+    // Every socket is busy, open another one if the gateway may get it. The connect is started in the I/O thread,
+    // the new socket holds the request until it is connected.
+    if ( retry && gateway->connections.count() < gateway->maximumConnections )
+    {
+        QTcpModbus *const transport = new QTcpModbus;
+        transport->setTimeout( gateway->timeout );
+        QModbusSharedConnection *const connection = new QModbusSharedConnection( *transport );
+        connection->setReconnectTimeout( transport->connectTimeout() );
+        connection->setRateLimiter( &gateway->limiter );
+        QMetaObject::invokeMethod( transport , "connectToHost" , Qt::QueuedConnection ,
+                                   Q_ARG( QString , gateway->host ) , Q_ARG( quint16 , gateway->port ) );
+        gateway->transports.append( transport );
+        gateway->connections.append( connection );
+        gateway->connectStarted.append( now );
+        return connection;
+    }
+    if ( best || !retry ) return best;
+
+    // No socket is open or connecting: reconnect them in the background, the least loaded one holds the request
+    // meanwhile.
+    for ( int i = 0 ; i < gateway->connections.count() ; i++ )
+    {
+        QMetaObject::invokeMethod( gateway->transports.at( i ) , "reconnect" , Qt::QueuedConnection );
+        gateway->connectStarted[i] = now;
+        const int pending = gateway->connections.at( i )->pendingCount();
+        if ( !best || pending < load )
+        {
+            best = gateway->connections.at( i );
+            load = pending;
+        }
+    }
+    return best;
+}
+
+
+/*** QModbusPoolClient implementation *********************************************************************************/
+QModbusPoolClient::QModbusPoolClient( const QModbusConnectionPool &pool ,
+                                      QModbusConnectionPool::Gateway *const gateway ,
+                                      const quint8 unitId , const int inFlight ) :
+    _pool( pool ) , _gateway( gateway ) , _unitId( unitId ) , _slots( inFlight )
+{}
+
+quint8 QModbusPoolClient::unitId( void ) const
+{
+    return _unitId;
+}
+
+QModbusResponse QModbusPoolClient::execute( const QModbusRequest &request ) const
+{
+    return execute( QList<QModbusRequest>() << request ).first();
+}
+
+QList<QModbusResponse> QModbusPoolClient::execute( const QList<QModbusRequest> &batch ) const
+{
+    // Submit everything within the limits before waiting, the slots are freed as the replies finish.
+    QList<QModbusReplyPointer> replies;
+    foreach ( const QModbusRequest &request , batch )
+    {
+        _slots.acquire();
+        _gateway->freeSlots.acquire();
+
+        QModbusSharedConnection *const connection = _pool._pick( _gateway );
+        if ( !connection )
+        {
+            _release( QModbusResponse( NoConnection ) , const_cast<QModbusPoolClient *>( this ) );
+            replies.append( QModbusReplyPointer() );
+            continue;
+        }
+        QModbusRequest addressed( _unitId , request.pdu() );
+        addressed.setDeadline( request.deadline() );
+        addressed.setCancellationToken( request.cancellationToken() );
+        addressed.setPriority( request.priority() );
+        replies.append( connection->submit( addressed , &_release , const_cast<QModbusPoolClient *>( this ) ) );
+    }
+
+    QList<QModbusResponse> responses;
+    foreach ( const QModbusReplyPointer &reply , replies )
+    {
+        if ( !reply )
+        {
+            responses.append( QModbusResponse( NoConnection ) );
+            continue;
+        }
+        reply->waitForFinished();
+        responses.append( reply->response() );
+    }
+    return responses;
+}
+
+bool QModbusPoolClient::isOpen( void ) const
+{
+    QMutexLocker locker( &_gateway->mutex );
+    foreach ( const QModbusSharedConnection *connection , _gateway->connections )
+    {
+        if ( connection->isOpen() ) return true;
+    }
+    return false;
+}
+
+unsigned int QModbusPoolClient::timeout( void ) const
+{
+    QMutexLocker locker( &_gateway->mutex );
+    return _gateway->timeout;
+}
+
+void QModbusPoolClient::setTimeout( const unsigned int timeout )
+{
+    QMutexLocker locker( &_gateway->mutex );
+    _gateway->timeout = timeout;
+    foreach ( QModbusSharedConnection *connection , _gateway->connections ) connection->setTimeout( timeout );
+}
+
+QList<bool> QModbusPoolClient::readCoils( const quint8 deviceAddress , const quint16 startingAddress ,
+                                          const quint16 quantityOfCoils , quint8 *const status ) const
+{
+    return core( *this ).readBits( deviceAddress , 0x01 , startingAddress , quantityOfCoils , status );
+}
+
+QList<bool> QModbusPoolClient::readDiscreteInputs( const quint8 deviceAddress , const quint16 startingAddress ,
+                                                   const quint16 quantityOfInputs , quint8 *const status ) const
+{
+    return core( *this ).readBits( deviceAddress , 0x02 , startingAddress , quantityOfInputs , status );
+}
+
+QList<quint16> QModbusPoolClient::readHoldingRegisters( const quint8 deviceAddress , const quint16 startingAddress ,
+                                                        const quint16 quantityOfRegisters ,
+                                                        quint8 *const status ) const
+{
+    return core( *this ).readRegisters( deviceAddress , 0x03 , startingAddress , quantityOfRegisters , status );
+}
+
+QList<quint16> QModbusPoolClient::readInputRegisters( const quint8 deviceAddress , const quint16 startingAddress ,
+                                                      const quint16 quantityOfInputRegisters ,
+                                                      quint8 *const status ) const
+{
+    return core( *this ).readRegisters( deviceAddress , 0x04 , startingAddress , quantityOfInputRegisters , status );
+}
+
+bool QModbusPoolClient::writeSingleCoil( const quint8 deviceAddress , const quint16 outputAddress ,
+                                         const bool outputValue , quint8 *const status ) const
+{
+    return core( *this ).writeSingleCoil( deviceAddress , outputAddress , outputValue , status );
+}
+
+bool QModbusPoolClient::writeSingleRegister( const quint8 deviceAddress , const quint16 registerAddress ,
+                                             const quint16 registerValue , quint8 *const status ) const
+{
+    return core( *this ).writeSingleRegister( deviceAddress , registerAddress , registerValue , status );
+}
+
+bool QModbusPoolClient::writeMultipleCoils( const quint8 deviceAddress , const quint16 startingAddress ,
+                                            const QList<bool> & outputValues , quint8 *const status ) const
+{
+    return core( *this ).writeMultipleCoils( deviceAddress , startingAddress , outputValues , status );
+}
+
+bool QModbusPoolClient::writeMultipleRegisters( const quint8 deviceAddress , const quint16 startingAddress ,
+                                                const QList<quint16> & registersValues , quint8 *const status ) const
+{
+    return core( *this ).writeMultipleRegisters( deviceAddress , startingAddress , registersValues , status );
+}
+
+bool QModbusPoolClient::maskWriteRegister( const quint8 deviceAddress , const quint16 referenceAddress ,
+                                           const quint16 andMask , const quint16 orMask ,
+                                           quint8 *const status ) const
+{
+    return core( *this ).maskWriteRegister( deviceAddress , referenceAddress , andMask , orMask , status );
+}
+
+QList<quint16> QModbusPoolClient::writeReadMultipleRegisters( const quint8 deviceAddress ,
+                                                              const quint16 writeStartingAddress ,
+                                                              const QList<quint16> & writeValues ,
+                                                              const quint16 readStartingAddress ,
+                                                              const quint16 quantityToRead ,
+                                                              quint8 *const status ) const
+{
+    return core( *this ).writeReadMultipleRegisters( deviceAddress , writeStartingAddress , writeValues ,
+                                                     readStartingAddress , quantityToRead , status );
+}
+
+QList<quint16> QModbusPoolClient::readFifoQueue( const quint8 deviceAddress , const quint16 fifoPointerAddress ,
+                                                 quint8 *const status ) const
+{
+    return core( *this ).readFifoQueue( deviceAddress , fifoPointerAddress , status );
+}
+
+QByteArray QModbusPoolClient::executeCustomFunction( const quint8 deviceAddress , const quint8 modbusFunction ,
+                                                     QByteArray &data , quint8 *const status ) const
+{
+    return core( *this ).executeCustomFunction( deviceAddress , modbusFunction , data , status );
+}
+
+bool QModbusPoolClient::executePdu( const quint8 deviceAddress , const QModbusFrameView &request ,
+                                    QModbusPduFrame &response , quint8 *const status ) const
+{
+    return core( *this ).executePdu( deviceAddress , request , response , status );
+}
+
+QByteArray QModbusPoolClient::executeRaw( QByteArray &data , quint8 *const status ) const
+{
+    // Raw requests only count against the limit of the gateway.
+    _gateway->freeSlots.acquire();
+    QModbusSharedConnection *const connection = _pool._pick( _gateway );
+    QByteArray response;
+    if ( connection ) response = connection->executeRaw( data , status );
+    else if ( status ) *status = NoConnection;
+    _gateway->freeSlots.release();
+    return response;
+}
+
+QByteArray QModbusPoolClient::calculateCheckSum( QByteArray &data ) const
+{
+    Q_UNUSED( data );
+    return QByteArray();
+}
+
+void QModbusPoolClient::_release( const QModbusResponse &response , void *context )
+{
+    Q_UNUSED( response );
+    QModbusPoolClient *const client = static_cast<QModbusPoolClient *>( context );
+    client->_slots.release();
+    client->_gateway->freeSlots.release();
+}
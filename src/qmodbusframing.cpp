@@ -0,0 +1,163 @@
+/***********************************************************************************************************************
+* QModbusFraming implementation.                                                                                      *
+***********************************************************************************************************************/
+#include <QModbusFraming>
+
+
+/*** System includes **************************************************************************************************/
+
+# /***/ ifdef __SSE2__ /***********************************************************************************************/
+#include <emmintrin.h>
+# /***/ endif /* __SSE2__ *********************************************************************************************/
+
+
+/*** Hex helpers ******************************************************************************************************/
+static const char hexDigits[] = "0123456789ABCDEF";
+
+// Returns the value of a hex digit or -1 if the character is not a hex digit.
+static inline int hexValue( const char c )
+{
+    if ( c >= '0' && c <= '9' ) return c - '0';
+    const char lower = c | 0x20;
+    if ( lower >= 'a' && lower <= 'f' ) return lower - 'a' + 10;
+    return -1;
+}
+
+# /***/ ifdef __SSE2__ /***********************************************************************************************/
+
+// Converts 16 hex characters to their values, clears valid for any character that is not a hex digit.
+static inline __m128i hexValues( const __m128i characters , __m128i &valid )
+{
+    const __m128i digit = _mm_sub_epi8( characters , _mm_set1_epi8( '0' ) );
+    const __m128i isDigit = _mm_and_si128( _mm_cmpgt_epi8( digit , _mm_set1_epi8( -1 ) ) ,
+                                           _mm_cmplt_epi8( digit , _mm_set1_epi8( 10 ) ) );
+    const __m128i letter = _mm_sub_epi8( _mm_or_si128( characters , _mm_set1_epi8( 0x20 ) ) , _mm_set1_epi8( 'a' ) );
+    const __m128i isLetter = _mm_and_si128( _mm_cmpgt_epi8( letter , _mm_set1_epi8( -1 ) ) ,
+                                            _mm_cmplt_epi8( letter , _mm_set1_epi8( 6 ) ) );
+    valid = _mm_and_si128( valid , _mm_or_si128( isDigit , isLetter ) );
+    return _mm_or_si128( _mm_and_si128( isDigit , digit ) ,
+                         _mm_and_si128( isLetter , _mm_add_epi8( letter , _mm_set1_epi8( 10 ) ) ) );
+}
+
+// Combines 8 pairs of nibbles (high nibble first) into 8 bytes in the low byte of each 16 bit lane.
+static inline __m128i hexPairs( const __m128i values )
+{
+    return _mm_or_si128( _mm_slli_epi16( _mm_and_si128( values , _mm_set1_epi16( 0x00FF ) ) , 4 ) ,
+                         _mm_srli_epi16( values , 8 ) );
+}
+
+// Converts 16 nibbles to upper case hex characters.
+static inline __m128i hexCharacters( const __m128i nibbles )
+{
+    const __m128i letter = _mm_and_si128( _mm_cmpgt_epi8( nibbles , _mm_set1_epi8( 9 ) ) ,
+                                          _mm_set1_epi8( 'A' - '0' - 10 ) );
+    return _mm_add_epi8( _mm_add_epi8( nibbles , _mm_set1_epi8( '0' ) ) , letter );
+}
+
+// Returns the sum of the 16 bytes (modulo 2^64).
+static inline quint64 byteSum( const __m128i bytes )
+{
+    const __m128i sums = _mm_sad_epu8( bytes , _mm_setzero_si128() );
+    return (quint64)_mm_cvtsi128_si32( sums ) + (quint64)_mm_cvtsi128_si32( _mm_srli_si128( sums , 8 ) );
+}
+
+# /***/ endif /* __SSE2__ *********************************************************************************************/
+
+
+/*** QModbusRtuFraming implementation *********************************************************************************/
+quint16 QModbusRtuFraming::crc( const char *data , const int size )
+{
+    quint16 crc = 0xFFFF;
+    for ( int i = 0 ; i < size ; i++ )
+    {
+        crc ^= (unsigned char)data[i];
+        for ( int j = 0 ; j < 8 ; j++ )
+        {
+            crc = ( crc & 0x0001 ) ? ( crc >> 1 ) ^ 0xA001 : crc >> 1;
+        }
+    }
+
+    return crc;
+}
+
+
+/*** QModbusAsciiFraming implementation *******************************************************************************/
+quint8 QModbusAsciiFraming::lrc( const char *data , const int size )
+{
+    quint8 lrc = 0;
+    for ( int i = 0 ; i < size ; i++ ) lrc += data[i];
+    return -lrc;
+}
+
+int QModbusAsciiFraming::encodeFrame( const char *data , const int size , char *hex )
+{
+    quint64 sum = 0;
+    int i = 0;
+
+# /***/ ifdef __SSE2__ /***********************************************************************************************/
+
+    // 16 bytes to 32 characters at a time.
+    for ( ; i + 16 <= size ; i += 16 )
+    {
+        const __m128i bytes = _mm_loadu_si128( (const __m128i *)( data + i ) );
+        const __m128i high = _mm_and_si128( _mm_srli_epi16( bytes , 4 ) , _mm_set1_epi8( 0x0F ) );
+        const __m128i low = _mm_and_si128( bytes , _mm_set1_epi8( 0x0F ) );
+        const __m128i highCharacters = hexCharacters( high );
+        const __m128i lowCharacters = hexCharacters( low );
+        _mm_storeu_si128( (__m128i *)( hex + 2 * i ) , _mm_unpacklo_epi8( highCharacters , lowCharacters ) );
+        _mm_storeu_si128( (__m128i *)( hex + 2 * i + 16 ) , _mm_unpackhi_epi8( highCharacters , lowCharacters ) );
+        sum += byteSum( bytes );
+    }
+
+# /***/ endif /* __SSE2__ *********************************************************************************************/
+
+    for ( ; i < size ; i++ )
+    {
+        const quint8 byte = data[i];
+        hex[2 * i] = hexDigits[byte >> 4];
+        hex[2 * i + 1] = hexDigits[byte & 0x0F];
+        sum += byte;
+    }
+
+    // Append the LRC (two's complement of the sum).
+    const quint8 lrc = -(quint8)sum;
+    hex[2 * size] = hexDigits[lrc >> 4];
+    hex[2 * size + 1] = hexDigits[lrc & 0x0F];
+    return 2 * size + 2;
+}
+
+int QModbusAsciiFraming::decodeFrame( const char *hex , const int size , char *data )
+{
+    if ( size & 1 ) return -1;
+    const int count = size / 2;
+    quint64 sum = 0;
+    int i = 0;
+
+# /***/ ifdef __SSE2__ /***********************************************************************************************/
+
+    // 32 characters to 16 bytes at a time.
+    __m128i valid = _mm_set1_epi8( -1 );
+    for ( ; i + 16 <= count ; i += 16 )
+    {
+        const __m128i first = hexValues( _mm_loadu_si128( (const __m128i *)( hex + 2 * i ) ) , valid );
+        const __m128i second = hexValues( _mm_loadu_si128( (const __m128i *)( hex + 2 * i + 16 ) ) , valid );
+        const __m128i bytes = _mm_packus_epi16( hexPairs( first ) , hexPairs( second ) );
+        _mm_storeu_si128( (__m128i *)( data + i ) , bytes );
+        sum += byteSum( bytes );
+    }
+    if ( _mm_movemask_epi8( valid ) != 0xFFFF ) return -1;
+
+# /***/ endif /* __SSE2__ *********************************************************************************************/
+
+    for ( ; i < count ; i++ )
+    {
+        const int high = hexValue( hex[2 * i] );
+        const int low = hexValue( hex[2 * i + 1] );
+        if ( high < 0 || low < 0 ) return -1;
+        data[i] = (char)( ( high << 4 ) | low );
+        sum += data[i] & 0xFF;
+    }
+
+    // The sum of the data and its LRC is zero.
+    return (quint8)sum == 0 ? count : -1;
+}
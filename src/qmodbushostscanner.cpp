@@ -0,0 +1,176 @@
+/***********************************************************************************************************************
+* QModbusHostScanner implementation.                                                                                  *
+***********************************************************************************************************************/
+#include <QModbusHostScanner>
+
+
+/*** Qt includes ******************************************************************************************************/
+#include <QtNetwork/QHostAddress>
+#include <QtNetwork/QTcpSocket>
+
+
+/*** Class implementation *********************************************************************************************/
+QModbusHostScanner::QModbusHostScanner( QObject *parent ) :
+    QObject( parent ) , _next( 0 ) , _port( 502 ) , _found( 0 ) , _scanning( false ) , _maximumConnects( 64 ) ,
+    _connectTimeout( 1000 )
+{
+    _timer.setSingleShot( true );
+    QObject::connect( &_timer , SIGNAL( timeout() ) , this , SLOT( _timerExpired() ) );
+    _clock.start();
+}
+
+QModbusHostScanner::~QModbusHostScanner()
+{
+    foreach ( QTcpSocket *socket , _attempts.keys() )
+    {
+        socket->abort();
+        delete socket;
+    }
+}
+
+int QModbusHostScanner::maximumConnects( void ) const
+{
+    return _maximumConnects;
+}
+
+void QModbusHostScanner::setMaximumConnects( const int connects )
+{
+    _maximumConnects = qBound( 1 , connects , 1024 );
+    if ( _scanning ) _launch();
+}
+
+int QModbusHostScanner::connectTimeout( void ) const
+{
+    return _connectTimeout;
+}
+
+void QModbusHostScanner::setConnectTimeout( const int msecs )
+{
+    _connectTimeout = qMax( 1 , msecs );
+}
+
+bool QModbusHostScanner::scan( const QStringList &hosts , const quint16 port )
+{
+    if ( _scanning ) return false;
+
+    _hosts = hosts;
+    _next = 0;
+    _port = port;
+    _found = 0;
+    _scanning = true;
+    _launch();
+    return true;
+}
+
+bool QModbusHostScanner::scanSubnet( const QString &address , const int prefixLength , const quint16 port )
+{
+    const QHostAddress hostAddress( address );
+    if ( _scanning || hostAddress.protocol() != QAbstractSocket::IPv4Protocol || prefixLength < 16 ||
+         prefixLength > 32 ) return false;
+
+    const quint32 mask = prefixLength == 32 ? 0xFFFFFFFF : ~( 0xFFFFFFFF >> prefixLength );
+    const quint32 network = hostAddress.toIPv4Address() & mask;
+    const quint32 size = ~mask + 1;
+
+    // The network and broadcast addresses are no hosts, except in the point to point subnets /31 and /32.
+    const quint32 first = prefixLength <= 30 ? 1 : 0;
+    const quint32 last = prefixLength <= 30 ? size - 2 : size - 1;
+    QStringList hosts;
+    for ( quint32 i = first ; i <= last ; i++ ) hosts.append( QHostAddress( network + i ).toString() );
+    return scan( hosts , port );
+}
+
+void QModbusHostScanner::cancel( void )
+{
+    if ( !_scanning ) return;
+
+    foreach ( QTcpSocket *socket , _attempts.keys() ) _finish( socket );
+    _next = _hosts.size();
+    _launch();
+}
+
+bool QModbusHostScanner::isScanning( void ) const
+{
+    return _scanning;
+}
+
+void QModbusHostScanner::_socketConnected( void )
+{
+    QTcpSocket *const socket = qobject_cast<QTcpSocket *>( sender() );
+    if ( !socket || !_attempts.contains( socket ) ) return;
+
+    const Attempt attempt = _attempts.value( socket );
+    _found++;
+    _finish( socket );
+    emit hostFound( attempt.host , _port , (int)( _clock.elapsed() - attempt.started ) );
+    _launch();
+}
+
+void QModbusHostScanner::_socketError( QAbstractSocket::SocketError error )
+{
+    Q_UNUSED( error )
+
+    // Refused, unreachable or unknown host: the host is done.
+    QTcpSocket *const socket = qobject_cast<QTcpSocket *>( sender() );
+    if ( !socket || !_attempts.contains( socket ) ) return;
+
+    _finish( socket );
+    _launch();
+}
+
+void QModbusHostScanner::_timerExpired( void )
+{
+    const qint64 now = _clock.elapsed();
+    while ( !_due.isEmpty() && _due.begin().key() <= now ) _finish( _due.begin().value() );
+    _launch();
+}
+
+void QModbusHostScanner::_launch( void )
+{
+    while ( _scanning && _attempts.size() < _maximumConnects && _next < _hosts.size() )
+    {
+        Attempt attempt;
+        attempt.host = _hosts.at( _next++ );
+        attempt.started = _clock.elapsed();
+        attempt.due = attempt.started + _connectTimeout;
+
+        QTcpSocket *const socket = new QTcpSocket( this );
+        QObject::connect( socket , SIGNAL( connected() ) , this , SLOT( _socketConnected() ) );
+        QObject::connect( socket , SIGNAL( error( QAbstractSocket::SocketError ) ) ,
+                          this , SLOT( _socketError( QAbstractSocket::SocketError ) ) );
+        _attempts.insert( socket , attempt );
+        _due.insert( attempt.due , socket );
+        socket->connectToHost( attempt.host , _port );
+    }
+    _reschedule();
+
+    if ( _scanning && _attempts.isEmpty() && _next >= _hosts.size() )
+    {
+        _scanning = false;
+        _hosts.clear();
+        emit finished( _found );
+    }
+}
+
+void QModbusHostScanner::_finish( QTcpSocket *const socket )
+{
+    // The socket may be in one of its own signals, so it is deleted later.
+    QObject::disconnect( socket , NULL , this , NULL );
+    socket->abort();
+    socket->deleteLater();
+
+    QMultiMap<qint64,QTcpSocket *>::iterator i = _due.find( _attempts.value( socket ).due );
+    while ( i != _due.end() && i.value() != socket ) ++i;
+    if ( i != _due.end() ) _due.erase( i );
+    _attempts.remove( socket );
+}
+
+void QModbusHostScanner::_reschedule( void )
+{
+    if ( _due.isEmpty() )
+    {
+        _timer.stop();
+        return;
+    }
+    _timer.start( (int)qMax( (qint64)0 , _due.begin().key() - _clock.elapsed() ) );
+}
@@ -0,0 +1,386 @@
+/***********************************************************************************************************************
+* QModbusPollScheduler implementation.                                                                                *
+***********************************************************************************************************************/
+#include <QModbusPollScheduler>
+
+
+/*** System includes **************************************************************************************************/
+#include <algorithm>
+#include <math.h>
+#include <string.h>
+
+
+/*** Class implementation *********************************************************************************************/
+QModbusPollScheduler::QModbusPollScheduler( QObject *parent ) :
+    QObject( parent ) , _nextId( 1 ) , _policy( ExecuteLate ) , _tolerance( 0 ) , _active( false )
+{
+    // The timer is restarted for the earliest deadline after each tick.
+    _timer.setSingleShot( true );
+    QObject::connect( &_timer , SIGNAL( timeout() ) , this , SLOT( _timerExpired() ) );
+
+    _clock.start();
+}
+
+QModbusPollScheduler::~QModbusPollScheduler()
+{}
+
+int QModbusPollScheduler::addJob( const QAbstractModbus &modbus , const quint8 deviceAddress ,
+                                  const QAbstractModbus::Table table , const quint16 startingAddress ,
+                                  const quint16 quantity , const int period , QModbusListener *const listener )
+{
+    // Check the parameters.
+    if ( !listener || period <= 0 || quantity == 0 || quantity > _maximumBlockSize( &modbus , deviceAddress , table ) ||
+         (quint32)startingAddress + quantity > 0x10000 )
+    {
+        return -1;
+    }
+
+    // Create the job, it is due immediately.
+    Job job;
+    job.modbus = &modbus;
+    job.deviceAddress = deviceAddress;
+    job.table = table;
+    job.startingAddress = startingAddress;
+    job.quantity = quantity;
+    job.listener = listener;
+    job.deadline = _clock.elapsed();
+    job.lastStart = -1;
+    job.periods = 0;
+    job.periodM2 = 0.0;
+    job.statistics.period = period;
+    job.statistics.samples = 0;
+    job.statistics.lastPeriod = -1;
+    job.statistics.averagePeriod = 0.0;
+    job.statistics.jitter = 0.0;
+    job.statistics.maximumJitter = 0;
+    job.statistics.averageLateness = 0.0;
+    job.statistics.overruns = 0;
+    job.statistics.dropped = 0;
+    job.statistics.merged = 0;
+
+    const int id = _nextId++;
+    _jobs.insert( id , job );
+    _push( id );
+
+    _reschedule();
+    return id;
+}
+
+bool QModbusPollScheduler::setChangeFilter( const int id , const QModbusChangeFilter &filter )
+{
+    if ( !_jobs.contains( id ) ) return false;
+
+    // Start over with a fresh filter, so the next sample is reported completely.
+    QModbusChangeFilter fresh = filter;
+    fresh.reset();
+    _filters.insert( id , fresh );
+    return true;
+}
+
+void QModbusPollScheduler::clearChangeFilter( const int id )
+{
+    _filters.remove( id );
+}
+
+void QModbusPollScheduler::setCapabilities( const QAbstractModbus &modbus , QModbusCapabilityCache *const cache )
+{
+    if ( cache )
+    {
+        _capabilities.insert( &modbus , cache );
+    }
+    else
+    {
+        _capabilities.remove( &modbus );
+    }
+}
+
+void QModbusPollScheduler::removeJob( const int id )
+{
+    // The heap entry is dropped when it comes to the top.
+    _jobs.remove( id );
+    _filters.remove( id );
+
+    // Compact the heap if it contains mostly stale entries.
+    if ( _heap.count() > 2 * _jobs.count() + 16 )
+    {
+        QVector<Deadline> heap;
+        foreach ( const Deadline &entry , _heap )
+        {
+            if ( _isPending( entry ) ) heap.append( entry );
+        }
+        std::make_heap( heap.begin() , heap.end() , _later );
+        _heap = heap;
+    }
+
+    _reschedule();
+}
+
+int QModbusPollScheduler::jobCount( void ) const
+{
+    return _jobs.count();
+}
+
+QModbusPollScheduler::Statistics QModbusPollScheduler::statistics( const int id ) const
+{
+    if ( _jobs.contains( id ) ) return _jobs.value( id ).statistics;
+
+    Statistics statistics;
+    memset( &statistics , 0 , sizeof( statistics ) );
+    return statistics;
+}
+
+QModbusPollScheduler::OverloadPolicy QModbusPollScheduler::overloadPolicy( void ) const
+{
+    return _policy;
+}
+
+void QModbusPollScheduler::setOverloadPolicy( const OverloadPolicy policy , const int tolerance )
+{
+    _policy = policy;
+    _tolerance = tolerance;
+}
+
+void QModbusPollScheduler::start( void )
+{
+    _active = true;
+    _reschedule();
+}
+
+void QModbusPollScheduler::stop( void )
+{
+    _active = false;
+    _timer.stop();
+}
+
+bool QModbusPollScheduler::isActive( void ) const
+{
+    return _active;
+}
+
+int QModbusPollScheduler::processDue( void )
+{
+    const qint64 now = _clock.elapsed();
+
+    // Pop all due deadlines, they come out earliest first. Stale entries of removed jobs are skipped.
+    QList<int> due;
+    while ( !_heap.isEmpty() && _heap.first().deadline <= now )
+    {
+        const Deadline entry = _heap.first();
+        std::pop_heap( _heap.begin() , _heap.end() , _later );
+        _heap.removeLast();
+        if ( _isPending( entry ) ) due.append( entry.id );
+    }
+
+    // Execute the jobs in deadline order, merging later due jobs of the same device and table into the request.
+    int requests = 0;
+    for ( int i = 0 ; i < due.count() ; i++ )
+    {
+        if ( due.at( i ) < 0 || !_jobs.contains( due.at( i ) ) ) continue;
+        Job &job = _jobs[due.at( i )];
+        const qint64 started = _clock.elapsed();
+
+        // With the drop policy, cycles later than the tolerance are skipped.
+        if ( _policy == DropLate && started - job.deadline > _tolerance )
+        {
+            _account( job , started , false );
+            _push( due.at( i ) );
+            continue;
+        }
+
+        // Merge the other due jobs reading an overlapping or adjacent range, as long as it fits in one request.
+        QList<int> ids;
+        ids.append( due.at( i ) );
+        quint32 start = job.startingAddress , end = (quint32)job.startingAddress + job.quantity;
+        const quint32 maximum = _maximumBlockSize( job.modbus , job.deviceAddress , job.table );
+        for ( int j = i + 1 ; j < due.count() ; j++ )
+        {
+            if ( due.at( j ) < 0 || !_jobs.contains( due.at( j ) ) ) continue;
+            const Job &other = _jobs[due.at( j )];
+            const quint32 otherStart = other.startingAddress;
+            const quint32 otherEnd = otherStart + other.quantity;
+            if ( other.modbus != job.modbus || other.deviceAddress != job.deviceAddress || other.table != job.table ||
+                 otherStart > end || otherEnd < start ||
+                 qMax( end , otherEnd ) - qMin( start , otherStart ) > maximum ) continue;
+            if ( _policy == DropLate && started - other.deadline > _tolerance ) continue;
+
+            start = qMin( start , otherStart );
+            end = qMax( end , otherEnd );
+            ids.append( due.at( j ) );
+            due[j] = -1;
+        }
+
+        // Account first, so that the listeners see up to date statistics.
+        foreach ( int id , ids )
+        {
+            Job &executed = _jobs[id];
+            if ( ids.count() > 1 ) executed.statistics.merged++;
+            _account( executed , started , true );
+            _push( id );
+        }
+
+        _execute( ids , start , end );
+        requests++;
+    }
+
+    return requests;
+}
+
+void QModbusPollScheduler::_timerExpired( void )
+{
+    processDue();
+    _reschedule();
+}
+
+bool QModbusPollScheduler::_later( const Deadline &a , const Deadline &b )
+{
+    return a.deadline > b.deadline;
+}
+
+quint32 QModbusPollScheduler::_maximumBlockSize( const QAbstractModbus *const modbus , const quint8 deviceAddress ,
+                                                 const QAbstractModbus::Table table ) const
+{
+    // The tables are read using the function of the same code.
+    QModbusCapabilityCache *const cache = _capabilities.value( modbus , NULL );
+    if ( cache ) return cache->maximumQuantity( deviceAddress , table );
+    return ( table == QAbstractModbus::Coils || table == QAbstractModbus::DiscreteInputs ) ? 2000 : 125;
+}
+
+bool QModbusPollScheduler::_isPending( const Deadline &entry ) const
+{
+    return _jobs.contains( entry.id ) && _jobs.value( entry.id ).deadline == entry.deadline;
+}
+
+void QModbusPollScheduler::_push( const int id )
+{
+    Deadline entry;
+    entry.deadline = _jobs.value( id ).deadline;
+    entry.id = id;
+    _heap.append( entry );
+    std::push_heap( _heap.begin() , _heap.end() , _later );
+}
+
+void QModbusPollScheduler::_execute( const QList<int> &ids , const quint32 start , const quint32 end )
+{
+    const Job job = _jobs.value( ids.first() );
+    const quint16 quantity = end - start;
+    quint8 status = QAbstractModbus::UnknownError;
+
+    if ( job.table == QAbstractModbus::Coils || job.table == QAbstractModbus::DiscreteInputs )
+    {
+        const QList<bool> values = job.table == QAbstractModbus::Coils ?
+                    job.modbus->readCoils( job.deviceAddress , start , quantity , &status ) :
+                    job.modbus->readDiscreteInputs( job.deviceAddress , start , quantity , &status );
+        if ( status == QAbstractModbus::Ok && values.count() != quantity ) status = QAbstractModbus::UnknownError;
+        const bool ok = status == QAbstractModbus::Ok;
+
+        // Fan out. A listener may remove jobs while we are notifying, so check each one.
+        foreach ( int id , ids )
+        {
+            if ( !_jobs.contains( id ) ) continue;
+            const Job executed = _jobs.value( id );
+            const QList<bool> slice = ok ? values.mid( executed.startingAddress - start , executed.quantity ) :
+                                           QList<bool>();
+
+            // Change-only jobs get successful samples only if something changed.
+            QHash<int,QModbusChangeFilter>::iterator filter = _filters.find( id );
+            if ( ok && filter != _filters.end() )
+            {
+                const QList<int> changed = filter.value().compare( slice );
+                if ( !changed.isEmpty() )
+                {
+                    executed.listener->bitsChanged( id , executed.startingAddress , slice , changed );
+                }
+            }
+            else
+            {
+                executed.listener->bitsReceived( id , executed.startingAddress , slice , status );
+            }
+        }
+    }
+    else
+    {
+        const QList<quint16> values = job.table == QAbstractModbus::HoldingRegisters ?
+                    job.modbus->readHoldingRegisters( job.deviceAddress , start , quantity , &status ) :
+                    job.modbus->readInputRegisters( job.deviceAddress , start , quantity , &status );
+        if ( status == QAbstractModbus::Ok && values.count() != quantity ) status = QAbstractModbus::UnknownError;
+        const bool ok = status == QAbstractModbus::Ok;
+
+        // Fan out. A listener may remove jobs while we are notifying, so check each one.
+        foreach ( int id , ids )
+        {
+            if ( !_jobs.contains( id ) ) continue;
+            const Job executed = _jobs.value( id );
+            const QList<quint16> slice = ok ? values.mid( executed.startingAddress - start , executed.quantity ) :
+                                              QList<quint16>();
+
+            // Change-only jobs get successful samples only if something changed.
+            QHash<int,QModbusChangeFilter>::iterator filter = _filters.find( id );
+            if ( ok && filter != _filters.end() )
+            {
+                const QList<int> changed = filter.value().compare( slice );
+                if ( !changed.isEmpty() )
+                {
+                    executed.listener->registersChanged( id , executed.startingAddress , slice , changed );
+                }
+            }
+            else
+            {
+                executed.listener->registersReceived( id , executed.startingAddress , slice , status );
+            }
+        }
+    }
+}
+
+void QModbusPollScheduler::_account( Job &job , const qint64 started , const bool executed )
+{
+    Statistics &statistics = job.statistics;
+    const qint64 period = statistics.period;
+    const qint64 lateness = qMax( started - job.deadline , (qint64)0 );
+
+    // Deadlines that passed meanwhile are overruns, the next deadline stays in phase with the period.
+    const qint64 missed = lateness / period;
+    statistics.overruns += missed;
+    job.deadline += ( missed + 1 ) * period;
+
+    if ( !executed )
+    {
+        statistics.dropped++;
+        return;
+    }
+
+    // Actual period and its deviation (Welford's running variance).
+    if ( job.lastStart >= 0 )
+    {
+        const qint64 actual = started - job.lastStart;
+        const double delta = actual - statistics.averagePeriod;
+        job.periods++;
+        statistics.lastPeriod = actual;
+        statistics.averagePeriod += delta / job.periods;
+        job.periodM2 += delta * ( actual - statistics.averagePeriod );
+        statistics.jitter = job.periods > 1 ? sqrt( job.periodM2 / ( job.periods - 1 ) ) : 0.0;
+        statistics.maximumJitter = qMax( statistics.maximumJitter , qAbs( actual - period ) );
+    }
+
+    job.lastStart = started;
+    statistics.samples++;
+    statistics.averageLateness += ( lateness - statistics.averageLateness ) / statistics.samples;
+}
+
+void QModbusPollScheduler::_reschedule( void )
+{
+    if ( !_active ) return;
+
+    // Drop stale entries from the top, so that we do not wake up for removed jobs.
+    while ( !_heap.isEmpty() && !_isPending( _heap.first() ) )
+    {
+        std::pop_heap( _heap.begin() , _heap.end() , _later );
+        _heap.removeLast();
+    }
+
+    if ( _heap.isEmpty() )
+    {
+        _timer.stop();
+        return;
+    }
+    _timer.start( (int)qMax( _heap.first().deadline - _clock.elapsed() , (qint64)0 ) );
+}
@@ -0,0 +1,132 @@
+/***********************************************************************************************************************
+* QModbusRateLimiter implementation.                                                                                  *
+***********************************************************************************************************************/
+#include <QModbusRateLimiter>
+
+
+/*** Qt includes ******************************************************************************************************/
+#include <QModbusPdu>
+
+
+/*** System includes **************************************************************************************************/
+#include <math.h>
+
+
+/*** Class implementation *********************************************************************************************/
+QModbusRateLimiter::QModbusRateLimiter( void ) : _burst( 0 ) , _maximumBackoff( 5000 )
+{
+    _clock.start();
+}
+
+void QModbusRateLimiter::setConnectionLimit( const double requestsPerSecond , const double bytesPerSecond )
+{
+    QMutexLocker locker( &_mutex );
+    _connectionRates.requests = qMax( 0.0 , requestsPerSecond );
+    _connectionRates.bytes = qMax( 0.0 , bytesPerSecond );
+}
+
+void QModbusRateLimiter::setUnitLimit( const quint8 unitId , const double requestsPerSecond ,
+                                       const double bytesPerSecond )
+{
+    QMutexLocker locker( &_mutex );
+    Unit &unit = _units[unitId];
+    unit.rates.requests = qMax( 0.0 , requestsPerSecond );
+    unit.rates.bytes = qMax( 0.0 , bytesPerSecond );
+    unit.ownRates = true;
+}
+
+void QModbusRateLimiter::setDefaultUnitLimit( const double requestsPerSecond , const double bytesPerSecond )
+{
+    QMutexLocker locker( &_mutex );
+    _defaultRates.requests = qMax( 0.0 , requestsPerSecond );
+    _defaultRates.bytes = qMax( 0.0 , bytesPerSecond );
+}
+
+int QModbusRateLimiter::burst( void ) const
+{
+    QMutexLocker locker( &_mutex );
+    return _burst;
+}
+
+void QModbusRateLimiter::setBurst( const int msecs )
+{
+    QMutexLocker locker( &_mutex );
+    _burst = qMax( 0 , msecs );
+}
+
+int QModbusRateLimiter::maximumBackoff( void ) const
+{
+    QMutexLocker locker( &_mutex );
+    return _maximumBackoff;
+}
+
+void QModbusRateLimiter::setMaximumBackoff( const int msecs )
+{
+    QMutexLocker locker( &_mutex );
+    _maximumBackoff = qMax( (int)InitialBackoff , msecs );
+}
+
+double QModbusRateLimiter::unitScale( const quint8 unitId ) const
+{
+    QMutexLocker locker( &_mutex );
+    return _units.contains( unitId ) ? _units.value( unitId ).scale : 1.0;
+}
+
+int QModbusRateLimiter::reserve( const QModbusRequest &request )
+{
+    // The PDU bytes of the request and of the expected response.
+    const QModbusFrameView pdu = request.pdu();
+    const double bytes = pdu.size() + qMax( 0 , QModbusPdu::responseSize( pdu.data() , pdu.size() ) );
+
+    QMutexLocker locker( &_mutex );
+    const qint64 now = _clock.elapsed();
+    Unit &unit = _units[request.deviceAddress()];
+    const Rates &rates = unit.ownRates ? unit.rates : _defaultRates;
+
+    // The request waits for the slowest bucket and for the end of a pause of its unit.
+    double wait = qMax( _take( _connectionRequests , _connectionRates.requests , 1 , now ) ,
+                        _take( _connectionBytes , _connectionRates.bytes , bytes , now ) );
+    wait = qMax( wait , _take( unit.requests , rates.requests * unit.scale , 1 , now ) );
+    wait = qMax( wait , _take( unit.bytes , rates.bytes * unit.scale , bytes , now ) );
+    wait = qMax( wait , (double)( unit.pausedUntil - now ) );
+    return (int)ceil( wait );
+}
+
+void QModbusRateLimiter::report( const QModbusRequest &request , const QModbusResponse &response )
+{
+    const quint8 status = response.status();
+    if ( status != QAbstractModbus::Ok && status != QAbstractModbus::SlaveDeviceBusy &&
+         status != QAbstractModbus::GatewayTargetDeviceFailedToRespond )
+    {
+        return;
+    }
+
+    QMutexLocker locker( &_mutex );
+    Unit &unit = _units[request.deviceAddress()];
+    if ( status == QAbstractModbus::Ok )
+    {
+        // Additive increase.
+        unit.backoff = 0;
+        unit.scale = qMin( 1.0 , unit.scale + 1.0 / RecoverySteps );
+        return;
+    }
+
+    // Multiplicative decrease and a pause that doubles while the unit stays busy.
+    unit.backoff = unit.backoff ? qMin( 2 * unit.backoff , _maximumBackoff ) : (int)InitialBackoff;
+    unit.pausedUntil = _clock.elapsed() + unit.backoff;
+    unit.scale = qMax( 1.0 / MinimumScale , unit.scale / 2 );
+}
+
+double QModbusRateLimiter::_take( Bucket &bucket , const double rate , const double tokens , const qint64 now ) const
+{
+    if ( rate <= 0 ) return 0;
+
+    // Refill for the time since the last request, at most a burst. A request goes as soon as the bucket is not in debt
+    // and takes its tokens even if that puts the bucket into debt, so the requests are spaced by their size.
+    const double capacity = rate * _burst / 1000.0;
+    bucket.level = qMin( capacity , bucket.level + rate * ( now - bucket.stamp ) / 1000.0 );
+    bucket.stamp = now;
+    const double wait = bucket.level >= 0 ? 0 : -bucket.level * 1000.0 / rate;
+    bucket.level -= tokens;
+    return wait;
+}
@@ -0,0 +1,188 @@
+/***********************************************************************************************************************
+* QModbusReconnectManager implementation.                                                                             *
+***********************************************************************************************************************/
+#include <QModbusReconnectManager>
+
+
+/*** Qt includes ******************************************************************************************************/
+#include <QtCore/QDateTime>
+#include <QtCore/QMetaObject>
+
+
+/*** Class implementation *********************************************************************************************/
+QModbusReconnectManager::QModbusReconnectManager( QObject *parent ) :
+    QObject( parent ) , _connectedCount( 0 ) , _initialDelay( 100 ) , _maximumDelay( 30000 )
+{
+    _timer.setSingleShot( true );
+    QObject::connect( &_timer , SIGNAL( timeout() ) , this , SLOT( _timerExpired() ) );
+    _clock.start();
+
+    // Any non-zero seed will do, it only has to differ between managers.
+    _random = (quint32)(quintptr)this ^ (quint32)QDateTime::currentMSecsSinceEpoch();
+    if ( !_random ) _random = 1;
+}
+
+QModbusReconnectManager::~QModbusReconnectManager()
+{
+    qDeleteAll( _connections );
+}
+
+void QModbusReconnectManager::addConnection( QTcpModbus *const modbus )
+{
+    if ( !modbus || _connections.contains( modbus ) ) return;
+
+    Connection *const connection = new Connection;
+    connection->modbus = modbus;
+    connection->failures = 0;
+    connection->connected = modbus->isConnected();
+    connection->due = -1;
+    _connections.insert( modbus , connection );
+    if ( connection->connected ) _connectedCount++;
+
+    // The transport may move to another thread later, the signals are queued then.
+    QObject::connect( modbus , SIGNAL( connected() ) , this , SLOT( _transportConnected() ) );
+    QObject::connect( modbus , SIGNAL( connectionLost() ) , this , SLOT( _transportLost() ) );
+    QObject::connect( modbus , SIGNAL( connectFailed() ) , this , SLOT( _transportFailed() ) );
+
+    if ( !connection->connected && !modbus->isConnecting() ) modbus->reconnect();
+}
+
+void QModbusReconnectManager::removeConnection( QTcpModbus *const modbus )
+{
+    Connection *const connection = _connections.take( modbus );
+    if ( !connection ) return;
+
+    QObject::disconnect( modbus , NULL , this , NULL );
+    _unschedule( connection );
+    if ( connection->connected ) _connectedCount--;
+    delete connection;
+    _reschedule();
+}
+
+int QModbusReconnectManager::connectionCount( void ) const
+{
+    return _connections.count();
+}
+
+int QModbusReconnectManager::connectedCount( void ) const
+{
+    return _connectedCount;
+}
+
+int QModbusReconnectManager::initialDelay( void ) const
+{
+    return _initialDelay;
+}
+
+void QModbusReconnectManager::setInitialDelay( const int msecs )
+{
+    _initialDelay = qMax( 1 , msecs );
+}
+
+int QModbusReconnectManager::maximumDelay( void ) const
+{
+    return _maximumDelay;
+}
+
+void QModbusReconnectManager::setMaximumDelay( const int msecs )
+{
+    _maximumDelay = qMax( 1 , msecs );
+}
+
+void QModbusReconnectManager::_transportConnected( void )
+{
+    Connection *const connection = _sender();
+    if ( !connection ) return;
+
+    connection->failures = 0;
+    _unschedule( connection );
+    _reschedule();
+    if ( connection->connected ) return;
+
+    connection->connected = true;
+    _connectedCount++;
+    emit connected( connection->modbus );
+    if ( _connectedCount == _connections.count() ) emit allConnected();
+}
+
+void QModbusReconnectManager::_transportLost( void )
+{
+    Connection *const connection = _sender();
+    if ( !connection ) return;
+
+    if ( connection->connected )
+    {
+        connection->connected = false;
+        _connectedCount--;
+        emit disconnected( connection->modbus );
+    }
+    _schedule( connection );
+}
+
+void QModbusReconnectManager::_transportFailed( void )
+{
+    Connection *const connection = _sender();
+    if ( !connection ) return;
+
+    connection->failures++;
+    _schedule( connection );
+}
+
+void QModbusReconnectManager::_timerExpired( void )
+{
+    // Start all attempts that are due, they run in parallel.
+    const qint64 now = _clock.elapsed();
+    while ( !_due.isEmpty() && _due.begin().key() <= now )
+    {
+        Connection *const connection = _due.begin().value();
+        _due.erase( _due.begin() );
+        connection->due = -1;
+
+        // Queued, the transport may live in another thread.
+        QMetaObject::invokeMethod( connection->modbus , "reconnect" , Qt::QueuedConnection );
+    }
+    _reschedule();
+}
+
+QModbusReconnectManager::Connection *QModbusReconnectManager::_sender( void ) const
+{
+    return _connections.value( sender() , NULL );
+}
+
+void QModbusReconnectManager::_schedule( Connection *const connection )
+{
+    _unschedule( connection );
+    connection->due = _clock.elapsed() + _backoff( connection->failures );
+    _due.insert( connection->due , connection );
+    _reschedule();
+}
+
+void QModbusReconnectManager::_unschedule( Connection *const connection )
+{
+    if ( connection->due < 0 ) return;
+    _due.remove( connection->due , connection );
+    connection->due = -1;
+}
+
+void QModbusReconnectManager::_reschedule( void )
+{
+    if ( _due.isEmpty() )
+    {
+        _timer.stop();
+        return;
+    }
+    _timer.start( (int)qMax( (qint64)0 , _due.begin().key() - _clock.elapsed() ) );
+}
+
+int QModbusReconnectManager::_backoff( const int failures )
+{
+    // Double the delay with each failure, the shift is bounded so it can not overflow.
+    const qint64 delay = qMin( (qint64)_maximumDelay , (qint64)_initialDelay << qMin( failures , 20 ) );
+
+    // Half of the delay is random (xorshift32).
+    _random ^= _random << 13;
+    _random ^= _random >> 17;
+    _random ^= _random << 5;
+    const qint64 half = delay / 2;
+    return (int)( delay - half + _random % ( half + 1 ) );
+}
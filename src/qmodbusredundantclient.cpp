@@ -0,0 +1,518 @@
+/***********************************************************************************************************************
+* QModbusRedundantClient implementation.                                                                              *
+***********************************************************************************************************************/
+#include <QModbusRedundantClient>
+
+
+/*** Qt includes ******************************************************************************************************/
+#include <QModbusRequestCore>
+#include <QtCore/QAtomicInt>
+#include <QtCore/QSemaphore>
+
+
+/*** System includes **************************************************************************************************/
+#include <algorithm>
+
+
+/*** Request core *****************************************************************************************************/
+// I/O policy of the request core, hands the requests to the paths.
+class QModbusRedundantClientIo
+{
+public:
+    explicit QModbusRedundantClientIo( const QModbusRedundantClient &client ) : _client( client ) {}
+
+    bool isOpen( void ) const
+    {
+        return _client.isOpen();
+    }
+
+    QModbusResponse execute( const QModbusRequest &request ) const
+    {
+        return _client.execute( request );
+    }
+
+private:
+    const QModbusRedundantClient &_client;
+};
+
+typedef QModbusRequestCore<QModbusRequestFraming,QModbusRedundantClientIo> QModbusRedundantClientCore;
+
+static inline QModbusRedundantClientCore core( const QModbusRedundantClient &client )
+{
+    return QModbusRedundantClientCore( QModbusRedundantClientIo( client ) );
+}
+
+
+/*** Race between the attempts of a request ***************************************************************************/
+struct QModbusRedundantRace;
+
+// An attempt as seen by the completion handler.
+struct QModbusRedundantTicket
+{
+    QModbusRedundantRace *race;     // The race of the attempt.
+    int path;                       // Index of the path.
+    QAtomicInt lost;                // 1 once another path answered first.
+};
+
+// Shared by the attempts of one request: each finished attempt releases a token. The attempts and the caller hold a
+// reference each, so a late reply after the caller took the first answer still finds the object.
+struct QModbusRedundantRace
+{
+    QModbusRedundantRace( const QModbusRedundantClient &client , const int attempts ) :
+        client( client ) , references( 1 ) , tickets( new QModbusRedundantTicket[attempts] )
+    {}
+
+    ~QModbusRedundantRace()
+    {
+        delete[] tickets;
+    }
+
+    const QModbusRedundantClient &client;   // The client, outlives the attempts (its paths fail them when deleted).
+    QModbusCancellationToken token; // Carried by the attempts, cancelled once the race is decided.
+    QSemaphore finished;            // One token per finished attempt.
+    QAtomicInt references;          // Caller and attempts not finished yet.
+    QModbusRedundantTicket *tickets;    // One per possible attempt.
+};
+
+// Waits for an attempt to finish, forwards a cancellation of the caller to the attempts.
+static bool raceWait( QModbusRedundantRace *const race , const QModbusCancellationToken &caller , const int msecs )
+{
+    if ( !caller.isCancellable() )
+    {
+        if ( msecs >= 0 ) return race->finished.tryAcquire( 1 , msecs );
+        race->finished.acquire();
+        return true;
+    }
+
+    QElapsedTimer clock;
+    clock.start();
+    for ( ;; )
+    {
+        if ( caller.isCancelled() ) race->token.cancel();
+        int step = QModbusCancellationToken::PollInterval;
+        if ( msecs >= 0 ) step = (int)qBound( (qint64)0 , msecs - clock.elapsed() , (qint64)step );
+        if ( race->finished.tryAcquire( 1 , step ) ) return true;
+        if ( msecs >= 0 && clock.hasExpired( msecs ) ) return false;
+    }
+}
+
+// An attempt of a request on a path, as seen by the caller.
+struct QModbusRedundantAttempt
+{
+    int path;                       // Index of the path.
+    QModbusReplyPointer reply;      // The reply.
+    qint64 sent;                    // Time the attempt was sent.
+    bool handled;                   // True once its reply was looked at.
+};
+
+
+/*** QModbusRedundantClient implementation ****************************************************************************/
+QModbusRedundantClient::QModbusRedundantClient( const QList<QAbstractModbus *> &paths ) :
+    _hedging( false ) , _hedgePercentile( 95 ) , _minimumHedgeDelay( 5 ) , _failureThreshold( 3 ) ,
+    _recoveryDelay( 5000 ) , _nextLatency( 0 ) , _newLatencies( 0 ) , _hedgeDelay( -1 ) , _hedgeCount( 0 ) ,
+    _failoverCount( 0 )
+{
+    foreach ( QAbstractModbus *modbus , paths )
+    {
+        Path path;
+        path.modbus = modbus;
+        path.connection = new QModbusSharedConnection( *modbus );
+        path.failures = 0;
+        path.down = false;
+        _paths.append( path );
+    }
+}
+
+QModbusRedundantClient::~QModbusRedundantClient()
+{
+    // The paths fail the requests in flight, their completion handlers still find the client.
+    for ( int i = 0 ; i < _paths.count() ; i++ ) delete _paths.at( i ).connection;
+}
+
+int QModbusRedundantClient::pathCount( void ) const
+{
+    return _paths.count();
+}
+
+bool QModbusRedundantClient::isPathHealthy( const int path ) const
+{
+    QMutexLocker locker( &_mutex );
+    return path >= 0 && path < _paths.count() && !_paths.at( path ).down;
+}
+
+int QModbusRedundantClient::primaryPath( void ) const
+{
+    const QList<int> order = _order();
+    return order.isEmpty() ? -1 : order.first();
+}
+
+void QModbusRedundantClient::setHedgingEnabled( const bool enabled )
+{
+    _hedging = enabled;
+}
+
+bool QModbusRedundantClient::isHedgingEnabled( void ) const
+{
+    return _hedging;
+}
+
+void QModbusRedundantClient::setHedgePercentile( const int percentile )
+{
+    _hedgePercentile = qBound( 50 , percentile , 99 );
+    _newLatencies = UpdateInterval;
+}
+
+int QModbusRedundantClient::hedgePercentile( void ) const
+{
+    return _hedgePercentile;
+}
+
+void QModbusRedundantClient::setMinimumHedgeDelay( const int msecs )
+{
+    _minimumHedgeDelay = qMax( 0 , msecs );
+    _newLatencies = UpdateInterval;
+}
+
+int QModbusRedundantClient::minimumHedgeDelay( void ) const
+{
+    return _minimumHedgeDelay;
+}
+
+int QModbusRedundantClient::hedgeDelay( void ) const
+{
+    return _hedgeDelay;
+}
+
+void QModbusRedundantClient::setFailureThreshold( const int failures )
+{
+    _failureThreshold = qMax( 1 , failures );
+}
+
+int QModbusRedundantClient::failureThreshold( void ) const
+{
+    return _failureThreshold;
+}
+
+void QModbusRedundantClient::setRecoveryDelay( const int msecs )
+{
+    _recoveryDelay = qMax( 0 , msecs );
+}
+
+int QModbusRedundantClient::recoveryDelay( void ) const
+{
+    return _recoveryDelay;
+}
+
+quint64 QModbusRedundantClient::hedgeCount( void ) const
+{
+    return _hedgeCount;
+}
+
+quint64 QModbusRedundantClient::failoverCount( void ) const
+{
+    return _failoverCount;
+}
+
+QModbusResponse QModbusRedundantClient::execute( const QModbusRequest &request ) const
+{
+    if ( !request.isValid() ) return QModbusResponse( IllegalDataValue );
+    const QList<int> order = _order();
+    if ( order.isEmpty() ) return QModbusResponse( NoConnection );
+
+    // Only reads are idempotent: they can be hedged and retried on another path.
+    const quint8 functionCode = request.functionCode();
+    const bool idempotent = functionCode >= 0x01 && functionCode <= 0x04;
+
+    // The attempts carry the token of the race, so the ones that lost can be cancelled.
+    QModbusRedundantRace *const race = new QModbusRedundantRace( *this , order.count() );
+    QModbusRequest attemptRequest( request );
+    attemptRequest.setCancellationToken( race->token );
+    QElapsedTimer clock;
+    clock.start();
+    QList<QModbusRedundantAttempt> attempts;
+    int next = 0;
+
+    // Send to the primary path.
+    _submit( race , attempts , order.at( next++ ) , attemptRequest , clock.elapsed() );
+
+    // Hedge: no reply within the hedge delay, send to the next path as well.
+    int tokens = 0;
+    if ( _hedging && idempotent && _hedgeDelay >= 0 && next < order.count() )
+    {
+        if ( raceWait( race , request.cancellationToken() , _hedgeDelay ) )
+        {
+            tokens = 1;
+        }
+        else
+        {
+            _submit( race , attempts , order.at( next++ ) , attemptRequest , clock.elapsed() );
+            _hedgeCount++;
+        }
+    }
+
+    // Take the first answer of a device. After a path failure a read is retried on the next path. The completion
+    // handlers record the health of the paths.
+    QModbusResponse response( NoConnection );
+    int handled = 0;
+    int winner = -1;
+    bool answered = false;
+    while ( !answered && handled < attempts.count() )
+    {
+        if ( tokens ) tokens--;
+        else raceWait( race , request.cancellationToken() , -1 );
+
+        for ( int i = 0 ; i < attempts.count() && !answered ; i++ )
+        {
+            QModbusRedundantAttempt &current = attempts[i];
+            if ( current.handled || !current.reply->isFinished() ) continue;
+            current.handled = true;
+            handled++;
+
+            response = current.reply->response();
+            answered = !_isPathFailure( response.status() );
+            if ( answered ) winner = i;
+            if ( answered && response.status() != Cancelled ) _addLatency( clock.elapsed() - current.sent );
+        }
+
+        if ( !answered && handled == attempts.count() && idempotent && next < order.count() )
+        {
+            _submit( race , attempts , order.at( next++ ) , attemptRequest , clock.elapsed() );
+            _failoverCount++;
+        }
+    }
+
+    // Cancel the attempts still in flight, they keep the race alive until they finished. Only those sent before the
+    // winning attempt lost the race: they were overtaken by a later attempt. A hedge that is cancelled because the
+    // attempt it hedged answered first tells nothing about its path, neither does a cancellation by the caller.
+    for ( int i = 0 ; i < winner && response.status() != Cancelled ; i++ )
+    {
+        if ( !attempts.at( i ).handled ) race->tickets[i].lost.fetchAndStoreRelease( 1 );
+    }
+    race->token.cancel();
+    if ( !race->references.deref() ) delete race;
+    return response;
+}
+
+bool QModbusRedundantClient::isOpen( void ) const
+{
+    for ( int i = 0 ; i < _paths.count() ; i++ )
+    {
+        if ( _paths.at( i ).connection->isOpen() ) return true;
+    }
+    return false;
+}
+
+unsigned int QModbusRedundantClient::timeout( void ) const
+{
+    const int path = primaryPath();
+    return path < 0 ? 0 : _paths.at( path ).connection->timeout();
+}
+
+void QModbusRedundantClient::setTimeout( const unsigned int timeout )
+{
+    for ( int i = 0 ; i < _paths.count() ; i++ ) _paths.at( i ).connection->setTimeout( timeout );
+}
+
+QList<bool> QModbusRedundantClient::readCoils( const quint8 deviceAddress , const quint16 startingAddress ,
+                                               const quint16 quantityOfCoils , quint8 *const status ) const
+{
+    return core( *this ).readBits( deviceAddress , 0x01 , startingAddress , quantityOfCoils , status );
+}
+
+QList<bool> QModbusRedundantClient::readDiscreteInputs( const quint8 deviceAddress , const quint16 startingAddress ,
+                                                        const quint16 quantityOfInputs , quint8 *const status ) const
+{
+    return core( *this ).readBits( deviceAddress , 0x02 , startingAddress , quantityOfInputs , status );
+}
+
+QList<quint16> QModbusRedundantClient::readHoldingRegisters( const quint8 deviceAddress ,
+                                                             const quint16 startingAddress ,
+                                                             const quint16 quantityOfRegisters ,
+                                                             quint8 *const status ) const
+{
+    return core( *this ).readRegisters( deviceAddress , 0x03 , startingAddress , quantityOfRegisters , status );
+}
+
+QList<quint16> QModbusRedundantClient::readInputRegisters( const quint8 deviceAddress ,
+                                                           const quint16 startingAddress ,
+                                                           const quint16 quantityOfInputRegisters ,
+                                                           quint8 *const status ) const
+{
+    return core( *this ).readRegisters( deviceAddress , 0x04 , startingAddress , quantityOfInputRegisters , status );
+}
+
+bool QModbusRedundantClient::writeSingleCoil( const quint8 deviceAddress , const quint16 outputAddress ,
+                                              const bool outputValue , quint8 *const status ) const
+{
+    return core( *this ).writeSingleCoil( deviceAddress , outputAddress , outputValue , status );
+}
+
+bool QModbusRedundantClient::writeSingleRegister( const quint8 deviceAddress , const quint16 registerAddress ,
+                                                  const quint16 registerValue , quint8 *const status ) const
+{
+    return core( *this ).writeSingleRegister( deviceAddress , registerAddress , registerValue , status );
+}
+
+bool QModbusRedundantClient::writeMultipleCoils( const quint8 deviceAddress , const quint16 startingAddress ,
+                                                 const QList<bool> & outputValues , quint8 *const status ) const
+{
+    return core( *this ).writeMultipleCoils( deviceAddress , startingAddress , outputValues , status );
+}
+
+bool QModbusRedundantClient::writeMultipleRegisters( const quint8 deviceAddress , const quint16 startingAddress ,
+                                                     const QList<quint16> & registersValues ,
+                                                     quint8 *const status ) const
+{
+    return core( *this ).writeMultipleRegisters( deviceAddress , startingAddress , registersValues , status );
+}
+
+bool QModbusRedundantClient::maskWriteRegister( const quint8 deviceAddress , const quint16 referenceAddress ,
+                                                const quint16 andMask , const quint16 orMask ,
+                                                quint8 *const status ) const
+{
+    return core( *this ).maskWriteRegister( deviceAddress , referenceAddress , andMask , orMask , status );
+}
+
+QList<quint16> QModbusRedundantClient::writeReadMultipleRegisters( const quint8 deviceAddress ,
+                                                                   const quint16 writeStartingAddress ,
+                                                                   const QList<quint16> & writeValues ,
+                                                                   const quint16 readStartingAddress ,
+                                                                   const quint16 quantityToRead ,
+                                                                   quint8 *const status ) const
+{
+    return core( *this ).writeReadMultipleRegisters( deviceAddress , writeStartingAddress , writeValues ,
+                                                     readStartingAddress , quantityToRead , status );
+}
+
+QList<quint16> QModbusRedundantClient::readFifoQueue( const quint8 deviceAddress , const quint16 fifoPointerAddress ,
+                                                      quint8 *const status ) const
+{
+    return core( *this ).readFifoQueue( deviceAddress , fifoPointerAddress , status );
+}
+
+QByteArray QModbusRedundantClient::executeCustomFunction( const quint8 deviceAddress , const quint8 modbusFunction ,
+                                                          QByteArray &data , quint8 *const status ) const
+{
+    return core( *this ).executeCustomFunction( deviceAddress , modbusFunction , data , status );
+}
+
+bool QModbusRedundantClient::executePdu( const quint8 deviceAddress , const QModbusFrameView &request ,
+                                         QModbusPduFrame &response , quint8 *const status ) const
+{
+    return core( *this ).executePdu( deviceAddress , request , response , status );
+}
+
+QByteArray QModbusRedundantClient::executeRaw( QByteArray &data , quint8 *const status ) const
+{
+    const int path = primaryPath();
+    if ( path < 0 )
+    {
+        if ( status ) *status = NoConnection;
+        return QByteArray();
+    }
+    return _paths.at( path ).connection->executeRaw( data , status );
+}
+
+QByteArray QModbusRedundantClient::calculateCheckSum( QByteArray &data ) const
+{
+    return _paths.isEmpty() ? QByteArray() : _paths.first().modbus->calculateCheckSum( data );
+}
+
+QList<int> QModbusRedundantClient::_order( void ) const
+{
+    QMutexLocker locker( &_mutex );
+    QList<int> order;
+    QList<int> down;
+    for ( int i = 0 ; i < _paths.count() ; i++ )
+    {
+        const Path &path = _paths.at( i );
+        if ( !path.down || path.downSince.hasExpired( _recoveryDelay ) ) order.append( i );
+        else down.append( i );
+    }
+
+    // Paths marked down are the last resort.
+    order.append( down );
+    return order;
+}
+
+void QModbusRedundantClient::_record( const int path , const quint8 status ) const
+{
+    QMutexLocker locker( &_mutex );
+    Path &current = _paths[path];
+    if ( !_isPathFailure( status ) )
+    {
+        current.failures = 0;
+        current.down = false;
+        return;
+    }
+
+    // Mark the path down, or restart the recovery delay of a path that failed again.
+    if ( ++current.failures >= _failureThreshold || current.down )
+    {
+        current.down = true;
+        current.downSince.start();
+    }
+}
+
+void QModbusRedundantClient::_submit( QModbusRedundantRace *const race , QList<QModbusRedundantAttempt> &attempts ,
+                                      const int path , const QModbusRequest &request , const qint64 sent ) const
+{
+    QModbusRedundantTicket *const ticket = &race->tickets[attempts.count()];
+    ticket->race = race;
+    ticket->path = path;
+
+    QModbusRedundantAttempt attempt;
+    attempt.path = path;
+    attempt.sent = sent;
+    attempt.handled = false;
+    race->references.ref();
+    attempt.reply = _paths.at( path ).connection->submit( request , &_attemptFinished , ticket );
+    attempts.append( attempt );
+}
+
+void QModbusRedundantClient::_attemptFinished( const QModbusResponse &response , void *context )
+{
+    QModbusRedundantTicket *const ticket = static_cast<QModbusRedundantTicket *>( context );
+    QModbusRedundantRace *const race = ticket->race;
+
+    // Every answer counts for the health of its path, late ones too. An attempt cancelled because another path
+    // answered first was slower than the hedge, one cancelled by the caller tells nothing.
+    const quint8 status = response.status();
+    if ( status != Cancelled ) race->client._record( ticket->path , status );
+    else if ( ticket->lost.fetchAndAddAcquire( 0 ) ) race->client._record( ticket->path , Timeout );
+
+    race->finished.release();
+    if ( !race->references.deref() ) delete race;
+}
+
+void QModbusRedundantClient::_addLatency( const int msecs ) const
+{
+    if ( _latencies.count() < LatencySamples ) _latencies.append( msecs );
+    else _latencies[_nextLatency] = msecs;
+    _nextLatency = ( _nextLatency + 1 ) % LatencySamples;
+    if ( ++_newLatencies < UpdateInterval || _latencies.count() < MinimumSamples ) return;
+
+    // The percentile of the samples, computed on a copy every few samples.
+    QVector<int> sorted = _latencies;
+    const int index = ( sorted.count() - 1 ) * _hedgePercentile / 100;
+    std::nth_element( sorted.begin() , sorted.begin() + index , sorted.end() );
+    _hedgeDelay = qMax( _minimumHedgeDelay , sorted.at( index ) );
+    _newLatencies = 0;
+}
+
+bool QModbusRedundantClient::_isPathFailure( const quint8 status )
+{
+    switch( status )
+    {
+        case GatewayPathUnavailable:
+        case GatewayTargetDeviceFailedToRespond:
+        case CrcError:
+        case Timeout:
+        case NoConnection:
+        case UnknownError:
+            return true;
+
+        default:
+            return false;
+    }
+}
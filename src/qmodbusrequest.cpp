@@ -0,0 +1,267 @@
+/***********************************************************************************************************************
+* QModbusRequest implementation.                                                                                      *
+***********************************************************************************************************************/
+#include <QModbusRequest>
+
+
+/*** Qt includes ******************************************************************************************************/
+#include <QModbusPdu>
+
+
+/*** QModbusRequest implementation ************************************************************************************/
+QModbusRequest::QModbusRequest( void ) :
+    _deviceAddress( 0 ) , _token( QModbusCancellationToken::none() ) , _priority( Cyclic )
+{}
+
+QModbusRequest::QModbusRequest( const quint8 deviceAddress , const QModbusFrameView &pdu ) :
+    _deviceAddress( deviceAddress ) , _token( QModbusCancellationToken::none() ) , _priority( Cyclic )
+{
+    _pdu.append( pdu.data() , pdu.size() );
+}
+
+QModbusRequest QModbusRequest::readCoils( const quint8 deviceAddress , const quint16 startingAddress ,
+                                          const quint16 quantityOfCoils )
+{
+    char pdu[QModbusReadBitsPdu::MaxPduSize];
+    const int size = QModbusReadBitsPdu::encode( pdu , 0x01 , startingAddress , quantityOfCoils );
+    return QModbusRequest( deviceAddress , QModbusFrameView( pdu , size ) );
+}
+
+QModbusRequest QModbusRequest::readDiscreteInputs( const quint8 deviceAddress , const quint16 startingAddress ,
+                                                   const quint16 quantityOfInputs )
+{
+    char pdu[QModbusReadBitsPdu::MaxPduSize];
+    const int size = QModbusReadBitsPdu::encode( pdu , 0x02 , startingAddress , quantityOfInputs );
+    return QModbusRequest( deviceAddress , QModbusFrameView( pdu , size ) );
+}
+
+QModbusRequest QModbusRequest::readHoldingRegisters( const quint8 deviceAddress , const quint16 startingAddress ,
+                                                     const quint16 quantityOfRegisters )
+{
+    char pdu[QModbusReadRegistersPdu::MaxPduSize];
+    const int size = QModbusReadRegistersPdu::encode( pdu , 0x03 , startingAddress , quantityOfRegisters );
+    return QModbusRequest( deviceAddress , QModbusFrameView( pdu , size ) );
+}
+
+QModbusRequest QModbusRequest::readInputRegisters( const quint8 deviceAddress , const quint16 startingAddress ,
+                                                   const quint16 quantityOfInputRegisters )
+{
+    char pdu[QModbusReadRegistersPdu::MaxPduSize];
+    const int size = QModbusReadRegistersPdu::encode( pdu , 0x04 , startingAddress , quantityOfInputRegisters );
+    return QModbusRequest( deviceAddress , QModbusFrameView( pdu , size ) );
+}
+
+QModbusRequest QModbusRequest::writeSingleCoil( const quint8 deviceAddress , const quint16 outputAddress ,
+                                                const bool outputValue )
+{
+    char pdu[QModbusWriteSinglePdu::MaxPduSize];
+    const int size = QModbusWriteSinglePdu::encode( pdu , 0x05 , outputAddress , outputValue ? 0xFF00 : 0x0000 );
+    return QModbusRequest( deviceAddress , QModbusFrameView( pdu , size ) );
+}
+
+QModbusRequest QModbusRequest::writeSingleRegister( const quint8 deviceAddress , const quint16 registerAddress ,
+                                                    const quint16 registerValue )
+{
+    char pdu[QModbusWriteSinglePdu::MaxPduSize];
+    const int size = QModbusWriteSinglePdu::encode( pdu , 0x06 , registerAddress , registerValue );
+    return QModbusRequest( deviceAddress , QModbusFrameView( pdu , size ) );
+}
+
+QModbusRequest QModbusRequest::writeMultipleCoils( const quint8 deviceAddress , const quint16 startingAddress ,
+                                                   const QList<bool> &outputValues )
+{
+    const int txBytes = ( outputValues.count() + 7 ) / 8;
+    if ( txBytes > QModbusWriteMultiplePdu::MaxDataSize ) return QModbusRequest();
+
+    // The bits are packed LSB first.
+    char pdu[QModbusWriteMultiplePdu::MaxPduSize];
+    QModbusWriteMultiplePdu::encode( pdu , 0x0F , startingAddress , outputValues.count() );
+    const int size = QModbusWriteMultiplePdu::setDataSize( pdu , txBytes );
+    char *data = QModbusWriteMultiplePdu::data( pdu );
+    for ( int i = 0 ; i < txBytes ; i++ ) data[i] = 0;
+    for ( int i = 0 ; i < outputValues.count() ; i++ )
+    {
+        if ( outputValues.at( i ) ) data[i >> 3] |= 0x01 << ( i & 7 );
+    }
+    return QModbusRequest( deviceAddress , QModbusFrameView( pdu , size ) );
+}
+
+QModbusRequest QModbusRequest::writeMultipleRegisters( const quint8 deviceAddress , const quint16 startingAddress ,
+                                                       const QList<quint16> &registersValues )
+{
+    const int txBytes = registersValues.count() * 2;
+    if ( txBytes > QModbusWriteMultiplePdu::MaxDataSize ) return QModbusRequest();
+
+    char pdu[QModbusWriteMultiplePdu::MaxPduSize];
+    QModbusWriteMultiplePdu::encode( pdu , 0x10 , startingAddress , registersValues.count() );
+    const int size = QModbusWriteMultiplePdu::setDataSize( pdu , txBytes );
+    char *data = QModbusWriteMultiplePdu::data( pdu );
+    foreach ( quint16 reg , registersValues )
+    {
+        QModbusPdu::put( data , reg );
+        data += 2;
+    }
+    return QModbusRequest( deviceAddress , QModbusFrameView( pdu , size ) );
+}
+
+QModbusRequest QModbusRequest::maskWriteRegister( const quint8 deviceAddress , const quint16 referenceAddress ,
+                                                  const quint16 andMask , const quint16 orMask )
+{
+    char pdu[QModbusMaskWritePdu::MaxPduSize];
+    const int size = QModbusMaskWritePdu::encode( pdu , 0x16 , referenceAddress , andMask , orMask );
+    return QModbusRequest( deviceAddress , QModbusFrameView( pdu , size ) );
+}
+
+QModbusRequest QModbusRequest::writeReadMultipleRegisters( const quint8 deviceAddress ,
+                                                           const quint16 writeStartingAddress ,
+                                                           const QList<quint16> &writeValues ,
+                                                           const quint16 readStartingAddress ,
+                                                           const quint16 quantityToRead )
+{
+    const int txBytes = writeValues.count() * 2;
+    if ( txBytes > QModbusReadWritePdu::MaxDataSize ) return QModbusRequest();
+
+    char pdu[QModbusReadWritePdu::MaxPduSize];
+    QModbusReadWritePdu::encode( pdu , 0x17 , readStartingAddress , quantityToRead , writeStartingAddress ,
+                                 writeValues.count() );
+    const int size = QModbusReadWritePdu::setDataSize( pdu , txBytes );
+    char *data = QModbusReadWritePdu::data( pdu );
+    foreach ( quint16 reg , writeValues )
+    {
+        QModbusPdu::put( data , reg );
+        data += 2;
+    }
+    return QModbusRequest( deviceAddress , QModbusFrameView( pdu , size ) );
+}
+
+QModbusRequest QModbusRequest::readFifoQueue( const quint8 deviceAddress , const quint16 fifoPointerAddress )
+{
+    char pdu[QModbusReadFifoPdu::MaxPduSize];
+    const int size = QModbusReadFifoPdu::encode( pdu , 0x18 , fifoPointerAddress );
+    return QModbusRequest( deviceAddress , QModbusFrameView( pdu , size ) );
+}
+
+bool QModbusRequest::isValid( void ) const
+{
+    return !_pdu.isEmpty();
+}
+
+quint8 QModbusRequest::deviceAddress( void ) const
+{
+    return _deviceAddress;
+}
+
+quint8 QModbusRequest::functionCode( void ) const
+{
+    return _pdu.isEmpty() ? 0 : _pdu.at( 0 );
+}
+
+QModbusFrameView QModbusRequest::pdu( void ) const
+{
+    return _pdu.view();
+}
+
+void QModbusRequest::setDeadline( const QModbusDeadline &deadline )
+{
+    _deadline = deadline;
+}
+
+const QModbusDeadline &QModbusRequest::deadline( void ) const
+{
+    return _deadline;
+}
+
+void QModbusRequest::setCancellationToken( const QModbusCancellationToken &token )
+{
+    _token = token;
+}
+
+const QModbusCancellationToken &QModbusRequest::cancellationToken( void ) const
+{
+    return _token;
+}
+
+bool QModbusRequest::isLimited( void ) const
+{
+    return !_deadline.isNever() || _token.isCancellable();
+}
+
+quint8 QModbusRequest::limitStatus( void ) const
+{
+    if ( _token.isCancelled() ) return QAbstractModbus::Cancelled;
+    if ( _deadline.hasExpired() ) return QAbstractModbus::Timeout;
+    return QAbstractModbus::Ok;
+}
+
+void QModbusRequest::setPriority( const Priority priority )
+{
+    _priority = priority;
+}
+
+QModbusRequest::Priority QModbusRequest::priority( void ) const
+{
+    return _priority;
+}
+
+
+/*** QModbusResponse implementation ***********************************************************************************/
+QModbusResponse::QModbusResponse( void ) : _status( QAbstractModbus::UnknownError )
+{}
+
+QModbusResponse::QModbusResponse( const quint8 status , const QModbusFrameView &pdu ) : _status( status )
+{
+    if ( status == QAbstractModbus::Ok ) _pdu.append( pdu.data() , pdu.size() );
+}
+
+quint8 QModbusResponse::status( void ) const
+{
+    return _status;
+}
+
+bool QModbusResponse::isOk( void ) const
+{
+    return _status == QAbstractModbus::Ok;
+}
+
+QModbusFrameView QModbusResponse::pdu( void ) const
+{
+    return _pdu.view();
+}
+
+QList<quint16> QModbusResponse::registers( void ) const
+{
+    // Function code, byte count and the registers.
+    QList<quint16> list;
+    if ( !isOk() || _pdu.size() < 2 || _pdu.at( 1 ) & 1 || _pdu.size() != _pdu.at( 1 ) + 2 ) return list;
+
+    const QModbusFrameView pdu = _pdu.view();
+    for ( int i = 2 ; i < pdu.size() ; i += 2 ) list.append( pdu.value( i ) );
+    return list;
+}
+
+QList<bool> QModbusResponse::bits( const quint16 quantity ) const
+{
+    // Function code, byte count and the bits packed LSB first.
+    QList<bool> list;
+    const int bytes = ( quantity + 7 ) / 8;
+    if ( !isOk() || _pdu.size() != bytes + 2 || _pdu.at( 1 ) != bytes ) return list;
+
+    const uchar *data = (const uchar *)_pdu.constData() + 2;
+    for ( int i = 0 ; i < quantity ; i++ ) list.append( data[i >> 3] & ( 0x01 << ( i & 7 ) ) );
+    return list;
+}
+
+QList<quint16> QModbusResponse::fifoQueue( void ) const
+{
+    // Function code, byte count, FIFO count and the registers.
+    QList<quint16> list;
+    if ( !isOk() || _pdu.size() < 5 ) return list;
+
+    const QModbusFrameView pdu = _pdu.view();
+    const int byteCount = pdu.value( 1 );
+    const int fifoCount = pdu.value( 3 );
+    if ( byteCount != fifoCount * 2 + 2 || pdu.size() != byteCount + 3 ) return list;
+
+    for ( int i = 0 ; i < fifoCount ; i++ ) list.append( pdu.value( 5 + 2 * i ) );
+    return list;
+}
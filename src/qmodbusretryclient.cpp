@@ -0,0 +1,394 @@
+/***********************************************************************************************************************
+* QModbusRetryClient implementation.                                                                                  *
+***********************************************************************************************************************/
+#include <QModbusRetryClient>
+
+
+/*** Qt includes ******************************************************************************************************/
+#include <QModbusRequestCore>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QSemaphore>
+
+
+/*** Request core *****************************************************************************************************/
+// I/O policy of the request core, every request goes through the retries.
+class QModbusRetryClientIo
+{
+public:
+    explicit QModbusRetryClientIo( const QModbusRetryClient &client ) : _client( client ) {}
+
+    bool isOpen( void ) const
+    {
+        return _client.isOpen();
+    }
+
+    QModbusResponse execute( const QModbusRequest &request ) const
+    {
+        return _client.execute( request );
+    }
+
+private:
+    const QModbusRetryClient &_client;
+};
+
+typedef QModbusRequestCore<QModbusRequestFraming,QModbusRetryClientIo> QModbusRetryClientCore;
+
+static inline QModbusRetryClientCore core( const QModbusRetryClient &client )
+{
+    return QModbusRetryClientCore( QModbusRetryClientIo( client ) );
+}
+
+
+/*** Class implementation *********************************************************************************************/
+QModbusRetryClient::QModbusRetryClient( QAbstractModbus &modbus , QObject *parent ) :
+    QObject( parent ) , _modbus( modbus ) , _maximumRetries( 3 ) , _timeoutBackoff( 50 ) , _busyDelay( 200 ) ,
+    _maximumDelay( 2000 ) , _budgetRatio( 0.1 ) , _budgetMaximum( 10 )
+{}
+
+void QModbusRetryClient::setMaximumRetries( const int retries )
+{
+    _maximumRetries = qBound( 0 , retries , (int)MaxRetries );
+}
+
+int QModbusRetryClient::maximumRetries( void ) const
+{
+    return _maximumRetries;
+}
+
+void QModbusRetryClient::setTimeoutBackoff( const int msecs )
+{
+    _timeoutBackoff = qMax( 0 , msecs );
+}
+
+int QModbusRetryClient::timeoutBackoff( void ) const
+{
+    return _timeoutBackoff;
+}
+
+void QModbusRetryClient::setBusyDelay( const int msecs )
+{
+    _busyDelay = qMax( 0 , msecs );
+}
+
+int QModbusRetryClient::busyDelay( void ) const
+{
+    return _busyDelay;
+}
+
+void QModbusRetryClient::setMaximumDelay( const int msecs )
+{
+    _maximumDelay = qMax( 0 , msecs );
+}
+
+int QModbusRetryClient::maximumDelay( void ) const
+{
+    return _maximumDelay;
+}
+
+void QModbusRetryClient::setRetryBudget( const double ratio , const int maximum )
+{
+    QMutexLocker locker( &_mutex );
+    _budgetRatio = qMax( 0.0 , ratio );
+    _budgetMaximum = qMax( 0 , maximum );
+}
+
+double QModbusRetryClient::retryBudgetRatio( void ) const
+{
+    QMutexLocker locker( &_mutex );
+    return _budgetRatio;
+}
+
+int QModbusRetryClient::retryBudgetMaximum( void ) const
+{
+    QMutexLocker locker( &_mutex );
+    return _budgetMaximum;
+}
+
+double QModbusRetryClient::retryBudget( const quint8 deviceAddress ) const
+{
+    QMutexLocker locker( &_mutex );
+    return _device( deviceAddress ).budget;
+}
+
+QModbusRetryClient::Statistics QModbusRetryClient::statistics( void ) const
+{
+    QMutexLocker locker( &_mutex );
+    Statistics total;
+    foreach ( const Device &device , _devices )
+    {
+        total.requests += device.statistics.requests;
+        total.retries += device.statistics.retries;
+        total.crcRetries += device.statistics.crcRetries;
+        total.timeoutRetries += device.statistics.timeoutRetries;
+        total.busyRetries += device.statistics.busyRetries;
+        total.recovered += device.statistics.recovered;
+        total.exhausted += device.statistics.exhausted;
+        total.budgetExhausted += device.statistics.budgetExhausted;
+    }
+    return total;
+}
+
+QModbusRetryClient::Statistics QModbusRetryClient::statistics( const quint8 deviceAddress ) const
+{
+    QMutexLocker locker( &_mutex );
+    return _devices.contains( deviceAddress ) ? _devices.value( deviceAddress ).statistics : Statistics();
+}
+
+void QModbusRetryClient::resetStatistics( void )
+{
+    QMutexLocker locker( &_mutex );
+    for ( QHash<quint8,Device>::iterator i = _devices.begin() ; i != _devices.end() ; ++i )
+    {
+        i.value().statistics = Statistics();
+    }
+}
+
+QModbusResponse QModbusRetryClient::execute( const QModbusRequest &request ) const
+{
+    return _retry( request , _modbus.execute( QList<QModbusRequest>() << request ).first() );
+}
+
+bool QModbusRetryClient::isOpen( void ) const
+{
+    return _modbus.isOpen();
+}
+
+unsigned int QModbusRetryClient::timeout( void ) const
+{
+    return _modbus.timeout();
+}
+
+void QModbusRetryClient::setTimeout( const unsigned int timeout )
+{
+    _modbus.setTimeout( timeout );
+}
+
+QList<bool> QModbusRetryClient::readCoils( const quint8 deviceAddress , const quint16 startingAddress ,
+                                           const quint16 quantityOfCoils , quint8 *const status ) const
+{
+    return core( *this ).readBits( deviceAddress , 0x01 , startingAddress , quantityOfCoils , status );
+}
+
+QList<bool> QModbusRetryClient::readDiscreteInputs( const quint8 deviceAddress , const quint16 startingAddress ,
+                                                    const quint16 quantityOfInputs , quint8 *const status ) const
+{
+    return core( *this ).readBits( deviceAddress , 0x02 , startingAddress , quantityOfInputs , status );
+}
+
+QList<quint16> QModbusRetryClient::readHoldingRegisters( const quint8 deviceAddress ,
+                                                         const quint16 startingAddress ,
+                                                         const quint16 quantityOfRegisters ,
+                                                         quint8 *const status ) const
+{
+    return core( *this ).readRegisters( deviceAddress , 0x03 , startingAddress , quantityOfRegisters , status );
+}
+
+QList<quint16> QModbusRetryClient::readInputRegisters( const quint8 deviceAddress ,
+                                                       const quint16 startingAddress ,
+                                                       const quint16 quantityOfInputRegisters ,
+                                                       quint8 *const status ) const
+{
+    return core( *this ).readRegisters( deviceAddress , 0x04 , startingAddress , quantityOfInputRegisters , status );
+}
+
+bool QModbusRetryClient::writeSingleCoil( const quint8 deviceAddress , const quint16 outputAddress ,
+                                          const bool outputValue , quint8 *const status ) const
+{
+    return core( *this ).writeSingleCoil( deviceAddress , outputAddress , outputValue , status );
+}
+
+bool QModbusRetryClient::writeSingleRegister( const quint8 deviceAddress , const quint16 registerAddress ,
+                                              const quint16 registerValue , quint8 *const status ) const
+{
+    return core( *this ).writeSingleRegister( deviceAddress , registerAddress , registerValue , status );
+}
+
+bool QModbusRetryClient::writeMultipleCoils( const quint8 deviceAddress , const quint16 startingAddress ,
+                                             const QList<bool> & outputValues , quint8 *const status ) const
+{
+    return core( *this ).writeMultipleCoils( deviceAddress , startingAddress , outputValues , status );
+}
+
+bool QModbusRetryClient::writeMultipleRegisters( const quint8 deviceAddress , const quint16 startingAddress ,
+                                                 const QList<quint16> & registersValues ,
+                                                 quint8 *const status ) const
+{
+    return core( *this ).writeMultipleRegisters( deviceAddress , startingAddress , registersValues , status );
+}
+
+bool QModbusRetryClient::maskWriteRegister( const quint8 deviceAddress , const quint16 referenceAddress ,
+                                            const quint16 andMask , const quint16 orMask ,
+                                            quint8 *const status ) const
+{
+    return core( *this ).maskWriteRegister( deviceAddress , referenceAddress , andMask , orMask , status );
+}
+
+QList<quint16> QModbusRetryClient::writeReadMultipleRegisters( const quint8 deviceAddress ,
+                                                               const quint16 writeStartingAddress ,
+                                                               const QList<quint16> & writeValues ,
+                                                               const quint16 readStartingAddress ,
+                                                               const quint16 quantityToRead ,
+                                                               quint8 *const status ) const
+{
+    return core( *this ).writeReadMultipleRegisters( deviceAddress , writeStartingAddress , writeValues ,
+                                                     readStartingAddress , quantityToRead , status );
+}
+
+QList<quint16> QModbusRetryClient::readFifoQueue( const quint8 deviceAddress , const quint16 fifoPointerAddress ,
+                                                  quint8 *const status ) const
+{
+    return core( *this ).readFifoQueue( deviceAddress , fifoPointerAddress , status );
+}
+
+QByteArray QModbusRetryClient::executeCustomFunction( const quint8 deviceAddress , const quint8 modbusFunction ,
+                                                      QByteArray &data , quint8 *const status ) const
+{
+    return core( *this ).executeCustomFunction( deviceAddress , modbusFunction , data , status );
+}
+
+bool QModbusRetryClient::executePdu( const quint8 deviceAddress , const QModbusFrameView &request ,
+                                     QModbusPduFrame &response , quint8 *const status ) const
+{
+    return core( *this ).executePdu( deviceAddress , request , response , status );
+}
+
+QList<QModbusResponse> QModbusRetryClient::execute( const QList<QModbusRequest> &batch ) const
+{
+    // The transport keeps its optimizations (pipelining) for the first attempt of the whole batch.
+    QList<QModbusResponse> responses = _modbus.execute( batch );
+    for ( int i = 0 ; i < responses.count() ; i++ ) responses[i] = _retry( batch.at( i ) , responses.at( i ) );
+    return responses;
+}
+
+QByteArray QModbusRetryClient::executeRaw( QByteArray &data , quint8 *const status ) const
+{
+    return _modbus.executeRaw( data , status );
+}
+
+QByteArray QModbusRetryClient::calculateCheckSum( QByteArray &data ) const
+{
+    return _modbus.calculateCheckSum( data );
+}
+
+QModbusResponse QModbusRetryClient::_retry( const QModbusRequest &request , QModbusResponse response ) const
+{
+    if ( !request.isValid() ) return response;
+    const quint8 deviceAddress = request.deviceAddress();
+    const quint8 functionCode = request.functionCode();
+
+    // Each request adds its share to the budget of the device.
+    {
+        QMutexLocker locker( &_mutex );
+        Device &device = _device( deviceAddress );
+        device.budget = qMin( (double)_budgetMaximum , device.budget + _budgetRatio );
+        device.statistics.requests++;
+    }
+
+    int retries = 0;
+    while ( _isRetryable( functionCode , response.status() ) && request.limitStatus() == Ok )
+    {
+        const quint8 status = response.status();
+        QMutexLocker locker( &_mutex );
+        Device &device = _device( deviceAddress );
+        if ( retries >= _maximumRetries )
+        {
+            device.statistics.exhausted++;
+            break;
+        }
+        if ( device.budget < 1 )
+        {
+            device.statistics.budgetExhausted++;
+            locker.unlock();
+            emit const_cast<QModbusRetryClient *>( this )->retryBudgetExhausted( deviceAddress );
+            break;
+        }
+
+        // CRC errors are retried right away, timeouts and busy devices after a delay doubling with each retry.
+        int delay = 0;
+        if ( status == CrcError )
+        {
+            device.statistics.crcRetries++;
+        }
+        else if ( status == Timeout )
+        {
+            delay = (int)qMin( (qint64)_timeoutBackoff << retries , (qint64)_maximumDelay );
+            device.statistics.timeoutRetries++;
+        }
+        else
+        {
+            delay = (int)qMin( (qint64)_busyDelay << retries , (qint64)_maximumDelay );
+            device.statistics.busyRetries++;
+        }
+        device.budget -= 1;
+        device.statistics.retries++;
+        locker.unlock();
+
+        emit const_cast<QModbusRetryClient *>( this )->retrying( deviceAddress , functionCode , status , ++retries ,
+                                                                 delay );
+        if ( !_wait( delay , request ) ) break;
+        response = _modbus.execute( QList<QModbusRequest>() << request ).first();
+    }
+
+    // A request cancelled or expired while waiting for the retry fails as such.
+    if ( !response.isOk() && request.limitStatus() != Ok ) return QModbusResponse( request.limitStatus() );
+    if ( retries && response.isOk() )
+    {
+        QMutexLocker locker( &_mutex );
+        _device( deviceAddress ).statistics.recovered++;
+    }
+    return response;
+}
+
+QModbusRetryClient::Device &QModbusRetryClient::_device( const quint8 deviceAddress ) const
+{
+    QHash<quint8,Device>::iterator i = _devices.find( deviceAddress );
+    if ( i == _devices.end() ) i = _devices.insert( deviceAddress , Device( _budgetMaximum ) );
+    return i.value();
+}
+
+bool QModbusRetryClient::_wait( const int msecs , const QModbusRequest &request )
+{
+    // QThread::msleep() is protected with Qt 4: wait on a semaphore nobody releases, in steps while the request can
+    // be cancelled.
+    QSemaphore never;
+    QElapsedTimer clock;
+    clock.start();
+    int left;
+    while ( ( left = msecs - (int)clock.elapsed() ) > 0 && request.limitStatus() == Ok )
+    {
+        int step = request.deadline().remaining( left );
+        if ( request.cancellationToken().isCancellable() ) step = qMin( step , (int)PollInterval );
+        never.tryAcquire( 1 , step );
+    }
+    return request.limitStatus() == Ok;
+}
+
+bool QModbusRetryClient::_isRetryable( const quint8 functionCode , const quint8 status )
+{
+    // Functions a device may execute twice without harm: reads and writes of absolute values.
+    bool idempotent;
+    switch( functionCode )
+    {
+        case 0x01: case 0x02: case 0x03: case 0x04: case 0x05: case 0x06: case 0x0F: case 0x10: case 0x16: case 0x17:
+            idempotent = true;
+            break;
+
+        default:
+            idempotent = false;
+            break;
+    }
+
+    switch( status )
+    {
+        case SlaveDeviceBusy:
+            return true;
+
+        case CrcError:
+        case Timeout:
+        case Acknowledge:
+            return idempotent;
+
+        default:
+            return false;
+    }
+}
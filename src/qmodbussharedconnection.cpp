@@ -0,0 +1,588 @@
+/***********************************************************************************************************************
+* QModbusSharedConnection implementation.                                                                             *
+***********************************************************************************************************************/
+#include <QModbusSharedConnection>
+
+
+/*** Qt includes ******************************************************************************************************/
+#include <QModbusRequestCore>
+#include <QtCore/QCoreApplication>
+#include <QtCore/QElapsedTimer>
+
+
+/*** Request core *****************************************************************************************************/
+// I/O policy of the request core, hands the requests to the I/O thread.
+class QModbusSharedConnectionIo
+{
+public:
+    explicit QModbusSharedConnectionIo( const QModbusSharedConnection &connection ) : _connection( connection ) {}
+
+    bool isOpen( void ) const
+    {
+        return _connection.isOpen();
+    }
+
+    QModbusResponse execute( const QModbusRequest &request ) const
+    {
+        return _connection.execute( request );
+    }
+
+private:
+    const QModbusSharedConnection &_connection;
+};
+
+// The transport of the I/O thread does the actual framing.
+typedef QModbusRequestCore<QModbusRequestFraming,QModbusSharedConnectionIo> QModbusSharedConnectionCore;
+
+static inline QModbusSharedConnectionCore core( const QModbusSharedConnection &connection )
+{
+    return QModbusSharedConnectionCore( QModbusSharedConnectionIo( connection ) );
+}
+
+
+/*** QModbusReply implementation **************************************************************************************/
+QModbusReply::QModbusReply( const int id , const QModbusRequest &request ) :
+    _id( id ) , _request( request ) , _finished( 0 ) , _isRaw( false ) , _handler( NULL ) , _context( NULL ) ,
+    _queueTime( 0 ) , _due( 0 ) , _reserved( false )
+{}
+
+int QModbusReply::id( void ) const
+{
+    return _id;
+}
+
+const QModbusRequest &QModbusReply::request( void ) const
+{
+    return _request;
+}
+
+bool QModbusReply::isFinished( void ) const
+{
+    return _finished.fetchAndAddAcquire( 0 ) != 0;
+}
+
+bool QModbusReply::waitForFinished( const int msecs )
+{
+    if ( isFinished() ) return true;
+
+    // Take the token and put it back for other waiting threads.
+    if ( !_done.tryAcquire( 1 , msecs ) ) return false;
+    _done.release();
+    return true;
+}
+
+QModbusResponse QModbusReply::response( void ) const
+{
+    return isFinished() ? _response : QModbusResponse();
+}
+
+int QModbusReply::queueTime( void ) const
+{
+    return isFinished() ? _queueTime : 0;
+}
+
+void QModbusReply::_finish( const QModbusResponse &response )
+{
+    _response = response;
+    _finished.fetchAndStoreRelease( 1 );
+    _done.release();
+    if ( _handler ) _handler( _response , _context );
+}
+
+
+/*** QModbusSharedConnection implementation ***************************************************************************/
+QModbusSharedConnection::QModbusSharedConnection( QAbstractModbus &modbus , QObject *parent ) :
+    QObject( parent ) , _modbus( modbus ) , _pending( 0 ) , _nextId( 0 ) , _stopping( 0 ) ,
+    _reconnectTimeout( 0 ) , _preemptive( 0 ) , _open( modbus.isOpen() ) , _timeout( (int)modbus.timeout() ) ,
+    _timeoutChanged( 0 ) , _held( 0 ) , _rateLimiter( NULL ) , _thread( *this )
+{
+    // Only the I/O thread may use a transport that is a QObject (sockets have a thread affinity).
+    QObject *const object = dynamic_cast<QObject *>( &modbus );
+    if ( object ) object->moveToThread( &_thread );
+
+    _thread.start();
+}
+
+QModbusSharedConnection::~QModbusSharedConnection()
+{
+    // Stop the I/O thread.
+    _stopping.fetchAndStoreOrdered( 1 );
+    _queued.release();
+    _thread.wait();
+
+    // Fail what is left in the queue.
+    QModbusReply *reply;
+    while ( ( reply = _queue.pop() ) ) _finish( reply , QModbusResponse( NoConnection ) );
+}
+
+QModbusReplyPointer QModbusSharedConnection::submit( const QModbusRequest &request ) const
+{
+    QModbusReplyPointer reply( new QModbusReply( _nextId.fetchAndAddRelaxed( 1 ) , request ) );
+    _enqueue( reply );
+    return reply;
+}
+
+QModbusReplyPointer QModbusSharedConnection::submit( const QModbusRequest &request ,
+                                                     const QModbusReply::Handler handler , void *const context ) const
+{
+    QModbusReplyPointer reply( new QModbusReply( _nextId.fetchAndAddRelaxed( 1 ) , request ) );
+    reply->_handler = handler;
+    reply->_context = context;
+    _enqueue( reply );
+    return reply;
+}
+
+QModbusResponse QModbusSharedConnection::execute( const QModbusRequest &request ) const
+{
+    const QModbusReplyPointer reply = submit( request );
+    reply->waitForFinished();
+    return reply->response();
+}
+
+int QModbusSharedConnection::pendingCount( void ) const
+{
+    return _pending.fetchAndAddRelaxed( 0 );
+}
+
+void QModbusSharedConnection::setReconnectTimeout( const int msecs )
+{
+    _reconnectTimeout.fetchAndStoreRelaxed( qMax( 0 , msecs ) );
+}
+
+int QModbusSharedConnection::reconnectTimeout( void ) const
+{
+    return _reconnectTimeout.fetchAndAddRelaxed( 0 );
+}
+
+void QModbusSharedConnection::setPreemptive( const bool preemptive )
+{
+    _preemptive.fetchAndStoreRelaxed( preemptive ? 1 : 0 );
+}
+
+bool QModbusSharedConnection::isPreemptive( void ) const
+{
+    return _preemptive.fetchAndAddRelaxed( 0 ) != 0;
+}
+
+QModbusSharedConnection::QueueStatistics QModbusSharedConnection::queueStatistics(
+    const QModbusRequest::Priority priority ) const
+{
+    QMutexLocker locker( &_statisticsMutex );
+    return _statistics[qBound( 0 , (int)priority , QModbusRequest::PriorityCount - 1 )];
+}
+
+void QModbusSharedConnection::resetQueueStatistics( void )
+{
+    QMutexLocker locker( &_statisticsMutex );
+    for ( int i = 0 ; i < QModbusRequest::PriorityCount ; i++ ) _statistics[i] = QueueStatistics();
+}
+
+void QModbusSharedConnection::setRateLimiter( QModbusRateLimiter *const limiter )
+{
+    _rateLimiter = limiter;
+}
+
+QModbusRateLimiter *QModbusSharedConnection::rateLimiter( void ) const
+{
+    return _rateLimiter;
+}
+
+bool QModbusSharedConnection::isOpen( void ) const
+{
+    return _open.fetchAndAddAcquire( 0 );
+}
+
+unsigned int QModbusSharedConnection::timeout( void ) const
+{
+    return (unsigned int)_timeout.fetchAndAddAcquire( 0 );
+}
+
+void QModbusSharedConnection::setTimeout( const unsigned int timeout )
+{
+    // The I/O thread applies the timeout before it starts the next request.
+    _timeout.fetchAndStoreOrdered( (int)timeout );
+    _timeoutChanged.fetchAndStoreRelease( 1 );
+}
+
+QList<bool> QModbusSharedConnection::readCoils( const quint8 deviceAddress , const quint16 startingAddress ,
+                                                const quint16 quantityOfCoils , quint8 *const status ) const
+{
+    return core( *this ).readBits( deviceAddress , 0x01 , startingAddress , quantityOfCoils , status );
+}
+
+QList<bool> QModbusSharedConnection::readDiscreteInputs( const quint8 deviceAddress , const quint16 startingAddress ,
+                                                         const quint16 quantityOfInputs , quint8 *const status ) const
+{
+    return core( *this ).readBits( deviceAddress , 0x02 , startingAddress , quantityOfInputs , status );
+}
+
+QList<quint16> QModbusSharedConnection::readHoldingRegisters( const quint8 deviceAddress ,
+                                                              const quint16 startingAddress ,
+                                                              const quint16 quantityOfRegisters ,
+                                                              quint8 *const status ) const
+{
+    return core( *this ).readRegisters( deviceAddress , 0x03 , startingAddress , quantityOfRegisters , status );
+}
+
+QList<quint16> QModbusSharedConnection::readInputRegisters( const quint8 deviceAddress ,
+                                                            const quint16 startingAddress ,
+                                                            const quint16 quantityOfInputRegisters ,
+                                                            quint8 *const status ) const
+{
+    return core( *this ).readRegisters( deviceAddress , 0x04 , startingAddress , quantityOfInputRegisters , status );
+}
+
+bool QModbusSharedConnection::writeSingleCoil( const quint8 deviceAddress , const quint16 outputAddress ,
+                                               const bool outputValue , quint8 *const status ) const
+{
+    return core( *this ).writeSingleCoil( deviceAddress , outputAddress , outputValue , status );
+}
+
+bool QModbusSharedConnection::writeSingleRegister( const quint8 deviceAddress , const quint16 registerAddress ,
+                                                   const quint16 registerValue , quint8 *const status ) const
+{
+    return core( *this ).writeSingleRegister( deviceAddress , registerAddress , registerValue , status );
+}
+
+bool QModbusSharedConnection::writeMultipleCoils( const quint8 deviceAddress , const quint16 startingAddress ,
+                                                  const QList<bool> & outputValues , quint8 *const status ) const
+{
+    return core( *this ).writeMultipleCoils( deviceAddress , startingAddress , outputValues , status );
+}
+
+bool QModbusSharedConnection::writeMultipleRegisters( const quint8 deviceAddress , const quint16 startingAddress ,
+                                                      const QList<quint16> & registersValues ,
+                                                      quint8 *const status ) const
+{
+    return core( *this ).writeMultipleRegisters( deviceAddress , startingAddress , registersValues , status );
+}
+
+bool QModbusSharedConnection::maskWriteRegister( const quint8 deviceAddress , const quint16 referenceAddress ,
+                                                 const quint16 andMask , const quint16 orMask ,
+                                                 quint8 *const status ) const
+{
+    return core( *this ).maskWriteRegister( deviceAddress , referenceAddress , andMask , orMask , status );
+}
+
+QList<quint16> QModbusSharedConnection::writeReadMultipleRegisters( const quint8 deviceAddress ,
+                                                                    const quint16 writeStartingAddress ,
+                                                                    const QList<quint16> & writeValues ,
+                                                                    const quint16 readStartingAddress ,
+                                                                    const quint16 quantityToRead ,
+                                                                    quint8 *const status ) const
+{
+    return core( *this ).writeReadMultipleRegisters( deviceAddress , writeStartingAddress , writeValues ,
+                                                     readStartingAddress , quantityToRead , status );
+}
+
+QList<quint16> QModbusSharedConnection::readFifoQueue( const quint8 deviceAddress , const quint16 fifoPointerAddress ,
+                                                       quint8 *const status ) const
+{
+    return core( *this ).readFifoQueue( deviceAddress , fifoPointerAddress , status );
+}
+
+QByteArray QModbusSharedConnection::executeCustomFunction( const quint8 deviceAddress , const quint8 modbusFunction ,
+                                                           QByteArray &data , quint8 *const status ) const
+{
+    return core( *this ).executeCustomFunction( deviceAddress , modbusFunction , data , status );
+}
+
+bool QModbusSharedConnection::executePdu( const quint8 deviceAddress , const QModbusFrameView &request ,
+                                          QModbusPduFrame &response , quint8 *const status ) const
+{
+    return core( *this ).executePdu( deviceAddress , request , response , status );
+}
+
+QList<QModbusResponse> QModbusSharedConnection::execute( const QList<QModbusRequest> &batch ) const
+{
+    // Queue all requests before waiting, so the I/O thread finds them together.
+    QList<QModbusReplyPointer> replies;
+    foreach ( const QModbusRequest &request , batch ) replies.append( submit( request ) );
+
+    QList<QModbusResponse> responses;
+    foreach ( const QModbusReplyPointer &reply , replies )
+    {
+        reply->waitForFinished();
+        responses.append( reply->response() );
+    }
+    return responses;
+}
+
+QByteArray QModbusSharedConnection::executeRaw( QByteArray &data , quint8 *const status ) const
+{
+    // The raw data travels with the reply, the response comes back the same way.
+    QModbusReplyPointer reply( new QModbusReply( _nextId.fetchAndAddRelaxed( 1 ) , QModbusRequest() ) );
+    reply->_raw = data;
+    reply->_isRaw = true;
+    _enqueue( reply );
+    reply->waitForFinished();
+
+    if ( status ) *status = reply->response().status();
+    return reply->_raw;
+}
+
+QByteArray QModbusSharedConnection::calculateCheckSum( QByteArray &data ) const
+{
+    return _modbus.calculateCheckSum( data );
+}
+
+void QModbusSharedConnection::_run( void )
+{
+    _clock.start();
+    for ( ;; )
+    {
+        // Unless requests wait in the lanes, wait for a request (or the stop request of the destructor) or for the
+        // next parked request. While a disconnected transport may reconnect, keep processing the events of the I/O
+        // thread.
+        while ( !_held )
+        {
+            int wait = _parkedWait();
+            if ( !wait ) break;
+            if ( reconnectTimeout() && !_modbus.isOpen() )
+            {
+                wait = wait < 0 ? (int)PollInterval : qMin( wait , (int)PollInterval );
+            }
+            if ( _queued.tryAcquire( 1 , wait ) )
+            {
+                _queued.release();
+                break;
+            }
+            QCoreApplication::processEvents();
+            _refresh();
+        }
+
+        // The lanes are looked at only once the transport is ready, so a request of a higher class that arrives while
+        // waiting still overtakes the ones already waiting.
+        _sort();
+        _waitForTransport();
+        if ( _stopping.fetchAndAddAcquire( 0 ) ) break;
+        _unpark();
+        if ( !_held ) continue;
+
+        _refresh();
+        _execute( _take() );
+        _refresh();
+    }
+
+    // Fail the requests left in the lanes, the destructor fails those still queued.
+    for ( int i = 0 ; i < QModbusRequest::PriorityCount ; i++ )
+    {
+        foreach ( QModbusReply *const reply , _lanes[i] ) _finish( reply , QModbusResponse( NoConnection ) );
+        _lanes[i].clear();
+    }
+    _held = 0;
+    foreach ( const QList<QModbusReply *> &parked , _parked )
+    {
+        foreach ( QModbusReply *const reply , parked ) _finish( reply , QModbusResponse( NoConnection ) );
+    }
+    _parked.clear();
+
+    // Hand the transport back to the thread that created the shared connection.
+    QObject *const object = dynamic_cast<QObject *>( &_modbus );
+    if ( object ) object->moveToThread( thread() );
+}
+
+void QModbusSharedConnection::_enqueue( const QModbusReplyPointer &reply ) const
+{
+    // Invalid requests and requests after the I/O thread was stopped never reach the queue.
+    if ( !reply->_isRaw && !reply->_request.isValid() )
+    {
+        reply->_raw.clear();
+        reply->_finish( QModbusResponse( IllegalDataValue ) );
+        return;
+    }
+    if ( _stopping.fetchAndAddAcquire( 0 ) )
+    {
+        reply->_raw.clear();
+        reply->_finish( QModbusResponse( NoConnection ) );
+        return;
+    }
+
+    // The queue holds a reference until the reply is finished.
+    reply->_self = reply;
+    reply->_queued.start();
+    _pending.fetchAndAddRelaxed( 1 );
+    _queue.push( reply.data() );
+    _queued.release();
+}
+
+void QModbusSharedConnection::_sort( void )
+{
+    while ( _queued.tryAcquire() )
+    {
+        // The destructor sets the stop request before it releases its wake-up token, so a token taken once the stop
+        // request is seen may be that one: there is no request behind it. Leave it to the I/O thread loop.
+        if ( _stopping.fetchAndAddAcquire( 0 ) )
+        {
+            _queued.release();
+            break;
+        }
+        QModbusReply *const reply = _pop();
+        _lanes[qBound( 0 , (int)reply->_request.priority() , QModbusRequest::PriorityCount - 1 )].append( reply );
+        _held++;
+    }
+}
+
+QModbusReply *QModbusSharedConnection::_pop( void )
+{
+    QModbusReply *reply;
+    while ( !( reply = _queue.pop() ) ) QThread::yieldCurrentThread();
+    return reply;
+}
+
+void QModbusSharedConnection::_waitForTransport( void )
+{
+    const int timeout = reconnectTimeout();
+    if ( !timeout || _modbus.isOpen() ) return;
+
+    // The requests stay queued until the transport is back, the stop request or the timeout.
+    QElapsedTimer clock;
+    clock.start();
+    while ( !_modbus.isOpen() && !clock.hasExpired( timeout ) && !_stopping.fetchAndAddAcquire( 0 ) )
+    {
+        QCoreApplication::processEvents();
+        _refresh();
+        IoThread::pause( PollInterval );
+        _sort();
+    }
+    QCoreApplication::processEvents();
+    _refresh();
+}
+
+QList<QModbusReply *> QModbusSharedConnection::_take( void )
+{
+    int priority = 0;
+    while ( _lanes[priority].isEmpty() ) priority++;
+
+    // Bulk requests always go one at a time, the classes below Control too if preemptive: the lanes are looked at
+    // again after each frame.
+    const bool single = priority == QModbusRequest::Bulk || ( priority != QModbusRequest::Control && isPreemptive() );
+    QList<QModbusReply *> &lane = _lanes[priority];
+    const QList<QModbusReply *> replies = lane.mid( 0 , single ? 1 : (int)MaxBatchSize );
+    lane.erase( lane.begin() , lane.begin() + replies.count() );
+    _held -= replies.count();
+    return replies;
+}
+
+void QModbusSharedConnection::_execute( const QList<QModbusReply *> &replies )
+{
+    QList<QModbusReply *> batch;
+    for ( int i = 0 ; i <= replies.count() ; i++ )
+    {
+        QModbusReply *const reply = i < replies.count() ? replies.at( i ) : NULL;
+
+        // Reserve the request with the rate limiter. A request it holds back is parked, so are the requests of a unit
+        // that has parked requests: a unit's requests stay in order.
+        if ( reply && !reply->_isRaw && _rateLimiter && !reply->_reserved )
+        {
+            const int wait = _rateLimiter->reserve( reply->_request );
+            reply->_reserved = true;
+            if ( wait || _parked.contains( reply->_request.deviceAddress() ) )
+            {
+                _park( reply , wait );
+                continue;
+            }
+        }
+
+        // Collect the requests up to the next raw request or the end.
+        if ( reply && !reply->_isRaw )
+        {
+            _account( reply );
+            batch.append( reply );
+            continue;
+        }
+
+        if ( !batch.isEmpty() )
+        {
+            QList<QModbusRequest> requests;
+            foreach ( QModbusReply *const collected , batch ) requests.append( collected->_request );
+            const QList<QModbusResponse> responses = _modbus.execute( requests );
+            for ( int j = 0 ; j < batch.count() ; j++ )
+            {
+                if ( _rateLimiter ) _rateLimiter->report( requests.at( j ) , responses.at( j ) );
+                _finish( batch.at( j ) , responses.at( j ) );
+            }
+            batch.clear();
+        }
+
+        if ( reply )
+        {
+            quint8 status = Ok;
+            _account( reply );
+            reply->_raw = _modbus.executeRaw( reply->_raw , &status );
+            _finish( reply , QModbusResponse( status ) );
+        }
+    }
+}
+
+void QModbusSharedConnection::_park( QModbusReply *const reply , const int wait )
+{
+    QList<QModbusReply *> &parked = _parked[reply->_request.deviceAddress()];
+    reply->_due = _clock.elapsed() + wait;
+    if ( !parked.isEmpty() ) reply->_due = qMax( reply->_due , parked.last()->_due );
+    parked.append( reply );
+}
+
+void QModbusSharedConnection::_unpark( void )
+{
+    // Collect the due requests by lane first, they go before the requests that arrived while they were parked.
+    const qint64 now = _clock.elapsed();
+    QList<QModbusReply *> due[QModbusRequest::PriorityCount];
+    QHash<quint8,QList<QModbusReply *> >::iterator i = _parked.begin();
+    while ( i != _parked.end() )
+    {
+        QList<QModbusReply *> &parked = i.value();
+        while ( !parked.isEmpty() && parked.first()->_due <= now )
+        {
+            QModbusReply *const reply = parked.takeFirst();
+            due[qBound( 0 , (int)reply->_request.priority() , QModbusRequest::PriorityCount - 1 )].append( reply );
+            _held++;
+        }
+        if ( parked.isEmpty() ) i = _parked.erase( i );
+        else ++i;
+    }
+    for ( int priority = 0 ; priority < QModbusRequest::PriorityCount ; priority++ )
+    {
+        if ( !due[priority].isEmpty() ) _lanes[priority] = due[priority] + _lanes[priority];
+    }
+}
+
+int QModbusSharedConnection::_parkedWait( void ) const
+{
+    if ( _parked.isEmpty() ) return -1;
+
+    qint64 due = _parked.begin().value().first()->_due;
+    foreach ( const QList<QModbusReply *> &parked , _parked ) due = qMin( due , parked.first()->_due );
+    return (int)qBound( (qint64)0 , due - _clock.elapsed() , (qint64)0x7FFFFFFF );
+}
+
+void QModbusSharedConnection::_refresh( void )
+{
+    if ( _timeoutChanged.fetchAndStoreAcquire( 0 ) )
+    {
+        _modbus.setTimeout( (unsigned int)_timeout.fetchAndAddAcquire( 0 ) );
+    }
+    _open.fetchAndStoreRelease( _modbus.isOpen() ? 1 : 0 );
+}
+
+void QModbusSharedConnection::_account( QModbusReply *const reply )
+{
+    reply->_queueTime = (int)reply->_queued.elapsed();
+
+    QMutexLocker locker( &_statisticsMutex );
+    QueueStatistics &statistics =
+        _statistics[qBound( 0 , (int)reply->_request.priority() , QModbusRequest::PriorityCount - 1 )];
+    statistics.count++;
+    statistics.totalWait += reply->_queueTime;
+    statistics.maximumWait = qMax( statistics.maximumWait , reply->_queueTime );
+}
+
+void QModbusSharedConnection::_finish( QModbusReply *const reply , const QModbusResponse &response ) const
+{
+    // The caller may have dropped its reference already, keep the reply alive until it is finished.
+    const QModbusReplyPointer keep = reply->_self;
+    keep->_self.clear();
+    keep->_finish( response );
+    _pending.fetchAndAddRelaxed( -1 );
+    emit const_cast<QModbusSharedConnection *>( this )->replyFinished( keep->_id );
+}
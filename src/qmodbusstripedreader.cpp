@@ -0,0 +1,116 @@
+/***********************************************************************************************************************
+* QModbusStripedReader implementation.                                                                                *
+***********************************************************************************************************************/
+#include <QModbusStripedReader>
+
+
+/*** Qt includes ******************************************************************************************************/
+#include <QModbusRequest>
+
+
+/*** Class implementation *********************************************************************************************/
+QModbusStripedReader::QModbusStripedReader( const QList<QAbstractModbus *> &connections ) : _blockSize( MaxBlockSize )
+{
+    foreach ( QAbstractModbus *modbus , connections ) _connections.append( new QModbusSharedConnection( *modbus ) );
+}
+
+QModbusStripedReader::~QModbusStripedReader()
+{
+    qDeleteAll( _connections );
+}
+
+int QModbusStripedReader::connectionCount( void ) const
+{
+    return _connections.count();
+}
+
+int QModbusStripedReader::blockSize( void ) const
+{
+    return _blockSize;
+}
+
+void QModbusStripedReader::setBlockSize( const int size )
+{
+    _blockSize = qBound( 1 , size , (int)MaxBlockSize );
+}
+
+QVector<quint16> QModbusStripedReader::readHoldingRegisters( const quint8 deviceAddress ,
+                                                             const quint16 startingAddress , const int quantity ,
+                                                             QList<Block> *const blocks , quint8 *const status ) const
+{
+    return _read( deviceAddress , 0x03 , startingAddress , quantity , blocks , status );
+}
+
+QVector<quint16> QModbusStripedReader::readInputRegisters( const quint8 deviceAddress ,
+                                                           const quint16 startingAddress , const int quantity ,
+                                                           QList<Block> *const blocks , quint8 *const status ) const
+{
+    return _read( deviceAddress , 0x04 , startingAddress , quantity , blocks , status );
+}
+
+QVector<quint16> QModbusStripedReader::_read( const quint8 deviceAddress , const quint8 functionCode ,
+                                              const quint16 startingAddress , const int quantity ,
+                                              QList<Block> *const blocks , quint8 *const status ) const
+{
+    if ( blocks ) blocks->clear();
+    if ( _connections.isEmpty() )
+    {
+        if ( status ) *status = QAbstractModbus::NoConnection;
+        return QVector<quint16>();
+    }
+    if ( quantity <= 0 || startingAddress + quantity > 0x10000 )
+    {
+        if ( status ) *status = QAbstractModbus::IllegalDataValue;
+        return QVector<quint16>();
+    }
+
+    // Queue all blocks round robin before waiting for any, so every connection has its share in flight.
+    QList<QModbusReplyPointer> replies;
+    QList<Block> layout;
+    for ( int offset = 0 ; offset < quantity ; offset += _blockSize )
+    {
+        Block block;
+        block.startingAddress = startingAddress + offset;
+        block.quantity = qMin( _blockSize , quantity - offset );
+        block.status = QAbstractModbus::Ok;
+        layout.append( block );
+
+        const QModbusRequest request = functionCode == 0x03 ?
+            QModbusRequest::readHoldingRegisters( deviceAddress , block.startingAddress , block.quantity ) :
+            QModbusRequest::readInputRegisters( deviceAddress , block.startingAddress , block.quantity );
+        replies.append( _connections.at( replies.count() % _connections.count() )->submit( request ) );
+    }
+
+    // Decode the blocks in place as they arrive.
+    QVector<quint16> registers( quantity , 0 );
+    quint8 first = QAbstractModbus::Ok;
+    for ( int i = 0 ; i < replies.count() ; i++ )
+    {
+        Block &block = layout[i];
+        replies.at( i )->waitForFinished();
+        const QModbusResponse response = replies.at( i )->response();
+        const QModbusFrameView pdu = response.pdu();
+
+        // Function code, byte count and the registers.
+        block.status = response.status();
+        if ( block.status == QAbstractModbus::Ok &&
+             ( pdu.size() != 2 + 2 * block.quantity || pdu.at( 0 ) != functionCode ||
+               pdu.at( 1 ) != 2 * block.quantity ) )
+        {
+            block.status = QAbstractModbus::UnknownError;
+        }
+        if ( block.status == QAbstractModbus::Ok )
+        {
+            quint16 *const data = registers.data() + ( block.startingAddress - startingAddress );
+            for ( int j = 0 ; j < block.quantity ; j++ ) data[j] = pdu.value( 2 + 2 * j );
+        }
+        else if ( first == QAbstractModbus::Ok )
+        {
+            first = block.status;
+        }
+    }
+
+    if ( blocks ) *blocks = layout;
+    if ( status ) *status = first;
+    return registers;
+}
@@ -0,0 +1,390 @@
+/***********************************************************************************************************************
+* QModbusSubscriptionEngine implementation.                                                                           *
+***********************************************************************************************************************/
+#include <QModbusSubscriptionEngine>
+
+
+/*** System includes **************************************************************************************************/
+#include <algorithm>
+
+
+/*** Class implementation *********************************************************************************************/
+QModbusSubscriptionEngine::QModbusSubscriptionEngine( const QAbstractModbus &modbus , QObject *parent ) :
+    QObject( parent ) , _modbus( modbus ) , _capabilities( NULL ) , _nextId( 1 ) , _active( false )
+{
+    // The timer is restarted for the next due group after each tick.
+    _timer.setSingleShot( true );
+    QObject::connect( &_timer , SIGNAL( timeout() ) , this , SLOT( _timerExpired() ) );
+
+    _clock.start();
+}
+
+QModbusSubscriptionEngine::~QModbusSubscriptionEngine()
+{}
+
+int QModbusSubscriptionEngine::subscribe( const quint8 deviceAddress , const QAbstractModbus::Table table ,
+                                          const quint16 startingAddress , const quint16 quantity , const int period ,
+                                          QModbusListener *const listener )
+{
+    // Check the parameters. The range has to fit into a block of its group, which keeps its size once planned.
+    const quint64 key = _groupKey( deviceAddress , table , period );
+    const quint32 maximum = _groups.contains( key ) ? _groups.value( key ).maximum :
+                                                      _maximumBlockSize( deviceAddress , table );
+    if ( !listener || period <= 0 || quantity == 0 || quantity > maximum ||
+         (quint32)startingAddress + quantity > 0x10000 )
+    {
+        return -1;
+    }
+
+    // Register the subscription.
+    const int id = _nextId++;
+    Subscription subscription;
+    subscription.deviceAddress = deviceAddress;
+    subscription.table = table;
+    subscription.startingAddress = startingAddress;
+    subscription.quantity = quantity;
+    subscription.period = period;
+    subscription.listener = listener;
+    _subscriptions.insert( id , subscription );
+
+    // Add it to the plan, a new group is due immediately.
+    if ( !_groups.contains( key ) )
+    {
+        Group group;
+        group.nextDue = _clock.elapsed();
+        group.maximum = maximum;
+        _groups.insert( key , group );
+    }
+    _insert( _groups[key] , id );
+
+    _reschedule();
+    return id;
+}
+
+void QModbusSubscriptionEngine::unsubscribe( const int id )
+{
+    if ( !_subscriptions.contains( id ) ) return;
+    const Subscription subscription = _subscriptions.take( id );
+    _filters.remove( id );
+    const quint64 key = _groupKey( subscription.deviceAddress , subscription.table , subscription.period );
+    Group &group = _groups[key];
+
+    // The block covering the subscription starts at most one maximal block size before the subscription's end.
+    const quint32 end = (quint32)subscription.startingAddress + subscription.quantity;
+    const quint32 maximum = group.maximum;
+    QList<Block>::iterator i = std::lower_bound( group.blocks.begin() , group.blocks.end() ,
+                                                 end > maximum ? end - maximum : 0 , _startsBefore );
+    for ( ; i != group.blocks.end() && i->start <= subscription.startingAddress ; ++i )
+    {
+        if ( i->subscriptions.contains( id ) ) break;
+    }
+    if ( i == group.blocks.end() || i->start > subscription.startingAddress ) return;
+
+    // Take the block out of the index and put the remaining subscriptions back, only this block is re-planned.
+    Block block = *i;
+    group.blocks.erase( i );
+    block.subscriptions.removeOne( id );
+    foreach ( int other , block.subscriptions )
+    {
+        _insert( group , other );
+    }
+
+    if ( group.blocks.isEmpty() ) _groups.remove( key );
+    _reschedule();
+}
+
+bool QModbusSubscriptionEngine::setChangeFilter( const int id , const QModbusChangeFilter &filter )
+{
+    if ( !_subscriptions.contains( id ) ) return false;
+
+    // Start over with a fresh filter, so the next sample is reported completely.
+    QModbusChangeFilter fresh = filter;
+    fresh.reset();
+    _filters.insert( id , fresh );
+    return true;
+}
+
+void QModbusSubscriptionEngine::clearChangeFilter( const int id )
+{
+    _filters.remove( id );
+}
+
+void QModbusSubscriptionEngine::setCapabilities( QModbusCapabilityCache *const cache )
+{
+    _capabilities = cache;
+}
+
+QModbusCapabilityCache *QModbusSubscriptionEngine::capabilities( void ) const
+{
+    return _capabilities;
+}
+
+int QModbusSubscriptionEngine::subscriptionCount( void ) const
+{
+    return _subscriptions.count();
+}
+
+int QModbusSubscriptionEngine::blockCount( void ) const
+{
+    int count = 0;
+    for ( QHash<quint64,Group>::const_iterator i = _groups.constBegin() ; i != _groups.constEnd() ; ++i )
+    {
+        count += i.value().blocks.count();
+    }
+    return count;
+}
+
+void QModbusSubscriptionEngine::start( void )
+{
+    _active = true;
+    _reschedule();
+}
+
+void QModbusSubscriptionEngine::stop( void )
+{
+    _active = false;
+    _timer.stop();
+}
+
+bool QModbusSubscriptionEngine::isActive( void ) const
+{
+    return _active;
+}
+
+int QModbusSubscriptionEngine::processDue( void )
+{
+    const qint64 now = _clock.elapsed();
+
+    // Collect the due blocks of all periods per device and table (key bits 8..15: device, bits 0..7: table).
+    QHash<quint32,QList<Block> > due;
+    for ( QHash<quint64,Group>::iterator i = _groups.begin() ; i != _groups.end() ; ++i )
+    {
+        Group &group = i.value();
+        if ( group.nextDue > now ) continue;
+        due[(quint32)( i.key() >> 32 )] += group.blocks;
+
+        // Schedule the next poll, skip the cycles we could not keep up with.
+        const qint64 period = (quint32)i.key();
+        group.nextDue += period;
+        if ( group.nextDue <= now ) group.nextDue = now + period;
+    }
+
+    // Merge overlapping blocks of different periods and poll them.
+    int requests = 0;
+    for ( QHash<quint32,QList<Block> >::iterator i = due.begin() ; i != due.end() ; ++i )
+    {
+        const quint8 deviceAddress = i.key() >> 8;
+        const QAbstractModbus::Table table = (QAbstractModbus::Table)( i.key() & 0xFF );
+        const quint32 maximum = _maximumBlockSize( deviceAddress , table );
+        QList<Block> &blocks = i.value();
+        std::sort( blocks.begin() , blocks.end() , _lessThan );
+
+        Block merged = blocks.first();
+        for ( int j = 1 ; j < blocks.count() ; j++ )
+        {
+            const Block &block = blocks.at( j );
+            const quint32 end = qMax( merged.end , block.end );
+            if ( block.start <= merged.end && end - merged.start <= maximum )
+            {
+                merged.end = end;
+                merged.subscriptions += block.subscriptions;
+            }
+            else
+            {
+                _poll( deviceAddress , table , merged );
+                requests++;
+                merged = block;
+            }
+        }
+        _poll( deviceAddress , table , merged );
+        requests++;
+    }
+
+    return requests;
+}
+
+void QModbusSubscriptionEngine::_timerExpired( void )
+{
+    processDue();
+    _reschedule();
+}
+
+bool QModbusSubscriptionEngine::_startsBefore( const Block &block , const quint32 address )
+{
+    return block.start < address;
+}
+
+bool QModbusSubscriptionEngine::_lessThan( const Block &a , const Block &b )
+{
+    return a.start < b.start;
+}
+
+quint64 QModbusSubscriptionEngine::_groupKey( const quint8 deviceAddress , const QAbstractModbus::Table table ,
+                                              const int period )
+{
+    return ( (quint64)deviceAddress << 40 ) | ( (quint64)table << 32 ) | (quint32)period;
+}
+
+quint32 QModbusSubscriptionEngine::_maximumBlockSize( const quint8 deviceAddress ,
+                                                      const QAbstractModbus::Table table ) const
+{
+    // The tables are read using the function of the same code.
+    if ( _capabilities ) return _capabilities->maximumQuantity( deviceAddress , table );
+    return ( table == QAbstractModbus::Coils || table == QAbstractModbus::DiscreteInputs ) ? 2000 : 125;
+}
+
+void QModbusSubscriptionEngine::_insert( Group &group , const int id )
+{
+    const Subscription &subscription = _subscriptions[id];
+    const quint32 maximum = group.maximum;
+    const quint32 start = subscription.startingAddress;
+    const quint32 end = start + subscription.quantity;
+
+    // Blocks are never larger than the maximum, so only blocks starting in [start - maximum, end] can overlap or
+    // touch the new range.
+    QList<int> candidates;
+    quint32 unionStart = start , unionEnd = end;
+    int i = std::lower_bound( group.blocks.begin() , group.blocks.end() , start > maximum ? start - maximum : 0 ,
+                              _startsBefore ) - group.blocks.begin();
+    for ( ; i < group.blocks.count() && group.blocks.at( i ).start <= end ; i++ )
+    {
+        if ( group.blocks.at( i ).end < start ) continue;
+        candidates.append( i );
+        unionStart = qMin( unionStart , group.blocks.at( i ).start );
+        unionEnd = qMax( unionEnd , group.blocks.at( i ).end );
+    }
+
+    Block block;
+    block.start = start;
+    block.end = end;
+    block.subscriptions.append( id );
+
+    if ( unionEnd - unionStart <= maximum )
+    {
+        // Everything fits into one request, merge all candidates.
+        block.start = unionStart;
+        block.end = unionEnd;
+        for ( int j = candidates.count() - 1 ; j >= 0 ; j-- )
+        {
+            block.subscriptions += group.blocks.at( candidates.at( j ) ).subscriptions;
+            group.blocks.removeAt( candidates.at( j ) );
+        }
+    }
+    else
+    {
+        // Merge with the candidate resulting in the smallest block that still fits, if any.
+        int best = -1;
+        quint32 bestSize = maximum + 1;
+        foreach ( int candidate , candidates )
+        {
+            const Block &other = group.blocks.at( candidate );
+            const quint32 size = qMax( end , other.end ) - qMin( start , other.start );
+            if ( size < bestSize )
+            {
+                best = candidate;
+                bestSize = size;
+            }
+        }
+        if ( best >= 0 )
+        {
+            const Block other = group.blocks.takeAt( best );
+            block.start = qMin( start , other.start );
+            block.end = qMax( end , other.end );
+            block.subscriptions += other.subscriptions;
+        }
+    }
+
+    // Put the block at its place in the index.
+    group.blocks.insert( std::lower_bound( group.blocks.begin() , group.blocks.end() , block.start , _startsBefore ) ,
+                         block );
+}
+
+void QModbusSubscriptionEngine::_poll( const quint8 deviceAddress , const QAbstractModbus::Table table ,
+                                       const Block &block )
+{
+    quint8 status = QAbstractModbus::UnknownError;
+    const quint16 quantity = block.end - block.start;
+
+    if ( table == QAbstractModbus::Coils || table == QAbstractModbus::DiscreteInputs )
+    {
+        const QList<bool> values = table == QAbstractModbus::Coils ?
+                    _modbus.readCoils( deviceAddress , block.start , quantity , &status ) :
+                    _modbus.readDiscreteInputs( deviceAddress , block.start , quantity , &status );
+        if ( status == QAbstractModbus::Ok && values.count() != quantity ) status = QAbstractModbus::UnknownError;
+        const bool ok = status == QAbstractModbus::Ok;
+
+        // Fan out. A listener may unsubscribe others while we are notifying, so check each one.
+        foreach ( int id , block.subscriptions )
+        {
+            if ( !_subscriptions.contains( id ) ) continue;
+            const Subscription subscription = _subscriptions.value( id );
+            const QList<bool> slice = ok ? values.mid( subscription.startingAddress - block.start ,
+                                                       subscription.quantity ) : QList<bool>();
+
+            // Change-only subscriptions get successful samples only if something changed.
+            QHash<int,QModbusChangeFilter>::iterator filter = _filters.find( id );
+            if ( ok && filter != _filters.end() )
+            {
+                const QList<int> changed = filter.value().compare( slice );
+                if ( !changed.isEmpty() )
+                {
+                    subscription.listener->bitsChanged( id , subscription.startingAddress , slice , changed );
+                }
+            }
+            else
+            {
+                subscription.listener->bitsReceived( id , subscription.startingAddress , slice , status );
+            }
+        }
+    }
+    else
+    {
+        const QList<quint16> values = table == QAbstractModbus::HoldingRegisters ?
+                    _modbus.readHoldingRegisters( deviceAddress , block.start , quantity , &status ) :
+                    _modbus.readInputRegisters( deviceAddress , block.start , quantity , &status );
+        if ( status == QAbstractModbus::Ok && values.count() != quantity ) status = QAbstractModbus::UnknownError;
+        const bool ok = status == QAbstractModbus::Ok;
+
+        // Fan out. A listener may unsubscribe others while we are notifying, so check each one.
+        foreach ( int id , block.subscriptions )
+        {
+            if ( !_subscriptions.contains( id ) ) continue;
+            const Subscription subscription = _subscriptions.value( id );
+            const QList<quint16> slice = ok ? values.mid( subscription.startingAddress - block.start ,
+                                                          subscription.quantity ) : QList<quint16>();
+
+            // Change-only subscriptions get successful samples only if something changed.
+            QHash<int,QModbusChangeFilter>::iterator filter = _filters.find( id );
+            if ( ok && filter != _filters.end() )
+            {
+                const QList<int> changed = filter.value().compare( slice );
+                if ( !changed.isEmpty() )
+                {
+                    subscription.listener->registersChanged( id , subscription.startingAddress , slice , changed );
+                }
+            }
+            else
+            {
+                subscription.listener->registersReceived( id , subscription.startingAddress , slice , status );
+            }
+        }
+    }
+}
+
+void QModbusSubscriptionEngine::_reschedule( void )
+{
+    if ( !_active ) return;
+    if ( _groups.isEmpty() )
+    {
+        _timer.stop();
+        return;
+    }
+
+    // Wake up for the group due first.
+    qint64 next = _groups.constBegin().value().nextDue;
+    for ( QHash<quint64,Group>::const_iterator i = _groups.constBegin() ; i != _groups.constEnd() ; ++i )
+    {
+        next = qMin( next , i.value().nextDue );
+    }
+    _timer.start( (int)qMax( next - _clock.elapsed() , (qint64)0 ) );
+}
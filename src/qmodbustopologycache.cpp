@@ -0,0 +1,485 @@
+/***********************************************************************************************************************
+* QModbusTopologyCache implementation.                                                                                *
+***********************************************************************************************************************/
+#include <QModbusTopologyCache>
+
+
+/*** Qt includes ******************************************************************************************************/
+#include <QtCore/QDateTime>
+#include <QtCore/QElapsedTimer>
+
+
+/*** System includes **************************************************************************************************/
+#include <algorithm>
+#include <string.h>
+
+
+/*** Static members ***************************************************************************************************/
+const quint8 QModbusTopologyCache::_quantityFunctions[QuantityFunctions] =
+{
+    0x01 , 0x02 , 0x03 , 0x04 , 0x0F , 0x10 , 0x17 , 0x00
+};
+
+
+/*** Helpers **********************************************************************************************************/
+namespace
+{
+    // Orders endpoint records by name.
+    template< class Endpoint >
+    bool nameBefore( const Endpoint &endpoint , const QByteArray &name )
+    {
+        return qstrcmp( endpoint.name , name.constData() ) < 0;
+    }
+
+    // Orders unit records by verification time.
+    template< class Unit >
+    bool verifiedBefore( const Unit &a , const Unit &b )
+    {
+        return a.verified < b.verified;
+    }
+}
+
+
+/*** Class implementation *********************************************************************************************/
+QModbusTopologyCache::QModbusTopologyCache( void ) :
+    _content( NULL ) , _endpoints( NULL ) , _unitRecords( NULL ) , _endpointCount( 0 )
+{}
+
+QModbusTopologyCache::~QModbusTopologyCache()
+{
+    _unmap();
+}
+
+bool QModbusTopologyCache::load( const QString &fileName )
+{
+    QMutexLocker locker( &_mutex );
+    _changed.clear();
+    _removed.clear();
+    _unmap();
+    return _map( fileName );
+}
+
+bool QModbusTopologyCache::save( const QString &fileName )
+{
+    QMutexLocker locker( &_mutex );
+
+    // Collect all endpoints sorted by their UTF-8 names, the order the lookups binary search in.
+    QMap<QByteArray,QString> names;
+    for ( quint32 i = 0 ; i < _endpointCount ; i++ )
+    {
+        const QString name = QString::fromUtf8( _endpoints[i].name );
+        if ( !_removed.contains( name ) ) names.insert( _endpoints[i].name , name );
+    }
+    foreach ( const QString &name , _changed.keys() )
+    {
+        const QByteArray utf8 = name.toUtf8();
+        if ( utf8.size() < NameSize ) names.insert( utf8 , name );
+    }
+
+    // Build the records.
+    QList<Endpoint> endpoints;
+    QList<Unit> units;
+    for ( QMap<QByteArray,QString>::const_iterator i = names.constBegin() ; i != names.constEnd() ; ++i )
+    {
+        Endpoint endpoint;
+        memset( &endpoint , 0 , sizeof( endpoint ) );
+        qstrncpy( endpoint.name , i.key().constData() , NameSize );
+        const QByteArray address = ( _changed.contains( i.value() ) ? _changed.value( i.value() ).address :
+                                     QString::fromUtf8( _mapped( i.value() )->address ) ).toUtf8();
+        if ( address.size() < AddressSize )
+        {
+            qstrncpy( endpoint.address , address.constData() , AddressSize );
+            endpoint.resolved = _changed.contains( i.value() ) ? _changed.value( i.value() ).resolved :
+                                                                 _mapped( i.value() )->resolved;
+        }
+        const QList<Unit> endpointUnits = _units( i.value() );
+        endpoint.firstUnit = units.count();
+        endpoint.unitCount = endpointUnits.count();
+        endpoints.append( endpoint );
+        units += endpointUnits;
+    }
+
+    Header header;
+    memset( &header , 0 , sizeof( header ) );
+    header.magic = Magic;
+    header.version = Version;
+    header.byteOrder = ByteOrderMark;
+    header.endpointCount = endpoints.count();
+    header.endpointSize = sizeof( Endpoint );
+    header.unitCount = units.count();
+    header.unitSize = sizeof( Unit );
+
+    // Write the new file next to the old one, then replace the old one. The mapping has to go first on systems that
+    // do not allow replacing a mapped file.
+    const QString temporary = fileName + ".new";
+    QFile file( temporary );
+    bool ok = file.open( QIODevice::WriteOnly | QIODevice::Truncate );
+    ok = ok && file.write( (const char *)&header , sizeof( header ) ) == sizeof( header );
+    foreach ( const Endpoint &endpoint , endpoints )
+    {
+        ok = ok && file.write( (const char *)&endpoint , sizeof( endpoint ) ) == sizeof( endpoint );
+    }
+    foreach ( const Unit &unit , units )
+    {
+        ok = ok && file.write( (const char *)&unit , sizeof( unit ) ) == sizeof( unit );
+    }
+    ok = ok && file.flush();
+    file.close();
+    if ( !ok )
+    {
+        QFile::remove( temporary );
+        return false;
+    }
+
+    _unmap();
+    QFile::remove( fileName );
+    ok = QFile::rename( temporary , fileName );
+    _changed.clear();
+    _removed.clear();
+    _map( ok ? fileName : temporary );
+    return ok;
+}
+
+QStringList QModbusTopologyCache::endpoints( void ) const
+{
+    QMutexLocker locker( &_mutex );
+    QMap<QString,bool> names;
+    for ( quint32 i = 0 ; i < _endpointCount ; i++ )
+    {
+        const QString name = QString::fromUtf8( _endpoints[i].name );
+        if ( !_removed.contains( name ) ) names.insert( name , true );
+    }
+    foreach ( const QString &name , _changed.keys() )
+    {
+        names.insert( name , true );
+    }
+    return names.keys();
+}
+
+void QModbusTopologyCache::remove( const QString &endpoint )
+{
+    QMutexLocker locker( &_mutex );
+    _changed.remove( endpoint );
+    _removed.insert( endpoint );
+}
+
+QString QModbusTopologyCache::resolvedAddress( const QString &endpoint , qint64 *const resolved ) const
+{
+    QMutexLocker locker( &_mutex );
+    if ( _changed.contains( endpoint ) )
+    {
+        if ( resolved ) *resolved = _changed.value( endpoint ).resolved;
+        return _changed.value( endpoint ).address;
+    }
+
+    const Endpoint *const mapped = _mapped( endpoint );
+    if ( resolved ) *resolved = mapped ? mapped->resolved : 0;
+    return mapped ? QString::fromUtf8( mapped->address ) : QString();
+}
+
+void QModbusTopologyCache::setResolvedAddress( const QString &endpoint , const QString &address )
+{
+    QMutexLocker locker( &_mutex );
+    Entry &entry = _entry( endpoint );
+    entry.address = address;
+    entry.resolved = address.isEmpty() ? 0 : QDateTime::currentMSecsSinceEpoch();
+}
+
+QList<quint8> QModbusTopologyCache::reachableUnits( const QString &endpoint ) const
+{
+    QMutexLocker locker( &_mutex );
+    QList<quint8> list;
+    foreach ( const Unit &unit , _units( endpoint ) )
+    {
+        if ( unit.flags & Reachable ) list.append( unit.unitId );
+    }
+    return list;
+}
+
+bool QModbusTopologyCache::isReachable( const QString &endpoint , const quint8 unitId ) const
+{
+    QMutexLocker locker( &_mutex );
+    return _find( endpoint , unitId ).flags & Reachable;
+}
+
+void QModbusTopologyCache::setReachable( const QString &endpoint , const quint8 unitId , const bool reachable )
+{
+    QMutexLocker locker( &_mutex );
+    Entry &entry = _entry( endpoint );
+    if ( !entry.units.contains( unitId ) ) entry.units.insert( unitId , _unit( unitId ) );
+    Unit &unit = entry.units[unitId];
+    unit.flags = reachable ? unit.flags | Reachable : unit.flags & ~Reachable;
+    unit.verified = QDateTime::currentMSecsSinceEpoch();
+}
+
+int QModbusTopologyCache::roundTripTime( const QString &endpoint , const quint8 unitId ) const
+{
+    QMutexLocker locker( &_mutex );
+    return _find( endpoint , unitId ).roundTripTime;
+}
+
+void QModbusTopologyCache::addRoundTripTime( const QString &endpoint , const quint8 unitId , const int usecs )
+{
+    QMutexLocker locker( &_mutex );
+    Entry &entry = _entry( endpoint );
+    if ( !entry.units.contains( unitId ) ) entry.units.insert( unitId , _unit( unitId ) );
+    Unit &unit = entry.units[unitId];
+
+    // Exponential moving average over about eight samples.
+    const qint32 sample = qMax( 0 , usecs );
+    unit.roundTripTime = unit.roundTripTime < 0 ? sample : unit.roundTripTime + ( sample - unit.roundTripTime ) / 8;
+}
+
+qint64 QModbusTopologyCache::lastVerified( const QString &endpoint , const quint8 unitId ) const
+{
+    QMutexLocker locker( &_mutex );
+    return _find( endpoint , unitId ).verified;
+}
+
+QList<quint8> QModbusTopologyCache::staleUnits( const QString &endpoint , const qint64 maximumAge ) const
+{
+    QMutexLocker locker( &_mutex );
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    QList<Unit> stale;
+    foreach ( const Unit &unit , _units( endpoint ) )
+    {
+        if ( now - unit.verified >= maximumAge ) stale.append( unit );
+    }
+    std::stable_sort( stale.begin() , stale.end() , verifiedBefore<Unit> );
+
+    QList<quint8> list;
+    foreach ( const Unit &unit , stale )
+    {
+        list.append( unit.unitId );
+    }
+    return list;
+}
+
+void QModbusTopologyCache::restore( const QString &endpoint , QModbusCapabilityCache &cache ) const
+{
+    QMutexLocker locker( &_mutex );
+    foreach ( const Unit &unit , _units( endpoint ) )
+    {
+        for ( int function = 0 ; function < 8 * FunctionBytes ; function++ )
+        {
+            const quint8 bit = 1 << ( function & 7 );
+            if ( unit.supported[function >> 3] & bit )
+            {
+                cache.setSupport( unit.unitId , function , QModbusCapabilityCache::Supported );
+            }
+            else if ( unit.unsupported[function >> 3] & bit )
+            {
+                cache.setSupport( unit.unitId , function , QModbusCapabilityCache::Unsupported );
+            }
+        }
+
+        for ( int i = 0 ; i < QuantityFunctions ; i++ )
+        {
+            if ( unit.maximum[i] ) cache.setMaximumQuantity( unit.unitId , _quantityFunctions[i] , unit.maximum[i] );
+        }
+
+        for ( int table = 0 ; table < 4 ; table++ )
+        {
+            if ( !( unit.windows & ( 1 << table ) ) ) continue;
+            cache.setAddressWindow( unit.unitId , (QAbstractModbus::Table)( table + 1 ) , unit.window[2 * table] ,
+                                    unit.window[2 * table + 1] );
+        }
+    }
+}
+
+void QModbusTopologyCache::store( const QString &endpoint , const QModbusCapabilityCache &cache )
+{
+    QMutexLocker locker( &_mutex );
+    Entry &entry = _entry( endpoint );
+    foreach ( quint8 unitId , cache.devices() )
+    {
+        if ( !entry.units.contains( unitId ) ) entry.units.insert( unitId , _unit( unitId ) );
+        Unit &unit = entry.units[unitId];
+
+        memset( unit.supported , 0 , sizeof( unit.supported ) );
+        memset( unit.unsupported , 0 , sizeof( unit.unsupported ) );
+        for ( int function = 0 ; function < 8 * FunctionBytes ; function++ )
+        {
+            const quint8 bit = 1 << ( function & 7 );
+            const QModbusCapabilityCache::Support support = cache.support( unitId , function );
+            if ( support == QModbusCapabilityCache::Supported ) unit.supported[function >> 3] |= bit;
+            if ( support == QModbusCapabilityCache::Unsupported ) unit.unsupported[function >> 3] |= bit;
+        }
+
+        // A maximum equal to the modbus limit is not worth remembering.
+        for ( int i = 0 ; i < QuantityFunctions ; i++ )
+        {
+            const quint16 maximum = cache.maximumQuantity( unitId , _quantityFunctions[i] );
+            unit.maximum[i] = maximum != QModbusCapabilityCache::standardMaximumQuantity( _quantityFunctions[i] ) ?
+                              maximum : 0;
+        }
+
+        unit.windows = 0;
+        for ( int table = 0 ; table < 4 ; table++ )
+        {
+            if ( cache.addressWindow( unitId , (QAbstractModbus::Table)( table + 1 ) , &unit.window[2 * table] ,
+                                      &unit.window[2 * table + 1] ) )
+            {
+                unit.windows |= 1 << table;
+            }
+        }
+    }
+}
+
+int QModbusTopologyCache::revalidate( const QString &endpoint , const QAbstractModbus &modbus ,
+                                      const qint64 maximumAge , const int maximumUnits )
+{
+    // The lock is not held while waiting for the devices.
+    int verified = 0;
+    foreach ( quint8 unitId , staleUnits( endpoint , maximumAge ) )
+    {
+        if ( verified >= maximumUnits ) break;
+
+        // Read the first holding register of the unit's window, any reply shows that the unit is there.
+        quint16 address = 0;
+        {
+            QMutexLocker locker( &_mutex );
+            const Unit unit = _find( endpoint , unitId );
+            if ( unit.windows & ( 1 << ( QAbstractModbus::HoldingRegisters - 1 ) ) )
+            {
+                address = unit.window[2 * ( QAbstractModbus::HoldingRegisters - 1 )];
+            }
+        }
+
+        quint8 status = QAbstractModbus::UnknownError;
+        QElapsedTimer timer;
+        timer.start();
+        modbus.readHoldingRegisters( unitId , address , 1 , &status );
+        const int usecs = (int)qMin( timer.nsecsElapsed() / 1000 , (qint64)0x7FFFFFFF );
+        if ( status == QAbstractModbus::NoConnection ) break;
+
+        // Exceptions and corrupted replies come from the unit as well, only complete replies give a round trip time.
+        // The gateway exceptions tell that the unit behind the gateway did not answer.
+        const bool reachable = status < QAbstractModbus::GatewayPathUnavailable ||
+                               status == QAbstractModbus::CrcError;
+        setReachable( endpoint , unitId , reachable );
+        if ( status < QAbstractModbus::GatewayPathUnavailable ) addRoundTripTime( endpoint , unitId , usecs );
+        verified++;
+    }
+    return verified;
+}
+
+QModbusTopologyCache::Unit QModbusTopologyCache::_unit( const quint8 unitId )
+{
+    Unit unit;
+    memset( &unit , 0 , sizeof( unit ) );
+    unit.roundTripTime = -1;
+    unit.unitId = unitId;
+    return unit;
+}
+
+const QModbusTopologyCache::Endpoint *QModbusTopologyCache::_mapped( const QString &endpoint ) const
+{
+    if ( !_content || _removed.contains( endpoint ) ) return NULL;
+    const QByteArray name = endpoint.toUtf8();
+    const Endpoint *const end = _endpoints + _endpointCount;
+    const Endpoint *const found = std::lower_bound( _endpoints , end , name , nameBefore<Endpoint> );
+    return found != end && qstrcmp( found->name , name.constData() ) == 0 ? found : NULL;
+}
+
+QList<QModbusTopologyCache::Unit> QModbusTopologyCache::_units( const QString &endpoint ) const
+{
+    if ( _changed.contains( endpoint ) ) return _changed.value( endpoint ).units.values();
+
+    QList<Unit> list;
+    const Endpoint *const mapped = _mapped( endpoint );
+    for ( quint32 i = 0 ; mapped && i < mapped->unitCount ; i++ )
+    {
+        list.append( _unitRecords[mapped->firstUnit + i] );
+    }
+    return list;
+}
+
+QModbusTopologyCache::Unit QModbusTopologyCache::_find( const QString &endpoint , const quint8 unitId ) const
+{
+    if ( _changed.contains( endpoint ) ) return _changed.value( endpoint ).units.value( unitId , _unit( unitId ) );
+
+    // The units of an endpoint are sorted by ID.
+    const Endpoint *const mapped = _mapped( endpoint );
+    for ( quint32 i = 0 ; mapped && i < mapped->unitCount ; i++ )
+    {
+        const Unit &unit = _unitRecords[mapped->firstUnit + i];
+        if ( unit.unitId == unitId ) return unit;
+        if ( unit.unitId > unitId ) break;
+    }
+    return _unit( unitId );
+}
+
+QModbusTopologyCache::Entry &QModbusTopologyCache::_entry( const QString &endpoint )
+{
+    if ( !_changed.contains( endpoint ) )
+    {
+        // Copy the mapped records on the first change.
+        Entry entry;
+        const Endpoint *const mapped = _mapped( endpoint );
+        if ( mapped )
+        {
+            entry.address = QString::fromUtf8( mapped->address );
+            entry.resolved = mapped->resolved;
+        }
+        foreach ( const Unit &unit , _units( endpoint ) )
+        {
+            entry.units.insert( unit.unitId , unit );
+        }
+        _removed.remove( endpoint );
+        _changed.insert( endpoint , entry );
+    }
+    return _changed[endpoint];
+}
+
+bool QModbusTopologyCache::_map( const QString &fileName )
+{
+    _file.setFileName( fileName );
+    if ( !_file.open( QIODevice::ReadOnly ) ) return false;
+
+    // Check the header, the sizes and that the endpoints point to existing units.
+    const qint64 size = _file.size();
+    Header header;
+    bool ok = size >= (qint64)sizeof( Header ) && _file.read( (char *)&header , sizeof( header ) ) == sizeof( header );
+    ok = ok && header.magic == Magic && header.version == Version && header.byteOrder == ByteOrderMark &&
+         header.endpointSize == sizeof( Endpoint ) && header.unitSize == sizeof( Unit ) &&
+         size == (qint64)( sizeof( Header ) + (quint64)header.endpointCount * sizeof( Endpoint ) +
+                           (quint64)header.unitCount * sizeof( Unit ) );
+    uchar *const content = ok ? _file.map( 0 , size ) : NULL;
+    if ( !content )
+    {
+        _file.close();
+        return false;
+    }
+
+    const Endpoint *const endpoints = (const Endpoint *)( content + sizeof( Header ) );
+    for ( quint32 i = 0 ; ok && i < header.endpointCount ; i++ )
+    {
+        const Endpoint &endpoint = endpoints[i];
+        ok = memchr( endpoint.name , 0 , NameSize ) && memchr( endpoint.address , 0 , AddressSize ) &&
+             endpoint.firstUnit <= header.unitCount && endpoint.unitCount <= header.unitCount - endpoint.firstUnit &&
+             ( i == 0 || qstrcmp( endpoints[i - 1].name , endpoint.name ) < 0 );
+    }
+    if ( !ok )
+    {
+        _file.unmap( content );
+        _file.close();
+        return false;
+    }
+
+    _content = content;
+    _endpoints = endpoints;
+    _unitRecords = (const Unit *)( endpoints + header.endpointCount );
+    _endpointCount = header.endpointCount;
+    return true;
+}
+
+void QModbusTopologyCache::_unmap( void )
+{
+    if ( _content ) _file.unmap( _content );
+    _file.close();
+    _content = NULL;
+    _endpoints = NULL;
+    _unitRecords = NULL;
+    _endpointCount = 0;
+}
@@ -0,0 +1,130 @@
+/***********************************************************************************************************************
+* QModbusUnitScanner implementation.                                                                                  *
+***********************************************************************************************************************/
+#include <QModbusUnitScanner>
+
+
+/*** Qt includes ******************************************************************************************************/
+#include <QModbusRequest>
+#include <QtCore/QElapsedTimer>
+
+
+/*** Class implementation *********************************************************************************************/
+QModbusUnitScanner::QModbusUnitScanner( const QAbstractModbus &modbus , QObject *parent ) :
+    QObject( parent ) , _modbus( modbus ) , _baudRate( 0 ) , _bitsPerCharacter( 11 ) ,
+    _probeFunction( ReadHoldingRegister ) , _maximumAllowance( 50 ) , _allowance( 50 ) , _slowest( -1 ) , _cache( NULL )
+{}
+
+void QModbusUnitScanner::setSerialLine( const int baudRate , const int bitsPerCharacter )
+{
+    _baudRate = qMax( 0 , baudRate );
+    _bitsPerCharacter = qBound( 7 , bitsPerCharacter , 12 );
+}
+
+int QModbusUnitScanner::baudRate( void ) const
+{
+    return _baudRate;
+}
+
+QModbusUnitScanner::ProbeFunction QModbusUnitScanner::probeFunction( void ) const
+{
+    return _probeFunction;
+}
+
+void QModbusUnitScanner::setProbeFunction( const ProbeFunction function )
+{
+    _probeFunction = function;
+}
+
+int QModbusUnitScanner::responseAllowance( void ) const
+{
+    return _maximumAllowance;
+}
+
+void QModbusUnitScanner::setResponseAllowance( const int msecs )
+{
+    _maximumAllowance = qMax( (int)MinimumAllowance , msecs );
+    _allowance = _maximumAllowance;
+    _slowest = -1;
+}
+
+int QModbusUnitScanner::probeTimeout( void ) const
+{
+    // Request ADU: address, PDU and CRC.
+    const int requestSize = _probeFunction == ReportServerId ? 4 : 8;
+    return (int)( ( _wireTime( requestSize ) + 999 ) / 1000 ) + _allowance;
+}
+
+void QModbusUnitScanner::setTopologyCache( QModbusTopologyCache *const cache , const QString &endpoint )
+{
+    _cache = cache;
+    _endpoint = endpoint;
+}
+
+QList<quint8> QModbusUnitScanner::scan( const quint8 firstUnit , const quint8 lastUnit ,
+                                        const QModbusCancellationToken &token )
+{
+    QList<quint8> found;
+    const int first = qMax( 1 , (int)firstUnit );
+    const int last = qMin( 247 , (int)lastUnit );
+
+    // Every scan adapts anew, the units of another bus may be slower.
+    _allowance = _maximumAllowance;
+    _slowest = -1;
+
+    static const char reportServerId[] = { 0x11 };
+    const int requestSize = _probeFunction == ReportServerId ? 4 : 8;
+    for ( int unitId = first ; unitId <= last ; unitId++ )
+    {
+        QModbusRequest request = _probeFunction == ReportServerId ?
+            QModbusRequest( (quint8)unitId , QModbusFrameView( reportServerId , sizeof( reportServerId ) ) ) :
+            QModbusRequest::readHoldingRegisters( (quint8)unitId , 0 , 1 );
+        request.setDeadline( QModbusDeadline( probeTimeout() ) );
+        request.setCancellationToken( token );
+
+        QElapsedTimer timer;
+        timer.start();
+        const quint8 status = _modbus.execute( QList<QModbusRequest>() << request ).value( 0 ).status();
+        const qint64 usecs = timer.nsecsElapsed() / 1000;
+        if ( status == QAbstractModbus::NoConnection || status == QAbstractModbus::Cancelled ) break;
+
+        // Any exception but the gateway ones comes from the unit, a corrupted reply may come from two units sharing
+        // the ID.
+        const bool present = status < QAbstractModbus::GatewayPathUnavailable || status == QAbstractModbus::CrcError;
+        if ( _cache )
+        {
+            _cache->setReachable( _endpoint , (quint8)unitId , present );
+            if ( present && status != QAbstractModbus::CrcError )
+            {
+                _cache->addRoundTripTime( _endpoint , (quint8)unitId , (int)qMin( usecs , (qint64)0x7FFFFFFF ) );
+            }
+        }
+        if ( !present ) continue;
+
+        // The turnaround is the round trip time without the wire time of both frames. Exception replies are the
+        // shortest (5 bytes), assuming them overestimates the turnaround of longer replies, which is safe.
+        if ( status != QAbstractModbus::CrcError )
+        {
+            const qint64 turnaround = qMax( (qint64)0 , usecs - _wireTime( requestSize ) - _wireTime( 5 ) );
+            _slowest = qMax( _slowest , turnaround );
+            _allowance = (int)qBound( (qint64)MinimumAllowance , AllowanceFactor * _slowest / 1000 + MinimumAllowance ,
+                                      (qint64)_maximumAllowance );
+        }
+
+        found.append( (quint8)unitId );
+        emit unitFound( unitId , status , (int)qMin( usecs , (qint64)0x7FFFFFFF ) );
+    }
+
+    emit finished( found.size() );
+    return found;
+}
+
+qint64 QModbusUnitScanner::_wireTime( const int characters ) const
+{
+    if ( _baudRate <= 0 ) return 0;
+
+    // Above 19200 baud the specification fixes the silence to 1750 microseconds.
+    const qint64 character = (qint64)_bitsPerCharacter * 1000000 / _baudRate;
+    const qint64 silence = _baudRate > 19200 ? 1750 : character * 7 / 2;
+    return characters * character + silence;
+}
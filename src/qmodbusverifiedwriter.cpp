@@ -0,0 +1,77 @@
+/***********************************************************************************************************************
+* QModbusVerifiedWriter implementation.                                                                               *
+***********************************************************************************************************************/
+#include <QModbusVerifiedWriter>
+
+
+/*** Class implementation *********************************************************************************************/
+QModbusVerifiedWriter::QModbusVerifiedWriter( const QAbstractModbus &modbus , QModbusCapabilityCache *const cache ) :
+    _modbus( modbus ) , _cache( cache ? cache : &_ownCache )
+{}
+
+QModbusCapabilityCache &QModbusVerifiedWriter::capabilities( void ) const
+{
+    return *_cache;
+}
+
+bool QModbusVerifiedWriter::writeRegister( const quint8 deviceAddress , const quint16 registerAddress ,
+                                           const quint16 registerValue , quint8 *const status ) const
+{
+    QList<quint16> values;
+    values.append( registerValue );
+    return writeRegisters( deviceAddress , registerAddress , values , NULL , status );
+}
+
+bool QModbusVerifiedWriter::writeRegisters( const quint8 deviceAddress , const quint16 startingAddress ,
+                                            const QList<quint16> &registersValues ,
+                                            QList<quint16> *const readBack , quint8 *const status ) const
+{
+    const quint16 quantity = registersValues.count();
+    quint8 result = QAbstractModbus::UnknownError;
+    QList<quint16> values;
+    bool done = false;
+
+    // Check the parameters.
+    if ( quantity == 0 || quantity > 123 )
+    {
+        if ( status ) *status = QAbstractModbus::IllegalDataValue;
+        return false;
+    }
+
+    // Write and read back in one transaction if the device supports (or might support) function 0x17.
+    if ( quantity <= 121 && _cache->support( deviceAddress , 0x17 ) != QModbusCapabilityCache::Unsupported )
+    {
+        values = _modbus.writeReadMultipleRegisters( deviceAddress , startingAddress , registersValues ,
+                                                     startingAddress , quantity , &result );
+        _cache->record( deviceAddress , 0x17 , result );
+
+        // Any failure but an unsupported function is final, the write might have happened or not.
+        done = result != QAbstractModbus::IllegalFunction;
+    }
+
+    // Fall back to a write followed by a read.
+    if ( !done )
+    {
+        const bool written = quantity == 1 ?
+                    _modbus.writeSingleRegister( deviceAddress , startingAddress , registersValues.first() , &result ) :
+                    _modbus.writeMultipleRegisters( deviceAddress , startingAddress , registersValues , &result );
+        if ( written )
+        {
+            values = _modbus.readHoldingRegisters( deviceAddress , startingAddress , quantity , &result );
+        }
+        else if ( result == QAbstractModbus::Ok )
+        {
+            result = QAbstractModbus::UnknownError;
+        }
+    }
+
+    // Verify.
+    if ( result == QAbstractModbus::Ok && values != registersValues )
+    {
+        result = values.count() == quantity ? QAbstractModbus::VerificationFailed : QAbstractModbus::UnknownError;
+    }
+
+    if ( readBack ) *readBack = values;
+    if ( status ) *status = result;
+    return result == QAbstractModbus::Ok;
+}
@@ -0,0 +1,200 @@
+/***********************************************************************************************************************
+* QModbusWriteBehind implementation.                                                                                  *
+***********************************************************************************************************************/
+#include <QModbusWriteBehind>
+
+
+/*** Class implementation *********************************************************************************************/
+QModbusWriteBehind::QModbusWriteBehind( const QAbstractModbus &modbus , const int window , QObject *parent ) :
+    QObject( parent ) , _modbus( modbus )
+{
+    // The window starts with the first write after a flush.
+    _timer.setSingleShot( true );
+    _timer.setInterval( window );
+    QObject::connect( &_timer , SIGNAL( timeout() ) , this , SLOT( _timerExpired() ) );
+}
+
+QModbusWriteBehind::~QModbusWriteBehind()
+{
+    flush();
+}
+
+int QModbusWriteBehind::window( void ) const
+{
+    return _timer.interval();
+}
+
+void QModbusWriteBehind::setWindow( const int window )
+{
+    _timer.setInterval( window );
+}
+
+void QModbusWriteBehind::writeCoil( const quint8 deviceAddress , const quint16 outputAddress , const bool outputValue )
+{
+    _coils.insert( _key( deviceAddress , outputAddress ) , outputValue );
+    _arm();
+}
+
+void QModbusWriteBehind::writeCoils( const quint8 deviceAddress , const quint16 startingAddress ,
+                                     const QList<bool> &outputValues )
+{
+    for ( int i = 0 ; i < outputValues.count() && startingAddress + i <= 0xFFFF ; i++ )
+    {
+        _coils.insert( _key( deviceAddress , startingAddress + i ) , outputValues.at( i ) );
+    }
+    _arm();
+}
+
+void QModbusWriteBehind::writeRegister( const quint8 deviceAddress , const quint16 registerAddress ,
+                                        const quint16 registerValue )
+{
+    // A full write replaces any pending write or mask.
+    Register entry;
+    entry.full = true;
+    entry.value = registerValue;
+    entry.andMask = 0xFFFF;
+    entry.orMask = 0x0000;
+    _registers.insert( _key( deviceAddress , registerAddress ) , entry );
+    _arm();
+}
+
+void QModbusWriteBehind::writeRegisters( const quint8 deviceAddress , const quint16 startingAddress ,
+                                         const QList<quint16> &registersValues )
+{
+    for ( int i = 0 ; i < registersValues.count() && startingAddress + i <= 0xFFFF ; i++ )
+    {
+        writeRegister( deviceAddress , startingAddress + i , registersValues.at( i ) );
+    }
+}
+
+void QModbusWriteBehind::maskRegister( const quint8 deviceAddress , const quint16 referenceAddress ,
+                                       const quint16 andMask , const quint16 orMask )
+{
+    const quint32 key = _key( deviceAddress , referenceAddress );
+
+    if ( !_registers.contains( key ) )
+    {
+        Register entry;
+        entry.full = false;
+        entry.value = 0x0000;
+        entry.andMask = andMask;
+        entry.orMask = orMask;
+        _registers.insert( key , entry );
+    }
+    else
+    {
+        Register &entry = _registers[key];
+        if ( entry.full )
+        {
+            // Apply the mask to the pending value.
+            entry.value = ( entry.value & andMask ) | ( orMask & ~andMask );
+        }
+        else
+        {
+            // Compose both masks: ( ( c & A1 | O1 & ~A1 ) & A2 ) | O2 & ~A2 = c & A | O & ~A with A = A1 & A2 and
+            // O = ( O1 & ~A1 & A2 ) | ( O2 & ~A2 ).
+            entry.orMask = ( entry.orMask & ~entry.andMask & andMask ) | ( orMask & ~andMask );
+            entry.andMask &= andMask;
+        }
+    }
+
+    _arm();
+}
+
+int QModbusWriteBehind::pendingCount( void ) const
+{
+    return _coils.count() + _registers.count();
+}
+
+bool QModbusWriteBehind::flush( quint8 *const status )
+{
+    _timer.stop();
+    quint8 first = QAbstractModbus::Ok;
+
+    // Take the pending writes, so that writes queued by slots connected to writeFailed() go to the next flush.
+    const QMap<quint32,bool> coils = _coils;
+    const QMap<quint32,Register> registers = _registers;
+    _coils.clear();
+    _registers.clear();
+
+    // Coils, runs of contiguous addresses of the same device.
+    QMap<quint32,bool>::const_iterator coil = coils.constBegin();
+    while ( coil != coils.constEnd() )
+    {
+        const quint32 key = coil.key();
+        QList<bool> values;
+        do
+        {
+            values.append( coil.value() );
+            ++coil;
+        }
+        while ( coil != coils.constEnd() && coil.key() == key + values.count() &&
+                ( coil.key() >> 16 ) == ( key >> 16 ) && values.count() < 1968 );
+
+        quint8 result = QAbstractModbus::UnknownError;
+        const bool ok = values.count() == 1 ?
+                    _modbus.writeSingleCoil( key >> 16 , key & 0xFFFF , values.first() , &result ) :
+                    _modbus.writeMultipleCoils( key >> 16 , key & 0xFFFF , values , &result );
+        if ( !ok ) _fail( key , QAbstractModbus::Coils , values.count() , result , first );
+    }
+
+    // Registers, runs of contiguous full writes of the same device. Masks are sent one by one.
+    QMap<quint32,Register>::const_iterator reg = registers.constBegin();
+    while ( reg != registers.constEnd() )
+    {
+        const quint32 key = reg.key();
+        quint8 result = QAbstractModbus::UnknownError;
+
+        if ( !reg.value().full )
+        {
+            if ( !_modbus.maskWriteRegister( key >> 16 , key & 0xFFFF , reg.value().andMask , reg.value().orMask ,
+                                             &result ) )
+            {
+                _fail( key , QAbstractModbus::HoldingRegisters , 1 , result , first );
+            }
+            ++reg;
+            continue;
+        }
+
+        QList<quint16> values;
+        do
+        {
+            values.append( reg.value().value );
+            ++reg;
+        }
+        while ( reg != registers.constEnd() && reg.value().full && reg.key() == key + values.count() &&
+                ( reg.key() >> 16 ) == ( key >> 16 ) && values.count() < 123 );
+
+        const bool ok = values.count() == 1 ?
+                    _modbus.writeSingleRegister( key >> 16 , key & 0xFFFF , values.first() , &result ) :
+                    _modbus.writeMultipleRegisters( key >> 16 , key & 0xFFFF , values , &result );
+        if ( !ok ) _fail( key , QAbstractModbus::HoldingRegisters , values.count() , result , first );
+    }
+
+    if ( status ) *status = first;
+    return first == QAbstractModbus::Ok;
+}
+
+void QModbusWriteBehind::_timerExpired( void )
+{
+    flush();
+}
+
+quint32 QModbusWriteBehind::_key( const quint8 deviceAddress , const quint16 address )
+{
+    return ( (quint32)deviceAddress << 16 ) | address;
+}
+
+void QModbusWriteBehind::_arm( void )
+{
+    if ( !_timer.isActive() ) _timer.start();
+}
+
+void QModbusWriteBehind::_fail( const quint32 key , const QAbstractModbus::Table table , const int quantity ,
+                                const quint8 status , quint8 &first )
+{
+    // A failed call that did not report anything is still a failure.
+    const quint8 result = status == QAbstractModbus::Ok ? (quint8)QAbstractModbus::UnknownError : status;
+    if ( first == QAbstractModbus::Ok ) first = result;
+    emit writeFailed( key >> 16 , table , key & 0xFFFF , quantity , result );
+}
@@ -5,8 +5,8 @@
 
 
 /*** Qt includes ******************************************************************************************************/
-#include <QtCore/QDataStream>
-#include <QtEndian>
+#include <QModbusRequestCore>
+#include <QtCore/QElapsedTimer>
 
 
 /*** System includes **************************************************************************************************/
@@ -17,6 +17,7 @@
 
 # /***/ ifdef Q_OS_UNIX /**********************************************************************************************/
 #include <sys/ioctl.h>
+#include <poll.h>
 
 # /***/ ifndef Q_OS_MACX /*********************************************************************************************/
 #include <linux/serial.h>
@@ -33,43 +34,91 @@ inline void setRts( QFile & f , bool active )
 #   define _readAll             _commPort.readAll
 #   define _readLine            _commPort.readLine
 
-# /***/ ifndef Q_OS_MACX /*********************************************************************************************/
-#   define _write( data )    do {                                                                                   \
-                                    if ( _rtsDriveMode == RtsSoftwareActiveOnTx ||                                  \
-                                         _rtsDriveMode == RtsSoftwareActiveOnRx )                                   \
-                                        setRts( _commPort , _rtsDriveMode == RtsSoftwareActiveOnTx );               \
-                                    _commPort.write( (data) );                                                      \
-                                    if ( _rtsDriveMode == RtsSoftwareActiveOnTx ||                                  \
-                                         _rtsDriveMode == RtsSoftwareActiveOnRx )                                   \
-                                    {                                                                               \
-                                        unsigned int lsr;                                                           \
-                                        do {                                                                        \
-                                            ioctl( _commPort.handle() , TIOCSERGETLSR , &lsr );                     \
-                                        } while ( ( lsr & TIOCSER_TEMT ) == 0 );                                    \
-                                        setRts( _commPort , _rtsDriveMode == RtsSoftwareActiveOnRx );               \
-                                    }                                                                               \
-                                } while( 0 )
-# /***/ else /*********************************************************************************************************/
-#   define _write( data )    do {                                                                                   \
-                                    if ( _rtsDriveMode == RtsSoftwareActiveOnTx ||                                  \
-                                         _rtsDriveMode == RtsSoftwareActiveOnRx )                                   \
-                                        setRts( _commPort , _rtsDriveMode == RtsSoftwareActiveOnTx );               \
-                                    _commPort.write( (data) );                                                      \
-                                    if ( _rtsDriveMode == RtsSoftwareActiveOnTx ||                                  \
-                                         _rtsDriveMode == RtsSoftwareActiveOnRx )                                   \
-                                    {                                                                               \
-                                        tcdrain( _commPort.handle() );                                              \
-                                    }                                                                               \
-                                } while( 0 )
-# /***/ endif  /*******************************************************************************************************/
-
 # /***/ endif /* Q_OS_UNIX ********************************************************************************************/
 
 
+/*** Request core *****************************************************************************************************/
+// I/O policy of the request core, uses the serial port of the transport.
+class QRtuModbusIo
+{
+public:
+    explicit QRtuModbusIo( const QRtuModbus &modbus ) :
+        _modbus( modbus ) , _token( QModbusCancellationToken::none() ) {}
+    bool isOpen( void ) const { return _modbus.isOpen(); }
+    void discard( void ) const { _modbus._discard(); }
+
+    void limit( const QModbusDeadline &deadline , const QModbusCancellationToken &token ) const
+    {
+        _deadline = deadline;
+        _token = token;
+    }
+
+    int read( char *const data , const int size ) const
+    {
+        if ( !_modbus._waitForData( _deadline , _token ) ) return 0;
+        return qMax( 0 , (int)_modbus._read( data , size ) );
+    }
+
+    int readAll( char *const data , const int maxSize ) const { return read( data , maxSize ); }
+    int readLine( char *const data , const int maxSize ) const
+    {
+        return qMax( 0 , (int)_modbus._readLine( data , maxSize ) );
+    }
+    bool write( const char *const data , const int size ) const { return _modbus._write( data , size ); }
+
+private:
+    const QRtuModbus &_modbus;
+    mutable QModbusDeadline _deadline;          // Limits of the current request (see limit()).
+    mutable QModbusCancellationToken _token;
+};
+
+typedef QModbusRequestCore<QModbusRtuFraming,QRtuModbusIo> QRtuModbusCore;
+
+static inline QRtuModbusCore core( const QRtuModbus &modbus )
+{
+    return QRtuModbusCore( QRtuModbusIo( modbus ) );
+}
+
+
 /*** Abstract interface class destructor implementation ***************************************************************/
 QAbstractModbus::~QAbstractModbus()
 {}
 
+bool QAbstractModbus::executePdu( const quint8 deviceAddress , const QModbusFrameView &request ,
+                                  QModbusPduFrame &response , quint8 *const status ) const
+{
+    quint8 result = IllegalDataValue;
+    response.clear();
+    if ( !request.isEmpty() && request.size() <= QModbusPdu::MaxSize )
+    {
+        // The function code is passed on its own, the response data comes back without it.
+        QByteArray data( request.data() + 1 , request.size() - 1 );
+        result = UnknownError;
+        const QByteArray reply = executeCustomFunction( deviceAddress , request.at( 0 ) , data , &result );
+        if ( result == Ok && ( !response.append( (char)request.at( 0 ) ) ||
+                               !response.append( reply.constData() , reply.size() ) ) ) result = UnknownError;
+    }
+    if ( status ) *status = result;
+    return result == Ok;
+}
+
+QList<QModbusResponse> QAbstractModbus::execute( const QList<QModbusRequest> &batch ) const
+{
+    QList<QModbusResponse> responses;
+    foreach ( const QModbusRequest &request , batch )
+    {
+        QModbusPduFrame response;
+        quint8 status = request.limitStatus();
+        if ( status == Ok )
+        {
+            status = IllegalDataValue;
+            executePdu( request.deviceAddress() , request.pdu() , response , &status );
+        }
+        responses.append( QModbusResponse( status , response.view() ) );
+    }
+    return responses;
+}
+
 
 /*** Class implementation *********************************************************************************************/
 QRtuModbus::QRtuModbus() : _timeout( 500 ) , _rtsDriveMode( RtsNotDriven )
@@ -402,1242 +451,289 @@ void QRtuModbus::setTimeout( const unsigned int timeout )
 QList<bool> QRtuModbus::readCoils( const quint8 deviceAddress , const quint16 startingAddress ,
                                     const quint16 quantityOfCoils , quint8 *const status ) const
 {
-    // Are we connected ?
-    if ( !isOpen() )
-    {
-        if ( status ) *status = NoConnection;
-        return QList<bool>();
-    }
+    return core( *this ).readBits( deviceAddress , 0x01 , startingAddress , quantityOfCoils , status );
+}
 
-    // Create modbus read coil status pdu (Modbus uses Big Endian).
-    QByteArray pdu;
-    QDataStream pduStream( &pdu , QIODevice::WriteOnly );
-    pduStream.setByteOrder( QDataStream::BigEndian );
-    pduStream << deviceAddress << (quint8)0x01 << startingAddress << quantityOfCoils;
+QList<bool> QRtuModbus::readDiscreteInputs( const quint8 deviceAddress , const quint16 startingAddress ,
+                                             const quint16 quantityOfInputs , quint8 *const status ) const
+{
+    return core( *this ).readBits( deviceAddress , 0x02 , startingAddress , quantityOfInputs , status );
+}
 
-    // Calculate CRC and add it to the PDU.
-    quint16 crc = _calculateCrc( pdu );
-    pduStream.writeRawData( (const char *)&crc , sizeof( crc ) );
+QList<quint16> QRtuModbus::readHoldingRegisters( const quint8 deviceAddress , const quint16 startingAddress ,
+                                                  const quint16 quantityOfRegisters , quint8 *const status ) const
+{
+    return core( *this ).readRegisters( deviceAddress , 0x03 , startingAddress , quantityOfRegisters , status );
+}
 
-    // Clear the RX buffer before making the request.
-    _readAll();
+QList<quint16> QRtuModbus::readInputRegisters( const quint8 deviceAddress , const quint16 startingAddress ,
+                                                const quint16 quantityOfInputRegisters , quint8 *const status ) const
+{
+    return core( *this ).readRegisters( deviceAddress , 0x04 , startingAddress , quantityOfInputRegisters , status );
+}
 
-    // Send the pdu.
-    _write( pdu );
+bool QRtuModbus::writeSingleCoil( const quint8 deviceAddress , const quint16 outputAddress ,
+                                   const bool outputValue , quint8 *const status ) const
+{
+    return core( *this ).writeSingleCoil( deviceAddress , outputAddress , outputValue , status );
+}
 
-    // Await response.
-    quint16 neededRxBytes = quantityOfCoils / 8;
-    if ( quantityOfCoils % 8 ) neededRxBytes++;
-    pdu.clear();
+bool QRtuModbus::writeSingleRegister( const quint8 deviceAddress , const quint16 outputAddress ,
+                                       const quint16 registerValue , quint8 *const status ) const
+{
+    return core( *this ).writeSingleRegister( deviceAddress , outputAddress , registerValue , status );
+}
 
-    // Even on error we have at least 5 bytes to read.
-    pdu = _read( 5 );
+bool QRtuModbus::writeMultipleCoils( const quint8 deviceAddress , const quint16 startingAddress ,
+                                      const QList<bool> & outputValues , quint8 *const status ) const
+{
+    return core( *this ).writeMultipleCoils( deviceAddress , startingAddress , outputValues , status );
+}
 
-    // Handle timeout.
-    if ( pdu.size() < 5 )
-    {
-        if ( status ) *status = Timeout;
-        return QList<bool>();
-    }
+bool QRtuModbus::writeMultipleRegisters( const quint8 deviceAddress , const quint16 startingAddress ,
+                                          const QList<quint16> & registersValues , quint8 *const status ) const
+{
+    return core( *this ).writeMultipleRegisters( deviceAddress , startingAddress , registersValues , status );
+}
 
-    // Was it a Modbus error?
-    if ( pdu[1] & 0x80 )
-    {
-        if ( !_checkCrc( pdu ) )
-        {
-            if ( status ) *status = CrcError;
-        }
-        else
-        {
-            if ( status ) *status = pdu[2];
-        }
-        return QList<bool>();
-    }
+bool QRtuModbus::maskWriteRegister( const quint8 deviceAddress , const quint16 referenceAddress ,
+                                     const quint16 andMask , const quint16 orMask , quint8 *const status ) const
+{
+    return core( *this ).maskWriteRegister( deviceAddress , referenceAddress , andMask , orMask , status );
+}
 
-    // Receive the rest.
-    pdu += _read( neededRxBytes );
+QList<quint16> QRtuModbus::writeReadMultipleRegisters( const quint8 deviceAddress ,
+                                                        const quint16 writeStartingAddress ,
+                                                        const QList<quint16> & writeValues ,
+                                                        const quint16 readStartingAddress ,
+                                                        const quint16 quantityToRead , quint8 *const status) const
+{
+    return core( *this ).writeReadMultipleRegisters( deviceAddress , writeStartingAddress , writeValues ,
+                                                     readStartingAddress , quantityToRead , status );
+}
 
-    // Check CRC.
-    if ( !_checkCrc( pdu ) )
-    {
-        if ( status ) *status = CrcError;
-        return QList<bool>();
-    }
+QList<quint16> QRtuModbus::readFifoQueue( const quint8 deviceAddress , const quint16 fifoPointerAddress ,
+                                           quint8 *const status ) const
+{
+    return core( *this ).readFifoQueue( deviceAddress , fifoPointerAddress , status );
+}
 
-    // Check data and return them on success.
-    if ( pdu.size() == neededRxBytes + 5 )
-    {
-        // Read device address and command ID and control them.
-        quint8 rxDeviceAddress , rxFunctionCode , byteCount;
-        QDataStream rxStream( pdu );
-        rxStream.setByteOrder( QDataStream::BigEndian );
-        rxStream >> rxDeviceAddress >> rxFunctionCode >> byteCount;
+QByteArray QRtuModbus::executeCustomFunction( const quint8 deviceAddress , const quint8 modbusFunction ,
+                                               QByteArray &data , quint8 *const status ) const
+{
+    return core( *this ).executeCustomFunction( deviceAddress , modbusFunction , data , status );
+}
 
-        if ( rxDeviceAddress == deviceAddress && rxFunctionCode == 0x01 && byteCount == neededRxBytes )
-        {
-            // It is ok, read and convert the data.
-            QList<bool> list;
-            quint8 tmp;
-            for ( int i = 0 ; i < quantityOfCoils ; i++ )
-            {
-                if ( i % 8 == 0 ) rxStream >> tmp;
-                list.append( tmp & ( 0x01 << ( i % 8 ) ) );
-            }
-            if ( status ) *status = Ok;
-            return list;
-        }
-    }
+bool QRtuModbus::executePdu( const quint8 deviceAddress , const QModbusFrameView &request , QModbusPduFrame &response ,
+                             quint8 *const status ) const
+{
+    return core( *this ).executePdu( deviceAddress , request , response , status );
+}
 
-    // If we arrive here, something went wrong.
-    if ( status ) *status = UnknownError;
-    return QList<bool>();
+QList<QModbusResponse> QRtuModbus::execute( const QList<QModbusRequest> &batch ) const
+{
+    return core( *this ).execute( batch );
 }
 
-QList<bool> QRtuModbus::readDiscreteInputs( const quint8 deviceAddress , const quint16 startingAddress ,
-                                             const quint16 quantityOfInputs , quint8 *const status ) const
+QByteArray QRtuModbus::executeRaw( QByteArray &data , quint8 *const status ) const
 {
+    QByteArray response;
+
     // Are we connected ?
     if ( !isOpen() )
     {
         if ( status ) *status = NoConnection;
-        return QList<bool>();
+        return QByteArray();
     }
 
-    // Create modbus read coil status pdu (Modbus uses Big Endian).
-    QByteArray pdu;
-    QDataStream pduStream( &pdu , QIODevice::WriteOnly );
-    pduStream.setByteOrder( QDataStream::BigEndian );
-    pduStream << deviceAddress << (quint8)0x02 << startingAddress << quantityOfInputs;
-
-    // Calculate CRC and add it to the PDU.
-    quint16 crc = _calculateCrc( pdu );
-    pduStream.writeRawData( (const char *)&crc , sizeof( crc ) );
-
     // Clear the RX buffer before making the request.
     _readAll();
 
-    // Send the pdu.
-    _write( pdu );
+    // Send the data.
+    _write( data.constData() , data.size() );
 
     // Await response.
-    quint16 neededRxBytes = quantityOfInputs / 8;
-    if ( quantityOfInputs % 8 ) neededRxBytes++;
-    pdu.clear();
-
     // Even on error we have at least 5 bytes to read.
-    pdu = _read( 5 );
+    response = _readAll();
 
     // Handle timeout.
-    if ( pdu.size() < 5 )
+    if ( response.size() == 0 )
     {
         if ( status ) *status = Timeout;
-        return QList<bool>();
-    }
-
-    // Was it a Modbus error?
-    if ( pdu[1] & 0x80 )
-    {
-        if ( !_checkCrc( pdu ) )
-        {
-            if ( status ) *status = CrcError;
-        }
-        else
-        {
-            if ( status ) *status = pdu[2];
-        }
-        return QList<bool>();
-    }
-
-    // Receive the rest of the message.
-    pdu += _read( neededRxBytes );
-
-    // Check CRC.
-    if ( !_checkCrc( pdu ) )
-    {
-        if ( status ) *status = CrcError;
-        return QList<bool>();
-    }
-
-    // Check data and return them on success.
-    if ( pdu.size() == neededRxBytes + 5 )
-    {
-        // Read device address and command ID and control them.
-        quint8 rxDeviceAddress , rxFunctionCode , byteCount;
-        QDataStream rxStream( pdu );
-        rxStream.setByteOrder( QDataStream::BigEndian );
-        rxStream >> rxDeviceAddress >> rxFunctionCode >> byteCount;
-
-        if ( rxDeviceAddress == deviceAddress && rxFunctionCode == 0x02 && byteCount == neededRxBytes )
-        {
-            // It is ok, read and convert the data.
-            QList<bool> list;
-            quint8 tmp;
-            for ( int i = 0 ; i < quantityOfInputs ; i++ )
-            {
-                if ( i % 8 == 0 ) rxStream >> tmp;
-                list.append( tmp & ( 0x01 << ( i % 8 ) ) );
-            }
-            if ( status ) *status = Ok;
-            return list;
-        }
+        return QByteArray();
     }
 
-    // If we arrive here, something went wrong.
-    if ( status ) *status = UnknownError;
-    return QList<bool>();
+    return response;
 }
 
-QList<quint16> QRtuModbus::readHoldingRegisters( const quint8 deviceAddress , const quint16 startingAddress ,
-                                                  const quint16 quantityOfRegisters , quint8 *const status ) const
+QByteArray QRtuModbus::calculateCheckSum( QByteArray &data ) const
 {
-    // Are we connected ?
-    if ( !isOpen() )
-    {
-        if ( status ) *status = NoConnection;
-        return QList<quint16>();
-    }
+    const quint16 crc = QModbusRtuFraming::crc( data.constData() , data.size() );
+    QByteArray checkSum;
+    checkSum.append( (char)( crc & 0xFF ) );
+    checkSum.append( (char)( crc >> 8 ) );
+    return checkSum;
+}
 
-    // Create modbus read holding registers pdu (Modbus uses Big Endian).
-    QByteArray pdu;
-    QDataStream pduStream( &pdu , QIODevice::WriteOnly );
-    pduStream.setByteOrder( QDataStream::BigEndian );
-    pduStream << deviceAddress << (quint8)0x03 << startingAddress << quantityOfRegisters;
 
-    // Calculate CRC and add it to the PDU.
-    quint16 crc = _calculateCrc( pdu );
-    pduStream.writeRawData( (const char *)&crc , sizeof( crc ) );
+# /***/ ifdef Q_OS_UNIX /**********************************************************************************************/
 
-    // Clear the RX buffer before making the request.
-    _readAll();
+void QRtuModbus::_discard( void ) const
+{
+    // A read would wait VTIME for data that may never come.
+    ::tcflush( _commPort.handle() , TCIFLUSH );
+}
 
-    // Send the pdu.
-    _write( pdu );
+bool QRtuModbus::_write( const char *const data , const qint64 size ) const
+{
+    const bool software = _rtsDriveMode == RtsSoftwareActiveOnTx || _rtsDriveMode == RtsSoftwareActiveOnRx;
 
-    // Await response.
-    quint16 neededRxBytes = quantityOfRegisters * 2;
-    pdu.clear();
+    // Drive RTS for transmission if done in software.
+    if ( software ) setRts( _commPort , _rtsDriveMode == RtsSoftwareActiveOnTx );
 
-    // Even on error we have at least 5 bytes to read.
-    pdu = _read( 5 );
+    const bool written = _commPort.write( data , size ) == size;
 
-    // Handle timeout.
-    if ( pdu.size() < 5 )
+    // Wait until the data has left the UART, then drive RTS for reception.
+    if ( software )
     {
-        if ( status ) *status = Timeout;
-        return QList<quint16>();
-    }
 
-    // Was it a Modbus error?
-    if ( pdu[1] & 0x80 )
-    {
-        if ( !_checkCrc( pdu ) )
-        {
-            if ( status ) *status = CrcError;
-        }
-        else
-        {
-            if ( status ) *status = pdu[2];
-        }
-        return QList<quint16>();
-    }
+# /***/ ifndef Q_OS_MACX /*********************************************************************************************/
 
-    // Receive the rest of the message.
-    pdu += _read( neededRxBytes );
+        unsigned int lsr;
+        do {
+            ioctl( _commPort.handle() , TIOCSERGETLSR , &lsr );
+        } while ( ( lsr & TIOCSER_TEMT ) == 0 );
+        setRts( _commPort , _rtsDriveMode == RtsSoftwareActiveOnRx );
 
-    // Check CRC.
-    if ( !_checkCrc( pdu ) )
-    {
-        if ( status ) *status = CrcError;
-        return QList<quint16>();
-    }
+# /***/ else /*********************************************************************************************************/
 
-    // Check data and return them on success.
-    if ( pdu.size() == neededRxBytes + 5 )
-    {
-        // Read device address and command ID and control them.
-        quint8 rxDeviceAddress , rxFunctionCode , byteCount;
-        QDataStream rxStream( pdu );
-        rxStream.setByteOrder( QDataStream::BigEndian );
-        rxStream >> rxDeviceAddress >> rxFunctionCode >> byteCount;
+        tcdrain( _commPort.handle() );
+
+# /***/ endif /* Q_OS_MACX ********************************************************************************************/
 
-        if ( rxDeviceAddress == deviceAddress && rxFunctionCode == 0x03 && byteCount == neededRxBytes )
-        {
-            // It is ok, read and convert the data.
-            QList<quint16> list;
-            quint16 tmp;
-            for ( int i = 0 ; i < quantityOfRegisters ; i++ )
-            {
-                rxStream >> tmp;
-                list.append( tmp );
-            }
-            if ( status ) *status = Ok;
-            return list;
-        }
     }
 
-    // If we arrive here, something went wrong.
-    if ( status ) *status = UnknownError;
-    return QList<quint16>();
+    return written;
 }
 
-QList<quint16> QRtuModbus::readInputRegisters( const quint8 deviceAddress , const quint16 startingAddress ,
-                                                const quint16 quantityOfInputRegisters , quint8 *const status ) const
+bool QRtuModbus::_waitForData( const QModbusDeadline &deadline , const QModbusCancellationToken &token ) const
 {
-    // Are we connected ?
-    if ( !isOpen() )
+    if ( deadline.isNever() && !token.isCancellable() ) return true;
+
+    // Poll in steps, so a cancellation is noticed in time. The read afterwards waits for the rest (VTIME).
+    struct pollfd port = { _commPort.handle() , POLLIN , 0 };
+    QElapsedTimer elapsed;
+    elapsed.start();
+    for ( ;; )
     {
-        if ( status ) *status = NoConnection;
-        return QList<quint16>();
-    }
+        const int left = (int)( _timeout - elapsed.elapsed() );
+        if ( left <= 0 || token.isCancelled() || deadline.hasExpired() ) return false;
 
-    // Create modbus read input status pdu (Modbus uses Big Endian).
-    QByteArray pdu;
-    QDataStream pduStream( &pdu , QIODevice::WriteOnly );
-    pduStream.setByteOrder( QDataStream::BigEndian );
-    pduStream << deviceAddress << (quint8)0x04 << startingAddress << quantityOfInputRegisters;
+        int wait = deadline.remaining( left );
+        if ( token.isCancellable() ) wait = qMin( wait , (int)QModbusCancellationToken::PollInterval );
+        if ( ::poll( &port , 1 , wait ) > 0 ) return true;
+    }
+}
 
-    // Calculate CRC and add it to the PDU.
-    quint16 crc = _calculateCrc( pdu );
-    pduStream.writeRawData( (const char *)&crc , sizeof( crc ) );
+# /***/ endif /* Q_OS_UNIX ********************************************************************************************/
 
-    // Clear the RX buffer before making the request.
-    _readAll();
 
-    // Send the pdu.
-    _write( pdu );
+# /***/ ifdef Q_OS_WIN /***********************************************************************************************/
+#include <QtDebug>
+QByteArray QRtuModbus::_read( const int numberBytes ) const
+{
+    QByteArray data( numberBytes , 0 );
+    data.resize( _read( data.data() , numberBytes ) );
+    return data;
+}
 
-    // Await response.
-    quint16 neededRxBytes = quantityOfInputRegisters * 2;
-    pdu.clear();
+qint64 QRtuModbus::_read( char *const data , const qint64 maxSize ) const
+{
+    DWORD size = 0;
 
-    // Even on error we have at least 5 bytes to read.
-    pdu = _read( 5 );
+    if ( maxSize == 0 ) return 0;
 
-    // Handle timeout.
-    if ( pdu.size() < 5 )
+    if ( ReadFile( _commPort , data , maxSize , &size , NULL ) )
     {
-        if ( status ) *status = Timeout;
-        return QList<quint16>();
+        return size;
     }
+    return 0;
+}
 
-    // Was it a Modbus error?
-    if ( pdu[1] & 0x80 )
+QByteArray QRtuModbus::_readAll( void ) const
+{
+    QByteArray data( 1024 , 0 );
+    DWORD size = 0;
+    if ( ReadFile( _commPort , data.data() , 1024 , &size , NULL ) )
     {
-        if ( !_checkCrc( pdu ) )
-        {
-            if ( status ) *status = CrcError;
-        }
-        else
-        {
-            if ( status ) *status = pdu[2];
-        }
-        return QList<quint16>();
+        data.resize( size );
     }
-
-    // Receive the rest of the message.
-    pdu += _read( neededRxBytes );
-
-    // Check CRC.
-    if ( !_checkCrc( pdu ) )
+    else
     {
-        if ( status ) *status = CrcError;
-        return QList<quint16>();
+        data.resize( 0 );
     }
 
-    // Check data and return them on success.
-    if ( pdu.size() == neededRxBytes + 5 )
-    {
-        // Read TCP fields and, device address and command ID and control them.
-        quint8 rxDeviceAddress , rxFunctionCode , byteCount;
-        QDataStream rxStream( pdu );
-        rxStream.setByteOrder( QDataStream::BigEndian );
-        rxStream >> rxDeviceAddress >> rxFunctionCode >> byteCount;
+    return data;
+}
+
+QByteArray QRtuModbus::_readLine( int maxBytes ) const
+{
+    QByteArray data;
+    DWORD size = 0;
+
+    if ( maxBytes == 0 ) return data;
 
-        if ( rxDeviceAddress == deviceAddress && rxFunctionCode == 0x04 && byteCount == neededRxBytes )
+    while( !data.endsWith( '\n' ) && --maxBytes )
+    {
+        unsigned char c;
+        if ( ReadFile( _commPort , &c , 1 , &size , NULL ) )
         {
-            // It is ok, read and convert the data.
-            QList<quint16> list;
-            quint16 tmp;
-            for ( int i = 0 ; i < quantityOfInputRegisters ; i++ )
-            {
-                rxStream >> tmp;
-                list.append( tmp );
-            }
-            if ( status ) *status = Ok;
-            return list;
+           data.append( c );
         }
     }
 
-    // If we arrive here, something went wrong.
-    if ( status ) *status = UnknownError;
-    return QList<quint16>();
+    return data;
 }
 
-bool QRtuModbus::writeSingleCoil( const quint8 deviceAddress , const quint16 outputAddress ,
-                                   const bool outputValue , quint8 *const status ) const
+qint64 QRtuModbus::_readLine( char *const data , const qint64 maxSize ) const
 {
-    // Are we connected ?
-    if ( !isOpen() )
-    {
-        if ( status ) *status = NoConnection;
-        return false;
-    }
+    qint64 count = 0;
+    DWORD size = 0;
 
-    // Create modbus write single coil pdu (Modbus uses Big Endian).
-    QByteArray pdu;
-    QDataStream pduStream( &pdu , QIODevice::WriteOnly );
-    pduStream.setByteOrder( QDataStream::BigEndian );
-    pduStream << deviceAddress << (quint8)0x05 << outputAddress << ( outputValue ? (quint16)0xFF00 : (quint16)0x0000 );
+    if ( maxSize == 0 ) return 0;
 
-    // Calculate CRC and add it to the PDU.
-    quint16 crc = _calculateCrc( pdu );
-    pduStream.writeRawData( (const char *)&crc , sizeof( crc ) );
+    // Leave room for the terminating null.
+    while( ( count == 0 || data[count - 1] != '\n' ) && count < maxSize - 1 )
+    {
+        if ( !ReadFile( _commPort , data + count , 1 , &size , NULL ) || size == 0 ) break;
+        count++;
+    }
+    data[count] = 0;
 
-    // Clear the RX buffer before making the request.
-    _readAll();
+    return count;
+}
 
-    // Send the pdu.
-    _write( pdu );
+void QRtuModbus::_discard( void ) const
+{
+    PurgeComm( _commPort , PURGE_RXCLEAR );
+}
 
-    // Await response.
-    pdu.clear();
+bool QRtuModbus::_write( const char *const data , const qint64 size ) const
+{
+    DWORD written = 0;
 
-    // Even on error we have at least 5 bytes to read.
-    pdu = _read( 5 );
+    if ( size == 0 ) return true;
 
-    // Handle timeout.
-    if ( pdu.size() < 5 )
+    if ( WriteFile( _commPort , data , size , &written , NULL ) )
     {
-        if ( status ) *status = Timeout;
-        return false;
-    }
-
-    // Was it a Modbus error?
-    if ( pdu[1] & 0x80 )
-    {
-        if ( !_checkCrc( pdu ) )
-        {
-            if ( status ) *status = CrcError;
-        }
-        else
-        {
-            if ( status ) *status = pdu[2];
-        }
-        return false;
-    }
-
-    // Read the rest of the message.
-    pdu += _read( 3 );
-
-    // Check CRC.
-    if ( !_checkCrc( pdu ) )
-    {
-        if ( status ) *status = CrcError;
-        return false;
-    }
-
-    // Check data and return them on success.
-    if ( pdu.size() == 8 )
-    {
-        // Read device address and command ID and control them.
-        quint8 rxDeviceAddress , rxFunctionCode;
-        quint16 rxOutputAddress , rxOutputValue;
-        QDataStream rxStream( pdu );
-        rxStream.setByteOrder( QDataStream::BigEndian );
-        rxStream >> rxDeviceAddress >> rxFunctionCode >> rxOutputAddress >> rxOutputValue;
-        if ( rxDeviceAddress == deviceAddress && rxFunctionCode == 0x05 && rxOutputAddress == outputAddress &&
-             ( ( outputValue && rxOutputValue == 0xFF00 ) || ( !outputValue && rxOutputValue == 0x0000 ) ) )
-        {
-            if ( status ) *status = Ok;
-            return true;
-        }
-    }
-
-    // If we arrive here, something went wrong.
-    if ( status ) *status = UnknownError;
-    return false;
-}
-
-bool QRtuModbus::writeSingleRegister( const quint8 deviceAddress , const quint16 outputAddress ,
-                                       const quint16 registerValue , quint8 *const status ) const
-{
-    // Are we connected ?
-    if ( !isOpen() )
-    {
-        if ( status ) *status = NoConnection;
-        return false;
-    }
-
-    // Create modbus write single coil pdu (Modbus uses Big Endian).
-    QByteArray pdu;
-    QDataStream pduStream( &pdu , QIODevice::WriteOnly );
-    pduStream.setByteOrder( QDataStream::BigEndian );
-    pduStream << deviceAddress << (quint8)0x06 << outputAddress << registerValue;
-
-    // Calculate CRC and add it to the PDU.
-    quint16 crc = _calculateCrc( pdu );
-    pduStream.writeRawData( (const char *)&crc , sizeof( crc ) );
-
-    // Clear the RX buffer before making the request.
-    _readAll();
-
-    // Send the pdu.
-    _write( pdu );
-
-    // Await response.
-    pdu.clear();
-
-    // Even on error we have at least 5 bytes to read.
-    pdu = _read( 5 );
-
-    // Handle timeout.
-    if ( pdu.size() < 5 )
-    {
-        if ( status ) *status = Timeout;
-        return false;
-    }
-
-    // Was it a Modbus error?
-    if ( pdu[1] & 0x80 )
-    {
-        if ( !_checkCrc( pdu ) )
-        {
-            if ( status ) *status = CrcError;
-        }
-        else
-        {
-            if ( status ) *status = pdu[2];
-        }
-        return false;
-    }
-
-    // Read the rest of the message.
-    pdu += _read( 3 );
-
-    // Check CRC.
-    if ( !_checkCrc( pdu ) )
-    {
-        if ( status ) *status = CrcError;
-        return false;
-    }
-
-    // Check data and return them on success.
-    if ( pdu.size() == 8 )
-    {
-        // Read device address and command ID and control them.
-        quint8 rxDeviceAddress , rxFunctionCode;
-        quint16 rxOutputAddress , rxRegisterValue;
-        QDataStream rxStream( pdu );
-        rxStream.setByteOrder( QDataStream::BigEndian );
-        rxStream >> rxDeviceAddress >> rxFunctionCode >> rxOutputAddress >> rxRegisterValue;
-        if ( rxDeviceAddress == deviceAddress && rxFunctionCode == 0x06 && rxOutputAddress == outputAddress &&
-             rxRegisterValue == registerValue )
-        {
-            if ( status ) *status = Ok;
-            return true;
-        }
+        return ( (qint64)written == size );
     }
-
-    // If we arrive here, something went wrong.
-    if ( status ) *status = UnknownError;
     return false;
 }
 
-bool QRtuModbus::writeMultipleCoils( const quint8 deviceAddress , const quint16 startingAddress ,
-                                      const QList<bool> & outputValues , quint8 *const status ) const
+bool QRtuModbus::_waitForData( const QModbusDeadline &deadline , const QModbusCancellationToken &token ) const
 {
-    // Are we connected ?
-    if ( !isOpen() )
-    {
-        if ( status ) *status = NoConnection;
-        return false;
-    }
-
-    // Create modbus write multiple coil pdu (Modbus uses Big Endian).
-    QByteArray pdu;
-    QDataStream pduStream( &pdu , QIODevice::WriteOnly );
-    pduStream.setByteOrder( QDataStream::BigEndian );
-    quint8 txBytes = outputValues.count() / 8;
-    if ( outputValues.count() % 8 != 0 ) txBytes++;
-    pduStream << deviceAddress << (quint8)0x0F << startingAddress << (quint16)outputValues.count() << txBytes;
-
-    // Encode the binary values.
-    quint8 tmp = 0;
-    for ( int i = 0 ; i < outputValues.count() ; i++ )
-    {
-        if ( i % 8 == 0 )
-        {
-            if ( i != 0 ) pduStream << tmp;
-            tmp = 0;
-        }
-        if ( outputValues[i] ) tmp |= 0x01 << ( i % 8 );
-    }
-    pduStream << tmp;
-
-    // Calculate CRC and add it to the PDU.
-    quint16 crc = _calculateCrc( pdu );
-    pduStream.writeRawData( (const char *)&crc , sizeof( crc ) );
-
-    // Clear the RX buffer before making the request.
-    _readAll();
-
-    // Send the pdu.
-    _write( pdu );
-
-    // Await response.
-    pdu.clear();
-
-    // Even on error we have at least 5 bytes to read.
-    pdu = _read( 5 );
-
-    // Handle timeout.
-    if ( pdu.size() < 5 )
-    {
-        if ( status ) *status = Timeout;
-        return false;
-    }
-
-    // Was it a Modbus error?
-    if ( pdu[1] & 0x80 )
-    {
-        if ( !_checkCrc( pdu ) )
-        {
-            if ( status ) *status = CrcError;
-        }
-        else
-        {
-            if ( status ) *status = pdu[2];
-        }
-        return false;
-    }
-
-    // Read the rest of the message.
-    pdu += _read( 3 );
-
-    // Check CRC.
-    if ( !_checkCrc( pdu ) )
-    {
-        if ( status ) *status = CrcError;
-        return false;
-    }
-
-    // Check data and return them on success.
-    if ( pdu.size() == 8 )
-    {
-        // Read TCP fields and, device address and command ID and control them.
-        quint8 rxDeviceAddress , rxFunctionCode;
-        quint16 rxStartingAddress , rxQuantityOfOutputs;
-        QDataStream rxStream( pdu );
-        rxStream.setByteOrder( QDataStream::BigEndian );
-        rxStream >> rxDeviceAddress >> rxFunctionCode >> rxStartingAddress >> rxQuantityOfOutputs;
-        if ( rxDeviceAddress == deviceAddress && rxFunctionCode == 0x0F && rxStartingAddress == startingAddress &&
-             rxQuantityOfOutputs == outputValues.count() )
-        {
-            if ( status ) *status = Ok;
-            return true;
-        }
-    }
-
-    // If we arrive here, something went wrong.
-    if ( status ) *status = UnknownError;
-    return false;
-}
-
-bool QRtuModbus::writeMultipleRegisters( const quint8 deviceAddress , const quint16 startingAddress ,
-                                          const QList<quint16> & registersValues , quint8 *const status ) const
-{
-    // Are we connected ?
-    if ( !isOpen() )
-    {
-        if ( status ) *status = NoConnection;
-        return false;
-    }
-
-    // Create modbus write multiple registers pdu (Modbus uses Big Endian).
-    QByteArray pdu;
-    QDataStream pduStream( &pdu , QIODevice::WriteOnly );
-    pduStream.setByteOrder( QDataStream::BigEndian );
-    quint8 txBytes = registersValues.count() * 2;
-    pduStream << deviceAddress << (quint8)0x10 << startingAddress << (quint16)registersValues.count() << txBytes;
-
-    // Encode the register values.
-    foreach ( quint16 reg , registersValues )
-    {
-        pduStream << reg;
-    }
-
-    // Calculate CRC and add it to the PDU.
-    quint16 crc = _calculateCrc( pdu );
-    pduStream.writeRawData( (const char *)&crc , sizeof( crc ) );
-
-    // Clear the RX buffer before making the request.
-    _readAll();
-
-    // Send the pdu.
-    _write( pdu );
-
-    // Await response.
-    pdu.clear();
-
-    // Even on error we have at least 5 bytes to read.
-    pdu = _read( 5 );
-
-    // Handle timeout.
-    if ( pdu.size() < 5 )
-    {
-        if ( status ) *status = Timeout;
-        return false;
-    }
-
-    // Was it a Modbus error?
-    if ( pdu[1] & 0x80 )
-    {
-        if ( !_checkCrc( pdu ) )
-        {
-            if ( status ) *status = CrcError;
-        }
-        else
-        {
-            if ( status ) *status = pdu[2];
-        }
-        return false;
-    }
-
-    // Read the rest of the message.
-    pdu += _read( 3 );
-
-    // Check CRC.
-    if ( !_checkCrc( pdu ) )
-    {
-        if ( status ) *status = CrcError;
-        return false;
-    }
-
-    // Check data and return them on success.
-    if ( pdu.size() == 8 )
-    {
-        // Read device address and command ID and control them.
-        quint8 rxDeviceAddress , rxFunctionCode;
-        quint16 rxStartingAddress , rxQuantityOfRegisters;
-        QDataStream rxStream( pdu );
-        rxStream.setByteOrder( QDataStream::BigEndian );
-        rxStream >> rxDeviceAddress >> rxFunctionCode >> rxStartingAddress >> rxQuantityOfRegisters;
-        if ( rxDeviceAddress == deviceAddress && rxFunctionCode == 0x10 && rxStartingAddress == startingAddress &&
-             rxQuantityOfRegisters == registersValues.count() )
-        {
-            if ( status ) *status = Ok;
-            return true;
-        }
-    }
-
-    // If we arrive here, something went wrong.
-    if ( status ) *status = UnknownError;
-    return false;
-}
-
-bool QRtuModbus::maskWriteRegister( const quint8 deviceAddress , const quint16 referenceAddress ,
-                                     const quint16 andMask , const quint16 orMask , quint8 *const status ) const
-{
-    // Are we connected ?
-    if ( !isOpen() )
-    {
-        if ( status ) *status = NoConnection;
-        return false;
-    }
-
-    // Create modbus mask write register pdu (Modbus uses Big Endian).
-    QByteArray pdu;
-    QDataStream pduStream( &pdu , QIODevice::WriteOnly );
-    pduStream.setByteOrder( QDataStream::BigEndian );
-    pduStream << deviceAddress << (quint8)0x16 << referenceAddress << andMask << orMask;
-
-    // Calculate CRC and add it to the PDU.
-    quint16 crc = _calculateCrc( pdu );
-    pduStream.writeRawData( (const char *)&crc , sizeof( crc ) );
-
-    // Clear the RX buffer before making the request.
-    _readAll();
-
-    // Send the pdu.
-    _write( pdu );
-
-    // Await response.
-    pdu.clear();
-
-    // Even on error we have at least 5 bytes to read.
-    pdu = _read( 5 );
-
-    // Handle timeout.
-    if ( pdu.size() < 5 )
-    {
-        if ( status ) *status = Timeout;
-        return false;
-    }
-
-    // Was it a Modbus error?
-    if ( pdu[1] & 0x80 )
-    {
-        if ( !_checkCrc( pdu ) )
-        {
-            if ( status ) *status = CrcError;
-        }
-        else
-        {
-            if ( status ) *status = pdu[2];
-        }
-        return false;
-    }
-
-    // Read the rest of the message.
-    pdu += _read( 5 );
-
-    // Check CRC.
-    if ( !_checkCrc( pdu ) )
-    {
-        if ( status ) *status = CrcError;
-        return false;
-    }
-
-    // Check data and return them on success.
-    if ( pdu.size() == 10 )
-    {
-        // Read device address and command ID and control them.
-        quint8 rxDeviceAddress , rxFunctionCode;
-        quint16 rxReferenceAddress , rxAndMask , rxOrMask;
-        QDataStream rxStream( pdu );
-        rxStream.setByteOrder( QDataStream::BigEndian );
-        rxStream >> rxDeviceAddress >> rxFunctionCode >> rxReferenceAddress >> rxAndMask >> rxOrMask;
-        if ( rxDeviceAddress == deviceAddress && rxFunctionCode == 0x16 &&
-             rxReferenceAddress == referenceAddress && rxAndMask == andMask && rxOrMask == orMask )
-        {
-            if ( status ) *status = Ok;
-            return true;
-        }
-    }
-
-    // If we arrive here, something went wrong.
-    if ( status ) *status = UnknownError;
-    return false;
-}
-
-
-QList<quint16> QRtuModbus::writeReadMultipleRegisters( const quint8 deviceAddress ,
-                                                        const quint16 writeStartingAddress ,
-                                                        const QList<quint16> & writeValues ,
-                                                        const quint16 readStartingAddress ,
-                                                        const quint16 quantityToRead , quint8 *const status) const
-{
-    // Are we connected ?
-    if ( !isOpen() )
-    {
-        if ( status ) *status = NoConnection;
-        return QList<quint16>();
-    }
-
-    // Create modbus read holding registers pdu (Modbus uses Big Endian).
-    QByteArray pdu;
-    QDataStream pduStream( &pdu , QIODevice::WriteOnly );
-    pduStream.setByteOrder( QDataStream::BigEndian );
-    pduStream << deviceAddress << (quint8)0x17 << readStartingAddress << quantityToRead
-              << writeStartingAddress << (quint16)writeValues.count() << (quint16)( writeValues.count() * 2 );
-
-    // Add data.
-    foreach ( quint16 reg , writeValues )
-    {
-        pduStream << reg;
-    }
-
-    // Calculate CRC and add it to the PDU.
-    quint16 crc = _calculateCrc( pdu );
-    pduStream.writeRawData( (const char *)&crc , sizeof( crc ) );
-
-    // Clear the RX buffer before making the request.
-    _readAll();
-
-    // Send the pdu.
-    _write( pdu );
-
-    // Await response.
-    quint16 neededRxBytes = quantityToRead * 2;
-    pdu.clear();
-
-    // Even on error we have at least 5 bytes to read.
-    pdu = _read( 5 );
-
-    // Handle timeout.
-    if ( pdu.size() < 5 )
-    {
-        if ( status ) *status = Timeout;
-        return QList<quint16>();
-    }
-
-    // Was it a Modbus error?
-    if ( pdu[1] & 0x80 )
-    {
-        if ( !_checkCrc( pdu ) )
-        {
-            if ( status ) *status = CrcError;
-        }
-        else
-        {
-            if ( status ) *status = pdu[2];
-        }
-        return QList<quint16>();
-    }
-
-    // Read the rest of the message.
-    pdu += _read( neededRxBytes );
-
-    // Check CRC.
-    if ( !_checkCrc( pdu ) )
-    {
-        if ( status ) *status = CrcError;
-        return QList<quint16>();
-    }
-
-    // Check data and return them on success.
-    if ( pdu.size() == neededRxBytes + 5 )
-    {
-        // Read device address and command ID and control them.
-        quint8 rxDeviceAddress , rxFunctionCode , byteCount;
-        QDataStream rxStream( pdu );
-        rxStream.setByteOrder( QDataStream::BigEndian );
-        rxStream >> rxDeviceAddress >> rxFunctionCode >> byteCount;
-
-        if ( rxDeviceAddress == deviceAddress && rxFunctionCode == 0x17 && byteCount == neededRxBytes )
-        {
-            // Generate response data.
-            QList<quint16> list;
-            quint16 tmp;
-            for ( int i = 0 ; i < quantityToRead ; i++ )
-            {
-                rxStream >> tmp;
-                list.append( tmp );
-            }
-            if ( status ) *status = Ok;
-            return list;
-        }
-    }
-
-    // If we arrive here, something went wrong.
-    if ( status ) *status = UnknownError;
-    return QList<quint16>();
-}
-
-QList<quint16> QRtuModbus::readFifoQueue( const quint8 deviceAddress , const quint16 fifoPointerAddress ,
-                                           quint8 *const status ) const
-{
-    // Are we connected ?
-    if ( !isOpen() )
-    {
-        if ( status ) *status = NoConnection;
-        return QList<quint16>();
-    }
-
-    // Create modbus read holding registers pdu (Modbus uses Big Endian).
-    QByteArray pdu;
-    QDataStream pduStream( &pdu , QIODevice::WriteOnly );
-    pduStream.setByteOrder( QDataStream::BigEndian );
-    pduStream << deviceAddress << (quint8)0x18 << fifoPointerAddress;
-
-    // Calculate CRC and add it to the PDU.
-    quint16 crc = _calculateCrc( pdu );
-    pduStream.writeRawData( (const char *)&crc , sizeof( crc ) );
-
-    // Clear the RX buffer before making the request.
-    _readAll();
-
-    // Send the pdu.
-    _write( pdu );
-
-    // Await response.
-    pdu.clear();
-
-    // Even on error we have at least 5 bytes to read.
-    pdu = _read( 5 );
-
-    // Handle timeout.
-    if ( pdu.size() < 5 )
-    {
-        if ( status ) *status = Timeout;
-        return QList<quint16>();
-    }
-
-    // Was it a Modbus error?
-    if ( pdu[1] & 0x80 )
-    {
-        if ( !_checkCrc( pdu ) )
-        {
-            if ( status ) *status = CrcError;
-        }
-        else
-        {
-            if ( status ) *status = pdu[2];
-        }
-        return QList<quint16>();
-    }
-
-    // Read the rest of the message.
-    pdu += _readAll();
-
-    // Check CRC.
-    if ( !_checkCrc( pdu ) )
-    {
-        if ( status ) *status = CrcError;
-        return QList<quint16>();
-    }
-
-    // Check data and return them on success.
-    if ( pdu.size() >= 10 )
-    {
-        // Read TCP fields and, device address and command ID and control them.
-        quint8 rxDeviceAddress , rxFunctionCode;
-        quint16 byteCount , fifoCount;
-        QDataStream rxStream( pdu );
-        rxStream.setByteOrder( QDataStream::BigEndian );
-        rxStream >> rxDeviceAddress >> rxFunctionCode >> byteCount >> fifoCount;
-
-        if ( rxDeviceAddress == deviceAddress && rxFunctionCode == 0x18 && byteCount == fifoCount * 2 )
-        {
-            QList<quint16> list;
-            quint16 tmp;
-            for ( int i = 0 ; i < fifoCount ; i++ )
-            {
-                rxStream >> tmp;
-                list.append( tmp );
-            }
-            if ( status ) *status = Ok;
-            return list;
-        }
-    }
-
-    // Something went wrong...
-    if ( status ) *status = UnknownError;
-    return QList<quint16>();
-}
-
-QByteArray QRtuModbus::executeCustomFunction( const quint8 deviceAddress , const quint8 modbusFunction ,
-                                               QByteArray &data , quint8 *const status ) const
-{
-    // Are we connected ?
-    if ( !isOpen() )
-    {
-        if ( status ) *status = NoConnection;
-        return QByteArray();
-    }
-
-    // Create modbus pdu (Modbus uses Big Endian).
-    QByteArray pdu;
-    QDataStream pduStream( &pdu , QIODevice::WriteOnly );
-    pduStream.setByteOrder( QDataStream::BigEndian );
-    pduStream << deviceAddress << modbusFunction;
-    pduStream.writeRawData( data.data() , data.size() );
-
-    // Calculate CRC and add it to the PDU.
-    quint16 crc = _calculateCrc( pdu );
-    pduStream.writeRawData( (const char *)&crc , sizeof( crc ) );
-
-    // Clear the RX buffer before making the request.
-    _readAll();
-
-    // Send the pdu.
-    _write( pdu );
-
-    // Await response.
-    // Even on error we have at least 5 bytes to read.
-    pdu = _read( 5 );
-
-    // Handle timeout.
-    if ( pdu.size() < 5 )
-    {
-        if ( status ) *status = Timeout;
-        return QByteArray();
-    }
-
-    // Was it a Modbus error?
-    if ( pdu[1] & 0x80 )
-    {
-        if ( !_checkCrc( pdu ) )
-        {
-            if ( status ) *status = CrcError;
-        }
-        else
-        {
-            if ( status ) *status = pdu[2];
-        }
-        return QByteArray();
-    }
-
-    // Read the rest of the message.
-    pdu += _readAll();
-
-    // Check CRC.
-    if ( !_checkCrc( pdu ) )
-    {
-        if ( status ) *status = CrcError;
-        return QByteArray();
-    }
-
-    // Check data and return them on success.
-    if ( pdu.size() >= 4 )
-    {
-        // Read device address and command ID and control them.
-        quint8 rxDeviceAddress , rxFunctionCode;
-        QDataStream rxStream( pdu );
-        rxStream.setByteOrder( QDataStream::BigEndian );
-        rxStream >> rxDeviceAddress >> rxFunctionCode;
-
-        // Control values of the fields.
-        if ( rxDeviceAddress == deviceAddress && rxFunctionCode == modbusFunction )
-        {
-            // Convert data.
-            return pdu.mid( 2 ,  pdu.size() - 4 );
-        }
-    }
-
-    // Something went wrong...
-    if ( status ) *status = UnknownError;
-    return QByteArray();
-}
-
-QByteArray QRtuModbus::executeRaw( QByteArray &data , quint8 *const status ) const
-{
-    QByteArray response;
-
-    // Are we connected ?
-    if ( !isOpen() )
-    {
-        if ( status ) *status = NoConnection;
-        return QByteArray();
-    }
-
-    // Clear the RX buffer before making the request.
-    _readAll();
-
-    // Send the data.
-    _write( data );
-
-    // Await response.
-    // Even on error we have at least 5 bytes to read.
-    response = _readAll();
-
-    // Handle timeout.
-    if ( response.size() == 0 )
-    {
-        if ( status ) *status = Timeout;
-        return QByteArray();
-    }
-
-    return response;
-}
-
-QByteArray QRtuModbus::calculateCheckSum( QByteArray &data ) const
-{
-    quint16 crc = _calculateCrc( data );
-    return QByteArray( (char *)&crc , 2 );
-}
-
-
-# /***/ ifdef Q_OS_WIN /***********************************************************************************************/
-#include <QtDebug>
-QByteArray QRtuModbus::_read( const int numberBytes ) const
-{
-    QByteArray data( numberBytes , 0 );
-    DWORD size = 0;
-
-    if ( numberBytes == 0 ) return data;
-
-    if ( ReadFile( _commPort , data.data() , numberBytes , &size , NULL ) )
-    {
-        data.resize( size );
-    }
-    else
-    {
-        data.resize( 0 );
-    }
-
-    return data;
-}
-
-QByteArray QRtuModbus::_readAll( void ) const
-{
-    QByteArray data( 1024 , 0 );
-    DWORD size = 0;
-    if ( ReadFile( _commPort , data.data() , 1024 , &size , NULL ) )
-    {
-        data.resize( size );
-    }
-    else
-    {
-        data.resize( 0 );
-    }
-
-    return data;
-}
-
-QByteArray QRtuModbus::_readLine( int maxBytes ) const
-{
-    QByteArray data;
-    DWORD size = 0;
-
-    if ( maxBytes == 0 ) return data;
-
-    while( !data.endsWith( '\n' ) && --maxBytes )
-    {
-        unsigned char c;
-        if ( ReadFile( _commPort , &c , 1 , &size , NULL ) )
-        {
-           data.append( c );
-        }
-    }
-
-    return data;
-}
-
-bool QRtuModbus::_write( QByteArray &data ) const
-{
-    DWORD size = 0;
-
-    if ( data.size() == 0 ) return true;
-
-    if ( WriteFile( _commPort , data.constData() , data.size() , &size , NULL ) )
-    {
-        return ( (int)size == data.size() );
-    }
-    return false;
+    return !token.isCancelled() && !deadline.hasExpired();
 }
 
 # /***/ endif /* Q_OS_WIN *********************************************************************************************/
-
-
-quint16 QRtuModbus::_calculateCrc( const QByteArray &pdu ) const
-{
-    quint16 crc , carryFlag , tmp;
-
-    crc = 0xFFFF;
-    for ( int i = 0 ; i < pdu.size() ; i++ )
-    {
-        crc = crc ^ (unsigned char)pdu.at( i );
-        for (int j = 0 ; j < 8 ; j++ )
-        {
-            tmp = crc;
-            carryFlag = tmp & 0x0001;
-            crc = crc >> 1;
-            if ( carryFlag == 1 )
-            {
-                crc = crc ^ 0xA001;
-            }
-        }
-    }
-
-    return crc;
-}
-
-bool QRtuModbus::_checkCrc( const QByteArray &pdu ) const
-{
-    QByteArray msg = pdu.left( pdu.size() - 2 );
-
-    quint16 crc = _calculateCrc( msg );
-
-    return pdu.endsWith( QByteArray( (const char *)&crc , 2 ) );
-}
@@ -5,18 +5,123 @@
 
 
 /*** Qt includes ******************************************************************************************************/
+#include <QModbusRequestCore>
 #include <QtCore/QByteArray>
-#include <QtCore/QDataStream>
+#include <QtCore/QElapsedTimer>
+
+
+/*** Request core *****************************************************************************************************/
+// I/O policy of the request core, uses the socket of the transport.
+class QTcpModbusIo
+{
+public:
+    explicit QTcpModbusIo( const QTcpModbus &modbus ) :
+        _modbus( modbus ) , _token( QModbusCancellationToken::none() ) {}
+
+    bool isOpen( void ) const
+    {
+        return _modbus.isConnected();
+    }
+
+    void discard( void ) const
+    {
+        char sink[64];
+        while ( _modbus._socket.read( sink , sizeof( sink ) ) > 0 );
+    }
+
+    void limit( const QModbusDeadline &deadline , const QModbusCancellationToken &token ) const
+    {
+        _deadline = deadline;
+        _token = token;
+    }
+
+    int read( char *const data , const int size ) const
+    {
+        // Wait for data only if there is not enough data buffered yet.
+        int count = qMax( 0 , (int)_modbus._socket.read( data , size ) );
+        while ( count < size && _wait( count ) )
+        {
+            count += qMax( 0 , (int)_modbus._socket.read( data + count , size - count ) );
+        }
+        return count;
+    }
+
+    int readAll( char *const data , const int maxSize ) const
+    {
+        if ( !_modbus._socket.bytesAvailable() ) _wait( 0 );
+        return qMax( 0 , (int)_modbus._socket.read( data , maxSize ) );
+    }
+
+    int readLine( char *const data , const int maxSize ) const
+    {
+        if ( !_modbus._socket.canReadLine() ) _wait( (int)_modbus._socket.bytesAvailable() );
+        return qMax( 0 , (int)_modbus._socket.readLine( data , maxSize ) );
+    }
+
+    bool write( const char *const data , const int size ) const
+    {
+        return _modbus._socket.write( data , size ) == size;
+    }
+
+    QModbusTcpFraming::Transactions &transactions( void ) const
+    {
+        return _modbus._transactions;
+    }
+
+private:
+    // Waits for more data. Until the first byte (received is 0), the deadline and the token bound the wait as well.
+    bool _wait( const int received ) const
+    {
+        if ( received || ( _deadline.isNever() && !_token.isCancellable() ) )
+        {
+            return _modbus._socket.waitForReadyRead( _modbus._timeout );
+        }
+
+        // Wait in steps, so a cancellation is noticed in time.
+        QElapsedTimer elapsed;
+        elapsed.start();
+        for ( ;; )
+        {
+            const int left = (int)( _modbus._timeout - elapsed.elapsed() );
+            if ( left <= 0 || _token.isCancelled() || _deadline.hasExpired() ) return false;
+
+            int wait = _deadline.remaining( left );
+            if ( _token.isCancellable() ) wait = qMin( wait , (int)QModbusCancellationToken::PollInterval );
+            if ( _modbus._socket.waitForReadyRead( wait ) ) return true;
+            if ( _modbus._socket.state() != QAbstractSocket::ConnectedState ) return false;
+        }
+    }
+
+    const QTcpModbus &_modbus;
+    mutable QModbusDeadline _deadline;          // Limits of the current request (see limit()).
+    mutable QModbusCancellationToken _token;
+};
+
+typedef QModbusRequestCore<QModbusTcpFraming,QTcpModbusIo> QTcpModbusCore;
+
+static inline QTcpModbusCore core( const QTcpModbus &modbus )
+{
+    const QTcpModbusIo io( modbus );
+    return QTcpModbusCore( io , QModbusTcpFraming( io.transactions() ) );
+}
 
 
 /*** Class implementation *********************************************************************************************/
-QTcpModbus::QTcpModbus() : _timeout( 500 ) , _connectTimeout( 1000 )
+QTcpModbus::QTcpModbus() : _timeout( 500 ) , _connectTimeout( 1000 ) , _connecting( false ) , _port( 502 )
 {
-    // Initialize random number generator to use for transaction ID generation.
-    qsrand( time( NULL ) );
+    // The socket and the timer follow the transport if it is moved to another thread (see QModbusSharedConnection).
+    _socket.setParent( this );
+    _connectTimer.setParent( this );
+    _connectTimer.setSingleShot( true );
 
     // Connect the socket's connection lost signal to my connection lost signal.
     QObject::connect( &_socket , SIGNAL( disconnected() ) , this , SIGNAL( connectionLost() ) );
+
+    // Track the outcome of a connect.
+    QObject::connect( &_socket , SIGNAL( connected() ) , this , SLOT( _socketConnected() ) );
+    QObject::connect( &_socket , SIGNAL( error( QAbstractSocket::SocketError ) ) ,
+                      this , SLOT( _socketError( QAbstractSocket::SocketError ) ) );
+    QObject::connect( &_connectTimer , SIGNAL( timeout() ) , this , SLOT( _connectTimedOut() ) );
 }
 
 QTcpModbus::~QTcpModbus()
@@ -27,11 +132,48 @@ QTcpModbus::~QTcpModbus()
 
 bool QTcpModbus::connect( const QString &host , const quint16 port )
 {
-    // Connect the socket to the host.
-    _socket.connectToHost( host , port );
+    connectToHost( host , port );
 
     // Wait until we have the connection established.
-    return _socket.waitForConnected( _connectTimeout );
+    if ( _socket.waitForConnected( _connectTimeout ) ) return true;
+    if ( _connecting ) _failConnect();
+    return false;
+}
+
+void QTcpModbus::connectToHost( const QString &host , const quint16 port )
+{
+    _host = host;
+    _port = port;
+
+    // Nothing is in flight on a new connection.
+    _transactions.clear();
+    _socket.abort();
+
+    // Connect the socket to the host, the timer bounds the time we wait for it.
+    _connecting = true;
+    _connectTimer.start( _connectTimeout );
+    _socket.connectToHost( host , port );
+}
+
+bool QTcpModbus::isConnecting( void ) const
+{
+    return _connecting;
+}
+
+QString QTcpModbus::host( void ) const
+{
+    return _host;
+}
+
+quint16 QTcpModbus::port( void ) const
+{
+    return _port;
+}
+
+void QTcpModbus::reconnect( void )
+{
+    if ( _host.isEmpty() || _connecting || isConnected() ) return;
+    connectToHost( _host , _port );
 }
 
 bool QTcpModbus::isConnected( void ) const
@@ -42,7 +184,9 @@ bool QTcpModbus::isConnected( void ) const
 
 void QTcpModbus::disconnect( void )
 {
-    // Close the socket's connection.
+    // Abandon a connect in progress and close the socket's connection.
+    _connecting = false;
+    _connectTimer.stop();
     _socket.close();
 }
 
@@ -69,973 +213,88 @@ void QTcpModbus::setTimeout( const unsigned int timeout )
 QList<bool> QTcpModbus::readCoils( const quint8 deviceAddress , const quint16 startingAddress ,
                                     const quint16 quantityOfCoils , quint8 *const status ) const
 {
-    // Are we connected ?
-    if ( !isConnected() )
-    {
-        if ( status ) *status = NoConnection;
-        return QList<bool>();
-    }
-
-    // Create a transaction number.
-    quint16 transactionId = qrand();
-
-    // Create tcp/modbus read coil status pdu (Modbus uses Big Endian).
-    QByteArray pdu;
-    QDataStream pduStream( &pdu , QIODevice::WriteOnly );
-    pduStream.setByteOrder( QDataStream::BigEndian );
-    pduStream << transactionId << (quint16)0 << (quint16)6
-              << deviceAddress << (quint8)0x01 << startingAddress << quantityOfCoils;
-
-    // Clear the RX buffer before making the request.
-    _socket.readAll();
-
-    // Send the pdu.
-    _socket.write( pdu );
-
-    // Await response.
-    quint16 neededRxBytes = quantityOfCoils / 8;
-    if ( quantityOfCoils % 8 ) neededRxBytes++;
-    pdu.clear();
-    while ( pdu.size() < neededRxBytes + 9 )
-    {
-        if ( ( pdu.size() >= 9 && pdu[7] & 0x80 ) || !_socket.waitForReadyRead( _timeout ) ) break;
-        pdu += _socket.read( neededRxBytes + 9 - pdu.size() );
-    }
-
-    // Check data and return them on success.
-    if ( pdu.size() == neededRxBytes + 9 )
-    {
-        // Read TCP fields and, device address and command ID and control them.
-        quint16 rxTransactionId , rxProtocolId, rxLength;
-        quint8 rxDeviceAddress , rxFunctionCode , byteCount;
-        QDataStream rxStream( pdu );
-        rxStream.setByteOrder( QDataStream::BigEndian );
-        rxStream >> rxTransactionId >> rxProtocolId >> rxLength >> rxDeviceAddress >> rxFunctionCode >> byteCount;
-
-        // Control values of the fields.
-        if ( rxTransactionId == transactionId && rxProtocolId == 0 && rxLength == neededRxBytes + 3 &&
-             rxDeviceAddress == deviceAddress && rxFunctionCode == 0x01 && byteCount == neededRxBytes )
-        {
-            // Convert data.
-            QList<bool> list;
-            quint8 tmp;
-            for ( int i = 0 ; i < quantityOfCoils ; i++ )
-            {
-                if ( i % 8 == 0 ) rxStream >> tmp;
-                list.append( tmp & ( 0x01 << ( i % 8 ) ) );
-            }
-            if ( status ) *status = Ok;
-            return list;
-        }
-        else
-        {
-            if ( status ) *status = UnknownError;
-        }
-    }
-    else
-    {
-        // What was wrong ?
-        if ( pdu.size() == 9 )
-        {
-            if ( status ) *status = pdu[8];
-        }
-        else
-        {
-            if ( status ) *status = Timeout;
-        }
-    }
-
-    return QList<bool>();
+    return core( *this ).readBits( deviceAddress , 0x01 , startingAddress , quantityOfCoils , status );
 }
 
 QList<bool> QTcpModbus::readDiscreteInputs( const quint8 deviceAddress , const quint16 startingAddress ,
                                              const quint16 quantityOfInputs , quint8 *const status ) const
 {
-    // Are we connected ?
-    if ( !isConnected() )
-    {
-        if ( status ) *status = NoConnection;
-        return QList<bool>();
-    }
-
-    // Create a transaction number.
-    quint16 transactionId = qrand();
-
-    // Create tcp/modbus read input status pdu (Modbus uses Big Endian).
-    QByteArray pdu;
-    QDataStream pduStream( &pdu , QIODevice::WriteOnly );
-    pduStream.setByteOrder( QDataStream::BigEndian );
-    pduStream << transactionId << (quint16)0 << (quint16)6
-              << deviceAddress << (quint8)0x02 << startingAddress << quantityOfInputs;
-
-    // Clear the RX buffer before making the request.
-    _socket.readAll();
-
-    // Send the pdu.
-    _socket.write( pdu );
-
-    // Await response.
-    quint16 neededRxBytes = quantityOfInputs / 8;
-    if ( quantityOfInputs % 8 ) neededRxBytes++;
-    pdu.clear();
-    while ( pdu.size() < neededRxBytes + 9 )
-    {
-        if ( ( pdu.size() >= 9 && pdu[7] & 0x80 ) || !_socket.waitForReadyRead( _timeout ) ) break;
-        pdu += _socket.read( neededRxBytes + 9 - pdu.size() );
-    }
-
-    // Check data and return them on success.
-    if ( pdu.size() == neededRxBytes + 9 )
-    {
-        // Read TCP fields and, device address and command ID and control them.
-        quint16 rxTransactionId , rxProtocolId, rxLength;
-        quint8 rxDeviceAddress , rxFunctionCode , byteCount;
-        QDataStream rxStream( pdu );
-        rxStream.setByteOrder( QDataStream::BigEndian );
-        rxStream >> rxTransactionId >> rxProtocolId >> rxLength >> rxDeviceAddress >> rxFunctionCode >> byteCount;
-
-        // Control values of the fields.
-        if ( rxTransactionId == transactionId && rxProtocolId == 0 && rxLength == neededRxBytes + 3 &&
-             rxDeviceAddress == deviceAddress && rxFunctionCode == 0x02 && byteCount == neededRxBytes )
-        {
-            // Convert data.
-            QList<bool> list;
-            quint8 tmp;
-            for ( int i = 0 ; i < quantityOfInputs ; i++ )
-            {
-                if ( i % 8 == 0 ) rxStream >> tmp;
-                list.append( tmp & ( 0x01 << ( i % 8 ) ) );
-            }
-            if ( status ) *status = Ok;
-            return list;
-        }
-        else
-        {
-            if ( status ) *status = UnknownError;
-        }
-    }
-    else
-    {
-        // What was wrong ?
-        if ( pdu.size() == 9 )
-        {
-            if ( status ) *status = pdu[8];
-        }
-        else
-        {
-            if ( status ) *status = Timeout;
-        }
-    }
-
-    return QList<bool>();
+    return core( *this ).readBits( deviceAddress , 0x02 , startingAddress , quantityOfInputs , status );
 }
 
 QList<quint16> QTcpModbus::readHoldingRegisters( const quint8 deviceAddress , const quint16 startingAddress ,
                                                   const quint16 quantityOfRegisters , quint8 *const status ) const
 {
-    // Are we connected ?
-    if ( !isConnected() )
-    {
-        if ( status ) *status = NoConnection;
-        return QList<quint16>();
-    }
-
-    // Create a transaction number.
-    quint16 transactionId = qrand();
-
-    // Create tcp/modbus read holding registers pdu (Modbus uses Big Endian).
-    QByteArray pdu;
-    QDataStream pduStream( &pdu , QIODevice::WriteOnly );
-    pduStream.setByteOrder( QDataStream::BigEndian );
-    pduStream << transactionId << (quint16)0 << (quint16)6
-              << deviceAddress << (quint8)0x03 << startingAddress << quantityOfRegisters;
-
-    // Clear the RX buffer before making the request.
-    _socket.readAll();
-
-     // Send the pdu.
-    _socket.write( pdu );
-
-    // Await response.
-    quint16 neededRxBytes = quantityOfRegisters * 2;
-    pdu.clear();
-    while ( pdu.size() < neededRxBytes + 9 )
-    {
-        if ( ( pdu.size() >= 9 && pdu[7] & 0x80 ) || !_socket.waitForReadyRead( _timeout ) ) break;
-        pdu += _socket.read( neededRxBytes + 9 - pdu.size() );
-    }
-
-    // Check data and return them on success.
-    if ( pdu.size() == neededRxBytes + 9 )
-    {
-        // Read TCP fields and, device address and command ID and control them.
-        quint16 rxTransactionId , rxProtocolId, rxLength;
-        quint8 rxDeviceAddress , rxFunctionCode , byteCount;
-        QDataStream rxStream( pdu );
-        rxStream.setByteOrder( QDataStream::BigEndian );
-        rxStream >> rxTransactionId >> rxProtocolId >> rxLength >> rxDeviceAddress >> rxFunctionCode >> byteCount;
-
-        // Control values of the fields.
-        if ( rxTransactionId == transactionId && rxProtocolId == 0 && rxLength == neededRxBytes + 3 &&
-             rxDeviceAddress == deviceAddress && rxFunctionCode == 0x03 && byteCount == neededRxBytes )
-        {
-            // Convert data.
-            QList<quint16> list;
-            quint16 tmp;
-            for ( int i = 0 ; i < quantityOfRegisters ; i++ )
-            {
-                rxStream >> tmp;
-                list.append( tmp );
-            }
-            if ( status ) *status = Ok;
-            return list;
-        }
-        else
-        {
-            if ( status ) *status = UnknownError;
-        }
-    }
-    else
-    {
-        // What was wrong ?
-        if ( pdu.size() == 9 )
-        {
-            if ( status ) *status = pdu[8];
-        }
-        else
-        {
-            if ( status ) *status = Timeout;
-        }
-    }
-
-    return QList<quint16>();
+    return core( *this ).readRegisters( deviceAddress , 0x03 , startingAddress , quantityOfRegisters , status );
 }
 
 QList<quint16> QTcpModbus::readInputRegisters( const quint8 deviceAddress , const quint16 startingAddress ,
                                                 const quint16 quantityOfInputRegisters , quint8 *const status ) const
 {
-    // Are we connected ?
-    if ( !isConnected() )
-    {
-        if ( status ) *status = NoConnection;
-        return QList<quint16>();
-    }
-
-    // Create a transaction number.
-    quint16 transactionId = qrand();
-
-    // Create modbus read input status pdu (Modbus uses Big Endian).
-    QByteArray pdu;
-    QDataStream pduStream( &pdu , QIODevice::WriteOnly );
-    pduStream.setByteOrder( QDataStream::BigEndian );
-    pduStream << transactionId << (quint16)0 << (quint16)6
-              << deviceAddress << (quint8)0x04 << startingAddress << quantityOfInputRegisters;
-
-    // Clear the RX buffer before making the request.
-    _socket.readAll();
-
-    // Send the pdu.
-    _socket.write( pdu );
-
-    // Await response.
-    quint16 neededRxBytes = quantityOfInputRegisters * 2;
-    pdu.clear();
-    while ( pdu.size() < neededRxBytes + 9 )
-    {
-        if ( ( pdu.size() >= 9 && pdu[7] & 0x80 ) || !_socket.waitForReadyRead( _timeout ) ) break;
-        pdu += _socket.read( neededRxBytes + 9 - pdu.size() );
-    }
-
-    // Check data and return them on success.
-    if ( pdu.size() == neededRxBytes + 9 )
-    {
-        // Read TCP fields and, device address and command ID and control them.
-        quint16 rxTransactionId , rxProtocolId, rxLength;
-        quint8 rxDeviceAddress , rxFunctionCode , byteCount;
-        QDataStream rxStream( pdu );
-        rxStream.setByteOrder( QDataStream::BigEndian );
-        rxStream >> rxTransactionId >> rxProtocolId >> rxLength >> rxDeviceAddress >> rxFunctionCode >> byteCount;
-
-        // Control values of the fields.
-        if ( rxTransactionId == transactionId && rxProtocolId == 0 && rxLength == neededRxBytes + 3 &&
-             rxDeviceAddress == deviceAddress && rxFunctionCode == 0x04 && byteCount == neededRxBytes )
-        {
-            // Convert data.
-            QList<quint16> list;
-            quint16 tmp;
-            for ( int i = 0 ; i < quantityOfInputRegisters ; i++ )
-            {
-                rxStream >> tmp;
-                list.append( tmp );
-            }
-            if ( status ) *status = Ok;
-            return list;
-        }
-        else
-        {
-            if ( status ) *status = UnknownError;
-        }
-    }
-    else
-    {
-        // What was wrong ?
-        if ( pdu.size() == 9 )
-        {
-            if ( status ) *status = pdu[8];
-        }
-        else
-        {
-            if ( status ) *status = Timeout;
-        }
-    }
-
-    return QList<quint16>();
+    return core( *this ).readRegisters( deviceAddress , 0x04 , startingAddress , quantityOfInputRegisters , status );
 }
 
 bool QTcpModbus::writeSingleCoil( const quint8 deviceAddress , const quint16 outputAddress ,
                                    const bool outputValue , quint8 *const status ) const
 {
-    // Are we connected ?
-    if ( !isConnected() )
-    {
-        if ( status ) *status = NoConnection;
-        return false;
-    }
-
-    // Create a transaction number.
-    quint16 transactionId = qrand();
-
-    // Create modbus write single coil pdu (Modbus uses Big Endian).
-    QByteArray pdu;
-    QDataStream pduStream( &pdu , QIODevice::WriteOnly );
-    pduStream.setByteOrder( QDataStream::BigEndian );
-    pduStream << transactionId << (quint16)0 << (quint16)6
-              << deviceAddress << (quint8)0x05 << outputAddress << ( outputValue ? (quint16)0xFF00 : (quint16)0x0000 );
-
-    // Clear the RX buffer before making the request.
-    _socket.readAll();
-
-    // Send the pdu.
-    _socket.write( pdu );
-
-    // Await response.
-    pdu.clear();
-    while ( pdu.size() < 12 )
-    {
-        if ( ( pdu.size() >= 9 && pdu[7] & 0x80 ) || !_socket.waitForReadyRead( _timeout ) ) break;
-        pdu += _socket.read( 12 - pdu.size() );
-    }
-
-    // Check data and return them on success.
-    if ( pdu.size() == 12 )
-    {
-        // Read TCP fields and, device address and command ID and control them.
-        quint16 rxTransactionId , rxProtocolId, rxLength , rxOutputAddress , rxOutputValue;
-        quint8 rxDeviceAddress , rxFunctionCode;
-        QDataStream rxStream( pdu );
-        rxStream.setByteOrder( QDataStream::BigEndian );
-        rxStream >> rxTransactionId >> rxProtocolId >> rxLength >> rxDeviceAddress >> rxFunctionCode
-                 >> rxOutputAddress >> rxOutputValue;
-
-        // Control values of the fields.
-        if ( rxTransactionId == transactionId && rxProtocolId == 0 && rxLength == 6 &&
-             rxDeviceAddress == deviceAddress && rxFunctionCode == 0x05 && rxOutputAddress == outputAddress &&
-             ( ( outputValue && rxOutputValue == 0xFF00 ) || ( !outputValue && rxOutputValue == 0x0000 ) ) )
-        {
-            // Ok, done.
-            if ( status ) *status = Ok;
-            return true;
-        }
-        else
-        {
-            if ( status ) *status = UnknownError;
-        }
-    }
-    else
-    {
-        // What was wrong ?
-        if ( pdu.size() == 9 )
-        {
-            if ( status ) *status = pdu[8];
-        }
-        else
-        {
-            if ( status ) *status = Timeout;
-        }
-    }
-
-    return false;
+    return core( *this ).writeSingleCoil( deviceAddress , outputAddress , outputValue , status );
 }
 
 bool QTcpModbus::writeSingleRegister( const quint8 deviceAddress , const quint16 outputAddress ,
                                        const quint16 registerValue , quint8 *const status ) const
 {
-    // Are we connected ?
-    if ( !isConnected() )
-    {
-        if ( status ) *status = NoConnection;
-        return false;
-    }
-
-    // Create a transaction number.
-    quint16 transactionId = qrand();
-
-    // Create modbus write single coil pdu (Modbus uses Big Endian).
-    QByteArray pdu;
-    QDataStream pduStream( &pdu , QIODevice::WriteOnly );
-    pduStream.setByteOrder( QDataStream::BigEndian );
-    pduStream << transactionId << (quint16)0 << (quint16)6
-              << deviceAddress << (quint8)0x06 << outputAddress << registerValue;
-
-    // Clear the RX buffer before making the request.
-    _socket.readAll();
-
-    // Send the pdu.
-    _socket.write( pdu );
-
-    // Await response.
-    pdu.clear();
-    while ( pdu.size() < 12 )
-    {
-        if ( ( pdu.size() >= 9 && pdu[7] & 0x80 ) || !_socket.waitForReadyRead( _timeout ) ) break;
-        pdu += _socket.read( 12 - pdu.size() );
-    }
-
-    // Check data and return them on success.
-    if ( pdu.size() == 12 )
-    {
-        // Read TCP fields and, device address and command ID and control them.
-        quint16 rxTransactionId , rxProtocolId, rxLength , rxOutputAddress , rxRegisterValue;
-        quint8 rxDeviceAddress , rxFunctionCode;
-        QDataStream rxStream( pdu );
-        rxStream.setByteOrder( QDataStream::BigEndian );
-        rxStream >> rxTransactionId >> rxProtocolId >> rxLength >> rxDeviceAddress >> rxFunctionCode
-                 >> rxOutputAddress >> rxRegisterValue;
-
-        // Control values of the fields.
-        if ( rxTransactionId == transactionId && rxProtocolId == 0 && rxLength == 6 &&
-             rxDeviceAddress == deviceAddress && rxFunctionCode == 0x06 && rxOutputAddress == outputAddress &&
-             rxRegisterValue == registerValue )
-        {
-            // Ok, done.
-            if ( status ) *status = Ok;
-            return true;
-        }
-        else
-        {
-            if ( status ) *status = UnknownError;
-        }
-    }
-    else
-    {
-        // What was wrong ?
-        if ( pdu.size() == 9 )
-        {
-            if ( status ) *status = pdu[8];
-        }
-        else
-        {
-            if ( status ) *status = Timeout;
-        }
-    }
-
-    return false;
+    return core( *this ).writeSingleRegister( deviceAddress , outputAddress , registerValue , status );
 }
 
 bool QTcpModbus::writeMultipleCoils( const quint8 deviceAddress , const quint16 startingAddress ,
                                       const QList<bool> & outputValues , quint8 *const status ) const
 {
-    // Are we connected ?
-    if ( !isConnected() )
-    {
-        if ( status ) *status = NoConnection;
-        return false;
-    }
-
-    // Create a transaction number.
-    quint16 transactionId = qrand();
-
-    // Create modbus write multiple coil pdu (Modbus uses Big Endian).
-    QByteArray pdu;
-    QDataStream pduStream( &pdu , QIODevice::WriteOnly );
-    pduStream.setByteOrder( QDataStream::BigEndian );
-    quint8 txBytes = outputValues.count() / 8;
-    if ( outputValues.count() % 8 != 0 ) txBytes++;
-    pduStream << transactionId << (quint16)0 << (quint16)( txBytes + 7 )
-              << deviceAddress << (quint8)0x0F << startingAddress << (quint16)outputValues.count() << txBytes;
-
-    // Encode the binary values.
-    quint8 tmp = 0;
-    for ( int i = 0 ; i < outputValues.count() ; i++ )
-    {
-        if ( i % 8 == 0 )
-        {
-            if ( i != 0 ) pduStream << tmp;
-            tmp = 0;
-        }
-        if ( outputValues[i] ) tmp |= 0x01 << ( i % 8 );
-    }
-    pduStream << tmp;
-
-    // Clear the RX buffer before making the request.
-    _socket.readAll();
-
-    // Send the pdu.
-    _socket.write( pdu );
-
-    // Await response.
-    pdu.clear();
-    while ( pdu.size() < 12 )
-    {
-        if ( ( pdu.size() >= 9 && pdu[7] & 0x80 ) || !_socket.waitForReadyRead( _timeout ) ) break;
-        pdu += _socket.read( 12 - pdu.size() );
-    }
-
-    // Check data and return them on success.
-    if ( pdu.size() == 12 )
-    {
-        // Read TCP fields and, device address and command ID and control them.
-        quint16 rxTransactionId , rxProtocolId, rxLength , rxStartingAddress , rxQuantityOfOutputs;
-        quint8 rxDeviceAddress , rxFunctionCode;
-        QDataStream rxStream( pdu );
-        rxStream.setByteOrder( QDataStream::BigEndian );
-        rxStream >> rxTransactionId >> rxProtocolId >> rxLength >> rxDeviceAddress >> rxFunctionCode
-                 >> rxStartingAddress >> rxQuantityOfOutputs;
-
-        // Control values of the fields.
-        if ( rxTransactionId == transactionId && rxProtocolId == 0 && rxLength == 6 &&
-             rxDeviceAddress == deviceAddress && rxFunctionCode == 0x0F && rxStartingAddress == startingAddress &&
-             rxQuantityOfOutputs == outputValues.count() )
-        {
-            // Ok, done.
-            if ( status ) *status = Ok;
-            return true;
-        }
-        else
-        {
-            if ( status ) *status = UnknownError;
-        }
-    }
-    else
-    {
-        // What was wrong ?
-        if ( pdu.size() == 9 )
-        {
-            if ( status ) *status = pdu[8];
-        }
-        else
-        {
-            if ( status ) *status = Timeout;
-        }
-    }
-
-    return false;
+    return core( *this ).writeMultipleCoils( deviceAddress , startingAddress , outputValues , status );
 }
 
 bool QTcpModbus::writeMultipleRegisters( const quint8 deviceAddress , const quint16 startingAddress ,
                                           const QList<quint16> & registersValues , quint8 *const status ) const
 {
-    // Are we connected ?
-    if ( !isConnected() )
-    {
-        if ( status ) *status = NoConnection;
-        return false;
-    }
-
-    // Create a transaction number.
-    quint16 transactionId = qrand();
-
-    // Create modbus write multiple registers pdu (Modbus uses Big Endian).
-    QByteArray pdu;
-    QDataStream pduStream( &pdu , QIODevice::WriteOnly );
-    pduStream.setByteOrder( QDataStream::BigEndian );
-    quint8 txBytes = registersValues.count() * 2;
-    pduStream << transactionId << (quint16)0 << (quint16)( txBytes + 7 )
-              << deviceAddress << (quint8)0x10 << startingAddress << (quint16)registersValues.count() << txBytes;
-
-    // Encode the register values.
-    foreach ( quint16 reg , registersValues )
-    {
-        pduStream << reg;
-    }
-
-    // Clear the RX buffer before making the request.
-    _socket.readAll();
-
-    // Send the pdu.
-    _socket.write( pdu );
-
-    // Await response.
-    pdu.clear();
-    while ( pdu.size() < 12 )
-    {
-        if ( ( pdu.size() >= 9 && pdu[7] & 0x80 ) || !_socket.waitForReadyRead( _timeout ) ) break;
-        pdu += _socket.read( 12 - pdu.size() );
-    }
-
-    // Check data and return them on success.
-    if ( pdu.size() == 12 )
-    {
-        // Read TCP fields and, device address and command ID and control them.
-        quint16 rxTransactionId , rxProtocolId, rxLength , rxStartingAddress , rxQuantityOfRegisters;
-        quint8 rxDeviceAddress , rxFunctionCode;
-        QDataStream rxStream( pdu );
-        rxStream.setByteOrder( QDataStream::BigEndian );
-        rxStream >> rxTransactionId >> rxProtocolId >> rxLength >> rxDeviceAddress >> rxFunctionCode
-                 >> rxStartingAddress >> rxQuantityOfRegisters;
-
-        // Control values of the fields.
-        if ( rxTransactionId == transactionId && rxProtocolId == 0 && rxLength == 6 &&
-             rxDeviceAddress == deviceAddress && rxFunctionCode == 0x10 && rxStartingAddress == startingAddress &&
-             rxQuantityOfRegisters == registersValues.count() )
-        {
-            // Ok, done.
-            if ( status ) *status = Ok;
-            return true;
-        }
-        else
-        {
-            if ( status ) *status = UnknownError;
-        }
-    }
-    else
-    {
-        // What was wrong ?
-        if ( pdu.size() == 9 )
-        {
-            if ( status ) *status = pdu[8];
-        }
-        else
-        {
-            if ( status ) *status = Timeout;
-        }
-    }
-
-    return false;
+    return core( *this ).writeMultipleRegisters( deviceAddress , startingAddress , registersValues , status );
 }
 
 bool QTcpModbus::maskWriteRegister( const quint8 deviceAddress , const quint16 referenceAddress ,
                                      const quint16 andMask , const quint16 orMask , quint8 *const status ) const
 {
-    // Are we connected ?
-    if ( !isConnected() )
-    {
-        if ( status ) *status = NoConnection;
-        return false;
-    }
-
-    // Create a transaction number.
-    quint16 transactionId = qrand();
-
-    // Create modbus mask write register pdu (Modbus uses Big Endian).
-    QByteArray pdu;
-    QDataStream pduStream( &pdu , QIODevice::WriteOnly );
-    pduStream.setByteOrder( QDataStream::BigEndian );
-    pduStream << transactionId << (quint16)0 << (quint16)8
-              << deviceAddress << (quint8)0x16 << referenceAddress << andMask << orMask;
-
-    // Clear the RX buffer before making the request.
-    _socket.readAll();
-
-    // Send the pdu.
-    _socket.write( pdu );
-
-    // Await response.
-    pdu.clear();
-    while ( pdu.size() < 14 )
-    {
-        if ( ( pdu.size() >= 9 && pdu[7] & 0x80 ) || !_socket.waitForReadyRead( _timeout ) ) break;
-        pdu += _socket.read( 14 - pdu.size() );
-    }
-
-    // Check data and return them on success.
-    if ( pdu.size() == 14 )
-    {
-        // Read TCP fields and, device address and command ID and control them.
-        quint16 rxTransactionId , rxProtocolId, rxLength , rxReferenceAddress , rxAndMask , rxOrMask;
-        quint8 rxDeviceAddress , rxFunctionCode;
-        QDataStream rxStream( pdu );
-        rxStream.setByteOrder( QDataStream::BigEndian );
-        rxStream >> rxTransactionId >> rxProtocolId >> rxLength >> rxDeviceAddress >> rxFunctionCode
-                 >> rxReferenceAddress >> rxAndMask >> rxOrMask;
-
-        // Control values of the fields.
-        if ( rxTransactionId == transactionId && rxProtocolId == 0 && rxLength == 8 &&
-             rxDeviceAddress == deviceAddress && rxFunctionCode == 0x16 &&
-             rxReferenceAddress == referenceAddress && rxAndMask == andMask && rxOrMask == orMask )
-        {
-            // Ok, done.
-            if ( status ) *status = Ok;
-            return true;
-        }
-        else
-        {
-            if ( status ) *status = UnknownError;
-        }
-    }
-    else
-    {
-        // What was wrong ?
-        if ( pdu.size() == 9 )
-        {
-            if ( status ) *status = pdu[8];
-        }
-        else
-        {
-            if ( status ) *status = Timeout;
-        }
-    }
-
-    return false;
+    return core( *this ).maskWriteRegister( deviceAddress , referenceAddress , andMask , orMask , status );
 }
 
-
 QList<quint16> QTcpModbus::writeReadMultipleRegisters( const quint8 deviceAddress ,
                                                         const quint16 writeStartingAddress ,
                                                         const QList<quint16> & writeValues ,
                                                         const quint16 readStartingAddress ,
                                                         const quint16 quantityToRead , quint8 *const status ) const
 {
-    // Are we connected ?
-    if ( !isConnected() )
-    {
-        if ( status ) *status = NoConnection;
-        return QList<quint16>();
-    }
-
-    // Create a transaction number.
-    quint16 transactionId = qrand();
-
-    // Create modbus read holding registers pdu (Modbus uses Big Endian).
-    QByteArray pdu;
-    QDataStream pduStream( &pdu , QIODevice::WriteOnly );
-    pduStream.setByteOrder( QDataStream::BigEndian );
-    pduStream << transactionId << (quint16)0 << (quint16)( writeValues.count() * 2 + 12 )
-              << deviceAddress << (quint8)0x17 << readStartingAddress << quantityToRead
-              << writeStartingAddress << (quint16)writeValues.count() << (quint16)( writeValues.count() * 2 );
-
-    // Add data.
-    foreach ( quint16 reg , writeValues )
-    {
-        pduStream << reg;
-    }
-
-    // Clear the RX buffer before making the request.
-    _socket.readAll();
-
-    // Send the pdu.
-    _socket.write( pdu );
-
-    // Await response.
-    quint16 neededRxBytes = quantityToRead * 2;
-    pdu.clear();
-    while ( pdu.size() < neededRxBytes + 9 )
-    {
-        if ( ( pdu.size() >= 9 && pdu[7] & 0x80 ) || !_socket.waitForReadyRead( _timeout ) ) break;
-        pdu += _socket.read( neededRxBytes + 9 - pdu.size() );
-    }
-
-    // Check data and return them on success.
-    if ( pdu.size() == neededRxBytes + 9 )
-    {
-        // Read TCP fields and, device address and command ID and control them.
-        quint16 rxTransactionId , rxProtocolId, rxLength;
-        quint8 rxDeviceAddress , rxFunctionCode , byteCount;
-        QDataStream rxStream( pdu );
-        rxStream.setByteOrder( QDataStream::BigEndian );
-        rxStream >> rxTransactionId >> rxProtocolId >> rxLength >> rxDeviceAddress >> rxFunctionCode >> byteCount;
-
-        // Control values of the fields.
-        if ( rxTransactionId == transactionId && rxProtocolId == 0 && rxLength == neededRxBytes + 3 &&
-             rxDeviceAddress == deviceAddress && rxFunctionCode == 0x17 && byteCount == neededRxBytes )
-        {
-            // Convert data.
-            QList<quint16> list;
-            quint16 tmp;
-            for ( int i = 0 ; i < quantityToRead ; i++ )
-            {
-                rxStream >> tmp;
-                list.append( tmp );
-            }
-            if ( status ) *status = Ok;
-            return list;
-        }
-        else
-        {
-            if ( status ) *status = UnknownError;
-        }
-    }
-    else
-    {
-        // What was wrong ?
-        if ( pdu.size() == 9 )
-        {
-            if ( status ) *status = pdu[8];
-        }
-        else
-        {
-            if ( status ) *status = Timeout;
-        }
-    }
-
-    return QList<quint16>();
+    return core( *this ).writeReadMultipleRegisters( deviceAddress , writeStartingAddress , writeValues ,
+                                                     readStartingAddress , quantityToRead , status );
 }
 
 QList<quint16> QTcpModbus::readFifoQueue( const quint8 deviceAddress , const quint16 fifoPointerAddress ,
                                            quint8 *const status ) const
 {
-    // Are we connected ?
-    if ( !isConnected() )
-    {
-        if ( status ) *status = NoConnection;
-        return QList<quint16>();
-    }
-
-    // Create a transaction number.
-    quint16 transactionId = qrand();
-
-    // Create modbus read FIFO registers pdu (Modbus uses Big Endian).
-    QByteArray pdu;
-    QDataStream pduStream( &pdu , QIODevice::WriteOnly );
-    pduStream.setByteOrder( QDataStream::BigEndian );
-    pduStream << transactionId << (quint16)0 << (quint16)4
-              << deviceAddress << (quint8)0x18 << fifoPointerAddress;
-
-    // Clear the RX buffer before making the request.
-    _socket.readAll();
-
-    // Send the pdu.
-    _socket.write( pdu );
-
-    // Await response.
-    pdu.clear();
-    if ( !_socket.waitForReadyRead( _timeout ) )
-    {
-        if ( status ) *status = Timeout;
-        return QList<quint16>();
-    }
-    pdu = _socket.readAll();
-
-    // Check data and return them on success.
-    if ( pdu.size() >= 12 && !( pdu[7] & 0x80 ) )
-    {
-        // Read TCP fields and, device address and command ID and control them.
-        quint16 rxTransactionId , rxProtocolId, rxLength , byteCount , fifoCount;
-        quint8 rxDeviceAddress , rxFunctionCode;
-        QDataStream rxStream( pdu );
-        rxStream.setByteOrder( QDataStream::BigEndian );
-        rxStream >> rxTransactionId >> rxProtocolId >> rxLength >> rxDeviceAddress >> rxFunctionCode
-                 >> byteCount >> fifoCount;
-
-        // Control values of the fields.
-        if ( rxTransactionId == transactionId && rxProtocolId == 0 && rxLength == byteCount - 2 &&
-             rxDeviceAddress == deviceAddress && rxFunctionCode == 0x18 && byteCount == fifoCount * 2 &&
-             pdu.size() == rxLength + 6 )
-        {
-            // Convert data.
-            QList<quint16> list;
-            quint16 tmp;
-            for ( int i = 0 ; i < fifoCount ; i++ )
-            {
-                rxStream >> tmp;
-                list.append( tmp );
-            }
-            if ( status ) *status = Ok;
-            return list;
-        }
-        else
-        {
-            if ( status ) *status = UnknownError;
-        }
-    }
-    else
-    {
-        // What was wrong ?
-        if ( pdu.size() == 9 )
-        {
-            if ( status ) *status = pdu[8];
-        }
-        else
-        {
-            if ( status ) *status = Timeout;
-        }
-    }
-
-    return QList<quint16>();
+    return core( *this ).readFifoQueue( deviceAddress , fifoPointerAddress , status );
 }
 
 QByteArray QTcpModbus::executeCustomFunction( const quint8 deviceAddress , const quint8 modbusFunction ,
                                                QByteArray &data , quint8 *const status ) const
 {
-    // Are we connected ?
-    if ( !isConnected() )
-    {
-        if ( status ) *status = NoConnection;
-        return QByteArray();
-    }
-
-    // Create a transaction number.
-    quint16 transactionId = qrand();
-
-    // Create modbus pdu (Modbus uses Big Endian).
-    QByteArray pdu;
-    QDataStream pduStream( &pdu , QIODevice::WriteOnly );
-    pduStream.setByteOrder( QDataStream::BigEndian );
-    pduStream << transactionId << (quint16)0 << (quint16)( data.size() + 2 )
-              << deviceAddress << modbusFunction;
-    pdu += data;
-
-    // Clear the RX buffer before making the request.
-    _socket.readAll();
-
-    // Send the pdu.
-    _socket.write( pdu );
-
-    // Await response.
-    pdu.clear();
-    if ( !_socket.waitForReadyRead( _timeout ) )
-    {
-        if ( status ) *status = Timeout;
-        return QByteArray();
-    }
-    pdu = _socket.readAll();
-
-    // Check data and return them on success.
-    if ( pdu.size() >= 9 && !( pdu[7] & 0x80 ) )
-    {
-        // Read TCP fields and, device address and command ID and control them.
-        quint16 rxTransactionId , rxProtocolId, rxLength;
-        quint8 rxDeviceAddress , rxFunctionCode;
-        QDataStream rxStream( pdu );
-        rxStream.setByteOrder( QDataStream::BigEndian );
-        rxStream >> rxTransactionId >> rxProtocolId >> rxLength >> rxDeviceAddress >> rxFunctionCode;
+    return core( *this ).executeCustomFunction( deviceAddress , modbusFunction , data , status );
+}
 
-        // Control values of the fields.
-        if ( rxTransactionId == transactionId && rxProtocolId == 0 && rxDeviceAddress == deviceAddress &&
-             rxFunctionCode == modbusFunction && pdu.size() == rxLength + 6 )
-        {
-            // Convert data.
-            return pdu.right( pdu.size() - 8 );
-        }
-        else
-        {
-            if ( status ) *status = UnknownError;
-        }
-    }
-    else
-    {
-        // What was wrong ?
-        if ( pdu.size() == 9 )
-        {
-            if ( status ) *status = pdu[8];
-        }
-        else
-        {
-            if ( status ) *status = Timeout;
-        }
-    }
+bool QTcpModbus::executePdu( const quint8 deviceAddress , const QModbusFrameView &request , QModbusPduFrame &response ,
+                             quint8 *const status ) const
+{
+    return core( *this ).executePdu( deviceAddress , request , response , status );
+}
 
-    return QByteArray();
+QList<QModbusResponse> QTcpModbus::execute( const QList<QModbusRequest> &batch ) const
+{
+    return core( *this ).execute( batch );
 }
 
 QByteArray QTcpModbus::executeRaw( QByteArray &data , quint8 *const status ) const
@@ -1067,3 +326,31 @@ QByteArray QTcpModbus::calculateCheckSum( QByteArray &data ) const
     Q_UNUSED( data );
     return QByteArray();
 }
+
+void QTcpModbus::_socketConnected( void )
+{
+    if ( !_connecting ) return;
+    _connecting = false;
+    _connectTimer.stop();
+    emit connected();
+}
+
+void QTcpModbus::_socketError( QAbstractSocket::SocketError error )
+{
+    // Errors of an established connection are reported by connectionLost().
+    Q_UNUSED( error );
+    if ( _connecting ) _failConnect();
+}
+
+void QTcpModbus::_connectTimedOut( void )
+{
+    if ( _connecting ) _failConnect();
+}
+
+void QTcpModbus::_failConnect( void )
+{
+    _connecting = false;
+    _connectTimer.stop();
+    _socket.abort();
+    emit connectFailed();
+}
@@ -0,0 +1,551 @@
+/***********************************************************************************************************************
+* SimulatedModbus : Thread-safe simulation of modbus devices behind one connection, used by the behaviour tests.      *
+************************************************************************************************************************
+* Author : QModbus contributors                                                                                        *
+* Date   : 2026/10/18                                                                                                  *
+* Changes: -                                                                                                           *
+***********************************************************************************************************************/
+#pragma once
+
+
+/*** Base classes *****************************************************************************************************/
+#include <QAbstractModbus>
+
+
+/*** Qt includes ******************************************************************************************************/
+#include <QModbusRequest>
+#include <QtCore/QAtomicInt>
+#include <QtCore/QHash>
+#include <QtCore/QList>
+#include <QtCore/QMap>
+#include <QtCore/QMutex>
+#include <QtCore/QMutexLocker>
+#include <QtCore/QSet>
+#include <QtCore/QStringList>
+#include <QtCore/QThread>
+#include <QtCore/QWaitCondition>
+
+
+/*** Helpers **********************************************************************************************************/
+// QThread::msleep() is protected with Qt 4.
+class TestSleep : public QThread
+{
+public:
+    static void pause( const unsigned long msecs ) { msleep( msecs ); }
+};
+
+
+/*** SimulatedModbus class ********************************************************************************************/
+/*
+* Answers all modbus functions from register and coil maps, any thread may use it concurrently. Every call goes through
+* transact(), which logs the request as "<function> <device> <address>", waits for the latency, and fails the request
+* if a scripted status or an error of the device applies. Like the transports, it does not send a request that was
+* cancelled or expired and stops waiting for it once it is cancelled or expires. Holding registers and coils are
+* read/write, input registers and discrete inputs read the same maps. A gate can hold all calls until the test opens it
+* again.
+*/
+class SimulatedModbus : public QAbstractModbus
+{
+public:
+    SimulatedModbus( void ) : _open( 1 ) , _timeout( 1000 ) , _latency( 0 ) , _active( 0 ) , _maximumActive( 0 ) ,
+                              _held( 0 ) , _gate( false ) , _passes( 0 ) , _registerCount( 0x10000 ) ,
+                              _maximumQuantity( 0 ) , _timeoutThread( NULL )
+    {}
+
+    // Configuration, may be changed while calls are in progress.
+    void setOpen( const bool open ) { _open.fetchAndStoreOrdered( open ? 1 : 0 ); }
+    void setLatency( const int msecs ) { _latency.fetchAndStoreOrdered( msecs ); }
+
+    // Requests to a silent device time out after the latency.
+    void setSilent( const quint8 deviceAddress , const bool silent = true )
+    {
+        QMutexLocker locker( &_mutex );
+        if ( silent ) _silent.insert( deviceAddress );
+        else _silent.remove( deviceAddress );
+    }
+
+    // Function codes answered with IllegalFunction.
+    void setUnsupported( const quint8 functionCode )
+    {
+        QMutexLocker locker( &_mutex );
+        _unsupported.insert( functionCode );
+    }
+
+    // Registers and coils beyond the count fail with IllegalDataAddress.
+    void setRegisterCount( const int count )
+    {
+        QMutexLocker locker( &_mutex );
+        _registerCount = count;
+    }
+
+    // Writes to a read-only holding register succeed but leave its value, like a device clamping a value.
+    void setReadOnly( const quint8 deviceAddress , const quint16 address )
+    {
+        QMutexLocker locker( &_mutex );
+        _readOnly.insert( key( deviceAddress , address ) );
+    }
+
+    // Reads of more than the quantity fail with IllegalDataValue, 0 for the limits of the specification.
+    void setMaximumQuantity( const int quantity )
+    {
+        QMutexLocker locker( &_mutex );
+        _maximumQuantity = quantity;
+    }
+
+    // The next calls fail with the given status, one status per call.
+    void failNext( const quint8 status , const int count = 1 )
+    {
+        QMutexLocker locker( &_mutex );
+        for ( int i = 0 ; i < count ; i++ ) _script.append( status );
+    }
+
+    // Holds the calls until the gate is opened, heldCount() tells how many wait. pass() lets calls through one by one.
+    void closeGate( void )
+    {
+        QMutexLocker locker( &_mutex );
+        _gate = true;
+        _passes = 0;
+    }
+
+    void openGate( void )
+    {
+        QMutexLocker locker( &_mutex );
+        _gate = false;
+        _gateOpened.wakeAll();
+    }
+
+    void pass( const int count = 1 )
+    {
+        QMutexLocker locker( &_mutex );
+        _passes += count;
+        _gateOpened.wakeAll();
+    }
+
+    int heldCount( void ) const
+    {
+        QMutexLocker locker( &_mutex );
+        return _held;
+    }
+
+    // Waits until the given number of calls is held at the gate, false if that did not happen within 5 seconds.
+    bool waitForHeld( const int count ) const
+    {
+        for ( int i = 0 ; i < 5000 && heldCount() != count ; i++ ) TestSleep::pause( 1 );
+        return heldCount() == count;
+    }
+
+    // Waits until the given number of calls was made, false if that did not happen within 5 seconds.
+    bool waitForCalls( const int count ) const
+    {
+        for ( int i = 0 ; i < 5000 && callCount() < count ; i++ ) TestSleep::pause( 1 );
+        return callCount() >= count;
+    }
+
+    // Register and coil values.
+    void setRegister( const quint8 deviceAddress , const quint16 address , const quint16 value )
+    {
+        QMutexLocker locker( &_mutex );
+        _registers.insert( key( deviceAddress , address ) , value );
+    }
+
+    quint16 registerValue( const quint8 deviceAddress , const quint16 address ) const
+    {
+        QMutexLocker locker( &_mutex );
+        return _registers.value( key( deviceAddress , address ) );
+    }
+
+    void setCoil( const quint8 deviceAddress , const quint16 address , const bool value )
+    {
+        QMutexLocker locker( &_mutex );
+        _coils.insert( key( deviceAddress , address ) , value );
+    }
+
+    bool coil( const quint8 deviceAddress , const quint16 address ) const
+    {
+        QMutexLocker locker( &_mutex );
+        return _coils.value( key( deviceAddress , address ) );
+    }
+
+    // Calls made so far, in order, as "<function> <device> <address>".
+    QStringList log( void ) const
+    {
+        QMutexLocker locker( &_mutex );
+        return _log;
+    }
+
+    int callCount( void ) const
+    {
+        QMutexLocker locker( &_mutex );
+        return _log.count();
+    }
+
+    void clearLog( void )
+    {
+        QMutexLocker locker( &_mutex );
+        _log.clear();
+        _threads.clear();
+    }
+
+    // Threads the calls were made from and the most calls that were in progress at the same time.
+    QSet<QThread *> threads( void ) const
+    {
+        QMutexLocker locker( &_mutex );
+        return _threads;
+    }
+
+    int maximumActive( void ) const { return _maximumActive.fetchAndAddOrdered( 0 ); }
+
+    // Thread that called setTimeout() last.
+    QThread *timeoutThread( void ) const
+    {
+        QMutexLocker locker( &_mutex );
+        return _timeoutThread;
+    }
+
+    static quint32 key( const quint8 deviceAddress , const quint16 address )
+    {
+        return ( (quint32)deviceAddress << 16 ) | address;
+    }
+
+    // Executes a request.
+    QModbusResponse transact( const QModbusRequest &request ) const
+    {
+        if ( request.limitStatus() != Ok ) return QModbusResponse( request.limitStatus() );
+        const QModbusFrameView pdu = request.pdu();
+        const quint8 device = request.deviceAddress();
+        const quint8 function = request.functionCode();
+        const quint16 address = pdu.size() >= 3 ? pdu.value( 1 ) : 0;
+
+        // Count the calls in progress and wait at the gate.
+        const int active = _active.fetchAndAddOrdered( 1 ) + 1;
+        for ( int maximum = _maximumActive.fetchAndAddOrdered( 0 ) ; active > maximum ;
+              maximum = _maximumActive.fetchAndAddOrdered( 0 ) )
+        {
+            if ( _maximumActive.testAndSetOrdered( maximum , active ) ) break;
+        }
+        quint8 status = Ok;
+        {
+            QMutexLocker locker( &_mutex );
+            _log.append( QString( "%1 %2 %3" ).arg( function ).arg( device ).arg( address ) );
+            _threads.insert( QThread::currentThread() );
+            _held++;
+            while ( _gate && !_passes ) _gateOpened.wait( &_mutex );
+            if ( _gate ) _passes--;
+            _held--;
+            if ( !_script.isEmpty() ) status = _script.takeFirst();
+            else if ( _silent.contains( device ) ) status = Timeout;
+        }
+        const int latency = _latency.fetchAndAddOrdered( 0 );
+        quint8 limit = Ok;
+        for ( int i = 0 ; i < latency && limit == Ok ; i++ )
+        {
+            TestSleep::pause( 1 );
+            limit = request.limitStatus();
+        }
+        if ( limit != Ok ) status = limit;
+
+        QModbusResponse response( status );
+        if ( status == Ok )
+        {
+            QMutexLocker locker( &_mutex );
+            if ( !_open.fetchAndAddOrdered( 0 ) ) response = QModbusResponse( NoConnection );
+            else response = _respond( device , pdu );
+        }
+        _active.fetchAndAddOrdered( -1 );
+        return response;
+    }
+
+    // Interface implementation (QAbstractModbus).
+    bool isOpen() const
+    {
+        return _open.fetchAndAddOrdered( 0 );
+    }
+
+    unsigned int timeout( void ) const
+    {
+        return (unsigned int)_timeout.fetchAndAddOrdered( 0 );
+    }
+
+    void setTimeout( const unsigned int timeout )
+    {
+        QMutexLocker locker( &_mutex );
+        _timeout.fetchAndStoreOrdered( (int)timeout );
+        _timeoutThread = QThread::currentThread();
+    }
+
+    QList<bool> readCoils( const quint8 deviceAddress , const quint16 startingAddress , const quint16 quantityOfCoils ,
+                           quint8 *const status = NULL ) const
+    {
+        return _result( transact( QModbusRequest::readCoils( deviceAddress , startingAddress , quantityOfCoils ) ) ,
+                        status ).bits( quantityOfCoils );
+    }
+
+    QList<bool> readDiscreteInputs( const quint8 deviceAddress , const quint16 startingAddress ,
+                                    const quint16 quantityOfInputs , quint8 *const status = NULL ) const
+    {
+        return _result( transact( QModbusRequest::readDiscreteInputs( deviceAddress , startingAddress ,
+                                                                      quantityOfInputs ) ) , status )
+               .bits( quantityOfInputs );
+    }
+
+    QList<quint16> readHoldingRegisters( const quint8 deviceAddress , const quint16 startingAddress ,
+                                         const quint16 quantityOfRegisters , quint8 *const status = NULL ) const
+    {
+        return _result( transact( QModbusRequest::readHoldingRegisters( deviceAddress , startingAddress ,
+                                                                        quantityOfRegisters ) ) , status )
+               .registers();
+    }
+
+    QList<quint16> readInputRegisters( const quint8 deviceAddress , const quint16 startingAddress ,
+                                       const quint16 quantityOfInputRegisters , quint8 *const status = NULL ) const
+    {
+        return _result( transact( QModbusRequest::readInputRegisters( deviceAddress , startingAddress ,
+                                                                      quantityOfInputRegisters ) ) , status )
+               .registers();
+    }
+
+    bool writeSingleCoil( const quint8 deviceAddress , const quint16 outputAddress , const bool outputValue ,
+                          quint8 *const status = NULL ) const
+    {
+        return _result( transact( QModbusRequest::writeSingleCoil( deviceAddress , outputAddress , outputValue ) ) ,
+                        status ).isOk();
+    }
+
+    bool writeSingleRegister( const quint8 deviceAddress , const quint16 registerAddress ,
+                              const quint16 registerValue , quint8 *const status = NULL ) const
+    {
+        return _result( transact( QModbusRequest::writeSingleRegister( deviceAddress , registerAddress ,
+                                                                       registerValue ) ) , status ).isOk();
+    }
+
+    bool writeMultipleCoils( const quint8 deviceAddress , const quint16 startingAddress ,
+                             const QList<bool> &outputValues , quint8 *const status = NULL ) const
+    {
+        return _result( transact( QModbusRequest::writeMultipleCoils( deviceAddress , startingAddress ,
+                                                                      outputValues ) ) , status ).isOk();
+    }
+
+    bool writeMultipleRegisters( const quint8 deviceAddress , const quint16 startingAddress ,
+                                 const QList<quint16> &registersValues , quint8 *const status = NULL ) const
+    {
+        return _result( transact( QModbusRequest::writeMultipleRegisters( deviceAddress , startingAddress ,
+                                                                          registersValues ) ) , status ).isOk();
+    }
+
+    bool maskWriteRegister( const quint8 deviceAddress , const quint16 referenceAddress , const quint16 andMask ,
+                            const quint16 orMask , quint8 *const status = NULL ) const
+    {
+        return _result( transact( QModbusRequest::maskWriteRegister( deviceAddress , referenceAddress , andMask ,
+                                                                     orMask ) ) , status ).isOk();
+    }
+
+    QList<quint16> writeReadMultipleRegisters( const quint8 deviceAddress , const quint16 writeStartingAddress ,
+                                               const QList<quint16> &writeValues ,
+                                               const quint16 readStartingAddress , const quint16 quantityToRead ,
+                                               quint8 *const status = NULL ) const
+    {
+        return _result( transact( QModbusRequest::writeReadMultipleRegisters( deviceAddress , writeStartingAddress ,
+                                                                              writeValues , readStartingAddress ,
+                                                                              quantityToRead ) ) , status )
+               .registers();
+    }
+
+    QList<quint16> readFifoQueue( const quint8 deviceAddress , const quint16 fifoPointerAddress ,
+                                  quint8 *const status = NULL ) const
+    {
+        return _result( transact( QModbusRequest::readFifoQueue( deviceAddress , fifoPointerAddress ) ) , status )
+               .fifoQueue();
+    }
+
+    QByteArray executeCustomFunction( const quint8 deviceAddress , const quint8 modbusFunction , QByteArray &data ,
+                                      quint8 *const status = NULL ) const
+    {
+        const QByteArray pdu = QByteArray( 1 , (char)modbusFunction ) + data;
+        const QModbusResponse response = _result( transact( QModbusRequest( deviceAddress ,
+                                                                            QModbusFrameView( pdu ) ) ) , status );
+        return response.isOk() ? response.pdu().mid( 1 ).toByteArray() : QByteArray();
+    }
+
+    QList<QModbusResponse> execute( const QList<QModbusRequest> &batch ) const
+    {
+        QList<QModbusResponse> responses;
+        foreach ( const QModbusRequest &request , batch ) responses.append( transact( request ) );
+        return responses;
+    }
+
+    QByteArray executeRaw( QByteArray &data , quint8 *const status = NULL ) const
+    {
+        Q_UNUSED( data );
+        if ( status ) *status = IllegalFunction;
+        return QByteArray();
+    }
+
+    QByteArray calculateCheckSum( QByteArray &data ) const
+    {
+        Q_UNUSED( data );
+        return QByteArray();
+    }
+
+private:
+    // Reports the status of a response.
+    static const QModbusResponse &_result( const QModbusResponse &response , quint8 *const status )
+    {
+        if ( status ) *status = response.status();
+        return response;
+    }
+
+    // Appends a 16 bit value, big endian.
+    static void _append( QByteArray &pdu , const quint16 value )
+    {
+        pdu.append( (char)( value >> 8 ) );
+        pdu.append( (char)( value & 0xFF ) );
+    }
+
+    // Stores a register value written by a request, the mutex is locked.
+    void _write( const quint8 device , const quint16 address , const quint16 value ) const
+    {
+        if ( !_readOnly.contains( key( device , address ) ) ) _registers.insert( key( device , address ) , value );
+    }
+
+    // Answers a request the way a device does, the mutex is locked.
+    QModbusResponse _respond( const quint8 device , const QModbusFrameView &request ) const
+    {
+        const quint8 function = request.at( 0 );
+        if ( _unsupported.contains( function ) ) return QModbusResponse( IllegalFunction );
+
+        QByteArray pdu( 1 , (char)function );
+        switch( function )
+        {
+            case 0x01:
+            case 0x02:
+            case 0x03:
+            case 0x04:
+            {
+                const quint16 start = request.value( 1 );
+                const quint16 quantity = request.value( 3 );
+                const bool bits = function <= 0x02;
+                if ( !quantity || ( _maximumQuantity && quantity > _maximumQuantity ) ||
+                     quantity > ( bits ? 2000 : 125 ) ) return QModbusResponse( IllegalDataValue );
+                if ( start + quantity > _registerCount ) return QModbusResponse( IllegalDataAddress );
+                if ( bits )
+                {
+                    QByteArray data( ( quantity + 7 ) / 8 , 0 );
+                    for ( int i = 0 ; i < quantity ; i++ )
+                    {
+                        if ( !_coils.value( key( device , start + i ) ) ) continue;
+                        data[i / 8] = (char)( data.at( i / 8 ) | 1 << i % 8 );
+                    }
+                    pdu.append( (char)data.size() );
+                    pdu.append( data );
+                }
+                else
+                {
+                    pdu.append( (char)( quantity * 2 ) );
+                    for ( int i = 0 ; i < quantity ; i++ )
+                    {
+                        _append( pdu , _registers.value( key( device , start + i ) ) );
+                    }
+                }
+                break;
+            }
+
+            case 0x05:
+            case 0x06:
+                if ( request.value( 1 ) >= _registerCount ) return QModbusResponse( IllegalDataAddress );
+                if ( function == 0x05 ) _coils.insert( key( device , request.value( 1 ) ) , request.at( 3 ) == 0xFF );
+                else _write( device , request.value( 1 ) , request.value( 3 ) );
+                pdu = request.toByteArray();
+                break;
+
+            case 0x0F:
+            case 0x10:
+            {
+                const quint16 start = request.value( 1 );
+                const quint16 quantity = request.value( 3 );
+                if ( start + quantity > _registerCount ) return QModbusResponse( IllegalDataAddress );
+                for ( int i = 0 ; i < quantity ; i++ )
+                {
+                    const quint32 address = key( device , start + i );
+                    if ( function == 0x0F ) _coils.insert( address , request.at( 6 + i / 8 ) >> i % 8 & 1 );
+                    else _write( device , start + i , request.value( 6 + 2 * i ) );
+                }
+                pdu = request.mid( 0 , 5 ).toByteArray();
+                break;
+            }
+
+            case 0x16:
+            {
+                // Result = ( Current AND And_Mask ) OR ( Or_Mask AND ( NOT And_Mask ) ).
+                const quint16 address = request.value( 1 );
+                const quint16 andMask = request.value( 3 );
+                _write( device , address , ( _registers.value( key( device , address ) ) & andMask ) |
+                                           ( request.value( 5 ) & ~andMask ) );
+                pdu = request.toByteArray();
+                break;
+            }
+
+            case 0x17:
+            {
+                // The write is performed before the read.
+                const quint16 readStart = request.value( 1 );
+                const quint16 readQuantity = request.value( 3 );
+                const quint16 writeStart = request.value( 5 );
+                const quint16 writeQuantity = request.value( 7 );
+                if ( readStart + readQuantity > _registerCount || writeStart + writeQuantity > _registerCount )
+                {
+                    return QModbusResponse( IllegalDataAddress );
+                }
+                for ( int i = 0 ; i < writeQuantity ; i++ )
+                {
+                    _write( device , writeStart + i , request.value( 10 + 2 * i ) );
+                }
+                pdu.append( (char)( readQuantity * 2 ) );
+                for ( int i = 0 ; i < readQuantity ; i++ )
+                {
+                    _append( pdu , _registers.value( key( device , readStart + i ) ) );
+                }
+                break;
+            }
+
+            case 0x18:
+            {
+                // The FIFO count is in the pointer register, the queue follows it.
+                const quint16 pointer = request.value( 1 );
+                const quint16 count = qMin( _registers.value( key( device , pointer ) ) , (quint16)31 );
+                _append( pdu , 2 + 2 * count );
+                _append( pdu , count );
+                for ( int i = 0 ; i < count ; i++ )
+                {
+                    _append( pdu , _registers.value( key( device , pointer + 1 + i ) ) );
+                }
+                break;
+            }
+
+            default:
+                return QModbusResponse( IllegalFunction );
+        }
+        return QModbusResponse( Ok , QModbusFrameView( pdu ) );
+    }
+
+    mutable QMutex _mutex;                      // Protects the members below but the atomics.
+    mutable QWaitCondition _gateOpened;         // Wakes up the calls held at the gate.
+    mutable QAtomicInt _open;                   // 1 if the connection is open.
+    mutable QAtomicInt _timeout;                // Timeout in milliseconds.
+    mutable QAtomicInt _latency;                // Time each call takes in milliseconds.
+    mutable QAtomicInt _active;                 // Calls in progress.
+    mutable QAtomicInt _maximumActive;          // Most calls in progress at the same time.
+    mutable int _held;                          // Calls waiting at the gate.
+    bool _gate;                                 // True while the calls are held.
+    mutable int _passes;                        // Calls let through the closed gate.
+    int _registerCount;                         // Number of registers and coils of each device.
+    int _maximumQuantity;                       // Largest quantity a read may have, 0 for the specification limits.
+    QSet<quint8> _silent;                       // Devices that never answer.
+    QSet<quint8> _unsupported;                  // Function codes answered with IllegalFunction.
+    mutable QList<quint8> _script;              // Statuses of the next calls.
+    mutable QMap<quint32,quint16> _registers;   // Register values by device and address.
+    mutable QMap<quint32,bool> _coils;          // Coil values by device and address.
+    QSet<quint32> _readOnly;                    // Holding registers ignoring writes, by device and address.
+    mutable QStringList _log;                   // Calls made, in order.
+    mutable QSet<QThread *> _threads;           // Threads the calls were made from.
+    QThread *_timeoutThread;                    // Thread that called setTimeout() last.
+};
@@ -0,0 +1,12 @@
+########################################################################################################################
+# tst_qmodbusbatch : Batches of mixed requests through the RTU and TCP framings and the default implementation.        #
+########################################################################################################################
+# Author ........: QModbus contributors                                                                                #
+# Changes .......: -                                                                                                   #
+########################################################################################################################
+
+
+# FILES ################################################################################################################
+include( ../tests.pri )
+TARGET          = tst_qmodbusbatch
+SOURCES        +=   tst_qmodbusbatch.cpp
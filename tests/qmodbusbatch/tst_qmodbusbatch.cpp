@@ -0,0 +1,282 @@
+/***********************************************************************************************************************
+* tst_qmodbusbatch : Batches of mixed requests through the RTU and TCP framings and the default implementation.        *
+************************************************************************************************************************
+* Author : QModbus contributors                                                                                        *
+* Date   : 2026/10/18                                                                                                  *
+* Changes: -                                                                                                           *
+***********************************************************************************************************************/
+
+
+/*** Qt includes ******************************************************************************************************/
+#include <QModbusFraming>
+#include <QtTest/QtTest>
+
+
+/*** Test includes ****************************************************************************************************/
+#include "simulatedmodbus.h"
+
+
+/*** System includes **************************************************************************************************/
+#include <string.h>
+
+
+/*** Helpers **********************************************************************************************************/
+// I/O policy of the framings wired to a simulated device: every frame written is answered at once, the replies wait
+// in the receive buffer. Reads never wait, an empty buffer is a timeout.
+class Wire
+{
+public:
+    enum Mode
+    {
+        Rtu ,                       // One RTU frame per write.
+        Tcp                         // Any number of TCP frames per write.
+    };
+
+    Wire( const Mode mode , const SimulatedModbus &device ) : writes( 0 ) , reversed( false ) , corrupt( false ) ,
+                                                              open( true ) , _mode( mode ) , _device( device ) {}
+
+    bool isOpen( void ) const { return open; }
+    void discard( void ) const { received.clear(); }
+    void limit( const QModbusDeadline & , const QModbusCancellationToken & ) const {}
+    int readAll( char *const data , const int maxSize ) const { return read( data , maxSize ); }
+    int readLine( char *const , const int ) const { return 0; }
+
+    int read( char *const data , const int size ) const
+    {
+        const int count = qMin( size , received.size() );
+        memcpy( data , received.constData() , count );
+        received.remove( 0 , count );
+        return count;
+    }
+
+    bool write( const char *const data , const int size ) const
+    {
+        writes++;
+        QByteArray replies;
+        for ( int i = 0 ; i < size ; )
+        {
+            const int length = _mode == Rtu ? size : 6 + QModbusPdu::get( data + i + 4 );
+            const QByteArray reply = _answer( QByteArray( data + i , length ) );
+            replies = reversed ? reply + replies : replies + reply;
+            i += length;
+        }
+        received += replies;
+        return true;
+    }
+
+    mutable QByteArray received;    // Replies not read yet.
+    mutable int writes;             // Number of writes.
+    bool reversed;                  // The replies to the frames of a write are sent in reverse order.
+    bool corrupt;                   // The TCP replies have a wrong protocol identifier.
+    bool open;                      // Connection state.
+
+private:
+    // Returns the reply of the device to an ADU, empty if the device is silent.
+    QByteArray _answer( const QByteArray &adu ) const
+    {
+        const bool rtu = _mode == Rtu;
+        const quint8 unit = adu.at( rtu ? 0 : 6 );
+        const QByteArray pdu = rtu ? adu.mid( 1 , adu.size() - 3 ) : adu.mid( 7 );
+        const QModbusResponse response =
+            _device.execute( QList<QModbusRequest>() << QModbusRequest( unit , QModbusFrameView( pdu ) ) ).value( 0 );
+        if ( response.status() == QAbstractModbus::Timeout ) return QByteArray();
+
+        QByteArray reply = response.pdu().toByteArray();
+        if ( !response.isOk() )
+        {
+            reply = QByteArray( 1 , (char)( pdu.at( 0 ) | 0x80 ) );
+            reply.append( (char)response.status() );
+        }
+        QByteArray frame( reply.size() + 7 , 0 );
+        if ( rtu )
+        {
+            frame.resize( QModbusRtuFraming::encode( frame.data() , unit , reply.constData() , reply.size() ) );
+        }
+        else
+        {
+            frame.resize( QModbusTcpFraming::encode( frame.data() , QModbusPdu::get( adu.constData() ) , unit ,
+                                                     reply.constData() , reply.size() ) );
+            if ( corrupt ) frame[3] = 1;
+        }
+        return frame;
+    }
+
+    Mode _mode;                     // Framing.
+    const SimulatedModbus &_device; // Device answering.
+};
+
+// Returns a batch of mixed requests, see checkMixed().
+static QList<QModbusRequest> mixed( SimulatedModbus &device )
+{
+    device.setRegister( 1 , 0 , 0x1111 );
+    device.setRegister( 1 , 1 , 0x2222 );
+    device.setRegister( 1 , 100 , 2 );
+    device.setRegister( 1 , 101 , 11 );
+    device.setRegister( 1 , 102 , 12 );
+    device.setSilent( 2 );
+    device.setUnsupported( 0x04 );
+    return QList<QModbusRequest>() << QModbusRequest::readHoldingRegisters( 1 , 0 , 2 )
+                                   << QModbusRequest::writeSingleRegister( 1 , 5 , 7 )
+                                   << QModbusRequest::maskWriteRegister( 1 , 5 , 0x00F0 , 0x0003 )
+                                   << QModbusRequest::writeMultipleCoils( 1 , 0 , QList<bool>() << true << false
+                                                                          << true )
+                                   << QModbusRequest()
+                                   << QModbusRequest::writeReadMultipleRegisters( 1 , 10 , QList<quint16>() << 1 << 2
+                                                                                  << 3 , 5 , 1 )
+                                   << QModbusRequest::readCoils( 1 , 0 , 3 )
+                                   << QModbusRequest::readFifoQueue( 1 , 100 )
+                                   << QModbusRequest::readHoldingRegisters( 2 , 0 , 1 )
+                                   << QModbusRequest::readInputRegisters( 1 , 0 , 1 );
+}
+
+// Checks the responses to mixed(): one per request, in order, each with its own status.
+static bool checkMixed( const SimulatedModbus &device , const QList<QModbusResponse> &responses )
+{
+    if ( responses.count() != 10 ) return false;
+    QList<quint8> statuses;
+    foreach ( const QModbusResponse &response , responses ) statuses.append( response.status() );
+    return statuses == QList<quint8>() << QAbstractModbus::Ok << QAbstractModbus::Ok << QAbstractModbus::Ok
+                                       << QAbstractModbus::Ok << QAbstractModbus::IllegalDataValue
+                                       << QAbstractModbus::Ok << QAbstractModbus::Ok << QAbstractModbus::Ok
+                                       << QAbstractModbus::Timeout << QAbstractModbus::IllegalFunction &&
+           responses.at( 0 ).registers() == QList<quint16>() << 0x1111 << 0x2222 &&
+           responses.at( 5 ).registers() == QList<quint16>() << 3 &&
+           responses.at( 6 ).bits( 3 ) == QList<bool>() << true << false << true &&
+           responses.at( 7 ).fifoQueue() == QList<quint16>() << 11 << 12 &&
+           device.registerValue( 1 , 12 ) == 3 &&
+           device.log() == QStringList() << "3 1 0" << "6 1 5" << "22 1 5" << "15 1 0" << "23 1 5" << "1 1 0"
+                                         << "24 1 100" << "3 2 0" << "4 1 0";
+}
+
+// Returns count reads of holding register i of unit 1, the first one to unit 2.
+static QList<QModbusRequest> reads( const int count )
+{
+    QList<QModbusRequest> batch;
+    batch.append( QModbusRequest::readHoldingRegisters( 2 , 0 , 1 ) );
+    for ( int i = 1 ; i < count ; i++ ) batch.append( QModbusRequest::readHoldingRegisters( 1 , (quint16)i , 1 ) );
+    return batch;
+}
+
+// Returns the number of responses with the given status.
+static int count( const QList<QModbusResponse> &responses , const quint8 status )
+{
+    int count = 0;
+    foreach ( const QModbusResponse &response , responses ) if ( response.status() == status ) count++;
+    return count;
+}
+
+
+/*** Test class *******************************************************************************************************/
+class TestQModbusBatch : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void defaultImplementation( void );
+    void rtu( void );
+    void tcpPipelined( void );
+    void tcpWindows( void );
+    void tcpTimeoutKeepsBatch( void );
+    void tcpMalformedReply( void );
+    void tcpConnectionLost( void );
+};
+
+void TestQModbusBatch::defaultImplementation( void )
+{
+    // The default implementation executes one request after the other through executePdu().
+    SimulatedModbus device;
+    const QList<QModbusRequest> batch = mixed( device );
+    const QAbstractModbus &modbus = device;
+    QVERIFY( checkMixed( device , modbus.QAbstractModbus::execute( batch ) ) );
+}
+
+void TestQModbusBatch::rtu( void )
+{
+    SimulatedModbus device;
+    const QList<QModbusRequest> batch = mixed( device );
+    const Wire wire( Wire::Rtu , device );
+    QList<QModbusResponse> responses;
+    QModbusRtuFraming().transact( wire , batch , responses );
+    QVERIFY( checkMixed( device , responses ) );
+
+    // The bus has one transaction at a time: one frame per write, the invalid request is not sent.
+    QCOMPARE( wire.writes , 9 );
+}
+
+void TestQModbusBatch::tcpPipelined( void )
+{
+    SimulatedModbus device;
+    const QList<QModbusRequest> batch = mixed( device );
+    Wire wire( Wire::Tcp , device );
+    wire.reversed = true;
+    QModbusTcpFraming::Transactions transactions;
+    QList<QModbusResponse> responses;
+    QModbusTcpFraming( transactions ).transact( wire , batch , responses );
+
+    // All requests are sent with one write, the replies are matched whatever their order.
+    QVERIFY( checkMixed( device , responses ) );
+    QCOMPARE( wire.writes , 1 );
+    QCOMPARE( transactions.pendingCount() , 0 );
+}
+
+void TestQModbusBatch::tcpWindows( void )
+{
+    // A window has as many requests as the transaction table has slots.
+    SimulatedModbus device;
+    const Wire wire( Wire::Tcp , device );
+    QModbusTcpFraming::Transactions transactions;
+    QList<QModbusResponse> responses;
+    QList<QModbusRequest> batch = reads( 100 );
+    batch[0] = QModbusRequest::readHoldingRegisters( 1 , 0 , 1 );
+    QModbusTcpFraming( transactions ).transact( wire , batch , responses );
+    QCOMPARE( count( responses , QAbstractModbus::Ok ) , 100 );
+    QCOMPARE( wire.writes , 2 );
+    QCOMPARE( device.log().at( 64 ) , QString( "3 1 64" ) );
+}
+
+void TestQModbusBatch::tcpTimeoutKeepsBatch( void )
+{
+    // A silent unit fails its own request, the rest of its window and the next window are answered.
+    SimulatedModbus device;
+    device.setSilent( 2 );
+    const Wire wire( Wire::Tcp , device );
+    QModbusTcpFraming::Transactions transactions;
+    QList<QModbusResponse> responses;
+    QModbusTcpFraming( transactions ).transact( wire , reads( 100 ) , responses );
+    QCOMPARE( responses.first().status() , (quint8)QAbstractModbus::Timeout );
+    QCOMPARE( count( responses , QAbstractModbus::Ok ) , 99 );
+    QCOMPARE( wire.writes , 2 );
+    QCOMPARE( transactions.pendingCount() , 0 );
+}
+
+void TestQModbusBatch::tcpMalformedReply( void )
+{
+    // The stream is out of sync: the window fails and the rest of the batch is not sent.
+    SimulatedModbus device;
+    Wire wire( Wire::Tcp , device );
+    wire.corrupt = true;
+    QModbusTcpFraming::Transactions transactions;
+    QList<QModbusResponse> responses;
+    QModbusTcpFraming( transactions ).transact( wire , reads( 100 ) , responses );
+    QCOMPARE( count( responses , QAbstractModbus::UnknownError ) , 100 );
+    QCOMPARE( wire.writes , 1 );
+    QVERIFY( wire.received.isEmpty() );
+    QCOMPARE( transactions.pendingCount() , 0 );
+}
+
+void TestQModbusBatch::tcpConnectionLost( void )
+{
+    SimulatedModbus device;
+    device.setSilent( 1 );
+    device.setSilent( 2 );
+    Wire wire( Wire::Tcp , device );
+    wire.open = false;
+    QModbusTcpFraming::Transactions transactions;
+    QList<QModbusResponse> responses;
+    QModbusTcpFraming( transactions ).transact( wire , reads( 100 ) , responses );
+    QCOMPARE( count( responses , QAbstractModbus::Timeout ) , 100 );
+    QCOMPARE( wire.writes , 1 );
+}
+
+QTEST_MAIN( TestQModbusBatch )
+#include "tst_qmodbusbatch.moc"
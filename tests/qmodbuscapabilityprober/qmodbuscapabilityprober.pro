@@ -0,0 +1,12 @@
+########################################################################################################################
+# tst_qmodbuscapabilityprober : Function support, address windows, request sizes and budget of the prober.             #
+########################################################################################################################
+# Author ........: QModbus contributors                                                                                #
+# Changes .......: -                                                                                                   #
+########################################################################################################################
+
+
+# FILES ################################################################################################################
+include( ../tests.pri )
+TARGET          = tst_qmodbuscapabilityprober
+SOURCES        +=   tst_qmodbuscapabilityprober.cpp
@@ -0,0 +1,299 @@
+/***********************************************************************************************************************
+* tst_qmodbuscapabilityprober : Function support, address windows, request sizes and budget of the prober.             *
+************************************************************************************************************************
+* Author : QModbus contributors                                                                                        *
+* Date   : 2026/10/18                                                                                                  *
+* Changes: -                                                                                                           *
+***********************************************************************************************************************/
+
+
+/*** Qt includes ******************************************************************************************************/
+#include <QModbusCapabilityProber>
+#include <QtTest/QtTest>
+
+
+/*** Test includes ****************************************************************************************************/
+#include "simulatedmodbus.h"
+
+
+/*** Test class *******************************************************************************************************/
+class TestQModbusCapabilityProber : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void settings( void );
+    void probeFunction( void );
+    void maskWriteOutsideWindow( void );
+    void probeAddressWindow( void );
+    void probeReadSize( void );
+    void probeWriteSize( void );
+    void probe( void );
+    void budget( void );
+    void failuresLeaveTheCache( void );
+};
+
+void TestQModbusCapabilityProber::settings( void )
+{
+    SimulatedModbus modbus;
+    QModbusCapabilityProber prober( modbus );
+    QCOMPARE( prober.maximumProbes() , 64 );
+    QCOMPARE( prober.probeCount() , 0 );
+    prober.setMaximumProbes( 0 );
+    QCOMPARE( prober.maximumProbes() , 1 );
+    prober.setMaximumProbes( 2000 );
+    QCOMPARE( prober.maximumProbes() , 1024 );
+
+    // Probers may share a cache, each one owns a cache otherwise.
+    QModbusCapabilityCache cache;
+    const QModbusCapabilityProber first( modbus , &cache );
+    const QModbusCapabilityProber second( modbus , &cache );
+    QCOMPARE( &first.capabilities() , &cache );
+    QCOMPARE( &second.capabilities() , &cache );
+    QVERIFY( &prober.capabilities() != &cache );
+    first.probeFunction( 1 , 0x03 );
+    QCOMPARE( second.capabilities().support( 1 , 0x03 ) , QModbusCapabilityCache::Supported );
+    QCOMPARE( prober.capabilities().support( 1 , 0x03 ) , QModbusCapabilityCache::Unknown );
+}
+
+void TestQModbusCapabilityProber::probeFunction( void )
+{
+    SimulatedModbus modbus;
+    modbus.setUnsupported( 0x04 );
+    const QModbusCapabilityProber prober( modbus );
+    const QModbusCapabilityCache &cache = prober.capabilities();
+    quint8 status = QAbstractModbus::UnknownError;
+
+    // The probes are rejected by the device, the exception tells that the function was decoded.
+    QCOMPARE( prober.probeFunction( 1 , 0x03 , &status ) , QModbusCapabilityCache::Supported );
+    QCOMPARE( status , (quint8)QAbstractModbus::Ok );
+    QCOMPARE( prober.probeFunction( 1 , 0x04 , &status ) , QModbusCapabilityCache::Unsupported );
+    QCOMPARE( status , (quint8)QAbstractModbus::Ok );
+    QCOMPARE( cache.support( 1 , 0x03 ) , QModbusCapabilityCache::Supported );
+    QCOMPARE( cache.support( 1 , 0x04 ) , QModbusCapabilityCache::Unsupported );
+    QCOMPARE( cache.support( 2 , 0x03 ) , QModbusCapabilityCache::Unknown );
+    QCOMPARE( prober.probeCount() , 1 );
+
+    // The write probes do not change anything.
+    modbus.setRegister( 1 , 0 , 42 );
+    QCOMPARE( prober.probeFunction( 1 , 0x10 ) , QModbusCapabilityCache::Supported );
+    QCOMPARE( prober.probeFunction( 1 , 0x17 ) , QModbusCapabilityCache::Supported );
+    QCOMPARE( modbus.registerValue( 1 , 0 ) , (quint16)42 );
+
+    // Functions without a harmless request are not probed.
+    modbus.clearLog();
+    QCOMPARE( prober.probeFunction( 1 , 0x2B , &status ) , QModbusCapabilityCache::Unknown );
+    QCOMPARE( status , (quint8)QAbstractModbus::IllegalDataValue );
+    QCOMPARE( modbus.callCount() , 0 );
+    QCOMPARE( cache.support( 1 , 0x2B ) , QModbusCapabilityCache::Unknown );
+}
+
+void TestQModbusCapabilityProber::maskWriteOutsideWindow( void )
+{
+    // With a known window, the mask write targets the first address after it.
+    SimulatedModbus modbus;
+    QModbusCapabilityCache cache;
+    cache.setAddressWindow( 1 , QAbstractModbus::HoldingRegisters , 0 , 99 );
+    const QModbusCapabilityProber prober( modbus , &cache );
+    QCOMPARE( prober.probeFunction( 1 , 0x16 ) , QModbusCapabilityCache::Supported );
+    QCOMPARE( modbus.log() , QStringList() << "22 1 100" );
+
+    cache.setAddressWindow( 1 , QAbstractModbus::HoldingRegisters , 10 , 99 );
+    prober.probeFunction( 1 , 0x16 );
+    QCOMPARE( modbus.log().last() , QString( "22 1 9" ) );
+}
+
+void TestQModbusCapabilityProber::probeAddressWindow( void )
+{
+    SimulatedModbus modbus;
+    modbus.setRegisterCount( 100 );
+    const QModbusCapabilityProber prober( modbus );
+    const QModbusCapabilityCache &cache = prober.capabilities();
+    quint8 status = QAbstractModbus::UnknownError;
+
+    QVERIFY( prober.probeAddressWindow( 1 , QAbstractModbus::HoldingRegisters , 10 , &status ) );
+    QCOMPARE( status , (quint8)QAbstractModbus::Ok );
+    quint16 firstAddress = 1 , lastAddress = 0;
+    QVERIFY( cache.addressWindow( 1 , QAbstractModbus::HoldingRegisters , &firstAddress , &lastAddress ) );
+    QCOMPARE( firstAddress , (quint16)0 );
+    QCOMPARE( lastAddress , (quint16)99 );
+    QVERIFY( !cache.addressWindow( 1 , QAbstractModbus::InputRegisters , NULL , NULL ) );
+    QCOMPARE( cache.support( 1 , QAbstractModbus::HoldingRegisters ) , QModbusCapabilityCache::Supported );
+
+    // Two binary searches over the address space.
+    QVERIFY( prober.probeCount() <= 24 );
+    QCOMPARE( prober.probeCount() , modbus.callCount() );
+
+    // The search has to start at a readable address.
+    QVERIFY( !prober.probeAddressWindow( 1 , QAbstractModbus::Coils , 150 , &status ) );
+    QCOMPARE( status , (quint8)QAbstractModbus::IllegalDataAddress );
+    QCOMPARE( prober.probeCount() , 1 );
+    QVERIFY( !cache.addressWindow( 1 , QAbstractModbus::Coils , NULL , NULL ) );
+}
+
+void TestQModbusCapabilityProber::probeReadSize( void )
+{
+    SimulatedModbus modbus;
+    const QModbusCapabilityProber prober( modbus );
+    QModbusCapabilityCache &cache = prober.capabilities();
+    quint8 status = QAbstractModbus::UnknownError;
+
+    // Most devices accept the standard maximum at once.
+    QCOMPARE( prober.probeReadSize( 1 , QAbstractModbus::InputRegisters , 0 , &status ) , (quint16)125 );
+    QCOMPARE( status , (quint8)QAbstractModbus::Ok );
+    QCOMPARE( modbus.callCount() , 1 );
+    QCOMPARE( cache.maximumQuantity( 1 , QAbstractModbus::InputRegisters ) , (quint16)125 );
+
+    // A smaller limit is found by a binary search.
+    modbus.setMaximumQuantity( 50 );
+    QCOMPARE( prober.probeReadSize( 2 , QAbstractModbus::HoldingRegisters , 0 , &status ) , (quint16)50 );
+    QCOMPARE( status , (quint8)QAbstractModbus::Ok );
+    QVERIFY( prober.probeCount() <= 8 );
+    QCOMPARE( cache.maximumQuantity( 2 , QAbstractModbus::HoldingRegisters ) , (quint16)50 );
+
+    // The end of the window limits the search without telling about the size of the device.
+    modbus.setMaximumQuantity( 0 );
+    modbus.setRegisterCount( 100 );
+    cache.setAddressWindow( 3 , QAbstractModbus::HoldingRegisters , 0 , 99 );
+    QCOMPARE( prober.probeReadSize( 3 , QAbstractModbus::HoldingRegisters , 80 , &status ) , (quint16)20 );
+    QCOMPARE( prober.probeCount() , 1 );
+    QCOMPARE( cache.maximumQuantity( 3 , QAbstractModbus::HoldingRegisters ) , (quint16)125 );
+    QCOMPARE( prober.probeReadSize( 3 , QAbstractModbus::HoldingRegisters , 100 , &status ) , (quint16)0 );
+    QCOMPARE( status , (quint8)QAbstractModbus::IllegalDataAddress );
+    QCOMPARE( prober.probeCount() , 0 );
+}
+
+void TestQModbusCapabilityProber::probeWriteSize( void )
+{
+    SimulatedModbus modbus;
+    for ( quint16 address = 0 ; address < 200 ; address++ ) modbus.setRegister( 1 , address , address * 3 );
+    const QModbusCapabilityProber prober( modbus );
+    QModbusCapabilityCache &cache = prober.capabilities();
+    quint8 status = QAbstractModbus::UnknownError;
+
+    // The values are read and written back unchanged.
+    QCOMPARE( prober.probeWriteSize( 1 , QAbstractModbus::HoldingRegisters , 0 , &status ) , (quint16)123 );
+    QCOMPARE( status , (quint8)QAbstractModbus::Ok );
+    QCOMPARE( modbus.log() , QStringList() << "3 1 0" << "16 1 0" );
+    for ( quint16 address = 0 ; address < 200 ; address++ )
+    {
+        QCOMPARE( modbus.registerValue( 1 , address ) , (quint16)( address * 3 ) );
+    }
+    QCOMPARE( cache.maximumQuantity( 1 , 0x10 ) , (quint16)123 );
+    QCOMPARE( cache.support( 1 , 0x10 ) , QModbusCapabilityCache::Supported );
+
+    // The writes are not larger than the reads, a learned read size limits them.
+    modbus.clearLog();
+    modbus.setMaximumQuantity( 50 );
+    cache.setMaximumQuantity( 2 , QAbstractModbus::Coils , 50 );
+    QCOMPARE( prober.probeWriteSize( 2 , QAbstractModbus::Coils , 0 , &status ) , (quint16)50 );
+    QCOMPARE( modbus.log() , QStringList() << "1 2 0" << "15 2 0" );
+    QCOMPARE( cache.maximumQuantity( 2 , 0x0F ) , (quint16)1968 );
+
+    // A failed read stops the probe.
+    QCOMPARE( prober.probeWriteSize( 3 , QAbstractModbus::HoldingRegisters , 0 , &status ) , (quint16)0 );
+    QCOMPARE( status , (quint8)QAbstractModbus::IllegalDataValue );
+    QCOMPARE( prober.probeCount() , 1 );
+
+    // Only coils and holding registers can be written.
+    modbus.clearLog();
+    QCOMPARE( prober.probeWriteSize( 1 , QAbstractModbus::InputRegisters , 0 , &status ) , (quint16)0 );
+    QCOMPARE( status , (quint8)QAbstractModbus::IllegalDataValue );
+    QCOMPARE( modbus.callCount() , 0 );
+}
+
+void TestQModbusCapabilityProber::probe( void )
+{
+    SimulatedModbus modbus;
+    modbus.setRegisterCount( 100 );
+    modbus.setMaximumQuantity( 50 );
+    modbus.setUnsupported( 0x17 );
+    const QModbusCapabilityProber prober( modbus );
+    const QModbusCapabilityCache &cache = prober.capabilities();
+    quint8 status = QAbstractModbus::UnknownError;
+
+    // An unsupported write function is learned, it does not fail the probe.
+    QVERIFY( prober.probe( 1 , QAbstractModbus::HoldingRegisters , 10 , &status ) );
+    QCOMPARE( status , (quint8)QAbstractModbus::Ok );
+    quint16 firstAddress = 1 , lastAddress = 0;
+    QVERIFY( cache.addressWindow( 1 , QAbstractModbus::HoldingRegisters , &firstAddress , &lastAddress ) );
+    QCOMPARE( firstAddress , (quint16)0 );
+    QCOMPARE( lastAddress , (quint16)99 );
+    QCOMPARE( cache.maximumQuantity( 1 , QAbstractModbus::HoldingRegisters ) , (quint16)50 );
+    QCOMPARE( cache.support( 1 , 0x03 ) , QModbusCapabilityCache::Supported );
+    QCOMPARE( cache.support( 1 , 0x10 ) , QModbusCapabilityCache::Supported );
+    QCOMPARE( cache.support( 1 , 0x16 ) , QModbusCapabilityCache::Supported );
+    QCOMPARE( cache.support( 1 , 0x17 ) , QModbusCapabilityCache::Unsupported );
+
+    // All probes count against one budget.
+    QCOMPARE( prober.probeCount() , modbus.callCount() );
+    QVERIFY( prober.probeCount() <= prober.maximumProbes() );
+
+    // An unsupported table fails at once.
+    modbus.setUnsupported( 0x02 );
+    modbus.clearLog();
+    QVERIFY( !prober.probe( 1 , QAbstractModbus::DiscreteInputs , 0 , &status ) );
+    QCOMPARE( status , (quint8)QAbstractModbus::IllegalFunction );
+    QCOMPARE( modbus.callCount() , 1 );
+}
+
+void TestQModbusCapabilityProber::budget( void )
+{
+    SimulatedModbus modbus;
+    modbus.setRegisterCount( 100 );
+    QModbusCapabilityProber prober( modbus );
+    const QModbusCapabilityCache &cache = prober.capabilities();
+    quint8 status = QAbstractModbus::Ok;
+
+    // The search stops when the budget is spent, nothing is learned.
+    prober.setMaximumProbes( 5 );
+    QVERIFY( !prober.probeAddressWindow( 1 , QAbstractModbus::HoldingRegisters , 10 , &status ) );
+    QCOMPARE( status , (quint8)QAbstractModbus::Timeout );
+    QCOMPARE( prober.probeCount() , 5 );
+    QCOMPARE( modbus.callCount() , 5 );
+    QVERIFY( !cache.addressWindow( 1 , QAbstractModbus::HoldingRegisters , NULL , NULL ) );
+
+    // Every call gets a new budget, the nested probes of probe() share one.
+    modbus.clearLog();
+    prober.setMaximumProbes( 20 );
+    QVERIFY( !prober.probe( 1 , QAbstractModbus::HoldingRegisters , 10 , &status ) );
+    QCOMPARE( status , (quint8)QAbstractModbus::Timeout );
+    QCOMPARE( prober.probeCount() , 20 );
+    QCOMPARE( modbus.callCount() , 20 );
+
+    // An interrupted size search keeps the largest quantity accepted so far: 125 and 62 are refused, 31 accepted.
+    modbus.setRegisterCount( 0x10000 );
+    modbus.setMaximumQuantity( 50 );
+    prober.setMaximumProbes( 3 );
+    QCOMPARE( prober.probeReadSize( 2 , QAbstractModbus::HoldingRegisters , 0 , &status ) , (quint16)31 );
+    QCOMPARE( status , (quint8)QAbstractModbus::Timeout );
+    QCOMPARE( cache.maximumQuantity( 2 , QAbstractModbus::HoldingRegisters ) , (quint16)31 );
+}
+
+void TestQModbusCapabilityProber::failuresLeaveTheCache( void )
+{
+    // Transport errors and busy devices tell nothing about the device.
+    SimulatedModbus modbus;
+    const QModbusCapabilityProber prober( modbus );
+    const QModbusCapabilityCache &cache = prober.capabilities();
+    quint8 status = QAbstractModbus::Ok;
+
+    modbus.failNext( QAbstractModbus::Timeout );
+    QCOMPARE( prober.probeFunction( 1 , 0x03 , &status ) , QModbusCapabilityCache::Unknown );
+    QCOMPARE( status , (quint8)QAbstractModbus::Timeout );
+    modbus.failNext( QAbstractModbus::SlaveDeviceBusy );
+    QCOMPARE( prober.probeFunction( 1 , 0x03 , &status ) , QModbusCapabilityCache::Unknown );
+    QCOMPARE( status , (quint8)QAbstractModbus::SlaveDeviceBusy );
+    QCOMPARE( cache.support( 1 , 0x03 ) , QModbusCapabilityCache::Unknown );
+
+    modbus.failNext( QAbstractModbus::CrcError );
+    QCOMPARE( prober.probeReadSize( 1 , QAbstractModbus::HoldingRegisters , 0 , &status ) , (quint16)0 );
+    QCOMPARE( status , (quint8)QAbstractModbus::CrcError );
+    modbus.failNext( QAbstractModbus::Timeout );
+    QVERIFY( !prober.probeAddressWindow( 1 , QAbstractModbus::HoldingRegisters , 0 , &status ) );
+    QCOMPARE( status , (quint8)QAbstractModbus::Timeout );
+    QVERIFY( cache.devices().isEmpty() );
+}
+
+QTEST_MAIN( TestQModbusCapabilityProber )
+#include "tst_qmodbuscapabilityprober.moc"
@@ -0,0 +1,12 @@
+########################################################################################################################
+# tst_qmodbuschangefilter : Change detection and deadbands.                                                            #
+########################################################################################################################
+# Author ........: QModbus contributors                                                                                #
+# Changes .......: -                                                                                                   #
+########################################################################################################################
+
+
+# FILES ################################################################################################################
+include( ../tests.pri )
+TARGET          = tst_qmodbuschangefilter
+SOURCES        +=   tst_qmodbuschangefilter.cpp
@@ -0,0 +1,197 @@
+/***********************************************************************************************************************
+* tst_qmodbuschangefilter : Changed items and deadbands of the change filter.                                          *
+************************************************************************************************************************
+* Author : QModbus contributors                                                                                        *
+* Date   : 2026/10/18                                                                                                  *
+* Changes: -                                                                                                           *
+***********************************************************************************************************************/
+
+
+/*** Qt includes ******************************************************************************************************/
+#include <QModbusChangeFilter>
+#include <QtTest/QtTest>
+
+
+/*** System includes **************************************************************************************************/
+#include <string.h>
+
+
+/*** Helpers **********************************************************************************************************/
+// Returns a list of indices.
+static QList<int> indices( const int a = -1 , const int b = -1 , const int c = -1 )
+{
+    QList<int> list;
+    if ( a >= 0 ) list << a;
+    if ( b >= 0 ) list << b;
+    if ( c >= 0 ) list << c;
+    return list;
+}
+
+// Returns a block of one register.
+static QList<quint16> block( const quint16 value )
+{
+    return QList<quint16>() << value;
+}
+
+// Returns the two registers of a 32 bit value, high word first.
+static QList<quint16> block32( const quint32 value )
+{
+    return QList<quint16>() << (quint16)( value >> 16 ) << (quint16)( value & 0xFFFF );
+}
+
+// Returns the two registers of a float, high word first.
+static QList<quint16> blockFloat( const float value )
+{
+    quint32 bits;
+    memcpy( &bits , &value , sizeof( bits ) );
+    return block32( bits );
+}
+
+
+/*** Test class *******************************************************************************************************/
+class TestQModbusChangeFilter : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void firstSample( void );
+    void sizeChange( void );
+    void reset( void );
+    void registers( void );
+    void absoluteDeadband( void );
+    void percentDeadband( void );
+    void doubleRegisters( void );
+    void signedDeadband( void );
+    void floatDeadband( void );
+    void bits( void );
+};
+
+void TestQModbusChangeFilter::firstSample( void )
+{
+    QModbusChangeFilter filter;
+    const QList<quint16> values = QList<quint16>() << 1 << 2 << 3;
+    QCOMPARE( filter.compare( values ) , indices( 0 , 1 , 2 ) );
+    QCOMPARE( filter.compare( values ) , indices() );
+
+    // Values of two registers are reported by the index of their first register, an incomplete value is left out.
+    QModbusChangeFilter filter32( QModbusChangeFilter::UInt32 );
+    QCOMPARE( filter32.compare( QList<quint16>() << 0 << 0 << 0 << 0 << 0 ) , indices( 0 , 2 ) );
+}
+
+void TestQModbusChangeFilter::sizeChange( void )
+{
+    QModbusChangeFilter filter;
+    filter.compare( QList<quint16>() << 1 << 2 );
+    QCOMPARE( filter.compare( QList<quint16>() << 1 << 2 << 3 ) , indices( 0 , 1 , 2 ) );
+    QCOMPARE( filter.compare( QList<quint16>() << 1 << 2 << 3 ) , indices() );
+    QCOMPARE( filter.compare( QList<quint16>() << 1 ) , indices( 0 ) );
+}
+
+void TestQModbusChangeFilter::reset( void )
+{
+    QModbusChangeFilter filter;
+    filter.compare( block( 7 ) );
+    QCOMPARE( filter.compare( block( 7 ) ) , indices() );
+    filter.reset();
+    QCOMPARE( filter.compare( block( 7 ) ) , indices( 0 ) );
+
+    QModbusChangeFilter bitFilter;
+    bitFilter.compare( QList<bool>() << true );
+    bitFilter.reset();
+    QCOMPARE( bitFilter.compare( QList<bool>() << true ) , indices( 0 ) );
+}
+
+void TestQModbusChangeFilter::registers( void )
+{
+    // Long enough for the vectorized comparison and its tail.
+    QList<quint16> values;
+    for ( int i = 0 ; i < 200 ; i++ ) values.append( (quint16)i );
+    QModbusChangeFilter filter;
+    filter.compare( values );
+
+    values[0] = 1000;
+    values[77] = 1000;
+    values[199] = 1000;
+    QCOMPARE( filter.compare( values ) , indices( 0 , 77 , 199 ) );
+    QCOMPARE( filter.compare( values ) , indices() );
+}
+
+void TestQModbusChangeFilter::absoluteDeadband( void )
+{
+    QModbusChangeFilter filter( QModbusChangeFilter::Int16 , QModbusChangeFilter::AbsoluteDeadband , 5.0 );
+    QCOMPARE( filter.compare( block( 0 ) ) , indices( 0 ) );
+    QCOMPARE( filter.compare( block( 3 ) ) , indices() );
+    QCOMPARE( filter.compare( block( 5 ) ) , indices() );       // On the deadband: not reported.
+    QCOMPARE( filter.compare( block( 6 ) ) , indices( 0 ) );
+
+    // Compared to the value reported last (6), not to the previous sample.
+    QCOMPARE( filter.compare( block( 2 ) ) , indices() );
+    QCOMPARE( filter.compare( block( 0xFFFF ) ) , indices( 0 ) ); // -1 as signed value.
+}
+
+void TestQModbusChangeFilter::percentDeadband( void )
+{
+    QModbusChangeFilter filter( QModbusChangeFilter::UInt16 , QModbusChangeFilter::PercentDeadband , 10.0 );
+    QCOMPARE( filter.compare( block( 1000 ) ) , indices( 0 ) );
+    QCOMPARE( filter.compare( block( 1100 ) ) , indices() );
+    QCOMPARE( filter.compare( block( 1101 ) ) , indices( 0 ) );
+
+    // The deadband is relative to the value reported last: 10% of 1101.
+    QCOMPARE( filter.compare( block( 1000 ) ) , indices() );
+    QCOMPARE( filter.compare( block( 990 ) ) , indices( 0 ) );
+}
+
+void TestQModbusChangeFilter::doubleRegisters( void )
+{
+    QModbusChangeFilter filter( QModbusChangeFilter::UInt32 );
+    QList<quint16> values = QList<quint16>() << 0 << 0 << 0 << 0;
+    filter.compare( values );
+
+    values[3] = 1;
+    QCOMPARE( filter.compare( values ) , indices( 2 ) );
+    values[0] = 1;
+    values[1] = 1;
+    QCOMPARE( filter.compare( values ) , indices( 0 ) );
+    values[1] = 2;
+    values[2] = 2;
+    QCOMPARE( filter.compare( values ) , indices( 0 , 2 ) );
+}
+
+void TestQModbusChangeFilter::signedDeadband( void )
+{
+    QModbusChangeFilter filter( QModbusChangeFilter::Int32 , QModbusChangeFilter::AbsoluteDeadband , 10.0 );
+    QCOMPARE( filter.compare( block32( 0 ) ) , indices( 0 ) );
+    QCOMPARE( filter.compare( block32( (quint32)-10 ) ) , indices() );
+    QCOMPARE( filter.compare( block32( (quint32)-11 ) ) , indices( 0 ) );
+    QCOMPARE( filter.compare( block32( (quint32)-1 ) ) , indices() );
+}
+
+void TestQModbusChangeFilter::floatDeadband( void )
+{
+    QModbusChangeFilter filter( QModbusChangeFilter::Float32 , QModbusChangeFilter::AbsoluteDeadband , 0.5 );
+    QCOMPARE( filter.compare( blockFloat( 1.0f ) ) , indices( 0 ) );
+    QCOMPARE( filter.compare( blockFloat( 1.4f ) ) , indices() );
+    QCOMPARE( filter.compare( blockFloat( 1.6f ) ) , indices( 0 ) );
+    QCOMPARE( filter.compare( blockFloat( -1.6f ) ) , indices( 0 ) );
+}
+
+void TestQModbusChangeFilter::bits( void )
+{
+    QList<bool> values;
+    for ( int i = 0 ; i < 100 ; i++ ) values.append( i % 3 == 0 );
+    QModbusChangeFilter filter;
+    QCOMPARE( filter.compare( values ).count() , 100 );
+    QCOMPARE( filter.compare( values ) , indices() );
+
+    // Bits in both 64 bit words.
+    values[3] = !values.at( 3 );
+    values[70] = !values.at( 70 );
+    QCOMPARE( filter.compare( values ) , indices( 3 , 70 ) );
+    QCOMPARE( filter.compare( values ) , indices() );
+
+    values.append( true );
+    QCOMPARE( filter.compare( values ).count() , 101 );
+}
+
+QTEST_MAIN( TestQModbusChangeFilter )
+#include "tst_qmodbuschangefilter.moc"
@@ -0,0 +1,13 @@
+########################################################################################################################
+# tst_qmodbusconnectionpool : Unit clients, socket growth and in-flight limits of the connection pool.                 #
+########################################################################################################################
+# Author ........: QModbus contributors                                                                                #
+# Changes .......: -                                                                                                   #
+########################################################################################################################
+
+
+# FILES ################################################################################################################
+include( ../tests.pri )
+TARGET          = tst_qmodbusconnectionpool
+SOURCES        +=   tst_qmodbusconnectionpool.cpp
+QT             += network                       # Local modbus TCP gateway the pool connects to.
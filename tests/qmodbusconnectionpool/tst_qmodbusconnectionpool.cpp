@@ -0,0 +1,357 @@
+/***********************************************************************************************************************
+* tst_qmodbusconnectionpool : Unit clients, socket growth and in-flight limits of the connection pool.                 *
+************************************************************************************************************************
+* Author : QModbus contributors                                                                                        *
+* Date   : 2026/10/18                                                                                                  *
+* Changes: -                                                                                                           *
+***********************************************************************************************************************/
+
+
+/*** Qt includes ******************************************************************************************************/
+#include <QModbusConnectionPool>
+#include <QModbusFraming>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QSemaphore>
+#include <QtNetwork/QTcpServer>
+#include <QtNetwork/QTcpSocket>
+#include <QtTest/QtTest>
+
+
+/*** Test includes ****************************************************************************************************/
+#include "simulatedmodbus.h"
+
+
+/*** Helpers **********************************************************************************************************/
+// Modbus TCP gateway on a local port, answers from a simulated device in its own thread. While held, the requests
+// received are kept unanswered, so the test sees how many the pool has in flight.
+class TcpGateway : public QThread
+{
+public:
+    explicit TcpGateway( const SimulatedModbus &device ) : _device( device ) , _port( 0 ) , _stop( 0 ) , _hold( 0 ) ,
+                                                           _connections( 0 ) , _pending( 0 ) , _maximumPending( 0 ) {}
+
+    ~TcpGateway()
+    {
+        _stop.fetchAndStoreOrdered( 1 );
+        wait();
+    }
+
+    // Starts listening, returns the port.
+    quint16 listen( void )
+    {
+        start();
+        _ready.acquire();
+        return _port;
+    }
+
+    void hold( const bool hold ) { _hold.fetchAndStoreOrdered( hold ? 1 : 0 ); }
+    int connectionCount( void ) const { return _connections.fetchAndAddOrdered( 0 ); }
+    int pendingCount( void ) const { return _pending.fetchAndAddOrdered( 0 ); }
+    int maximumPending( void ) const { return _maximumPending.fetchAndAddOrdered( 0 ); }
+
+    // Waits until the given number of requests is unanswered, false if that did not happen within 5 seconds.
+    bool waitForPending( const int count ) const
+    {
+        for ( int i = 0 ; i < 5000 && pendingCount() != count ; i++ ) TestSleep::pause( 1 );
+        return pendingCount() == count;
+    }
+
+protected:
+    void run( void )
+    {
+        QTcpServer server;
+        server.listen( QHostAddress::LocalHost );
+        _port = server.serverPort();
+        _ready.release();
+
+        // No event loop: the sockets are polled.
+        QList<QTcpSocket *> sockets;
+        QList<QByteArray> buffers;
+        QList<QList<QByteArray> > requests;
+        while ( !_stop.fetchAndAddOrdered( 0 ) )
+        {
+            if ( server.waitForNewConnection( 1 ) )
+            {
+                while ( server.hasPendingConnections() )
+                {
+                    sockets.append( server.nextPendingConnection() );
+                    buffers.append( QByteArray() );
+                    requests.append( QList<QByteArray>() );
+                    _connections.fetchAndAddOrdered( 1 );
+                }
+            }
+            for ( int i = 0 ; i < sockets.count() ; i++ )
+            {
+                QTcpSocket *const socket = sockets.at( i );
+                if ( socket->state() != QAbstractSocket::ConnectedState ) continue;
+                socket->waitForReadyRead( 0 );
+                buffers[i].append( socket->readAll() );
+                while ( buffers.at( i ).size() >= 6 &&
+                        buffers.at( i ).size() >= 6 + QModbusPdu::get( buffers.at( i ).constData() + 4 ) )
+                {
+                    const int length = 6 + QModbusPdu::get( buffers.at( i ).constData() + 4 );
+                    requests[i].append( buffers.at( i ).left( length ) );
+                    buffers[i].remove( 0 , length );
+                    const int pending = _pending.fetchAndAddOrdered( 1 ) + 1;
+                    _maximumPending.fetchAndStoreOrdered( qMax( pending , maximumPending() ) );
+                }
+                if ( _hold.fetchAndAddOrdered( 0 ) ) continue;
+                while ( !requests.at( i ).isEmpty() )
+                {
+                    socket->write( _answer( requests[i].takeFirst() ) );
+                    _pending.fetchAndAddOrdered( -1 );
+                }
+                socket->flush();
+            }
+        }
+        qDeleteAll( sockets );
+    }
+
+private:
+    // Returns the reply of the device to an ADU, empty if the device is silent.
+    QByteArray _answer( const QByteArray &adu ) const
+    {
+        const quint8 unit = adu.at( 6 );
+        const QByteArray pdu = adu.mid( 7 );
+        const QModbusResponse response =
+            _device.execute( QList<QModbusRequest>() << QModbusRequest( unit , QModbusFrameView( pdu ) ) ).value( 0 );
+        if ( response.status() == QAbstractModbus::Timeout ) return QByteArray();
+
+        QByteArray reply = response.pdu().toByteArray();
+        if ( !response.isOk() )
+        {
+            reply = QByteArray( 1 , (char)( pdu.at( 0 ) | 0x80 ) );
+            reply.append( (char)response.status() );
+        }
+        QByteArray frame( reply.size() + 7 , 0 );
+        frame.resize( QModbusTcpFraming::encode( frame.data() , QModbusPdu::get( adu.constData() ) , unit ,
+                                                 reply.constData() , reply.size() ) );
+        return frame;
+    }
+
+    const SimulatedModbus &_device; // Device answering.
+    quint16 _port;                  // Port listening, set before _ready is released.
+    QSemaphore _ready;              // Released once the server listens.
+    QAtomicInt _stop;               // 1 to stop the thread.
+    QAtomicInt _hold;               // 1 while the requests are not answered.
+    mutable QAtomicInt _connections;    // Sockets accepted.
+    mutable QAtomicInt _pending;        // Requests received but not answered.
+    mutable QAtomicInt _maximumPending; // Largest number of requests unanswered.
+};
+
+// Executes a batch through a client in a thread of its own.
+class Worker : public QThread
+{
+public:
+    Worker( const QAbstractModbus &client , const QList<QModbusRequest> &batch ) :
+        _client( client ) , _batch( batch ) {}
+
+    QList<QModbusResponse> responses;
+
+protected:
+    void run( void ) { responses = _client.execute( _batch ); }
+
+private:
+    const QAbstractModbus &_client;
+    const QList<QModbusRequest> _batch;
+};
+
+// Returns count single register reads.
+static QList<QModbusRequest> reads( const int count )
+{
+    QList<QModbusRequest> batch;
+    for ( int i = 0 ; i < count ; i++ ) batch.append( QModbusRequest::readHoldingRegisters( 1 , (quint16)i , 1 ) );
+    return batch;
+}
+
+// Returns true if all responses are Ok.
+static bool allOk( const QList<QModbusResponse> &responses )
+{
+    foreach ( const QModbusResponse &response , responses ) if ( !response.isOk() ) return false;
+    return true;
+}
+
+// Returns a local port nobody listens on.
+static quint16 unusedPort( void )
+{
+    QTcpServer server;
+    server.listen( QHostAddress::LocalHost );
+    const quint16 port = server.serverPort();
+    server.close();
+    return port;
+}
+
+
+/*** Test class *******************************************************************************************************/
+class TestQModbusConnectionPool : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void clients( void );
+    void unitIds( void );
+    void lazySockets( void );
+    void inFlightPerUnit( void );
+    void inFlightPerGateway( void );
+    void socketsGrowWhenBusy( void );
+    void connectFailure( void );
+};
+
+void TestQModbusConnectionPool::clients( void )
+{
+    QModbusConnectionPool pool;
+    QCOMPARE( pool.maximumConnections() , 4 );
+    QCOMPARE( pool.maximumInFlight() , 32 );
+    QCOMPARE( pool.maximumInFlightPerUnit() , 4 );
+
+    // One client per unit of a gateway.
+    QModbusPoolClient *const client = pool.client( "127.0.0.1" , 1502 , 7 );
+    QCOMPARE( client->unitId() , (quint8)7 );
+    QCOMPARE( pool.client( "127.0.0.1" , 1502 , 7 ) , client );
+    QVERIFY( pool.client( "127.0.0.1" , 1502 , 8 ) != client );
+    QVERIFY( pool.client( "127.0.0.1" , 1503 , 7 ) != client );
+    QCOMPARE( pool.rateLimiter( "127.0.0.1" , 1502 ) , pool.rateLimiter( "127.0.0.1" , 1502 ) );
+    QVERIFY( pool.rateLimiter( "127.0.0.1" , 1502 ) != pool.rateLimiter( "127.0.0.1" , 1503 ) );
+
+    // No socket before the first request.
+    QVERIFY( !client->isOpen() );
+    QCOMPARE( pool.connectionCount( "127.0.0.1" , 1502 ) , 0 );
+}
+
+void TestQModbusConnectionPool::unitIds( void )
+{
+    SimulatedModbus device;
+    device.setRegister( 7 , 0 , 42 );
+    TcpGateway gateway( device );
+    const quint16 port = gateway.listen();
+    QModbusConnectionPool pool;
+
+    // The device address of the request is replaced by the unit ID of the client.
+    quint8 status = QAbstractModbus::UnknownError;
+    QCOMPARE( pool.client( "127.0.0.1" , port , 7 )->readHoldingRegisters( 1 , 0 , 1 , &status ) ,
+              QList<quint16>() << 42 );
+    QCOMPARE( status , (quint8)QAbstractModbus::Ok );
+    QVERIFY( pool.client( "127.0.0.1" , port , 8 )->writeSingleRegister( 1 , 3 , 9 , &status ) );
+    QCOMPARE( device.registerValue( 8 , 3 ) , (quint16)9 );
+    QCOMPARE( device.log() , QStringList() << "3 7 0" << "6 8 3" );
+}
+
+void TestQModbusConnectionPool::lazySockets( void )
+{
+    SimulatedModbus device;
+    TcpGateway gateway( device );
+    const quint16 port = gateway.listen();
+    QModbusConnectionPool pool;
+    QModbusPoolClient *const client = pool.client( "127.0.0.1" , port , 1 );
+
+    // Requests one after the other never find the socket busy, they all use the first one.
+    for ( int i = 0 ; i < 10 ; i++ ) QVERIFY( client->writeSingleRegister( 1 , (quint16)i , 1 ) );
+    QVERIFY( client->isOpen() );
+    QCOMPARE( pool.connectionCount( "127.0.0.1" , port ) , 1 );
+    QCOMPARE( gateway.connectionCount() , 1 );
+    QCOMPARE( device.callCount() , 10 );
+}
+
+void TestQModbusConnectionPool::inFlightPerUnit( void )
+{
+    SimulatedModbus device;
+    TcpGateway gateway( device );
+    const quint16 port = gateway.listen();
+    QModbusConnectionPool pool;
+    pool.setMaximumInFlightPerUnit( 2 );
+    QModbusPoolClient *const client = pool.client( "127.0.0.1" , port , 1 );
+    client->setTimeout( 5000 );
+
+    // The batch is submitted two requests at a time.
+    gateway.hold( true );
+    Worker worker( *client , reads( 6 ) );
+    worker.start();
+    QVERIFY( gateway.waitForPending( 2 ) );
+    TestSleep::pause( 100 );
+    QCOMPARE( gateway.pendingCount() , 2 );
+    gateway.hold( false );
+    QVERIFY( worker.wait( 5000 ) );
+    QCOMPARE( worker.responses.count() , 6 );
+    QVERIFY( allOk( worker.responses ) );
+    QCOMPARE( gateway.maximumPending() , 2 );
+}
+
+void TestQModbusConnectionPool::inFlightPerGateway( void )
+{
+    SimulatedModbus device;
+    TcpGateway gateway( device );
+    const quint16 port = gateway.listen();
+    QModbusConnectionPool pool;
+    pool.setMaximumInFlight( 3 );
+    QModbusPoolClient *const first = pool.client( "127.0.0.1" , port , 1 );
+    QModbusPoolClient *const second = pool.client( "127.0.0.1" , port , 2 );
+    first->setTimeout( 5000 );
+
+    // The units may have four requests in flight each, the gateway three in all.
+    gateway.hold( true );
+    Worker one( *first , reads( 4 ) );
+    Worker two( *second , reads( 4 ) );
+    one.start();
+    two.start();
+    QVERIFY( gateway.waitForPending( 3 ) );
+    TestSleep::pause( 100 );
+    QCOMPARE( gateway.pendingCount() , 3 );
+    gateway.hold( false );
+    QVERIFY( one.wait( 5000 ) );
+    QVERIFY( two.wait( 5000 ) );
+    QVERIFY( allOk( one.responses ) );
+    QVERIFY( allOk( two.responses ) );
+    QCOMPARE( gateway.maximumPending() , 3 );
+    QCOMPARE( device.callCount() , 8 );
+}
+
+void TestQModbusConnectionPool::socketsGrowWhenBusy( void )
+{
+    SimulatedModbus device;
+    TcpGateway gateway( device );
+    const quint16 port = gateway.listen();
+    QModbusConnectionPool pool;
+    pool.setMaximumConnections( 2 );
+    pool.setMaximumInFlightPerUnit( 8 );
+    QModbusPoolClient *const client = pool.client( "127.0.0.1" , port , 1 );
+    client->setTimeout( 5000 );
+
+    // Every socket has requests in flight: the gateway gets another one, up to the limit.
+    gateway.hold( true );
+    Worker worker( *client , reads( 8 ) );
+    worker.start();
+    QVERIFY( gateway.waitForPending( 8 ) );
+    QCOMPARE( gateway.connectionCount() , 2 );
+    QCOMPARE( pool.connectionCount( "127.0.0.1" , port ) , 2 );
+    gateway.hold( false );
+    QVERIFY( worker.wait( 5000 ) );
+    QVERIFY( allOk( worker.responses ) );
+    QCOMPARE( gateway.connectionCount() , 2 );
+}
+
+void TestQModbusConnectionPool::connectFailure( void )
+{
+    const quint16 port = unusedPort();
+    QModbusConnectionPool pool;
+    QModbusPoolClient *const client = pool.client( "127.0.0.1" , port , 1 );
+
+    // The first request waits for the connect, at most one connect timeout.
+    quint8 status = QAbstractModbus::UnknownError;
+    client->readHoldingRegisters( 1 , 0 , 1 , &status );
+    QCOMPARE( status , (quint8)QAbstractModbus::NoConnection );
+
+    // The connect failed: for one connect timeout, requests fail at once.
+    QElapsedTimer clock;
+    clock.start();
+    for ( int i = 0 ; i < 10 ; i++ )
+    {
+        status = QAbstractModbus::UnknownError;
+        client->readHoldingRegisters( 1 , 0 , 1 , &status );
+        QCOMPARE( status , (quint8)QAbstractModbus::NoConnection );
+    }
+    QVERIFY( clock.elapsed() < 500 );
+    QCOMPARE( pool.connectionCount( "127.0.0.1" , port ) , 0 );
+}
+
+QTEST_MAIN( TestQModbusConnectionPool )
+#include "tst_qmodbusconnectionpool.moc"
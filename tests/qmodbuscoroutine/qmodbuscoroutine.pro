@@ -0,0 +1,17 @@
+########################################################################################################################
+# tst_qmodbuscoroutine : Device programs awaiting requests of a shared connection.                                     #
+########################################################################################################################
+# Author ........: QModbus contributors                                                                                #
+# Changes .......: -                                                                                                   #
+########################################################################################################################
+
+
+# FILES ################################################################################################################
+include( ../tests.pri )
+TARGET          = tst_qmodbuscoroutine
+SOURCES        +=   tst_qmodbuscoroutine.cpp
+
+
+# C++20 ################################################################################################################
+CONFIG         += c++2a                         # QModbusCoroutine needs C++20 coroutines.
+*-g++*:QMAKE_CXXFLAGS += -fcoroutines           # GCC 10 does not enable them with -std=c++2a.
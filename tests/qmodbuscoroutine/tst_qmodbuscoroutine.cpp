@@ -0,0 +1,154 @@
+/***********************************************************************************************************************
+* tst_qmodbuscoroutine : Device programs awaiting requests of a shared connection.                                     *
+************************************************************************************************************************
+* Author : QModbus contributors                                                                                        *
+* Date   : 2026/10/18                                                                                                  *
+* Changes: -                                                                                                           *
+***********************************************************************************************************************/
+
+
+/*** Qt includes ******************************************************************************************************/
+#include <QModbusCoroutine>
+#include <QtCore/QThread>
+#include <QtTest/QtTest>
+
+
+/*** Test includes ****************************************************************************************************/
+#include "simulatedmodbus.h"
+
+
+/*** Helpers **********************************************************************************************************/
+// State of a device program, written by the program and read by the test once done is set.
+struct Program
+{
+    Program( void ) : status( QAbstractModbus::UnknownError ) , thread( NULL ) , done( 0 ) {}
+
+    quint8 status;                  // Status of the last request awaited.
+    QThread *thread;                // Thread the program was resumed on.
+    QAtomicInt done;                // 1 once the program returned.
+};
+
+// Sets the next register to 1 if the register is 0.
+static QModbusTask regulate( const QModbusCoroutineClient &client , const quint16 address , Program &program )
+{
+    const QModbusResponse state = co_await client.readHoldingRegisters( 1 , address , 1 );
+    program.thread = QThread::currentThread();
+    program.status = state.status();
+    if ( state.isOk() && state.registers().value( 0 ) == 0 )
+    {
+        const QModbusResponse write = co_await client.writeSingleRegister( 1 , address + 1 , 1 );
+        program.status = write.status();
+    }
+    program.done.fetchAndStoreOrdered( 1 );
+}
+
+// Awaits a request that can not be submitted.
+static QModbusTask invalid( const QModbusCoroutineClient &client , Program &program )
+{
+    const QModbusResponse response = co_await client.execute( QModbusRequest() );
+    program.thread = QThread::currentThread();
+    program.status = response.status();
+    program.done.fetchAndStoreOrdered( 1 );
+}
+
+// Increments a register, counts the programs finished.
+static QModbusTask increment( const QModbusCoroutineClient &client , const quint16 address , QAtomicInt &finished )
+{
+    const QModbusResponse value = co_await client.readHoldingRegisters( 1 , address , 1 );
+    if ( value.isOk() ) co_await client.writeSingleRegister( 1 , address , value.registers().value( 0 ) + 1 );
+    finished.fetchAndAddOrdered( 1 );
+}
+
+// Waits until an atomic reaches a value, false if that did not happen within 5 seconds.
+static bool waitFor( const QAtomicInt &atomic , const int value )
+{
+    QAtomicInt &counter = const_cast<QAtomicInt &>( atomic );
+    for ( int i = 0 ; i < 5000 && counter.fetchAndAddOrdered( 0 ) != value ; i++ ) TestSleep::pause( 1 );
+    return counter.fetchAndAddOrdered( 0 ) == value;
+}
+
+
+/*** Test class *******************************************************************************************************/
+class TestQModbusCoroutine : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void program( void );
+    void errorsAreStatuses( void );
+    void invalidRequestResumesAtOnce( void );
+    void manyPrograms( void );
+};
+
+void TestQModbusCoroutine::program( void )
+{
+    SimulatedModbus modbus;
+    modbus.setRegister( 1 , 20 , 5 );
+    QModbusSharedConnection connection( modbus );
+    const QModbusCoroutineClient client( connection );
+
+    // The program is suspended while its request is executed, then resumed on the I/O thread.
+    modbus.closeGate();
+    Program writes;
+    regulate( client , 10 , writes );
+    QVERIFY( modbus.waitForHeld( 1 ) );
+    QCOMPARE( writes.done.fetchAndAddOrdered( 0 ) , 0 );
+    modbus.openGate();
+    QVERIFY( waitFor( writes.done , 1 ) );
+    QCOMPARE( writes.status , (quint8)QAbstractModbus::Ok );
+    QVERIFY( writes.thread != QThread::currentThread() );
+    QVERIFY( modbus.threads().contains( writes.thread ) );
+    QCOMPARE( modbus.registerValue( 1 , 11 ) , (quint16)1 );
+
+    Program reads;
+    regulate( client , 20 , reads );
+    QVERIFY( waitFor( reads.done , 1 ) );
+    QCOMPARE( modbus.registerValue( 1 , 21 ) , (quint16)0 );
+    QCOMPARE( modbus.log() , QStringList() << "3 1 10" << "6 1 11" << "3 1 20" );
+}
+
+void TestQModbusCoroutine::errorsAreStatuses( void )
+{
+    SimulatedModbus modbus;
+    modbus.setSilent( 1 );
+    QModbusSharedConnection connection( modbus );
+    const QModbusCoroutineClient client( connection );
+    Program program;
+    regulate( client , 10 , program );
+    QVERIFY( waitFor( program.done , 1 ) );
+    QCOMPARE( program.status , (quint8)QAbstractModbus::Timeout );
+    QCOMPARE( modbus.callCount() , 1 );
+}
+
+void TestQModbusCoroutine::invalidRequestResumesAtOnce( void )
+{
+    SimulatedModbus modbus;
+    QModbusSharedConnection connection( modbus );
+    const QModbusCoroutineClient client( connection );
+    Program program;
+    invalid( client , program );
+    QCOMPARE( program.done.fetchAndAddOrdered( 0 ) , 1 );
+    QCOMPARE( program.status , (quint8)QAbstractModbus::IllegalDataValue );
+    QCOMPARE( program.thread , QThread::currentThread() );
+    QCOMPARE( modbus.callCount() , 0 );
+}
+
+void TestQModbusCoroutine::manyPrograms( void )
+{
+    // A thousand programs wait on one connection without a thread each.
+    SimulatedModbus modbus;
+    QModbusSharedConnection connection( modbus );
+    const QModbusCoroutineClient client( connection );
+    QAtomicInt finished( 0 );
+    for ( int i = 0 ; i < 1000 ; i++ ) increment( client , (quint16)( i % 100 ) , finished );
+    QVERIFY( waitFor( finished , 1000 ) );
+
+    // Programs on the same register interleave, but every request went through the I/O thread one at a time.
+    QCOMPARE( modbus.callCount() , 2000 );
+    QCOMPARE( modbus.threads().count() , 1 );
+    QCOMPARE( modbus.maximumActive() , 1 );
+    for ( quint16 i = 0 ; i < 100 ; i++ ) QVERIFY( modbus.registerValue( 1 , i ) >= 1 );
+}
+
+QTEST_MAIN( TestQModbusCoroutine )
+#include "tst_qmodbuscoroutine.moc"
@@ -0,0 +1,12 @@
+########################################################################################################################
+# tst_qmodbusdeadline : Deadlines and cancellation tokens of requests, in the framings and the shared connection.      #
+########################################################################################################################
+# Author ........: QModbus contributors                                                                                #
+# Changes .......: -                                                                                                   #
+########################################################################################################################
+
+
+# FILES ################################################################################################################
+include( ../tests.pri )
+TARGET          = tst_qmodbusdeadline
+SOURCES        +=   tst_qmodbusdeadline.cpp
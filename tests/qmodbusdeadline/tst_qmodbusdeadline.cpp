@@ -0,0 +1,357 @@
+/***********************************************************************************************************************
+* tst_qmodbusdeadline : Deadlines and cancellation tokens of requests, in the framings and the shared connection.      *
+************************************************************************************************************************
+* Author : QModbus contributors                                                                                        *
+* Date   : 2026/10/18                                                                                                  *
+* Changes: -                                                                                                           *
+***********************************************************************************************************************/
+
+
+/*** Qt includes ******************************************************************************************************/
+#include <QModbusDeadline>
+#include <QModbusFraming>
+#include <QModbusSharedConnection>
+#include <QtCore/QElapsedTimer>
+#include <QtTest/QtTest>
+
+
+/*** Test includes ****************************************************************************************************/
+#include "simulatedmodbus.h"
+
+
+/*** System includes **************************************************************************************************/
+#include <string.h>
+
+
+/*** Helpers **********************************************************************************************************/
+// I/O policy of the framings wired to a simulated device: every frame written is answered at once, the replies wait
+// in the receive buffer. Reads never wait, an empty buffer is a timeout. The replies of the late unit arrive only
+// after a read timed out.
+class Wire
+{
+public:
+    enum Mode
+    {
+        Rtu ,                       // One RTU frame per write.
+        Tcp                         // Any number of TCP frames per write.
+    };
+
+    Wire( const Mode mode , const SimulatedModbus &device ) : writes( 0 ) , lateUnit( 0 ) ,
+                                                              cancelOnWrite( QModbusCancellationToken::none() ) ,
+                                                              _mode( mode ) , _device( device ) {}
+
+    bool isOpen( void ) const { return true; }
+    void discard( void ) const { received.clear(); }
+    void limit( const QModbusDeadline & , const QModbusCancellationToken & ) const {}
+    int readAll( char *const data , const int maxSize ) const { return read( data , maxSize ); }
+    int readLine( char *const , const int ) const { return 0; }
+
+    int read( char *const data , const int size ) const
+    {
+        if ( received.isEmpty() )
+        {
+            received = late;
+            late.clear();
+            return 0;
+        }
+        const int count = qMin( size , received.size() );
+        memcpy( data , received.constData() , count );
+        received.remove( 0 , count );
+        return count;
+    }
+
+    bool write( const char *const data , const int size ) const
+    {
+        writes++;
+        for ( int i = 0 ; i < size ; )
+        {
+            const int length = _mode == Rtu ? size : 6 + QModbusPdu::get( data + i + 4 );
+            const QByteArray adu( data + i , length );
+            const quint8 unit = adu.at( _mode == Rtu ? 0 : 6 );
+            ( unit == lateUnit ? late : received ).append( _answer( adu ) );
+            i += length;
+        }
+
+        // The request is given up while it is on the wire.
+        QModbusCancellationToken token = cancelOnWrite;
+        token.cancel();
+        return true;
+    }
+
+    mutable QByteArray received;    // Replies not read yet.
+    mutable QByteArray late;        // Replies of the late unit, not received yet.
+    mutable int writes;             // Number of writes.
+    quint8 lateUnit;                // Unit that answers late, 0 for none.
+    QModbusCancellationToken cancelOnWrite; // Cancelled by every write.
+
+private:
+    // Returns the reply of the device to an ADU.
+    QByteArray _answer( const QByteArray &adu ) const
+    {
+        const bool rtu = _mode == Rtu;
+        const quint8 unit = adu.at( rtu ? 0 : 6 );
+        const QByteArray pdu = rtu ? adu.mid( 1 , adu.size() - 3 ) : adu.mid( 7 );
+        const QModbusResponse response =
+            _device.execute( QList<QModbusRequest>() << QModbusRequest( unit , QModbusFrameView( pdu ) ) ).value( 0 );
+        const QByteArray reply = response.pdu().toByteArray();
+        QByteArray frame( reply.size() + 7 , 0 );
+        if ( rtu )
+        {
+            frame.resize( QModbusRtuFraming::encode( frame.data() , unit , reply.constData() , reply.size() ) );
+        }
+        else
+        {
+            frame.resize( QModbusTcpFraming::encode( frame.data() , QModbusPdu::get( adu.constData() ) , unit ,
+                                                     reply.constData() , reply.size() ) );
+        }
+        return frame;
+    }
+
+    Mode _mode;                     // Framing.
+    const SimulatedModbus &_device; // Device answering.
+};
+
+// Returns a read of holding register 0 of a unit with the given limits.
+static QModbusRequest limited( const quint8 unit , const QModbusDeadline &deadline ,
+                               const QModbusCancellationToken &token )
+{
+    QModbusRequest request = QModbusRequest::readHoldingRegisters( unit , 0 , 1 );
+    request.setDeadline( deadline );
+    request.setCancellationToken( token );
+    return request;
+}
+
+// Returns a token that is already cancelled.
+static QModbusCancellationToken cancelled( void )
+{
+    QModbusCancellationToken token;
+    token.cancel();
+    return token;
+}
+
+// Returns the statuses of responses.
+static QList<quint8> statuses( const QList<QModbusResponse> &responses )
+{
+    QList<quint8> statuses;
+    foreach ( const QModbusResponse &response , responses ) statuses.append( response.status() );
+    return statuses;
+}
+
+
+/*** Test class *******************************************************************************************************/
+class TestQModbusDeadline : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void deadline( void );
+    void cancellationToken( void );
+    void requestLimits( void );
+    void limitedRequestsAreNotSent( void );
+    void tcpLimitedWindow( void );
+    void tcpGiveUp( void );
+    void rtuDrainsLateReply( void );
+    void sharedConnection( void );
+};
+
+void TestQModbusDeadline::deadline( void )
+{
+    const QModbusDeadline never;
+    QVERIFY( never.isNever() );
+    QVERIFY( !never.hasExpired() );
+    QCOMPARE( never.remaining( 100 ) , 100 );
+
+    const QModbusDeadline expired( 0 );
+    QVERIFY( !expired.isNever() );
+    QVERIFY( expired.hasExpired() );
+    QCOMPARE( expired.remaining( 100 ) , 0 );
+    QVERIFY( QModbusDeadline( -5 ).hasExpired() );
+
+    const QModbusDeadline later( 10000 );
+    QVERIFY( !later.hasExpired() );
+    QCOMPARE( later.remaining( 100 ) , 100 );
+    QVERIFY( later.remaining( 20000 ) > 9000 );
+    QVERIFY( later.remaining( 20000 ) <= 10000 );
+
+    const QModbusDeadline soon( 50 );
+    TestSleep::pause( 100 );
+    QVERIFY( soon.hasExpired() );
+    QCOMPARE( soon.remaining( 100 ) , 0 );
+}
+
+void TestQModbusDeadline::cancellationToken( void )
+{
+    // Copies share their state.
+    QModbusCancellationToken token;
+    const QModbusCancellationToken copy = token;
+    QVERIFY( token.isCancellable() );
+    QVERIFY( !copy.isCancelled() );
+    token.cancel();
+    QVERIFY( copy.isCancelled() );
+    QVERIFY( !QModbusCancellationToken().isCancelled() );
+
+    QModbusCancellationToken none = QModbusCancellationToken::none();
+    QVERIFY( !none.isCancellable() );
+    none.cancel();
+    QVERIFY( !none.isCancelled() );
+}
+
+void TestQModbusDeadline::requestLimits( void )
+{
+    QModbusRequest request = QModbusRequest::readHoldingRegisters( 1 , 0 , 1 );
+    QVERIFY( !request.isLimited() );
+    QVERIFY( !request.cancellationToken().isCancellable() );
+    QCOMPARE( request.limitStatus() , (quint8)QAbstractModbus::Ok );
+
+    request.setDeadline( QModbusDeadline( 0 ) );
+    QVERIFY( request.isLimited() );
+    QCOMPARE( request.limitStatus() , (quint8)QAbstractModbus::Timeout );
+
+    QModbusCancellationToken token;
+    request.setCancellationToken( token );
+    QCOMPARE( request.limitStatus() , (quint8)QAbstractModbus::Timeout );
+
+    // A cancelled token wins over an expired deadline.
+    token.cancel();
+    QCOMPARE( request.limitStatus() , (quint8)QAbstractModbus::Cancelled );
+
+    request.setDeadline( QModbusDeadline() );
+    QVERIFY( request.isLimited() );
+    QCOMPARE( request.limitStatus() , (quint8)QAbstractModbus::Cancelled );
+}
+
+void TestQModbusDeadline::limitedRequestsAreNotSent( void )
+{
+    const QList<QModbusRequest> batch = QList<QModbusRequest>()
+        << QModbusRequest::readHoldingRegisters( 1 , 1 , 1 )
+        << limited( 1 , QModbusDeadline() , cancelled() )
+        << limited( 1 , QModbusDeadline( 0 ) , QModbusCancellationToken::none() )
+        << QModbusRequest::readHoldingRegisters( 1 , 4 , 1 );
+    const QList<quint8> expected = QList<quint8>() << QAbstractModbus::Ok << QAbstractModbus::Cancelled
+                                                   << QAbstractModbus::Timeout << QAbstractModbus::Ok;
+    QList<QModbusResponse> responses;
+
+    SimulatedModbus rtuDevice;
+    const Wire rtu( Wire::Rtu , rtuDevice );
+    QModbusRtuFraming().transact( rtu , batch , responses );
+    QCOMPARE( statuses( responses ) , expected );
+    QCOMPARE( rtu.writes , 2 );
+    QCOMPARE( rtuDevice.log() , QStringList() << "3 1 1" << "3 1 4" );
+
+    SimulatedModbus tcpDevice;
+    const Wire tcp( Wire::Tcp , tcpDevice );
+    QModbusTcpFraming::Transactions transactions;
+    responses.clear();
+    QModbusTcpFraming( transactions ).transact( tcp , batch , responses );
+    QCOMPARE( statuses( responses ) , expected );
+    QCOMPARE( tcp.writes , 1 );
+    QCOMPARE( tcpDevice.log() , QStringList() << "3 1 1" << "3 1 4" );
+
+    // The shared connection hands the limits to the transport.
+    SimulatedModbus sharedDevice;
+    const QModbusSharedConnection connection( sharedDevice );
+    QCOMPARE( statuses( connection.execute( batch ) ) , expected );
+    QCOMPARE( sharedDevice.log() , QStringList() << "3 1 1" << "3 1 4" );
+}
+
+void TestQModbusDeadline::tcpLimitedWindow( void )
+{
+    // The limited request goes out alone, the requests before and after it share windows.
+    SimulatedModbus device;
+    const Wire wire( Wire::Tcp , device );
+    QModbusTcpFraming::Transactions transactions;
+    QList<QModbusResponse> responses;
+    QModbusTcpFraming( transactions ).transact( wire , QList<QModbusRequest>()
+                                                << QModbusRequest::readHoldingRegisters( 1 , 0 , 1 )
+                                                << QModbusRequest::readHoldingRegisters( 1 , 1 , 1 )
+                                                << limited( 1 , QModbusDeadline( 10000 ) ,
+                                                            QModbusCancellationToken() )
+                                                << QModbusRequest::readHoldingRegisters( 1 , 3 , 1 )
+                                                << QModbusRequest::readHoldingRegisters( 1 , 4 , 1 ) ,
+                                                responses );
+    QCOMPARE( statuses( responses ) , QList<quint8>() << QAbstractModbus::Ok << QAbstractModbus::Ok
+                                                      << QAbstractModbus::Ok << QAbstractModbus::Ok
+                                                      << QAbstractModbus::Ok );
+    QCOMPARE( wire.writes , 3 );
+}
+
+void TestQModbusDeadline::tcpGiveUp( void )
+{
+    // The request to unit 2 is cancelled while it waits for its reply: its slot is freed, the late reply is dropped
+    // and the rest of the batch is executed.
+    SimulatedModbus device;
+    device.setRegister( 1 , 0 , 11 );
+    device.setRegister( 2 , 0 , 22 );
+    QModbusCancellationToken token;
+    Wire wire( Wire::Tcp , device );
+    wire.lateUnit = 2;
+    wire.cancelOnWrite = token;
+    QModbusTcpFraming::Transactions transactions;
+    QList<QModbusResponse> responses;
+    QModbusTcpFraming( transactions ).transact( wire , QList<QModbusRequest>()
+                                                << limited( 2 , QModbusDeadline() , token )
+                                                << QModbusRequest::readHoldingRegisters( 1 , 0 , 1 ) ,
+                                                responses );
+    QCOMPARE( statuses( responses ) , QList<quint8>() << QAbstractModbus::Cancelled << QAbstractModbus::Ok );
+    QCOMPARE( responses.at( 1 ).registers() , QList<quint16>() << 11 );
+    QCOMPARE( wire.writes , 2 );
+    QCOMPARE( transactions.pendingCount() , 0 );
+    QVERIFY( wire.received.isEmpty() );
+}
+
+void TestQModbusDeadline::rtuDrainsLateReply( void )
+{
+    // The late reply of the cancelled request is drained, it does not wait in the buffer for the next request.
+    SimulatedModbus device;
+    QModbusCancellationToken token;
+    Wire wire( Wire::Rtu , device );
+    wire.lateUnit = 2;
+    wire.cancelOnWrite = token;
+    QList<QModbusResponse> responses;
+    QModbusRtuFraming().transact( wire , QList<QModbusRequest>() << limited( 2 , QModbusDeadline() , token ) ,
+                                  responses );
+    QCOMPARE( statuses( responses ) , QList<quint8>() << QAbstractModbus::Cancelled );
+    QCOMPARE( wire.writes , 1 );
+    QVERIFY( wire.received.isEmpty() );
+    QVERIFY( wire.late.isEmpty() );
+}
+
+void TestQModbusDeadline::sharedConnection( void )
+{
+    SimulatedModbus modbus;
+    const QModbusSharedConnection connection( modbus );
+
+    // A request cancelled while queued behind another one is never sent.
+    modbus.closeGate();
+    const QModbusReplyPointer first = connection.submit( QModbusRequest::readHoldingRegisters( 1 , 0 , 1 ) );
+    QVERIFY( modbus.waitForHeld( 1 ) );
+    QModbusCancellationToken token;
+    const QModbusReplyPointer second = connection.submit( limited( 1 , QModbusDeadline() , token ) );
+    token.cancel();
+    modbus.openGate();
+    first->waitForFinished();
+    second->waitForFinished();
+    QCOMPARE( first->response().status() , (quint8)QAbstractModbus::Ok );
+    QCOMPARE( second->response().status() , (quint8)QAbstractModbus::Cancelled );
+    QCOMPARE( modbus.log() , QStringList() << "3 1 0" );
+
+    // A request waiting for its reply stops waiting once it is cancelled.
+    modbus.setLatency( 5000 );
+    QModbusCancellationToken slow;
+    const QModbusReplyPointer reply = connection.submit( limited( 1 , QModbusDeadline() , slow ) );
+    QVERIFY( modbus.waitForCalls( 2 ) );
+    QElapsedTimer clock;
+    clock.start();
+    slow.cancel();
+    reply->waitForFinished();
+    QCOMPARE( reply->response().status() , (quint8)QAbstractModbus::Cancelled );
+    QVERIFY( clock.elapsed() < 1000 );
+
+    // An expired deadline is a timeout.
+    const QModbusResponse expired = connection.execute( limited( 1 , QModbusDeadline( 100 ) ,
+                                                                 QModbusCancellationToken::none() ) );
+    QCOMPARE( expired.status() , (quint8)QAbstractModbus::Timeout );
+}
+
+QTEST_MAIN( TestQModbusDeadline )
+#include "tst_qmodbusdeadline.moc"
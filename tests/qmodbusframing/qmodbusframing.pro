@@ -0,0 +1,12 @@
+########################################################################################################################
+# tst_qmodbusframing : RTU and ASCII framing: CRC, LRC, encoding and decoding of frames.                               #
+########################################################################################################################
+# Author ........: QModbus contributors                                                                                #
+# Changes .......: -                                                                                                   #
+########################################################################################################################
+
+
+# FILES ################################################################################################################
+include( ../tests.pri )
+TARGET          = tst_qmodbusframing
+SOURCES        +=   tst_qmodbusframing.cpp
@@ -0,0 +1,272 @@
+/***********************************************************************************************************************
+* tst_qmodbusframing : RTU and ASCII framing: CRC, LRC, encoding and decoding of frames.                               *
+************************************************************************************************************************
+* Author : QModbus contributors                                                                                        *
+* Date   : 2026/10/18                                                                                                  *
+* Changes: -                                                                                                           *
+***********************************************************************************************************************/
+
+
+/*** Qt includes ******************************************************************************************************/
+#include <QModbusFraming>
+#include <QtTest/QtTest>
+
+
+/*** Helpers **********************************************************************************************************/
+// I/O policy replaying a recorded reply and recording what is written.
+class ScriptedIo
+{
+public:
+    explicit ScriptedIo( const QByteArray &reply ) : _reply( reply ) , _position( 0 ) {}
+
+    bool isOpen( void ) const
+    {
+        return true;
+    }
+
+    void discard( void ) const
+    {}
+
+    void limit( const QModbusDeadline &deadline , const QModbusCancellationToken &token ) const
+    {
+        Q_UNUSED( deadline );
+        Q_UNUSED( token );
+    }
+
+    int read( char *data , int size ) const
+    {
+        const int count = qMin( size , _reply.size() - _position );
+        memcpy( data , _reply.constData() + _position , count );
+        _position += count;
+        return count;
+    }
+
+    int readAll( char *data , int maxSize ) const
+    {
+        return read( data , maxSize );
+    }
+
+    int readLine( char *data , int maxSize ) const
+    {
+        const int end = _reply.indexOf( '\n' , _position );
+        const int available = ( end < 0 ? _reply.size() : end + 1 ) - _position;
+        const int count = read( data , qMin( available , maxSize - 1 ) );
+        data[count] = '\0';
+        return count;
+    }
+
+    bool write( const char *data , int size ) const
+    {
+        _written.append( data , size );
+        return true;
+    }
+
+    QByteArray written( void ) const
+    {
+        return _written;
+    }
+
+private:
+    QByteArray _reply;              // Bytes the device sends.
+    mutable int _position;          // Bytes of the reply read so far.
+    mutable QByteArray _written;    // Bytes sent to the device.
+};
+
+// Appends the CRC to an RTU frame given as hex.
+static QByteArray rtuFrame( const char *const hex )
+{
+    QByteArray frame = QByteArray::fromHex( hex );
+    const quint16 crc = QModbusRtuFraming::crc( frame.constData() , frame.size() );
+    frame.append( (char)( crc & 0xFF ) );
+    frame.append( (char)( crc >> 8 ) );
+    return frame;
+}
+
+// Builds an ASCII line from address and PDU given as hex.
+static QByteArray asciiLine( const char *const hex )
+{
+    const QByteArray frame = QByteArray::fromHex( hex );
+    QByteArray line( 2 * frame.size() + 2 , '\0' );
+    QModbusAsciiFraming::encodeFrame( frame.constData() , frame.size() , line.data() );
+    return ":" + line + "\r\n";
+}
+
+
+/*** Test class *******************************************************************************************************/
+class TestQModbusFraming : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void rtuCrc( void );
+    void rtuEncode( void );
+    void rtuDecode( void );
+    void rtuDecodeErrors( void );
+    void asciiLrc( void );
+    void asciiEncode( void );
+    void asciiFrameRoundTrip( void );
+    void asciiDecodeErrors( void );
+    void asciiDecode( void );
+};
+
+void TestQModbusFraming::rtuCrc( void )
+{
+    // The example of the modbus serial line specification: read 10 holding registers from address 0 of device 1.
+    const QByteArray frame = QByteArray::fromHex( "01030000000A" );
+    QCOMPARE( QModbusRtuFraming::crc( frame.constData() , frame.size() ) , (quint16)0xCDC5 );
+    QCOMPARE( QModbusRtuFraming::crc( frame.constData() , 0 ) , (quint16)0xFFFF );
+}
+
+void TestQModbusFraming::rtuEncode( void )
+{
+    const QByteArray pdu = QByteArray::fromHex( "030000000A" );
+    char adu[QModbusPdu::MaxRtuAduSize];
+    const int size = QModbusRtuFraming::encode( adu , 0x01 , pdu.constData() , pdu.size() );
+    QCOMPARE( QByteArray( adu , size ).toHex() , QByteArray( "01030000000ac5cd" ) );
+}
+
+void TestQModbusFraming::rtuDecode( void )
+{
+    const QByteArray request = QByteArray::fromHex( "0300000002" );
+    const ScriptedIo io( rtuFrame( "010304002A0100" ) );
+    QModbusPduFrame response;
+    const quint8 status = QModbusRtuFraming().transact( io , 0x01 , request.constData() , request.size() , 6 ,
+                                                        response );
+    QCOMPARE( status , (quint8)QAbstractModbus::Ok );
+    QCOMPARE( response.view().toByteArray().toHex() , QByteArray( "0304002a0100" ) );
+    QCOMPARE( io.written() , rtuFrame( "010300000002" ) );
+
+    // A response of unknown length is read to its end.
+    const ScriptedIo fifo( rtuFrame( "01180006000200010002" ) );
+    const QByteArray fifoRequest = QByteArray::fromHex( "180000" );
+    QCOMPARE( QModbusRtuFraming().transact( fifo , 0x01 , fifoRequest.constData() , fifoRequest.size() , -1 ,
+                                            response ) , (quint8)QAbstractModbus::Ok );
+    QCOMPARE( response.view().toByteArray().toHex() , QByteArray( "180006000200010002" ) );
+}
+
+void TestQModbusFraming::rtuDecodeErrors( void )
+{
+    const QByteArray request = QByteArray::fromHex( "0300000001" );
+    QModbusPduFrame response;
+
+    // Exception response.
+    const ScriptedIo exception( rtuFrame( "018302" ) );
+    QCOMPARE( QModbusRtuFraming().transact( exception , 0x01 , request.constData() , request.size() , 4 , response ) ,
+              (quint8)QAbstractModbus::IllegalDataAddress );
+
+    // Corrupted frame.
+    QByteArray corrupted = rtuFrame( "010302002A" );
+    corrupted[3] = corrupted[3] ^ 0x01;
+    const ScriptedIo crcError( corrupted );
+    QCOMPARE( QModbusRtuFraming().transact( crcError , 0x01 , request.constData() , request.size() , 4 , response ) ,
+              (quint8)QAbstractModbus::CrcError );
+
+    // Reply of another device.
+    const ScriptedIo otherDevice( rtuFrame( "020302002A" ) );
+    QCOMPARE( QModbusRtuFraming().transact( otherDevice , 0x01 , request.constData() , request.size() , 4 ,
+                                            response ) , (quint8)QAbstractModbus::UnknownError );
+
+    // No (complete) reply.
+    const ScriptedIo silent( QByteArray::fromHex( "0103" ) );
+    QCOMPARE( QModbusRtuFraming().transact( silent , 0x01 , request.constData() , request.size() , 4 , response ) ,
+              (quint8)QAbstractModbus::Timeout );
+}
+
+void TestQModbusFraming::asciiLrc( void )
+{
+    // 0x01 + 0x03 + 0x0A = 0x0E, the LRC is its two's complement.
+    const QByteArray frame = QByteArray::fromHex( "01030000000A" );
+    QCOMPARE( QModbusAsciiFraming::lrc( frame.constData() , frame.size() ) , (quint8)0xF2 );
+}
+
+void TestQModbusFraming::asciiEncode( void )
+{
+    const QByteArray pdu = QByteArray::fromHex( "030000000A" );
+    char line[QModbusPdu::MaxAsciiAduSize];
+    const int size = QModbusAsciiFraming::encode( line , 0x01 , pdu.constData() , pdu.size() );
+    QCOMPARE( QByteArray( line , size ) , QByteArray( ":01030000000AF2\r\n" ) );
+}
+
+void TestQModbusFraming::asciiFrameRoundTrip( void )
+{
+    // Every size, so the vectorized paths and their tails are all used.
+    for ( int size = 1 ; size <= QModbusPdu::MaxRtuAduSize - 2 ; size++ )
+    {
+        QByteArray frame( size , '\0' );
+        for ( int i = 0 ; i < size ; i++ ) frame[i] = (char)( ( i * 37 + size ) & 0xFF );
+
+        QByteArray hex( 2 * size + 2 , '\0' );
+        QCOMPARE( QModbusAsciiFraming::encodeFrame( frame.constData() , size , hex.data() ) , 2 * size + 2 );
+        QCOMPARE( hex.left( 2 * size ) , frame.toHex().toUpper() );
+
+        const quint8 lrc = QModbusAsciiFraming::lrc( frame.constData() , size );
+        QCOMPARE( hex.mid( 2 * size ) , QByteArray( 1 , (char)lrc ).toHex().toUpper() );
+
+        // Lower case is accepted as well.
+        const QByteArray lower = hex.toLower();
+        QByteArray decoded( size + 1 , '\0' );
+        QCOMPARE( QModbusAsciiFraming::decodeFrame( lower.constData() , lower.size() , decoded.data() ) , size + 1 );
+        QCOMPARE( decoded.left( size ) , frame );
+        QCOMPARE( (quint8)decoded.at( size ) , lrc );
+    }
+}
+
+void TestQModbusFraming::asciiDecodeErrors( void )
+{
+    char data[QModbusPdu::MaxRtuAduSize];
+    const QByteArray valid( "01030000000AF2" );
+    QCOMPARE( QModbusAsciiFraming::decodeFrame( valid.constData() , valid.size() , data ) , 7 );
+
+    // Odd number of characters.
+    QCOMPARE( QModbusAsciiFraming::decodeFrame( valid.constData() , valid.size() - 1 , data ) , -1 );
+
+    // Wrong LRC.
+    const QByteArray wrongLrc( "01030000000AF3" );
+    QCOMPARE( QModbusAsciiFraming::decodeFrame( wrongLrc.constData() , wrongLrc.size() , data ) , -1 );
+
+    // Not a hex digit, at the start, in the LRC and in the middle of a long frame (vectorized path).
+    QByteArray invalid( "G1030000000AF2" );
+    QCOMPARE( QModbusAsciiFraming::decodeFrame( invalid.constData() , invalid.size() , data ) , -1 );
+    invalid = "01030000000AFZ";
+    QCOMPARE( QModbusAsciiFraming::decodeFrame( invalid.constData() , invalid.size() , data ) , -1 );
+
+    const QByteArray frame( 40 , '\x5A' );
+    invalid.resize( 2 * frame.size() + 2 );
+    QModbusAsciiFraming::encodeFrame( frame.constData() , frame.size() , invalid.data() );
+    QCOMPARE( QModbusAsciiFraming::decodeFrame( invalid.constData() , invalid.size() , data ) , frame.size() + 1 );
+    invalid[37] = ':';
+    QCOMPARE( QModbusAsciiFraming::decodeFrame( invalid.constData() , invalid.size() , data ) , -1 );
+}
+
+void TestQModbusFraming::asciiDecode( void )
+{
+    const QByteArray request = QByteArray::fromHex( "0300000002" );
+    QModbusPduFrame response;
+
+    const ScriptedIo io( asciiLine( "010304002A0100" ) );
+    QCOMPARE( QModbusAsciiFraming().transact( io , 0x01 , request.constData() , request.size() , 6 , response ) ,
+              (quint8)QAbstractModbus::Ok );
+    QCOMPARE( response.view().toByteArray().toHex() , QByteArray( "0304002a0100" ) );
+    QCOMPARE( io.written() , QByteArray( ":010300000002FA\r\n" ) );
+
+    const ScriptedIo exception( asciiLine( "018302" ) );
+    QCOMPARE( QModbusAsciiFraming().transact( exception , 0x01 , request.constData() , request.size() , 6 ,
+                                              response ) , (quint8)QAbstractModbus::IllegalDataAddress );
+
+    QByteArray corrupted = asciiLine( "010304002A0100" );
+    corrupted[5] = 'F';
+    const ScriptedIo lrcError( corrupted );
+    QCOMPARE( QModbusAsciiFraming().transact( lrcError , 0x01 , request.constData() , request.size() , 6 ,
+                                              response ) , (quint8)QAbstractModbus::CrcError );
+
+    const ScriptedIo otherDevice( asciiLine( "020304002A0100" ) );
+    QCOMPARE( QModbusAsciiFraming().transact( otherDevice , 0x01 , request.constData() , request.size() , 6 ,
+                                              response ) , (quint8)QAbstractModbus::UnknownError );
+
+    const ScriptedIo silent( QByteArray( ":0103" ) );
+    QCOMPARE( QModbusAsciiFraming().transact( silent , 0x01 , request.constData() , request.size() , 6 , response ) ,
+              (quint8)QAbstractModbus::Timeout );
+}
+
+QTEST_MAIN( TestQModbusFraming )
+#include "tst_qmodbusframing.moc"
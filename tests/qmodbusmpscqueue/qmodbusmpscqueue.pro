@@ -0,0 +1,12 @@
+########################################################################################################################
+# tst_qmodbusmpscqueue : Multiple producer single consumer queue.                                                      #
+########################################################################################################################
+# Author ........: QModbus contributors                                                                                #
+# Changes .......: -                                                                                                   #
+########################################################################################################################
+
+
+# FILES ################################################################################################################
+include( ../tests.pri )
+TARGET          = tst_qmodbusmpscqueue
+SOURCES        +=   tst_qmodbusmpscqueue.cpp
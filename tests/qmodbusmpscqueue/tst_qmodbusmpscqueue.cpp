@@ -0,0 +1,154 @@
+/***********************************************************************************************************************
+* tst_qmodbusmpscqueue : Order and completeness of the lock-free multi-producer single-consumer queue.                 *
+************************************************************************************************************************
+* Author : QModbus contributors                                                                                        *
+* Date   : 2026/10/18                                                                                                  *
+* Changes: -                                                                                                           *
+***********************************************************************************************************************/
+
+
+/*** Qt includes ******************************************************************************************************/
+#include <QModbusMpscQueue>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QThread>
+#include <QtTest/QtTest>
+
+
+/*** Helpers **********************************************************************************************************/
+// Queue element recording who pushed it in which order.
+class Item : public QModbusMpscNode
+{
+public:
+    Item( const int producer , const int sequence ) : producer( producer ) , sequence( sequence ) {}
+
+    int producer;                   // Index of the pushing thread.
+    int sequence;                   // Position in the pushes of that thread.
+};
+
+// Thread pushing items with increasing sequence numbers.
+class Producer : public QThread
+{
+public:
+    Producer( QModbusMpscQueue<Item> &queue , const int producer , const int count ) :
+        _queue( queue ) , _producer( producer ) , _count( count ) {}
+
+protected:
+    void run( void )
+    {
+        for ( int i = 0 ; i < _count ; i++ ) _queue.push( new Item( _producer , i ) );
+    }
+
+private:
+    QModbusMpscQueue<Item> &_queue; // Queue to push to.
+    int _producer;                  // Index of the thread.
+    int _count;                     // Number of items to push.
+};
+
+
+/*** Test class *******************************************************************************************************/
+class TestQModbusMpscQueue : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void empty( void );
+    void fifoOrder( void );
+    void reuseAfterDrain( void );
+    void concurrentProducers( void );
+};
+
+void TestQModbusMpscQueue::empty( void )
+{
+    QModbusMpscQueue<Item> queue;
+    QVERIFY( !queue.pop() );
+    QVERIFY( !queue.pop() );
+}
+
+void TestQModbusMpscQueue::fifoOrder( void )
+{
+    QModbusMpscQueue<Item> queue;
+    Item first( 0 , 0 );
+    Item second( 0 , 1 );
+    Item third( 0 , 2 );
+    queue.push( &first );
+    queue.push( &second );
+    queue.push( &third );
+
+    QCOMPARE( queue.pop() , &first );
+    QCOMPARE( queue.pop() , &second );
+    QCOMPARE( queue.pop() , &third );
+    QVERIFY( !queue.pop() );
+}
+
+void TestQModbusMpscQueue::reuseAfterDrain( void )
+{
+    // Single elements exercise the hand over through the stub node, the same node can be pushed again once popped.
+    QModbusMpscQueue<Item> queue;
+    Item item( 0 , 0 );
+    for ( int i = 0 ; i < 5 ; i++ )
+    {
+        queue.push( &item );
+        QCOMPARE( queue.pop() , &item );
+        QVERIFY( !queue.pop() );
+    }
+
+    Item first( 0 , 0 );
+    Item second( 0 , 1 );
+    queue.push( &first );
+    QCOMPARE( queue.pop() , &first );
+    queue.push( &second );
+    queue.push( &first );
+    QCOMPARE( queue.pop() , &second );
+    QCOMPARE( queue.pop() , &first );
+    QVERIFY( !queue.pop() );
+}
+
+void TestQModbusMpscQueue::concurrentProducers( void )
+{
+    const int producerCount = 4;
+    const int itemCount = 100000;
+    QModbusMpscQueue<Item> queue;
+    QList<Producer *> producers;
+    for ( int i = 0 ; i < producerCount ; i++ ) producers.append( new Producer( queue , i , itemCount ) );
+    foreach ( Producer *producer , producers ) producer->start();
+
+    // Pop while the producers push: every item arrives once, the items of each producer in their order. pop() may
+    // return NULL while a push is in progress, so the consumer retries until all items are there.
+    QList<int> next;
+    for ( int i = 0 ; i < producerCount ; i++ ) next.append( 0 );
+    int received = 0;
+    bool ordered = true;
+    QElapsedTimer guard;
+    guard.start();
+    while ( received < producerCount * itemCount && guard.elapsed() < 10000 )
+    {
+        Item *const item = queue.pop();
+        if ( !item )
+        {
+            QThread::yieldCurrentThread();
+            continue;
+        }
+        if ( item->sequence != next.at( item->producer ) ) ordered = false;
+        next[item->producer] = item->sequence + 1;
+        received++;
+        delete item;
+    }
+
+    foreach ( Producer *producer , producers )
+    {
+        producer->wait();
+        delete producer;
+    }
+    while ( Item *const item = queue.pop() )
+    {
+        received++;
+        delete item;
+    }
+
+    QVERIFY( ordered );
+    QCOMPARE( received , producerCount * itemCount );
+    for ( int i = 0 ; i < producerCount ; i++ ) QCOMPARE( next.at( i ) , itemCount );
+}
+
+QTEST_MAIN( TestQModbusMpscQueue )
+#include "tst_qmodbusmpscqueue.moc"
@@ -0,0 +1,12 @@
+########################################################################################################################
+# tst_qmodbuspdu : Request PDU layouts and response sizes.                                                             #
+########################################################################################################################
+# Author ........: QModbus contributors                                                                                #
+# Changes .......: -                                                                                                   #
+########################################################################################################################
+
+
+# FILES ################################################################################################################
+include( ../tests.pri )
+TARGET          = tst_qmodbuspdu
+SOURCES        +=   tst_qmodbuspdu.cpp
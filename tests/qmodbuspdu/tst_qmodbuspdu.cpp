@@ -0,0 +1,189 @@
+/***********************************************************************************************************************
+* tst_qmodbuspdu : Request PDU layouts, request factories and response sizes.                                          *
+************************************************************************************************************************
+* Author : QModbus contributors                                                                                        *
+* Date   : 2026/10/18                                                                                                  *
+* Changes: -                                                                                                           *
+***********************************************************************************************************************/
+
+
+/*** Qt includes ******************************************************************************************************/
+#include <QModbusPdu>
+#include <QModbusRequest>
+#include <QtTest/QtTest>
+
+
+/*** Helpers **********************************************************************************************************/
+// Returns the expected response size of a request PDU given as hex.
+static int responseSize( const char *const hex )
+{
+    const QByteArray pdu = QByteArray::fromHex( hex );
+    return QModbusPdu::responseSize( pdu.constData() , pdu.size() );
+}
+
+
+/*** Test class *******************************************************************************************************/
+class TestQModbusPdu : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void putGet( void );
+    void responseSizes( void );
+    void responseSizeOfShortRequests( void );
+    void readRegistersLayout( void );
+    void writeMultipleLayout( void );
+    void readWriteLayout( void );
+    void requestFactories( void );
+    void invalidRequests( void );
+    void fifoQueue( void );
+};
+
+void TestQModbusPdu::putGet( void )
+{
+    char buffer[2];
+    QModbusPdu::put( buffer , 0xA55A );
+    QCOMPARE( (quint8)buffer[0] , (quint8)0xA5 );
+    QCOMPARE( (quint8)buffer[1] , (quint8)0x5A );
+    QCOMPARE( QModbusPdu::get( buffer ) , (quint16)0xA55A );
+}
+
+void TestQModbusPdu::responseSizes( void )
+{
+    // Bits: function code, byte count and the bits packed into bytes.
+    QCOMPARE( responseSize( "0100130001" ) , 3 );
+    QCOMPARE( responseSize( "0100130008" ) , 3 );
+    QCOMPARE( responseSize( "0100130009" ) , 4 );
+    QCOMPARE( responseSize( "02000007D0" ) , 252 );
+
+    // Registers: function code, byte count and two bytes per register.
+    QCOMPARE( responseSize( "030000000A" ) , 22 );
+    QCOMPARE( responseSize( "040000007D" ) , 252 );
+
+    // Writes echo address and quantity or value.
+    QCOMPARE( responseSize( "0500ACFF00" ) , 5 );
+    QCOMPARE( responseSize( "0600010003" ) , 5 );
+    QCOMPARE( responseSize( "0F0013000A02CD01" ) , 5 );
+    QCOMPARE( responseSize( "100001000204000A0102" ) , 5 );
+    QCOMPARE( responseSize( "160004F2F00025" ) , 7 );
+
+    // Read/write: the registers read, whatever the number of registers written.
+    QCOMPARE( responseSize( "170003000600" "0E0003" "06" "00FF00FF00FF" ) , 14 );
+    QCOMPARE( responseSize( "170003000100" "0E0003" "06" "00FF00FF00FF" ) , 4 );
+
+    // The size of other responses is not known in advance.
+    QCOMPARE( responseSize( "1804DE" ) , -1 );
+    QCOMPARE( responseSize( "2B0E0100" ) , -1 );
+}
+
+void TestQModbusPdu::responseSizeOfShortRequests( void )
+{
+    QCOMPARE( QModbusPdu::responseSize( "" , 0 ) , -1 );
+    QCOMPARE( responseSize( "01001300" ) , -1 );
+    QCOMPARE( responseSize( "030000" ) , -1 );
+    QCOMPARE( responseSize( "1700030006" ) , 14 );
+    QCOMPARE( responseSize( "17000300" ) , -1 );
+}
+
+void TestQModbusPdu::readRegistersLayout( void )
+{
+    QCOMPARE( (int)QModbusReadRegistersPdu::MaxPduSize , 5 );
+
+    char pdu[QModbusPdu::MaxSize];
+    const int size = QModbusReadRegistersPdu::encode( pdu , 0x03 , 0x006B , 3 );
+    QCOMPARE( QByteArray( pdu , size ).toHex() , QByteArray( "03006b0003" ) );
+}
+
+void TestQModbusPdu::writeMultipleLayout( void )
+{
+    QCOMPARE( (int)QModbusWriteMultiplePdu::MaxPduSize , QModbusPdu::MaxSize - 1 );
+
+    char pdu[QModbusPdu::MaxSize];
+    QModbusWriteMultiplePdu::encode( pdu , 0x10 , 0x0001 , 2 );
+    const int size = QModbusWriteMultiplePdu::setDataSize( pdu , 4 );
+    char *data = QModbusWriteMultiplePdu::data( pdu );
+    QModbusPdu::put( data , 0x000A );
+    QModbusPdu::put( data + 2 , 0x0102 );
+    QCOMPARE( QByteArray( pdu , size ).toHex() , QByteArray( "100001000204000a0102" ) );
+}
+
+void TestQModbusPdu::readWriteLayout( void )
+{
+    // Read start, quantity to read, write start, quantity to write, byte count at offset 9, then the data.
+    char pdu[QModbusPdu::MaxSize];
+    QModbusReadWritePdu::encode( pdu , 0x17 , 0x0003 , 6 , 0x000E , 3 );
+    const int size = QModbusReadWritePdu::setDataSize( pdu , 6 );
+    QCOMPARE( (int)( QModbusReadWritePdu::data( pdu ) - pdu ) , 10 );
+    QCOMPARE( size , 16 );
+    QCOMPARE( (quint8)pdu[9] , (quint8)6 );
+    QCOMPARE( QModbusPdu::responseSize( pdu , size ) , 14 );
+}
+
+void TestQModbusPdu::requestFactories( void )
+{
+    // Examples of the modbus application protocol specification.
+    QModbusRequest request = QModbusRequest::readHoldingRegisters( 0x11 , 0x006B , 3 );
+    QVERIFY( request.isValid() );
+    QCOMPARE( request.deviceAddress() , (quint8)0x11 );
+    QCOMPARE( request.functionCode() , (quint8)0x03 );
+    QCOMPARE( request.pdu().toByteArray().toHex() , QByteArray( "03006b0003" ) );
+
+    QList<bool> coils;
+    coils << true << false << true << true << false << false << true << true << true << false;
+    request = QModbusRequest::writeMultipleCoils( 0x11 , 0x0013 , coils );
+    QCOMPARE( request.pdu().toByteArray().toHex() , QByteArray( "0f0013000a02cd01" ) );
+
+    QList<quint16> registers;
+    registers << 0x000A << 0x0102;
+    request = QModbusRequest::writeMultipleRegisters( 0x11 , 0x0001 , registers );
+    QCOMPARE( request.pdu().toByteArray().toHex() , QByteArray( "100001000204000a0102" ) );
+
+    request = QModbusRequest::maskWriteRegister( 0x11 , 0x0004 , 0x00F2 , 0x0025 );
+    QCOMPARE( request.pdu().toByteArray().toHex() , QByteArray( "16000400f20025" ) );
+
+    registers.clear();
+    registers << 0x00FF << 0x00FF << 0x00FF;
+    request = QModbusRequest::writeReadMultipleRegisters( 0x11 , 0x000E , registers , 0x0003 , 6 );
+    QCOMPARE( request.pdu().toByteArray().toHex() , QByteArray( "170003000600" "0e000306" "00ff00ff00ff" ) );
+
+    request = QModbusRequest::readFifoQueue( 0x11 , 0x04DE );
+    QCOMPARE( request.pdu().toByteArray().toHex() , QByteArray( "1804de" ) );
+}
+
+void TestQModbusPdu::invalidRequests( void )
+{
+    QList<bool> coils;
+    for ( int i = 0 ; i < 1969 ; i++ ) coils.append( true );
+    QVERIFY( !QModbusRequest::writeMultipleCoils( 0x01 , 0 , coils ).isValid() );
+    coils.removeLast();
+    QVERIFY( QModbusRequest::writeMultipleCoils( 0x01 , 0 , coils ).isValid() );
+
+    QList<quint16> registers;
+    for ( int i = 0 ; i < 124 ; i++ ) registers.append( (quint16)i );
+    QVERIFY( !QModbusRequest::writeMultipleRegisters( 0x01 , 0 , registers ).isValid() );
+    registers.removeLast();
+    QVERIFY( QModbusRequest::writeMultipleRegisters( 0x01 , 0 , registers ).isValid() );
+
+    while ( registers.count() > 122 ) registers.removeLast();
+    QVERIFY( !QModbusRequest::writeReadMultipleRegisters( 0x01 , 0 , registers , 0 , 1 ).isValid() );
+    registers.removeLast();
+    QVERIFY( QModbusRequest::writeReadMultipleRegisters( 0x01 , 0 , registers , 0 , 1 ).isValid() );
+
+    QCOMPARE( QModbusRequest().functionCode() , (quint8)0 );
+}
+
+void TestQModbusPdu::fifoQueue( void )
+{
+    // Function code, byte count, FIFO count and the registers.
+    const QByteArray pdu = QByteArray::fromHex( "1800060002" "01b81284" );
+    QList<quint16> expected;
+    expected << 0x01B8 << 0x1284;
+    QCOMPARE( QModbusResponse( QAbstractModbus::Ok , QModbusFrameView( pdu ) ).fifoQueue() , expected );
+
+    // Inconsistent counts.
+    const QByteArray wrongCount = QByteArray::fromHex( "1800060003" "01b81284" );
+    QVERIFY( QModbusResponse( QAbstractModbus::Ok , QModbusFrameView( wrongCount ) ).fifoQueue().isEmpty() );
+}
+
+QTEST_MAIN( TestQModbusPdu )
+#include "tst_qmodbuspdu.moc"
@@ -0,0 +1,12 @@
+########################################################################################################################
+# tst_qmodbuspollscheduler : Deadline order, overruns, overload policies and merging of the poll scheduler.            #
+########################################################################################################################
+# Author ........: QModbus contributors                                                                                #
+# Changes .......: -                                                                                                   #
+########################################################################################################################
+
+
+# FILES ################################################################################################################
+include( ../tests.pri )
+TARGET          = tst_qmodbuspollscheduler
+SOURCES        +=   tst_qmodbuspollscheduler.cpp
@@ -0,0 +1,279 @@
+/***********************************************************************************************************************
+* tst_qmodbuspollscheduler : Deadline order, overruns, overload policies and merging of the poll scheduler.            *
+************************************************************************************************************************
+* Author : QModbus contributors                                                                                        *
+* Date   : 2026/10/18                                                                                                  *
+* Changes: -                                                                                                           *
+***********************************************************************************************************************/
+
+
+/*** Qt includes ******************************************************************************************************/
+#include <QModbusPollScheduler>
+#include <QtTest/QtTest>
+
+
+/*** Test includes ****************************************************************************************************/
+#include "simulatedmodbus.h"
+
+
+/*** Helpers **********************************************************************************************************/
+// Listener recording the register samples it gets.
+class Recorder : public QModbusListener
+{
+public:
+    void registersReceived( const int id , const quint16 startingAddress , const QList<quint16> &values ,
+                            const quint8 status )
+    {
+        Q_UNUSED( startingAddress );
+        ids.append( id );
+        samples.append( values );
+        statuses.append( status );
+        changed.append( QList<int>() );
+    }
+
+    void registersChanged( const int id , const quint16 startingAddress , const QList<quint16> &values ,
+                           const QList<int> &indices )
+    {
+        registersReceived( id , startingAddress , values , QAbstractModbus::Ok );
+        changed.last() = indices;
+    }
+
+    QList<int> ids;                 // Job of each sample.
+    QList<QList<quint16> > samples; // Register values of each sample.
+    QList<quint8> statuses;         // Status of each sample.
+    QList<QList<int> > changed;     // Changed indices of each sample, empty unless change-only.
+};
+
+
+/*** Test class *******************************************************************************************************/
+class TestQModbusPollScheduler : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void invalidJobs( void );
+    void earliestDeadlineFirst( void );
+    void overrunsKeepThePhase( void );
+    void dropLate( void );
+    void lateJobsAreMerged( void );
+    void removeJob( void );
+    void changeOnlyDelivery( void );
+    void capabilities( void );
+    void timer( void );
+};
+
+void TestQModbusPollScheduler::invalidJobs( void )
+{
+    SimulatedModbus modbus;
+    QModbusPollScheduler scheduler;
+    Recorder recorder;
+    QCOMPARE( scheduler.addJob( modbus , 1 , QAbstractModbus::HoldingRegisters , 0 , 0 , 100 , &recorder ) , -1 );
+    QCOMPARE( scheduler.addJob( modbus , 1 , QAbstractModbus::HoldingRegisters , 0 , 126 , 100 , &recorder ) , -1 );
+    QCOMPARE( scheduler.addJob( modbus , 1 , QAbstractModbus::HoldingRegisters , 0xFFFF , 2 , 100 , &recorder ) ,
+              -1 );
+    QCOMPARE( scheduler.addJob( modbus , 1 , QAbstractModbus::HoldingRegisters , 0 , 1 , 0 , &recorder ) , -1 );
+    QCOMPARE( scheduler.addJob( modbus , 1 , QAbstractModbus::HoldingRegisters , 0 , 1 , 100 , NULL ) , -1 );
+    QCOMPARE( scheduler.jobCount() , 0 );
+    QCOMPARE( scheduler.statistics( 1 ).samples , (quint64)0 );
+}
+
+void TestQModbusPollScheduler::earliestDeadlineFirst( void )
+{
+    SimulatedModbus modbus;
+    QModbusPollScheduler scheduler;
+    Recorder recorder;
+    const int slow = scheduler.addJob( modbus , 1 , QAbstractModbus::HoldingRegisters , 0 , 1 , 100 , &recorder );
+    const int fast = scheduler.addJob( modbus , 2 , QAbstractModbus::HoldingRegisters , 0 , 1 , 30 , &recorder );
+    QCOMPARE( scheduler.jobCount() , 2 );
+
+    // Both are due at once.
+    QCOMPARE( scheduler.processDue() , 2 );
+    QCOMPARE( scheduler.statistics( slow ).samples , (quint64)1 );
+    QCOMPARE( scheduler.statistics( slow ).lastPeriod , (qint64)-1 );
+
+    // Then only the fast one.
+    TestSleep::pause( 35 );
+    QCOMPARE( scheduler.processDue() , 1 );
+    QCOMPARE( recorder.ids.last() , fast );
+
+    // When both are late, the earlier deadline (60) goes before the later one (100).
+    TestSleep::pause( 70 );
+    modbus.clearLog();
+    QCOMPARE( scheduler.processDue() , 2 );
+    QCOMPARE( modbus.log() , QStringList() << "3 2 0" << "3 1 0" );
+    QCOMPARE( scheduler.statistics( fast ).samples , (quint64)3 );
+    QVERIFY( scheduler.statistics( fast ).overruns >= 1 );
+    QVERIFY( scheduler.statistics( slow ).lastPeriod >= 100 );
+    QCOMPARE( scheduler.statistics( slow ).period , 100 );
+}
+
+void TestQModbusPollScheduler::overrunsKeepThePhase( void )
+{
+    SimulatedModbus modbus;
+    QModbusPollScheduler scheduler;
+    Recorder recorder;
+    const int id = scheduler.addJob( modbus , 1 , QAbstractModbus::HoldingRegisters , 0 , 1 , 40 , &recorder );
+    QCOMPARE( scheduler.processDue() , 1 );
+
+    // Three deadlines passed: the job runs once, the missed ones are counted and skipped.
+    TestSleep::pause( 130 );
+    QCOMPARE( scheduler.processDue() , 1 );
+    QCOMPARE( scheduler.processDue() , 0 );
+    const QModbusPollScheduler::Statistics statistics = scheduler.statistics( id );
+    QCOMPARE( statistics.samples , (quint64)2 );
+    QVERIFY( statistics.overruns >= 2 );
+    QVERIFY( statistics.averageLateness > 0.0 );
+    QVERIFY( statistics.maximumJitter >= 80 );
+
+    // The next deadline stays on the grid of the period: at most one period from now.
+    TestSleep::pause( 45 );
+    QCOMPARE( scheduler.processDue() , 1 );
+}
+
+void TestQModbusPollScheduler::dropLate( void )
+{
+    SimulatedModbus modbus;
+    QModbusPollScheduler scheduler;
+    scheduler.setOverloadPolicy( QModbusPollScheduler::DropLate , 10 );
+    QCOMPARE( scheduler.overloadPolicy() , QModbusPollScheduler::DropLate );
+    Recorder recorder;
+    const int id = scheduler.addJob( modbus , 1 , QAbstractModbus::HoldingRegisters , 0 , 1 , 30 , &recorder );
+    QCOMPARE( scheduler.processDue() , 1 );
+
+    // A cycle later than the tolerance is dropped.
+    TestSleep::pause( 50 );
+    QCOMPARE( scheduler.processDue() , 0 );
+    QCOMPARE( scheduler.statistics( id ).dropped , (quint64)1 );
+    QCOMPARE( scheduler.statistics( id ).samples , (quint64)1 );
+    QCOMPARE( recorder.ids.count() , 1 );
+    QCOMPARE( modbus.callCount() , 1 );
+}
+
+void TestQModbusPollScheduler::lateJobsAreMerged( void )
+{
+    SimulatedModbus modbus;
+    SimulatedModbus other;
+    for ( quint16 i = 0 ; i < 20 ; i++ ) modbus.setRegister( 1 , i , i );
+    QModbusPollScheduler scheduler;
+    Recorder recorder;
+    const int a = scheduler.addJob( modbus , 1 , QAbstractModbus::HoldingRegisters , 0 , 10 , 100 , &recorder );
+    const int b = scheduler.addJob( modbus , 1 , QAbstractModbus::HoldingRegisters , 10 , 5 , 50 , &recorder );
+    const int c = scheduler.addJob( modbus , 1 , QAbstractModbus::InputRegisters , 0 , 10 , 100 , &recorder );
+    const int d = scheduler.addJob( other , 1 , QAbstractModbus::HoldingRegisters , 0 , 10 , 100 , &recorder );
+
+    // Adjacent ranges of the same connection, device and table share the request.
+    QCOMPARE( scheduler.processDue() , 3 );
+    QCOMPARE( modbus.callCount() , 2 );
+    QCOMPARE( other.callCount() , 1 );
+    QCOMPARE( scheduler.statistics( a ).merged , (quint64)1 );
+    QCOMPARE( scheduler.statistics( b ).merged , (quint64)1 );
+    QCOMPARE( scheduler.statistics( c ).merged , (quint64)0 );
+    QCOMPARE( scheduler.statistics( d ).merged , (quint64)0 );
+
+    // Each job gets its own range.
+    QCOMPARE( recorder.samples.at( recorder.ids.indexOf( a ) ).count() , 10 );
+    QCOMPARE( recorder.samples.at( recorder.ids.indexOf( b ) ) , QList<quint16>() << 10 << 11 << 12 << 13 << 14 );
+}
+
+void TestQModbusPollScheduler::removeJob( void )
+{
+    SimulatedModbus modbus;
+    QModbusPollScheduler scheduler;
+    Recorder recorder;
+    const int a = scheduler.addJob( modbus , 1 , QAbstractModbus::HoldingRegisters , 0 , 1 , 10 , &recorder );
+    const int b = scheduler.addJob( modbus , 2 , QAbstractModbus::HoldingRegisters , 0 , 1 , 10 , &recorder );
+    scheduler.removeJob( a );
+    QCOMPARE( scheduler.jobCount() , 1 );
+    QCOMPARE( scheduler.processDue() , 1 );
+    QCOMPARE( recorder.ids , QList<int>() << b );
+    QCOMPARE( scheduler.statistics( a ).samples , (quint64)0 );
+
+    // Many removals do not let the heap grow.
+    for ( int i = 0 ; i < 100 ; i++ )
+    {
+        scheduler.removeJob( scheduler.addJob( modbus , 3 , QAbstractModbus::HoldingRegisters , 0 , 1 , 10 ,
+                                               &recorder ) );
+    }
+    QCOMPARE( scheduler.jobCount() , 1 );
+    TestSleep::pause( 15 );
+    QCOMPARE( scheduler.processDue() , 1 );
+}
+
+void TestQModbusPollScheduler::changeOnlyDelivery( void )
+{
+    SimulatedModbus modbus;
+    QModbusPollScheduler scheduler;
+    Recorder recorder;
+    const int id = scheduler.addJob( modbus , 1 , QAbstractModbus::HoldingRegisters , 0 , 2 , 10 , &recorder );
+    QVERIFY( scheduler.setChangeFilter( id , QModbusChangeFilter() ) );
+    QVERIFY( !scheduler.setChangeFilter( id + 1 , QModbusChangeFilter() ) );
+
+    scheduler.processDue();
+    QCOMPARE( recorder.changed.last() , QList<int>() << 0 << 1 );
+    TestSleep::pause( 15 );
+    scheduler.processDue();
+    QCOMPARE( recorder.ids.count() , 1 );
+
+    modbus.setRegister( 1 , 1 , 7 );
+    TestSleep::pause( 15 );
+    scheduler.processDue();
+    QCOMPARE( recorder.ids.count() , 2 );
+    QCOMPARE( recorder.changed.last() , QList<int>() << 1 );
+
+    // Failures are always reported.
+    modbus.setSilent( 1 );
+    TestSleep::pause( 15 );
+    scheduler.processDue();
+    QCOMPARE( recorder.ids.count() , 3 );
+    QCOMPARE( recorder.statuses.last() , (quint8)QAbstractModbus::Timeout );
+
+    scheduler.clearChangeFilter( id );
+    modbus.setSilent( 1 , false );
+    TestSleep::pause( 15 );
+    scheduler.processDue();
+    TestSleep::pause( 15 );
+    scheduler.processDue();
+    QCOMPARE( recorder.ids.count() , 5 );
+}
+
+void TestQModbusPollScheduler::capabilities( void )
+{
+    SimulatedModbus modbus;
+    QModbusCapabilityCache cache;
+    cache.setMaximumQuantity( 1 , 0x03 , 10 );
+    QModbusPollScheduler scheduler;
+    scheduler.setCapabilities( modbus , &cache );
+    Recorder recorder;
+
+    QCOMPARE( scheduler.addJob( modbus , 1 , QAbstractModbus::HoldingRegisters , 0 , 11 , 100 , &recorder ) , -1 );
+    scheduler.addJob( modbus , 1 , QAbstractModbus::HoldingRegisters , 0 , 8 , 100 , &recorder );
+    scheduler.addJob( modbus , 1 , QAbstractModbus::HoldingRegisters , 8 , 8 , 100 , &recorder );
+
+    // The merged request would exceed what the device accepts.
+    QCOMPARE( scheduler.processDue() , 2 );
+    foreach ( quint8 status , recorder.statuses ) QCOMPARE( status , (quint8)QAbstractModbus::Ok );
+}
+
+void TestQModbusPollScheduler::timer( void )
+{
+    SimulatedModbus modbus;
+    QModbusPollScheduler scheduler;
+    Recorder recorder;
+    const int id = scheduler.addJob( modbus , 1 , QAbstractModbus::HoldingRegisters , 0 , 1 , 50 , &recorder );
+    QVERIFY( !scheduler.isActive() );
+
+    scheduler.start();
+    QVERIFY( scheduler.isActive() );
+    QTest::qWait( 275 );
+    QVERIFY( recorder.ids.count() >= 4 && recorder.ids.count() <= 7 );
+    const QModbusPollScheduler::Statistics statistics = scheduler.statistics( id );
+    QVERIFY( statistics.averagePeriod >= 45.0 && statistics.averagePeriod <= 75.0 );
+
+    scheduler.stop();
+    const int count = recorder.ids.count();
+    QTest::qWait( 100 );
+    QCOMPARE( recorder.ids.count() , count );
+}
+
+QTEST_MAIN( TestQModbusPollScheduler )
+#include "tst_qmodbuspollscheduler.moc"
@@ -0,0 +1,12 @@
+########################################################################################################################
+# tst_qmodbusratelimiter : Token buckets, backoff and request parking of the rate limiter.                             #
+########################################################################################################################
+# Author ........: QModbus contributors                                                                                #
+# Changes .......: -                                                                                                   #
+########################################################################################################################
+
+
+# FILES ################################################################################################################
+include( ../tests.pri )
+TARGET          = tst_qmodbusratelimiter
+SOURCES        +=   tst_qmodbusratelimiter.cpp
@@ -0,0 +1,205 @@
+/***********************************************************************************************************************
+* tst_qmodbusratelimiter : Token buckets, backoff and request parking of the rate limiter.                             *
+************************************************************************************************************************
+* Author : QModbus contributors                                                                                        *
+* Date   : 2026/10/18                                                                                                  *
+* Changes: -                                                                                                           *
+***********************************************************************************************************************/
+
+
+/*** Qt includes ******************************************************************************************************/
+#include <QModbusRateLimiter>
+#include <QModbusSharedConnection>
+#include <QtCore/QElapsedTimer>
+#include <QtTest/QtTest>
+
+
+/*** Test includes ****************************************************************************************************/
+#include "simulatedmodbus.h"
+
+
+/*** Helpers **********************************************************************************************************/
+// Returns a read of a single holding register.
+static QModbusRequest read( const quint8 unit , const quint16 address )
+{
+    return QModbusRequest::readHoldingRegisters( unit , address , 1 );
+}
+
+// Returns true if a wait is the expected one, the clock may have advanced by a few milliseconds meanwhile.
+static bool around( const int wait , const int expected )
+{
+    return wait <= expected && wait >= expected - 20;
+}
+
+
+/*** Test class *******************************************************************************************************/
+class TestQModbusRateLimiter : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void noLimits( void );
+    void requestRate( void );
+    void burst( void );
+    void byteRate( void );
+    void unitLimits( void );
+    void backoff( void );
+    void parking( void );
+    void busyUnitIsPaused( void );
+};
+
+void TestQModbusRateLimiter::noLimits( void )
+{
+    QModbusRateLimiter limiter;
+    QCOMPARE( limiter.burst() , 0 );
+    QCOMPARE( limiter.maximumBackoff() , 5000 );
+    for ( int i = 0 ; i < 100 ; i++ ) QCOMPARE( limiter.reserve( read( 1 , 0 ) ) , 0 );
+    QCOMPARE( limiter.unitScale( 1 ) , 1.0 );
+}
+
+void TestQModbusRateLimiter::requestRate( void )
+{
+    // Without a burst the requests are evenly spaced, each one waits for the previous ones.
+    QModbusRateLimiter limiter;
+    limiter.setConnectionLimit( 10 );
+    QCOMPARE( limiter.reserve( read( 1 , 0 ) ) , 0 );
+    QVERIFY( around( limiter.reserve( read( 2 , 0 ) ) , 100 ) );
+    QVERIFY( around( limiter.reserve( read( 3 , 0 ) ) , 200 ) );
+
+    // The debt is paid back over time.
+    TestSleep::pause( 350 );
+    QCOMPARE( limiter.reserve( read( 1 , 0 ) ) , 0 );
+}
+
+void TestQModbusRateLimiter::burst( void )
+{
+    // After an idle time, 300 ms worth of requests go at once: three tokens, and one more on the empty bucket.
+    QModbusRateLimiter limiter;
+    limiter.setConnectionLimit( 10 );
+    limiter.setBurst( 300 );
+    QCOMPARE( limiter.burst() , 300 );
+    TestSleep::pause( 400 );
+    for ( int i = 0 ; i < 4 ; i++ ) QCOMPARE( limiter.reserve( read( 1 , 0 ) ) , 0 );
+    QVERIFY( around( limiter.reserve( read( 1 , 0 ) ) , 100 ) );
+}
+
+void TestQModbusRateLimiter::byteRate( void )
+{
+    // Reading ten registers costs 5 bytes of request and 22 bytes of response.
+    QModbusRateLimiter limiter;
+    limiter.setConnectionLimit( 0 , 100 );
+    const QModbusRequest request = QModbusRequest::readHoldingRegisters( 1 , 0 , 10 );
+    QCOMPARE( limiter.reserve( request ) , 0 );
+    QVERIFY( around( limiter.reserve( request ) , 270 ) );
+}
+
+void TestQModbusRateLimiter::unitLimits( void )
+{
+    QModbusRateLimiter limiter;
+    limiter.setDefaultUnitLimit( 10 );
+    limiter.setUnitLimit( 1 , 5 );
+    limiter.setUnitLimit( 2 , 0 );
+
+    // Every unit has a bucket of its own, a unit with its own limits does not use the default ones.
+    QCOMPARE( limiter.reserve( read( 1 , 0 ) ) , 0 );
+    QCOMPARE( limiter.reserve( read( 2 , 0 ) ) , 0 );
+    QCOMPARE( limiter.reserve( read( 3 , 0 ) ) , 0 );
+    QCOMPARE( limiter.reserve( read( 4 , 0 ) ) , 0 );
+    QVERIFY( around( limiter.reserve( read( 1 , 1 ) ) , 200 ) );
+    QCOMPARE( limiter.reserve( read( 2 , 1 ) ) , 0 );
+    QVERIFY( around( limiter.reserve( read( 3 , 1 ) ) , 100 ) );
+}
+
+void TestQModbusRateLimiter::backoff( void )
+{
+    QModbusRateLimiter limiter;
+    limiter.setMaximumBackoff( 10 );
+    QCOMPARE( limiter.maximumBackoff() , 100 );
+    limiter.setMaximumBackoff( 400 );
+
+    // A busy unit is paused and its rates are halved, the pause doubles up to the maximum.
+    const QModbusRequest request = read( 1 , 0 );
+    limiter.report( request , QModbusResponse( QAbstractModbus::SlaveDeviceBusy ) );
+    QCOMPARE( limiter.unitScale( 1 ) , 0.5 );
+    QVERIFY( around( limiter.reserve( request ) , 100 ) );
+    limiter.report( request , QModbusResponse( QAbstractModbus::GatewayTargetDeviceFailedToRespond ) );
+    QVERIFY( around( limiter.reserve( request ) , 200 ) );
+    limiter.report( request , QModbusResponse( QAbstractModbus::SlaveDeviceBusy ) );
+    limiter.report( request , QModbusResponse( QAbstractModbus::SlaveDeviceBusy ) );
+    QVERIFY( around( limiter.reserve( request ) , 400 ) );
+    QCOMPARE( limiter.unitScale( 1 ) , 1.0 / 16 );
+    QCOMPARE( limiter.reserve( read( 2 , 0 ) ) , 0 );
+
+    // Other failures do not count, a success gives back a sixteenth of the rates.
+    limiter.report( request , QModbusResponse( QAbstractModbus::Timeout ) );
+    limiter.report( request , QModbusResponse( QAbstractModbus::IllegalDataAddress ) );
+    QCOMPARE( limiter.unitScale( 1 ) , 1.0 / 16 );
+    limiter.report( request , QModbusResponse( QAbstractModbus::Ok ) );
+    QCOMPARE( limiter.unitScale( 1 ) , 2.0 / 16 );
+    limiter.report( request , QModbusResponse( QAbstractModbus::SlaveDeviceBusy ) );
+    QVERIFY( around( limiter.reserve( request ) , 100 ) );
+
+    // The rates are never below 1/64.
+    for ( int i = 0 ; i < 10 ; i++ ) limiter.report( request , QModbusResponse( QAbstractModbus::SlaveDeviceBusy ) );
+    QCOMPARE( limiter.unitScale( 1 ) , 1.0 / 64 );
+}
+
+void TestQModbusRateLimiter::parking( void )
+{
+    SimulatedModbus modbus;
+    QModbusRateLimiter limiter;
+    limiter.setUnitLimit( 1 , 5 );
+    QModbusSharedConnection connection( modbus );
+    connection.setRateLimiter( &limiter );
+    QCOMPARE( connection.rateLimiter() , &limiter );
+
+    // The requests to unit 1 are parked and spaced by 200 ms, the requests to unit 2 do not wait for them.
+    QElapsedTimer clock;
+    clock.start();
+    QList<QModbusReplyPointer> slow;
+    QList<QModbusReplyPointer> fast;
+    for ( quint16 i = 0 ; i < 3 ; i++ )
+    {
+        slow.append( connection.submit( read( 1 , i ) ) );
+        fast.append( connection.submit( read( 2 , i ) ) );
+    }
+    foreach ( const QModbusReplyPointer &reply , fast ) QVERIFY( reply->waitForFinished( 5000 ) );
+    QVERIFY( clock.elapsed() < 150 );
+    QVERIFY( !slow.last()->isFinished() );
+
+    foreach ( const QModbusReplyPointer &reply , slow )
+    {
+        QVERIFY( reply->waitForFinished( 5000 ) );
+        QCOMPARE( reply->response().status() , (quint8)QAbstractModbus::Ok );
+    }
+    QVERIFY( clock.elapsed() >= 380 );
+
+    // The parked requests of a unit keep their order.
+    QStringList unit1;
+    foreach ( const QString &entry , modbus.log() ) if ( entry.startsWith( "3 1 " ) ) unit1.append( entry );
+    QCOMPARE( unit1 , QStringList() << "3 1 0" << "3 1 1" << "3 1 2" );
+    QCOMPARE( modbus.log().last() , QString( "3 1 2" ) );
+}
+
+void TestQModbusRateLimiter::busyUnitIsPaused( void )
+{
+    // The connection reports the responses: a busy reply pauses the unit.
+    SimulatedModbus modbus;
+    QModbusRateLimiter limiter;
+    QModbusSharedConnection connection( modbus );
+    connection.setRateLimiter( &limiter );
+    modbus.failNext( QAbstractModbus::SlaveDeviceBusy );
+    QCOMPARE( connection.execute( read( 1 , 0 ) ).status() , (quint8)QAbstractModbus::SlaveDeviceBusy );
+    QCOMPARE( limiter.unitScale( 1 ) , 0.5 );
+
+    QElapsedTimer clock;
+    clock.start();
+    QCOMPARE( connection.execute( read( 2 , 0 ) ).status() , (quint8)QAbstractModbus::Ok );
+    QVERIFY( clock.elapsed() < 50 );
+    QCOMPARE( connection.execute( read( 1 , 0 ) ).status() , (quint8)QAbstractModbus::Ok );
+    QVERIFY( clock.elapsed() >= 70 );
+    QCOMPARE( limiter.unitScale( 1 ) , 0.5 + 1.0 / 16 );
+}
+
+QTEST_MAIN( TestQModbusRateLimiter )
+#include "tst_qmodbusratelimiter.moc"
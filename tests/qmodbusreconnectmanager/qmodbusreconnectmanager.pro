@@ -0,0 +1,13 @@
+########################################################################################################################
+# tst_qmodbusreconnectmanager : Parallel connects, reconnects and backoff of the reconnect manager.                    #
+########################################################################################################################
+# Author ........: QModbus contributors                                                                                #
+# Changes .......: -                                                                                                   #
+########################################################################################################################
+
+
+# FILES ################################################################################################################
+include( ../tests.pri )
+TARGET          = tst_qmodbusreconnectmanager
+SOURCES        +=   tst_qmodbusreconnectmanager.cpp
+QT             += network                       # Local TCP server the transports connect to.
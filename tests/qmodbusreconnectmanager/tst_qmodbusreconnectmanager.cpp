@@ -0,0 +1,155 @@
+/***********************************************************************************************************************
+* tst_qmodbusreconnectmanager : Parallel connects, reconnects and backoff of the reconnect manager.                    *
+************************************************************************************************************************
+* Author : QModbus contributors                                                                                        *
+* Date   : 2026/10/18                                                                                                  *
+* Changes: -                                                                                                           *
+***********************************************************************************************************************/
+
+
+/*** Qt includes ******************************************************************************************************/
+#include <QModbusReconnectManager>
+#include <QTcpModbus>
+#include <QtNetwork/QTcpServer>
+#include <QtNetwork/QTcpSocket>
+#include <QtTest/QtTest>
+
+
+/*** Helpers **********************************************************************************************************/
+// Runs the event loop until a spy recorded the given number of signals, false if that did not happen in time.
+static bool waitForSignals( const QSignalSpy &spy , const int count , const int msecs = 5000 )
+{
+    for ( int i = 0 ; i < msecs / 10 && spy.count() < count ; i++ ) QTest::qWait( 10 );
+    return spy.count() >= count;
+}
+
+// Returns a local port nobody listens on.
+static quint16 unusedPort( void )
+{
+    QTcpServer server;
+    server.listen( QHostAddress::LocalHost );
+    const quint16 port = server.serverPort();
+    server.close();
+    return port;
+}
+
+
+/*** Test class *******************************************************************************************************/
+class TestQModbusReconnectManager : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void coldStart( void );
+    void reconnectAfterLoss( void );
+    void backoff( void );
+    void removeConnection( void );
+};
+
+void TestQModbusReconnectManager::coldStart( void )
+{
+    QTcpServer server;
+    QVERIFY( server.listen( QHostAddress::LocalHost ) );
+    QModbusReconnectManager manager;
+    QSignalSpy connected( &manager , SIGNAL( connected( QTcpModbus * ) ) );
+    QSignalSpy allConnected( &manager , SIGNAL( allConnected() ) );
+
+    // The connects run in parallel, the calls return at once.
+    QList<QTcpModbus *> transports;
+    for ( int i = 0 ; i < 3 ; i++ )
+    {
+        QTcpModbus *const modbus = new QTcpModbus;
+        modbus->connectToHost( "127.0.0.1" , server.serverPort() );
+        QVERIFY( modbus->isConnecting() );
+        manager.addConnection( modbus );
+        transports.append( modbus );
+    }
+    manager.addConnection( transports.first() );
+    QCOMPARE( manager.connectionCount() , 3 );
+    QCOMPARE( manager.connectedCount() , 0 );
+
+    QVERIFY( waitForSignals( allConnected , 1 ) );
+    QCOMPARE( connected.count() , 3 );
+    QCOMPARE( manager.connectedCount() , 3 );
+    foreach ( QTcpModbus *modbus , transports ) QVERIFY( modbus->isConnected() );
+    qDeleteAll( transports );
+}
+
+void TestQModbusReconnectManager::reconnectAfterLoss( void )
+{
+    QTcpServer server;
+    QVERIFY( server.listen( QHostAddress::LocalHost ) );
+    QTcpModbus modbus;
+    QVERIFY( modbus.connect( "127.0.0.1" , server.serverPort() ) );
+    QVERIFY( server.waitForNewConnection( 5000 ) );
+    QTcpSocket *const peer = server.nextPendingConnection();
+
+    QModbusReconnectManager manager;
+    manager.setInitialDelay( 20 );
+    QSignalSpy connected( &manager , SIGNAL( connected( QTcpModbus * ) ) );
+    QSignalSpy disconnected( &manager , SIGNAL( disconnected( QTcpModbus * ) ) );
+    manager.addConnection( &modbus );
+    QCOMPARE( manager.connectedCount() , 1 );
+
+    // The server drops the connection: the manager reports it and connects again.
+    peer->abort();
+    QVERIFY( waitForSignals( disconnected , 1 ) );
+    QCOMPARE( manager.connectedCount() , 0 );
+    QVERIFY( waitForSignals( connected , 1 ) );
+    QCOMPARE( manager.connectedCount() , 1 );
+    QVERIFY( modbus.isConnected() );
+    QCOMPARE( modbus.port() , server.serverPort() );
+}
+
+void TestQModbusReconnectManager::backoff( void )
+{
+    const quint16 port = unusedPort();
+    QTcpModbus modbus;
+    QSignalSpy failures( &modbus , SIGNAL( connectFailed() ) );
+    modbus.connectToHost( "127.0.0.1" , port );
+
+    QModbusReconnectManager manager;
+    manager.setInitialDelay( 25 );
+    manager.setMaximumDelay( 200 );
+    QCOMPARE( manager.initialDelay() , 25 );
+    QCOMPARE( manager.maximumDelay() , 200 );
+    QSignalSpy connected( &manager , SIGNAL( connected( QTcpModbus * ) ) );
+    manager.addConnection( &modbus );
+
+    // Refused connects are retried with growing delays (at least half of 25, 50, 100, 200, 200... ms): far fewer
+    // attempts than the refusals alone would allow, but more than one.
+    QTest::qWait( 1000 );
+    QVERIFY( failures.count() >= 3 );
+    QVERIFY( failures.count() <= 16 );
+    QCOMPARE( connected.count() , 0 );
+
+    // Once the endpoint is up, the next attempt, at most the maximum delay later, connects.
+    QTcpServer server;
+    QVERIFY( server.listen( QHostAddress::LocalHost , port ) );
+    QVERIFY( waitForSignals( connected , 1 , 2000 ) );
+    QVERIFY( modbus.isConnected() );
+}
+
+void TestQModbusReconnectManager::removeConnection( void )
+{
+    const quint16 port = unusedPort();
+    QTcpModbus modbus;
+    QSignalSpy failures( &modbus , SIGNAL( connectFailed() ) );
+    modbus.connectToHost( "127.0.0.1" , port );
+
+    QModbusReconnectManager manager;
+    manager.setInitialDelay( 10 );
+    manager.addConnection( &modbus );
+    QVERIFY( waitForSignals( failures , 2 ) );
+
+    // No attempt after the transport was removed.
+    manager.removeConnection( &modbus );
+    QCOMPARE( manager.connectionCount() , 0 );
+    QTest::qWait( 100 );
+    const int count = failures.count();
+    QTest::qWait( 300 );
+    QCOMPARE( failures.count() , count );
+}
+
+QTEST_MAIN( TestQModbusReconnectManager )
+#include "tst_qmodbusreconnectmanager.moc"
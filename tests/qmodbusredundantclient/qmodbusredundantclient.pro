@@ -0,0 +1,12 @@
+########################################################################################################################
+# tst_qmodbusredundantclient : Failover and hedged reads across the paths of the redundant client.                     #
+########################################################################################################################
+# Author ........: QModbus contributors                                                                                #
+# Changes .......: -                                                                                                   #
+########################################################################################################################
+
+
+# FILES ################################################################################################################
+include( ../tests.pri )
+TARGET          = tst_qmodbusredundantclient
+SOURCES        +=   tst_qmodbusredundantclient.cpp
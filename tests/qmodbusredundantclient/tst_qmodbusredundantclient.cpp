@@ -0,0 +1,171 @@
+/***********************************************************************************************************************
+* tst_qmodbusredundantclient : Failover and hedged reads across the paths of the redundant client.                     *
+************************************************************************************************************************
+* Author : QModbus contributors                                                                                        *
+* Date   : 2026/10/18                                                                                                  *
+* Changes: -                                                                                                           *
+***********************************************************************************************************************/
+
+
+/*** Qt includes ******************************************************************************************************/
+#include <QModbusRedundantClient>
+#include <QtTest/QtTest>
+
+
+/*** Test includes ****************************************************************************************************/
+#include "simulatedmodbus.h"
+
+
+/*** Helpers **********************************************************************************************************/
+// Reads until the client has a hedge delay, both paths answer at once meanwhile.
+static bool warmUp( const QModbusRedundantClient &client )
+{
+    for ( int i = 0 ; i < 64 && client.hedgeDelay() < 0 ; i++ ) client.readHoldingRegisters( 1 , 0 , 1 );
+    return client.hedgeDelay() >= 0;
+}
+
+
+/*** Test class *******************************************************************************************************/
+class TestQModbusRedundantClient : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void failover( void );
+    void writesAreNotRepeated( void );
+    void hedgeDelay( void );
+    void stalledPrimaryIsMarkedDown( void );
+    void cancelledHedgesKeepPathHealthy( void );
+};
+
+void TestQModbusRedundantClient::failover( void )
+{
+    SimulatedModbus primary;
+    SimulatedModbus secondary;
+    secondary.setRegister( 1 , 0 , 42 );
+    QModbusRedundantClient client( QList<QAbstractModbus *>() << &primary << &secondary );
+    client.setFailureThreshold( 2 );
+    QCOMPARE( client.pathCount() , 2 );
+    QCOMPARE( client.primaryPath() , 0 );
+
+    // A read that fails on the primary path is retried on the next one.
+    primary.setSilent( 1 );
+    quint8 status = QAbstractModbus::UnknownError;
+    QCOMPARE( client.readHoldingRegisters( 1 , 0 , 1 , &status ) , QList<quint16>() << 42 );
+    QCOMPARE( status , (quint8)QAbstractModbus::Ok );
+    QCOMPARE( client.failoverCount() , (quint64)1 );
+    QVERIFY( client.isPathHealthy( 0 ) );
+
+    // After the failure threshold the primary path is marked down and the next path takes over.
+    QCOMPARE( client.readHoldingRegisters( 1 , 0 , 1 , &status ) , QList<quint16>() << 42 );
+    QVERIFY( !client.isPathHealthy( 0 ) );
+    QCOMPARE( client.primaryPath() , 1 );
+    const int primaryCalls = primary.callCount();
+    QCOMPARE( client.readHoldingRegisters( 1 , 0 , 1 , &status ) , QList<quint16>() << 42 );
+    QCOMPARE( primary.callCount() , primaryCalls );
+
+    // A device exception is an answer, not a path failure.
+    secondary.failNext( QAbstractModbus::IllegalDataAddress );
+    client.readHoldingRegisters( 1 , 0 , 1 , &status );
+    QCOMPARE( status , (quint8)QAbstractModbus::IllegalDataAddress );
+    QVERIFY( client.isPathHealthy( 1 ) );
+}
+
+void TestQModbusRedundantClient::writesAreNotRepeated( void )
+{
+    SimulatedModbus primary;
+    SimulatedModbus secondary;
+    QModbusRedundantClient client( QList<QAbstractModbus *>() << &primary << &secondary );
+
+    primary.setSilent( 1 );
+    quint8 status = QAbstractModbus::UnknownError;
+    QVERIFY( !client.writeSingleRegister( 1 , 0 , 7 , &status ) );
+    QCOMPARE( status , (quint8)QAbstractModbus::Timeout );
+    QCOMPARE( secondary.callCount() , 0 );
+    QCOMPARE( client.failoverCount() , (quint64)0 );
+}
+
+void TestQModbusRedundantClient::hedgeDelay( void )
+{
+    SimulatedModbus primary;
+    SimulatedModbus secondary;
+    QModbusRedundantClient client( QList<QAbstractModbus *>() << &primary << &secondary );
+    client.setHedgingEnabled( true );
+    client.setMinimumHedgeDelay( 5 );
+    QCOMPARE( client.hedgeDelay() , -1 );
+
+    // Fast answers: the hedge delay is about the minimum.
+    QVERIFY( warmUp( client ) );
+    QVERIFY( client.hedgeDelay() >= 5 && client.hedgeDelay() < 20 );
+
+    // A read the primary does not answer within the hedge delay is sent to the next path as well.
+    const quint64 hedges = client.hedgeCount();
+    primary.setLatency( 100 );
+    secondary.setRegister( 1 , 0 , 42 );
+    QElapsedTimer clock;
+    clock.start();
+    QCOMPARE( client.readHoldingRegisters( 1 , 0 , 1 ) , QList<quint16>() << 42 );
+    QVERIFY( clock.elapsed() < 100 );
+    QCOMPARE( client.hedgeCount() , hedges + 1 );
+
+    // Writes are never hedged.
+    QVERIFY( client.writeSingleRegister( 1 , 1 , 7 ) );
+    QCOMPARE( client.hedgeCount() , hedges + 1 );
+}
+
+void TestQModbusRedundantClient::stalledPrimaryIsMarkedDown( void )
+{
+    SimulatedModbus primary;
+    SimulatedModbus secondary;
+    QModbusRedundantClient client( QList<QAbstractModbus *>() << &primary << &secondary );
+    client.setHedgingEnabled( true );
+    client.setMinimumHedgeDelay( 5 );
+    client.setFailureThreshold( 3 );
+    QVERIFY( warmUp( client ) );
+
+    // The hedges rescue every read, the primary attempts they overtook count as failures of the primary path.
+    primary.setLatency( 200 );
+    for ( int i = 0 ; i < 3 ; i++ )
+    {
+        quint8 status = QAbstractModbus::UnknownError;
+        client.readHoldingRegisters( 1 , 0 , 1 , &status );
+        QCOMPARE( status , (quint8)QAbstractModbus::Ok );
+    }
+    TestSleep::pause( 100 );
+    QVERIFY( !client.isPathHealthy( 0 ) );
+    QVERIFY( client.isPathHealthy( 1 ) );
+    QCOMPARE( client.primaryPath() , 1 );
+}
+
+void TestQModbusRedundantClient::cancelledHedgesKeepPathHealthy( void )
+{
+    SimulatedModbus primary;
+    SimulatedModbus secondary;
+    QModbusRedundantClient client( QList<QAbstractModbus *>() << &primary << &secondary );
+    client.setHedgingEnabled( true );
+    client.setMinimumHedgeDelay( 5 );
+    client.setFailureThreshold( 3 );
+    QVERIFY( warmUp( client ) );
+
+    // The primary answers after the hedge was sent but before the slower secondary: every hedge is cancelled. That
+    // tells nothing about the secondary, which must stay healthy. Fewer reads than it takes to update the hedge delay.
+    const quint64 hedges = client.hedgeCount();
+    primary.setLatency( 20 );
+    secondary.setLatency( 200 );
+    for ( int i = 0 ; i < 6 ; i++ )
+    {
+        quint8 status = QAbstractModbus::UnknownError;
+        client.readHoldingRegisters( 1 , 0 , 1 , &status );
+        QCOMPARE( status , (quint8)QAbstractModbus::Ok );
+    }
+    QCOMPARE( client.hedgeCount() , hedges + 6 );
+
+    // Let the cancelled hedges finish on the secondary path.
+    TestSleep::pause( 300 );
+    QVERIFY( client.isPathHealthy( 0 ) );
+    QVERIFY( client.isPathHealthy( 1 ) );
+    QCOMPARE( client.primaryPath() , 0 );
+}
+
+QTEST_MAIN( TestQModbusRedundantClient )
+#include "tst_qmodbusredundantclient.moc"
@@ -0,0 +1,12 @@
+########################################################################################################################
+# tst_qmodbusretryclient : Retry policy, backoff, budgets and statistics of the retry client.                          #
+########################################################################################################################
+# Author ........: QModbus contributors                                                                                #
+# Changes .......: -                                                                                                   #
+########################################################################################################################
+
+
+# FILES ################################################################################################################
+include( ../tests.pri )
+TARGET          = tst_qmodbusretryclient
+SOURCES        +=   tst_qmodbusretryclient.cpp
@@ -0,0 +1,251 @@
+/***********************************************************************************************************************
+* tst_qmodbusretryclient : Retry policy, backoff, budgets and statistics of the retry client.                          *
+************************************************************************************************************************
+* Author : QModbus contributors                                                                                        *
+* Date   : 2026/10/18                                                                                                  *
+* Changes: -                                                                                                           *
+***********************************************************************************************************************/
+
+
+/*** Qt includes ******************************************************************************************************/
+#include <QModbusRetryClient>
+#include <QtCore/QElapsedTimer>
+#include <QtTest/QtTest>
+
+
+/*** Test includes ****************************************************************************************************/
+#include "simulatedmodbus.h"
+
+
+/*** Helpers **********************************************************************************************************/
+// Returns the delays announced by the retrying() signals recorded.
+static QList<int> delays( const QSignalSpy &spy )
+{
+    QList<int> delays;
+    for ( int i = 0 ; i < spy.count() ; i++ ) delays.append( spy.at( i ).at( 4 ).toInt() );
+    return delays;
+}
+
+
+/*** Test class *******************************************************************************************************/
+class TestQModbusRetryClient : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void settings( void );
+    void crcErrorsAreRetriedAtOnce( void );
+    void backoff( void );
+    void maximumRetries( void );
+    void finalStatuses( void );
+    void retryBudget( void );
+    void deadlineEndsRetries( void );
+    void statistics( void );
+};
+
+void TestQModbusRetryClient::settings( void )
+{
+    SimulatedModbus modbus;
+    QModbusRetryClient client( modbus );
+    QCOMPARE( client.maximumRetries() , 3 );
+    QCOMPARE( client.timeoutBackoff() , 50 );
+    QCOMPARE( client.busyDelay() , 200 );
+    QCOMPARE( client.maximumDelay() , 2000 );
+    QCOMPARE( client.retryBudgetRatio() , 0.1 );
+    QCOMPARE( client.retryBudgetMaximum() , 10 );
+    QCOMPARE( client.retryBudget( 1 ) , 10.0 );
+
+    client.setMaximumRetries( 20 );
+    QCOMPARE( client.maximumRetries() , 16 );
+    client.setMaximumRetries( -1 );
+    QCOMPARE( client.maximumRetries() , 0 );
+    client.setRetryBudget( -1 , -1 );
+    QCOMPARE( client.retryBudgetRatio() , 0.0 );
+    QCOMPARE( client.retryBudgetMaximum() , 0 );
+}
+
+void TestQModbusRetryClient::crcErrorsAreRetriedAtOnce( void )
+{
+    SimulatedModbus modbus;
+    modbus.setRegister( 1 , 0 , 42 );
+    modbus.failNext( QAbstractModbus::CrcError , 2 );
+    QModbusRetryClient client( modbus );
+    QSignalSpy retrying( &client , SIGNAL( retrying( int , int , int , int , int ) ) );
+
+    quint8 status = QAbstractModbus::UnknownError;
+    QCOMPARE( client.readHoldingRegisters( 1 , 0 , 1 , &status ) , QList<quint16>() << 42 );
+    QCOMPARE( status , (quint8)QAbstractModbus::Ok );
+    QCOMPARE( modbus.callCount() , 3 );
+    QCOMPARE( retrying.count() , 2 );
+    QCOMPARE( retrying.at( 0 ).at( 0 ).toInt() , 1 );
+    QCOMPARE( retrying.at( 0 ).at( 1 ).toInt() , 3 );
+    QCOMPARE( retrying.at( 0 ).at( 2 ).toInt() , (int)QAbstractModbus::CrcError );
+    QCOMPARE( retrying.at( 1 ).at( 3 ).toInt() , 2 );
+    QCOMPARE( delays( retrying ) , QList<int>() << 0 << 0 );
+}
+
+void TestQModbusRetryClient::backoff( void )
+{
+    SimulatedModbus modbus;
+    QModbusRetryClient client( modbus );
+    client.setTimeoutBackoff( 20 );
+    client.setBusyDelay( 10 );
+    client.setMaximumDelay( 50 );
+    QSignalSpy retrying( &client , SIGNAL( retrying( int , int , int , int , int ) ) );
+
+    // The delay doubles with every retry, up to the maximum.
+    modbus.failNext( QAbstractModbus::Timeout , 3 );
+    QElapsedTimer clock;
+    clock.start();
+    QVERIFY( client.writeSingleRegister( 1 , 0 , 5 ) );
+    QVERIFY( clock.elapsed() >= 100 );
+    QCOMPARE( delays( retrying ) , QList<int>() << 20 << 40 << 50 );
+
+    // Busy devices have delays of their own, Acknowledge counts as busy.
+    retrying.clear();
+    modbus.failNext( QAbstractModbus::SlaveDeviceBusy );
+    modbus.failNext( QAbstractModbus::Acknowledge );
+    QVERIFY( client.writeSingleRegister( 1 , 0 , 6 ) );
+    QCOMPARE( delays( retrying ) , QList<int>() << 10 << 20 );
+    QCOMPARE( modbus.registerValue( 1 , 0 ) , (quint16)6 );
+}
+
+void TestQModbusRetryClient::maximumRetries( void )
+{
+    SimulatedModbus modbus;
+    modbus.failNext( QAbstractModbus::Timeout , 5 );
+    QModbusRetryClient client( modbus );
+    client.setTimeoutBackoff( 0 );
+    client.setMaximumRetries( 2 );
+
+    quint8 status = QAbstractModbus::Ok;
+    client.readHoldingRegisters( 1 , 0 , 1 , &status );
+    QCOMPARE( status , (quint8)QAbstractModbus::Timeout );
+    QCOMPARE( modbus.callCount() , 3 );
+    QCOMPARE( client.statistics().exhausted , (quint64)1 );
+    QCOMPARE( client.statistics().recovered , (quint64)0 );
+}
+
+void TestQModbusRetryClient::finalStatuses( void )
+{
+    SimulatedModbus modbus;
+    QModbusRetryClient client( modbus );
+    client.setTimeoutBackoff( 0 );
+    client.setBusyDelay( 0 );
+    quint8 status = QAbstractModbus::Ok;
+
+    // Exceptions are final.
+    modbus.failNext( QAbstractModbus::IllegalDataAddress );
+    client.readHoldingRegisters( 1 , 0 , 1 , &status );
+    QCOMPARE( status , (quint8)QAbstractModbus::IllegalDataAddress );
+    QCOMPARE( modbus.callCount() , 1 );
+
+    // A FIFO read that may have been executed is not repeated, a busy device did not execute it.
+    modbus.failNext( QAbstractModbus::Timeout );
+    client.readFifoQueue( 1 , 100 , &status );
+    QCOMPARE( status , (quint8)QAbstractModbus::Timeout );
+    QCOMPARE( modbus.callCount() , 2 );
+    modbus.failNext( QAbstractModbus::SlaveDeviceBusy );
+    client.readFifoQueue( 1 , 100 , &status );
+    QCOMPARE( status , (quint8)QAbstractModbus::Ok );
+    QCOMPARE( modbus.callCount() , 4 );
+    QCOMPARE( client.statistics().retries , (quint64)1 );
+}
+
+void TestQModbusRetryClient::retryBudget( void )
+{
+    SimulatedModbus modbus;
+    QModbusRetryClient client( modbus );
+    client.setRetryBudget( 0.5 , 2 );
+    QSignalSpy exhausted( &client , SIGNAL( retryBudgetExhausted( int ) ) );
+
+    // The full budget allows two retries, the third one is not sent.
+    modbus.failNext( QAbstractModbus::CrcError , 4 );
+    quint8 status = QAbstractModbus::Ok;
+    client.readHoldingRegisters( 1 , 0 , 1 , &status );
+    QCOMPARE( status , (quint8)QAbstractModbus::CrcError );
+    QCOMPARE( modbus.callCount() , 3 );
+    QCOMPARE( client.retryBudget( 1 ) , 0.0 );
+    QCOMPARE( exhausted.count() , 1 );
+    QCOMPARE( exhausted.at( 0 ).at( 0 ).toInt() , 1 );
+    QCOMPARE( client.statistics( 1 ).budgetExhausted , (quint64)1 );
+
+    // The budget of a device does not limit the others: the last scripted CRC error is retried.
+    modbus.clearLog();
+    QCOMPARE( client.retryBudget( 2 ) , 2.0 );
+    QVERIFY( client.writeSingleRegister( 2 , 0 , 1 , &status ) );
+    QCOMPARE( modbus.callCount() , 2 );
+
+    // Each request refills the budget by the ratio: two requests later, device 1 gets one retry again.
+    modbus.clearLog();
+    QVERIFY( client.writeSingleRegister( 1 , 0 , 1 ) );
+    QCOMPARE( client.retryBudget( 1 ) , 0.5 );
+    modbus.failNext( QAbstractModbus::CrcError , 2 );
+    client.readHoldingRegisters( 1 , 0 , 1 , &status );
+    QCOMPARE( status , (quint8)QAbstractModbus::CrcError );
+    QCOMPARE( modbus.callCount() , 3 );
+    QCOMPARE( client.retryBudget( 1 ) , 0.0 );
+    QCOMPARE( exhausted.count() , 2 );
+}
+
+void TestQModbusRetryClient::deadlineEndsRetries( void )
+{
+    // The wait for a retry ends at the deadline of the request, the request fails with Timeout.
+    SimulatedModbus modbus;
+    modbus.failNext( QAbstractModbus::Timeout );
+    QModbusRetryClient client( modbus );
+    client.setTimeoutBackoff( 1000 );
+    QModbusRequest request = QModbusRequest::readHoldingRegisters( 1 , 0 , 1 );
+    request.setDeadline( QModbusDeadline( 100 ) );
+    QElapsedTimer clock;
+    clock.start();
+    QCOMPARE( client.execute( request ).status() , (quint8)QAbstractModbus::Timeout );
+    QVERIFY( clock.elapsed() < 500 );
+    QCOMPARE( modbus.callCount() , 1 );
+
+    // A cancelled request is not retried at all.
+    QModbusCancellationToken token;
+    token.cancel();
+    request.setDeadline( QModbusDeadline() );
+    request.setCancellationToken( token );
+    QCOMPARE( client.execute( request ).status() , (quint8)QAbstractModbus::Cancelled );
+    QCOMPARE( client.statistics().retries , (quint64)1 );
+}
+
+void TestQModbusRetryClient::statistics( void )
+{
+    SimulatedModbus modbus;
+    QModbusRetryClient client( modbus );
+    client.setTimeoutBackoff( 0 );
+    client.setBusyDelay( 0 );
+
+    modbus.failNext( QAbstractModbus::CrcError );
+    QVERIFY( client.writeSingleRegister( 1 , 0 , 1 ) );
+    modbus.failNext( QAbstractModbus::Timeout );
+    modbus.failNext( QAbstractModbus::SlaveDeviceBusy );
+    QVERIFY( client.writeSingleRegister( 2 , 0 , 1 ) );
+    QVERIFY( client.writeSingleRegister( 2 , 1 , 1 ) );
+
+    const QModbusRetryClient::Statistics first = client.statistics( 1 );
+    QCOMPARE( first.requests , (quint64)1 );
+    QCOMPARE( first.retries , (quint64)1 );
+    QCOMPARE( first.crcRetries , (quint64)1 );
+    QCOMPARE( first.recovered , (quint64)1 );
+    const QModbusRetryClient::Statistics second = client.statistics( 2 );
+    QCOMPARE( second.requests , (quint64)2 );
+    QCOMPARE( second.retries , (quint64)2 );
+    QCOMPARE( second.timeoutRetries , (quint64)1 );
+    QCOMPARE( second.busyRetries , (quint64)1 );
+    QCOMPARE( second.recovered , (quint64)1 );
+    const QModbusRetryClient::Statistics all = client.statistics();
+    QCOMPARE( all.requests , (quint64)3 );
+    QCOMPARE( all.retries , (quint64)3 );
+    QCOMPARE( all.recovered , (quint64)2 );
+
+    client.resetStatistics();
+    QCOMPARE( client.statistics().requests , (quint64)0 );
+    QCOMPARE( client.statistics( 2 ).retries , (quint64)0 );
+}
+
+QTEST_MAIN( TestQModbusRetryClient )
+#include "tst_qmodbusretryclient.moc"
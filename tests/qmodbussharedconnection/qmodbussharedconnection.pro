@@ -0,0 +1,12 @@
+########################################################################################################################
+# tst_qmodbussharedconnection : Concurrent use, shutdown, priority lanes and preemption of the shared connection.      #
+########################################################################################################################
+# Author ........: QModbus contributors                                                                                #
+# Changes .......: -                                                                                                   #
+########################################################################################################################
+
+
+# FILES ################################################################################################################
+include( ../tests.pri )
+TARGET          = tst_qmodbussharedconnection
+SOURCES        +=   tst_qmodbussharedconnection.cpp
@@ -0,0 +1,253 @@
+/***********************************************************************************************************************
+* tst_qmodbussharedconnection : Concurrent use, shutdown, priority lanes and preemption of the shared connection.      *
+************************************************************************************************************************
+* Author : QModbus contributors                                                                                        *
+* Date   : 2026/10/18                                                                                                  *
+* Changes: -                                                                                                           *
+***********************************************************************************************************************/
+
+
+/*** Qt includes ******************************************************************************************************/
+#include <QModbusSharedConnection>
+#include <QtCore/QThread>
+#include <QtTest/QtTest>
+
+
+/*** Test includes ****************************************************************************************************/
+#include "simulatedmodbus.h"
+
+
+/*** Helpers **********************************************************************************************************/
+// Thread destroying a shared connection, so a destructor that hangs fails the test instead of blocking it.
+class Destroyer : public QThread
+{
+public:
+    explicit Destroyer( QModbusSharedConnection *const connection ) : _connection( connection ) {}
+
+protected:
+    void run( void ) { delete _connection; }
+
+private:
+    QModbusSharedConnection *_connection;   // Connection to destroy.
+};
+
+// Thread writing registers through a shared connection and reading them back.
+class Client : public QThread
+{
+public:
+    Client( QModbusSharedConnection &connection , const quint16 base ) : failures( 0 ) , _connection( connection ) ,
+                                                                          _base( base ) {}
+
+    int failures;                   // Number of writes or reads that failed or read another value.
+
+protected:
+    void run( void )
+    {
+        for ( quint16 i = 0 ; i < 200 ; i++ )
+        {
+            quint8 status = QAbstractModbus::UnknownError;
+            if ( !_connection.writeSingleRegister( 1 , _base + i , _base + i , &status ) ) failures++;
+            if ( _connection.readHoldingRegisters( 1 , _base + i , 1 , &status ) !=
+                 QList<quint16>() << (quint16)( _base + i ) ) failures++;
+        }
+    }
+
+private:
+    QModbusSharedConnection &_connection;   // Connection to use.
+    quint16 _base;                  // First register of the thread.
+};
+
+// Returns a read of one holding register of device 1 at the given address, with the given priority.
+static QModbusRequest request( const quint16 address ,
+                               const QModbusRequest::Priority priority = QModbusRequest::Cyclic )
+{
+    QModbusRequest request = QModbusRequest::readHoldingRegisters( 1 , address , 1 );
+    request.setPriority( priority );
+    return request;
+}
+
+// Returns the log entry of request().
+static QString logged( const quint16 address )
+{
+    return QString( "3 1 %1" ).arg( address );
+}
+
+
+/*** Test class *******************************************************************************************************/
+class TestQModbusSharedConnection : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void execute( void );
+    void concurrentClients( void );
+    void transportState( void );
+    void shutdownWhileSorting( void );
+    void priorityLanes( void );
+    void preemption( void );
+};
+
+void TestQModbusSharedConnection::execute( void )
+{
+    SimulatedModbus modbus;
+    modbus.setRegister( 1 , 10 , 0x1234 );
+    QModbusSharedConnection connection( modbus );
+
+    quint8 status = QAbstractModbus::UnknownError;
+    QCOMPARE( connection.readHoldingRegisters( 1 , 10 , 1 , &status ) , QList<quint16>() << 0x1234 );
+    QCOMPARE( status , (quint8)QAbstractModbus::Ok );
+    QVERIFY( connection.writeSingleRegister( 1 , 11 , 0x5678 , &status ) );
+    QCOMPARE( modbus.registerValue( 1 , 11 ) , (quint16)0x5678 );
+
+    // Invalid requests never reach the transport.
+    const QModbusReplyPointer reply = connection.submit( QModbusRequest() );
+    QVERIFY( reply->isFinished() );
+    QCOMPARE( reply->response().status() , (quint8)QAbstractModbus::IllegalDataValue );
+    QCOMPARE( modbus.callCount() , 2 );
+
+    // The transport is only used by the I/O thread.
+    QCOMPARE( modbus.threads().count() , 1 );
+    QVERIFY( !modbus.threads().contains( QThread::currentThread() ) );
+    QCOMPARE( connection.pendingCount() , 0 );
+}
+
+void TestQModbusSharedConnection::concurrentClients( void )
+{
+    SimulatedModbus modbus;
+    QModbusSharedConnection connection( modbus );
+    QList<Client *> clients;
+    for ( int i = 0 ; i < 8 ; i++ ) clients.append( new Client( connection , (quint16)( i * 1000 ) ) );
+    foreach ( Client *client , clients ) client->start();
+    foreach ( Client *client , clients )
+    {
+        QVERIFY( client->wait( 30000 ) );
+        QCOMPARE( client->failures , 0 );
+        delete client;
+    }
+
+    // All requests went through the I/O thread, one at a time.
+    QCOMPARE( modbus.callCount() , 8 * 200 * 2 );
+    QCOMPARE( modbus.threads().count() , 1 );
+    QCOMPARE( modbus.maximumActive() , 1 );
+    QCOMPARE( connection.pendingCount() , 0 );
+}
+
+void TestQModbusSharedConnection::transportState( void )
+{
+    SimulatedModbus modbus;
+    QModbusSharedConnection connection( modbus );
+    QVERIFY( connection.isOpen() );
+    QCOMPARE( connection.timeout() , 1000u );
+
+    // The timeout is seen at once but applied to the transport by the I/O thread before its next request.
+    connection.setTimeout( 250 );
+    QCOMPARE( connection.timeout() , 250u );
+    QCOMPARE( modbus.timeout() , 1000u );
+    QVERIFY( !modbus.timeoutThread() );
+    quint8 status = QAbstractModbus::UnknownError;
+    connection.readHoldingRegisters( 1 , 0 , 1 , &status );
+    QCOMPARE( status , (quint8)QAbstractModbus::Ok );
+    QCOMPARE( modbus.timeout() , 250u );
+    QVERIFY( modbus.threads().contains( modbus.timeoutThread() ) );
+
+    // The open state is the one the I/O thread saw last.
+    modbus.setOpen( false );
+    connection.readHoldingRegisters( 1 , 0 , 1 , &status );
+    QCOMPARE( status , (quint8)QAbstractModbus::NoConnection );
+    QVERIFY( !connection.isOpen() );
+    modbus.setOpen( true );
+    connection.readHoldingRegisters( 1 , 0 , 1 , &status );
+    QCOMPARE( status , (quint8)QAbstractModbus::Ok );
+    QVERIFY( connection.isOpen() );
+}
+
+void TestQModbusSharedConnection::shutdownWhileSorting( void )
+{
+    // The destructor's wake-up token must not be taken for a request while the I/O thread sorts a burst of requests,
+    // or the I/O thread waits forever for a request that is not there. The race is timing dependent, so many short
+    // bursts are destroyed right after they were submitted.
+    SimulatedModbus modbus;
+    for ( int round = 0 ; round < 200 ; round++ )
+    {
+        QModbusSharedConnection *const connection = new QModbusSharedConnection( modbus );
+        QList<QModbusReplyPointer> replies;
+        for ( int i = 0 ; i < 50 ; i++ ) replies.append( connection->submit( request( i ) ) );
+
+        Destroyer *const destroyer = new Destroyer( connection );
+        destroyer->start();
+        QVERIFY2( destroyer->wait( 5000 ) , "The destructor did not return" );
+        delete destroyer;
+
+        // Every request is either executed or failed.
+        foreach ( const QModbusReplyPointer &reply , replies )
+        {
+            QVERIFY( reply->isFinished() );
+            const quint8 status = reply->response().status();
+            QVERIFY( status == QAbstractModbus::Ok || status == QAbstractModbus::NoConnection );
+        }
+    }
+}
+
+void TestQModbusSharedConnection::priorityLanes( void )
+{
+    SimulatedModbus modbus;
+    QModbusSharedConnection connection( modbus );
+
+    // Hold the I/O thread in a first request while requests of all classes are queued.
+    modbus.closeGate();
+    const QModbusReplyPointer first = connection.submit( request( 0 ) );
+    QVERIFY( modbus.waitForHeld( 1 ) );
+    QList<QModbusReplyPointer> replies;
+    replies << connection.submit( request( 1 , QModbusRequest::Bulk ) )
+            << connection.submit( request( 2 , QModbusRequest::Bulk ) )
+            << connection.submit( request( 3 , QModbusRequest::Cyclic ) )
+            << connection.submit( request( 4 , QModbusRequest::Interactive ) )
+            << connection.submit( request( 5 , QModbusRequest::Cyclic ) )
+            << connection.submit( request( 6 , QModbusRequest::Control ) );
+    QCOMPARE( connection.pendingCount() , 7 );
+    modbus.openGate();
+
+    foreach ( const QModbusReplyPointer &reply , replies ) QVERIFY( reply->waitForFinished( 5000 ) );
+    QVERIFY( first->isFinished() );
+
+    // Highest class first, each class in submission order.
+    QCOMPARE( modbus.log() , QStringList() << logged( 0 ) << logged( 6 ) << logged( 4 ) << logged( 3 ) << logged( 5 )
+                                           << logged( 1 ) << logged( 2 ) );
+    QCOMPARE( connection.queueStatistics( QModbusRequest::Cyclic ).count , 3 );
+    QCOMPARE( connection.queueStatistics( QModbusRequest::Bulk ).count , 2 );
+    QVERIFY( connection.queueStatistics( QModbusRequest::Bulk ).maximumWait >=
+             connection.queueStatistics( QModbusRequest::Control ).maximumWait );
+}
+
+void TestQModbusSharedConnection::preemption( void )
+{
+    // A control request submitted while a batch of cyclic requests runs goes before the rest of the batch only if the
+    // connection is preemptive.
+    for ( int preemptive = 0 ; preemptive < 2 ; preemptive++ )
+    {
+        SimulatedModbus modbus;
+        QModbusSharedConnection connection( modbus );
+        connection.setPreemptive( preemptive );
+        QCOMPARE( connection.isPreemptive() , (bool)preemptive );
+
+        modbus.closeGate();
+        QList<QModbusReplyPointer> replies;
+        replies << connection.submit( request( 0 ) );
+        QVERIFY( modbus.waitForHeld( 1 ) );
+        replies << connection.submit( request( 1 ) ) << connection.submit( request( 2 ) );
+        modbus.pass();
+        QVERIFY( modbus.waitForCalls( 2 ) );
+        QVERIFY( modbus.waitForHeld( 1 ) );
+        replies << connection.submit( request( 3 , QModbusRequest::Control ) );
+        modbus.openGate();
+        foreach ( const QModbusReplyPointer &reply , replies ) QVERIFY( reply->waitForFinished( 5000 ) );
+
+        const QStringList expected = preemptive ?
+            QStringList() << logged( 0 ) << logged( 1 ) << logged( 3 ) << logged( 2 ) :
+            QStringList() << logged( 0 ) << logged( 1 ) << logged( 2 ) << logged( 3 );
+        QCOMPARE( modbus.log() , expected );
+    }
+}
+
+QTEST_MAIN( TestQModbusSharedConnection )
+#include "tst_qmodbussharedconnection.moc"
@@ -0,0 +1,12 @@
+########################################################################################################################
+# tst_qmodbusstripedreader : Blocks, round robin and failed blocks of the striped reader.                              #
+########################################################################################################################
+# Author ........: QModbus contributors                                                                                #
+# Changes .......: -                                                                                                   #
+########################################################################################################################
+
+
+# FILES ################################################################################################################
+include( ../tests.pri )
+TARGET          = tst_qmodbusstripedreader
+SOURCES        +=   tst_qmodbusstripedreader.cpp
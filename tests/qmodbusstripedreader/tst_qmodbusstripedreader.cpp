@@ -0,0 +1,193 @@
+/***********************************************************************************************************************
+* tst_qmodbusstripedreader : Blocks, round robin and failed blocks of the striped reader.                              *
+************************************************************************************************************************
+* Author : QModbus contributors                                                                                        *
+* Date   : 2026/10/18                                                                                                  *
+* Changes: -                                                                                                           *
+***********************************************************************************************************************/
+
+
+/*** Qt includes ******************************************************************************************************/
+#include <QModbusStripedReader>
+#include <QtCore/QElapsedTimer>
+#include <QtTest/QtTest>
+
+
+/*** Test includes ****************************************************************************************************/
+#include "simulatedmodbus.h"
+
+
+/*** Helpers **********************************************************************************************************/
+// Connections to the same device: simulated devices with the same registers, register i of unit 1 holds i + 1.
+class Device
+{
+public:
+    explicit Device( const int connections )
+    {
+        for ( int i = 0 ; i < connections ; i++ )
+        {
+            SimulatedModbus *const modbus = new SimulatedModbus;
+            for ( int address = 0 ; address < 1000 ; address++ )
+            {
+                modbus->setRegister( 1 , (quint16)address , (quint16)( address + 1 ) );
+            }
+            _connections.append( modbus );
+        }
+    }
+
+    ~Device() { qDeleteAll( _connections ); }
+
+    SimulatedModbus &connection( const int i ) const { return *_connections.at( i ); }
+
+    QList<QAbstractModbus *> connections( void ) const
+    {
+        QList<QAbstractModbus *> connections;
+        foreach ( SimulatedModbus *modbus , _connections ) connections.append( modbus );
+        return connections;
+    }
+
+private:
+    QList<SimulatedModbus *> _connections;
+};
+
+// Returns the values of registers first to first + count - 1 of the device.
+static QVector<quint16> expected( const int first , const int count )
+{
+    QVector<quint16> values;
+    for ( int i = 0 ; i < count ; i++ ) values.append( (quint16)( first + i + 1 ) );
+    return values;
+}
+
+
+/*** Test class *******************************************************************************************************/
+class TestQModbusStripedReader : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void snapshot( void );
+    void parallel( void );
+    void blockSize( void );
+    void failedBlocks( void );
+    void invalidRanges( void );
+};
+
+void TestQModbusStripedReader::snapshot( void )
+{
+    Device device( 3 );
+    const QModbusStripedReader reader( device.connections() );
+    QCOMPARE( reader.connectionCount() , 3 );
+    QCOMPARE( reader.blockSize() , 125 );
+
+    // Eight blocks of 125 registers, spread round robin.
+    QList<QModbusStripedReader::Block> blocks;
+    quint8 status = QAbstractModbus::UnknownError;
+    QCOMPARE( reader.readHoldingRegisters( 1 , 0 , 1000 , &blocks , &status ) , expected( 0 , 1000 ) );
+    QCOMPARE( status , (quint8)QAbstractModbus::Ok );
+    QCOMPARE( blocks.count() , 8 );
+    for ( int i = 0 ; i < blocks.count() ; i++ )
+    {
+        QCOMPARE( blocks.at( i ).startingAddress , (quint16)( 125 * i ) );
+        QCOMPARE( blocks.at( i ).quantity , (quint16)125 );
+        QCOMPARE( blocks.at( i ).status , (quint8)QAbstractModbus::Ok );
+    }
+    QCOMPARE( device.connection( 0 ).log() , QStringList() << "3 1 0" << "3 1 375" << "3 1 750" );
+    QCOMPARE( device.connection( 1 ).log() , QStringList() << "3 1 125" << "3 1 500" << "3 1 875" );
+    QCOMPARE( device.connection( 2 ).log() , QStringList() << "3 1 250" << "3 1 625" );
+
+    // Input registers, the range does not have to start at a block boundary.
+    QCOMPARE( reader.readInputRegisters( 1 , 10 , 300 , &blocks , &status ) , expected( 10 , 300 ) );
+    QCOMPARE( blocks.count() , 3 );
+    QCOMPARE( blocks.last().startingAddress , (quint16)260 );
+    QCOMPARE( blocks.last().quantity , (quint16)50 );
+    QCOMPARE( device.connection( 2 ).log().last() , QString( "4 1 260" ) );
+}
+
+void TestQModbusStripedReader::parallel( void )
+{
+    // Every connection has its own I/O thread: six blocks on three connections take two round trips.
+    Device device( 3 );
+    for ( int i = 0 ; i < 3 ; i++ ) device.connection( i ).setLatency( 100 );
+    const QModbusStripedReader reader( device.connections() );
+    QElapsedTimer clock;
+    clock.start();
+    QCOMPARE( reader.readHoldingRegisters( 1 , 0 , 750 ) , expected( 0 , 750 ) );
+    QVERIFY( clock.elapsed() < 500 );
+
+    QSet<QThread *> threads;
+    for ( int i = 0 ; i < 3 ; i++ )
+    {
+        QCOMPARE( device.connection( i ).callCount() , 2 );
+        QCOMPARE( device.connection( i ).threads().count() , 1 );
+        threads.unite( device.connection( i ).threads() );
+    }
+    QCOMPARE( threads.count() , 3 );
+}
+
+void TestQModbusStripedReader::blockSize( void )
+{
+    Device device( 2 );
+    QModbusStripedReader reader( device.connections() );
+    reader.setBlockSize( 0 );
+    QCOMPARE( reader.blockSize() , 1 );
+    reader.setBlockSize( 200 );
+    QCOMPARE( reader.blockSize() , 125 );
+
+    reader.setBlockSize( 10 );
+    QList<QModbusStripedReader::Block> blocks;
+    QCOMPARE( reader.readHoldingRegisters( 1 , 100 , 25 , &blocks ) , expected( 100 , 25 ) );
+    QCOMPARE( blocks.count() , 3 );
+    QCOMPARE( blocks.at( 2 ).startingAddress , (quint16)120 );
+    QCOMPARE( blocks.at( 2 ).quantity , (quint16)5 );
+    QCOMPARE( device.connection( 0 ).log() , QStringList() << "3 1 100" << "3 1 120" );
+    QCOMPARE( device.connection( 1 ).log() , QStringList() << "3 1 110" );
+}
+
+void TestQModbusStripedReader::failedBlocks( void )
+{
+    // The blocks of the second connection time out, the others are read.
+    Device device( 2 );
+    device.connection( 1 ).setSilent( 1 );
+    const QModbusStripedReader reader( device.connections() );
+    QList<QModbusStripedReader::Block> blocks;
+    quint8 status = QAbstractModbus::Ok;
+    const QVector<quint16> registers = reader.readHoldingRegisters( 1 , 0 , 500 , &blocks , &status );
+    QCOMPARE( status , (quint8)QAbstractModbus::Timeout );
+    QCOMPARE( registers.count() , 500 );
+    QCOMPARE( blocks.count() , 4 );
+    for ( int i = 0 ; i < blocks.count() ; i++ )
+    {
+        const bool failed = i % 2;
+        QCOMPARE( blocks.at( i ).status , (quint8)( failed ? QAbstractModbus::Timeout : QAbstractModbus::Ok ) );
+        const QVector<quint16> block = registers.mid( 125 * i , 125 );
+        QCOMPARE( block , failed ? QVector<quint16>( 125 , 0 ) : expected( 125 * i , 125 ) );
+    }
+}
+
+void TestQModbusStripedReader::invalidRanges( void )
+{
+    Device device( 1 );
+    const QModbusStripedReader reader( device.connections() );
+    QList<QModbusStripedReader::Block> blocks;
+    quint8 status = QAbstractModbus::Ok;
+    QVERIFY( reader.readHoldingRegisters( 1 , 0 , 0 , &blocks , &status ).isEmpty() );
+    QCOMPARE( status , (quint8)QAbstractModbus::IllegalDataValue );
+    QVERIFY( reader.readHoldingRegisters( 1 , 0xFFF0 , 17 , &blocks , &status ).isEmpty() );
+    QCOMPARE( status , (quint8)QAbstractModbus::IllegalDataValue );
+    QVERIFY( blocks.isEmpty() );
+    QCOMPARE( device.connection( 0 ).callCount() , 0 );
+
+    // The range may end at the last address.
+    QCOMPARE( reader.readHoldingRegisters( 1 , 0xFFF0 , 16 , &blocks , &status ).count() , 16 );
+    QCOMPARE( status , (quint8)QAbstractModbus::Ok );
+
+    // No connection to read through.
+    const QList<QAbstractModbus *> connections;
+    const QModbusStripedReader none( connections );
+    QCOMPARE( none.connectionCount() , 0 );
+    QVERIFY( none.readInputRegisters( 1 , 0 , 10 , NULL , &status ).isEmpty() );
+    QCOMPARE( status , (quint8)QAbstractModbus::NoConnection );
+}
+
+QTEST_MAIN( TestQModbusStripedReader )
+#include "tst_qmodbusstripedreader.moc"
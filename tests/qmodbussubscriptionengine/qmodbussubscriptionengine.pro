@@ -0,0 +1,12 @@
+########################################################################################################################
+# tst_qmodbussubscriptionengine : Poll plan, fan out and change-only delivery of the subscription engine.              #
+########################################################################################################################
+# Author ........: QModbus contributors                                                                                #
+# Changes .......: -                                                                                                   #
+########################################################################################################################
+
+
+# FILES ################################################################################################################
+include( ../tests.pri )
+TARGET          = tst_qmodbussubscriptionengine
+SOURCES        +=   tst_qmodbussubscriptionengine.cpp
@@ -0,0 +1,316 @@
+/***********************************************************************************************************************
+* tst_qmodbussubscriptionengine : Poll plan, fan out and change-only delivery of the subscription engine.              *
+************************************************************************************************************************
+* Author : QModbus contributors                                                                                        *
+* Date   : 2026/10/18                                                                                                  *
+* Changes: -                                                                                                           *
+***********************************************************************************************************************/
+
+
+/*** Qt includes ******************************************************************************************************/
+#include <QModbusSubscriptionEngine>
+#include <QtTest/QtTest>
+
+
+/*** Test includes ****************************************************************************************************/
+#include "simulatedmodbus.h"
+
+
+/*** Helpers **********************************************************************************************************/
+// Listener recording the samples it gets.
+class Recorder : public QModbusListener
+{
+public:
+    struct Sample
+    {
+        int id;                     // Subscription.
+        quint16 startingAddress;    // First register or bit.
+        QList<quint16> registers;   // Register values.
+        QList<bool> bits;           // Bit values.
+        quint8 status;              // Transaction status.
+        QList<int> changed;         // Changed indices, empty unless change-only.
+    };
+
+    void registersReceived( const int id , const quint16 startingAddress , const QList<quint16> &values ,
+                            const quint8 status )
+    {
+        Sample sample = { id , startingAddress , values , QList<bool>() , status , QList<int>() };
+        samples.append( sample );
+    }
+
+    void bitsReceived( const int id , const quint16 startingAddress , const QList<bool> &values , const quint8 status )
+    {
+        Sample sample = { id , startingAddress , QList<quint16>() , values , status , QList<int>() };
+        samples.append( sample );
+    }
+
+    void registersChanged( const int id , const quint16 startingAddress , const QList<quint16> &values ,
+                           const QList<int> &changed )
+    {
+        Sample sample = { id , startingAddress , values , QList<bool>() , QAbstractModbus::Ok , changed };
+        samples.append( sample );
+    }
+
+    // Returns the samples of a subscription.
+    QList<Sample> of( const int id ) const
+    {
+        QList<Sample> list;
+        foreach ( const Sample &sample , samples ) if ( sample.id == id ) list.append( sample );
+        return list;
+    }
+
+    QList<Sample> samples;          // Samples in the order received.
+};
+
+// Sets holding registers of device 1 to their address.
+static void fill( SimulatedModbus &modbus , const quint16 first , const quint16 count )
+{
+    for ( quint16 i = first ; i < first + count ; i++ ) modbus.setRegister( 1 , i , i );
+}
+
+// Returns the registers a filled range holds.
+static QList<quint16> filled( const quint16 first , const quint16 count )
+{
+    QList<quint16> values;
+    for ( quint16 i = first ; i < first + count ; i++ ) values.append( i );
+    return values;
+}
+
+
+/*** Test class *******************************************************************************************************/
+class TestQModbusSubscriptionEngine : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void invalidSubscriptions( void );
+    void overlappingRangesShareBlocks( void );
+    void blocksKeepTheModbusLimit( void );
+    void unsubscribe( void );
+    void duePeriodsAreMerged( void );
+    void failedPolls( void );
+    void changeOnlyDelivery( void );
+    void capabilities( void );
+    void timer( void );
+};
+
+void TestQModbusSubscriptionEngine::invalidSubscriptions( void )
+{
+    SimulatedModbus modbus;
+    QModbusSubscriptionEngine engine( modbus );
+    Recorder recorder;
+    QCOMPARE( engine.subscribe( 1 , QAbstractModbus::HoldingRegisters , 0 , 0 , 100 , &recorder ) , -1 );
+    QCOMPARE( engine.subscribe( 1 , QAbstractModbus::HoldingRegisters , 0 , 126 , 100 , &recorder ) , -1 );
+    QCOMPARE( engine.subscribe( 1 , QAbstractModbus::Coils , 0 , 2001 , 100 , &recorder ) , -1 );
+    QCOMPARE( engine.subscribe( 1 , QAbstractModbus::HoldingRegisters , 0xFFFF , 2 , 100 , &recorder ) , -1 );
+    QCOMPARE( engine.subscribe( 1 , QAbstractModbus::HoldingRegisters , 0 , 1 , 0 , &recorder ) , -1 );
+    QCOMPARE( engine.subscribe( 1 , QAbstractModbus::HoldingRegisters , 0 , 1 , 100 , NULL ) , -1 );
+    QCOMPARE( engine.subscriptionCount() , 0 );
+    QVERIFY( engine.subscribe( 1 , QAbstractModbus::Coils , 0 , 2000 , 100 , &recorder ) > 0 );
+}
+
+void TestQModbusSubscriptionEngine::overlappingRangesShareBlocks( void )
+{
+    SimulatedModbus modbus;
+    fill( modbus , 0 , 300 );
+    QModbusSubscriptionEngine engine( modbus );
+    Recorder recorder;
+    const int a = engine.subscribe( 1 , QAbstractModbus::HoldingRegisters , 0 , 10 , 100 , &recorder );
+    const int b = engine.subscribe( 1 , QAbstractModbus::HoldingRegisters , 5 , 15 , 100 , &recorder );
+    const int c = engine.subscribe( 1 , QAbstractModbus::HoldingRegisters , 20 , 5 , 100 , &recorder );
+    const int d = engine.subscribe( 1 , QAbstractModbus::HoldingRegisters , 200 , 10 , 100 , &recorder );
+    QCOMPARE( engine.subscriptionCount() , 4 );
+
+    // Overlapping and adjacent ranges share a block, distant ones do not.
+    QCOMPARE( engine.blockCount() , 2 );
+    QCOMPARE( engine.processDue() , 2 );
+    QCOMPARE( modbus.log() , QStringList() << "3 1 0" << "3 1 200" );
+
+    // Every subscriber gets its own slice of the block.
+    QCOMPARE( recorder.samples.count() , 4 );
+    QCOMPARE( recorder.of( a ).first().registers , filled( 0 , 10 ) );
+    QCOMPARE( recorder.of( b ).first().registers , filled( 5 , 15 ) );
+    QCOMPARE( recorder.of( b ).first().startingAddress , (quint16)5 );
+    QCOMPARE( recorder.of( c ).first().registers , filled( 20 , 5 ) );
+    QCOMPARE( recorder.of( d ).first().registers , filled( 200 , 10 ) );
+    QCOMPARE( recorder.of( d ).first().status , (quint8)QAbstractModbus::Ok );
+
+    // Nothing is due before the period passed.
+    QCOMPARE( engine.processDue() , 0 );
+    TestSleep::pause( 110 );
+    QCOMPARE( engine.processDue() , 2 );
+}
+
+void TestQModbusSubscriptionEngine::blocksKeepTheModbusLimit( void )
+{
+    SimulatedModbus modbus;
+    QModbusSubscriptionEngine engine( modbus );
+    Recorder recorder;
+    engine.subscribe( 1 , QAbstractModbus::HoldingRegisters , 0 , 100 , 100 , &recorder );
+    engine.subscribe( 1 , QAbstractModbus::HoldingRegisters , 100 , 100 , 100 , &recorder );
+    QCOMPARE( engine.blockCount() , 2 );
+
+    // A range fitting into one of the blocks joins it.
+    engine.subscribe( 1 , QAbstractModbus::HoldingRegisters , 90 , 30 , 100 , &recorder );
+    QCOMPARE( engine.blockCount() , 2 );
+    QCOMPARE( engine.processDue() , 2 );
+    QCOMPARE( recorder.samples.count() , 3 );
+    foreach ( const Recorder::Sample &sample , recorder.samples )
+    {
+        QCOMPARE( sample.status , (quint8)QAbstractModbus::Ok );
+    }
+
+    // Different devices and tables never share a block.
+    engine.subscribe( 2 , QAbstractModbus::HoldingRegisters , 0 , 10 , 100 , &recorder );
+    engine.subscribe( 1 , QAbstractModbus::InputRegisters , 0 , 10 , 100 , &recorder );
+    QCOMPARE( engine.blockCount() , 4 );
+}
+
+void TestQModbusSubscriptionEngine::unsubscribe( void )
+{
+    SimulatedModbus modbus;
+    QModbusSubscriptionEngine engine( modbus );
+    Recorder recorder;
+    const int a = engine.subscribe( 1 , QAbstractModbus::HoldingRegisters , 0 , 10 , 100 , &recorder );
+    const int b = engine.subscribe( 1 , QAbstractModbus::HoldingRegisters , 10 , 10 , 100 , &recorder );
+    QCOMPARE( engine.blockCount() , 1 );
+
+    // The remaining subscription is polled alone.
+    engine.unsubscribe( a );
+    QCOMPARE( engine.subscriptionCount() , 1 );
+    QCOMPARE( engine.blockCount() , 1 );
+    QCOMPARE( engine.processDue() , 1 );
+    QCOMPARE( modbus.log() , QStringList() << "3 1 10" );
+    QCOMPARE( recorder.samples.count() , 1 );
+    QCOMPARE( recorder.samples.first().id , b );
+
+    engine.unsubscribe( b );
+    engine.unsubscribe( b );
+    QCOMPARE( engine.subscriptionCount() , 0 );
+    QCOMPARE( engine.blockCount() , 0 );
+}
+
+void TestQModbusSubscriptionEngine::duePeriodsAreMerged( void )
+{
+    SimulatedModbus modbus;
+    QModbusSubscriptionEngine engine( modbus );
+    Recorder recorder;
+    const int fast = engine.subscribe( 1 , QAbstractModbus::Coils , 0 , 16 , 50 , &recorder );
+    const int slow = engine.subscribe( 1 , QAbstractModbus::Coils , 8 , 16 , 10000 , &recorder );
+    QCOMPARE( engine.blockCount() , 2 );
+
+    // Both are due at first: one request.
+    modbus.setCoil( 1 , 9 , true );
+    QCOMPARE( engine.processDue() , 1 );
+    QCOMPARE( modbus.log() , QStringList() << "1 1 0" );
+    QCOMPARE( recorder.of( fast ).first().bits.count() , 16 );
+    QVERIFY( recorder.of( fast ).first().bits.at( 9 ) );
+    QCOMPARE( recorder.of( slow ).first().bits.count() , 16 );
+    QVERIFY( recorder.of( slow ).first().bits.at( 1 ) );
+
+    // Later only the fast one is due.
+    TestSleep::pause( 60 );
+    QCOMPARE( engine.processDue() , 1 );
+    QCOMPARE( recorder.of( fast ).count() , 2 );
+    QCOMPARE( recorder.of( slow ).count() , 1 );
+}
+
+void TestQModbusSubscriptionEngine::failedPolls( void )
+{
+    SimulatedModbus modbus;
+    modbus.setSilent( 1 );
+    QModbusSubscriptionEngine engine( modbus );
+    Recorder recorder;
+    const int id = engine.subscribe( 1 , QAbstractModbus::HoldingRegisters , 0 , 4 , 100 , &recorder );
+    engine.setChangeFilter( id , QModbusChangeFilter() );
+
+    // Failures are reported to change-only subscriptions as well.
+    QCOMPARE( engine.processDue() , 1 );
+    QCOMPARE( recorder.samples.count() , 1 );
+    QCOMPARE( recorder.samples.first().status , (quint8)QAbstractModbus::Timeout );
+    QVERIFY( recorder.samples.first().registers.isEmpty() );
+}
+
+void TestQModbusSubscriptionEngine::changeOnlyDelivery( void )
+{
+    SimulatedModbus modbus;
+    fill( modbus , 0 , 4 );
+    QModbusSubscriptionEngine engine( modbus );
+    Recorder recorder;
+    const int id = engine.subscribe( 1 , QAbstractModbus::HoldingRegisters , 0 , 4 , 10 , &recorder );
+    QVERIFY( engine.setChangeFilter( id , QModbusChangeFilter() ) );
+    QVERIFY( !engine.setChangeFilter( id + 1 , QModbusChangeFilter() ) );
+
+    // The first sample is reported completely.
+    engine.processDue();
+    QCOMPARE( recorder.samples.count() , 1 );
+    QCOMPARE( recorder.samples.last().changed , QList<int>() << 0 << 1 << 2 << 3 );
+
+    // Unchanged samples are not reported.
+    TestSleep::pause( 15 );
+    engine.processDue();
+    QCOMPARE( recorder.samples.count() , 1 );
+
+    // Changed values are.
+    modbus.setRegister( 1 , 2 , 42 );
+    TestSleep::pause( 15 );
+    engine.processDue();
+    QCOMPARE( recorder.samples.count() , 2 );
+    QCOMPARE( recorder.samples.last().changed , QList<int>() << 2 );
+    QCOMPARE( recorder.samples.last().registers , QList<quint16>() << 0 << 1 << 42 << 3 );
+
+    // Every sample once the filter is cleared.
+    engine.clearChangeFilter( id );
+    TestSleep::pause( 15 );
+    engine.processDue();
+    QCOMPARE( recorder.samples.count() , 3 );
+    QVERIFY( recorder.samples.last().changed.isEmpty() );
+}
+
+void TestQModbusSubscriptionEngine::capabilities( void )
+{
+    SimulatedModbus modbus;
+    QModbusCapabilityCache cache;
+    cache.setMaximumQuantity( 1 , 0x03 , 10 );
+    QModbusSubscriptionEngine engine( modbus );
+    engine.setCapabilities( &cache );
+    QCOMPARE( engine.capabilities() , &cache );
+    Recorder recorder;
+
+    // Blocks are limited to what the device accepts.
+    QCOMPARE( engine.subscribe( 1 , QAbstractModbus::HoldingRegisters , 0 , 11 , 100 , &recorder ) , -1 );
+    engine.subscribe( 1 , QAbstractModbus::HoldingRegisters , 0 , 8 , 100 , &recorder );
+    engine.subscribe( 1 , QAbstractModbus::HoldingRegisters , 8 , 8 , 100 , &recorder );
+    QCOMPARE( engine.blockCount() , 2 );
+
+    // Other devices keep the modbus limit.
+    engine.subscribe( 2 , QAbstractModbus::HoldingRegisters , 0 , 8 , 100 , &recorder );
+    engine.subscribe( 2 , QAbstractModbus::HoldingRegisters , 8 , 8 , 100 , &recorder );
+    QCOMPARE( engine.blockCount() , 3 );
+    QCOMPARE( engine.processDue() , 3 );
+}
+
+void TestQModbusSubscriptionEngine::timer( void )
+{
+    SimulatedModbus modbus;
+    QModbusSubscriptionEngine engine( modbus );
+    Recorder recorder;
+    engine.subscribe( 1 , QAbstractModbus::HoldingRegisters , 0 , 1 , 50 , &recorder );
+    QVERIFY( !engine.isActive() );
+    QTest::qWait( 100 );
+    QCOMPARE( recorder.samples.count() , 0 );
+
+    // Polled at once, then every period.
+    engine.start();
+    QVERIFY( engine.isActive() );
+    QTest::qWait( 275 );
+    QVERIFY( recorder.samples.count() >= 4 && recorder.samples.count() <= 7 );
+
+    engine.stop();
+    const int count = recorder.samples.count();
+    QTest::qWait( 100 );
+    QCOMPARE( recorder.samples.count() , count );
+}
+
+QTEST_MAIN( TestQModbusSubscriptionEngine )
+#include "tst_qmodbussubscriptionengine.moc"
@@ -0,0 +1,12 @@
+########################################################################################################################
+# tst_qmodbustopologycache : Save and load of the topology cache.                                                      #
+########################################################################################################################
+# Author ........: QModbus contributors                                                                                #
+# Changes .......: -                                                                                                   #
+########################################################################################################################
+
+
+# FILES ################################################################################################################
+include( ../tests.pri )
+TARGET          = tst_qmodbustopologycache
+SOURCES        +=   tst_qmodbustopologycache.cpp
@@ -0,0 +1,217 @@
+/***********************************************************************************************************************
+* tst_qmodbustopologycache : Save and load round trip of the topology cache file.                                      *
+************************************************************************************************************************
+* Author : QModbus contributors                                                                                        *
+* Date   : 2026/10/18                                                                                                  *
+* Changes: -                                                                                                           *
+***********************************************************************************************************************/
+
+
+/*** Qt includes ******************************************************************************************************/
+#include <QModbusCapabilityCache>
+#include <QModbusTopologyCache>
+#include <QtCore/QCoreApplication>
+#include <QtCore/QDateTime>
+#include <QtCore/QDir>
+#include <QtCore/QFile>
+#include <QtTest/QtTest>
+
+
+/*** Test class *******************************************************************************************************/
+class TestQModbusTopologyCache : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init( void );
+    void cleanup( void );
+    void emptyCache( void );
+    void roundTrip( void );
+    void capabilitiesRoundTrip( void );
+    void saveOverMappedFile( void );
+    void invalidFile( void );
+    void longEndpointName( void );
+
+private:
+    QString _fileName;              // Cache file of the running test.
+};
+
+void TestQModbusTopologyCache::init( void )
+{
+    _fileName = QDir::temp().filePath( QString( "tst_qmodbustopologycache_%1.cache" )
+                                       .arg( QCoreApplication::applicationPid() ) );
+    QFile::remove( _fileName );
+}
+
+void TestQModbusTopologyCache::cleanup( void )
+{
+    QFile::remove( _fileName );
+}
+
+void TestQModbusTopologyCache::emptyCache( void )
+{
+    QModbusTopologyCache cache;
+    QVERIFY( cache.endpoints().isEmpty() );
+    QVERIFY( cache.resolvedAddress( "plc1:502" ).isEmpty() );
+    QVERIFY( !cache.isReachable( "plc1:502" , 1 ) );
+    QCOMPARE( cache.roundTripTime( "plc1:502" , 1 ) , -1 );
+    QCOMPARE( cache.lastVerified( "plc1:502" , 1 ) , (qint64)0 );
+
+    // A missing file is no cache.
+    QVERIFY( !cache.load( _fileName ) );
+
+    // An empty cache can be saved and loaded.
+    QVERIFY( cache.save( _fileName ) );
+    QModbusTopologyCache loaded;
+    QVERIFY( loaded.load( _fileName ) );
+    QVERIFY( loaded.endpoints().isEmpty() );
+}
+
+void TestQModbusTopologyCache::roundTrip( void )
+{
+    const qint64 before = QDateTime::currentMSecsSinceEpoch();
+    qint64 verified = 0;
+    {
+        QModbusTopologyCache cache;
+        cache.setResolvedAddress( "plc1:502" , "192.168.1.10" );
+        cache.setReachable( "plc1:502" , 1 , true );
+        cache.setReachable( "plc1:502" , 7 , true );
+        cache.setReachable( "plc1:502" , 3 , false );
+        cache.addRoundTripTime( "plc1:502" , 1 , 1500 );
+        cache.setReachable( "/dev/ttyUSB0" , 12 , true );
+        verified = cache.lastVerified( "plc1:502" , 1 );
+        QVERIFY( verified >= before );
+        QVERIFY( cache.save( _fileName ) );
+    }
+
+    QModbusTopologyCache cache;
+    QVERIFY( cache.load( _fileName ) );
+    QCOMPARE( cache.endpoints() , QStringList() << "/dev/ttyUSB0" << "plc1:502" );
+
+    qint64 resolved = 0;
+    QCOMPARE( cache.resolvedAddress( "plc1:502" , &resolved ) , QString( "192.168.1.10" ) );
+    QVERIFY( resolved >= before );
+    QVERIFY( cache.resolvedAddress( "/dev/ttyUSB0" ).isEmpty() );
+
+    QCOMPARE( cache.reachableUnits( "plc1:502" ) , QList<quint8>() << 1 << 7 );
+    QVERIFY( cache.isReachable( "plc1:502" , 1 ) );
+    QVERIFY( !cache.isReachable( "plc1:502" , 3 ) );
+    QVERIFY( cache.lastVerified( "plc1:502" , 3 ) >= before );
+    QCOMPARE( cache.lastVerified( "plc1:502" , 1 ) , verified );
+    QCOMPARE( cache.roundTripTime( "plc1:502" , 1 ) , 1500 );
+    QCOMPARE( cache.roundTripTime( "plc1:502" , 7 ) , -1 );
+    QCOMPARE( cache.reachableUnits( "/dev/ttyUSB0" ) , QList<quint8>() << 12 );
+
+    // Changes after loading are seen before they are saved.
+    cache.addRoundTripTime( "plc1:502" , 1 , 2300 );
+    QCOMPARE( cache.roundTripTime( "plc1:502" , 1 ) , 1600 );
+}
+
+void TestQModbusTopologyCache::capabilitiesRoundTrip( void )
+{
+    {
+        QModbusCapabilityCache capabilities;
+        capabilities.setSupport( 1 , 0x03 , QModbusCapabilityCache::Supported );
+        capabilities.setSupport( 1 , 0x17 , QModbusCapabilityCache::Unsupported );
+        capabilities.setMaximumQuantity( 1 , 0x03 , 60 );
+        capabilities.setAddressWindow( 1 , QAbstractModbus::HoldingRegisters , 100 , 199 );
+        capabilities.setSupport( 2 , 0x01 , QModbusCapabilityCache::Supported );
+
+        QModbusTopologyCache cache;
+        cache.store( "plc1:502" , capabilities );
+        QVERIFY( cache.save( _fileName ) );
+    }
+
+    QModbusTopologyCache cache;
+    QVERIFY( cache.load( _fileName ) );
+    QModbusCapabilityCache capabilities;
+    cache.restore( "plc1:502" , capabilities );
+
+    QCOMPARE( capabilities.support( 1 , 0x03 ) , QModbusCapabilityCache::Supported );
+    QCOMPARE( capabilities.support( 1 , 0x17 ) , QModbusCapabilityCache::Unsupported );
+    QCOMPARE( capabilities.support( 1 , 0x10 ) , QModbusCapabilityCache::Unknown );
+    QCOMPARE( capabilities.support( 2 , 0x01 ) , QModbusCapabilityCache::Supported );
+    QCOMPARE( capabilities.maximumQuantity( 1 , 0x03 ) , (quint16)60 );
+    QCOMPARE( capabilities.maximumQuantity( 1 , 0x04 ) , QModbusCapabilityCache::standardMaximumQuantity( 0x04 ) );
+
+    quint16 first = 0;
+    quint16 last = 0;
+    QVERIFY( capabilities.addressWindow( 1 , QAbstractModbus::HoldingRegisters , &first , &last ) );
+    QCOMPARE( first , (quint16)100 );
+    QCOMPARE( last , (quint16)199 );
+    QVERIFY( !capabilities.addressWindow( 1 , QAbstractModbus::InputRegisters , &first , &last ) );
+
+    // Nothing is restored for other endpoints.
+    QModbusCapabilityCache other;
+    cache.restore( "plc2:502" , other );
+    QVERIFY( other.devices().isEmpty() );
+}
+
+void TestQModbusTopologyCache::saveOverMappedFile( void )
+{
+    QModbusTopologyCache cache;
+    cache.setReachable( "plc1:502" , 1 , true );
+    QVERIFY( cache.save( _fileName ) );
+
+    // The cache maps the file it saved, saving again replaces it.
+    cache.setReachable( "plc1:502" , 2 , true );
+    cache.setReachable( "plc2:502" , 5 , true );
+    cache.remove( "plc2:502" );
+    cache.setResolvedAddress( "plc3:502" , "10.0.0.3" );
+    QVERIFY( cache.save( _fileName ) );
+    QCOMPARE( cache.reachableUnits( "plc1:502" ) , QList<quint8>() << 1 << 2 );
+
+    QModbusTopologyCache loaded;
+    QVERIFY( loaded.load( _fileName ) );
+    QCOMPARE( loaded.endpoints() , QStringList() << "plc1:502" << "plc3:502" );
+    QCOMPARE( loaded.reachableUnits( "plc1:502" ) , QList<quint8>() << 1 << 2 );
+    QCOMPARE( loaded.resolvedAddress( "plc3:502" ) , QString( "10.0.0.3" ) );
+}
+
+void TestQModbusTopologyCache::invalidFile( void )
+{
+    QByteArray content;
+    {
+        QModbusTopologyCache cache;
+        cache.setReachable( "plc1:502" , 1 , true );
+        QVERIFY( cache.save( _fileName ) );
+    }
+    QFile file( _fileName );
+    QVERIFY( file.open( QIODevice::ReadOnly ) );
+    content = file.readAll();
+    file.close();
+
+    // Not a cache at all, then a valid header with the records cut off. The cache is empty after a failed load, the
+    // changes not saved are dropped.
+    const QByteArray invalid[] = { QByteArray( "not a topology cache" ) , content.left( content.size() - 1 ) };
+    for ( int i = 0 ; i < 2 ; i++ )
+    {
+        QVERIFY( file.open( QIODevice::WriteOnly | QIODevice::Truncate ) );
+        QCOMPARE( file.write( invalid[i] ) , (qint64)invalid[i].size() );
+        file.close();
+
+        QModbusTopologyCache cache;
+        cache.setReachable( "plc2:502" , 1 , true );
+        QVERIFY( !cache.load( _fileName ) );
+        QVERIFY( cache.endpoints().isEmpty() );
+        QVERIFY( !cache.isReachable( "plc1:502" , 1 ) );
+    }
+}
+
+void TestQModbusTopologyCache::longEndpointName( void )
+{
+    const QString longName( 64 , QChar( 'x' ) );
+    const QString maximalName( 63 , QChar( 'y' ) );
+    QModbusTopologyCache cache;
+    cache.setReachable( longName , 1 , true );
+    cache.setReachable( maximalName , 1 , true );
+    QVERIFY( cache.save( _fileName ) );
+
+    QModbusTopologyCache loaded;
+    QVERIFY( loaded.load( _fileName ) );
+    QCOMPARE( loaded.endpoints() , QStringList() << maximalName );
+    QVERIFY( loaded.isReachable( maximalName , 1 ) );
+}
+
+QTEST_MAIN( TestQModbusTopologyCache )
+#include "tst_qmodbustopologycache.moc"
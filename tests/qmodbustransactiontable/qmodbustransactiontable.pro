@@ -0,0 +1,12 @@
+########################################################################################################################
+# tst_qmodbustransactiontable : Transaction identifiers of modbus TCP.                                                 #
+########################################################################################################################
+# Author ........: QModbus contributors                                                                                #
+# Changes .......: -                                                                                                   #
+########################################################################################################################
+
+
+# FILES ################################################################################################################
+include( ../tests.pri )
+TARGET          = tst_qmodbustransactiontable
+SOURCES        +=   tst_qmodbustransactiontable.cpp
@@ -0,0 +1,122 @@
+/***********************************************************************************************************************
+* tst_qmodbustransactiontable : Allocation, lookup and release of TCP transaction identifiers.                         *
+************************************************************************************************************************
+* Author : QModbus contributors                                                                                        *
+* Date   : 2026/10/18                                                                                                  *
+* Changes: -                                                                                                           *
+***********************************************************************************************************************/
+
+
+/*** Qt includes ******************************************************************************************************/
+#include <QModbusTransactionTable>
+#include <QtTest/QtTest>
+
+
+/*** Test class *******************************************************************************************************/
+class TestQModbusTransactionTable : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void sequentialIdentifiers( void );
+    void findAndRelease( void );
+    void fullTable( void );
+    void staleIdentifiers( void );
+    void clear( void );
+    void wrapAround( void );
+};
+
+void TestQModbusTransactionTable::sequentialIdentifiers( void )
+{
+    QModbusTransactionTable<int,4> table;
+    QCOMPARE( table.capacity() , 4 );
+    for ( int i = 0 ; i < 10 ; i++ )
+    {
+        QCOMPARE( table.allocate( i ) , i );
+        QVERIFY( table.release( (quint16)i ) );
+    }
+    QCOMPARE( table.pendingCount() , 0 );
+}
+
+void TestQModbusTransactionTable::findAndRelease( void )
+{
+    QModbusTransactionTable<int,4> table;
+    const int first = table.allocate( 11 );
+    const int second = table.allocate( 22 );
+    QCOMPARE( table.pendingCount() , 2 );
+
+    QVERIFY( table.find( (quint16)first ) );
+    QCOMPARE( *table.find( (quint16)first ) , 11 );
+    QCOMPARE( *table.find( (quint16)second ) , 22 );
+
+    // The stored value can be changed in place.
+    *table.find( (quint16)second ) = 33;
+    QCOMPARE( *table.find( (quint16)second ) , 33 );
+
+    QVERIFY( table.release( (quint16)first ) );
+    QVERIFY( !table.find( (quint16)first ) );
+    QCOMPARE( *table.find( (quint16)second ) , 33 );
+    QCOMPARE( table.pendingCount() , 1 );
+
+    // Releasing twice fails.
+    QVERIFY( !table.release( (quint16)first ) );
+    QCOMPARE( table.pendingCount() , 1 );
+}
+
+void TestQModbusTransactionTable::fullTable( void )
+{
+    QModbusTransactionTable<int,4> table;
+    for ( int i = 0 ; i < 4 ; i++ ) QCOMPARE( table.allocate() , i );
+    QCOMPARE( table.allocate() , -1 );
+    QCOMPARE( table.pendingCount() , 4 );
+
+    // The next identifier goes to the slot of the oldest transaction, another free slot does not help.
+    QVERIFY( table.release( 2 ) );
+    QCOMPARE( table.allocate() , -1 );
+    QVERIFY( table.release( 0 ) );
+    QCOMPARE( table.allocate() , 4 );
+    QCOMPARE( table.pendingCount() , 3 );
+}
+
+void TestQModbusTransactionTable::staleIdentifiers( void )
+{
+    QModbusTransactionTable<int,4> table;
+    QCOMPARE( table.allocate( 1 ) , 0 );
+    QVERIFY( table.release( 0 ) );
+    for ( int i = 1 ; i < 4 ; i++ ) QVERIFY( table.release( (quint16)table.allocate() ) );
+
+    // Identifier 4 uses the slot of identifier 0: a late reply to 0 must not find it.
+    QCOMPARE( table.allocate( 5 ) , 4 );
+    QVERIFY( !table.find( 0 ) );
+    QVERIFY( !table.release( 0 ) );
+    QCOMPARE( *table.find( 4 ) , 5 );
+
+    // Never allocated.
+    QVERIFY( !table.find( 1000 ) );
+}
+
+void TestQModbusTransactionTable::clear( void )
+{
+    QModbusTransactionTable<int,4> table;
+    for ( int i = 0 ; i < 3 ; i++ ) table.allocate( i );
+    table.clear();
+    QCOMPARE( table.pendingCount() , 0 );
+    for ( int i = 0 ; i < 3 ; i++ ) QVERIFY( !table.find( (quint16)i ) );
+
+    // Identifiers continue to increase, so late replies from before the clear are not mistaken for new ones.
+    QCOMPARE( table.allocate() , 3 );
+}
+
+void TestQModbusTransactionTable::wrapAround( void )
+{
+    QModbusTransactionTable<int,64> table;
+    for ( int i = 0 ; i < 65535 ; i++ ) QVERIFY( table.release( (quint16)table.allocate() ) );
+    QCOMPARE( table.allocate( 1 ) , 65535 );
+    QCOMPARE( table.allocate( 2 ) , 0 );
+    QCOMPARE( *table.find( 65535 ) , 1 );
+    QCOMPARE( *table.find( 0 ) , 2 );
+    QCOMPARE( table.pendingCount() , 2 );
+}
+
+QTEST_MAIN( TestQModbusTransactionTable )
+#include "tst_qmodbustransactiontable.moc"
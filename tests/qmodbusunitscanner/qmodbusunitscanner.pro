@@ -0,0 +1,12 @@
+########################################################################################################################
+# tst_qmodbusunitscanner : Units found, probe timeouts and the time a silent unit costs the unit scanner.              #
+########################################################################################################################
+# Author ........: QModbus contributors                                                                                #
+# Changes .......: -                                                                                                   #
+########################################################################################################################
+
+
+# FILES ################################################################################################################
+include( ../tests.pri )
+TARGET          = tst_qmodbusunitscanner
+SOURCES        +=   tst_qmodbusunitscanner.cpp
@@ -0,0 +1,177 @@
+/***********************************************************************************************************************
+* tst_qmodbusunitscanner : Units found, probe timeouts and the time a silent unit costs the unit scanner.              *
+************************************************************************************************************************
+* Author : QModbus contributors                                                                                        *
+* Date   : 2026/10/18                                                                                                  *
+* Changes: -                                                                                                           *
+***********************************************************************************************************************/
+
+
+/*** Qt includes ******************************************************************************************************/
+#include <QModbusFraming>
+#include <QModbusTopologyCache>
+#include <QModbusUnitScanner>
+#include <QRtuModbus>
+#include <QtCore/QElapsedTimer>
+#include <QtTest/QtTest>
+
+
+/*** Test includes ****************************************************************************************************/
+#include "simulatedmodbus.h"
+
+
+/*** System includes **************************************************************************************************/
+#ifdef Q_OS_UNIX
+#include <fcntl.h>
+#include <stdlib.h>
+#include <unistd.h>
+#endif
+
+
+/*** Helpers **********************************************************************************************************/
+// Makes every unit of a simulated bus silent but the given ones.
+static void silenceAllBut( SimulatedModbus &modbus , const QList<quint8> &units )
+{
+    for ( int unit = 1 ; unit <= 247 ; unit++ ) modbus.setSilent( (quint8)unit , !units.contains( (quint8)unit ) );
+}
+
+
+/*** Test class *******************************************************************************************************/
+class TestQModbusUnitScanner : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void probeTimeout( void );
+    void unitsFound( void );
+    void exceptionsArePresence( void );
+    void topologyCache( void );
+    void cancel( void );
+    void silentRtuUnits( void );
+};
+
+void TestQModbusUnitScanner::probeTimeout( void )
+{
+    SimulatedModbus modbus;
+    QModbusUnitScanner scanner( modbus );
+    QCOMPARE( scanner.baudRate() , 0 );
+    QCOMPARE( scanner.responseAllowance() , 50 );
+    QCOMPARE( scanner.probeTimeout() , 50 );
+
+    // 8 characters of 11 bits at 9600 baud and 3.5 characters of silence: 13167 microseconds, rounded up.
+    scanner.setSerialLine( 9600 );
+    QCOMPARE( scanner.probeTimeout() , 14 + 50 );
+
+    // Report server ID is 4 characters: 8587 microseconds.
+    scanner.setProbeFunction( QModbusUnitScanner::ReportServerId );
+    QCOMPARE( scanner.probeTimeout() , 9 + 50 );
+
+    // The allowance has a lower bound.
+    scanner.setSerialLine( 0 );
+    scanner.setResponseAllowance( 1 );
+    QCOMPARE( scanner.probeTimeout() , 10 );
+}
+
+void TestQModbusUnitScanner::unitsFound( void )
+{
+    SimulatedModbus modbus;
+    silenceAllBut( modbus , QList<quint8>() << 3 << 7 << 10 );
+    QModbusUnitScanner scanner( modbus );
+    QSignalSpy found( &scanner , SIGNAL( unitFound( int , int , int ) ) );
+    QSignalSpy finished( &scanner , SIGNAL( finished( int ) ) );
+
+    QCOMPARE( scanner.scan( 2 , 9 ) , QList<quint8>() << 3 << 7 );
+    QCOMPARE( found.count() , 2 );
+    QCOMPARE( found.at( 0 ).at( 0 ).toInt() , 3 );
+    QCOMPARE( found.at( 0 ).at( 1 ).toInt() , (int)QAbstractModbus::Ok );
+    QCOMPARE( found.at( 1 ).at( 0 ).toInt() , 7 );
+    QCOMPARE( finished.count() , 1 );
+    QCOMPARE( finished.at( 0 ).at( 0 ).toInt() , 2 );
+
+    // One probe per unit of the range, holding register 0.
+    QCOMPARE( modbus.callCount() , 8 );
+    QCOMPARE( modbus.log().first() , QString( "3 2 0" ) );
+    QCOMPARE( modbus.log().last() , QString( "3 9 0" ) );
+
+    // The allowance adapts to the units found, it never exceeds the configured one.
+    QVERIFY( scanner.probeTimeout() <= 50 );
+    QCOMPARE( scanner.responseAllowance() , 50 );
+}
+
+void TestQModbusUnitScanner::exceptionsArePresence( void )
+{
+    // A unit answering with an exception is there.
+    SimulatedModbus modbus;
+    silenceAllBut( modbus , QList<quint8>() << 5 );
+    QModbusUnitScanner scanner( modbus );
+    scanner.setProbeFunction( QModbusUnitScanner::ReportServerId );
+    QSignalSpy found( &scanner , SIGNAL( unitFound( int , int , int ) ) );
+
+    QCOMPARE( scanner.scan( 1 , 8 ) , QList<quint8>() << 5 );
+    QCOMPARE( found.count() , 1 );
+    QCOMPARE( found.at( 0 ).at( 1 ).toInt() , (int)QAbstractModbus::IllegalFunction );
+    QCOMPARE( modbus.log().first() , QString( "17 1 0" ) );
+}
+
+void TestQModbusUnitScanner::topologyCache( void )
+{
+    SimulatedModbus modbus;
+    silenceAllBut( modbus , QList<quint8>() << 2 );
+    QModbusTopologyCache cache;
+    cache.setReachable( "bus" , 3 , true );
+    QModbusUnitScanner scanner( modbus );
+    scanner.setTopologyCache( &cache , "bus" );
+
+    scanner.scan( 1 , 4 );
+    QCOMPARE( cache.reachableUnits( "bus" ) , QList<quint8>() << 2 );
+    QVERIFY( cache.roundTripTime( "bus" , 2 ) >= 0 );
+    QVERIFY( cache.lastVerified( "bus" , 4 ) > 0 );
+}
+
+void TestQModbusUnitScanner::cancel( void )
+{
+    SimulatedModbus modbus;
+    QModbusUnitScanner scanner( modbus );
+    QModbusCancellationToken token;
+    token.cancel();
+    QVERIFY( scanner.scan( 1 , 247 , token ).isEmpty() );
+    QCOMPARE( modbus.callCount() , 0 );
+
+    // A closed connection ends the scan.
+    modbus.setOpen( false );
+    QVERIFY( scanner.scan( 1 , 247 ).isEmpty() );
+    QCOMPARE( modbus.callCount() , 1 );
+}
+
+void TestQModbusUnitScanner::silentRtuUnits( void )
+{
+#ifdef Q_OS_UNIX
+    // A pseudo terminal stands in for the bus: the probes go out, no unit answers.
+    const int master = ::posix_openpt( O_RDWR | O_NOCTTY );
+    QVERIFY( master >= 0 );
+    QVERIFY( ::grantpt( master ) == 0 && ::unlockpt( master ) == 0 );
+    QRtuModbus modbus;
+    QVERIFY( modbus.open( QString::fromLatin1( ::ptsname( master ) ) ) );
+    QCOMPARE( modbus.timeout() , 500u );
+
+    QModbusUnitScanner scanner( modbus );
+    scanner.setSerialLine( 9600 );
+    const int units = 4;
+    QElapsedTimer clock;
+    clock.start();
+    QVERIFY( scanner.scan( 1 , units ).isEmpty() );
+    const qint64 perUnit = clock.elapsed() / units;
+
+    // A silent unit costs the probe timeout and the silence that ends the wait for a late reply, not the timeout of
+    // the transport.
+    const int bound = scanner.probeTimeout() + QModbusRtuFraming::LateReplySilence + 100;
+    QVERIFY2( perUnit < bound , qPrintable( QString( "%1 ms per unit, expected less than %2 ms" )
+                                            .arg( perUnit ).arg( bound ) ) );
+
+    modbus.close();
+    ::close( master );
+#endif
+}
+
+QTEST_MAIN( TestQModbusUnitScanner )
+#include "tst_qmodbusunitscanner.moc"
@@ -0,0 +1,12 @@
+########################################################################################################################
+# tst_qmodbusverifiedwriter : Function 0x17 use, fallback and verification of the verified writer.                     #
+########################################################################################################################
+# Author ........: QModbus contributors                                                                                #
+# Changes .......: -                                                                                                   #
+########################################################################################################################
+
+
+# FILES ################################################################################################################
+include( ../tests.pri )
+TARGET          = tst_qmodbusverifiedwriter
+SOURCES        +=   tst_qmodbusverifiedwriter.cpp
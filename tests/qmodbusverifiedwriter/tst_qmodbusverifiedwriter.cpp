@@ -0,0 +1,168 @@
+/***********************************************************************************************************************
+* tst_qmodbusverifiedwriter : Function 0x17 use, fallback and verification of the verified writer.                     *
+************************************************************************************************************************
+* Author : QModbus contributors                                                                                        *
+* Date   : 2026/10/18                                                                                                  *
+* Changes: -                                                                                                           *
+***********************************************************************************************************************/
+
+
+/*** Qt includes ******************************************************************************************************/
+#include <QModbusVerifiedWriter>
+#include <QtTest/QtTest>
+
+
+/*** Test includes ****************************************************************************************************/
+#include "simulatedmodbus.h"
+
+
+/*** Helpers **********************************************************************************************************/
+// Returns count register values starting at first.
+static QList<quint16> sequence( const quint16 first , const int count )
+{
+    QList<quint16> values;
+    for ( int i = 0 ; i < count ; i++ ) values.append( (quint16)( first + i ) );
+    return values;
+}
+
+
+/*** Test class *******************************************************************************************************/
+class TestQModbusVerifiedWriter : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void writeRead( void );
+    void fallback( void );
+    void largeBlocks( void );
+    void invalidBlocks( void );
+    void verificationFailed( void );
+    void failuresAreFinal( void );
+    void sharedCache( void );
+};
+
+void TestQModbusVerifiedWriter::writeRead( void )
+{
+    SimulatedModbus modbus;
+    QModbusVerifiedWriter writer( modbus );
+    quint8 status = QAbstractModbus::UnknownError;
+    QList<quint16> readBack;
+
+    // Written and read back in a single transaction.
+    QVERIFY( writer.writeRegisters( 1 , 10 , sequence( 100 , 3 ) , &readBack , &status ) );
+    QCOMPARE( status , (quint8)QAbstractModbus::Ok );
+    QCOMPARE( readBack , sequence( 100 , 3 ) );
+    QCOMPARE( modbus.log() , QStringList() << "23 1 10" );
+    QCOMPARE( modbus.registerValue( 1 , 12 ) , (quint16)102 );
+    QCOMPARE( writer.capabilities().support( 1 , 0x17 ) , QModbusCapabilityCache::Supported );
+
+    QVERIFY( writer.writeRegister( 1 , 20 , 7 , &status ) );
+    QCOMPARE( modbus.log().last() , QString( "23 1 20" ) );
+    QCOMPARE( modbus.registerValue( 1 , 20 ) , (quint16)7 );
+}
+
+void TestQModbusVerifiedWriter::fallback( void )
+{
+    SimulatedModbus modbus;
+    modbus.setUnsupported( 0x17 );
+    QModbusVerifiedWriter writer( modbus );
+    quint8 status = QAbstractModbus::UnknownError;
+
+    // The illegal function exception is learned, the block is written and read back.
+    QVERIFY( writer.writeRegisters( 1 , 0 , sequence( 1 , 4 ) , NULL , &status ) );
+    QCOMPARE( status , (quint8)QAbstractModbus::Ok );
+    QCOMPARE( modbus.log() , QStringList() << "23 1 0" << "16 1 0" << "3 1 0" );
+    QCOMPARE( writer.capabilities().support( 1 , 0x17 ) , QModbusCapabilityCache::Unsupported );
+
+    // Later writes go straight to the fallback, a single register is written with function 0x06.
+    modbus.clearLog();
+    QVERIFY( writer.writeRegister( 1 , 5 , 9 , &status ) );
+    QCOMPARE( modbus.log() , QStringList() << "6 1 5" << "3 1 5" );
+
+    // Other devices still try function 0x17.
+    modbus.clearLog();
+    QVERIFY( writer.writeRegister( 2 , 5 , 9 , &status ) );
+    QCOMPARE( modbus.log().first() , QString( "23 2 5" ) );
+}
+
+void TestQModbusVerifiedWriter::largeBlocks( void )
+{
+    // Function 0x17 writes at most 121 registers.
+    SimulatedModbus modbus;
+    QModbusVerifiedWriter writer( modbus );
+    QList<quint16> readBack;
+    QVERIFY( writer.writeRegisters( 1 , 0 , sequence( 0 , 123 ) , &readBack ) );
+    QCOMPARE( readBack.count() , 123 );
+    QCOMPARE( modbus.log() , QStringList() << "16 1 0" << "3 1 0" );
+
+    modbus.clearLog();
+    QVERIFY( writer.writeRegisters( 1 , 0 , sequence( 0 , 121 ) ) );
+    QCOMPARE( modbus.log() , QStringList() << "23 1 0" );
+}
+
+void TestQModbusVerifiedWriter::invalidBlocks( void )
+{
+    SimulatedModbus modbus;
+    QModbusVerifiedWriter writer( modbus );
+    quint8 status = QAbstractModbus::UnknownError;
+    QVERIFY( !writer.writeRegisters( 1 , 0 , QList<quint16>() , NULL , &status ) );
+    QCOMPARE( status , (quint8)QAbstractModbus::IllegalDataValue );
+    QVERIFY( !writer.writeRegisters( 1 , 0 , sequence( 0 , 124 ) , NULL , &status ) );
+    QCOMPARE( status , (quint8)QAbstractModbus::IllegalDataValue );
+    QCOMPARE( modbus.callCount() , 0 );
+}
+
+void TestQModbusVerifiedWriter::verificationFailed( void )
+{
+    for ( int fallback = 0 ; fallback < 2 ; fallback++ )
+    {
+        // The device accepts the write but keeps the old value of register 5.
+        SimulatedModbus modbus;
+        if ( fallback ) modbus.setUnsupported( 0x17 );
+        modbus.setRegister( 1 , 5 , 50 );
+        modbus.setReadOnly( 1 , 5 );
+        QModbusVerifiedWriter writer( modbus );
+        quint8 status = QAbstractModbus::UnknownError;
+        QList<quint16> readBack;
+
+        QVERIFY( !writer.writeRegisters( 1 , 4 , sequence( 1 , 3 ) , &readBack , &status ) );
+        QCOMPARE( status , (quint8)QAbstractModbus::VerificationFailed );
+        QCOMPARE( readBack , QList<quint16>() << 1 << 50 << 3 );
+    }
+}
+
+void TestQModbusVerifiedWriter::failuresAreFinal( void )
+{
+    // The write may have happened: a failed transaction is not repeated using the fallback.
+    SimulatedModbus modbus;
+    modbus.failNext( QAbstractModbus::Timeout );
+    QModbusVerifiedWriter writer( modbus );
+    quint8 status = QAbstractModbus::UnknownError;
+    QList<quint16> readBack;
+    QVERIFY( !writer.writeRegisters( 1 , 0 , sequence( 1 , 2 ) , &readBack , &status ) );
+    QCOMPARE( status , (quint8)QAbstractModbus::Timeout );
+    QVERIFY( readBack.isEmpty() );
+    QCOMPARE( modbus.callCount() , 1 );
+    QVERIFY( writer.capabilities().support( 1 , 0x17 ) != QModbusCapabilityCache::Unsupported );
+
+    // A device exception is final as well.
+    modbus.failNext( QAbstractModbus::IllegalDataAddress );
+    QVERIFY( !writer.writeRegisters( 1 , 0 , sequence( 1 , 2 ) , NULL , &status ) );
+    QCOMPARE( status , (quint8)QAbstractModbus::IllegalDataAddress );
+    QCOMPARE( modbus.callCount() , 2 );
+}
+
+void TestQModbusVerifiedWriter::sharedCache( void )
+{
+    SimulatedModbus modbus;
+    QModbusCapabilityCache cache;
+    cache.setSupport( 1 , 0x17 , QModbusCapabilityCache::Unsupported );
+    QModbusVerifiedWriter writer( modbus , &cache );
+    QCOMPARE( &writer.capabilities() , &cache );
+
+    QVERIFY( writer.writeRegisters( 1 , 0 , sequence( 1 , 2 ) ) );
+    QCOMPARE( modbus.log() , QStringList() << "16 1 0" << "3 1 0" );
+}
+
+QTEST_MAIN( TestQModbusVerifiedWriter )
+#include "tst_qmodbusverifiedwriter.moc"
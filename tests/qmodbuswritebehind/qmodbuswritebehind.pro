@@ -0,0 +1,12 @@
+########################################################################################################################
+# tst_qmodbuswritebehind : Coalescing of queued writes and mask composition.                                           #
+########################################################################################################################
+# Author ........: QModbus contributors                                                                                #
+# Changes .......: -                                                                                                   #
+########################################################################################################################
+
+
+# FILES ################################################################################################################
+include( ../tests.pri )
+TARGET          = tst_qmodbuswritebehind
+SOURCES        +=   tst_qmodbuswritebehind.cpp
@@ -0,0 +1,329 @@
+/***********************************************************************************************************************
+* tst_qmodbuswritebehind : Coalescing of writes and composition of mask writes by the write-behind queue.              *
+************************************************************************************************************************
+* Author : QModbus contributors                                                                                        *
+* Date   : 2026/10/18                                                                                                  *
+* Changes: -                                                                                                           *
+***********************************************************************************************************************/
+
+
+/*** Qt includes ******************************************************************************************************/
+#include <QModbusWriteBehind>
+#include <QtCore/QMap>
+#include <QtCore/QStringList>
+#include <QtTest/QtTest>
+
+
+/*** Helpers **********************************************************************************************************/
+// Device simulation recording the modbus calls, only the writes are implemented.
+class FakeModbus : public QAbstractModbus
+{
+public:
+    FakeModbus( void ) {}
+
+    bool isOpen() const
+    {
+        return true;
+    }
+
+    unsigned int timeout( void ) const
+    {
+        return 1000;
+    }
+
+    void setTimeout( const unsigned int timeout )
+    {
+        Q_UNUSED( timeout );
+    }
+
+    QList<bool> readCoils( const quint8 deviceAddress , const quint16 startingAddress , const quint16 quantityOfCoils ,
+                           quint8 *const status = NULL ) const
+    {
+        Q_UNUSED( deviceAddress ); Q_UNUSED( startingAddress ); Q_UNUSED( quantityOfCoils );
+        return _unsupported( status , QList<bool>() );
+    }
+
+    QList<bool> readDiscreteInputs( const quint8 deviceAddress , const quint16 startingAddress ,
+                                    const quint16 quantityOfInputs , quint8 *const status = NULL ) const
+    {
+        Q_UNUSED( deviceAddress ); Q_UNUSED( startingAddress ); Q_UNUSED( quantityOfInputs );
+        return _unsupported( status , QList<bool>() );
+    }
+
+    QList<quint16> readHoldingRegisters( const quint8 deviceAddress , const quint16 startingAddress ,
+                                         const quint16 quantityOfRegisters , quint8 *const status = NULL ) const
+    {
+        Q_UNUSED( deviceAddress ); Q_UNUSED( startingAddress ); Q_UNUSED( quantityOfRegisters );
+        return _unsupported( status , QList<quint16>() );
+    }
+
+    QList<quint16> readInputRegisters( const quint8 deviceAddress , const quint16 startingAddress ,
+                                       const quint16 quantityOfInputRegisters , quint8 *const status = NULL ) const
+    {
+        Q_UNUSED( deviceAddress ); Q_UNUSED( startingAddress ); Q_UNUSED( quantityOfInputRegisters );
+        return _unsupported( status , QList<quint16>() );
+    }
+
+    bool writeSingleCoil( const quint8 deviceAddress , const quint16 outputAddress , const bool outputValue ,
+                          quint8 *const status = NULL ) const
+    {
+        calls.append( QString( "coil %1 %2" ).arg( deviceAddress ).arg( outputAddress ) );
+        coils.insert( key( deviceAddress , outputAddress ) , outputValue );
+        return _ok( status );
+    }
+
+    bool writeSingleRegister( const quint8 deviceAddress , const quint16 registerAddress ,
+                              const quint16 registerValue , quint8 *const status = NULL ) const
+    {
+        calls.append( QString( "register %1 %2" ).arg( deviceAddress ).arg( registerAddress ) );
+        registers.insert( key( deviceAddress , registerAddress ) , registerValue );
+        return _ok( status );
+    }
+
+    bool writeMultipleCoils( const quint8 deviceAddress , const quint16 startingAddress ,
+                             const QList<bool> &outputValues , quint8 *const status = NULL ) const
+    {
+        calls.append( QString( "coils %1 %2 %3" ).arg( deviceAddress ).arg( startingAddress )
+                      .arg( outputValues.count() ) );
+        for ( int i = 0 ; i < outputValues.count() ; i++ )
+        {
+            coils.insert( key( deviceAddress , startingAddress + i ) , outputValues.at( i ) );
+        }
+        return _ok( status );
+    }
+
+    bool writeMultipleRegisters( const quint8 deviceAddress , const quint16 startingAddress ,
+                                 const QList<quint16> &registersValues , quint8 *const status = NULL ) const
+    {
+        calls.append( QString( "registers %1 %2 %3" ).arg( deviceAddress ).arg( startingAddress )
+                      .arg( registersValues.count() ) );
+        for ( int i = 0 ; i < registersValues.count() ; i++ )
+        {
+            registers.insert( key( deviceAddress , startingAddress + i ) , registersValues.at( i ) );
+        }
+        return _ok( status );
+    }
+
+    bool maskWriteRegister( const quint8 deviceAddress , const quint16 referenceAddress , const quint16 andMask ,
+                            const quint16 orMask , quint8 *const status = NULL ) const
+    {
+        // Result = ( Current AND And_Mask ) OR ( Or_Mask AND ( NOT And_Mask ) ).
+        calls.append( QString( "mask %1 %2" ).arg( deviceAddress ).arg( referenceAddress ) );
+        const quint32 address = key( deviceAddress , referenceAddress );
+        registers.insert( address , ( registers.value( address ) & andMask ) | ( orMask & ~andMask ) );
+        return _ok( status );
+    }
+
+    QList<quint16> writeReadMultipleRegisters( const quint8 deviceAddress , const quint16 writeStartingAddress ,
+                                               const QList<quint16> &writeValues ,
+                                               const quint16 readStartingAddress , const quint16 quantityToRead ,
+                                               quint8 *const status = NULL ) const
+    {
+        Q_UNUSED( deviceAddress ); Q_UNUSED( writeStartingAddress ); Q_UNUSED( writeValues );
+        Q_UNUSED( readStartingAddress ); Q_UNUSED( quantityToRead );
+        return _unsupported( status , QList<quint16>() );
+    }
+
+    QList<quint16> readFifoQueue( const quint8 deviceAddress , const quint16 fifoPointerAddress ,
+                                  quint8 *const status = NULL ) const
+    {
+        Q_UNUSED( deviceAddress ); Q_UNUSED( fifoPointerAddress );
+        return _unsupported( status , QList<quint16>() );
+    }
+
+    QByteArray executeCustomFunction( const quint8 deviceAddress , const quint8 modbusFunction , QByteArray &data ,
+                                      quint8 *const status = NULL ) const
+    {
+        Q_UNUSED( deviceAddress ); Q_UNUSED( modbusFunction ); Q_UNUSED( data );
+        return _unsupported( status , QByteArray() );
+    }
+
+    QByteArray executeRaw( QByteArray &data , quint8 *const status = NULL ) const
+    {
+        Q_UNUSED( data );
+        return _unsupported( status , QByteArray() );
+    }
+
+    QByteArray calculateCheckSum( QByteArray &data ) const
+    {
+        Q_UNUSED( data );
+        return QByteArray();
+    }
+
+    static quint32 key( const quint8 deviceAddress , const quint16 address )
+    {
+        return ( (quint32)deviceAddress << 16 ) | address;
+    }
+
+    mutable QStringList calls;                  // Calls made, in order.
+    mutable QMap<quint32,bool> coils;           // Coil values by device and address.
+    mutable QMap<quint32,quint16> registers;    // Register values by device and address.
+
+private:
+    static bool _ok( quint8 *const status )
+    {
+        if ( status ) *status = Ok;
+        return true;
+    }
+
+    template< class T >
+    static T _unsupported( quint8 *const status , const T &result )
+    {
+        if ( status ) *status = IllegalFunction;
+        return result;
+    }
+};
+
+// Applies a mask write the way a device does.
+static quint16 applyMask( const quint16 current , const quint16 andMask , const quint16 orMask )
+{
+    return ( current & andMask ) | ( orMask & ~andMask );
+}
+
+
+/*** Test class *******************************************************************************************************/
+class TestQModbusWriteBehind : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void composedMasks( void );
+    void randomMaskComposition( void );
+    void maskOnPendingValue( void );
+    void valueReplacesMask( void );
+    void contiguousRegisters( void );
+    void contiguousCoils( void );
+    void devicesAreSeparate( void );
+};
+
+void TestQModbusWriteBehind::composedMasks( void )
+{
+    FakeModbus modbus;
+    modbus.registers.insert( FakeModbus::key( 1 , 4 ) , 0x0012 );
+    QModbusWriteBehind writeBehind( modbus , 1000 );
+
+    // Example of the modbus specification followed by setting and clearing single bits.
+    writeBehind.maskRegister( 1 , 4 , 0x00F2 , 0x0025 );
+    writeBehind.maskRegister( 1 , 4 , 0xFFFF , 0x0000 );
+    writeBehind.maskRegister( 1 , 4 , 0x7FFF , 0x8000 );
+    writeBehind.maskRegister( 1 , 4 , 0xFFFE , 0x0000 );
+    QCOMPARE( writeBehind.pendingCount() , 1 );
+    QVERIFY( writeBehind.flush() );
+
+    QCOMPARE( modbus.calls , QStringList() << "mask 1 4" );
+    quint16 expected = applyMask( 0x0012 , 0x00F2 , 0x0025 );
+    QCOMPARE( expected , (quint16)0x0017 );
+    expected = applyMask( applyMask( expected , 0x7FFF , 0x8000 ) , 0xFFFE , 0x0000 );
+    QCOMPARE( modbus.registers.value( FakeModbus::key( 1 , 4 ) ) , expected );
+    QCOMPARE( writeBehind.pendingCount() , 0 );
+}
+
+void TestQModbusWriteBehind::randomMaskComposition( void )
+{
+    // A fixed pseudo random sequence, so a failure can be reproduced.
+    quint32 seed = 12345;
+    for ( int run = 0 ; run < 500 ; run++ )
+    {
+        FakeModbus modbus;
+        QModbusWriteBehind writeBehind( modbus , 1000 );
+        seed = seed * 1103515245 + 12345;
+        const quint16 initial = (quint16)( seed >> 16 );
+        modbus.registers.insert( FakeModbus::key( 1 , 0 ) , initial );
+
+        quint16 expected = initial;
+        const int masks = 1 + run % 5;
+        for ( int i = 0 ; i < masks ; i++ )
+        {
+            seed = seed * 1103515245 + 12345;
+            const quint16 andMask = (quint16)( seed >> 16 );
+            seed = seed * 1103515245 + 12345;
+            const quint16 orMask = (quint16)( seed >> 16 );
+            writeBehind.maskRegister( 1 , 0 , andMask , orMask );
+            expected = applyMask( expected , andMask , orMask );
+        }
+        QVERIFY( writeBehind.flush() );
+
+        QCOMPARE( modbus.calls.count() , 1 );
+        QCOMPARE( modbus.registers.value( FakeModbus::key( 1 , 0 ) ) , expected );
+    }
+}
+
+void TestQModbusWriteBehind::maskOnPendingValue( void )
+{
+    FakeModbus modbus;
+    QModbusWriteBehind writeBehind( modbus , 1000 );
+    writeBehind.writeRegister( 1 , 10 , 0x1234 );
+    writeBehind.maskRegister( 1 , 10 , 0xFF00 , 0x0056 );
+    QVERIFY( writeBehind.flush() );
+
+    QCOMPARE( modbus.calls , QStringList() << "register 1 10" );
+    QCOMPARE( modbus.registers.value( FakeModbus::key( 1 , 10 ) ) , (quint16)0x1256 );
+}
+
+void TestQModbusWriteBehind::valueReplacesMask( void )
+{
+    FakeModbus modbus;
+    QModbusWriteBehind writeBehind( modbus , 1000 );
+    writeBehind.maskRegister( 1 , 10 , 0x00FF , 0xAB00 );
+    writeBehind.writeRegister( 1 , 10 , 0x4321 );
+    QCOMPARE( writeBehind.pendingCount() , 1 );
+    QVERIFY( writeBehind.flush() );
+
+    QCOMPARE( modbus.calls , QStringList() << "register 1 10" );
+    QCOMPARE( modbus.registers.value( FakeModbus::key( 1 , 10 ) ) , (quint16)0x4321 );
+}
+
+void TestQModbusWriteBehind::contiguousRegisters( void )
+{
+    FakeModbus modbus;
+    QModbusWriteBehind writeBehind( modbus , 1000 );
+
+    // 100..102 and 104 in any order, the last write of a register wins. The mask at 103 splits the run.
+    writeBehind.writeRegister( 1 , 102 , 2 );
+    writeBehind.writeRegisters( 1 , 100 , QList<quint16>() << 0 << 1 );
+    writeBehind.writeRegister( 1 , 101 , 11 );
+    writeBehind.maskRegister( 1 , 103 , 0xFFFF , 0x0000 );
+    writeBehind.writeRegister( 1 , 104 , 4 );
+    QCOMPARE( writeBehind.pendingCount() , 5 );
+    QVERIFY( writeBehind.flush() );
+
+    QCOMPARE( modbus.calls , QStringList() << "registers 1 100 3" << "mask 1 103" << "register 1 104" );
+    QCOMPARE( modbus.registers.value( FakeModbus::key( 1 , 100 ) ) , (quint16)0 );
+    QCOMPARE( modbus.registers.value( FakeModbus::key( 1 , 101 ) ) , (quint16)11 );
+    QCOMPARE( modbus.registers.value( FakeModbus::key( 1 , 102 ) ) , (quint16)2 );
+    QCOMPARE( modbus.registers.value( FakeModbus::key( 1 , 104 ) ) , (quint16)4 );
+
+    // Nothing left to send.
+    modbus.calls.clear();
+    QVERIFY( writeBehind.flush() );
+    QVERIFY( modbus.calls.isEmpty() );
+}
+
+void TestQModbusWriteBehind::contiguousCoils( void )
+{
+    FakeModbus modbus;
+    QModbusWriteBehind writeBehind( modbus , 1000 );
+    writeBehind.writeCoil( 1 , 5 , true );
+    writeBehind.writeCoils( 1 , 6 , QList<bool>() << false << true );
+    writeBehind.writeCoil( 1 , 20 , true );
+    QVERIFY( writeBehind.flush() );
+
+    QCOMPARE( modbus.calls , QStringList() << "coils 1 5 3" << "coil 1 20" );
+    QCOMPARE( modbus.coils.value( FakeModbus::key( 1 , 7 ) ) , true );
+    QCOMPARE( modbus.coils.value( FakeModbus::key( 1 , 6 ) ) , false );
+}
+
+void TestQModbusWriteBehind::devicesAreSeparate( void )
+{
+    // The last register of device 1 and the first of device 2 have adjacent keys, but are no run.
+    FakeModbus modbus;
+    QModbusWriteBehind writeBehind( modbus , 1000 );
+    writeBehind.writeRegister( 1 , 0xFFFF , 1 );
+    writeBehind.writeRegister( 2 , 0x0000 , 2 );
+    QVERIFY( writeBehind.flush() );
+
+    QCOMPARE( modbus.calls , QStringList() << "register 1 65535" << "register 2 0" );
+}
+
+QTEST_MAIN( TestQModbusWriteBehind )
+#include "tst_qmodbuswritebehind.moc"
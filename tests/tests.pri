@@ -0,0 +1,38 @@
+########################################################################################################################
+# tests.pri : Settings shared by all unit tests.                                                                       #
+########################################################################################################################
+# Author ........: QModbus contributors                                                                                #
+# Changes .......: -                                                                                                   #
+########################################################################################################################
+
+
+# COMMON SETTINGS FOR ALL PLATFORMS ####################################################################################
+TEMPLATE        = app                           # Console application.
+QT             += core testlib                  # QtTest, no GUI.
+QT             -= gui
+CONFIG         += console \                     # No application bundle, output to the console.
+                  testcase \                    # "make check" runs the test.
+                  warn_on                       # Show all warnings.
+CONFIG         -= app_bundle
+
+
+# DEPENDENCIES AND INLCUDES ############################################################################################
+INCLUDEPATH    += $$PWD/../include              # The library's includes.
+INCLUDEPATH    += $$PWD/common                  # Helpers shared by the tests.
+CONFIG( debug , debug | release ) {
+QMODBUS_LIB     = QModbusd                      # Debug version of the library.
+} else {
+QMODBUS_LIB     = QModbus                       # Release version of the library.
+}
+macx {
+LIBS           += -F$$PWD/../build/lib -framework $$QMODBUS_LIB
+} else {
+LIBS           += -L$$PWD/../build/lib -l$$QMODBUS_LIB
+unix:QMAKE_RPATHDIR += $$PWD/../build/lib       # Run the tests against the library built, not an installed one.
+}
+
+
+# OUTPUT DESTINATIONS ##################################################################################################
+MOC_DIR         = ./build/.moc
+OBJECTS_DIR     = ./build/.obj
+DESTDIR         = ./build
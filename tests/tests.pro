@@ -0,0 +1,37 @@
+########################################################################################################################
+# tests : Unit tests of QModbus, build the library first (see readme.md).                                              #
+########################################################################################################################
+# Author ........: QModbus contributors                                                                                #
+# Changes .......: -                                                                                                   #
+########################################################################################################################
+
+
+# SUBPROJECTS ##########################################################################################################
+TEMPLATE        = subdirs
+SUBDIRS         = qmodbusframing \
+                  qmodbuschangefilter \
+                  qmodbuswritebehind \
+                  qmodbuspdu \
+                  qmodbustransactiontable \
+                  qmodbusmpscqueue \
+                  qmodbustopologycache \
+                  qmodbussharedconnection \
+                  qmodbusredundantclient \
+                  qmodbusunitscanner \
+                  qmodbussubscriptionengine \
+                  qmodbuspollscheduler \
+                  qmodbusverifiedwriter \
+                  qmodbusbatch \
+                  qmodbusreconnectmanager \
+                  qmodbusconnectionpool \
+                  qmodbusstripedreader \
+                  qmodbusdeadline \
+                  qmodbusratelimiter \
+                  qmodbusretryclient \
+                  qmodbuscapabilityprober
+
+
+# C++20 SUBPROJECTS ####################################################################################################
+greaterThan( QT_MAJOR_VERSION , 4 ) {           # CONFIG += c++2a needs Qt 5.12 or later and a C++20 compiler.
+SUBDIRS        += qmodbuscoroutine
+}